@@ -0,0 +1,97 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/miniconda/lib/cmake/fmt/fmt-config-version.cmake"
+  "/root/miniconda/lib/cmake/fmt/fmt-config.cmake"
+  "/root/miniconda/lib/cmake/fmt/fmt-targets-release.cmake"
+  "/root/miniconda/lib/cmake/fmt/fmt-targets.cmake"
+  "/root/miniconda/lib/cmake/spdlog/spdlogConfig.cmake"
+  "/root/miniconda/lib/cmake/spdlog/spdlogConfigTargets-release.cmake"
+  "/root/miniconda/lib/cmake/spdlog/spdlogConfigTargets.cmake"
+  "/root/miniconda/lib/cmake/spdlog/spdlogConfigVersion.cmake"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/benchmarks/CMakeLists.txt"
+  "/root/repo/benchmarks/compare/CMakeLists.txt"
+  "/root/repo/cmake/ZyrnixConfig.cmake.in"
+  "/usr/lib/x86_64-linux-gnu/cmake/benchmark/benchmarkConfig.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/benchmark/benchmarkConfigVersion.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/benchmark/benchmarkTargets-none.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/benchmark/benchmarkTargets.cmake"
+  "/usr/share/cmake-3.25/Modules/BasicConfigVersion-AnyNewerVersion.cmake.in"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeFindDependencyMacro.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakePackageConfigHelpers.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckCSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFile.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckLibraryExists.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/FindCURL.cmake"
+  "/usr/share/cmake-3.25/Modules/FindOpenSSL.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageHandleStandardArgs.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageMessage.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPkgConfig.cmake"
+  "/usr/share/cmake-3.25/Modules/FindThreads.cmake"
+  "/usr/share/cmake-3.25/Modules/FindZLIB.cmake"
+  "/usr/share/cmake-3.25/Modules/Internal/CheckSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  "/usr/share/cmake-3.25/Modules/SelectLibraryConfigurations.cmake"
+  "/usr/share/cmake-3.25/Modules/WriteBasicConfigVersionFile.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "ZyrnixConfigVersion.cmake"
+  "ZyrnixConfig.cmake"
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  "benchmarks/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "benchmarks/compare/CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/Zyrnix.dir/DependInfo.cmake"
+  "CMakeFiles/zyrnix_decode.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_allocations.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_async.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_config.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_deferred.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_filters.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_formatting.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_latency.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_metrics.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_rate_limiter.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_redaction.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_rotating.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_throughput.dir/DependInfo.cmake"
+  "benchmarks/CMakeFiles/bench_write_speed.dir/DependInfo.cmake"
+  "benchmarks/compare/CMakeFiles/bench_compare.dir/DependInfo.cmake"
+  )
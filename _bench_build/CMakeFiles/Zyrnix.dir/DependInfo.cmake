@@ -0,0 +1,93 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/Zyrnix.cpp" "CMakeFiles/Zyrnix.dir/src/Zyrnix.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/Zyrnix.cpp.o.d"
+  "/root/repo/src/adaptive_sampler.cpp" "CMakeFiles/Zyrnix.dir/src/adaptive_sampler.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/adaptive_sampler.cpp.o.d"
+  "/root/repo/src/aho_corasick.cpp" "CMakeFiles/Zyrnix.dir/src/aho_corasick.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/aho_corasick.cpp.o.d"
+  "/root/repo/src/async/async_logger.cpp" "CMakeFiles/Zyrnix.dir/src/async/async_logger.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/async/async_logger.cpp.o.d"
+  "/root/repo/src/async/async_queue.cpp" "CMakeFiles/Zyrnix.dir/src/async/async_queue.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/async/async_queue.cpp.o.d"
+  "/root/repo/src/async/record_pool.cpp" "CMakeFiles/Zyrnix.dir/src/async/record_pool.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/async/record_pool.cpp.o.d"
+  "/root/repo/src/async/thread_pool.cpp" "CMakeFiles/Zyrnix.dir/src/async/thread_pool.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/async/thread_pool.cpp.o.d"
+  "/root/repo/src/backtrace_ring.cpp" "CMakeFiles/Zyrnix.dir/src/backtrace_ring.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/backtrace_ring.cpp.o.d"
+  "/root/repo/src/binary_log.cpp" "CMakeFiles/Zyrnix.dir/src/binary_log.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/binary_log.cpp.o.d"
+  "/root/repo/src/child_logger.cpp" "CMakeFiles/Zyrnix.dir/src/child_logger.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/child_logger.cpp.o.d"
+  "/root/repo/src/color.cpp" "CMakeFiles/Zyrnix.dir/src/color.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/color.cpp.o.d"
+  "/root/repo/src/config.cpp" "CMakeFiles/Zyrnix.dir/src/config.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/config.cpp.o.d"
+  "/root/repo/src/config_watcher.cpp" "CMakeFiles/Zyrnix.dir/src/config_watcher.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/config_watcher.cpp.o.d"
+  "/root/repo/src/coro.cpp" "CMakeFiles/Zyrnix.dir/src/coro.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/coro.cpp.o.d"
+  "/root/repo/src/cycle_clock.cpp" "CMakeFiles/Zyrnix.dir/src/cycle_clock.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/cycle_clock.cpp.o.d"
+  "/root/repo/src/dedup.cpp" "CMakeFiles/Zyrnix.dir/src/dedup.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/dedup.cpp.o.d"
+  "/root/repo/src/field.cpp" "CMakeFiles/Zyrnix.dir/src/field.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/field.cpp.o.d"
+  "/root/repo/src/formatted_record.cpp" "CMakeFiles/Zyrnix.dir/src/formatted_record.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/formatted_record.cpp.o.d"
+  "/root/repo/src/formatter.cpp" "CMakeFiles/Zyrnix.dir/src/formatter.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/formatter.cpp.o.d"
+  "/root/repo/src/hot_reload_manager.cpp" "CMakeFiles/Zyrnix.dir/src/hot_reload_manager.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/hot_reload_manager.cpp.o.d"
+  "/root/repo/src/interned_name.cpp" "CMakeFiles/Zyrnix.dir/src/interned_name.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/interned_name.cpp.o.d"
+  "/root/repo/src/json_escape.cpp" "CMakeFiles/Zyrnix.dir/src/json_escape.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/json_escape.cpp.o.d"
+  "/root/repo/src/keyed_rate_limiter.cpp" "CMakeFiles/Zyrnix.dir/src/keyed_rate_limiter.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/keyed_rate_limiter.cpp.o.d"
+  "/root/repo/src/latency_histogram.cpp" "CMakeFiles/Zyrnix.dir/src/latency_histogram.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/latency_histogram.cpp.o.d"
+  "/root/repo/src/level_rules.cpp" "CMakeFiles/Zyrnix.dir/src/level_rules.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/level_rules.cpp.o.d"
+  "/root/repo/src/log_context.cpp" "CMakeFiles/Zyrnix.dir/src/log_context.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/log_context.cpp.o.d"
+  "/root/repo/src/log_filter.cpp" "CMakeFiles/Zyrnix.dir/src/log_filter.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/log_filter.cpp.o.d"
+  "/root/repo/src/log_health.cpp" "CMakeFiles/Zyrnix.dir/src/log_health.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/log_health.cpp.o.d"
+  "/root/repo/src/log_metrics.cpp" "CMakeFiles/Zyrnix.dir/src/log_metrics.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/log_metrics.cpp.o.d"
+  "/root/repo/src/log_site.cpp" "CMakeFiles/Zyrnix.dir/src/log_site.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/log_site.cpp.o.d"
+  "/root/repo/src/logger.cpp" "CMakeFiles/Zyrnix.dir/src/logger.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/logger.cpp.o.d"
+  "/root/repo/src/logger_registry.cpp" "CMakeFiles/Zyrnix.dir/src/logger_registry.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/logger_registry.cpp.o.d"
+  "/root/repo/src/metrics_server.cpp" "CMakeFiles/Zyrnix.dir/src/metrics_server.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/metrics_server.cpp.o.d"
+  "/root/repo/src/pii_detectors.cpp" "CMakeFiles/Zyrnix.dir/src/pii_detectors.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/pii_detectors.cpp.o.d"
+  "/root/repo/src/rate_limiter.cpp" "CMakeFiles/Zyrnix.dir/src/rate_limiter.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/rate_limiter.cpp.o.d"
+  "/root/repo/src/rcu.cpp" "CMakeFiles/Zyrnix.dir/src/rcu.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/rcu.cpp.o.d"
+  "/root/repo/src/redaction.cpp" "CMakeFiles/Zyrnix.dir/src/redaction.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/redaction.cpp.o.d"
+  "/root/repo/src/shm_ring.cpp" "CMakeFiles/Zyrnix.dir/src/shm_ring.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/shm_ring.cpp.o.d"
+  "/root/repo/src/sinks/async_log_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/async_log_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/async_log_sink.cpp.o.d"
+  "/root/repo/src/sinks/binary_file_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/binary_file_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/binary_file_sink.cpp.o.d"
+  "/root/repo/src/sinks/cloud_sinks.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/cloud_sinks.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/cloud_sinks.cpp.o.d"
+  "/root/repo/src/sinks/compressed_file_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/compressed_file_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/compressed_file_sink.cpp.o.d"
+  "/root/repo/src/sinks/daily_file_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/daily_file_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/daily_file_sink.cpp.o.d"
+  "/root/repo/src/sinks/file_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/file_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/file_sink.cpp.o.d"
+  "/root/repo/src/sinks/flush_policy.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/flush_policy.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/flush_policy.cpp.o.d"
+  "/root/repo/src/sinks/group_commit.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/group_commit.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/group_commit.cpp.o.d"
+  "/root/repo/src/sinks/http_transport.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/http_transport.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/http_transport.cpp.o.d"
+  "/root/repo/src/sinks/isolated_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/isolated_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/isolated_sink.cpp.o.d"
+  "/root/repo/src/sinks/journald_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/journald_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/journald_sink.cpp.o.d"
+  "/root/repo/src/sinks/lazy_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/lazy_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/lazy_sink.cpp.o.d"
+  "/root/repo/src/sinks/log_file.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/log_file.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/log_file.cpp.o.d"
+  "/root/repo/src/sinks/loki_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/loki_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/loki_sink.cpp.o.d"
+  "/root/repo/src/sinks/mmap_file_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/mmap_file_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/mmap_file_sink.cpp.o.d"
+  "/root/repo/src/sinks/multi_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/multi_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/multi_sink.cpp.o.d"
+  "/root/repo/src/sinks/null_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/null_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/null_sink.cpp.o.d"
+  "/root/repo/src/sinks/otlp_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/otlp_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/otlp_sink.cpp.o.d"
+  "/root/repo/src/sinks/rfc5424_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/rfc5424_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/rfc5424_sink.cpp.o.d"
+  "/root/repo/src/sinks/rotating_file_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/rotating_file_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/rotating_file_sink.cpp.o.d"
+  "/root/repo/src/sinks/shm_ring_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/shm_ring_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/shm_ring_sink.cpp.o.d"
+  "/root/repo/src/sinks/signal_safe_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/signal_safe_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/signal_safe_sink.cpp.o.d"
+  "/root/repo/src/sinks/spill_queue.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/spill_queue.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/spill_queue.cpp.o.d"
+  "/root/repo/src/sinks/stdout_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/stdout_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/stdout_sink.cpp.o.d"
+  "/root/repo/src/sinks/structured_json_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/structured_json_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/structured_json_sink.cpp.o.d"
+  "/root/repo/src/sinks/structured_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/structured_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/structured_sink.cpp.o.d"
+  "/root/repo/src/sinks/syslog_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/syslog_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/syslog_sink.cpp.o.d"
+  "/root/repo/src/sinks/tcp_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/tcp_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/tcp_sink.cpp.o.d"
+  "/root/repo/src/sinks/udp_sink.cpp" "CMakeFiles/Zyrnix.dir/src/sinks/udp_sink.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/sinks/udp_sink.cpp.o.d"
+  "/root/repo/src/snappy.cpp" "CMakeFiles/Zyrnix.dir/src/snappy.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/snappy.cpp.o.d"
+  "/root/repo/src/structured_encoder.cpp" "CMakeFiles/Zyrnix.dir/src/structured_encoder.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/structured_encoder.cpp.o.d"
+  "/root/repo/src/structured_logger.cpp" "CMakeFiles/Zyrnix.dir/src/structured_logger.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/structured_logger.cpp.o.d"
+  "/root/repo/src/thread_placement.cpp" "CMakeFiles/Zyrnix.dir/src/thread_placement.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/thread_placement.cpp.o.d"
+  "/root/repo/src/timestamp_cache.cpp" "CMakeFiles/Zyrnix.dir/src/timestamp_cache.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/timestamp_cache.cpp.o.d"
+  "/root/repo/src/trace_context.cpp" "CMakeFiles/Zyrnix.dir/src/trace_context.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/trace_context.cpp.o.d"
+  "/root/repo/src/tracepoints.cpp" "CMakeFiles/Zyrnix.dir/src/tracepoints.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/tracepoints.cpp.o.d"
+  "/root/repo/src/util.cpp" "CMakeFiles/Zyrnix.dir/src/util.cpp.o" "gcc" "CMakeFiles/Zyrnix.dir/src/util.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
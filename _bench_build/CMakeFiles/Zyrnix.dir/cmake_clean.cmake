@@ -0,0 +1,159 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Zyrnix.dir/src/Zyrnix.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/Zyrnix.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/adaptive_sampler.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/adaptive_sampler.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/aho_corasick.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/aho_corasick.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/async/async_logger.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/async/async_logger.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/async/async_queue.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/async/async_queue.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/async/record_pool.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/async/record_pool.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/async/thread_pool.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/async/thread_pool.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/backtrace_ring.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/backtrace_ring.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/binary_log.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/binary_log.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/child_logger.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/child_logger.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/color.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/color.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/config.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/config.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/config_watcher.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/config_watcher.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/coro.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/coro.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/cycle_clock.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/cycle_clock.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/dedup.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/dedup.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/field.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/field.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/formatted_record.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/formatted_record.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/formatter.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/formatter.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/hot_reload_manager.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/hot_reload_manager.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/interned_name.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/interned_name.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/json_escape.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/json_escape.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/keyed_rate_limiter.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/keyed_rate_limiter.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/latency_histogram.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/latency_histogram.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/level_rules.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/level_rules.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/log_context.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/log_context.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/log_filter.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/log_filter.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/log_health.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/log_health.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/log_metrics.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/log_metrics.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/log_site.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/log_site.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/logger.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/logger.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/logger_registry.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/logger_registry.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/metrics_server.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/metrics_server.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/pii_detectors.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/pii_detectors.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/rate_limiter.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/rate_limiter.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/rcu.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/rcu.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/redaction.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/redaction.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/shm_ring.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/shm_ring.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/async_log_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/async_log_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/binary_file_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/binary_file_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/cloud_sinks.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/cloud_sinks.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/compressed_file_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/compressed_file_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/daily_file_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/daily_file_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/file_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/file_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/flush_policy.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/flush_policy.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/group_commit.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/group_commit.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/http_transport.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/http_transport.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/isolated_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/isolated_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/journald_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/journald_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/lazy_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/lazy_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/log_file.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/log_file.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/loki_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/loki_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/mmap_file_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/mmap_file_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/multi_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/multi_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/null_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/null_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/otlp_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/otlp_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/rfc5424_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/rfc5424_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/rotating_file_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/rotating_file_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/shm_ring_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/shm_ring_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/signal_safe_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/signal_safe_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/spill_queue.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/spill_queue.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/stdout_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/stdout_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/structured_json_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/structured_json_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/structured_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/structured_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/syslog_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/syslog_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/tcp_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/tcp_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/sinks/udp_sink.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/sinks/udp_sink.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/snappy.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/snappy.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/structured_encoder.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/structured_encoder.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/structured_logger.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/structured_logger.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/thread_placement.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/thread_placement.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/timestamp_cache.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/timestamp_cache.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/trace_context.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/trace_context.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/tracepoints.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/tracepoints.cpp.o.d"
+  "CMakeFiles/Zyrnix.dir/src/util.cpp.o"
+  "CMakeFiles/Zyrnix.dir/src/util.cpp.o.d"
+  "libZyrnix.a"
+  "libZyrnix.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Zyrnix.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
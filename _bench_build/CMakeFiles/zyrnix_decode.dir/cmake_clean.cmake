@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zyrnix_decode.dir/tools/zyrnix_decode.cpp.o"
+  "CMakeFiles/zyrnix_decode.dir/tools/zyrnix_decode.cpp.o.d"
+  "zyrnix_decode"
+  "zyrnix_decode.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zyrnix_decode.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,25 @@
+
+
+# Get installation prefix (parent of lib/cmake/Zyrnix)
+get_filename_component(XLOG_INSTALL_PREFIX "${CMAKE_CURRENT_LIST_DIR}/../../.." ABSOLUTE)
+
+# Version info
+set(Zyrnix_VERSION "1.1.1")
+set(Zyrnix_VERSION_MAJOR "1")
+set(Zyrnix_VERSION_MINOR "1")
+set(Zyrnix_VERSION_PATCH "1")
+
+add_library(Zyrnix STATIC IMPORTED)
+set_target_properties(Zyrnix PROPERTIES
+    IMPORTED_LOCATION "${XLOG_INSTALL_PREFIX}/lib/libZyrnix.a"
+    INTERFACE_INCLUDE_DIRECTORIES "${XLOG_INSTALL_PREFIX}/include"
+)
+
+if(ON)
+    include(CMakeFindDependencyMacro)
+    find_dependency(fmt)
+    set_target_properties(Zyrnix PROPERTIES
+        INTERFACE_LINK_LIBRARIES fmt::fmt
+        INTERFACE_COMPILE_DEFINITIONS XLOG_HAS_FMT=1
+    )
+endif()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_allocations.dir/bench_allocations.cpp.o"
+  "CMakeFiles/bench_allocations.dir/bench_allocations.cpp.o.d"
+  "bench_allocations"
+  "bench_allocations.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_allocations.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
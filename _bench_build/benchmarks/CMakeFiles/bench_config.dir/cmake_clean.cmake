@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_config.dir/bench_config.cpp.o"
+  "CMakeFiles/bench_config.dir/bench_config.cpp.o.d"
+  "bench_config"
+  "bench_config.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_config.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
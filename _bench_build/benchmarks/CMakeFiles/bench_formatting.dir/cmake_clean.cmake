@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_formatting.dir/bench_formatting.cpp.o"
+  "CMakeFiles/bench_formatting.dir/bench_formatting.cpp.o.d"
+  "bench_formatting"
+  "bench_formatting.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_formatting.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_redaction.dir/bench_redaction.cpp.o"
+  "CMakeFiles/bench_redaction.dir/bench_redaction.cpp.o.d"
+  "bench_redaction"
+  "bench_redaction.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_redaction.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
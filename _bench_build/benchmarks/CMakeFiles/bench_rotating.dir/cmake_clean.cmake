@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_rotating.dir/bench_rotating.cpp.o"
+  "CMakeFiles/bench_rotating.dir/bench_rotating.cpp.o.d"
+  "bench_rotating"
+  "bench_rotating.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_rotating.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_write_speed.dir/bench_write_speed.cpp.o"
+  "CMakeFiles/bench_write_speed.dir/bench_write_speed.cpp.o.d"
+  "bench_write_speed"
+  "bench_write_speed.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_write_speed.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
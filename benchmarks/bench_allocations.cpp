@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include "Zyrnix/sinks/udp_sink.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+using namespace Zyrnix;
+
+// Every heap allocation in the process goes through here, so the
+// benchmarks can report how many a single log call costs.
+namespace {
+std::atomic<uint64_t> allocations{0};
+}
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// allocs_per_log should be 0: a literal reaches the sink as a view
+void log_literal(benchmark::State& state, Logger& logger) {
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        logger.info("request completed status=200 latency_ms=17");
+    }
+    const uint64_t count = allocations.load(std::memory_order_relaxed) - before;
+    state.counters["allocs_per_log"] = static_cast<double>(count) / static_cast<double>(state.iterations());
+}
+
+void BM_Alloc_NullSink(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    log_literal(state, logger);
+}
+
+void BM_Alloc_UdpSink(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<UdpSink>("127.0.0.1", 9));
+    log_literal(state, logger);
+}
+
+}
+
+BENCHMARK(BM_Alloc_NullSink);
+BENCHMARK(BM_Alloc_UdpSink);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/async/async_queue.hpp"
+#include <thread>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+constexpr size_t records_per_producer = 20000;
+
+// One iteration: N producers push a fixed number of records each while a
+// single consumer drains the queue, as the async logger does. With
+// with_fields each record carries three fields, as one with a request
+// context would.
+void run_queue(benchmark::State& state, QueueBackend backend, bool with_fields = false) {
+    const size_t producers = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state) {
+        AsyncQueueOptions options;
+        options.backend = backend;
+        options.capacity = 8192;
+        AsyncQueue queue(options);
+
+        std::thread consumer([&queue] {
+            LogRecord record;
+            while (queue.pop(record)) {
+                benchmark::DoNotOptimize(record.message.data());
+            }
+        });
+
+        std::vector<std::thread> threads;
+        threads.reserve(producers);
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, with_fields] {
+                for (size_t i = 0; i < records_per_producer; ++i) {
+                    LogRecord record;
+                    record.level = LogLevel::Info;
+                    record.message = "benchmark message";
+                    if (with_fields) {
+                        record.fields.emplace("request_id", "7f3a9c");
+                        record.fields.emplace("tenant", "acme");
+                        record.fields.emplace("attempt", static_cast<int64_t>(i));
+                    }
+                    while (!queue.push(std::move(record))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        queue.shutdown(true);
+        consumer.join();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * producers * records_per_producer));
+}
+
+void BM_AsyncQueue_Mutex(benchmark::State& state) {
+    run_queue(state, QueueBackend::Mutex);
+}
+
+void BM_AsyncQueue_LockFreeRing(benchmark::State& state) {
+    run_queue(state, QueueBackend::LockFreeRing);
+}
+
+void BM_AsyncQueue_PerThreadLanes(benchmark::State& state) {
+    run_queue(state, QueueBackend::PerThreadLanes);
+}
+
+void BM_AsyncQueue_LockFreeRing_Fields(benchmark::State& state) {
+    run_queue(state, QueueBackend::LockFreeRing, true);
+}
+
+void BM_AsyncQueue_PerThreadLanes_Fields(benchmark::State& state) {
+    run_queue(state, QueueBackend::PerThreadLanes, true);
+}
+
+}
+
+BENCHMARK(BM_AsyncQueue_Mutex)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AsyncQueue_LockFreeRing)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AsyncQueue_PerThreadLanes)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_AsyncQueue_LockFreeRing_Fields)->Arg(1)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AsyncQueue_PerThreadLanes_Fields)->Arg(1)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/config.hpp"
+#include "Zyrnix/logger.hpp"
+#include <filesystem>
+#include <string>
+
+using namespace Zyrnix;
+
+namespace {
+
+const auto log_dir = std::filesystem::temp_directory_path() / "Zyrnix_bench_config";
+
+// range(0) loggers, each with a pattern, a redaction preset and a stdout
+// and a file sink, like a service with one logger per component
+std::string large_config(int64_t loggers, bool lazy) {
+    std::string json = "{\"loggers\": [\n";
+    for (int64_t i = 0; i < loggers; ++i) {
+        const std::string n = std::to_string(i);
+        json += (i ? ",\n" : "");
+        json += "  {\"name\": \"component" + n + "\", \"level\": \"info\", \"pattern\": \"%Y-%m-%d %H:%M:%S %l [%n] %v\",";
+        json += " \"redact_presets\": \"email\", \"lazy_sinks\": " + std::string(lazy ? "true" : "false") + ",";
+        json += " \"sinks\": [{\"type\": \"stdout\", \"pattern\": \"%l %v\"},";
+        json += " {\"type\": \"file\", \"path\": \"" + (log_dir / (n + ".log")).string() + "\"}]}";
+    }
+    return json + "\n]}\n";
+}
+
+void BM_Config_Parse(benchmark::State& state) {
+    const std::string json = large_config(state.range(0), false);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ConfigLoader::load_from_json_string(json));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+// Parse plus create_loggers(): the startup cost of a config. With lazy
+// sinks (range(1)) no file is opened until the first record.
+void BM_Config_Startup(benchmark::State& state) {
+    std::filesystem::create_directories(log_dir);
+    const std::string json = large_config(state.range(0), state.range(1) != 0);
+    for (auto _ : state) {
+        ConfigLoader::load_from_json_string(json);
+        auto loggers = ConfigLoader::create_loggers();
+        benchmark::DoNotOptimize(loggers.size());
+        state.PauseTiming();
+        loggers.clear();
+        state.ResumeTiming();
+    }
+    std::filesystem::remove_all(log_dir);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+
+}
+
+BENCHMARK(BM_Config_Parse)->Arg(40)->Arg(400)->Arg(4000);
+BENCHMARK(BM_Config_Startup)->Args({400, 0})->Args({400, 1})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/log_macros.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include <memory>
+
+using namespace Zyrnix;
+
+namespace {
+
+// Caller-side cost on an async logger: formatting on the calling thread
+// versus capturing the raw arguments and formatting on the consumer.
+std::shared_ptr<Logger> make_logger() {
+    AsyncOptions options;
+    options.overflow_policy = OverflowPolicy::DropNewest;
+    auto logger = Logger::create_async("bench", options);
+    logger->add_sink(std::make_shared<NullSink>());
+    return logger;
+}
+
+void BM_Async_Formatted(benchmark::State& state) {
+    auto logger = make_logger();
+    int i = 0;
+    for (auto _ : state) {
+        logger->info("request {} completed status={} latency_ms={:.2f} path={}", ++i, 200, 17.25, "/api/v1/items");
+    }
+    logger->flush();
+}
+
+void BM_Async_Deferred(benchmark::State& state) {
+    auto logger = make_logger();
+    int i = 0;
+    for (auto _ : state) {
+        XLOG_INFO_DEFERRED(logger, "request {} completed status={} latency_ms={:.2f} path={}", ++i, 200, 17.25,
+                           "/api/v1/items");
+    }
+    logger->flush();
+}
+
+}
+
+BENCHMARK(BM_Async_Formatted);
+BENCHMARK(BM_Async_Deferred);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/log_filter.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+// Filters run on the logging threads without the logger's mutex, so
+// throughput should grow with the thread count.
+void BM_Filter_Regex(benchmark::State& state) {
+    static std::shared_ptr<Logger> logger;
+    if (state.thread_index() == 0) {
+        logger = std::make_shared<Logger>("bench");
+        logger->add_sink(std::make_shared<NullSink>());
+        logger->add_filter(std::make_shared<RegexFilter>("status=(2|3)[0-9]{2}"));
+    }
+    for (auto _ : state) {
+        logger->info("request completed status=200 latency_ms=17 path=/api/v1/orders/8812");
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        logger.reset();
+    }
+}
+
+
+// Rejected in stage one: no LogRecord is built for the dropped records
+void BM_Filter_FieldReject(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    logger.add_filter(std::make_shared<FieldFilter>("tenant", "acme"));
+    for (auto _ : state) {
+        logger.info("request completed status=200 latency_ms=17 path=/api/v1/orders/8812");
+    }
+}
+
+// Twenty patterns of which none matches, the worst case for an OR chain
+std::vector<std::string> alert_patterns() {
+    std::vector<std::string> patterns;
+    for (int i = 0; i < 20; ++i) {
+        patterns.push_back("code=E" + std::to_string(1000 + i * 37) + "\\b");
+    }
+    return patterns;
+}
+
+RegexFilterOptions engine_options(const benchmark::State& state) {
+    RegexFilterOptions options;
+    options.engine = state.range(0) ? RegexEngine::RE2 : RegexEngine::Std;
+    return options;
+}
+
+// One RegexFilter per pattern: the message is scanned twenty times
+void BM_Filter_RegexChain(benchmark::State& state) {
+    auto any = std::make_shared<CompositeFilter>(CompositeFilter::Mode::OR);
+    for (const auto& pattern : alert_patterns()) {
+        any->add_filter(std::make_shared<RegexFilter>(pattern, engine_options(state)));
+    }
+    const RecordView view("bench", LogLevel::Info,
+                          "request completed status=200 latency_ms=17 path=/api/v1/orders/8812", nullptr);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(any->prefilter(view));
+    }
+}
+
+// The same patterns as one set: a single scan
+void BM_Filter_RegexSet(benchmark::State& state) {
+    RegexSetFilter any(alert_patterns(), engine_options(state));
+    const RecordView view("bench", LogLevel::Info,
+                          "request completed status=200 latency_ms=17 path=/api/v1/orders/8812", nullptr);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(any.prefilter(view));
+    }
+}
+
+// level >= warn && tenant == acme && (msg ~ timeout || msg ~ refused), on a
+// record that passes the first two tests
+const FieldList& tenant_fields() {
+    static const FieldList fields{{"tenant", "acme"}, {"region", "eu"}};
+    return fields;
+}
+
+void BM_Filter_CompositeTree(benchmark::State& state) {
+    RegexFilterOptions options;
+    options.track_stats = false;
+    options.engine = RegexEngine::RE2;
+    auto either = std::make_shared<CompositeFilter>(CompositeFilter::Mode::OR);
+    either->add_filter(std::make_shared<RegexFilter>("timeout", options));
+    either->add_filter(std::make_shared<RegexFilter>("refused", options));
+    CompositeFilter all(CompositeFilter::Mode::AND);
+    all.add_filter(std::make_shared<LevelFilter>(LogLevel::Warn));
+    all.add_filter(std::make_shared<FieldFilter>("tenant", "acme"));
+    all.add_filter(either);
+
+    RecordView view("bench", LogLevel::Error, "upstream call failed: connection refused", nullptr);
+    view.fields = &tenant_fields();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(all.prefilter(view));
+    }
+}
+
+void BM_Filter_Expression(benchmark::State& state) {
+    auto filter = ExpressionFilter::compile(
+        "level >= warn && field.tenant == \"acme\" && (msg ~ /timeout/ || msg ~ /refused/)");
+    RecordView view("bench", LogLevel::Error, "upstream call failed: connection refused", nullptr);
+    view.fields = &tenant_fields();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter->prefilter(view));
+    }
+}
+
+}
+
+BENCHMARK(BM_Filter_CompositeTree);
+BENCHMARK(BM_Filter_Expression);
+BENCHMARK(BM_Filter_RegexChain)->ArgName("re2")->Arg(0)->Arg(1);
+BENCHMARK(BM_Filter_RegexSet)->ArgName("re2")->Arg(0)->Arg(1);
+BENCHMARK(BM_Filter_FieldReject);
+BENCHMARK(BM_Filter_Regex)->Threads(1)->Threads(4)->UseRealTime();
+
+BENCHMARK_MAIN();
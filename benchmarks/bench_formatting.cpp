@@ -0,0 +1,281 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/log_macros.hpp"
+#include "Zyrnix/formatter.hpp"
+#include "Zyrnix/json_escape.hpp"
+#include "Zyrnix/log_context.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include "Zyrnix/sinks/structured_json_sink.hpp"
+#include "Zyrnix/structured_encoder.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace Zyrnix;
+
+namespace {
+
+const std::string message = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+void BM_Formatter_Format(benchmark::State& state) {
+    Formatter formatter;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(formatter.format("bench", LogLevel::Info, message));
+    }
+}
+
+const char* const iso_pattern = "%Y-%m-%dT%H:%M:%S.%e %l [%n] %t %v";
+
+void BM_Formatter_Pattern(benchmark::State& state) {
+    Formatter formatter{std::string(iso_pattern)};
+    const auto now = std::chrono::system_clock::now();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(formatter.format(now, "bench", LogLevel::Info, message, 1234));
+    }
+}
+
+void BM_Formatter_PatternCompiled(benchmark::State& state) {
+    const Formatter formatter = Formatter::compiled<"%Y-%m-%dT%H:%M:%S.%e %l [%n] %t %v">();
+    const auto now = std::chrono::system_clock::now();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(formatter.format(now, "bench", LogLevel::Info, message, 1234));
+    }
+}
+
+// N file sinks with the default layout; the line is rendered once and
+// shared, so cost should grow with the writes, not with formatting
+void BM_FanOut_FileSinks(benchmark::State& state) {
+    Logger logger("bench");
+    for (int i = 0; i < state.range(0); ++i) {
+        logger.add_sink(std::make_shared<FileSink>("/dev/null"));
+    }
+    for (auto _ : state) {
+        logger.info(message);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// The logger takes Debug but no sink does: rejected at the top of log()
+void BM_Log_BelowAllSinks(benchmark::State& state) {
+    Logger logger("bench");
+    auto sink = std::make_shared<NullSink>();
+    sink->set_level(LogLevel::Info);
+    logger.add_sink(sink);
+    for (auto _ : state) {
+        logger.debug(message);
+    }
+}
+
+const std::map<std::string, std::string> json_fields = {
+    {"user_id", "8812"}, {"path", "/api/v1/orders/8812"}, {"agent", "curl/8.4.0 \"bench\""}};
+
+// How StructuredJsonSink built a line before: ostringstream, a string per
+// escaped value and a stream per control character
+std::string legacy_escape(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 32) {
+                    std::ostringstream oss;
+                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+                    result += oss.str();
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result;
+}
+
+std::string legacy_json_line(const std::string& logger_name, LogLevel level, const std::string& text,
+                             const std::map<std::string, std::string>& fields) {
+    const auto now = std::chrono::system_clock::now();
+    std::string timestamp(TimestampCache::utc(now));
+    TimestampCache::append_fraction(timestamp, now, TimePrecision::Milliseconds);
+    std::ostringstream json;
+    json << "{\"timestamp\":\"" << timestamp << "Z\",\"level\":\"" << to_string(level) << "\",";
+    json << "\"logger\":\"" << legacy_escape(logger_name) << "\",\"message\":\"" << legacy_escape(text) << "\"";
+    for (const auto& [key, value] : fields) {
+        json << ",\"" << legacy_escape(key) << "\":\"" << legacy_escape(value) << "\"";
+    }
+    json << "}";
+    return json.str();
+}
+
+void BM_Json_LegacyLine(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacy_json_line("bench", LogLevel::Info, message, json_fields));
+    }
+}
+
+// The whole sink, written out to /dev/null, against building the line above
+void BM_Json_StructuredSink(benchmark::State& state) {
+    StructuredJsonSink sink("/dev/null");
+    for (auto _ : state) {
+        sink.log_with_fields("bench", LogLevel::Info, message, json_fields);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// The same with request context: two global keys on the sink and three
+// in the thread's LogContext
+void BM_Json_StructuredSink_Context(benchmark::State& state) {
+    StructuredJsonSink sink("/dev/null");
+    sink.set_context("service", "checkout");
+    sink.set_context("host", "web-17.eu-west");
+    ScopedContext context;
+    context.set("request_id", "7f3a9c2e-51d4-4b8a-9be0-0c6d1f2a9e44")
+        .set("tenant", "acme")
+        .set("route", "POST /api/v1/orders");
+    for (auto _ : state) {
+        sink.log_with_fields("bench", LogLevel::Info, message, json_fields);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+const StructuredFormat structured_formats[] = {StructuredFormat::Json,    StructuredFormat::MsgPack,
+                                               StructuredFormat::Cbor,    StructuredFormat::Protobuf,
+                                               StructuredFormat::Logfmt,  StructuredFormat::Ecs,
+                                               StructuredFormat::Gelf};
+
+// One record with three typed fields through each encoder, into a reused
+// buffer; bytes_per_line is the size of the record
+void BM_Structured_Encode(benchmark::State& state) {
+    auto encoder = make_encoder(structured_formats[state.range(0)]);
+    const Field fields[] = {kv("status", 200), kv("latency_ms", 3.25), kv("path", "/api/v1/orders/8812")};
+    const StructuredHeader header{std::chrono::system_clock::now(), LogLevel::Info, "bench", message};
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        encoder->begin(out, header, std::size(fields));
+        for (const auto& field : fields) {
+            encoder->member(out, field.key, field.value);
+        }
+        encoder->end(out, 0);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.counters["bytes_per_line"] = static_cast<double>(out.size());
+}
+
+// The whole sink with each encoder, the same fields as BM_Json_StructuredSink
+void BM_Structured_Sink(benchmark::State& state) {
+    StructuredSink sink("/dev/null", structured_formats[state.range(0)]);
+    for (auto _ : state) {
+        sink.log_with_fields("bench", LogLevel::Info, message, json_fields);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Escaping alone, over text of the given length with a quote every 64 bytes
+void BM_Json_Escape(benchmark::State& state) {
+    std::string text;
+    while (text.size() < static_cast<size_t>(state.range(0))) {
+        text.append(message, 0, 63).push_back('"');
+    }
+    text.resize(static_cast<size_t>(state.range(0)));
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        json::append_escaped(out, text);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    state.SetLabel(json::escape_kernel_name());
+}
+
+#if XLOG_HAS_FMT
+// Disabled level: the fmt overload returns before touching the arguments
+void BM_FmtLog_Disabled(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    logger.set_level(LogLevel::Info);
+    for (auto _ : state) {
+        logger.debug("request {} status={} latency_ms={:.1f}", 8812, 200, 17.25);
+    }
+}
+
+// Same through the macro: the level check plus the site's enable byte
+void BM_FmtLog_DisabledSite(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    logger.set_level(LogLevel::Info);
+    for (auto _ : state) {
+        XLOG_LOG_AT(&logger, LogLevel::Debug, "request {} status={} latency_ms={:.1f}", 8812, 200, 17.25);
+    }
+}
+
+// What callers had to write before: formats even though Debug is off
+void BM_FmtLog_DisabledPreformatted(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    logger.set_level(LogLevel::Info);
+    for (auto _ : state) {
+        logger.debug(fmt::format("request {} status={} latency_ms={:.1f}", 8812, 200, 17.25));
+    }
+}
+
+// Debug off but kept in a backtrace ring: formatted and copied, not written
+void BM_FmtLog_Backtrace(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    logger.set_level(LogLevel::Info);
+    logger.enable_backtrace(256);
+    for (auto _ : state) {
+        logger.debug("request {} status={} latency_ms={:.1f}", 8812, 200, 17.25);
+    }
+}
+
+// The same through a deferred site: only the argument bytes are copied
+void BM_FmtLog_BacktraceDeferred(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    logger.set_level(LogLevel::Info);
+    logger.enable_backtrace(256);
+    for (auto _ : state) {
+        XLOG_LOG_DEFERRED(&logger, LogLevel::Debug, "request {} status={} latency_ms={:.1f}", 8812, 200, 17.25);
+    }
+}
+
+void BM_FmtLog_Enabled(benchmark::State& state) {
+    Logger logger("bench");
+    logger.add_sink(std::make_shared<NullSink>());
+    for (auto _ : state) {
+        logger.info("request {} status={} latency_ms={:.1f}", 8812, 200, 17.25);
+    }
+}
+#endif
+
+}
+
+BENCHMARK(BM_Formatter_Format);
+BENCHMARK(BM_Formatter_Pattern);
+BENCHMARK(BM_Formatter_PatternCompiled);
+BENCHMARK(BM_Log_BelowAllSinks);
+#if XLOG_HAS_FMT
+BENCHMARK(BM_FmtLog_Disabled);
+BENCHMARK(BM_FmtLog_DisabledSite);
+BENCHMARK(BM_FmtLog_DisabledPreformatted);
+BENCHMARK(BM_FmtLog_Backtrace);
+BENCHMARK(BM_FmtLog_BacktraceDeferred);
+BENCHMARK(BM_FmtLog_Enabled);
+#endif
+BENCHMARK(BM_FanOut_FileSinks)->Arg(1)->Arg(3);
+BENCHMARK(BM_Json_LegacyLine);
+BENCHMARK(BM_Json_StructuredSink);
+BENCHMARK(BM_Json_StructuredSink_Context);
+// 0 JSON, 1 MessagePack, 2 CBOR, 3 protobuf
+BENCHMARK(BM_Structured_Encode)->DenseRange(0, 6);
+BENCHMARK(BM_Structured_Sink)->DenseRange(0, 6);
+BENCHMARK(BM_Json_Escape)->Arg(64)->Arg(4096);
+
+BENCHMARK_MAIN();
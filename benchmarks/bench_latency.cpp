@@ -0,0 +1,198 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/latency_histogram.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include "Zyrnix/sinks/rotating_file_sink.hpp"
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace Zyrnix;
+
+/*
+ * Tail latency of a log call under a fixed request rate.
+ *
+ * Each case drives range(3) calls per second in total from range(2)
+ * threads for a fixed time and records every call's latency into a
+ * LatencyHistogram. A call's latency is taken from when it was due, on a
+ * fixed schedule, not from when it started: when one call stalls, the
+ * calls queued up behind it are charged the wait, as the requests they
+ * stand for would be. Without that (coordinated omission) a 5 ms stall
+ * counts as one slow call however many were held up. The uncorrected
+ * figures are reported beside it as raw_*.
+ *
+ * Each case is one iteration; results are counters, so the usual output
+ * flags give a file to track across runs:
+ *
+ *     bench_latency --benchmark_out=latency.csv --benchmark_out_format=csv
+ *     bench_latency --benchmark_out=latency.json --benchmark_out_format=json
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+static_assert(std::is_same_v<Clock::duration, std::chrono::nanoseconds>, "histograms take nanoseconds");
+
+constexpr auto run_time = std::chrono::seconds(2);
+
+const std::string message = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+// range(0): sync, or async on one of the queue backends
+enum Mode : int64_t { Sync = 0, Mutex = 1, LockFreeRing = 2, PerThreadLanes = 3 };
+const char* const mode_names[] = {"sync", "mutex", "ring", "lanes"};
+
+// range(1): the sink
+enum SinkKind : int64_t { Null = 0, File = 1, Rotating = 2, Hiccup = 3 };
+const char* const sink_names[] = {"null", "file", "rotating", "hiccup"};
+
+// Stands in for a network sink: cheap, except that one write in
+// stall_every blocks for stall_for, as a full socket buffer or a
+// reconnect would
+class HiccupSink : public LogSink {
+public:
+    void log(const std::string&, LogLevel, const std::string&) override {}
+    void log_record(const FormattedRecord&) override {
+        if (++written_ % stall_every == 0) {
+            std::this_thread::sleep_for(stall_for);
+        }
+    }
+
+private:
+    static constexpr uint64_t stall_every = 20000;
+    static constexpr auto stall_for = std::chrono::milliseconds(5);
+    uint64_t written_ = 0;  // Sinks are called under the logger's sink lock
+};
+
+std::filesystem::path bench_path() {
+    return std::filesystem::temp_directory_path() / "Zyrnix_bench_latency.log";
+}
+
+void remove_outputs() {
+    const auto base = bench_path();
+    for (const auto& entry : std::filesystem::directory_iterator(base.parent_path())) {
+        if (entry.path().filename().string().rfind(base.filename().string(), 0) == 0) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
+
+std::shared_ptr<Logger> make_logger(int64_t mode, int64_t sink) {
+    std::shared_ptr<Logger> logger;
+    if (mode == Sync) {
+        logger = std::make_shared<Logger>("bench");
+    } else {
+        AsyncOptions options;
+        options.backend = mode == Mutex ? QueueBackend::Mutex
+                          : mode == LockFreeRing ? QueueBackend::LockFreeRing
+                                                 : QueueBackend::PerThreadLanes;
+        options.block_timeout_ms = 60000;  // A full queue shows as latency, not drops
+        logger = Logger::create_async("bench", options);
+    }
+    switch (sink) {
+        case File: logger->add_sink(std::make_shared<FileSink>(bench_path().string())); break;
+        // Rotates about every 10k lines
+        case Rotating: logger->add_sink(std::make_shared<RotatingFileSink>(bench_path().string(), 1024 * 1024, 5)); break;
+        case Hiccup: logger->add_sink(std::make_shared<HiccupSink>()); break;
+        default: logger->add_sink(std::make_shared<NullSink>()); break;
+    }
+    return logger;
+}
+
+// Sleeps while the next call is far off and yields the last stretch, so a
+// thread waiting for its slot leaves the core to the others and to the
+// async workers
+void wait_until(Clock::time_point due) {
+    constexpr auto sleep_margin = std::chrono::microseconds(100);
+    if (due - Clock::now() > sleep_margin) {
+        std::this_thread::sleep_until(due - sleep_margin);
+    }
+    while (Clock::now() < due) {
+        std::this_thread::yield();
+    }
+}
+
+struct Histograms {
+    LatencyHistogram corrected;
+    LatencyHistogram raw;
+};
+
+void generate(Logger& logger, Histograms& histograms, Clock::duration interval, Clock::time_point start,
+              Clock::time_point end) {
+    for (uint64_t i = 0;; ++i) {
+        const auto due = start + interval * i;
+        if (due >= end) {
+            break;
+        }
+        wait_until(due);  // Returns at once when behind schedule
+        const auto began = Clock::now();
+        logger.info(message);
+        const auto done = Clock::now();
+        histograms.corrected.record(static_cast<uint64_t>((done - due).count()));
+        histograms.raw.record(static_cast<uint64_t>((done - began).count()));
+    }
+}
+
+void BM_Latency(benchmark::State& state) {
+    const int64_t mode = state.range(0);
+    const int64_t sink = state.range(1);
+    const size_t threads = static_cast<size_t>(state.range(2));
+    const double rate = static_cast<double>(state.range(3));
+    // Each thread takes every threads-th slot of the overall schedule
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(threads) / rate));
+    auto histograms = std::make_unique<Histograms>();
+    for (auto _ : state) {
+        remove_outputs();
+        auto logger = make_logger(mode, sink);
+        const auto start = Clock::now() + std::chrono::milliseconds(10);
+        const auto end = start + run_time;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                generate(*logger, *histograms, interval, start + interval * t / threads, end);
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        logger->flush().wait();
+        logger.reset();
+        remove_outputs();
+    }
+
+    const auto corrected = histograms->corrected.snapshot();
+    const auto raw = histograms->raw.snapshot();
+    auto ns = [](uint64_t value) { return static_cast<double>(value); };
+    state.counters["calls"] = ns(corrected.count);
+    state.counters["rate"] = benchmark::Counter(ns(corrected.count), benchmark::Counter::kIsRate);
+    state.counters["p50_ns"] = ns(corrected.percentile(0.50));
+    state.counters["p99_ns"] = ns(corrected.percentile(0.99));
+    state.counters["p999_ns"] = ns(corrected.percentile(0.999));
+    state.counters["max_ns"] = ns(corrected.max_ns);
+    state.counters["raw_p99_ns"] = ns(raw.percentile(0.99));
+    state.counters["raw_p999_ns"] = ns(raw.percentile(0.999));
+    state.counters["raw_max_ns"] = ns(raw.max_ns);
+    state.SetLabel(std::string(mode_names[mode]) + "/" + sink_names[sink]);
+}
+
+void matrix(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"mode", "sink", "threads", "rate"});
+    for (int64_t sink : {Null, File, Rotating, Hiccup}) {
+        for (int64_t mode : {Sync, Mutex, LockFreeRing, PerThreadLanes}) {
+            for (int64_t threads : {1, 4}) {
+                bench->Args({mode, sink, threads, 100000});
+            }
+        }
+    }
+}
+
+}
+
+BENCHMARK(BM_Latency)->Apply(matrix)->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
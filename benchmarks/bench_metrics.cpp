@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include <atomic>
+#include <memory>
+
+using namespace Zyrnix;
+
+namespace {
+
+// What an async log call records: a counter and the queue depth seen
+void BM_Metrics_RecordPerCall(benchmark::State& state) {
+    static std::shared_ptr<LogMetrics> metrics;
+    if (state.thread_index() == 0) {
+        metrics = std::make_shared<LogMetrics>();
+    }
+    size_t depth = 0;
+    for (auto _ : state) {
+        metrics->record_message_logged();
+        metrics->observe_queue_depth(++depth & 1023);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The layout LogMetrics had before sharding: neighbouring atomics on one
+// line, bumped by every thread
+void BM_Metrics_SharedAtomics(benchmark::State& state) {
+    struct Shared {
+        std::atomic<uint64_t> logged{0};
+        std::atomic<uint64_t> max_depth{0};
+    };
+    static Shared shared;
+    uint64_t depth = 0;
+    for (auto _ : state) {
+        shared.logged.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t seen = ++depth & 1023;
+        uint64_t current = shared.max_depth.load(std::memory_order_relaxed);
+        while (seen > current && !shared.max_depth.compare_exchange_weak(current, seen, std::memory_order_relaxed)) {
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// A sync log call to a null sink with metrics on, timing one call in
+// range(0): 1 times every call, the default 64
+void BM_Metrics_LogCall(benchmark::State& state) {
+    Logger logger("bench_metrics_" + std::to_string(state.range(0)));
+    logger.add_sink(std::make_shared<NullSink>());
+    MetricsRegistry::instance().get_logger_metrics(logger.name)->set_timing_interval(static_cast<uint32_t>(state.range(0)));
+    for (auto _ : state) {
+        logger.info("request handled");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_Metrics_Snapshot(benchmark::State& state) {
+    LogMetrics metrics;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(metrics.get_snapshot());
+    }
+}
+
+// A scrape of range(0) loggers, each with a sink, one call of each timed,
+// rendered into the same buffer every time
+void BM_Metrics_Scrape(benchmark::State& state) {
+    auto& registry = MetricsRegistry::instance();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        const std::string name = "bench_scrape_" + std::to_string(i);
+        auto metrics = registry.get_logger_metrics(name);
+        metrics->record_message_logged();
+        metrics->record_log_call_ns(1500);
+        registry.get_sink_metrics(name + ".file")->record_write_duration_ns(4000);
+    }
+    std::string out;
+    for (auto _ : state) {
+        registry.write_exposition(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.counters["bytes"] = static_cast<double>(out.size());
+}
+
+}
+
+BENCHMARK(BM_Metrics_RecordPerCall)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_Metrics_SharedAtomics)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_Metrics_LogCall)->Arg(1)->Arg(64)->Arg(1 << 20);
+BENCHMARK(BM_Metrics_Snapshot);
+BENCHMARK(BM_Metrics_Scrape)->Arg(100)->Arg(2000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/adaptive_sampler.hpp"
+#include "Zyrnix/keyed_rate_limiter.hpp"
+#include "Zyrnix/rate_limiter.hpp"
+#include "Zyrnix/log_macros.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+// A rate high enough that every call is admitted: the cost of the check
+// itself, shared by all threads
+void BM_RateLimiter_Admit(benchmark::State& state) {
+    static std::unique_ptr<RateLimiter> limiter;
+    if (state.thread_index() == 0) {
+        limiter = std::make_unique<RateLimiter>(RateLimiterOptions{1'000'000'000, 1'000'000'000,
+                                                                   static_cast<size_t>(state.range(0))});
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(limiter->try_log());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// An error storm against an empty bucket
+void BM_RateLimiter_Refuse(benchmark::State& state) {
+    static std::unique_ptr<RateLimiter> limiter;
+    if (state.thread_index() == 0) {
+        limiter = std::make_unique<RateLimiter>(1, 1);
+        limiter->try_log();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(limiter->try_log());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// range(0) distinct keys against a 4096-key table: past capacity every
+// miss evicts
+void BM_KeyedLimiter(benchmark::State& state) {
+    static std::unique_ptr<KeyedRateLimiter> limiter;
+    if (state.thread_index() == 0) {
+        KeyedRateLimiterOptions options;
+        options.key_by = KeyedRateLimiterOptions::KeyBy::Message;
+        options.messages_per_second = 100;
+        limiter = std::make_unique<KeyedRateLimiter>(options);
+    }
+    std::vector<std::string> keys;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        keys.push_back("tenant-" + std::to_string(i));
+    }
+    size_t next = static_cast<size_t>(state.thread_index());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(limiter->try_log(keys[next]));
+        next = next + 1 == keys.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The per-record check with no pressure (rate 1:1), as most records see it
+void BM_AdaptiveSampler_Admit(benchmark::State& state) {
+    static std::unique_ptr<AdaptiveSampler> sampler;
+    if (state.thread_index() == 0) {
+        sampler = std::make_unique<AdaptiveSampler>();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sampler->admit(LogLevel::Info));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// A hot site behind XLOG_INFO_EVERY_N: nearly every call is held back
+void BM_Log_EveryN(benchmark::State& state) {
+    static std::shared_ptr<Logger> logger;
+    if (state.thread_index() == 0) {
+        logger = std::make_shared<Logger>("bench");
+        logger->add_sink(std::make_shared<NullSink>());
+    }
+    for (auto _ : state) {
+        XLOG_INFO_EVERY_N(logger, 10000, "cache miss for key {}", 42);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        logger.reset();
+    }
+}
+
+// An error storm through a deduplicating logger: all but one line per
+// window are counted rather than written. range(0) = 0 is the same
+// storm with dedup off.
+void BM_Log_Dedup(benchmark::State& state) {
+    static std::shared_ptr<Logger> logger;
+    if (state.thread_index() == 0) {
+        logger = std::make_shared<Logger>("bench");
+        logger->add_sink(std::make_shared<NullSink>());
+        if (state.range(0) != 0) {
+            logger->set_dedup();
+        }
+    }
+    for (auto _ : state) {
+        logger->error("connection to db-primary refused");
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        logger.reset();
+    }
+}
+
+}
+
+BENCHMARK(BM_Log_Dedup)->ArgName("dedup")->Arg(0)->Arg(1)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_Log_EveryN)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_RateLimiter_Admit)->ArgName("chunk")->Arg(1)->Arg(64)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_RateLimiter_Refuse)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_AdaptiveSampler_Admit)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_KeyedLimiter)->ArgName("keys")->Arg(16)->Arg(1000)->Arg(100000)->Threads(1)->Threads(4)->UseRealTime();
+
+BENCHMARK_MAIN();
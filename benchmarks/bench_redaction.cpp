@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/redaction.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+// A typical ~200 byte line with a couple of things worth redacting
+const std::string line =
+    "request completed user=alice@example.com client=192.168.10.42 path=/api/v1/orders/8812 "
+    "status=200 latency_ms=17 session=tok_live_51Hx token=abcdef trace=4bf92f3577b34da6a3ce929d0e0e4736";
+
+std::shared_ptr<Logger> make_logger() {
+    auto logger = std::make_shared<Logger>("bench");
+    logger->add_sink(std::make_shared<NullSink>());
+    return logger;
+}
+
+void run(benchmark::State& state, Logger& logger) {
+    for (auto _ : state) {
+        logger.info(line);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+void BM_Log_NoRedaction(benchmark::State& state) {
+    auto logger = make_logger();
+    run(state, *logger);
+}
+
+void BM_Log_SubstringRedaction(benchmark::State& state) {
+    auto logger = make_logger();
+    logger->set_redact_patterns({"tok_live_51Hx", "abcdef", "password", "api_key", "secret"});
+    run(state, *logger);
+}
+
+// Customer-specific token lists run into the hundreds
+void BM_Log_ManySubstrings(benchmark::State& state) {
+    auto logger = make_logger();
+    std::vector<std::string> tokens;
+    for (int i = 0; i < state.range(0); ++i) {
+        tokens.push_back("cust_token_" + std::to_string(i * 7919));
+    }
+    tokens.push_back("abcdef");
+    logger->set_redact_patterns(tokens);
+    run(state, *logger);
+}
+
+void BM_Log_PiiPresets(benchmark::State& state) {
+    auto logger = make_logger();
+    logger->set_redact_pii_presets({"email", "ipv4", "credit_card", "ssn"});
+    run(state, *logger);
+}
+
+// The presets alone, without the logger around them
+void BM_Redact_PiiPresets(benchmark::State& state) {
+    const Redactor redactor({}, {}, {"email", "ipv4", "credit_card", "ssn"}, false);
+    std::string out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(redactor.redact(line, out));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * line.size()));
+}
+
+void BM_Log_RegexAndPresets(benchmark::State& state) {
+    auto logger = make_logger();
+    logger->set_redact_patterns({"tok_live_51Hx", "abcdef"});
+    logger->set_redact_regex_patterns({"trace=[0-9a-f]{32}", "session=\\S+"});
+    logger->set_redact_pii_presets({"email", "ipv4"});
+    run(state, *logger);
+}
+
+}
+
+BENCHMARK(BM_Log_NoRedaction);
+BENCHMARK(BM_Log_SubstringRedaction);
+BENCHMARK(BM_Log_ManySubstrings)->Arg(20)->Arg(200);
+BENCHMARK(BM_Log_PiiPresets);
+BENCHMARK(BM_Redact_PiiPresets);
+BENCHMARK(BM_Log_RegexAndPresets);
+
+BENCHMARK_MAIN();
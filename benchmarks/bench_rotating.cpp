@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/rotating_file_sink.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+void remove_rotated(const std::filesystem::path& base) {
+    for (const auto& entry : std::filesystem::directory_iterator(base.parent_path())) {
+        if (entry.path().filename().string().rfind(base.filename().string(), 0) == 0) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
+
+// Per-call latency while the sink rotates every 1 MB, keeping range(0)
+// files, with range(1)-byte messages: about every 10k lines at 64 bytes.
+// The rotating calls are the tail: p99 and max show what a rotation costs
+// the caller.
+void BM_Rotating_Latency(benchmark::State& state) {
+    const auto base = std::filesystem::temp_directory_path() / "Zyrnix_bench_rotating";
+    remove_rotated(base);
+    const std::string message(static_cast<size_t>(state.range(1)), 'x');
+    std::vector<int64_t> samples;
+    samples.reserve(1 << 20);
+    {
+        Logger logger("bench");
+        logger.add_sink(std::make_shared<RotatingFileSink>(base.string(), 1024 * 1024,
+                                                           static_cast<size_t>(state.range(0))));
+        for (auto _ : state) {
+            const auto start = std::chrono::steady_clock::now();
+            logger.info(message);
+            const auto took = std::chrono::steady_clock::now() - start;
+            if (samples.size() < samples.capacity()) {
+                samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(took).count());
+            }
+        }
+    }
+    remove_rotated(base);
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double q) {
+        return samples.empty() ? 0.0 : static_cast<double>(samples[static_cast<size_t>(q * (samples.size() - 1))]);
+    };
+    state.counters["p50_ns"] = at(0.50);
+    state.counters["p99_ns"] = at(0.99);
+    state.counters["p9999_ns"] = at(0.9999);
+    state.counters["max_ns"] = samples.empty() ? 0.0 : static_cast<double>(samples.back());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+}
+
+BENCHMARK(BM_Rotating_Latency)
+    ->ArgNames({"files", "bytes"})
+    ->Args({5, 64})
+    ->Args({50, 64})
+    ->Args({5, 1024})
+    ->Iterations(500000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include "Zyrnix/sinks/structured_json_sink.hpp"
+#include <filesystem>
+#include <memory>
+#include <string>
+
+using namespace Zyrnix;
+
+namespace {
+
+// range(0) picks the sink, range(1) is the message length in bytes
+enum SinkKind : int64_t { Null = 0, File = 1, Json = 2 };
+
+const char* const sink_names[] = {"null", "file", "json"};
+
+std::string make_message(size_t size) {
+    const std::string pattern = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812 ";
+    std::string text;
+    while (text.size() < size) {
+        text.append(pattern);
+    }
+    text.resize(size);
+    return text;
+}
+
+std::filesystem::path bench_path() {
+    return std::filesystem::temp_directory_path() / "Zyrnix_bench_throughput.log";
+}
+
+LogSinkPtr make_sink(int64_t kind) {
+    switch (kind) {
+        case File: return std::make_shared<FileSink>(bench_path().string());
+        case Json: return std::make_shared<StructuredJsonSink>(bench_path().string());
+        default: return std::make_shared<NullSink>();
+    }
+}
+
+// Shared by all threads of a run; thread 0 builds it before the timed loop
+// and tears it down after, as in bench_filters.cpp
+std::shared_ptr<Logger> logger;
+std::string message;
+
+void setup(const benchmark::State& state, bool async) {
+    std::filesystem::remove(bench_path());
+    message = make_message(static_cast<size_t>(state.range(1)));
+    if (async) {
+        AsyncOptions options;
+        options.backend = QueueBackend::LockFreeRing;
+        options.block_timeout_ms = 60000;  // Wait out a full queue rather than drop
+        logger = Logger::create_async("bench", options);
+    } else {
+        logger = std::make_shared<Logger>("bench");
+    }
+    logger->add_sink(make_sink(state.range(0)));
+}
+
+void teardown(benchmark::State& state) {
+    logger.reset();
+    std::filesystem::remove(bench_path());
+    state.SetLabel(sink_names[state.range(0)]);
+}
+
+// Every call formats and writes on the calling thread, under the sink's lock
+void BM_Sync_Log(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        setup(state, false);
+    }
+    for (auto _ : state) {
+        logger->info(message);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+    if (state.thread_index() == 0) {
+        teardown(state);
+    }
+}
+
+// The caller only builds and pushes a record; one worker formats and writes.
+// The queue blocks when full, so over a run long enough to fill it the rate
+// is bounded by the worker, not just the push.
+void BM_Async_Log(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        setup(state, true);
+    }
+    for (auto _ : state) {
+        logger->info(message);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+    if (state.thread_index() == 0) {
+        teardown(state);
+    }
+}
+
+void sink_by_size(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"sink", "bytes"});
+    for (int64_t sink : {Null, File, Json}) {
+        for (int64_t size : {16, 128, 1024}) {
+            bench->Args({sink, size});
+        }
+    }
+}
+
+}
+
+BENCHMARK(BM_Sync_Log)->Apply(sink_by_size)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_Async_Log)->Apply(sink_by_size)->Threads(1)->Threads(4)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/binary_file_sink.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/flush_policy.hpp"
+#include "Zyrnix/sinks/mmap_file_sink.hpp"
+#include <filesystem>
+#include <memory>
+#include <string>
+
+using namespace Zyrnix;
+
+namespace {
+
+const std::string message = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+// A real file rather than /dev/null, so the per-line write() shows
+void run_file_sink(benchmark::State& state, const FlushPolicy& policy) {
+    const auto path = std::filesystem::temp_directory_path() / "Zyrnix_bench_write_speed.log";
+    std::filesystem::remove(path);
+    {
+        Logger logger("bench");
+        logger.add_sink(std::make_shared<FileSink>(path.string(), policy));
+        for (auto _ : state) {
+            logger.info(message);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    std::filesystem::remove(path);
+}
+
+void BM_FileSink_EveryLine(benchmark::State& state) {
+    run_file_sink(state, FlushPolicy::every_line());
+}
+
+void BM_FileSink_DefaultPolicy(benchmark::State& state) {
+    run_file_sink(state, FlushPolicy{});
+}
+
+void BM_FileSink_Never(benchmark::State& state) {
+    run_file_sink(state, FlushPolicy::never(1 << 20));
+}
+
+// Same buffer, written out through io_uring while the next one fills
+void BM_FileSink_IoUring(benchmark::State& state) {
+    FlushPolicy policy;
+    policy.backend = FileBackend::IoUring;
+    run_file_sink(state, policy);
+}
+
+void BM_FileSink_IoUringRegistered(benchmark::State& state) {
+    FlushPolicy policy;
+    policy.backend = FileBackend::IoUringRegistered;
+    run_file_sink(state, policy);
+}
+
+// A reservation and a memcpy per line; segments roll every 64 MB
+void BM_MmapFileSink(benchmark::State& state) {
+    const auto base = std::filesystem::temp_directory_path() / "Zyrnix_bench_mmap";
+    {
+        Logger logger("bench");
+        logger.add_sink(std::make_shared<MmapFileSink>(base.string()));
+        for (auto _ : state) {
+            logger.info(message);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    for (const auto& entry : std::filesystem::directory_iterator(base.parent_path())) {
+        if (entry.path().filename().string().rfind("Zyrnix_bench_mmap.", 0) == 0) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
+
+// Same buffering as DefaultPolicy, but no layout rendered
+void BM_BinaryFileSink(benchmark::State& state) {
+    const auto path = std::filesystem::temp_directory_path() / "Zyrnix_bench_write_speed.zbl";
+    std::filesystem::remove(path);
+    {
+        Logger logger("bench");
+        logger.add_sink(std::make_shared<BinaryFileSink>(path.string()));
+        for (auto _ : state) {
+            logger.info(message);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    std::filesystem::remove(path);
+}
+
+}
+
+BENCHMARK(BM_FileSink_EveryLine);
+BENCHMARK(BM_FileSink_DefaultPolicy);
+BENCHMARK(BM_FileSink_Never);
+BENCHMARK(BM_FileSink_IoUring);
+BENCHMARK(BM_FileSink_IoUringRegistered);
+BENCHMARK(BM_BinaryFileSink);
+BENCHMARK(BM_MmapFileSink);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,347 @@
+#include <benchmark/benchmark.h>
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include "Zyrnix/sinks/structured_json_sink.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+
+#if XLOG_BENCH_SPDLOG
+#include <spdlog/async.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/logger.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/null_sink.h>
+#endif
+
+#if XLOG_BENCH_GLOG
+#include <glog/logging.h>
+#include <mutex>
+#endif
+
+#if XLOG_BENCH_QUILL
+#include "quill/Backend.h"
+#include "quill/Frontend.h"
+#include "quill/LogMacros.h"
+#include "quill/Logger.h"
+#include "quill/sinks/FileSink.h"
+#include "quill/sinks/JsonFileSink.h"
+#include "quill/sinks/NullSink.h"
+#endif
+
+/*
+ * The same log call through Zyrnix and, where they were found at
+ * configure time, spdlog, glog and Quill (-DXLOG_BUILD_COMPARISON=ON).
+ *
+ * Every scenario logs "request {} status={} latency_ms={}" with an int,
+ * an int and a double, from 1 to 64 threads sharing one logger, and
+ * reports ns/call (wall time), messages/s (items_per_second) and heap
+ * allocations per call on all threads, background ones included.
+ * Benchmarks are named BM_<scenario>_<library>, so a scenario's rows sit
+ * together; --benchmark_filter=AsyncFile picks one.
+ *
+ * Scenarios a library has no equivalent for are left out: glog has no
+ * null or JSON sink and no async mode, and Quill is async only, so its
+ * rows are its async backend whatever the sink. spdlog has no structured
+ * fields; its JSON row is the usual pattern-layout idiom, which neither
+ * escapes nor types the values.
+ */
+
+// Every heap allocation in the process goes through here, as in
+// bench_allocations.cpp
+namespace {
+std::atomic<uint64_t> allocations{0};
+}
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Zyrnix::kv;
+
+std::filesystem::path bench_path(const char* library) {
+    return std::filesystem::temp_directory_path() / (std::string("Zyrnix_bench_compare_") + library + ".log");
+}
+
+void remove_with_prefix(const std::filesystem::path& base) {
+    for (const auto& entry : std::filesystem::directory_iterator(base.parent_path())) {
+        if (entry.path().filename().string().rfind(base.filename().string(), 0) == 0) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
+
+// Runs call(i) in the timed loop on every thread. Google Benchmark holds
+// all threads at a barrier on entering and leaving the loop, so thread 0's
+// reads of the allocation counter bracket every thread's calls.
+template <class Call>
+void measure(benchmark::State& state, Call&& call) {
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    int64_t i = 0;
+    for (auto _ : state) {
+        call(i++);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        const uint64_t count = allocations.load(std::memory_order_relaxed) - before;
+        state.counters["allocs_per_call"] =
+            static_cast<double>(count) / static_cast<double>(state.iterations() * state.threads());
+    }
+}
+
+// ---- Zyrnix ----------------------------------------------------------------
+
+std::shared_ptr<Zyrnix::Logger> zyrnix;
+
+std::shared_ptr<Zyrnix::Logger> zyrnix_logger(bool async) {
+    if (!async) {
+        return std::make_shared<Zyrnix::Logger>("bench");
+    }
+    Zyrnix::AsyncOptions options;
+    options.backend = Zyrnix::QueueBackend::LockFreeRing;
+    options.block_timeout_ms = 60000;  // Block on a full queue, as the others do
+    return Zyrnix::Logger::create_async("bench", options);
+}
+
+template <class Sink>
+void run_zyrnix(benchmark::State& state, bool async) {
+    const auto path = bench_path("zyrnix");
+    if (state.thread_index() == 0) {
+        remove_with_prefix(path);
+        zyrnix = zyrnix_logger(async);
+        if constexpr (std::is_same_v<Sink, Zyrnix::NullSink>) {
+            zyrnix->add_sink(std::make_shared<Sink>());
+        } else {
+            zyrnix->add_sink(std::make_shared<Sink>(path.string()));
+        }
+    }
+    if constexpr (std::is_same_v<Sink, Zyrnix::StructuredJsonSink>) {
+        measure(state, [](int64_t i) {
+            zyrnix->info("request completed", kv("request", i), kv("status", 200), kv("latency_ms", 17.25));
+        });
+    } else {
+        measure(state, [](int64_t i) { zyrnix->info("request {} status={} latency_ms={}", i, 200, 17.25); });
+    }
+    if (state.thread_index() == 0) {
+        zyrnix.reset();
+        remove_with_prefix(path);
+    }
+}
+
+void BM_Null_Zyrnix(benchmark::State& state) {
+    run_zyrnix<Zyrnix::NullSink>(state, false);
+}
+
+void BM_File_Zyrnix(benchmark::State& state) {
+    run_zyrnix<Zyrnix::FileSink>(state, false);
+}
+
+void BM_AsyncFile_Zyrnix(benchmark::State& state) {
+    run_zyrnix<Zyrnix::FileSink>(state, true);
+}
+
+void BM_Json_Zyrnix(benchmark::State& state) {
+    run_zyrnix<Zyrnix::StructuredJsonSink>(state, false);
+}
+
+// ---- spdlog ----------------------------------------------------------------
+
+#if XLOG_BENCH_SPDLOG
+std::shared_ptr<spdlog::logger> spd;
+
+std::shared_ptr<spdlog::details::thread_pool> spdlog_pool() {
+    static auto pool = std::make_shared<spdlog::details::thread_pool>(8192, 1);
+    return pool;
+}
+
+enum class SpdlogSink { Null, File, AsyncFile, Json };
+
+void run_spdlog(benchmark::State& state, SpdlogSink kind) {
+    const auto path = bench_path("spdlog");
+    if (state.thread_index() == 0) {
+        remove_with_prefix(path);
+        spdlog::sink_ptr sink;
+        if (kind == SpdlogSink::Null) {
+            sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+        } else {
+            sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path.string(), true);
+        }
+        if (kind == SpdlogSink::AsyncFile) {
+            spd = std::make_shared<spdlog::async_logger>("bench", sink, spdlog_pool(),
+                                                         spdlog::async_overflow_policy::block);
+        } else {
+            spd = std::make_shared<spdlog::logger>("bench", sink);
+        }
+        if (kind == SpdlogSink::Json) {
+            spd->set_pattern("{\"timestamp\":\"%Y-%m-%dT%H:%M:%S.%eZ\",\"level\":\"%l\",\"logger\":\"%n\",%v}",
+                             spdlog::pattern_time_type::utc);
+        }
+    }
+    if (kind == SpdlogSink::Json) {
+        measure(state, [](int64_t i) {
+            spd->info("\"message\":\"request completed\",\"request\":{},\"status\":{},\"latency_ms\":{}", i, 200, 17.25);
+        });
+    } else {
+        measure(state, [](int64_t i) { spd->info("request {} status={} latency_ms={}", i, 200, 17.25); });
+    }
+    if (state.thread_index() == 0) {
+        spd->flush();
+        spd.reset();
+        remove_with_prefix(path);
+    }
+}
+
+void BM_Null_Spdlog(benchmark::State& state) {
+    run_spdlog(state, SpdlogSink::Null);
+}
+
+void BM_File_Spdlog(benchmark::State& state) {
+    run_spdlog(state, SpdlogSink::File);
+}
+
+void BM_AsyncFile_Spdlog(benchmark::State& state) {
+    run_spdlog(state, SpdlogSink::AsyncFile);
+}
+
+void BM_Json_Spdlog(benchmark::State& state) {
+    run_spdlog(state, SpdlogSink::Json);
+}
+#endif
+
+// ---- glog ------------------------------------------------------------------
+
+#if XLOG_BENCH_GLOG
+// glog is configured once per process; every run appends to its INFO file
+void init_glog() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        FLAGS_logtostderr = false;
+        FLAGS_alsologtostderr = false;
+        FLAGS_stderrthreshold = google::GLOG_FATAL;
+        google::InitGoogleLogging("bench_compare");
+        google::SetLogDestination(google::GLOG_INFO, bench_path("glog").string().c_str());
+        std::atexit([] { remove_with_prefix(bench_path("glog")); });
+    });
+}
+
+void BM_File_Glog(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        init_glog();
+    }
+    measure(state, [](int64_t i) { LOG(INFO) << "request " << i << " status=" << 200 << " latency_ms=" << 17.25; });
+    if (state.thread_index() == 0) {
+        google::FlushLogFiles(google::GLOG_INFO);
+    }
+}
+#endif
+
+// ---- Quill -----------------------------------------------------------------
+
+#if XLOG_BENCH_QUILL
+quill::Logger* quill_logger = nullptr;
+
+enum class QuillSink { Null, File, Json };
+
+// Loggers are removed asynchronously, so each run gets a fresh name
+std::string quill_name() {
+    static int runs = 0;
+    return "bench" + std::to_string(runs++);
+}
+
+void run_quill(benchmark::State& state, QuillSink kind) {
+    const auto path = bench_path("quill");
+    if (state.thread_index() == 0) {
+        static std::once_flag once;
+        std::call_once(once, [] { quill::Backend::start(); });
+        remove_with_prefix(path);
+        const std::string name = quill_name();
+        std::shared_ptr<quill::Sink> sink;
+        if (kind == QuillSink::Null) {
+            sink = quill::Frontend::create_or_get_sink<quill::NullSink>(name + ".null");
+        } else if (kind == QuillSink::Json) {
+            sink = quill::Frontend::create_or_get_sink<quill::JsonFileSink>(
+                path.string() + "." + name, quill::FileSinkConfig{}, quill::FileEventNotifier{});
+        } else {
+            sink = quill::Frontend::create_or_get_sink<quill::FileSink>(
+                path.string() + "." + name, quill::FileSinkConfig{}, quill::FileEventNotifier{});
+        }
+        quill_logger = quill::Frontend::create_or_get_logger(name, std::move(sink));
+    }
+    if (kind == QuillSink::Json) {
+        measure(state, [](int64_t i) {
+            LOG_INFO(quill_logger, "request completed {request} {status} {latency_ms}", i, 200, 17.25);
+        });
+    } else {
+        measure(state, [](int64_t i) { LOG_INFO(quill_logger, "request {} status={} latency_ms={}", i, 200, 17.25); });
+    }
+    if (state.thread_index() == 0) {
+        quill_logger->flush_log();
+        quill::Frontend::remove_logger(quill_logger);
+        quill_logger = nullptr;
+        remove_with_prefix(path);
+    }
+}
+
+void BM_AsyncNull_Quill(benchmark::State& state) {
+    run_quill(state, QuillSink::Null);
+}
+
+void BM_AsyncFile_Quill(benchmark::State& state) {
+    run_quill(state, QuillSink::File);
+}
+
+void BM_AsyncJson_Quill(benchmark::State& state) {
+    run_quill(state, QuillSink::Json);
+}
+#endif
+
+}
+
+#define XLOG_COMPARE(bench) BENCHMARK(bench)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime()
+
+XLOG_COMPARE(BM_Null_Zyrnix);
+#if XLOG_BENCH_SPDLOG
+XLOG_COMPARE(BM_Null_Spdlog);
+#endif
+#if XLOG_BENCH_QUILL
+XLOG_COMPARE(BM_AsyncNull_Quill);
+#endif
+
+XLOG_COMPARE(BM_File_Zyrnix);
+#if XLOG_BENCH_SPDLOG
+XLOG_COMPARE(BM_File_Spdlog);
+#endif
+#if XLOG_BENCH_GLOG
+XLOG_COMPARE(BM_File_Glog);
+#endif
+
+XLOG_COMPARE(BM_AsyncFile_Zyrnix);
+#if XLOG_BENCH_SPDLOG
+XLOG_COMPARE(BM_AsyncFile_Spdlog);
+#endif
+#if XLOG_BENCH_QUILL
+XLOG_COMPARE(BM_AsyncFile_Quill);
+#endif
+
+XLOG_COMPARE(BM_Json_Zyrnix);
+#if XLOG_BENCH_SPDLOG
+XLOG_COMPARE(BM_Json_Spdlog);
+#endif
+#if XLOG_BENCH_QUILL
+XLOG_COMPARE(BM_AsyncJson_Quill);
+#endif
+
+BENCHMARK_MAIN();
@@ -4,16 +4,31 @@
 
 #include <string>
 #include "logger.hpp"
+#include "child_logger.hpp"
+#include "logger_registry.hpp"
 #include "config.hpp"
+#include "thread_placement.hpp"
+#include "buffer_memory.hpp"
+#include "memory_budget.hpp"
+#include "log_clock.hpp"
 
 #ifndef XLOG_NO_CONTEXT
 #include "log_context.hpp"
+#include "trace_context.hpp"
+#endif
+
+#ifndef XLOG_NO_ASYNC
+#include "async/async_logger.hpp"
 #endif
 
 namespace Zyrnix {
 
 LoggerPtr create_logger(const std::string& name, const Config& cfg = Config());
 
+#ifndef XLOG_NO_ASYNC
+AsyncLoggerPtr create_async_logger(LoggerPtr logger, const Config& cfg = Config());
+#endif
+
 }
 #define LOG_TRACE(logger, msg) logger->trace(msg)
 #define LOG_DEBUG(logger, msg) logger->debug(msg)
@@ -76,3 +76,9 @@
 #else
     #define XLOG_HAS_FILTERS 0
 #endif
+
+// fmt-style log calls (v1.2.0). Defined by the CMake build when fmt is
+// found (XLOG_ENABLE_FMT); define it yourself when building otherwise.
+#ifndef XLOG_HAS_FMT
+    #define XLOG_HAS_FMT 0
+#endif
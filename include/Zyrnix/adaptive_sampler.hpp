@@ -0,0 +1,107 @@
+#pragma once
+#include "Zyrnix_features.hpp"
+#include "log_filter.hpp"
+#include "log_level.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Zyrnix {
+
+class LogMetrics;
+class SinkMetrics;
+
+struct AdaptiveSamplingOptions {
+    // The logger's metrics (MetricsRegistry::get_logger_metrics()): queue
+    // depth against capacity and recent latency are read from it, and the
+    // sample rate is published to it
+    std::shared_ptr<LogMetrics> metrics;
+
+    // Sinks whose write error rate counts as pressure
+    std::vector<std::shared_ptr<SinkMetrics>> sinks;
+
+    // Records at or above this level are never sampled
+    LogLevel protected_level = LogLevel::Error;
+
+    // At sustained pressure, keep 1 in this many of the records below protected_level
+    size_t max_sample_rate = 64;
+
+    // Each input is scaled so that 1.0 is full pressure
+    uint64_t latency_budget_us = 100000;  // Recent log latency
+    double error_rate_budget = 0.05;      // Fraction of sink writes failing
+
+    // Above engage_at the rate doubles each interval, below release_at it
+    // halves, back down to 1:1
+    double engage_at = 0.5;
+    double release_at = 0.25;
+    std::chrono::milliseconds interval{100};
+};
+
+/**
+ * @brief Samples low-severity records harder as the pipeline falls behind (v1.2.0)
+ *
+ * Pressure is the highest of its inputs: async queue depth over its
+ * capacity, the recent log latency over latency_budget_us, and the share
+ * of sink writes that failed since the last look over error_rate_budget.
+ * Once per interval, whichever logging thread gets there first reads
+ * them and doubles or halves the sample rate, so it backs off
+ * geometrically and recovers the same way, with engage_at and release_at
+ * apart to keep it from flapping. Records at or above protected_level
+ * always pass; the rest are kept 1 in rate, counted on each thread.
+ *
+ * As a LogFilter it decides in stage one, on the level alone.
+ */
+class AdaptiveSampler : public LogFilter {
+public:
+    explicit AdaptiveSampler(const AdaptiveSamplingOptions& options = AdaptiveSamplingOptions{});
+    ~AdaptiveSampler() override;
+
+    AdaptiveSampler(const AdaptiveSampler&) = delete;
+    AdaptiveSampler& operator=(const AdaptiveSampler&) = delete;
+
+    FilterVerdict prefilter(const RecordView& view) const override;
+    bool should_log(const LogRecord& record) const override;
+
+    /**
+     * @brief Whether to keep a record at level
+     */
+    bool admit(LogLevel level) const;
+
+    /**
+     * @brief Records below protected_level are kept 1 in this many
+     */
+    size_t sample_rate() const { return rate_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Pressure seen at the last evaluation, 0.0 to 1.0
+     */
+    double pressure() const;
+
+    uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Read the inputs and adjust the rate now, rather than on the next
+     *        record after interval
+     */
+    void evaluate() const;
+
+private:
+    double measure() const;  // Caller holds eval_mtx_
+
+    AdaptiveSamplingOptions options_;
+    uint64_t interval_ns_;
+    mutable std::atomic<size_t> rate_{1};
+    mutable std::atomic<uint64_t> next_eval_ns_{0};
+    mutable std::atomic<uint64_t> pressure_permille_{0};
+    mutable std::atomic<uint64_t> dropped_{0};
+
+    // Evaluation state, only touched by the thread holding eval_mtx_
+    mutable std::mutex eval_mtx_;
+    mutable std::vector<uint64_t> last_writes_;
+    mutable std::vector<uint64_t> last_errors_;
+};
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Multi-pattern substring matcher (v1.2.0)
+ *
+ * Aho-Corasick automaton compiled into a dense DFA over the bytes that
+ * occur in the patterns, so a scan is one table lookup per input byte
+ * regardless of how many patterns there are. Built once, then read-only
+ * and safe to share between threads.
+ *
+ * With only a handful of patterns, a vectorised std::string_view::find per
+ * pattern beats the table walk, so small sets are searched that way.
+ */
+class AhoCorasick {
+public:
+    AhoCorasick() = default;
+    explicit AhoCorasick(const std::vector<std::string>& patterns);
+
+    bool empty() const { return pattern_count_ == 0; }
+    size_t pattern_count() const { return pattern_count_; }
+
+    /**
+     * @brief True if any pattern occurs in text
+     */
+    bool contains_any(std::string_view text) const;
+
+    /**
+     * @brief Overwrite every occurrence of every pattern with fill
+     *
+     * The text is scanned once. out is only written (as a copy of text
+     * with the matches masked) once the first match is found.
+     * @return true if anything matched
+     */
+    bool mask(std::string_view text, std::string& out, char fill = '*') const;
+
+private:
+    uint32_t next(uint32_t state, unsigned char c) const {
+        return transitions_[static_cast<size_t>(state) * class_count_ + byte_class_[c]];
+    }
+
+    bool mask_small(std::string_view text, std::string& out, char fill) const;
+
+    static constexpr size_t small_set_limit = 8;
+
+    size_t pattern_count_ = 0;
+    std::vector<std::string> small_set_;  // Patterns, kept when pattern_count_ <= small_set_limit
+    uint32_t class_count_ = 1;           // Class 0 = bytes in no pattern
+    std::array<uint16_t, 256> byte_class_{};
+    std::vector<uint32_t> transitions_;  // state * class_count_ + class -> state
+    std::vector<uint32_t> match_length_; // Longest pattern ending in each state, 0 = none
+};
+
+}
@@ -6,14 +6,23 @@ namespace Zyrnix {
 
 class AsyncLogger {
 public:
-    AsyncLogger(LoggerPtr logger) : logger(logger) {}
+    /**
+     * @brief Wrap a logger, switching it to queued dispatch if needed
+     */
+    AsyncLogger(LoggerPtr logger) : logger(logger) {
+        if (logger && !logger->is_async()) {
+            logger->enable_async();
+        }
+    }
 
-    void info(const std::string& msg) { logger->info(msg); }
-    void debug(const std::string& msg) { logger->debug(msg); }
-    void error(const std::string& msg) { logger->error(msg); }
-    void warn(const std::string& msg) { logger->warn(msg); }
-    void trace(const std::string& msg) { logger->trace(msg); }
-    void critical(const std::string& msg) { logger->critical(msg); }
+    void log(LogLevel level, std::string_view msg) { logger->log(level, msg); }
+
+    void info(std::string_view msg) { logger->info(msg); }
+    void debug(std::string_view msg) { logger->debug(msg); }
+    void error(std::string_view msg) { logger->error(msg); }
+    void warn(std::string_view msg) { logger->warn(msg); }
+    void trace(std::string_view msg) { logger->trace(msg); }
+    void critical(std::string_view msg) { logger->critical(msg); }
 
 private:
     LoggerPtr logger;
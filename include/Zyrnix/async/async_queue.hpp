@@ -1,13 +1,321 @@
 #pragma once
+#include "../buffer_memory.hpp"
 #include "../log_record.hpp"
-#include <queue>
+#include "../log_metrics.hpp"
+#include "../memory_budget.hpp"
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <atomic>
+#include <memory>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
 
 namespace Zyrnix {
 
+class CrashWriter;
+template <typename T> class MpmcRing;
+
+/**
+ * @brief Storage used by AsyncQueue (v1.2.0)
+ */
+enum class QueueBackend {
+    Mutex,         // RecordQueue guarded by a mutex
+    LockFreeRing,  // Bounded lock-free MPMC ring; push fails when full
+    PerThreadLanes // One SPSC ring per producer thread, merged by timestamp
+};
+
+/**
+ * @brief What push() does when the queue is at capacity (v1.2.0)
+ *
+ * Producer lanes cannot evict from the consumer side, so with
+ * PerThreadLanes DropOldest behaves like DropNewest and Sample blocks
+ * for the 1-in-N record it keeps.
+ */
+enum class OverflowPolicy {
+    Block,       // Wait up to block_timeout_ms for space, then drop
+    DropNewest,  // Reject the incoming record
+    DropOldest,  // Evict the oldest queued record to make room
+    Sample       // While saturated keep 1 in sample_rate records
+};
+
+/**
+ * @brief How an idle consumer waits for records (v1.2.0)
+ */
+enum class WaitStrategy {
+    Park,          // Block on the condition variable immediately
+    SpinThenPark,  // Busy-spin, then yield, then block
+    Spin           // Never block; burns a core for the lowest latency
+};
+
+/**
+ * @brief How full the queue is, as seen by producers (v1.2.0)
+ *
+ * Elevated once the queue fills to its high watermark, Saturated once a
+ * push finds it full; both last until it drains back to the low
+ * watermark, and Saturated steps down to Elevated below the high one.
+ * With PerThreadLanes the fill is that of the fullest lane.
+ */
+enum class Backpressure : uint8_t {
+    Normal,
+    Elevated,
+    Saturated
+};
+
+constexpr std::string_view backpressure_name(Backpressure pressure) {
+    switch (pressure) {
+        case Backpressure::Normal: return "normal";
+        case Backpressure::Elevated: return "elevated";
+        case Backpressure::Saturated: return "saturated";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Fair sharing of one queue between tenants (v1.2.0)
+ *
+ * With field set, each record is queued under its tenant, the value of
+ * that field (from the record or the LogContext it was logged in), and
+ * the consumer takes records from the tenants in deficit round-robin:
+ * each tenant with records sends up to quantum_bytes of them before the
+ * next one's turn, so no tenant waits behind another's backlog. Records
+ * at the priority lane's level skip this and go first, as before.
+ */
+struct TenantOptions {
+    std::string field;                 // e.g. "tenant"; empty turns fair queueing off
+    size_t quantum_bytes = 16 * 1024;  // Sent per tenant per round
+    size_t quota_bytes = 0;            // Queued bytes a tenant may hold, 0 = no quota
+    size_t max_tenants = 1024;         // Tenants past this, and records without the field, share ""
+};
+
+struct AsyncQueueOptions {
+    QueueBackend backend = QueueBackend::Mutex;
+    size_t capacity = 8192;             // Max queued records, 0 = unbounded (Mutex only)
+    size_t shutdown_timeout_ms = 5000;
+    size_t lane_capacity = 1024;        // Slots per producer lane (PerThreadLanes)
+    OverflowPolicy overflow_policy = OverflowPolicy::Block;
+    size_t block_timeout_ms = 100;
+    size_t sample_rate = 10;
+    WaitStrategy wait_strategy = WaitStrategy::Park;
+    size_t spin_iterations = 4000;      // Pause rounds before yielding
+    size_t yield_iterations = 64;       // Yield rounds before parking
+    bool priority_lane = false;         // Separate lane drained before everything else
+    LogLevel priority_level = LogLevel::Error;  // Records at or above go to the priority lane
+    size_t priority_capacity = 1024;
+    double high_watermark = 0.75;       // Fill that raises Backpressure::Elevated, 0 = no tracking
+    double low_watermark = 0.5;         // Fill at which pressure is back to Normal
+    std::string budget_account = "async";  // MemoryBudget account the queued records charge
+    TenantOptions tenants;             // Mutex backend only; its metrics are named as budget_account
+};
+
+/**
+ * @brief Where idle consumers found their next record
+ */
+struct WaitStats {
+    size_t spin_budget = 0;
+    uint64_t spin_wakeups = 0;   // Found work while spinning
+    uint64_t yield_wakeups = 0;  // Found work while yielding
+    uint64_t parks = 0;          // Had to block on the condition variable
+};
+
+/**
+ * @brief Records discarded by each overflow policy
+ */
+struct OverflowStats {
+    uint64_t dropped_newest = 0;
+    uint64_t evicted_oldest = 0;
+    uint64_t sampled_out = 0;
+    uint64_t block_timeouts = 0;
+    uint64_t over_budget = 0;  // Turned away by the MemoryBudget (v1.2.0)
+    uint64_t over_quota = 0;   // The record's tenant was at its quota (v1.2.0)
+
+    uint64_t total() const {
+        return dropped_newest + evicted_oldest + sampled_out + block_timeouts + over_budget + over_quota;
+    }
+};
+
+/**
+ * @brief Point-in-time view of one producer lane
+ */
+struct LaneStats {
+    uint64_t lane_id = 0;
+    size_t depth = 0;
+    uint64_t dropped = 0;
+    bool retired = false;   // Owning thread has exited
+};
+
+/**
+ * @brief FIFO of records for the Mutex backend (v1.2.0)
+ *
+ * A ring over a BufferArray, so its slots are backed as BufferMemory
+ * says. A bounded queue reserve()s its capacity up front; otherwise the
+ * ring doubles when full and never shrinks. Unlike std::deque, which
+ * allocates a node per LogRecord because a record is larger than its
+ * block, a push into a queue that has held that many records before
+ * does not allocate.
+ */
+class RecordQueue {
+public:
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    LogRecord& front() { return (*slots_)[head_]; }
+
+    void push(LogRecord&& record) {
+        if (size_ == slot_count()) {
+            grow(slot_count() == 0 ? 64 : slot_count() * 2);
+        }
+        (*slots_)[(head_ + size_) % slot_count()] = std::move(record);
+        ++size_;
+    }
+
+    // The slot keeps whatever front() left in it until it is reused
+    void pop() {
+        head_ = (head_ + 1) % slot_count();
+        --size_;
+    }
+
+    // Slots for at least count records, made now
+    void reserve(size_t count) {
+        if (count > slot_count()) {
+            grow(count);
+        }
+    }
+
+    // Oldest first, without locks; for crash-time readers only
+    template <typename F>
+    void for_each_queued(F&& visit) const {
+        const size_t count = size_;
+        const size_t slots = slot_count();
+        for (size_t i = 0; i < count && slots > 0; ++i) {
+            visit((*slots_)[(head_ + i) % slots]);
+        }
+    }
+
+private:
+    size_t slot_count() const { return slots_ ? slots_->size() : 0; }
+
+    void grow(size_t count) {
+        auto slots = std::make_unique<BufferArray<LogRecord>>(count);
+        for (size_t i = 0; i < size_; ++i) {
+            (*slots)[i] = std::move((*slots_)[(head_ + i) % slot_count()]);
+        }
+        slots_ = std::move(slots);
+        head_ = 0;
+    }
+
+    std::unique_ptr<BufferArray<LogRecord>> slots_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief RecordQueue per tenant, taken from in deficit round-robin (v1.2.0)
+ *
+ * Used by the Mutex backend under its lock. Without a tenant field it is
+ * a single RecordQueue. Tenants with records are kept in a list in turn
+ * order; front() gives the head tenant its quantum when its turn starts
+ * and moves on to the next tenant once the head's oldest record costs
+ * more than it has left. A record costs its message and logger name plus
+ * the size of a LogRecord.
+ */
+class TenantQueue {
+public:
+    struct Tenant {
+        std::string key;
+        RecordQueue records;
+        size_t bytes = 0;
+        size_t deficit = 0;
+        bool in_turn = false;  // Given its quantum for the current turn
+        bool active = false;   // Has records, so is in the turn list
+        Tenant* prev = nullptr;
+        Tenant* next = nullptr;
+        std::shared_ptr<TenantMetrics::Counters> counters;
+    };
+
+    TenantQueue() = default;
+
+    TenantQueue(const TenantQueue&) = delete;
+    TenantQueue& operator=(const TenantQueue&) = delete;
+
+    void configure(const TenantOptions& options, std::shared_ptr<TenantMetrics> metrics);
+    // Slots for a bounded queue's capacity, made now; tenants still grow theirs
+    void reserve(size_t capacity) { single_.reserve(capacity); }
+    bool fair() const { return !field_.empty(); }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    /**
+     * @brief The record's tenant, made on first sight; nullptr when not fair
+     */
+    Tenant* tenant_of(const LogRecord& record);
+
+    /**
+     * @brief Whether record fits in its tenant's quota; a tenant with
+     *        nothing queued takes any one record
+     */
+    bool within_quota(const Tenant* tenant, const LogRecord& record) const {
+        return !tenant || quota_ == 0 || tenant->bytes == 0 || tenant->bytes + cost(record) <= quota_;
+    }
+
+    /**
+     * @brief Count a record turned away for tenant's quota
+     */
+    void refuse(Tenant* tenant);
+
+    void push(Tenant* tenant, LogRecord&& record);
+    void push(LogRecord&& record) { push(tenant_of(record), std::move(record)); }
+
+    // The next record in turn; pop() removes the one front() returned
+    LogRecord& front();
+    void pop();
+
+    // The oldest record of the tenant holding the most bytes, for
+    // DropOldest to evict; pop_victim() removes it
+    LogRecord& victim();
+    void pop_victim();
+
+    // Tenant by tenant; for crash-time readers only
+    template <typename F>
+    void for_each_queued(F&& visit) const {
+        single_.for_each_queued(visit);
+        for (const Tenant* tenant = head_; tenant; tenant = tenant->next) {
+            tenant->records.for_each_queued(visit);
+        }
+    }
+
+    // What a queued record holds, as charged to its tenant's quota and to
+    // the queue's memory budget
+    static size_t cost(const LogRecord& record) {
+        return sizeof(LogRecord) + record.message.size() + record.logger_name.size();
+    }
+
+private:
+    void link_back(Tenant* tenant);
+    void unlink(Tenant* tenant);
+    void remove_front(Tenant* tenant, size_t bytes);
+
+    RecordQueue single_;
+    std::string field_;
+    size_t quantum_ = 0;
+    size_t quota_ = 0;
+    size_t max_tenants_ = 0;
+    std::shared_ptr<TenantMetrics> metrics_;
+    std::map<std::string, std::unique_ptr<Tenant>, std::less<>> tenants_;
+    Tenant* shared_ = nullptr;  // The "" tenant
+    Tenant* head_ = nullptr;    // Tenants with records, in turn order
+    Tenant* tail_ = nullptr;
+    Tenant* victim_ = nullptr;
+    size_t front_cost_ = 0;  // Of the record front() or victim() returned, which the caller may move from
+    size_t size_ = 0;
+};
+
 /**
  * @brief Thread-safe async queue with flush guarantees
  * 
@@ -20,6 +328,11 @@ public:
      * @param shutdown_timeout_ms Maximum time to wait for queue drain on shutdown (default 5000ms)
      */
     explicit AsyncQueue(size_t shutdown_timeout_ms = 5000);
+
+    /**
+     * @brief Construct async queue with an explicit storage backend (v1.2.0)
+     */
+    explicit AsyncQueue(const AsyncQueueOptions& options);
     
     /**
      * @brief Destructor - waits for queue to drain with timeout
@@ -30,8 +343,30 @@ public:
      * @brief Push a log record to the queue
      * @param record The log record to push
      * @return true if pushed successfully, false if queue is shutting down
+     *         or the record was discarded by the overflow policy
      */
     bool push(LogRecord&& record);
+
+    /**
+     * @brief Push without waiting for space (v1.2.0)
+     *
+     * As push(), except that a full queue under OverflowPolicy::Block
+     * rejects the record at once, counted as dropped_newest.
+     */
+    bool try_push(LogRecord&& record);
+
+    /**
+     * @brief Push a run of records, claiming queue space for them at once (v1.2.0)
+     *
+     * The records are queued in order, as push() (or try_push(), when
+     * may_block is false) would queue them, but space for as many as fit
+     * is taken in one step: one lock for the Mutex backend, one tail CAS
+     * for the ring, one tail store for a producer lane. Records that do
+     * not fit, and those bound for the priority lane, take push()'s path
+     * one at a time, overflow policy included. Every record is moved from.
+     * @return How many of the records were queued
+     */
+    size_t push_bulk(std::span<LogRecord> records, bool may_block = true);
     
     /**
      * @brief Pop a log record from the queue (blocking)
@@ -39,6 +374,16 @@ public:
      * @return true if a record was popped, false if queue is shutting down
      */
     bool pop(LogRecord& record);
+
+    /**
+     * @brief Pop up to max_records records in one go (v1.2.0)
+     *
+     * Appends to out. Waits up to timeout for the first record; an empty
+     * result with a true return means the wait timed out.
+     * @return false once the queue is shutting down and drained
+     */
+    bool pop_bulk(std::vector<LogRecord>& out, size_t max_records,
+                  std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
     
     /**
      * @brief Check if queue is empty
@@ -73,11 +418,160 @@ public:
      */
     size_t dropped_on_shutdown() const;
 
+    QueueBackend backend() const { return backend_; }
+
+    /**
+     * @brief Id of the calling thread's lane, 0 if it has none (v1.2.0)
+     */
+    uint64_t current_lane_id() const;
+
+    /**
+     * @brief Per-lane depth and drop counters (PerThreadLanes only)
+     */
+    std::vector<LaneStats> lane_stats() const;
+
+    /**
+     * @brief Per-policy overflow counters (v1.2.0)
+     */
+    OverflowStats overflow_stats() const;
+
+    /**
+     * @brief Consumer spin/park counters (v1.2.0)
+     */
+    WaitStats wait_stats() const;
+
+    /**
+     * @brief Called for every record discarded by the overflow policy
+     *
+     * lane_id is 0 unless the record was dropped from a producer lane.
+     * Must be set before producers start pushing.
+     */
+    using DropCallback = std::function<void(uint64_t count, uint64_t lane_id)>;
+    void set_drop_callback(DropCallback callback) { drop_callback_ = std::move(callback); }
+
+    /**
+     * @brief Current backpressure state; one relaxed load (v1.2.0)
+     */
+    Backpressure pressure() const { return pressure_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Called on every backpressure transition (v1.2.0)
+     *
+     * Runs on the producer or consumer thread whose push or pop crossed a
+     * watermark, once per transition. Must be set before producers start
+     * pushing.
+     */
+    using PressureCallback = std::function<void(Backpressure previous, Backpressure current)>;
+    void set_pressure_callback(PressureCallback callback) { pressure_callback_ = std::move(callback); }
+
+    struct Lane;
+
+    /**
+     * @brief Write every queued record as a text line (v1.2.0)
+     *
+     * crash::DrainFn for this queue, registered while the queue exists;
+     * reads the storage without locks (see crash_drain.hpp).
+     */
+    static void drain_for_crash(const void* queue, CrashWriter& out);
+
 private:
-    std::queue<LogRecord> queue_;
+    Lane* local_lane();
+    bool pop_bulk_records(std::vector<LogRecord>& out, size_t max_records, std::chrono::milliseconds timeout);
+    size_t pop_from_lanes(LogRecord* out, size_t max_records);
+    size_t try_pop_lock_free(LogRecord* out, size_t max_records);
+    size_t pop_priority(LogRecord* out, size_t max_records);
+    bool has_priority() const;
+    void after_lock_free_pop(size_t popped);
+    bool lanes_empty() const;
+    void reclaim_retired_lanes();
+
+    bool push_record(LogRecord&& record, bool may_block);
+    bool push_mutex(LogRecord&& record, bool may_block);
+    bool push_ring(LogRecord&& record, bool may_block);
+    bool push_lane(LogRecord&& record, bool may_block);
+    size_t push_run(std::span<LogRecord> records, bool& over_budget);  // What fits now, in one claim
+    size_t push_mutex_run(std::span<LogRecord> records);
+    bool wait_for_space(const std::function<bool()>& has_space,
+                        std::chrono::steady_clock::time_point deadline);
+    void notify_producers();
+    bool sample_keep();
+    void count_overflow(std::atomic<uint64_t>& counter, uint64_t lane_id = 0);
+    // Watermark checks: after a push while Normal, on finding the queue
+    // full, and after a pop while under pressure
+    bool watching_rise() const {
+        return high_permille_ > 0 && pressure_.load(std::memory_order_relaxed) == Backpressure::Normal;
+    }
+    void check_rising(size_t depth, size_t capacity) {
+        if (depth * 1000 >= capacity * high_permille_) {
+            transition(Backpressure::Normal, Backpressure::Elevated);
+        }
+    }
+    void saturate();
+    void check_falling(size_t depth, size_t capacity);
+    void transition(Backpressure from, Backpressure to);
+
+    bool pop_record(LogRecord& record);
+    bool try_pop_locked(LogRecord& record);
+    bool storage_empty() const;
+    size_t drain_and_count();
+    void notify_consumer();
+    bool spin_once(size_t& round, std::chrono::steady_clock::time_point deadline);
+    void count_wakeup(size_t round);
+
+    QueueBackend backend_ = QueueBackend::Mutex;
+    std::unique_ptr<MpmcRing<LogRecord>> ring_;
+    std::unique_ptr<MpmcRing<LogRecord>> priority_ring_;
+    LogLevel priority_level_ = LogLevel::Error;
+    std::atomic<size_t> waiting_consumers_{0};
+
+    uint64_t queue_id_ = 0;
+    size_t lane_capacity_ = 1024;
+    uint64_t next_lane_id_ = 1;
+    std::vector<std::shared_ptr<Lane>> lanes_;
+    mutable std::mutex lanes_mtx_;
+    std::atomic<uint64_t> lanes_version_{0};
+    std::vector<std::shared_ptr<Lane>> consumer_lanes_;  // Consumer's cached copy of lanes_
+    uint64_t consumer_lanes_version_ = 0;
+    // Lanes a crash handler can find without lanes_mtx_; lanes past the
+    // first 64 are not
+    static constexpr size_t crash_lane_slots = 64;
+    std::atomic<Lane*> crash_lanes_[crash_lane_slots] = {};
+    std::atomic<const std::vector<LogRecord>*> crash_batches_[8] = {};  // Consumers' pop_bulk() buffers
+    int crash_slot_ = -1;
+    std::mutex consumer_mtx_;
+
+    TenantQueue queue_;
     mutable std::mutex mtx_;
     std::condition_variable cv_;
     std::condition_variable drain_cv_;
+    std::condition_variable space_cv_;
+    std::atomic<size_t> blocked_producers_{0};
+
+    size_t capacity_ = 0;
+    OverflowPolicy overflow_policy_ = OverflowPolicy::Block;
+    size_t block_timeout_ms_ = 100;
+    size_t sample_rate_ = 10;
+    std::atomic<uint64_t> sample_counter_{0};
+    std::atomic<uint64_t> dropped_newest_{0};
+    std::atomic<uint64_t> evicted_oldest_{0};
+    std::atomic<uint64_t> sampled_out_{0};
+    std::atomic<uint64_t> block_timeouts_{0};
+    std::atomic<uint64_t> over_budget_{0};
+    std::atomic<uint64_t> over_quota_{0};
+    BudgetAccount budget_;
+    DropCallback drop_callback_;
+    size_t high_permille_ = 750;
+    size_t low_permille_ = 500;
+    std::atomic<Backpressure> pressure_{Backpressure::Normal};
+    PressureCallback pressure_callback_;
+
+    std::atomic<size_t> approx_size_{0};  // Mutex backend: size readable without the lock
+    WaitStrategy wait_strategy_ = WaitStrategy::Park;
+    size_t spin_iterations_ = 4000;
+    size_t yield_iterations_ = 64;
+    std::atomic<uint64_t> spin_wakeups_{0};
+    std::atomic<uint64_t> yield_wakeups_{0};
+    std::atomic<uint64_t> parks_{0};
     std::atomic<bool> shutdown_{false};
     std::atomic<size_t> dropped_count_{0};
     size_t shutdown_timeout_ms_;
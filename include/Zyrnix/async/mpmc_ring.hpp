@@ -0,0 +1,172 @@
+#pragma once
+#include "../buffer_memory.hpp"
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace Zyrnix {
+
+inline constexpr size_t XLOG_CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Bounded lock-free multi-producer/multi-consumer ring (v1.2.0)
+ *
+ * Vyukov-style ring: every slot carries a sequence number which tells
+ * producers and consumers whether the slot is free for the current lap.
+ * Capacity is rounded up to a power of two. Head and tail live on their
+ * own cache lines so producers and consumers do not false-share.
+ */
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity)
+        : capacity_(round_up_pow2(capacity < 2 ? 2 : capacity))
+        , mask_(capacity_ - 1)
+        , slots_(capacity_)
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    /**
+     * @brief Try to enqueue a value
+     * @return false if the ring is full
+     */
+    bool try_push(T&& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Enqueue up to count values with one claim on the tail (v1.2.0)
+     *
+     * Takes the run of free slots at the tail, at most count long, in a
+     * single CAS, then moves the values in and publishes the slots in
+     * order.
+     * @return How many values were enqueued, from the front of values
+     */
+    size_t try_push_bulk(T* values, size_t count) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t run = 0;
+            while (run < count && slots_[(pos + run) & mask_].sequence.load(std::memory_order_acquire) == pos + run) {
+                ++run;
+            }
+            if (run == 0) {
+                size_t seq = slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+                if (count == 0 || static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos) < 0) {
+                    return 0;
+                }
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            // A slot seen free cannot be taken without moving the tail, which fails the CAS
+            if (tail_.compare_exchange_weak(pos, pos + run, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < run; ++i) {
+                    Slot& slot = slots_[(pos + i) & mask_];
+                    slot.value = std::move(values[i]);
+                    slot.sequence.store(pos + i + 1, std::memory_order_release);
+                }
+                return run;
+            }
+        }
+    }
+
+    /**
+     * @brief Try to dequeue a value
+     * @return false if the ring is empty
+     */
+    bool try_pop(T& out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(slot.value);
+                    slot.sequence.store(pos + capacity_, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Approximate number of queued values
+     */
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Visit the published values without consuming them (v1.2.0)
+     *
+     * For crash-time readers: plain loads, no locks, nothing written. A
+     * value a producer or consumer is moving at the same time is skipped
+     * or may be seen torn.
+     */
+    template <typename F>
+    void for_each_queued(F&& visit) const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t pos = head_.load(std::memory_order_acquire); pos != tail; ++pos) {
+            const Slot& slot = slots_[pos & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) == pos + 1) {
+                visit(slot.value);
+            }
+        }
+    }
+
+private:
+    struct alignas(XLOG_CACHE_LINE_SIZE) Slot {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static size_t round_up_pow2(size_t v) {
+        size_t p = 1;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    BufferArray<Slot> slots_;
+
+    alignas(XLOG_CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    alignas(XLOG_CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "../log_record.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Zyrnix {
+
+template <typename T> class MpmcRing;
+
+/**
+ * @brief Free list of LogRecords whose string storage is reused (v1.2.0)
+ *
+ * Consumers hand drained records back with release(); producers take one
+ * with acquire() and assign into the existing string and map capacity,
+ * so steady-state async logging does not allocate. When the free list
+ * is empty acquire() counts a miss and the caller starts from a fresh
+ * record.
+ */
+class RecordPool {
+public:
+    explicit RecordPool(size_t capacity);
+    ~RecordPool();
+
+    RecordPool(const RecordPool&) = delete;
+    RecordPool& operator=(const RecordPool&) = delete;
+
+    /**
+     * @brief Move a recycled record into out
+     * @return false on a pool miss (out is left untouched)
+     */
+    bool acquire(LogRecord& out);
+
+    /**
+     * @brief Clear a record, keeping its capacity, and return it to the pool
+     */
+    void release(LogRecord&& record);
+
+    /**
+     * @brief Return every record in the batch to the pool
+     */
+    void release(std::vector<LogRecord>& batch);
+
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    size_t capacity() const;
+
+private:
+    std::unique_ptr<MpmcRing<LogRecord>> free_;
+    std::atomic<uint64_t> misses_{0};
+};
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "mpmc_ring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Zyrnix {
+
+/**
+ * @brief Bounded single-producer/single-consumer ring (v1.2.0)
+ *
+ * The producer only writes tail_ and the consumer only writes head_, so
+ * a push never touches a cache line another producer writes. Each side
+ * keeps a private copy of the other's index and only reloads it when
+ * the ring looks full (or empty).
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(round_up_pow2(capacity < 2 ? 2 : capacity))
+        , mask_(capacity_ - 1)
+        , slots_(capacity_)
+    {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Producer side: enqueue a value
+     * @return false if the ring is full
+     */
+    bool try_push(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ >= capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ >= capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Producer side: enqueue up to count values with one tail store (v1.2.0)
+     * @return How many values were enqueued, from the front of values
+     */
+    size_t try_push_bulk(T* values, size_t count) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (capacity_ - (tail - head_cache_) < count) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+        }
+        const size_t run = std::min(count, capacity_ - (tail - head_cache_));
+        for (size_t i = 0; i < run; ++i) {
+            slots_[(tail + i) & mask_] = std::move(values[i]);
+        }
+        if (run > 0) {
+            tail_.store(tail + run, std::memory_order_release);
+        }
+        return run;
+    }
+
+    /**
+     * @brief Consumer side: peek at the oldest value
+     * @return nullptr if the ring is empty
+     */
+    T* front() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    /**
+     * @brief Consumer side: release the slot returned by front()
+     */
+    void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t size() const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Visit the queued values without consuming them (v1.2.0)
+     *
+     * For crash-time readers, as MpmcRing::for_each_queued().
+     */
+    template <typename F>
+    void for_each_queued(F&& visit) const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t pos = head_.load(std::memory_order_acquire); pos < tail; ++pos) {
+            visit(static_cast<const T&>(slots_[pos & mask_]));
+        }
+    }
+
+private:
+    static size_t round_up_pow2(size_t v) {
+        size_t p = 1;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    BufferArray<T> slots_;
+
+    alignas(XLOG_CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;  // Producer's view of head_
+
+    alignas(XLOG_CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;  // Consumer's view of tail_
+};
+
+}
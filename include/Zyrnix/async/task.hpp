@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Zyrnix {
+
+/**
+ * @brief Move-only void() callable stored in place when it is small (v1.2.0)
+ *
+ * Closures of up to inline_size bytes (six pointers, or a few references
+ * and a std::function) live in the Task itself, so handing one to
+ * ThreadPool does not allocate. Larger ones are moved to the heap. Unlike
+ * std::function, move-only callables such as std::packaged_task fit.
+ */
+class Task {
+public:
+    static constexpr size_t inline_size = 48;
+
+    Task() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {  // NOLINT: implicit, like std::function
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        } else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept { take(other); }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void operator()() { ops_->invoke(storage_); }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* to, void* from) noexcept;  // Leaves from destroyed
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static constexpr Ops inline_ops{
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* to, void* from) noexcept {
+            ::new (to) Fn(std::move(*static_cast<Fn*>(from)));
+            static_cast<Fn*>(from)->~Fn();
+        },
+        [](void* p) noexcept { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops heap_ops{
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* to, void* from) noexcept { ::new (to) Fn*(*static_cast<Fn**>(from)); },
+        [](void* p) noexcept { delete *static_cast<Fn**>(p); },
+    };
+
+    void take(Task& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[inline_size];
+    const Ops* ops_ = nullptr;
+};
+
+}
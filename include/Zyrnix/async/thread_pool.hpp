@@ -1,27 +1,101 @@
 #pragma once
-#include <vector>
-#include <thread>
-#include <functional>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include "task.hpp"
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace Zyrnix {
 
+template <typename T> class MpmcRing;
+
+/**
+ * @brief Work-stealing pool of worker threads (v1.2.0)
+ *
+ * Every worker owns a Chase-Lev deque: tasks a worker enqueues go on its
+ * own deque and are run newest first by it, or stolen oldest first by an
+ * idle worker. Tasks from other threads go through a shared lock-free
+ * ring. Tasks are stored in recycled Task objects, so enqueueing a
+ * closure of up to Task::inline_size bytes neither allocates nor takes a
+ * lock once the pool is warm. Idle workers sleep on an atomic and are
+ * only woken when there is work.
+ *
+ * The destructor runs every task already enqueued, including tasks those
+ * tasks enqueue, then joins the workers.
+ */
 class ThreadPool {
 public:
     explicit ThreadPool(size_t threads);
     ~ThreadPool();
-    void enqueue(std::function<void()> task);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Run f on a worker
+     *
+     * An exception thrown by f is reported on std::cerr and dropped; use
+     * submit() to get it back.
+     */
+    template <typename F>
+    void enqueue(F&& f) {
+        push(Task(std::forward<F>(f)));
+    }
+
+    /**
+     * @brief Run f on a worker and get its result, or its exception (v1.2.0)
+     */
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>&>> {
+        std::packaged_task<std::invoke_result_t<std::decay_t<F>&>()> task(std::forward<F>(f));
+        auto result = task.get_future();
+        push(Task(std::move(task)));
+        return result;
+    }
+
+    /**
+     * @brief Block until every enqueued task has finished (v1.2.0)
+     *
+     * Includes tasks enqueued meanwhile. Must not be called from a task
+     * running on this pool, which would wait for itself.
+     */
+    void wait_idle();
+
+    /**
+     * @brief Whether the calling thread is one of this pool's workers (v1.2.0)
+     */
+    bool in_worker() const;
+
+    size_t size() const { return workers_.size(); }
 
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex mtx;
-    std::condition_variable cv;
-    std::atomic<bool> running;
-    void worker();
+    struct Worker;
+
+    void push(Task&& task);
+    Task* find_task(size_t self);
+    void run(Task* task);
+    void worker(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::unique_ptr<MpmcRing<Task*>> injected_;  // From threads outside the pool
+    std::unique_ptr<MpmcRing<Task*>> free_;      // Recycled tasks
+
+    // Where injected tasks go while the ring is full
+    std::mutex overflow_mtx_;
+    std::deque<Task*> overflow_;
+    std::atomic<size_t> overflow_size_{0};
+
+    std::atomic<size_t> pending_{0};  // Enqueued and not yet finished
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<uint32_t> wake_seq_{0};
+    std::atomic<bool> running_{true};
 };
 
 }
@@ -0,0 +1,142 @@
+#pragma once
+#include "mpmc_ring.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Chase-Lev work-stealing deque (v1.2.0)
+ *
+ * The owning thread pushes and pops at the bottom without contention;
+ * any other thread steals from the top with one CAS, which only competes
+ * with the owner for the last element. Grows when full; outgrown arrays
+ * are kept until the deque is destroyed, since a thief may still be
+ * reading one. Memory orderings follow Lê et al., "Correct and Efficient
+ * Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ *
+ * T must be trivially copyable (typically a pointer).
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256)
+        : array_(new Array(round_up_pow2(capacity < 2 ? 2 : capacity)))
+    {
+        arrays_.emplace_back(array_.load(std::memory_order_relaxed));
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief Owner side: add a value at the bottom
+     */
+    void push(T value) {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(array->mask)) {
+            array = grow(array, top, bottom);
+        }
+        array->put(bottom, value);
+        // A release store in place of the paper's release fence: as strong
+        // here, and visible to ThreadSanitizer
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Owner side: take the newest value
+     * @return false if the deque is empty (or a thief took the last one)
+     */
+    bool pop(T& out) {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = array->get(bottom);
+        if (top == bottom) {
+            // Last element: race the thieves for it
+            const bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Any thread: take the oldest value
+     * @return false if the deque is empty or another thread won the race
+     */
+    bool steal(T& out) {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        const T value = array_.load(std::memory_order_acquire)->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    /**
+     * @brief Approximate number of values, for any thread
+     */
+    size_t size() const {
+        const int64_t bottom = bottom_.load(std::memory_order_acquire);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Array {
+        explicit Array(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+        T get(int64_t i) const { return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T value) { slots[static_cast<size_t>(i) & mask].store(value, std::memory_order_relaxed); }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array* grow(Array* old, int64_t top, int64_t bottom) {
+        auto* next = new Array((old->mask + 1) * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            next->put(i, old->get(i));
+        }
+        arrays_.emplace_back(next);
+        array_.store(next, std::memory_order_release);
+        return next;
+    }
+
+    static size_t round_up_pow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    alignas(XLOG_CACHE_LINE_SIZE) std::atomic<int64_t> top_{0};
+    alignas(XLOG_CACHE_LINE_SIZE) std::atomic<int64_t> bottom_{0};
+    std::atomic<Array*> array_;
+    std::vector<std::unique_ptr<Array>> arrays_;  // Owner only: current and outgrown arrays
+};
+
+}
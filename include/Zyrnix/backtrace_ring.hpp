@@ -0,0 +1,58 @@
+#pragma once
+#include "log_level.hpp"
+#include "log_record.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+struct LogSite;
+struct DeferredSite;
+
+/**
+ * @brief The last records a logger held back, kept for a later dump (v1.2.0)
+ *
+ * A fixed ring of slots, rounded up to a power of two. A writer claims
+ * the next slot with one fetch_add and fills it under that slot's own
+ * flag, which only take() ever contends for, so writers do not wait on
+ * each other. Slot strings keep their capacity, so once the ring has gone
+ * round a push copies the text without allocating. Deferred records keep
+ * their argument bytes and are only formatted if they are dumped.
+ */
+class BacktraceRing {
+public:
+    explicit BacktraceRing(size_t capacity);
+    ~BacktraceRing();
+
+    BacktraceRing(const BacktraceRing&) = delete;
+    BacktraceRing& operator=(const BacktraceRing&) = delete;
+
+    void push(LogLevel level, std::string_view message, const LogSite* site, const DeferredSite* deferred,
+              std::chrono::system_clock::time_point when, uint64_t thread_id) const;
+
+    /**
+     * @brief Everything pushed since the last take(), oldest first, up to capacity
+     *
+     * The records come back with logger_name and backtrace set.
+     */
+    std::vector<LogRecord> take(const std::string& logger_name) const;
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot;
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    mutable std::atomic<uint64_t> head_{0};
+    mutable std::mutex take_mtx_;
+    mutable uint64_t tail_ = 0;  // Guarded by take_mtx_
+};
+
+}
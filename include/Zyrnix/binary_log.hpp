@@ -0,0 +1,205 @@
+#pragma once
+#include "field.hpp"
+#include "log_level.hpp"
+#include "log_site.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief The binary log format written by BinaryFileSink (v1.2.0)
+ *
+ * A file starts with the 8 bytes "ZYRNIXB1" and holds a sequence of
+ * blocks. A block is a 16-byte header (magic "ZBK1", payload size,
+ * record count and the CRC-32C of the payload, each a little-endian u32)
+ * followed by the payload: entries, each a varint length and a body
+ * whose first byte says what it is. A string entry defines the next
+ * string id of the block; a record entry holds the level, the timestamp
+ * as a zigzag varint nanosecond delta from the block's previous record,
+ * the thread id, the logger name's string id, the call site (0, or the
+ * file's string id + 1 followed by the function's id and the line), the
+ * message bytes and the fields. A field is a key string id, a type byte
+ * (the FieldType, plus packed_field when the value is a varint) and the
+ * value: bytes, or when packed a zigzag varint integer (0 or 1 for
+ * booleans). Strings that are canonical integers are packed too.
+ *
+ * Every block starts with an empty string table, so blocks decode
+ * independently of each other (and in parallel), and a damaged block
+ * loses only its own records.
+ */
+namespace binlog {
+
+inline constexpr char file_magic[8] = {'Z', 'Y', 'R', 'N', 'I', 'X', 'B', '1'};
+inline constexpr uint32_t block_magic = 0x314B425A;  // "ZBK1"
+inline constexpr size_t block_header_size = 16;
+
+enum class Entry : uint8_t { String = 1, Record = 2 };
+inline constexpr uint8_t packed_field = 0x80;
+
+/**
+ * @brief CRC-32C of data, continuing from crc; uses SSE4.2 where the CPU has it
+ */
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Where a block is within a file
+ */
+struct BlockRef {
+    size_t offset;  // Of the payload
+    uint32_t size;
+    uint32_t records;
+    uint32_t crc;
+};
+
+/**
+ * @brief Builds one block at a time
+ */
+class BlockWriter {
+public:
+    void add(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+             std::string_view logger_name, const LogSite* site, std::string_view message);
+
+    /**
+     * @brief As above, with fields from any range of key/FieldValue pairs
+     */
+    template <class Fields>
+    void add(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+             std::string_view logger_name, const LogSite* site, std::string_view message,
+             const Fields& fields) {
+        begin_record(timestamp, level, thread_id, logger_name, site, message, fields.size());
+        for (const auto& [key, value] : fields) {
+            add_field(key, value);
+        }
+        end_record();
+    }
+
+    /**
+     * @brief Bytes of payload so far
+     */
+    size_t size() const { return payload_.size(); }
+    bool empty() const { return records_ == 0; }
+
+    /**
+     * @brief Append the finished block (header and payload) to out and start the next
+     * @return Where the block is within out; all zero if nothing was added
+     */
+    BlockRef finish(std::string& out);
+
+    /**
+     * @brief Append the block so far to out as finish() would, and go on building it
+     */
+    BlockRef copy_to(std::string& out) const;
+
+private:
+    void begin_record(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+                      std::string_view logger_name, const LogSite* site, std::string_view message,
+                      size_t field_count);
+    size_t encode_head(char* head, std::chrono::system_clock::time_point timestamp, LogLevel level,
+                       uint64_t thread_id, std::string_view logger_name, const LogSite* site,
+                       size_t message_size);
+    void add_field(std::string_view key, const FieldValue& value);
+    void end_record();
+    uint32_t intern(std::string_view text);
+
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    std::string payload_;
+    std::string entry_;  // The record being built
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> strings_;
+    std::unordered_map<const char*, uint32_t> site_strings_;  // By pointer: sites are static
+    std::string last_logger_;  // Most records repeat the previous logger
+    static constexpr uint32_t no_string = UINT32_MAX;
+    uint32_t last_logger_id_ = no_string;
+    int64_t previous_ns_ = 0;
+    uint32_t records_ = 0;
+};
+
+/**
+ * @brief A record read back; the views point into the block being decoded
+ */
+struct DecodedRecord {
+    std::chrono::system_clock::time_point timestamp;
+    LogLevel level;
+    uint64_t thread_id;
+    std::string_view logger_name;
+    std::string_view file;  // Empty without a call site
+    std::string_view function;
+    uint32_t line = 0;
+    std::string_view message;
+    std::vector<std::pair<std::string_view, FieldValue>> fields;
+};
+
+
+/**
+ * @brief Find the blocks of a file image, skipping garbage between them
+ *
+ * Blocks cut short by the end of the data (a crash mid-write), or whose
+ * size or CRC is damaged, are left out and counted in damaged; the scan
+ * goes on past them, so one bad header hides no later block.
+ */
+std::vector<BlockRef> scan_blocks(std::string_view file, size_t* damaged = nullptr);
+
+/**
+ * @brief Decode one block, calling emit for each record in order
+ *
+ * Returns false if the CRC does not match or the payload is malformed;
+ * records before the malformed part have been emitted.
+ */
+template <class Emit>
+bool decode_block(std::string_view file, const BlockRef& block, Emit&& emit);
+
+namespace detail {
+
+bool read_varint(const char*& p, const char* end, uint64_t& value);
+bool decode_record(const char*& p, const char* end, const std::vector<std::string_view>& strings,
+                   int64_t& previous_ns, DecodedRecord& record);
+
+}
+
+template <class Emit>
+bool decode_block(std::string_view file, const BlockRef& block, Emit&& emit) {
+    if (block.offset + block.size > file.size()) {
+        return false;
+    }
+    const char* p = file.data() + block.offset;
+    const char* end = p + block.size;
+    if (crc32c(p, block.size) != block.crc) {
+        return false;
+    }
+    std::vector<std::string_view> strings;
+    DecodedRecord record;
+    int64_t previous_ns = 0;
+    while (p < end) {
+        uint64_t length;
+        if (!detail::read_varint(p, end, length) || length == 0 || length > static_cast<uint64_t>(end - p)) {
+            return false;
+        }
+        const char* entry_end = p + length;
+        const auto kind = static_cast<Entry>(static_cast<uint8_t>(*p++));
+        if (kind == Entry::String) {
+            strings.emplace_back(p, static_cast<size_t>(entry_end - p));
+        } else if (kind == Entry::Record) {
+            if (!detail::decode_record(p, entry_end, strings, previous_ns, record)) {
+                return false;
+            }
+            emit(static_cast<const DecodedRecord&>(record));
+        }
+        p = entry_end;  // Unknown kinds are skipped
+    }
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace Zyrnix {
+
+/**
+ * @brief How the library backs its large buffers (v1.2.0)
+ *
+ * Covers the async queue of every backend and the SPSC rings, record
+ * pools, SignalSafeSink's buffer, MmapFileSink's segments and
+ * FlightRecorderSink's ring. With everything off (the default) rings
+ * come from the heap as before.
+ */
+struct BufferMemory {
+    // Map buffers with MAP_HUGETLB from the reserved pool (vm.nr_hugepages);
+    // when it is empty, map them 2 MiB aligned and madvise(MADV_HUGEPAGE)
+    // for transparent huge pages instead
+    bool huge_pages = false;
+
+    // Fault every page in when the buffer is made, not on its first write
+    bool prefault = false;
+
+    // mlock() the buffers so they are never paged out; needs
+    // RLIMIT_MEMLOCK (ulimit -l) to cover them
+    bool lock = false;
+
+    // Smaller buffers stay on the heap whatever the options say
+    size_t min_bytes = 256 * 1024;
+};
+
+/**
+ * @brief Set the backing of buffers made from now on (v1.2.0)
+ *
+ * Call it before creating loggers and sinks; buffers already made keep
+ * their memory. Huge pages and prefaulting are Linux only, mlock() POSIX.
+ */
+void set_buffer_memory(BufferMemory memory);
+BufferMemory get_buffer_memory();
+
+struct BufferMemoryStats {
+    uint64_t mapped_bytes;     // Buffers mapped rather than on the heap
+    uint64_t huge_page_bytes;  // Of those, on MAP_HUGETLB or advised THP pages
+    uint64_t locked_bytes;
+    uint64_t hugetlb_fallbacks;  // MAP_HUGETLB refused, THP used instead
+    uint64_t lock_failures;
+};
+
+BufferMemoryStats get_buffer_memory_stats();
+
+/**
+ * @brief Uninitialized memory backed as BufferMemory says (v1.2.0)
+ *
+ * Mapped when any option is on and the buffer is at least min_bytes, or
+ * always with prefault set for a buffer that must never fault, e.g. one
+ * written from a signal handler; otherwise aligned heap memory. May be
+ * empty if mapping fails.
+ */
+class BufferRegion {
+public:
+    BufferRegion() = default;
+    BufferRegion(size_t bytes, size_t alignment, bool prefault = false);
+    ~BufferRegion();
+
+    BufferRegion(BufferRegion&& other) noexcept { swap(other); }
+    BufferRegion& operator=(BufferRegion&& other) noexcept {
+        BufferRegion(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void* data() const { return data_; }
+    size_t size() const { return bytes_; }
+    bool mapped() const { return mapped_ != 0; }
+    bool huge() const { return huge_; }
+    bool locked() const { return locked_; }
+
+private:
+    void swap(BufferRegion& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(alignment_, other.alignment_);
+        std::swap(huge_, other.huge_);
+        std::swap(locked_, other.locked_);
+    }
+
+    void* data_ = nullptr;
+    size_t bytes_ = 0;
+    size_t mapped_ = 0;  // Length of the mapping, 0 for heap memory
+    size_t alignment_ = 0;
+    bool huge_ = false;
+    bool locked_ = false;
+};
+
+/**
+ * @brief count value-initialized T in a BufferRegion, for ring slots (v1.2.0)
+ */
+template <typename T>
+class BufferArray {
+public:
+    explicit BufferArray(size_t count)
+        : region_(count * sizeof(T), alignof(T)), count_(count) {
+        if (!region_.data()) {
+            throw std::bad_alloc();
+        }
+        T* items = data();
+        size_t built = 0;
+        try {
+            for (; built < count_; ++built) {
+                new (items + built) T();
+            }
+        } catch (...) {
+            destroy(built);
+            throw;
+        }
+    }
+
+    ~BufferArray() { destroy(count_); }
+
+    BufferArray(const BufferArray&) = delete;
+    BufferArray& operator=(const BufferArray&) = delete;
+
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+
+    T* data() const { return static_cast<T*>(region_.data()); }
+    size_t size() const { return count_; }
+
+private:
+    void destroy(size_t built) {
+        for (size_t i = built; i > 0; --i) {
+            data()[i - 1].~T();
+        }
+    }
+
+    BufferRegion region_;
+    size_t count_;
+};
+
+/**
+ * @brief Prefault and lock a mapping the library made itself (v1.2.0)
+ *
+ * For file mappings such as MmapFileSink's segments and
+ * FlightRecorderSink's ring, which cannot be on
+ * MAP_HUGETLB pages: applies prefault and lock as set, writing each page
+ * back unchanged where MADV_POPULATE_WRITE is missing.
+ */
+void prepare_mapping(void* map, size_t size);
+
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include "logger.hpp"
+#include "interned_name.hpp"
+#include <cstdint>
+#include <unordered_map>
+
+namespace Zyrnix {
+
+/**
+ * @brief A component's name and level over a root Logger's pipeline (v1.2.0)
+ *
+ * Made by Logger::child() or ChildLogger::child(); its name is the
+ * parent's name, a dot and the child's name. A child holds no sinks,
+ * filters or queue of its own: past its level check a record goes
+ * straight into the root's pipeline, carrying the child's name. It is a
+ * few pointers and two bytes, so one per class or connection is cheap.
+ *
+ * The level is inherited from the parent unless set_level() is called,
+ * and the inherited level is resolved when a level changes, so each call
+ * costs the same two atomic loads whatever the depth. The root's sink
+ * levels still apply. Records below a child's level do not go to the
+ * root's backtrace ring, and XLOG_*_DEFERRED sites need a Logger.
+ */
+class ChildLogger {
+public:
+    ChildLogger(const ChildLogger&) = delete;
+    ChildLogger& operator=(const ChildLogger&) = delete;
+
+    std::string_view name() const { return name_->text; }
+    uint32_t name_id() const { return name_->id; }
+    Logger& root() const { return *root_; }
+    const ChildLogger* parent() const { return parent_; }
+
+    /**
+     * @brief Grandchild, named "<this name>.<name>"; same rules as Logger::child()
+     */
+    ChildLogger* child(std::string_view name);
+
+    /**
+     * @brief Give this child, and the children inheriting from it, its own level
+     */
+    void set_level(LogLevel level);
+
+    /**
+     * @brief Follow the parent's level again
+     */
+    void inherit_level();
+    bool inherits_level() const { return own_.load(std::memory_order_relaxed) == inherit; }
+
+    LogLevel get_level() const {
+        const uint8_t level = level_.load(std::memory_order_relaxed);
+        return level == inherit ? root_->min_level() : static_cast<LogLevel>(level);
+    }
+    LogLevel get_effective_level() const {
+        const uint32_t word = root_->levels_.load(std::memory_order_relaxed);
+        // An inherited temporary level past its deadline is settled by log()
+        if (inherits_level() && root_->temporary_level_lapsed(word)) {
+            return Logger::sink_floor_of(word);
+        }
+        return std::max(get_level(), Logger::sink_floor_of(word));
+    }
+
+    void log(LogLevel level, std::string_view message);
+    void log(const LogSite& site, std::string_view message);
+    void log_limited(const LogSite& site, uint64_t suppressed, std::string_view message);
+    void record_suppressed(uint64_t count) { root_->record_suppressed(count); }
+
+    // make runs on the calling thread, deferrable() or not
+    template <class F>
+        requires LazyMessage<F> || is_deferrable_v<std::decay_t<F>>
+    void log_lazy(const LogSite& site, F&& make) {
+        if (enabled(site)) {
+            decltype(auto) message = build_lazy(make);
+            log(site, std::string_view(message));
+        }
+    }
+
+    void trace(std::string_view msg) { log(LogLevel::Trace, msg); }
+    void debug(std::string_view msg) { log(LogLevel::Debug, msg); }
+    void info(std::string_view msg) { log(LogLevel::Info, msg); }
+    void warn(std::string_view msg) { log(LogLevel::Warn, msg); }
+    void error(std::string_view msg) { log(LogLevel::Error, msg); }
+    void critical(std::string_view msg) { log(LogLevel::Critical, msg); }
+
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void log(LogLevel level, std::string_view message, Fields&&... fields) {
+        if (enabled(level)) {
+            Field list[] = {Field(std::forward<Fields>(fields))...};
+            root_->emit_fields(level, message, list, this);
+        }
+    }
+    void log_fields(LogLevel level, std::string_view message, std::span<Field> fields);
+
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void trace(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Trace, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void debug(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Debug, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void info(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Info, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void warn(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Warn, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void error(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Error, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void critical(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Critical, message, std::forward<Fields>(fields)...);
+    }
+
+#if XLOG_HAS_FMT
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void log(LogLevel level, fmt::format_string<Args...> format, Args&&... args) {
+        if (enabled(level)) {
+            vlog(level, format, fmt::make_format_args(args...));
+        }
+    }
+
+    template <class... Args>
+    void log(const LogSite& site, fmt::format_string<Args...> format, Args&&... args) {
+        if (enabled(site)) {
+            vlog(site.level, format, fmt::make_format_args(args...), &site);
+        }
+    }
+
+    template <class... Args>
+    void log_limited(const LogSite& site, uint64_t suppressed, fmt::format_string<Args...> format, Args&&... args) {
+        record_suppressed(suppressed);
+        if (enabled(site)) {
+            vlog(site.level, format, fmt::make_format_args(args...), &site, suppressed);
+        }
+    }
+
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void trace(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Trace, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void debug(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Debug, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void info(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Info, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void warn(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Warn, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void error(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Error, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void critical(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Critical, format, std::forward<Args>(args)...);
+    }
+#endif
+
+private:
+    friend class Logger;
+    friend struct ChildRegistry;
+
+    // In own_, no level of its own; in level_, the root's level applies
+    static constexpr uint8_t inherit = 0xFF;
+
+    ChildLogger(Logger* root, const ChildLogger* parent, const InternedName* name)
+        : root_(root), parent_(parent), name_(name) {}
+
+    bool enabled(LogLevel level) const {
+        root_->settle_sink_floor();
+        if (!root_->sinks_accept(level)) {
+            return false;
+        }
+        root_->check_temporary_level_expiry();
+        return level >= get_level();
+    }
+    bool enabled(const LogSite& site) const {
+        return enabled(site.level) || (root_->sinks_accept(site.level) && site.forced());
+    }
+#if XLOG_HAS_FMT
+    void vlog(LogLevel level, fmt::string_view format, fmt::format_args args, const LogSite* site = nullptr,
+              uint64_t suppressed = 0);
+#endif
+
+    Logger* root_;
+    const ChildLogger* parent_;  // nullptr for the root's own children
+    const InternedName* name_;
+    std::atomic<uint8_t> own_{inherit};
+    std::atomic<uint8_t> level_{inherit};  // own_, else the nearest ancestor's
+};
+
+/**
+ * @brief A root Logger's children, by full name (v1.2.0)
+ */
+struct ChildRegistry {
+    std::mutex mtx;
+    std::unordered_map<const InternedName*, std::unique_ptr<ChildLogger>> by_name;
+    std::vector<ChildLogger*> order;  // Creation order, so parents come before their children
+
+    // Caller holds mtx
+    void resolve_levels();
+};
+
+}
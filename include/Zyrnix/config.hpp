@@ -5,6 +5,7 @@
 #include <map>
 #include <vector>
 #include "log_level.hpp"
+#include "level_rules.hpp"
 
 namespace Zyrnix {
 
@@ -18,8 +19,18 @@ struct LoggerConfig {
     LogLevel level = LogLevel::Info;
     bool async = false;
     std::vector<std::string> sinks;
+    // Each sink object's members but "type", as "<type>_<key>" (e.g.
+    // "file_path", "loki_url"); arrays of scalars are joined with commas
     std::map<std::string, std::string> sink_params;
 
+    // Formatter pattern for every sink of this logger (v1.2.0); a sink's
+    // own "pattern" (stored as sink_params["<type>_pattern"]) wins.
+    std::string pattern;
+
+    // ExpressionFilter source, e.g. "level >= warn && msg ~ /timeout/"
+    // (v1.2.0); empty for none. Quotes inside it are escaped as \".
+    std::string filter;
+
     // Redaction configuration (v1.1.3)
     // These are stored as raw strings and interpreted by ConfigLoader
     // to configure Logger redaction behaviour.
@@ -27,6 +38,23 @@ struct LoggerConfig {
     std::string redact_regexes;
     std::string redact_presets;
     bool redact_cloud_only = false;
+
+    // Async queue configuration (v1.2.0), only used when async is true.
+    // overflow_policy is one of: block, drop_newest, drop_oldest, sample
+    size_t queue_capacity = 8192;
+    std::string overflow_policy = "block";
+    size_t block_timeout_ms = 100;
+    size_t sample_rate = 10;
+
+    // Levels at or above priority_level bypass the backlog through a
+    // separate lane; empty disables it. sync_critical writes Critical
+    // records on the calling thread once the queue has been fenced.
+    std::string priority_level;
+    bool sync_critical = false;
+
+    // Open each sink (file, connection) when its first record arrives
+    // rather than when the logger is created (v1.2.0)
+    bool lazy_sinks = false;
 };
 
 /**
@@ -37,13 +65,19 @@ struct LoggerConfig {
  * 
  * Example JSON format:
  * {
+ *   "levels": {"db.*": "debug", "http": "warn"},
  *   "loggers": [
  *     {
  *       "name": "app",
  *       "level": "info",
  *       "async": true,
+ *       "queue_capacity": 8192,
+ *       "overflow_policy": "drop_oldest",
+ *       "pattern": "%Y-%m-%dT%H:%M:%S.%e %l [%n] %t %v",
+ *       "filter": "level >= warn || field.tenant == \"acme\"",
+ *       "lazy_sinks": true,
  *       "sinks": [
- *         {"type": "stdout"},
+ *         {"type": "stdout", "pattern": "%H:%M:%S %l %v"},
  *         {"type": "file", "path": "/var/log/app.log"},
  *         {"type": "rotating", "path": "app.log", "max_size": 10485760, "max_files": 5}
  *       ]
@@ -72,12 +106,36 @@ public:
      * @return Vector of logger configurations
      */
     static std::vector<LoggerConfig> get_logger_configs();
+
+    /**
+     * @brief The "levels" object: patterns over logger names (v1.2.0)
+     *
+     * HotReloadManager hands them to LoggerRegistry::set_level_rules(); a
+     * matching rule wins over a logger's own "level".
+     */
+    static LevelRules get_level_rules();
     
     /**
      * @brief Create loggers from loaded configuration
      * @return Map of logger name to Logger instance
      */
     static std::map<std::string, std::shared_ptr<Logger>> create_loggers();
+
+    /**
+     * @brief Create one logger; its sinks are named by their type (v1.2.0)
+     */
+    static std::shared_ptr<Logger> create_logger(const LoggerConfig& config);
+
+    /**
+     * @brief Move a logger built from running to next in place (v1.2.0)
+     *
+     * Level, redaction and filter changes go through the logger's setters.
+     * Only sinks whose parameters or pattern changed are rebuilt, each
+     * swapped in with a single sink snapshot; the others keep their files,
+     * connections and buffered records. Returns false, leaving the logger
+     * alone, when next needs a new logger (a different async setup).
+     */
+    static bool reconfigure(Logger& logger, const LoggerConfig& running, const LoggerConfig& next);
     
     /**
      * @brief Clear all loaded configurations
@@ -92,6 +150,7 @@ public:
 
 private:
     static std::vector<LoggerConfig> configs_;
+    static LevelRules level_rules_;
     
     static LogLevel parse_log_level(const std::string& level);
     static bool parse_json_internal(const std::string& content);
@@ -4,23 +4,66 @@
 #include <atomic>
 #include <functional>
 #include <chrono>
+#include <cstdint>
 
 namespace Zyrnix {
 
+/**
+ * @brief Calls on_change after the config file changes
+ *
+ * Since v1.2.0 the watcher sleeps on inotify (Linux) or kqueue (BSD,
+ * macOS) on the file's directory, so a config deployed by writing a
+ * temporary file and renaming it over the old one, or by swapping a
+ * symlink, is seen as well as an edit in place. Events are debounced:
+ * on_change runs once the directory has been quiet for debounce, and
+ * only if the file's inode, size or nanosecond mtime differs from the
+ * last time it ran. Without either API, or if the directory cannot be
+ * watched, the file is polled every poll_interval with the same checks.
+ */
 class ConfigWatcher {
 public:
-    ConfigWatcher(const std::string& config_path, std::function<void()> on_change, std::chrono::milliseconds poll_interval = std::chrono::milliseconds(1000));
+    enum class Mode { Inotify, Kqueue, Polling };
+
+    ConfigWatcher(const std::string& config_path, std::function<void()> on_change,
+                  std::chrono::milliseconds poll_interval = std::chrono::milliseconds(1000),
+                  std::chrono::milliseconds debounce = std::chrono::milliseconds(50));
     ~ConfigWatcher();
     void start();
     void stop();
+
+    // How the running watcher learns of changes (v1.2.0)
+    Mode mode() const { return mode_.load(std::memory_order_relaxed); }
+
 private:
+    struct FileState {
+        bool exists = false;
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        int64_t size = 0;
+        int64_t mtime_ns = 0;
+
+        bool operator==(const FileState&) const = default;
+    };
+
     void watch_loop();
+    bool watch_inotify();
+    bool watch_kqueue();
+    void watch_polling();
+    // Calls on_change_ if the file differs from last_
+    void check();
+    // False once stop() has been called
+    bool wait(std::chrono::milliseconds timeout);
+    FileState read_state() const;
+
     std::string config_path_;
     std::function<void()> on_change_;
     std::chrono::milliseconds poll_interval_;
+    std::chrono::milliseconds debounce_;
     std::atomic<bool> running_{false};
+    std::atomic<Mode> mode_{Mode::Polling};
     std::thread watcher_thread_;
-    time_t last_mtime_ = 0;
+    FileState last_;
+    int wake_fds_[2] = {-1, -1};  // stop() writes to [1] to wake the watcher
 };
 
 }
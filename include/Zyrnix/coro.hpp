@@ -0,0 +1,183 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Lazily started coroutine returning T (v1.2.0)
+ *
+ * Runs when first awaited and resumes its awaiter when it finishes, by
+ * symmetric transfer, so chains of co_await do not grow the stack. An
+ * exception escaping the body is rethrown from the co_await.
+ */
+template <typename T = void>
+class CoTask {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct PromiseBase {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            template <typename P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+                auto next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    struct promise_type : PromiseBase {
+        std::optional<T> value;
+
+        CoTask get_return_object() { return CoTask(Handle::from_promise(*this)); }
+
+        template <typename U>
+        void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    };
+
+    CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+    ~CoTask() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+
+    T await_resume() {
+        auto& promise = handle_.promise();
+        if (promise.error) std::rethrow_exception(promise.error);
+        return std::move(*promise.value);
+    }
+
+private:
+    explicit CoTask(Handle handle) : handle_(handle) {}
+
+    Handle handle_;
+};
+
+template <>
+struct CoTask<void>::promise_type : CoTask<void>::PromiseBase {
+    CoTask get_return_object() { return CoTask(Handle::from_promise(*this)); }
+    void return_void() {}
+};
+
+template <>
+inline void CoTask<void>::await_resume() {
+    if (handle_.promise().error) std::rethrow_exception(handle_.promise().error);
+}
+
+/**
+ * @brief One thread running the coroutines of every AsyncLogSink (v1.2.0)
+ *
+ * Coroutines hop onto it with co_await schedule() and wait on it with
+ * co_await sleep_for(), which sets a timer rather than blocking the
+ * thread, so any number of them can be waiting at once. Started on
+ * first use and leaked, like HttpTransport.
+ */
+class SinkExecutor {
+public:
+    static SinkExecutor& instance();
+
+    /**
+     * @brief Resume handle on the executor thread, from any thread
+     */
+    void post(std::coroutine_handle<> handle);
+
+    /**
+     * @brief Resume handle on the executor thread at deadline, from any thread
+     */
+    void post_at(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle);
+
+    bool in_executor() const { return std::this_thread::get_id() == thread_id_; }
+
+    /**
+     * @brief Awaitable: continue on the executor thread
+     */
+    auto schedule() {
+        struct Awaiter {
+            SinkExecutor& executor;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { executor.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    /**
+     * @brief Awaitable: continue on the executor thread once delay has passed
+     */
+    template <typename Rep, typename Period>
+    auto sleep_for(std::chrono::duration<Rep, Period> delay) {
+        struct Awaiter {
+            SinkExecutor& executor;
+            std::chrono::steady_clock::time_point deadline;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { executor.post_at(deadline, h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, std::chrono::steady_clock::now() +
+                                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay)};
+    }
+
+    SinkExecutor(const SinkExecutor&) = delete;
+    SinkExecutor& operator=(const SinkExecutor&) = delete;
+
+private:
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t seq;  // Keeps timers with the same deadline in order
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+        }
+    };
+
+    SinkExecutor();
+    ~SinkExecutor() = delete;  // Leaked, so it outlives every static logger's sinks
+    void run();
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t timer_seq_ = 0;
+    std::thread::id thread_id_;
+};
+
+}
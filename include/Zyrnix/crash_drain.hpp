@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief Buffered write() to a pre-opened fd, for a crash handler (v1.2.0)
+ *
+ * Uses nothing but write(), so it may be called from a signal handler.
+ * Errors are ignored: there is no one left to report them to.
+ */
+class CrashWriter {
+public:
+    explicit CrashWriter(int fd) : fd_(fd) {}
+    ~CrashWriter() { flush(); }
+
+    CrashWriter(const CrashWriter&) = delete;
+    CrashWriter& operator=(const CrashWriter&) = delete;
+
+    void write(std::string_view text);
+    void write(unsigned long long value);
+    void flush();
+
+private:
+    int fd_;
+    char buffer_[4096];
+    size_t used_ = 0;
+};
+
+/**
+ * @brief Writes out what is still queued when the process crashes (v1.2.0)
+ *
+ * What an async logger or a cloud sink holds in memory is the last few
+ * seconds before a crash, and is lost with the process. install() opens
+ * a file up front and handles SIGSEGV, SIGABRT and SIGBUS: the handler
+ * walks every registered source and writes out its raw contents, then
+ * restores the previous handler and re-raises the signal.
+ *
+ * Async queues (every backend), LokiSink and CloudWatchSink register
+ * themselves while they exist. The handler reads their storage without
+ * taking their locks and without allocating; records being pushed or
+ * popped at that moment may be missed or come out torn, and a record the
+ * consumer had already taken off the queue is not seen. The walk is
+ * best effort by design: the alternative is losing everything.
+ *
+ * @code
+ * Zyrnix::crash::install("/var/log/myapp.crash.log");
+ * @endcode
+ */
+namespace crash {
+
+/**
+ * @brief Writes a source's queued contents; must be async-signal-safe
+ */
+using DrainFn = void (*)(const void* source, CrashWriter& out);
+
+/**
+ * @brief Register a source to drain on a crash
+ * @return Slot to pass to unregister_source(), or -1 if the table (64
+ *         sources) is full and the source will not be drained
+ */
+int register_source(const void* source, DrainFn drain);
+void unregister_source(int slot);
+
+/**
+ * @brief Open path for appending and install the handlers
+ * @return false if the file cannot be opened or the platform has no
+ *         sigaction
+ */
+bool install(const std::string& path);
+
+/**
+ * @brief Restore the handlers found by install() and close the file
+ */
+void uninstall();
+
+/**
+ * @brief Write every registered source to fd now (also used by the handler)
+ */
+void drain(int fd);
+
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define XLOG_HAS_RDTSC 1
+#endif
+
+namespace Zyrnix {
+
+/**
+ * @brief Cheap monotonic ticks for timing sampled calls (v1.2.0)
+ *
+ * On x86-64 with an invariant TSC, now() is one rdtsc; elsewhere it is
+ * steady_clock in nanoseconds. to_ns() converts a tick count with a rate
+ * measured against steady_clock once, the first time it is needed, from
+ * a reference taken when the library was loaded, so calibration never
+ * spins for long on a logging thread.
+ */
+class CycleClock {
+public:
+    static uint64_t now() {
+#ifdef XLOG_HAS_RDTSC
+        if (uses_tsc_) {
+            return __rdtsc();
+        }
+#endif
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static uint64_t to_ns(uint64_t ticks) {
+#ifdef XLOG_HAS_RDTSC
+        if (uses_tsc_) {
+            return static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick());
+        }
+#endif
+        return ticks;
+    }
+
+    static bool uses_tsc() { return uses_tsc_; }
+    static double ns_per_tick();
+
+private:
+    static const bool uses_tsc_;
+};
+
+}
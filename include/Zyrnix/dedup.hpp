@@ -0,0 +1,90 @@
+#pragma once
+#include "log_level.hpp"
+#include "log_site.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+struct DedupOptions {
+    // How long repeats of a line are folded into one summary
+    std::chrono::milliseconds window{5000};
+
+    // Distinct lines tracked at once, rounded up to a power of two. 1 only
+    // collapses consecutive repeats, as syslog does; more also collapses
+    // storms that interleave.
+    size_t slots = 64;
+};
+
+/**
+ * @brief One line standing in for a run of repeats (v1.2.0)
+ */
+struct RepeatSummary {
+    LogLevel level;
+    const LogSite* site;
+    std::chrono::system_clock::time_point last;  // Timestamp for the summary line
+    uint64_t repeats;
+    std::string message;  // The repeated line with " [repeated N more times, first ..., last ...]"
+};
+
+/**
+ * @brief Collapses repeats of a line into a summary (v1.2.0)
+ *
+ * Lines are keyed on level and text, each hashing to one slot. The first
+ * line of a run is written; repeats within window of it are only counted.
+ * The run ends when the window has passed, or when a different line takes
+ * its slot, and then a summary with the count and the first and last
+ * repeat's times goes out. Runs that simply stop are summed up by whichever
+ * call next finds a window has passed, or by drain(all).
+ *
+ * Each slot has its own lock, and a slot keeps the capacity of the text it
+ * last held, so checking a line does not allocate.
+ */
+class Deduplicator {
+public:
+    explicit Deduplicator(const DedupOptions& options = DedupOptions{});
+    ~Deduplicator();
+
+    Deduplicator(const Deduplicator&) = delete;
+    Deduplicator& operator=(const Deduplicator&) = delete;
+
+    /**
+     * @brief Whether to write a line logged at now, or count it as a repeat
+     *
+     * Summaries of runs that ended are appended to summaries, to be
+     * written before the line.
+     */
+    bool admit(LogLevel level, std::string_view message, const LogSite* site,
+               std::chrono::system_clock::time_point now, std::vector<RepeatSummary>& summaries) const;
+
+    /**
+     * @brief Summaries of runs whose window has passed, or with all of every run
+     */
+    void drain(std::chrono::system_clock::time_point now, bool all, std::vector<RepeatSummary>& summaries) const;
+
+    /**
+     * @brief Repeats held back so far
+     */
+    uint64_t collapsed_count() const { return collapsed_.load(std::memory_order_relaxed); }
+
+    const DedupOptions& options() const { return options_; }
+
+private:
+    struct Slot;
+
+    void summarize(Slot& slot, std::vector<RepeatSummary>& summaries) const;
+
+    DedupOptions options_;
+    std::chrono::system_clock::duration window_;
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    mutable std::atomic<int64_t> next_sweep_{0};  // system_clock ticks
+    mutable std::atomic<uint64_t> collapsed_{0};
+};
+
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include "Zyrnix_features.hpp"
+#include "log_site.hpp"
+#include "logger.hpp"
+
+#if XLOG_HAS_FMT
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <fmt/format.h>
+
+namespace Zyrnix {
+
+/**
+ * @brief Static descriptor of one deferred-formatting call site (v1.2.0)
+ *
+ * Built at compile time by the XLOG_*_DEFERRED macros. decode is
+ * generated from the call's argument types and turns the captured bytes
+ * back into the formatted message.
+ */
+struct DeferredSite : LogSite {
+    using DecodeFn = void (*)(std::string_view bytes, const char* format, std::string& out);
+
+    const char* format;
+    DecodeFn decode;
+};
+
+namespace deferred {
+
+/**
+ * @brief How an argument of type T is captured and read back
+ *
+ * Trivially copyable values are copied byte for byte; strings are stored
+ * as a length followed by their characters and come back as views into
+ * the captured bytes.
+ */
+template <class T>
+struct Capture {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "deferred logging captures arguments by value: use strings or trivially copyable types, "
+                  "or the formatting XLOG_* macros");
+    using Decoded = T;
+
+    static size_t size(const T&) { return sizeof(T); }
+    static char* write(char* p, const T& value) {
+        std::memcpy(p, &value, sizeof(T));
+        return p + sizeof(T);
+    }
+    static T read(const char*& p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+};
+
+struct StringCapture {
+    using Decoded = std::string_view;
+
+    static size_t size(std::string_view s) { return sizeof(uint32_t) + s.size(); }
+    static char* write(char* p, std::string_view s) {
+        const uint32_t length = static_cast<uint32_t>(s.size());
+        std::memcpy(p, &length, sizeof(length));
+        std::memcpy(p + sizeof(length), s.data(), length);
+        return p + sizeof(length) + length;
+    }
+    static std::string_view read(const char*& p) {
+        uint32_t length;
+        std::memcpy(&length, p, sizeof(length));
+        std::string_view s(p + sizeof(length), length);
+        p += sizeof(length) + length;
+        return s;
+    }
+};
+
+// A null C string is captured as empty
+struct CStringCapture : StringCapture {
+    static std::string_view view(const char* s) { return s ? std::string_view(s) : std::string_view(); }
+    static size_t size(const char* s) { return StringCapture::size(view(s)); }
+    static char* write(char* p, const char* s) { return StringCapture::write(p, view(s)); }
+};
+
+template <> struct Capture<std::string_view> : StringCapture {};
+template <> struct Capture<std::string> : StringCapture {};
+template <> struct Capture<const char*> : CStringCapture {};
+template <> struct Capture<char*> : CStringCapture {};
+
+template <class T>
+using Stored = std::decay_t<T>;
+
+template <class... Ts>
+struct TypeList {};
+
+// Only named in decltype() by the macros, to turn the arguments into types
+template <class... Args>
+TypeList<Stored<Args>...> type_list_of(const Args&...);
+
+/**
+ * @brief An argument as decode() would hand it to fmt, for formatting
+ *        right away without capturing it
+ */
+template <class T>
+decltype(auto) normalize(const T& value) {
+    if constexpr (std::is_base_of_v<CStringCapture, Capture<Stored<T>>>) {
+        return CStringCapture::view(value);
+    } else {
+        return (value);
+    }
+}
+
+/**
+ * @brief Append the captured form of args to buffer's start (resized to fit)
+ */
+template <class... Args>
+void encode(std::string& buffer, const Args&... args) {
+    buffer.resize((size_t{0} + ... + Capture<Stored<Args>>::size(args)));
+    char* p = buffer.data();
+    ((p = Capture<Stored<Args>>::write(p, args)), ...);
+    (void)p;
+}
+
+template <class... Ts>
+void decode(std::string_view bytes, const char* format, std::string& out) {
+    const char* p = bytes.data();
+    // Braced initialization reads the arguments in order
+    std::tuple<typename Capture<Ts>::Decoded...> values{Capture<Ts>::read(p)...};
+    (void)p;
+    out.clear();
+    std::apply([&](const auto&... value) {
+        fmt::vformat_to(std::back_inserter(out), fmt::string_view(format), fmt::make_format_args(value...));
+    }, values);
+}
+
+/**
+ * @brief Build a call site; fails to compile if format does not fit the arguments
+ */
+template <class... Ts>
+consteval DeferredSite make_site(TypeList<Ts...>, const char* format, const LogSite& site) {
+    (void)fmt::format_string<const typename Capture<Ts>::Decoded&...>(format);
+    return DeferredSite{site, format, &decode<Ts...>};
+}
+
+/**
+ * @brief decode() for a deferrable() closure captured byte for byte
+ */
+template <class F>
+void run_lazy(std::string_view bytes, const char*, std::string& out) {
+    std::array<char, sizeof(F)> raw;
+    std::memcpy(raw.data(), bytes.data(), sizeof(F));
+    const F make = std::bit_cast<F>(raw);
+    decltype(auto) message = std::invoke(make);
+    out.assign(std::string_view(message));
+}
+
+// Only decodes: records point at the macro's own LogSite for the location
+template <class F>
+inline constexpr DeferredSite lazy_site{LogSite{LogLevel::Trace, "", 0, 0, "", nullptr}, "", &run_lazy<F>};
+
+}
+
+template <class F>
+bool Logger::defer_lazy(const LogSite& site, const F& fn) {
+    const std::string_view bytes(reinterpret_cast<const char*>(&fn), sizeof(F));
+    if (backtrace_on() && site.level < min_level() && !site.forced()) {
+        capture_backtrace(site.level, bytes, &site, &deferred::lazy_site<F>);
+        return true;
+    }
+#ifndef XLOG_NO_ASYNC
+    if (defers(site.level)) {
+        LogRecord record = acquire_record();
+        record.message.assign(bytes);
+        push_deferred(site, deferred::lazy_site<F>, std::move(record));
+        return true;
+    }
+#endif
+    return false;
+}
+
+template <class... Args>
+void Logger::log_deferred(const DeferredSite& site, const Args&... args) {
+    if (!may_log(site)) {
+        return;
+    }
+    if (backtrace_on() && site.level < min_level() && !site.forced()) {
+        // Into the backtrace ring as argument bytes; formatted only if dumped
+        thread_local std::string bytes;
+        deferred::encode(bytes, args...);
+        capture_backtrace(site.level, bytes, &site, &site);
+        return;
+    }
+#ifndef XLOG_NO_ASYNC
+    if (defers(site.level)) {
+        LogRecord record = acquire_record();
+        deferred::encode(record.message, args...);
+        push_deferred(site, site, std::move(record));
+        return;
+    }
+#endif
+    // Same argument handling as decode(), so null C strings do not throw
+    auto format_now = [&](const auto&... values) {
+        vlog(site.level, site.format, fmt::make_format_args(values...), &site);
+    };
+    format_now(deferred::normalize(args)...);
+}
+
+}
+
+#endif
@@ -0,0 +1,246 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+enum class FieldType : uint8_t { String, Integer, Float, Bool };
+
+/**
+ * @brief The value of a structured field, with its type (v1.2.0)
+ *
+ * Numbers and booleans are kept as the text they print as, written with
+ * std::to_chars when the value is made (no allocation: it fits the small
+ * string buffer), so filters and text sinks read every field the same
+ * way. The type tells JSON and binary sinks to write them natively.
+ * Non-finite floats are stored as strings.
+ */
+class FieldValue {
+public:
+    FieldValue() = default;
+    FieldValue(std::string text) : text_(std::move(text)) {}
+    FieldValue(std::string_view text) : text_(text) {}
+    FieldValue(const char* text) : text_(text) {}
+    FieldValue(char c) : text_(1, c) {}
+
+    FieldValue(bool value) : text_(value ? "true" : "false"), type_(FieldType::Bool) {}
+
+    template <std::integral T>
+        requires(!std::same_as<T, bool> && !std::same_as<T, char>)
+    FieldValue(T value) : type_(FieldType::Integer) {
+        char digits[24];
+        text_.assign(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+    template <std::floating_point T>
+    FieldValue(T value) {
+        char digits[32];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text_.assign(digits, result.ptr);
+        type_ = std::isfinite(value) ? FieldType::Float : FieldType::String;
+    }
+
+    /**
+     * @brief A value of type from text it printed as, e.g. read back from a file
+     */
+    static FieldValue of(FieldType type, std::string_view text) {
+        FieldValue value(text);
+        value.type_ = type;
+        return value;
+    }
+
+    FieldType type() const { return type_; }
+    const std::string& text() const { return text_; }
+
+    /**
+     * @brief Append as a JSON value: numbers and booleans bare, strings quoted
+     */
+    void append_json(std::string& out) const;
+
+    bool operator==(const FieldValue& other) const = default;
+    bool operator==(std::string_view text) const { return text_ == text; }
+
+private:
+    std::string text_;
+    FieldType type_ = FieldType::String;
+};
+
+/**
+ * @brief A typed key/value pair, built on the caller's stack by kv() (v1.2.0)
+ *
+ * The key is a view: pass a literal, or a string that outlives the call.
+ */
+struct Field {
+    std::string_view key;
+    FieldValue value;
+};
+
+template <class T>
+Field kv(std::string_view key, T&& value) {
+    return Field{key, FieldValue(std::forward<T>(value))};
+}
+
+/**
+ * @brief Intern a field key: the view returned lives as long as the process (v1.2.0)
+ *
+ * A per-thread cache of recent keys sits in front of the shared table,
+ * so keys logged again from the same buffer (literals, context keys)
+ * cost a compare. Meant for the small, fixed set of names an application
+ * uses, not for keys made up per record.
+ */
+std::string_view intern_field_key(std::string_view key);
+
+/**
+ * @brief The fields of a LogRecord, in insertion order (v1.2.0)
+ *
+ * A flat list: the first inline_capacity entries live in the record, so
+ * a record with a few fields allocates nothing for them and they travel
+ * through an async queue with it; past that they move to one heap
+ * array. Lookups scan, which beats hashing at these sizes. Keys are
+ * interned, so entries hold views that outlive whatever the key came
+ * from. Adding a field invalidates iterators.
+ */
+class FieldList {
+public:
+    struct Entry {
+        std::string_view key;
+        FieldValue value;
+    };
+    using iterator = Entry*;
+    using const_iterator = const Entry*;
+
+    static constexpr size_t inline_capacity = 8;
+
+    FieldList() {}
+    FieldList(std::initializer_list<Entry> entries) {
+        for (const auto& entry : entries) {
+            insert_or_assign(entry.key, entry.value);
+        }
+    }
+    FieldList(const FieldList& other) { *this = other; }
+    FieldList(FieldList&& other) noexcept { *this = std::move(other); }
+    ~FieldList() { clear(); }
+
+    FieldList& operator=(const FieldList& other) {
+        if (this != &other) {
+            clear();
+            if (other.spilled()) {
+                heap_ = other.heap_;
+            } else {
+                for (; size_ < other.size_; ++size_) {
+                    new (&slots_[size_]) Entry(other.slots_[size_]);
+                }
+            }
+        }
+        return *this;
+    }
+
+    FieldList& operator=(FieldList&& other) noexcept {
+        if (this != &other) {
+            clear();
+            if (other.spilled()) {
+                heap_.swap(other.heap_);
+            } else {
+                for (; size_ < other.size_; ++size_) {
+                    new (&slots_[size_]) Entry(std::move(other.slots_[size_]));
+                }
+                other.clear();
+            }
+        }
+        return *this;
+    }
+
+    size_t size() const { return spilled() ? heap_.size() : size_; }
+    bool empty() const { return size() == 0; }
+
+    iterator begin() { return spilled() ? heap_.data() : slots_; }
+    iterator end() { return begin() + size(); }
+    const_iterator begin() const { return spilled() ? heap_.data() : slots_; }
+    const_iterator end() const { return begin() + size(); }
+
+    /**
+     * @brief The value stored under key, or nullptr
+     */
+    const FieldValue* find(std::string_view key) const {
+        for (const auto& entry : *this) {
+            if (entry.key == key) {
+                return &entry.value;
+            }
+        }
+        return nullptr;
+    }
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    /**
+     * @brief Add key unless it is there already; true if added
+     */
+    bool emplace(std::string_view key, FieldValue value) {
+        if (contains(key)) {
+            return false;
+        }
+        append(key, std::move(value));
+        return true;
+    }
+
+    void insert_or_assign(std::string_view key, FieldValue value) {
+        for (auto& entry : *this) {
+            if (entry.key == key) {
+                entry.value = std::move(value);
+                return;
+            }
+        }
+        append(key, std::move(value));
+    }
+
+    /**
+     * @brief Remove every field; a spilled list keeps its heap array for reuse
+     */
+    void clear() {
+        for (; size_ > 0; --size_) {
+            slots_[size_ - 1].~Entry();
+        }
+        heap_.clear();
+    }
+
+private:
+    bool spilled() const { return !heap_.empty(); }
+
+    void append(std::string_view key, FieldValue value) {
+        key = intern_field_key(key);
+        if (spilled()) {
+            heap_.push_back(Entry{key, std::move(value)});
+        } else if (size_ < inline_capacity) {
+            new (&slots_[size_]) Entry{key, std::move(value)};
+            ++size_;
+        } else {
+            spill(Entry{key, std::move(value)});
+        }
+    }
+
+    void spill(Entry&& next);
+
+    union {
+        Entry slots_[inline_capacity];  // The first size_ are live
+    };
+    uint32_t size_ = 0;
+    std::vector<Entry> heap_;  // All the entries, once spilled
+};
+
+template <class T>
+inline constexpr bool is_field_v = std::is_same_v<std::remove_cvref_t<T>, Field>;
+
+// One or more Fields: what the typed-field overloads take
+template <class... Ts>
+concept FieldPack = sizeof...(Ts) > 0 && (is_field_v<Ts> && ...);
+
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "log_level.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief The file written by FlightRecorderSink, and its reader (v1.2.0)
+ *
+ * A 4096-byte header, then capacity bytes of ring, capacity a power of
+ * two. Header fields, in native byte order at fixed offsets:
+ *
+ *     0    char[8]  magic "ZYRNFLT1"
+ *     8    u32      version, 1; written last, so 0 means not ready yet
+ *     12   u32      header size, 4096
+ *     16   u64      capacity
+ *     24   u64      generation: how many times the file has been opened
+ *     64   u64      head: bytes reserved by writers, ever
+ *
+ * Entries start 16-byte aligned at position % capacity and never wrap:
+ * a u64 commit word, a u32 payload size (the top bit set for padding to
+ * the end of the ring), the u32 CRC-32C of the payload, the payload, and
+ * padding to 16 bytes. Writers reserve space by advancing head with a
+ * CAS and overwrite the oldest entries; the commit word is stored last
+ * as the entry's position + 1, so an entry left over from an earlier lap
+ * or cut short by the process dying never reads as committed. A payload
+ * is a record: i64 timestamp (ns since the epoch), u64 thread id, u32
+ * generation, u8 level, u8 0, u16 logger name size, the logger name and
+ * the message.
+ *
+ * The last capacity bytes before head are the recording. A reader walks
+ * them from the oldest position, following committed entries and
+ * stepping 16 bytes at a time past anything else.
+ */
+namespace flight {
+
+inline constexpr char magic[8] = {'Z', 'Y', 'R', 'N', 'F', 'L', 'T', '1'};
+inline constexpr uint32_t format_version = 1;
+inline constexpr size_t header_size = 4096;
+inline constexpr size_t entry_header_size = 16;
+inline constexpr size_t entry_alignment = 16;
+inline constexpr size_t record_header_size = 24;
+inline constexpr uint32_t padding_flag = 0x80000000u;
+
+struct Header {
+    char magic[8];
+    std::atomic<uint32_t> version;
+    uint32_t header_size;
+    uint64_t capacity;
+    uint64_t generation;
+    alignas(64) std::atomic<uint64_t> head;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the header's atomics live in a shared file mapping");
+static_assert(offsetof(Header, version) == 8 && offsetof(Header, capacity) == 16 &&
+              offsetof(Header, generation) == 24 && offsetof(Header, head) == 64);
+static_assert(sizeof(Header) <= header_size);
+
+/**
+ * @brief A record read back; the views point into the reader's mapping
+ */
+struct Record {
+    std::chrono::system_clock::time_point timestamp;
+    LogLevel level;
+    uint64_t thread_id;
+    uint64_t generation;
+    std::string_view logger_name;
+    std::string_view message;
+};
+
+/**
+ * @brief Reads a recording, for tools/zyrnix_flight or a post-mortem
+ *
+ * Maps the file read-only; meant for a file whose writer is gone, though
+ * a live one only costs the records written meanwhile.
+ */
+class Reader {
+public:
+    explicit Reader(const std::string& path);
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /**
+     * @brief Whether the file is a recording
+     */
+    bool is_open() const { return header_ != nullptr; }
+
+    /**
+     * @brief Call emit(const Record&) for every record, oldest first
+     * @return Records emitted
+     */
+    template <class Emit>
+    size_t read(Emit&& emit);
+
+    /**
+     * @brief Committed entries whose CRC did not match, found by read()
+     */
+    size_t damaged() const { return damaged_; }
+
+    uint64_t generation() const;
+    uint64_t capacity() const;
+
+private:
+    // The record at pos, if a committed one starts there; sets next
+    bool entry_at(uint64_t pos, uint64_t head, Record& record, bool& is_record, uint64_t& next);
+
+    const Header* header_ = nullptr;
+    const char* data_ = nullptr;
+    size_t mapped_size_ = 0;
+    size_t damaged_ = 0;
+};
+
+template <class Emit>
+size_t Reader::read(Emit&& emit) {
+    if (!header_) {
+        return 0;
+    }
+    damaged_ = 0;
+    const uint64_t capacity = header_->capacity;
+    const uint64_t head = header_->head.load(std::memory_order_acquire);
+    uint64_t pos = head > capacity ? head - capacity : 0;
+    pos = (pos + entry_alignment - 1) & ~static_cast<uint64_t>(entry_alignment - 1);
+    size_t emitted = 0;
+    Record record;
+    while (pos < head) {
+        bool is_record = false;
+        uint64_t next = pos + entry_alignment;
+        if (entry_at(pos, head, record, is_record, next) && is_record) {
+            emit(static_cast<const Record&>(record));
+            ++emitted;
+        }
+        pos = next;
+    }
+    return emitted;
+}
+
+}
+
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include "formatter.hpp"
+#include "log_record.hpp"
+#include "util.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+class SinkMetrics;
+
+/**
+ * @brief Storage for the renderings of one record (v1.2.0)
+ *
+ * Owned by whoever dispatches the record; every FormattedRecord built
+ * over it shares what it holds.
+ */
+class RenderCache {
+public:
+    RenderCache() = default;
+    RenderCache(const RenderCache&) = delete;
+    RenderCache& operator=(const RenderCache&) = delete;
+    RenderCache(RenderCache&&) = default;
+    RenderCache& operator=(RenderCache&&) = default;
+
+    /**
+     * @brief Forget the renderings, keeping the buffers for the next record
+     */
+    void reset();
+
+    /**
+     * @brief Most bytes any RenderCache in the process has held for one
+     *        record or batch, across all its layouts and its fields JSON
+     *
+     * Buffers past 64 KiB are released on reset, so a value above that
+     * means some lines are paying for a fresh buffer each time.
+     */
+    static size_t high_water_bytes();
+
+private:
+    friend class FormattedRecord;
+    friend class ScopedRenderCache;
+
+    void note_high_water() const;
+
+    const std::string* layout_ = nullptr;  // Layout of text_, nullptr until rendered
+    std::string text_;
+    // Kept across records with their buffers; the first other_count_ are in use
+    std::vector<std::pair<std::string, std::string>> other_layouts_;
+    size_t other_count_ = 0;
+    std::string fields_json_;
+    bool fields_json_ready_ = false;
+};
+
+/**
+ * @brief The calling thread's RenderCache, lent for one dispatch (v1.2.0)
+ *
+ * Reset on loan, so renderings go into buffers that kept their capacity
+ * from the thread's last record and a line costs no allocation once they
+ * have grown to fit. A dispatch nested inside another on the same thread,
+ * from a sink that logs, gets a cache of its own.
+ */
+class ScopedRenderCache {
+public:
+    ScopedRenderCache();
+    ~ScopedRenderCache();
+
+    ScopedRenderCache(const ScopedRenderCache&) = delete;
+    ScopedRenderCache& operator=(const ScopedRenderCache&) = delete;
+
+    operator RenderCache&() { return *cache_; }
+
+private:
+    RenderCache* cache_;
+    std::unique_ptr<RenderCache> nested_;
+};
+
+/**
+ * @brief A record on its way to the sinks, rendered at most once per layout (v1.2.0)
+ *
+ * Logger hands the same FormattedRecord to every sink. The first sink to
+ * call formatted() renders the line, and the others using the same
+ * layout get that rendering back instead of formatting it again.
+ *
+ * A cheap handle of views: copies share the RenderCache, and a record
+ * logged through a string_view reaches the sinks without being copied
+ * into a heap string. Valid only during the log_record()/log_batch()
+ * call, so sinks that keep records around must copy what they need.
+ */
+class FormattedRecord {
+public:
+    using Fields = FieldList;
+
+    FormattedRecord(const LogRecord& record, RenderCache& cache)
+        : FormattedRecord(record, record.message, cache) {}
+
+    /**
+     * @param message Text to log instead of record.message (e.g. redacted)
+     */
+    FormattedRecord(const LogRecord& record, std::string_view message, RenderCache& cache)
+        : logger_name_(record.logger_name), level_(record.level), message_(message),
+          timestamp_(record.timestamp), thread_id_(record.thread_id), site_(record.site),
+          fields_(&record.fields), trace_(&record.trace), stack_(record.stack.get()), cache_(&cache) {}
+
+    /**
+     * @brief Same record as base, logging message instead of base's text
+     */
+    FormattedRecord(const FormattedRecord& base, std::string_view message, RenderCache& cache)
+        : logger_name_(base.logger_name_), level_(base.level_), message_(message),
+          timestamp_(base.timestamp_), thread_id_(base.thread_id_), site_(base.site_),
+          fields_(base.fields_), trace_(base.trace_), stack_(base.stack_), cache_(&cache) {}
+
+    /**
+     * @brief A record without fields, straight from the caller's strings,
+     *        logged on the calling thread
+     */
+    FormattedRecord(std::string_view logger_name, LogLevel level, std::string_view message,
+                    std::chrono::system_clock::time_point timestamp, RenderCache& cache,
+                    const LogSite* site = nullptr, const StackTrace* stack = nullptr)
+        : logger_name_(logger_name), level_(level), message_(message),
+          timestamp_(timestamp), thread_id_(current_thread_id()), site_(site), fields_(nullptr),
+          trace_(&TraceContext::current()), stack_(stack), cache_(&cache) {}
+
+    std::string_view logger_name() const { return logger_name_; }
+    LogLevel level() const { return level_; }
+    std::chrono::system_clock::time_point timestamp() const { return timestamp_; }
+    uint64_t thread_id() const { return thread_id_; }
+
+    /**
+     * @brief The call site, or nullptr if the record was not logged through a macro
+     */
+    const LogSite* site() const { return site_; }
+
+    /**
+     * @brief The text to log; may differ from the logged message after redaction
+     */
+    std::string_view message() const { return message_; }
+
+    /**
+     * @brief Structured fields of the record; empty if it has none
+     */
+    const Fields& fields() const;
+
+    /**
+     * @brief Trace context of the logging thread; valid() is false without one
+     */
+    const TraceContext& trace() const { return *trace_; }
+
+    /**
+     * @brief Stack of the logging call, or nullptr if none was captured
+     *
+     * Formatters write its frames on the lines after the record's.
+     */
+    const StackTrace* stack() const { return stack_; }
+
+    /**
+     * @brief The record rendered by formatter, computed on first use
+     */
+    const std::string& formatted(const Formatter& formatter) const;
+
+    /**
+     * @brief The fields as JSON members, ,"key":value each, encoded on first use
+     *
+     * Shared like formatted(), so every sink writing JSON appends the
+     * same encoding rather than escaping the fields again.
+     */
+    const std::string& fields_json() const;
+
+private:
+    std::string_view logger_name_;
+    LogLevel level_;
+    std::string_view message_;
+    std::chrono::system_clock::time_point timestamp_;
+    uint64_t thread_id_;
+    const LogSite* site_;
+    const Fields* fields_;
+    const TraceContext* trace_;
+    const StackTrace* stack_;
+    RenderCache* cache_;
+};
+
+/**
+ * @brief Times this thread's formatted() renders into meter while alive (v1.2.0)
+ *
+ * Logger holds one around each sampled sink write, so the format stage
+ * is measured where the sink asks for its line. Lines served from the
+ * RenderCache cost nothing and are not recorded.
+ */
+class FormatTiming {
+public:
+    explicit FormatTiming(SinkMetrics* meter);
+    ~FormatTiming();
+
+    FormatTiming(const FormatTiming&) = delete;
+    FormatTiming& operator=(const FormatTiming&) = delete;
+
+private:
+    SinkMetrics* previous_;
+};
+
+}
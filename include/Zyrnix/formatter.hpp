@@ -1,14 +1,398 @@
 #pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include "log_level.hpp"
+#include "log_site.hpp"
+#include "timestamp_cache.hpp"
+#include "trace_context.hpp"
 
 namespace Zyrnix {
 
+class StackTrace;
+
+/**
+ * @brief Building blocks of Formatter patterns (v1.2.0)
+ *
+ * A pattern is parsed into Items, each a literal run or one flag. The
+ * parser is constexpr, so the same code serves runtime patterns and the
+ * ones compiled by Formatter::compiled().
+ */
+namespace pattern {
+
+enum class Flag : uint8_t {
+    Literal,
+    DateTime,     // %Y-%m-%d %H:%M:%S as one 19-character copy
+    IsoDateTime,  // %Y-%m-%dT%H:%M:%S
+    Year,         // %Y
+    Month,        // %m
+    Day,          // %d
+    Hour,         // %H
+    Minute,       // %M
+    Second,       // %S
+    Millis,       // %e
+    Micros,       // %f
+    Level,        // %l
+    Name,         // %n
+    Message,      // %v
+    Thread,       // %t
+    File,         // %s source file name
+    Path,         // %g source file as compiled
+    Line,         // %#
+    Function,     // %!
+    TraceId,      // %x
+    SpanId        // %y
+};
+
+struct Item {
+    Flag flag;
+    uint32_t offset;  // Literal text as [offset, offset + length) of the pattern
+    uint32_t length;
+};
+
+/**
+ * @brief What the flag writers read from a record
+ */
+struct Context {
+    std::chrono::system_clock::time_point when;
+    std::string_view datetime;  // TimestampCache::local(when), if the pattern has date flags
+    std::string_view logger_name;
+    LogLevel level;
+    std::string_view message;
+    uint64_t thread_id;
+    const LogSite* site;  // nullptr when the record has no call site
+    const TraceContext* trace = nullptr;  // nullptr or !valid() when the record has no trace
+};
+
+constexpr std::string_view datetime_spec = "%Y-%m-%d %H:%M:%S";
+constexpr std::string_view iso_datetime_spec = "%Y-%m-%dT%H:%M:%S";
+
+constexpr Flag flag_for(char c) {
+    switch (c) {
+        case 'Y': return Flag::Year;
+        case 'm': return Flag::Month;
+        case 'd': return Flag::Day;
+        case 'H': return Flag::Hour;
+        case 'M': return Flag::Minute;
+        case 'S': return Flag::Second;
+        case 'e': return Flag::Millis;
+        case 'f': return Flag::Micros;
+        case 'l': return Flag::Level;
+        case 'n': return Flag::Name;
+        case 'v': return Flag::Message;
+        case 't': return Flag::Thread;
+        case 's': return Flag::File;
+        case 'g': return Flag::Path;
+        case '#': return Flag::Line;
+        case '!': return Flag::Function;
+        case 'x': return Flag::TraceId;
+        case 'y': return Flag::SpanId;
+        default: return Flag::Literal;
+    }
+}
+
+constexpr bool is_date_flag(Flag flag) {
+    return flag >= Flag::DateTime && flag <= Flag::Second;
+}
+
+/**
+ * @brief Split text into Items, calling emit for each
+ *
+ * "%%" and unknown flags are kept as literal text; adjacent literals are
+ * merged into one Item.
+ */
+template <class Emit>
+constexpr void parse(std::string_view text, Emit&& emit) {
+    size_t literal_start = 0;
+    size_t literal_end = 0;
+    bool in_literal = false;
+    auto literal = [&](size_t begin, size_t end) {
+        if (in_literal && literal_end == begin) {
+            literal_end = end;
+            return;
+        }
+        if (in_literal) {
+            emit(Item{Flag::Literal, static_cast<uint32_t>(literal_start),
+                      static_cast<uint32_t>(literal_end - literal_start)});
+        }
+        literal_start = begin;
+        literal_end = end;
+        in_literal = true;
+    };
+    auto flag = [&](Flag f) {
+        if (in_literal) {
+            emit(Item{Flag::Literal, static_cast<uint32_t>(literal_start),
+                      static_cast<uint32_t>(literal_end - literal_start)});
+            in_literal = false;
+        }
+        emit(Item{f, 0, 0});
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] != '%' || i + 1 == text.size()) {
+            literal(i, i + 1);
+            ++i;
+            continue;
+        }
+        if (text.substr(i, datetime_spec.size()) == datetime_spec) {
+            flag(Flag::DateTime);
+            i += datetime_spec.size();
+            continue;
+        }
+        if (text.substr(i, iso_datetime_spec.size()) == iso_datetime_spec) {
+            flag(Flag::IsoDateTime);
+            i += iso_datetime_spec.size();
+            continue;
+        }
+        const char c = text[i + 1];
+        const Flag f = flag_for(c);
+        if (f != Flag::Literal) {
+            flag(f);
+        } else if (c == '%') {
+            literal(i + 1, i + 2);
+        } else {
+            literal(i, i + 2);
+        }
+        i += 2;
+    }
+    if (in_literal) {
+        emit(Item{Flag::Literal, static_cast<uint32_t>(literal_start),
+                  static_cast<uint32_t>(literal_end - literal_start)});
+    }
+}
+
+constexpr size_t count_items(std::string_view text) {
+    size_t count = 0;
+    parse(text, [&](const Item&) { ++count; });
+    return count;
+}
+
+constexpr bool uses_datetime(std::string_view text) {
+    bool uses = false;
+    parse(text, [&](const Item& item) { uses = uses || is_date_flag(item.flag); });
+    return uses;
+}
+
+/**
+ * @brief Append the decimal digits of value
+ */
+inline void append_number(std::string& out, uint64_t value) {
+    char buf[20];
+    size_t n = 0;
+    do {
+        buf[sizeof(buf) - ++n] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    out.append(buf + sizeof(buf) - n, n);
+}
+
+/**
+ * @brief Append value as exactly width digits, zero-padded
+ */
+inline void append_padded(std::string& out, uint32_t value, size_t width) {
+    char buf[10];
+    for (size_t i = width; i > 0; --i) {
+        buf[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    out.append(buf, width);
+}
+
+inline uint32_t sub_second_micros(std::chrono::system_clock::time_point when) {
+    const auto since_epoch = when.time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        since_epoch - std::chrono::floor<std::chrono::seconds>(since_epoch)).count());
+}
+
+/**
+ * @brief Append one non-literal item
+ */
+inline void write_flag(std::string& out, Flag flag, const Context& ctx) {
+    switch (flag) {
+        case Flag::DateTime: out.append(ctx.datetime); break;
+        case Flag::IsoDateTime:
+            out.append(ctx.datetime.substr(0, 10));
+            out.push_back('T');
+            out.append(ctx.datetime.substr(11));
+            break;
+        case Flag::Year: out.append(ctx.datetime.substr(0, 4)); break;
+        case Flag::Month: out.append(ctx.datetime.substr(5, 2)); break;
+        case Flag::Day: out.append(ctx.datetime.substr(8, 2)); break;
+        case Flag::Hour: out.append(ctx.datetime.substr(11, 2)); break;
+        case Flag::Minute: out.append(ctx.datetime.substr(14, 2)); break;
+        case Flag::Second: out.append(ctx.datetime.substr(17, 2)); break;
+        case Flag::Millis: append_padded(out, sub_second_micros(ctx.when) / 1000, 3); break;
+        case Flag::Micros: append_padded(out, sub_second_micros(ctx.when), 6); break;
+        case Flag::Level: out.append(level_name(ctx.level)); break;
+        case Flag::Name: out.append(ctx.logger_name); break;
+        case Flag::Message: out.append(ctx.message); break;
+        case Flag::Thread: append_number(out, ctx.thread_id); break;
+        // Records not logged through a macro have no site and leave these empty
+        case Flag::File: out.append(ctx.site ? ctx.site->file_name() : std::string_view()); break;
+        case Flag::Path: out.append(ctx.site ? ctx.site->file : ""); break;
+        case Flag::Line:
+            if (ctx.site) {
+                append_number(out, ctx.site->line);
+            }
+            break;
+        case Flag::Function: out.append(ctx.site ? ctx.site->function : ""); break;
+        case Flag::TraceId:
+            if (ctx.trace && ctx.trace->valid()) {
+                ctx.trace->append_trace_id(out);
+            }
+            break;
+        case Flag::SpanId:
+            if (ctx.trace && ctx.trace->valid()) {
+                ctx.trace->append_span_id(out);
+            }
+            break;
+        case Flag::Literal: break;
+    }
+}
+
+/**
+ * @brief A pattern usable as a template argument, e.g. compiled<"%v">()
+ */
+template <size_t N>
+struct Text {
+    constexpr Text(const char (&s)[N]) {
+        for (size_t i = 0; i < N; ++i) {
+            chars[i] = s[i];
+        }
+    }
+    constexpr std::string_view view() const { return std::string_view(chars, N - 1); }
+
+    char chars[N] = {};
+};
+
+template <Text P>
+struct Compiled {
+    static constexpr size_t size = count_items(P.view());
+
+    static constexpr std::array<Item, size> items = [] {
+        std::array<Item, size> out{};
+        size_t n = 0;
+        parse(P.view(), [&](const Item& item) { out[n++] = item; });
+        return out;
+    }();
+
+    template <size_t I>
+    static void write(std::string& out, const Context& ctx) {
+        constexpr Item item = items[I];
+        if constexpr (item.flag == Flag::Literal) {
+            out.append(P.chars + item.offset, item.length);
+        } else {
+            write_flag(out, item.flag, ctx);
+        }
+    }
+
+    // One call per item with the flag known at compile time, so the
+    // switch in write_flag folds away and the layout is straight-line code
+    template <size_t... I>
+    static void write_all(std::string& out, const Context& ctx, std::index_sequence<I...>) {
+        (write<I>(out, ctx), ...);
+    }
+
+    static void render(std::string& out, const Context& ctx) {
+        write_all(out, ctx, std::make_index_sequence<size>());
+    }
+};
+
+}
+
+/**
+ * @brief Renders records into text according to a pattern (v1.2.0)
+ *
+ * Flags: %Y %m %d %H %M %S (local date and time), %e milliseconds,
+ * %f microseconds, %l level, %n logger name, %v message, %t thread id,
+ * %s source file name, %g source path, %# line, %! function (records
+ * logged through the XLOG_* macros; empty otherwise), %x trace id and
+ * %y span id (hex, from TraceContext; empty without a trace) and %% for
+ * a literal '%'. Anything else is copied as is. The default
+ * is "%Y-%m-%d %H:%M:%S [%l] %n: %v". A record with a stack trace has
+ * its frames on the lines after it, indented by four spaces.
+ *
+ * Runtime patterns are parsed once into a list of flag writers;
+ * compiled<"...">() does the parsing at compile time and renders with
+ * the flags inlined.
+ */
 class Formatter {
 public:
+    static constexpr const char* default_pattern = "%Y-%m-%d %H:%M:%S [%l] %n: %v";
+
+    Formatter();
+    explicit Formatter(std::string pattern);
+
+    /**
+     * @brief Default layout with ".mmm" or ".uuuuuu" after the seconds
+     */
+    explicit Formatter(TimePrecision precision);
+
+    /**
+     * @brief A formatter for a pattern known at compile time
+     */
+    template <pattern::Text P>
+    static Formatter compiled() {
+        Formatter formatter(std::string(P.view()), Precompiled{});
+        formatter.compiled_ = &pattern::Compiled<P>::render;
+        formatter.uses_datetime_ = pattern::uses_datetime(P.view());
+        return formatter;
+    }
+
     std::string format(const std::string& logger_name, LogLevel level, const std::string& message);
+
+    /**
+     * @brief Render a line stamped with the time it was logged (v1.2.0)
+     */
+    std::string format(std::chrono::system_clock::time_point timestamp, std::string_view logger_name,
+                       LogLevel level, std::string_view message) const;
+
+    /**
+     * @brief As above, for a record logged on thread_id from site, under trace (v1.2.0)
+     */
+    std::string format(std::chrono::system_clock::time_point timestamp, std::string_view logger_name,
+                       LogLevel level, std::string_view message, uint64_t thread_id,
+                       const LogSite* site = nullptr, const TraceContext* trace = nullptr) const;
+
+    /**
+     * @brief As above, appending the line to out (v1.2.0)
+     *
+     * For callers that keep a buffer from line to line: once it has grown
+     * to fit, rendering allocates nothing.
+     */
+    void format_to(std::string& out, std::chrono::system_clock::time_point timestamp, std::string_view logger_name,
+                   LogLevel level, std::string_view message, uint64_t thread_id,
+                   const LogSite* site = nullptr, const TraceContext* trace = nullptr,
+                   const StackTrace* stack = nullptr) const;
+
+    /**
+     * @brief The pattern; identifies the output layout (v1.2.0)
+     *
+     * Formatters with equal layouts render a record identically, which is
+     * what lets FormattedRecord share one rendering between sinks.
+     */
+    const std::string& layout() const { return pattern_; }
+
     static std::string redact(const std::string& message, const std::vector<std::string>& patterns);
+
+private:
+    using RenderFn = void (*)(std::string&, const pattern::Context&);
+    struct Precompiled {};
+
+    Formatter(std::string pattern, Precompiled) : pattern_(std::move(pattern)) {}
+
+    void render(std::string& out, const pattern::Context& ctx) const;
+
+    std::string pattern_;
+    std::vector<pattern::Item> items_;  // Unused when compiled_ is set
+    RenderFn compiled_ = nullptr;
+    bool uses_datetime_ = false;
 };
 
 }
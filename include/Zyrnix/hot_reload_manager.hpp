@@ -7,9 +7,24 @@
 #include <chrono>
 #include "Zyrnix/config.hpp"
 #include "Zyrnix/config_watcher.hpp"
+#include "Zyrnix/logger_registry.hpp"
 
 namespace Zyrnix {
 
+/**
+ * @brief Reload loggers from a config file whenever it changes
+ *
+ * Since v1.2.0 loaded loggers are published to LoggerRegistry, replacing
+ * those of the previous load in one swap; get_logger() is a registry
+ * lookup and takes no lock. A LoggerHandle follows the reloads without
+ * looking the name up again.
+ *
+ * A reload is a diff against the running configuration: a logger whose
+ * entry is unchanged is left alone, and one whose level, redaction,
+ * filter or sinks changed is updated in place by
+ * ConfigLoader::reconfigure(). Only a changed async setup, or a logger
+ * new to the file, builds a new Logger.
+ */
 class HotReloadManager {
 public:
     HotReloadManager(const std::string& config_path);
@@ -17,20 +32,31 @@ public:
     void start();
     void stop();
     std::shared_ptr<Logger> get_logger(const std::string& name);
+    LoggerHandle get_handle(const std::string& name);
+    // Everything in LoggerRegistry, including loggers registered elsewhere
     std::map<std::string, std::shared_ptr<Logger>> get_all_loggers();
 
     // Hot-reload metrics (v1.1.3)
     uint64_t reload_success_count() const { return reload_successes_.load(std::memory_order_relaxed); }
     uint64_t reload_failure_count() const { return reload_failures_.load(std::memory_order_relaxed); }
+    // Loggers built from scratch and updated in place by reloads so far (v1.2.0)
+    uint64_t loggers_rebuilt_count() const { return loggers_rebuilt_.load(std::memory_order_relaxed); }
+    uint64_t loggers_updated_count() const { return loggers_updated_.load(std::memory_order_relaxed); }
     std::chrono::system_clock::time_point last_reload_time() const { return last_reload_time_; }
 private:
     void reload();
     std::string config_path_;
-    std::map<std::string, std::shared_ptr<Logger>> loggers_;
+    struct Running {
+        LoggerConfig config;
+        std::shared_ptr<Logger> logger;
+    };
+    std::map<std::string, Running> running_;  // As of the last successful reload
     std::mutex mtx_;
     std::unique_ptr<ConfigWatcher> watcher_;
     std::atomic<uint64_t> reload_successes_{0};
     std::atomic<uint64_t> reload_failures_{0};
+    std::atomic<uint64_t> loggers_rebuilt_{0};
+    std::atomic<uint64_t> loggers_updated_{0};
     std::chrono::system_clock::time_point last_reload_time_{};
 };
 
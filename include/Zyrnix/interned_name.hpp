@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief A logger name stored once for the whole process (v1.2.0)
+ *
+ * intern() returns the same object for the same text every time, so a
+ * name is one pointer wherever it is kept, compares by address and has a
+ * dense id for tables indexed by logger. Names are never freed.
+ */
+struct InternedName {
+    std::string text;
+    uint32_t id;
+
+    static const InternedName& intern(std::string_view name);
+
+    /**
+     * @brief Names interned so far; ids run from 0 to count() - 1
+     */
+    static uint32_t count();
+};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief JSON string escaping for the JSON sinks and tools (v1.2.0)
+ *
+ * Quotes, backslashes and control characters are escaped; everything
+ * else, including UTF-8 sequences, is copied as it is. The search for
+ * the next byte to escape looks at 32 bytes at a time with AVX2, 16 with
+ * SSE2 or NEON, and the clean run before it is appended in one go.
+ */
+namespace json {
+
+/**
+ * @brief Append text, escaped, without quotes
+ */
+void append_escaped(std::string& out, std::string_view text);
+
+/**
+ * @brief Append text as a quoted JSON string
+ */
+inline void append_string(std::string& out, std::string_view text) {
+    out.push_back('"');
+    append_escaped(out, text);
+    out.push_back('"');
+}
+
+/**
+ * @brief Offset of the first byte of text that needs escaping, or its size
+ */
+size_t find_escape(std::string_view text);
+
+/**
+ * @brief The kernel find_escape() uses: "avx2", "sse2", "neon" or "scalar"
+ */
+const char* escape_kernel_name();
+
+}
+
+}
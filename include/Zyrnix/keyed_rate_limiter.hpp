@@ -0,0 +1,92 @@
+#pragma once
+#include "Zyrnix_features.hpp"
+#include "log_filter.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+class LimiterMetrics;
+
+struct KeyedRateLimiterOptions {
+    enum class KeyBy {
+        Site,     // Call site; for the XLOG_* macros, one format string each
+        Message,  // Message text
+        Field     // Value of field; records without it are not limited
+    };
+
+    KeyBy key_by = KeyBy::Site;
+    std::string field;
+
+    // Per key, as in RateLimiter
+    size_t messages_per_second = 10;
+    size_t burst_capacity = 0;  // 0 for messages_per_second
+
+    // Keys tracked at once, rounded up to a power of two (at least 8).
+    // A new key takes the place of one not seen lately in its group of 8.
+    size_t capacity = 4096;
+
+    // Name under MetricsRegistry::get_limiter_metrics(); empty for no metrics
+    std::string metrics_name;
+};
+
+/**
+ * @brief Rate limits each key separately, in memory fixed at construction (v1.2.0)
+ *
+ * A noisy tenant or a repeating error template only uses up its own
+ * bucket. Keys hash into a set-associative table of token buckets, each
+ * the single CAS word RateLimiter uses, and a clock sweep picks which
+ * of a group's 8 keys to evict, so millions of distinct keys cost no more
+ * memory than capacity. A key evicted and seen again starts with a full
+ * bucket. Checks are lock-free; a racing eviction can hand a bucket's
+ * state to the new key, so limits are approximate under heavy churn.
+ *
+ * As a LogFilter it decides in stage one. The top offenders are reported
+ * through MetricsRegistry when metrics_name is set.
+ */
+class KeyedRateLimiter : public LogFilter {
+public:
+    explicit KeyedRateLimiter(const KeyedRateLimiterOptions& options = KeyedRateLimiterOptions{});
+    ~KeyedRateLimiter() override;
+
+    KeyedRateLimiter(const KeyedRateLimiter&) = delete;
+    KeyedRateLimiter& operator=(const KeyedRateLimiter&) = delete;
+
+    FilterVerdict prefilter(const RecordView& view) const override;
+    bool should_log(const LogRecord& record) const override;
+
+    /**
+     * @brief Take a token for key
+     */
+    bool try_log(std::string_view key) const;
+
+    uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return slot_count_; }
+
+    std::shared_ptr<LimiterMetrics> metrics() const { return metrics_; }
+
+private:
+    struct Slot;
+
+    bool admit(uint64_t hash, const RecordView* view, std::string_view key) const;
+    Slot* find_or_claim(uint64_t hash) const;
+    void report(const RecordView* view, std::string_view key, uint64_t dropped) const;
+    uint64_t now_ticks() const;
+
+    KeyedRateLimiterOptions options_;
+    uint64_t interval_;
+    uint64_t tolerance_;
+    uint64_t epoch_ns_;
+    size_t slot_count_;
+    size_t set_mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<std::atomic<uint8_t>[]> hands_;  // Clock hand per group
+    std::shared_ptr<LimiterMetrics> metrics_;
+    mutable std::atomic<uint64_t> dropped_{0};
+};
+
+}
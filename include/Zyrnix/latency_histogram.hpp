@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Lock-free log-bucketed latency histogram in nanoseconds (v1.2.0)
+ *
+ * HDR-style buckets: values below 32 ns are counted exactly, and each
+ * power of two above is split into 16 buckets, so a recorded value is
+ * known to within 1/16 (6.25%) from 1 ns up to about 4.9 hours; longer
+ * values land in the last bucket. record() is a few relaxed atomic adds
+ * and never waits. The whole histogram is about 5 KiB.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 4;
+    static constexpr uint64_t sub_buckets = uint64_t{1} << sub_bucket_bits;
+    static constexpr unsigned max_exponent = 43;
+    static constexpr size_t bucket_count = (max_exponent - sub_bucket_bits) * sub_buckets + 2 * sub_buckets;
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+
+        /**
+         * @brief Highest value in the bucket holding the q-th quantile, 0 when empty
+         */
+        uint64_t percentile(double q) const;
+
+        /**
+         * @brief Recorded values no greater than limit_ns, counting whole buckets
+         */
+        uint64_t count_at_most(uint64_t limit_ns) const;
+    };
+
+    void record(uint64_t nanoseconds) {
+        buckets_[bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+        uint64_t current = max_.load(std::memory_order_relaxed);
+        while (nanoseconds > current &&
+               !max_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Copy of the counts; concurrent records may be split across fields
+     */
+    Snapshot snapshot() const;
+    void reset();
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < 2 * sub_buckets) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+        if (exponent > max_exponent) {
+            return bucket_count - 1;
+        }
+        const unsigned shift = exponent - sub_bucket_bits;
+        return static_cast<size_t>(shift * sub_buckets + (value >> shift));
+    }
+
+    // Largest value counted in bucket index
+    static uint64_t bucket_upper_bound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+}
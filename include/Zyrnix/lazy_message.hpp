@@ -0,0 +1,65 @@
+#pragma once
+#include <concepts>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace Zyrnix {
+
+/**
+ * @brief A callable that builds a message, for the XLOG_*_LAZY macros (v1.2.0)
+ *
+ * Called only once the record is known to be logged, and may return
+ * anything a std::string_view can be made from.
+ */
+template <class F>
+concept LazyMessage = std::invocable<F&> &&
+                      std::convertible_to<std::invoke_result_t<F&>, std::string_view>;
+
+/**
+ * @brief A LazyMessage that may run on an async logger's consumer thread (v1.2.0)
+ *
+ * Made by deferrable(). Its bytes are copied into the queued record and
+ * the consumer calls it there, so it must capture only values: a
+ * reference or pointer capture would be read after the caller has moved
+ * on. Trivially copyable closures only, which rules out capturing a
+ * std::string by value (capture a string_view to a literal, or let the
+ * caller build the message). Synchronous loggers call it at once.
+ */
+template <class F>
+struct Deferrable {
+    F fn;
+};
+
+template <class F>
+inline constexpr bool is_deferrable_v = false;
+template <class F>
+inline constexpr bool is_deferrable_v<Deferrable<F>> = true;
+
+/**
+ * @brief Mark make as safe to run on the consumer thread
+ *
+ *     XLOG_DEBUG_LAZY(logger, Zyrnix::deferrable([=] { return render(id, total); }));
+ */
+template <class F>
+Deferrable<std::decay_t<F>> deferrable(F&& make) {
+    static_assert(std::is_trivially_copyable_v<std::decay_t<F>>,
+                  "deferrable() copies the closure byte for byte: capture trivially copyable values only");
+    static_assert(LazyMessage<std::decay_t<F>>, "deferrable() takes a callable returning the message");
+    return Deferrable<std::decay_t<F>>{std::forward<F>(make)};
+}
+
+/**
+ * @brief Call make, unwrapping a Deferrable
+ */
+template <class F>
+decltype(auto) build_lazy(F& make) {
+    if constexpr (is_deferrable_v<std::remove_const_t<F>>) {
+        return std::invoke(make.fn);
+    } else {
+        return std::invoke(make);
+    }
+}
+
+}
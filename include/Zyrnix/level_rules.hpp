@@ -0,0 +1,58 @@
+#pragma once
+#include "log_level.hpp"
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Levels for logger names matching dotted patterns (v1.2.0)
+ *
+ * A pattern is a logger name whose segments may be "*": in the middle it
+ * stands for one segment, at the end for one or more, so "db.*" covers
+ * "db.pool" and "db.pool.conn" but not "db" itself, and "*" covers every
+ * name. Patterns are compiled into a trie of segments. When several match,
+ * the one whose first wildcard comes latest wins, so "db.pool" beats
+ * "db.*", which beats "*.pool", which beats "*".
+ *
+ * Rules are matched when a logger is registered or a child is made, and
+ * the level is stored in the logger, so logging never matches patterns.
+ */
+class LevelRules {
+public:
+    /**
+     * @brief Add or replace the rule for pattern; false if a segment is empty
+     */
+    bool add(std::string_view pattern, LogLevel level);
+
+    std::optional<LogLevel> match(std::string_view name) const;
+
+    bool empty() const { return patterns_.empty(); }
+    size_t size() const { return patterns_.size(); }
+    const std::map<std::string, LogLevel>& patterns() const { return patterns_; }
+
+    bool operator==(const LevelRules& other) const { return patterns_ == other.patterns_; }
+
+private:
+    static constexpr uint32_t none = UINT32_MAX;
+    static constexpr uint8_t unset = 0xFF;
+
+    struct Node {
+        std::map<std::string, uint32_t, std::less<>> children;
+        uint32_t star = none;
+        uint8_t exact = unset;    // A pattern ends here
+        uint8_t subtree = unset;  // A pattern ends here with a trailing "*"
+    };
+
+    void match(uint32_t node, const std::vector<std::string_view>& segments, size_t depth, uint64_t literals,
+               uint64_t& best, uint8_t& level) const;
+
+    std::vector<Node> nodes_{1};
+    std::map<std::string, LogLevel> patterns_;
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "timestamp_cache.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Zyrnix {
+
+/**
+ * @brief Where record timestamps are read from (v1.2.0)
+ */
+enum class ClockSource : uint8_t {
+    Precise,  // system_clock::now()
+    Coarse,   // CLOCK_REALTIME_COARSE: a few ms resolution, the cheapest read there is
+    Tsc       // CycleClock ticks mapped onto wall time; needs an invariant TSC
+};
+
+/**
+ * @brief The clock every record is stamped with, once, where it is logged (v1.2.0)
+ *
+ * Logger, ChildLogger and StaticLogger read it once per record into
+ * LogRecord::timestamp (or the FormattedRecord), and sinks and patterns
+ * use that stamp, so every sink reports the same time for a record.
+ *
+ * Tsc reads one rdtsc and maps it onto the wall clock with a multiply
+ * and an add, from an anchor (ticks, system_clock) re-taken about once a
+ * second by whichever logging thread finds it stale; a step of the wall
+ * clock shows up by then, or at once after resync(). Records from
+ * different threads can come out of order by the TSC's skew between
+ * cores, a few ns. Without an invariant TSC, set_source(Tsc) selects
+ * Precise, and without a coarse clock Coarse does too.
+ *
+ *     Zyrnix::LogClock::set_source(Zyrnix::ClockSource::Tsc);
+ *
+ * Process-wide, and meant to be set at start-up.
+ */
+class LogClock {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+
+    static time_point now() {
+        switch (source_.load(std::memory_order_relaxed)) {
+            case ClockSource::Coarse:
+                return time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::nanoseconds(realtime_coarse_ns())));
+            case ClockSource::Tsc: return tsc_now();
+            case ClockSource::Precise: break;
+        }
+        return std::chrono::system_clock::now();
+    }
+
+    static void set_source(ClockSource source);
+
+    /**
+     * @brief The source in effect, after any fallback
+     */
+    static ClockSource source() { return source_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Re-anchor the Tsc mapping now, e.g. after the wall clock was set
+     */
+    static void resync();
+
+private:
+    static time_point tsc_now();
+
+    static std::atomic<ClockSource> source_;
+};
+
+}
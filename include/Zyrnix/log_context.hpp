@@ -20,8 +20,34 @@ public:
     static ContextMap get_all();
     static bool contains(const std::string& key);
 
+    /**
+     * @brief The calling thread's value for key without copying it, or
+     *        nullptr (v1.2.0)
+     *
+     * Valid until the context is next changed on this thread.
+     */
+    static const std::string* find(const std::string& key);
+
+    /**
+     * @brief The calling thread's context without copying it (v1.2.0)
+     *
+     * Valid until the context is next changed on this thread.
+     */
+    static const ContextMap& current();
+
+    /**
+     * @brief The calling thread's context as JSON members (v1.2.0)
+     *
+     * ,"key":"value" for each entry, escaped once and kept until the
+     * context next changes, so JSON sinks append it in one copy. Valid
+     * until the context is next changed on this thread.
+     */
+    static const std::string& json_fragment();
+
 private:
     static thread_local ContextMap context_;
+    static thread_local std::string json_;
+    static thread_local bool json_stale_;
 };
 
 class ScopedContext {
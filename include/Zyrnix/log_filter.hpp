@@ -6,20 +6,62 @@
 #include <atomic>
 #include <unordered_map>
 #include <mutex>
+#include <string_view>
+#include <vector>
 #include "log_level.hpp"
 #include "log_record.hpp"
 
 namespace Zyrnix {
 
+/**
+ * @brief A record as stage-one filters see it, before it is built (v1.2.0)
+ *
+ * Views of the caller's strings, so making one allocates nothing.
+ * field() looks in the record's fields when it has any (records built
+ * for stage two or taken off the async queue), then in the calling
+ * thread's LogContext.
+ */
+struct RecordView {
+    std::string_view logger_name;
+    LogLevel level;
+    std::string_view message;
+    const LogSite* site = nullptr;
+    const FieldList* fields = nullptr;
+
+    RecordView(std::string_view logger_name, LogLevel level, std::string_view message, const LogSite* site);
+    explicit RecordView(const LogRecord& record);
+
+    const std::string* field(const std::string& key) const;
+};
+
+enum class FilterVerdict {
+    Reject,
+    Accept,
+    Undecided  // Needs the full LogRecord
+};
+
 class LogFilter {
 public:
     virtual ~LogFilter() = default;
+
+    /**
+     * @brief Stage one: decide from a view of the record (v1.2.0)
+     *
+     * Logger asks every filter this first, and only builds a LogRecord
+     * (with the caller's context fields merged in) for records no filter
+     * rejected here. It then calls should_log() on the filters that
+     * returned Undecided, which is the default. Override it for checks
+     * that are cheap and need nothing beyond the view.
+     */
+    virtual FilterVerdict prefilter(const RecordView&) const { return FilterVerdict::Undecided; }
+
     virtual bool should_log(const LogRecord& record) const = 0;
 };
 
 class LevelFilter : public LogFilter {
 public:
     explicit LevelFilter(LogLevel min_level);
+    FilterVerdict prefilter(const RecordView& view) const override;
     bool should_log(const LogRecord& record) const override;
 
 private:
@@ -29,6 +71,7 @@ private:
 class FieldFilter : public LogFilter {
 public:
     FieldFilter(const std::string& field_name, const std::string& expected_value);
+    FilterVerdict prefilter(const RecordView& view) const override;
     bool should_log(const LogRecord& record) const override;
 
 private:
@@ -36,6 +79,23 @@ private:
     std::string expected_value_;
 };
 
+/**
+ * @brief Keeps records logged from matching call sites (v1.2.0)
+ *
+ * Globs on file and function as in SiteRegistry. Records that were not
+ * logged through an XLOG_* macro have no site and are dropped.
+ */
+class SiteFilter : public LogFilter {
+public:
+    explicit SiteFilter(std::string file_glob, std::string function_glob = "*");
+    FilterVerdict prefilter(const RecordView& view) const override;
+    bool should_log(const LogRecord& record) const override;
+
+private:
+    std::string file_glob_;
+    std::string function_glob_;
+};
+
 class LambdaFilter : public LogFilter {
 public:
     using FilterFunc = std::function<bool(const LogRecord&)>;
@@ -52,6 +112,7 @@ public:
     
     CompositeFilter(Mode mode);
     void add_filter(std::shared_ptr<LogFilter> filter);
+    FilterVerdict prefilter(const RecordView& view) const override;
     bool should_log(const LogRecord& record) const override;
 
 private:
@@ -70,12 +131,25 @@ struct FilterStats {
     }
 };
 
+/**
+ * @brief Regular expression engine behind a RegexFilter (v1.2.0)
+ */
+enum class RegexEngine {
+    Std,  // std::regex, ECMAScript syntax
+    RE2   // Linear time in the input, no backtracking; needs XLOG_HAS_RE2
+};
+
 struct RegexFilterOptions {
     bool case_insensitive = false;
     bool invert = false;
     bool track_stats = true;
+    // RE2 falls back to Std when the library is built without RE2 or
+    // the pattern needs something RE2 lacks, such as backreferences
+    RegexEngine engine = RegexEngine::Std;
 };
 
+class CompiledRegex;
+
 class RegexFilter : public LogFilter {
 public:
     explicit RegexFilter(const std::string& pattern, bool invert = false);
@@ -85,18 +159,24 @@ public:
     RegexFilter(const std::string& pattern, const RegexFilterOptions& options);
     RegexFilter(const std::string& field_name, const std::string& pattern, const RegexFilterOptions& options);
     
+    FilterVerdict prefilter(const RecordView& view) const override;
     bool should_log(const LogRecord& record) const override;
     
     std::string pattern() const { return pattern_str_; }
     bool is_case_insensitive() const { return case_insensitive_; }
     bool is_inverted() const { return invert_; }
+
+    /**
+     * @brief The engine in use, which may differ from the one requested
+     */
+    RegexEngine engine() const;
     
     FilterStats get_stats() const;
     void reset_stats();
     
 private:
     std::string pattern_str_;
-    std::regex regex_;
+    std::shared_ptr<const CompiledRegex> regex_;
     std::string field_name_;  
     bool invert_;
     bool case_insensitive_;
@@ -106,6 +186,43 @@ private:
     mutable std::atomic<uint64_t> miss_count_{0};
     
     void update_stats(bool matched) const;
+    bool decide(const RecordView& view) const;
+};
+
+/**
+ * @brief Keeps records matching any of a set of patterns, in one pass (v1.2.0)
+ *
+ * Where twenty RegexFilters in an OR scan each message twenty times, the
+ * set scans it once: with RE2 as an RE2::Set, otherwise as a single
+ * std::regex alternation. invert drops records matching any pattern.
+ */
+class RegexSetFilter : public LogFilter {
+public:
+    explicit RegexSetFilter(const std::vector<std::string>& patterns,
+                            const RegexFilterOptions& options = RegexFilterOptions{});
+    RegexSetFilter(const std::string& field_name, const std::vector<std::string>& patterns,
+                   const RegexFilterOptions& options = RegexFilterOptions{});
+
+    FilterVerdict prefilter(const RecordView& view) const override;
+    bool should_log(const LogRecord& record) const override;
+
+    const std::vector<std::string>& patterns() const { return patterns_; }
+    RegexEngine engine() const;
+
+    FilterStats get_stats() const;
+    void reset_stats();
+
+private:
+    std::vector<std::string> patterns_;
+    std::shared_ptr<const CompiledRegex> regex_;
+    std::string field_name_;
+    bool invert_;
+    bool track_stats_;
+
+    mutable std::atomic<uint64_t> match_count_{0};
+    mutable std::atomic<uint64_t> miss_count_{0};
+
+    bool decide(const RecordView& view) const;
 };
 
 class RegexFilterCache {
@@ -125,6 +242,18 @@ public:
                    const RegexFilterOptions& options = RegexFilterOptions{});
     
     std::shared_ptr<RegexFilter> get_precompiled(const std::string& name) const;
+
+    /**
+     * @brief A shared RegexSetFilter for this pattern list (v1.2.0)
+     */
+    std::shared_ptr<RegexSetFilter> get_or_create_set(
+        const std::vector<std::string>& patterns,
+        const RegexFilterOptions& options = RegexFilterOptions{});
+
+    std::shared_ptr<RegexSetFilter> get_or_create_set(
+        const std::string& field_name,
+        const std::vector<std::string>& patterns,
+        const RegexFilterOptions& options = RegexFilterOptions{});
     
     void clear();
     
@@ -138,6 +267,7 @@ private:
     mutable std::mutex mutex_;
     std::unordered_map<std::string, std::shared_ptr<RegexFilter>> cache_;
     std::unordered_map<std::string, std::shared_ptr<RegexFilter>> precompiled_;
+    std::unordered_map<std::string, std::shared_ptr<RegexSetFilter>> sets_;
     mutable std::atomic<size_t> cache_hits_{0};
     mutable std::atomic<size_t> cache_misses_{0};
     
@@ -145,4 +275,53 @@ private:
                                const RegexFilterOptions& options) const;
 };
 
+/**
+ * @brief A filter written as an expression, e.g. in a config file (v1.2.0)
+ *
+ *     level >= warn && field.tenant == "acme" && msg ~ /timeout/
+ *
+ * Operands are level (compared by severity with == != < <= > >= against
+ * trace, debug, info, warn, error or critical), msg, logger and
+ * field.<name> (compared with == and != against a "string", or with ~
+ * and !~ against a /regex/, /regex/i for case-insensitive). A bare
+ * field.<name> tests that the field is set; a missing field otherwise
+ * compares as empty, as in FieldFilter. Terms combine with &&, || and !,
+ * with parentheses and true/false as usual.
+ *
+ * The expression is compiled once into a flat list of instructions with
+ * jumps for short-circuiting, so evaluating it makes no virtual calls
+ * and no allocations. Regexes use RE2 when available. Everything it
+ * reads is in the RecordView, so it always decides in stage one.
+ */
+class ExpressionFilter : public LogFilter {
+public:
+    /**
+     * @brief Compile text into a filter
+     * @return nullptr if it does not parse, with the reason in *error
+     */
+    static std::shared_ptr<ExpressionFilter> compile(const std::string& text, std::string* error = nullptr);
+
+    ~ExpressionFilter() override;
+
+    FilterVerdict prefilter(const RecordView& view) const override;
+    bool should_log(const LogRecord& record) const override;
+
+    bool evaluate(const RecordView& view) const;
+
+    const std::string& expression() const { return text_; }
+
+private:
+    struct Instruction;
+    class Compiler;
+
+    ExpressionFilter();
+
+    std::string_view text(const RecordView& view, const Instruction& in) const;
+
+    std::string text_;
+    std::vector<Instruction> code_;
+    std::vector<std::string> strings_;  // Field names and literals
+    std::vector<std::shared_ptr<const CompiledRegex>> regexes_;
+};
+
 } 
\ No newline at end of file
@@ -2,12 +2,17 @@
 #include "Zyrnix_features.hpp"
 #include "log_level.hpp"
 #include "log_metrics.hpp"
+#include "rcu.hpp"
 #include <string>
 #include <memory>
 #include <chrono>
 #include <map>
 #include <functional>
 #include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
 
 namespace Zyrnix {
 
@@ -176,9 +181,44 @@ public:
     static bool is_auto_registration_enabled();
     
     static void auto_register(const std::string& name, std::shared_ptr<Logger> logger);
+
+    /**
+     * @brief Evaluate every logger on a background thread each interval (v1.2.0)
+     *
+     * Each tick publishes an immutable snapshot: the aggregate result and
+     * the JSON for the registry and for each logger, rendered once. Until
+     * stop_background_evaluation(), export_json(), get_overall_status(),
+     * check_all_aggregate() and health_json() read that snapshot without
+     * taking the registry's mutex, and state-change callbacks fire from
+     * the ticker, which they must not stop. Calling it again only changes
+     * the interval. check_logger() and check_all() still evaluate on demand.
+     */
+    void start_background_evaluation(std::chrono::milliseconds interval = std::chrono::seconds(1));
+    void stop_background_evaluation();
+    bool background_evaluation_running() const;
+
+    /**
+     * @brief Evaluate now and publish the snapshot, as a tick does (v1.2.0)
+     */
+    void evaluate_now();
+
+    /**
+     * @brief JSON for logger_name, or for the whole registry if empty (v1.2.0)
+     *
+     * From the latest snapshot when there is one; otherwise, and for a
+     * name the snapshot does not have, evaluated on demand.
+     */
+    std::string health_json(const std::string& logger_name = "") const;
     
 private:
     HealthRegistry() : health_checker_(std::make_shared<HealthChecker>()) {}
+
+    // What a tick publishes; never changed once published
+    struct HealthSnapshot {
+        AggregateHealthResult aggregate;
+        std::string json;
+        std::unordered_map<std::string, std::string> logger_json;
+    };
     
     struct LoggerEntry {
         std::weak_ptr<Logger> logger;
@@ -194,23 +234,23 @@ private:
     mutable std::mutex mutex_;
     
     static std::atomic<bool> auto_registration_enabled_;
+
+    RcuPtr<HealthSnapshot> snapshot_;
+    std::mutex evaluate_mutex_;  // One evaluation publishes at a time
+    std::thread ticker_;
+    mutable std::mutex tick_mutex_;
+    std::condition_variable tick_cv_;
+    std::chrono::milliseconds interval_{1000};
+    bool stopping_ = false;
     
     void notify_state_change(const std::string& name, HealthStatus old_status,
                             HealthStatus new_status, const HealthCheckResult& result);
+    void run_ticker();
 };
 
 
 inline std::string handle_health_check_request(const std::string& logger_name = "") {
-    auto& registry = HealthRegistry::instance();
-    
-    if (logger_name.empty()) {
-      
-        return registry.export_json();
-    } else {
-   
-        auto result = registry.check_logger(logger_name);
-        return result.to_json();
-    }
+    return HealthRegistry::instance().health_json(logger_name);
 }
 
 inline AggregateHealthResult handle_aggregate_health_check() {
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 namespace Zyrnix {
 
@@ -12,7 +13,10 @@ enum class LogLevel {
     Critical
 };
 
-inline std::string to_string(LogLevel lvl) {
+/**
+ * @brief Level name as a view of a static string (v1.2.0)
+ */
+constexpr std::string_view level_name(LogLevel lvl) {
     switch (lvl) {
         case LogLevel::Trace: return "TRACE";
         case LogLevel::Debug: return "DEBUG";
@@ -24,4 +28,8 @@ inline std::string to_string(LogLevel lvl) {
     }
 }
 
+inline std::string to_string(LogLevel lvl) {
+    return std::string(level_name(lvl));
+}
+
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "logger.hpp"
 #include "log_level.hpp"
+#include "log_site.hpp"
+#include "rate_limiter.hpp"
 
 #ifndef XLOG_ACTIVE_LEVEL
     #ifdef NDEBUG
@@ -11,65 +13,297 @@
 #endif
 
 #define XLOG_LEVEL_ENABLED(logger, level) \
-    ((int)(level) >= XLOG_ACTIVE_LEVEL && (logger)->get_level() <= (level))
+    ((int)(level) >= XLOG_ACTIVE_LEVEL && (logger)->get_effective_level() <= (level))
 
-#define XLOG_LOG_IF(logger, level, condition, message) \
+// The message may be a format string followed by its arguments when
+// XLOG_HAS_FMT is set, e.g. XLOG_INFO(logger, "took {} ms", ms) (v1.2.0)
+//
+// Each expansion describes its call site once, in a static constexpr
+// LogSite the records point at, so file, line and function cost nothing
+// at run time. This makes the macros statements rather than expressions.
+// The site's SiteSwitch lets SiteRegistry turn it on below the logger's
+// level. The level is checked before the arguments are evaluated, so a
+// disabled XLOG_DEBUG(logger, "state=" + dump_state()) never calls
+// dump_state().
+#define XLOG_DECLARE_SITE_(level) \
+    static constinit ::Zyrnix::SiteSwitch xlog_switch_; \
+    static constexpr ::Zyrnix::LogSite xlog_site_ = ::Zyrnix::LogSite::here(level, &xlog_switch_)
+
+#define XLOG_SITE_ENABLED_(logger, level) (XLOG_LEVEL_ENABLED(logger, level) || xlog_site_.forced())
+
+#define XLOG_LOG_AT(logger, level, ...) \
+    do { \
+        XLOG_DECLARE_SITE_(level); \
+        if (XLOG_SITE_ENABLED_(logger, level)) { \
+            (logger)->log(xlog_site_, __VA_ARGS__); \
+        } \
+    } while(0)
+
+#define XLOG_LOG_IF(logger, level, condition, ...) \
     do { \
-        if (XLOG_LEVEL_ENABLED(logger, level) && (condition)) { \
-            (logger)->log(level, message); \
+        XLOG_DECLARE_SITE_(level); \
+        if (XLOG_SITE_ENABLED_(logger, level) && (condition)) { \
+            (logger)->log(xlog_site_, __VA_ARGS__); \
         } \
     } while(0)
 
-#define XLOG_TRACE_IF(logger, condition, message) \
-    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Trace, condition, message)
+#define XLOG_TRACE_IF(logger, condition, ...) \
+    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Trace, condition, __VA_ARGS__)
 
-#define XLOG_DEBUG_IF(logger, condition, message) \
-    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Debug, condition, message)
+#define XLOG_DEBUG_IF(logger, condition, ...) \
+    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Debug, condition, __VA_ARGS__)
 
-#define XLOG_INFO_IF(logger, condition, message) \
-    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Info, condition, message)
+#define XLOG_INFO_IF(logger, condition, ...) \
+    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Info, condition, __VA_ARGS__)
 
-#define XLOG_WARN_IF(logger, condition, message) \
-    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Warn, condition, message)
+#define XLOG_WARN_IF(logger, condition, ...) \
+    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Warn, condition, __VA_ARGS__)
 
-#define XLOG_ERROR_IF(logger, condition, message) \
-    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Error, condition, message)
+#define XLOG_ERROR_IF(logger, condition, ...) \
+    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Error, condition, __VA_ARGS__)
 
-#define XLOG_CRITICAL_IF(logger, condition, message) \
-    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Critical, condition, message)
+#define XLOG_CRITICAL_IF(logger, condition, ...) \
+    XLOG_LOG_IF(logger, ::Zyrnix::LogLevel::Critical, condition, __VA_ARGS__)
+
+// Rate-limited logging (v1.2.0): each expansion keeps its own limit
+// state, so the check is a relaxed atomic on a counter only that site
+// uses. The next line let through ends in " [N suppressed]", and held
+// back calls count as filtered in the logger's LogMetrics. Only calls
+// whose level is enabled reach the limit.
+// XLOG_INFO_EVERY_N(logger, 1000, "cache miss for {}", key);
+// XLOG_WARN_EVERY_MS(logger, 500, "queue above high water mark");
+// XLOG_ERROR_FIRST_N(logger, 10, "config key {} is deprecated", name);
+#define XLOG_LOG_LIMITED_(logger, level, limit_type, limit, ...) \
+    do { \
+        XLOG_DECLARE_SITE_(level); \
+        static constinit limit_type xlog_limit_; \
+        if (XLOG_SITE_ENABLED_(logger, level)) { \
+            const ::Zyrnix::LimitDecision xlog_decision_ = xlog_limit_.admit(limit); \
+            if (xlog_decision_.emit) { \
+                (logger)->log_limited(xlog_site_, xlog_decision_.suppressed, __VA_ARGS__); \
+            } else if (xlog_decision_.suppressed > 0) { \
+                (logger)->record_suppressed(xlog_decision_.suppressed); \
+            } \
+        } \
+    } while(0)
+
+#define XLOG_LOG_EVERY_N(logger, level, n, ...) \
+    XLOG_LOG_LIMITED_(logger, level, ::Zyrnix::EveryNLimit, n, __VA_ARGS__)
+#define XLOG_LOG_EVERY_MS(logger, level, period_ms, ...) \
+    XLOG_LOG_LIMITED_(logger, level, ::Zyrnix::EveryMsLimit, period_ms, __VA_ARGS__)
+#define XLOG_LOG_FIRST_N(logger, level, n, ...) \
+    XLOG_LOG_LIMITED_(logger, level, ::Zyrnix::FirstNLimit, n, __VA_ARGS__)
 
 #if XLOG_ACTIVE_LEVEL <= 0
-    #define XLOG_TRACE(logger, message) (logger)->log(::Zyrnix::LogLevel::Trace, message)
+    #define XLOG_TRACE_EVERY_N(logger, n, ...) XLOG_LOG_EVERY_N(logger, ::Zyrnix::LogLevel::Trace, n, __VA_ARGS__)
+    #define XLOG_TRACE_EVERY_MS(logger, period_ms, ...) \
+        XLOG_LOG_EVERY_MS(logger, ::Zyrnix::LogLevel::Trace, period_ms, __VA_ARGS__)
+    #define XLOG_TRACE_FIRST_N(logger, n, ...) XLOG_LOG_FIRST_N(logger, ::Zyrnix::LogLevel::Trace, n, __VA_ARGS__)
 #else
-    #define XLOG_TRACE(logger, message) ((void)0)
+    #define XLOG_TRACE_EVERY_N(logger, n, ...) ((void)0)
+    #define XLOG_TRACE_EVERY_MS(logger, period_ms, ...) ((void)0)
+    #define XLOG_TRACE_FIRST_N(logger, n, ...) ((void)0)
 #endif
 
 #if XLOG_ACTIVE_LEVEL <= 1
-    #define XLOG_DEBUG(logger, message) (logger)->log(::Zyrnix::LogLevel::Debug, message)
+    #define XLOG_DEBUG_EVERY_N(logger, n, ...) XLOG_LOG_EVERY_N(logger, ::Zyrnix::LogLevel::Debug, n, __VA_ARGS__)
+    #define XLOG_DEBUG_EVERY_MS(logger, period_ms, ...) \
+        XLOG_LOG_EVERY_MS(logger, ::Zyrnix::LogLevel::Debug, period_ms, __VA_ARGS__)
+    #define XLOG_DEBUG_FIRST_N(logger, n, ...) XLOG_LOG_FIRST_N(logger, ::Zyrnix::LogLevel::Debug, n, __VA_ARGS__)
 #else
-    #define XLOG_DEBUG(logger, message) ((void)0)
+    #define XLOG_DEBUG_EVERY_N(logger, n, ...) ((void)0)
+    #define XLOG_DEBUG_EVERY_MS(logger, period_ms, ...) ((void)0)
+    #define XLOG_DEBUG_FIRST_N(logger, n, ...) ((void)0)
 #endif
 
 #if XLOG_ACTIVE_LEVEL <= 2
-    #define XLOG_INFO(logger, message) (logger)->log(::Zyrnix::LogLevel::Info, message)
+    #define XLOG_INFO_EVERY_N(logger, n, ...) XLOG_LOG_EVERY_N(logger, ::Zyrnix::LogLevel::Info, n, __VA_ARGS__)
+    #define XLOG_INFO_EVERY_MS(logger, period_ms, ...) \
+        XLOG_LOG_EVERY_MS(logger, ::Zyrnix::LogLevel::Info, period_ms, __VA_ARGS__)
+    #define XLOG_INFO_FIRST_N(logger, n, ...) XLOG_LOG_FIRST_N(logger, ::Zyrnix::LogLevel::Info, n, __VA_ARGS__)
 #else
-    #define XLOG_INFO(logger, message) ((void)0)
+    #define XLOG_INFO_EVERY_N(logger, n, ...) ((void)0)
+    #define XLOG_INFO_EVERY_MS(logger, period_ms, ...) ((void)0)
+    #define XLOG_INFO_FIRST_N(logger, n, ...) ((void)0)
 #endif
 
 #if XLOG_ACTIVE_LEVEL <= 3
-    #define XLOG_WARN(logger, message) (logger)->log(::Zyrnix::LogLevel::Warn, message)
+    #define XLOG_WARN_EVERY_N(logger, n, ...) XLOG_LOG_EVERY_N(logger, ::Zyrnix::LogLevel::Warn, n, __VA_ARGS__)
+    #define XLOG_WARN_EVERY_MS(logger, period_ms, ...) \
+        XLOG_LOG_EVERY_MS(logger, ::Zyrnix::LogLevel::Warn, period_ms, __VA_ARGS__)
+    #define XLOG_WARN_FIRST_N(logger, n, ...) XLOG_LOG_FIRST_N(logger, ::Zyrnix::LogLevel::Warn, n, __VA_ARGS__)
 #else
-    #define XLOG_WARN(logger, message) ((void)0)
+    #define XLOG_WARN_EVERY_N(logger, n, ...) ((void)0)
+    #define XLOG_WARN_EVERY_MS(logger, period_ms, ...) ((void)0)
+    #define XLOG_WARN_FIRST_N(logger, n, ...) ((void)0)
 #endif
 
 #if XLOG_ACTIVE_LEVEL <= 4
-    #define XLOG_ERROR(logger, message) (logger)->log(::Zyrnix::LogLevel::Error, message)
+    #define XLOG_ERROR_EVERY_N(logger, n, ...) XLOG_LOG_EVERY_N(logger, ::Zyrnix::LogLevel::Error, n, __VA_ARGS__)
+    #define XLOG_ERROR_EVERY_MS(logger, period_ms, ...) \
+        XLOG_LOG_EVERY_MS(logger, ::Zyrnix::LogLevel::Error, period_ms, __VA_ARGS__)
+    #define XLOG_ERROR_FIRST_N(logger, n, ...) XLOG_LOG_FIRST_N(logger, ::Zyrnix::LogLevel::Error, n, __VA_ARGS__)
 #else
-    #define XLOG_ERROR(logger, message) ((void)0)
+    #define XLOG_ERROR_EVERY_N(logger, n, ...) ((void)0)
+    #define XLOG_ERROR_EVERY_MS(logger, period_ms, ...) ((void)0)
+    #define XLOG_ERROR_FIRST_N(logger, n, ...) ((void)0)
 #endif
 
 #if XLOG_ACTIVE_LEVEL <= 5
-    #define XLOG_CRITICAL(logger, message) (logger)->log(::Zyrnix::LogLevel::Critical, message)
+    #define XLOG_CRITICAL_EVERY_N(logger, n, ...) XLOG_LOG_EVERY_N(logger, ::Zyrnix::LogLevel::Critical, n, __VA_ARGS__)
+    #define XLOG_CRITICAL_EVERY_MS(logger, period_ms, ...) \
+        XLOG_LOG_EVERY_MS(logger, ::Zyrnix::LogLevel::Critical, period_ms, __VA_ARGS__)
+    #define XLOG_CRITICAL_FIRST_N(logger, n, ...) XLOG_LOG_FIRST_N(logger, ::Zyrnix::LogLevel::Critical, n, __VA_ARGS__)
+#else
+    #define XLOG_CRITICAL_EVERY_N(logger, n, ...) ((void)0)
+    #define XLOG_CRITICAL_EVERY_MS(logger, period_ms, ...) ((void)0)
+    #define XLOG_CRITICAL_FIRST_N(logger, n, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 0
+    #define XLOG_TRACE(logger, ...) XLOG_LOG_AT(logger, ::Zyrnix::LogLevel::Trace, __VA_ARGS__)
+#else
+    #define XLOG_TRACE(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 1
+    #define XLOG_DEBUG(logger, ...) XLOG_LOG_AT(logger, ::Zyrnix::LogLevel::Debug, __VA_ARGS__)
+#else
+    #define XLOG_DEBUG(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 2
+    #define XLOG_INFO(logger, ...) XLOG_LOG_AT(logger, ::Zyrnix::LogLevel::Info, __VA_ARGS__)
+#else
+    #define XLOG_INFO(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 3
+    #define XLOG_WARN(logger, ...) XLOG_LOG_AT(logger, ::Zyrnix::LogLevel::Warn, __VA_ARGS__)
+#else
+    #define XLOG_WARN(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 4
+    #define XLOG_ERROR(logger, ...) XLOG_LOG_AT(logger, ::Zyrnix::LogLevel::Error, __VA_ARGS__)
+#else
+    #define XLOG_ERROR(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 5
+    #define XLOG_CRITICAL(logger, ...) XLOG_LOG_AT(logger, ::Zyrnix::LogLevel::Critical, __VA_ARGS__)
+#else
+    #define XLOG_CRITICAL(logger, ...) ((void)0)
+#endif
+
+// Lazy messages (v1.2.0): the argument is a callable returning the message, run
+// only if the record is logged. Wrapped in Zyrnix::deferrable() and
+// capturing values only, an async logger runs it on the consumer thread.
+// XLOG_DEBUG_LAZY(logger, [&] { return dump_state(); });
+// XLOG_DEBUG_LAZY(logger, Zyrnix::deferrable([=] { return describe(id, total); }));
+// Variadic so that commas in a capture list survive.
+#define XLOG_LOG_LAZY(logger, level, ...) \
+    do { \
+        XLOG_DECLARE_SITE_(level); \
+        if (XLOG_SITE_ENABLED_(logger, level)) { \
+            (logger)->log_lazy(xlog_site_, __VA_ARGS__); \
+        } \
+    } while(0)
+
+#if XLOG_ACTIVE_LEVEL <= 0
+    #define XLOG_TRACE_LAZY(logger, ...) XLOG_LOG_LAZY(logger, ::Zyrnix::LogLevel::Trace, __VA_ARGS__)
+#else
+    #define XLOG_TRACE_LAZY(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 1
+    #define XLOG_DEBUG_LAZY(logger, ...) XLOG_LOG_LAZY(logger, ::Zyrnix::LogLevel::Debug, __VA_ARGS__)
 #else
-    #define XLOG_CRITICAL(logger, message) ((void)0)
+    #define XLOG_DEBUG_LAZY(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 2
+    #define XLOG_INFO_LAZY(logger, ...) XLOG_LOG_LAZY(logger, ::Zyrnix::LogLevel::Info, __VA_ARGS__)
+#else
+    #define XLOG_INFO_LAZY(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 3
+    #define XLOG_WARN_LAZY(logger, ...) XLOG_LOG_LAZY(logger, ::Zyrnix::LogLevel::Warn, __VA_ARGS__)
+#else
+    #define XLOG_WARN_LAZY(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 4
+    #define XLOG_ERROR_LAZY(logger, ...) XLOG_LOG_LAZY(logger, ::Zyrnix::LogLevel::Error, __VA_ARGS__)
+#else
+    #define XLOG_ERROR_LAZY(logger, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 5
+    #define XLOG_CRITICAL_LAZY(logger, ...) XLOG_LOG_LAZY(logger, ::Zyrnix::LogLevel::Critical, __VA_ARGS__)
+#else
+    #define XLOG_CRITICAL_LAZY(logger, ...) ((void)0)
+#endif
+
+#if XLOG_HAS_FMT
+#include "deferred.hpp"
+
+// Deferred formatting (v1.2.0): the call site is described once at
+// compile time, and an async logger queues only the argument bytes for
+// a consumer thread to format. format must be a string literal and the
+// arguments strings or trivially copyable values.
+// XLOG_INFO_DEFERRED(logger, "order {} filled at {}", order_id, price);
+#define XLOG_LOG_DEFERRED(logger, level, format, ...) \
+    do { \
+        static constinit ::Zyrnix::SiteSwitch xlog_switch_; \
+        static constexpr ::Zyrnix::DeferredSite xlog_deferred_site_ = ::Zyrnix::deferred::make_site( \
+            decltype(::Zyrnix::deferred::type_list_of(__VA_ARGS__)){}, format, \
+            ::Zyrnix::LogSite::here(level, &xlog_switch_)); \
+        if (XLOG_LEVEL_ENABLED(logger, level) || xlog_deferred_site_.forced()) { \
+            (logger)->log_deferred(xlog_deferred_site_ __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } while(0)
+
+#if XLOG_ACTIVE_LEVEL <= 0
+    #define XLOG_TRACE_DEFERRED(logger, format, ...) \
+        XLOG_LOG_DEFERRED(logger, ::Zyrnix::LogLevel::Trace, format __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define XLOG_TRACE_DEFERRED(logger, format, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 1
+    #define XLOG_DEBUG_DEFERRED(logger, format, ...) \
+        XLOG_LOG_DEFERRED(logger, ::Zyrnix::LogLevel::Debug, format __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define XLOG_DEBUG_DEFERRED(logger, format, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 2
+    #define XLOG_INFO_DEFERRED(logger, format, ...) \
+        XLOG_LOG_DEFERRED(logger, ::Zyrnix::LogLevel::Info, format __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define XLOG_INFO_DEFERRED(logger, format, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 3
+    #define XLOG_WARN_DEFERRED(logger, format, ...) \
+        XLOG_LOG_DEFERRED(logger, ::Zyrnix::LogLevel::Warn, format __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define XLOG_WARN_DEFERRED(logger, format, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 4
+    #define XLOG_ERROR_DEFERRED(logger, format, ...) \
+        XLOG_LOG_DEFERRED(logger, ::Zyrnix::LogLevel::Error, format __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define XLOG_ERROR_DEFERRED(logger, format, ...) ((void)0)
+#endif
+
+#if XLOG_ACTIVE_LEVEL <= 5
+    #define XLOG_CRITICAL_DEFERRED(logger, format, ...) \
+        XLOG_LOG_DEFERRED(logger, ::Zyrnix::LogLevel::Critical, format __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define XLOG_CRITICAL_DEFERRED(logger, format, ...) ((void)0)
+#endif
 #endif
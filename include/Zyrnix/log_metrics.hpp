@@ -1,5 +1,8 @@
 #pragma once
 #include "Zyrnix_features.hpp"
+#include "latency_histogram.hpp"
+#include "sharded_counter.hpp"
+#include <array>
 #include <string>
 #include <functional>
 #include <map>
@@ -11,55 +14,166 @@
 
 namespace Zyrnix {
 
+/**
+ * @brief Logger stages timed on sampled calls (v1.2.0)
+ *
+ * Formatting and writing are timed per sink, in SinkMetrics.
+ */
+enum class PipelineStage : uint8_t { Filter, Redact, Enqueue };
+inline constexpr size_t pipeline_stage_count = 3;
+const char* to_string(PipelineStage stage);
+
 class LogMetrics {
 public:
+    // Sharded per thread (v1.2.0), so logging threads do not share lines
     struct Counters {
-        std::atomic<uint64_t> messages_logged{0};
-        std::atomic<uint64_t> messages_dropped{0};
-        std::atomic<uint64_t> messages_filtered{0};
-        std::atomic<uint64_t> flushes{0};
-        std::atomic<uint64_t> errors{0};
+        ShardedCounter messages_logged;
+        ShardedCounter messages_dropped;
+        ShardedCounter messages_filtered;
+        ShardedCounter flushes;
+        ShardedCounter errors;
+        ShardedCounter pool_misses;
     };
 
     struct Timings {
-        std::atomic<uint64_t> total_log_time_us{0};  // Total time spent logging (microseconds)
-        std::atomic<uint64_t> total_flush_time_us{0}; // Total time spent flushing
-        std::atomic<uint64_t> max_log_latency_us{0};  // Max single log call latency
-        std::atomic<uint64_t> max_flush_latency_us{0}; // Max single flush latency
+        ShardedCounter total_log_time_us;  // Total time spent logging (microseconds)
+        ShardedCounter total_flush_time_us; // Total time spent flushing
+        ShardedMax max_log_latency_us;  // Max single log call latency
+        ShardedMax max_flush_latency_us; // Max single flush latency
+        std::atomic<uint64_t> recent_log_latency_us{0};  // Latest log latency (v1.2.0)
+        LatencyHistogram log_call_ns;    // Producer side of a queued log call (v1.2.0)
+        LatencyHistogram queue_wait_ns;  // Record timestamp to dequeue (v1.2.0)
+        LatencyHistogram flush_ns;       // (v1.2.0)
     };
 
     struct QueueMetrics {
         std::atomic<size_t> current_depth{0};
-        std::atomic<size_t> max_depth{0};
+        ShardedMax max_depth;
         std::atomic<uint64_t> enqueue_count{0};
         std::atomic<uint64_t> dequeue_count{0};
+        std::atomic<size_t> spin_budget{0};
+        std::atomic<uint64_t> spin_wakeups{0};
+        std::atomic<uint64_t> yield_wakeups{0};
+        std::atomic<uint64_t> parks{0};
+        std::atomic<size_t> capacity{0};       // 0 when unbounded (v1.2.0)
+        std::atomic<size_t> sample_rate{1};    // Kept 1 in N below the protected level (v1.2.0)
     };
 
     LogMetrics();
 
-    void record_message_logged();
-    void record_message_dropped();
-    void record_message_filtered();
-    void record_flush();
-    void record_error();
+    void record_message_logged(uint64_t count = 1) { counters_.messages_logged.add(count); }
+    void record_message_dropped(uint64_t count = 1) { counters_.messages_dropped.add(count); }
+    void record_message_filtered(uint64_t count = 1) { counters_.messages_filtered.add(count); }
+    void record_flush() { counters_.flushes.add(); }
+    void record_error() { counters_.errors.add(); }
+    void record_pool_miss() { counters_.pool_misses.add(); }
     void record_log_duration(uint64_t microseconds);
     void record_flush_duration(uint64_t microseconds);
     void update_queue_depth(size_t depth);
 
-    uint64_t get_messages_logged() const { return counters_.messages_logged.load(std::memory_order_relaxed); }
-    uint64_t get_messages_dropped() const { return counters_.messages_dropped.load(std::memory_order_relaxed); }
-    uint64_t get_messages_filtered() const { return counters_.messages_filtered.load(std::memory_order_relaxed); }
-    uint64_t get_flushes() const { return counters_.flushes.load(std::memory_order_relaxed); }
-    uint64_t get_errors() const { return counters_.errors.load(std::memory_order_relaxed); }
+    /**
+     * @brief Raise the max queue depth only; producers call this (v1.2.0)
+     *
+     * The current depth is a single value every writer would share, so it
+     * is left to update_queue_depth() on the consumer.
+     */
+    void observe_queue_depth(size_t depth) { queue_metrics_.max_depth.update(depth); }
+
+    /**
+     * @brief Latency distributions at nanosecond resolution (v1.2.0)
+     *
+     * Log-call latency is the time a Logger spends in a call past its
+     * level check, for the calls sample_timing() picks. Queue wait is
+     * recorded for every record, from its timestamp until a worker takes
+     * it off the queue. record_flush_duration_ns() also feeds the
+     * microsecond average and max.
+     */
+    void record_log_call_ns(uint64_t nanoseconds) { timings_.log_call_ns.record(nanoseconds); }
+    void record_queue_wait_ns(uint64_t nanoseconds) { timings_.queue_wait_ns.record(nanoseconds); }
+    void record_flush_duration_ns(uint64_t nanoseconds);
+    LatencyHistogram::Snapshot get_log_call_latency() const { return timings_.log_call_ns.snapshot(); }
+    LatencyHistogram::Snapshot get_queue_wait_latency() const { return timings_.queue_wait_ns.snapshot(); }
+    LatencyHistogram::Snapshot get_flush_latency() const { return timings_.flush_ns.snapshot(); }
+
+    /**
+     * @brief True for one call in get_timing_interval() on this thread (v1.2.0)
+     *
+     * Callers time only those calls, so two clock reads are paid rarely.
+     */
+    /**
+     * @brief Time one stage took for a sampled call or batch (v1.2.0)
+     */
+    void record_stage_ns(PipelineStage stage, uint64_t nanoseconds) {
+        stages_ns_[static_cast<size_t>(stage)].record(nanoseconds);
+    }
+    LatencyHistogram::Snapshot get_stage_latency(PipelineStage stage) const {
+        return stages_ns_[static_cast<size_t>(stage)].snapshot();
+    }
+
+    bool sample_timing() const {
+        thread_local uint32_t calls = 0;
+        return (++calls & timing_mask_.load(std::memory_order_relaxed)) == 0;
+    }
+
+    /**
+     * @brief Time one call in one_in, rounded up to a power of two; 1 times all (v1.2.0)
+     */
+    void set_timing_interval(uint32_t one_in);
+    uint32_t get_timing_interval() const { return timing_mask_.load(std::memory_order_relaxed) + 1; }
+
+    /**
+     * @brief Bound of the async queue, against which depth is pressure (v1.2.0)
+     */
+    void set_queue_capacity(size_t capacity);
+    size_t get_queue_capacity() const { return queue_metrics_.capacity.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Publish the rate an AdaptiveSampler currently keeps 1 in (v1.2.0)
+     */
+    void update_sample_rate(size_t rate);
+    size_t get_sample_rate() const { return queue_metrics_.sample_rate.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Count a record dropped because a producer lane was full (v1.2.0)
+     *
+     * Also counts towards messages_dropped.
+     */
+    void record_lane_dropped(uint64_t lane_id);
+    std::map<uint64_t, uint64_t> get_lane_drops() const;
+
+    /**
+     * @brief Publish async consumer wait counters (v1.2.0)
+     */
+    void update_consumer_wait(size_t spin_budget, uint64_t spin_wakeups,
+                              uint64_t yield_wakeups, uint64_t parks);
+    size_t get_spin_budget() const { return queue_metrics_.spin_budget.load(std::memory_order_relaxed); }
+    uint64_t get_spin_wakeups() const { return queue_metrics_.spin_wakeups.load(std::memory_order_relaxed); }
+    uint64_t get_yield_wakeups() const { return queue_metrics_.yield_wakeups.load(std::memory_order_relaxed); }
+    uint64_t get_consumer_parks() const { return queue_metrics_.parks.load(std::memory_order_relaxed); }
+
+    uint64_t get_messages_logged() const { return counters_.messages_logged.load(); }
+    uint64_t get_messages_dropped() const { return counters_.messages_dropped.load(); }
+    uint64_t get_messages_filtered() const { return counters_.messages_filtered.load(); }
+    uint64_t get_flushes() const { return counters_.flushes.load(); }
+    uint64_t get_errors() const { return counters_.errors.load(); }
+    uint64_t get_pool_misses() const { return counters_.pool_misses.load(); }
     
     double get_messages_per_second() const;
     double get_average_log_latency_us() const;
     double get_average_flush_latency_us() const;
-    uint64_t get_max_log_latency_us() const { return timings_.max_log_latency_us.load(std::memory_order_relaxed); }
-    uint64_t get_max_flush_latency_us() const { return timings_.max_flush_latency_us.load(std::memory_order_relaxed); }
+    uint64_t get_max_log_latency_us() const { return timings_.max_log_latency_us.load(); }
+    uint64_t get_max_flush_latency_us() const { return timings_.max_flush_latency_us.load(); }
+
+    /**
+     * @brief The latency last passed to record_log_duration() (v1.2.0)
+     *
+     * Async loggers record, per dispatched batch, how long its oldest
+     * record took from the log call to the sinks.
+     */
+    uint64_t get_recent_log_latency_us() const { return timings_.recent_log_latency_us.load(std::memory_order_relaxed); }
     
     size_t get_current_queue_depth() const { return queue_metrics_.current_depth.load(std::memory_order_relaxed); }
-    size_t get_max_queue_depth() const { return queue_metrics_.max_depth.load(std::memory_order_relaxed); }
+    size_t get_max_queue_depth() const { return queue_metrics_.max_depth.load(); }
 
     void reset();
 
@@ -76,12 +190,16 @@ public:
         uint64_t max_flush_latency_us;
         size_t current_queue_depth;
         size_t max_queue_depth;
+        size_t sample_rate;
         std::chrono::steady_clock::time_point timestamp;
     };
 
     Snapshot get_snapshot() const;
 
-    std::string export_prometheus(const std::string& prefix = "Zyrnix") const;
+    /**
+     * @brief Prometheus text; stage histograms carry logger_label if given
+     */
+    std::string export_prometheus(const std::string& prefix = "Zyrnix", const std::string& logger_label = "") const;
 
     std::string export_json() const;
 
@@ -89,6 +207,9 @@ private:
     Counters counters_;
     Timings timings_;
     QueueMetrics queue_metrics_;
+    std::atomic<uint32_t> timing_mask_{63};
+    std::array<LatencyHistogram, pipeline_stage_count> stages_ns_;
+    std::map<uint64_t, uint64_t> lane_drops_;
     std::chrono::steady_clock::time_point start_time_;
     mutable std::mutex mutex_;
 };
@@ -98,68 +219,234 @@ public:
     SinkMetrics(const std::string& sink_name);
 
     void record_write(size_t bytes);
+    void record_writes(uint64_t count, uint64_t bytes);  // (v1.2.0)
     void record_flush();
     void record_error();
     void record_write_duration(uint64_t microseconds);
+    void record_write_duration_ns(uint64_t nanoseconds);  // (v1.2.0)
+    LatencyHistogram::Snapshot get_write_latency() const { return write_ns_.snapshot(); }
+
+    /**
+     * @brief Rendering a record with the sink's layout, on sampled writes (v1.2.0)
+     *
+     * Also part of the write latency, which it was measured within.
+     */
+    void record_format_ns(uint64_t nanoseconds) { format_ns_.record(nanoseconds); }
+    LatencyHistogram::Snapshot get_format_latency() const { return format_ns_.snapshot(); }
+
+    // Isolated sinks with a dedicated worker (v1.2.0)
+    void update_queue_depth(size_t depth);
+    void record_dropped(uint64_t count = 1);
 
     std::string get_name() const { return name_; }
-    uint64_t get_writes() const { return writes_.load(std::memory_order_relaxed); }
-    uint64_t get_bytes_written() const { return bytes_written_.load(std::memory_order_relaxed); }
+    uint64_t get_writes() const { return writes_.load(); }
+    uint64_t get_bytes_written() const { return bytes_written_.load(); }
     uint64_t get_flushes() const { return flushes_.load(std::memory_order_relaxed); }
     uint64_t get_errors() const { return errors_.load(std::memory_order_relaxed); }
     double get_average_write_latency_us() const;
+    size_t get_queue_depth() const { return queue_depth_.load(std::memory_order_relaxed); }
+    uint64_t get_dropped() const { return dropped_.load(std::memory_order_relaxed); }
 
     std::string export_prometheus(const std::string& prefix = "Zyrnix") const;
+    std::string export_json() const;
 
 private:
     std::string name_;
-    std::atomic<uint64_t> writes_{0};
-    std::atomic<uint64_t> bytes_written_{0};
+    // Bumped by every thread fanning out to the sink (v1.2.0)
+    ShardedCounter writes_;
+    ShardedCounter bytes_written_;
     std::atomic<uint64_t> flushes_{0};
     std::atomic<uint64_t> errors_{0};
     std::atomic<uint64_t> total_write_time_us_{0};
+    LatencyHistogram write_ns_;
+    LatencyHistogram format_ns_;
+    std::atomic<size_t> queue_depth_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+/**
+ * @brief The keys a KeyedRateLimiter held back the most (v1.2.0)
+ *
+ * The limiter reports a key when its drop count reaches a power of two
+ * and then every 1024 drops, so counts trail by at most that much. Only
+ * the max_keys largest are kept.
+ */
+class LimiterMetrics {
+public:
+    struct Offender {
+        std::string key;
+        uint64_t dropped;
+    };
+
+    explicit LimiterMetrics(const std::string& limiter_name, size_t max_keys = 16);
+
+    /**
+     * @brief key has now dropped dropped records, newly_dropped since its last report
+     */
+    void record_offender(const std::string& key, uint64_t dropped, uint64_t newly_dropped);
+
+    std::string get_name() const { return name_; }
+    uint64_t get_dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Most dropped first
+     */
+    std::vector<Offender> top_offenders() const;
+
+    std::string export_prometheus(const std::string& prefix = "Zyrnix") const;
+    std::string export_json() const;
+
+private:
+    std::string name_;
+    size_t max_keys_;
+    std::atomic<uint64_t> dropped_{0};
+    mutable std::mutex mutex_;
+    std::vector<Offender> offenders_;
 };
 
+/**
+ * @brief Per-tenant state of an async queue with fair queueing (v1.2.0)
+ *
+ * The queue updates each tenant's counters under its own lock as records
+ * come and go; readers see them a moment late at worst.
+ */
+class TenantMetrics {
+public:
+    struct Counters {
+        std::atomic<uint64_t> queued{0};
+        std::atomic<uint64_t> queued_bytes{0};
+        std::atomic<uint64_t> enqueued{0};
+        std::atomic<uint64_t> over_quota{0};  // Refused, the tenant being at its quota
+        std::atomic<uint64_t> evicted{0};     // Dropped to make room under DropOldest
+    };
+
+    struct Snapshot {
+        std::string tenant;
+        uint64_t queued;
+        uint64_t queued_bytes;
+        uint64_t enqueued;
+        uint64_t over_quota;
+        uint64_t evicted;
+    };
+
+    explicit TenantMetrics(const std::string& queue_name);
+
+    /**
+     * @brief The counters of one tenant, made on first use
+     */
+    std::shared_ptr<Counters> tenant(const std::string& key);
+
+    void set_quota_bytes(uint64_t bytes) { quota_bytes_.store(bytes, std::memory_order_relaxed); }
+    uint64_t get_quota_bytes() const { return quota_bytes_.load(std::memory_order_relaxed); }
+
+    std::string get_name() const { return name_; }
+
+    /**
+     * @brief Every tenant, in key order
+     */
+    std::vector<Snapshot> snapshot() const;
+
+    std::string export_prometheus(const std::string& prefix = "Zyrnix") const;
+    std::string export_json() const;
+
+private:
+    std::string name_;
+    std::atomic<uint64_t> quota_bytes_{0};
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Counters>> tenants_;
+};
+
+/**
+ * @brief Text formats of MetricsRegistry::write_exposition() (v1.2.0)
+ */
+enum class ExpositionFormat { Prometheus, OpenMetrics };
+
+/**
+ * @brief HTTP Content-Type of format
+ */
+const char* content_type(ExpositionFormat format);
+
 class MetricsRegistry {
 public:
     static MetricsRegistry& instance();
 
     std::shared_ptr<LogMetrics> get_logger_metrics(const std::string& logger_name);
     std::shared_ptr<SinkMetrics> get_sink_metrics(const std::string& sink_name);
+    std::shared_ptr<LimiterMetrics> get_limiter_metrics(const std::string& limiter_name);
+    std::shared_ptr<TenantMetrics> get_tenant_metrics(const std::string& queue_name);  // (v1.2.0)
 
     std::map<std::string, LogMetrics::Snapshot> get_all_logger_snapshots() const;
 
     std::string export_all_prometheus(const std::string& prefix = "Zyrnix") const;
 
+    /**
+     * @brief Render every metric into out, replacing what it held (v1.2.0)
+     *
+     * Each metric is one family, with a series per logger, sink, limiter
+     * or queue told apart by a logger, sink, limiter or queue label. The
+     * registry's mutex is held only to take the current list of metric
+     * objects, so get_*_metrics() callers never wait on a scrape, and out
+     * keeps its capacity, so scraping into the same string again does not
+     * allocate.
+     */
+    void write_exposition(std::string& out, const std::string& prefix = "Zyrnix",
+                          ExpositionFormat format = ExpositionFormat::Prometheus) const;
+
     std::string export_all_json() const;
 
     void reset_all();
 
 private:
     MetricsRegistry() = default;
+
+    template <class Metrics>
+    struct Entry {
+        std::string name;
+        std::string label;  // kind="name", escaped
+        std::shared_ptr<Metrics> metrics;
+    };
+
+    // The metric objects in name order, as of one moment
+    struct Entries {
+        std::vector<Entry<LogMetrics>> loggers;
+        std::vector<Entry<SinkMetrics>> sinks;
+        std::vector<Entry<LimiterMetrics>> limiters;
+        std::vector<Entry<TenantMetrics>> tenants;
+    };
+
+    // Shared by readers until the next registration; rebuilt on demand
+    std::shared_ptr<const Entries> entries() const;
     
     mutable std::mutex mutex_;
     std::map<std::string, std::shared_ptr<LogMetrics>> logger_metrics_;
     std::map<std::string, std::shared_ptr<SinkMetrics>> sink_metrics_;
+    std::map<std::string, std::shared_ptr<LimiterMetrics>> limiter_metrics_;
+    std::map<std::string, std::shared_ptr<TenantMetrics>> tenant_metrics_;
+    mutable std::shared_ptr<const Entries> entries_;  // Null after a registration
 };
 
 class ScopedTimer {
 public:
     using Callback = std::function<void(uint64_t)>;
+    enum class Unit { Microseconds, Nanoseconds };
 
-    explicit ScopedTimer(Callback callback)
+    explicit ScopedTimer(Callback callback, Unit unit = Unit::Microseconds)
         : callback_(callback)
+        , unit_(unit)
         , start_(std::chrono::steady_clock::now())
     {}
 
     ~ScopedTimer() {
-        auto end = std::chrono::steady_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start_).count();
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        auto duration = unit_ == Unit::Nanoseconds
+            ? std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+            : std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
         callback_(duration);
     }
 
 private:
     Callback callback_;
+    Unit unit_;
     std::chrono::steady_clock::time_point start_;
 };
 
@@ -1,25 +1,59 @@
 #pragma once
+#include "field.hpp"
 #include "log_level.hpp"
+#include "trace_context.hpp"
 #include <string>
 #include <chrono>
-#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <future>
 
 namespace Zyrnix {
 
+/**
+ * @brief Marker pushed through an async queue (v1.2.0)
+ *
+ * The consumer completes it once every record queued ahead of it has
+ * been handed to the sinks, and with flush_sinks set, once the sinks have
+ * been flushed as well.
+ */
+struct LogFence {
+    std::promise<void> done;
+    bool flush_sinks = false;
+};
+
+struct LogSite;
+struct DeferredSite;
+class StackTrace;
+
 struct LogRecord {
     std::string logger_name;
     LogLevel level;
     std::string message;
     std::chrono::system_clock::time_point timestamp;
-    std::unordered_map<std::string, std::string> fields;
+    uint64_t thread_id = 0;  // current_thread_id() of the logging thread (v1.2.0)
+    FieldList fields;  // Typed, and flat with inline slots, since v1.2.0
+    TraceContext trace;  // The logging thread's, by value (v1.2.0)
+    std::shared_ptr<LogFence> fence;  // Set only on async pipeline fence markers (v1.2.0)
+    const LogSite* site = nullptr;    // Where the record was logged, if it came from a macro (v1.2.0)
+    // Set while message holds the captured arguments of a deferred call
+    // rather than text; the consumer decodes it before dispatch (v1.2.0)
+    const DeferredSite* deferred = nullptr;
+    // Replayed from the logger's backtrace ring, so it skips the logger's
+    // level; filters and sink levels still apply (v1.2.0)
+    bool backtrace = false;
+    // Logged through a ChildLogger, whose level stands in for the logger's (v1.2.0)
+    bool child_level = false;
+    // Return addresses of the logging call, when the logger captures them (v1.2.0)
+    std::shared_ptr<StackTrace> stack;
     
     bool has_field(const std::string& key) const {
-        return fields.find(key) != fields.end();
+        return fields.contains(key);
     }
     
     std::string get_field(const std::string& key) const {
-        auto it = fields.find(key);
-        return (it != fields.end()) ? it->second : "";
+        const FieldValue* value = fields.find(key);
+        return value ? value->text() : "";
     }
 };
 
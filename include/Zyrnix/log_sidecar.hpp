@@ -0,0 +1,138 @@
+#pragma once
+#include "log_level.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+class FormattedRecord;
+
+/**
+ * @brief A small index written beside each finished log file (v1.2.0)
+ *
+ * Set on RotationOptions or CompressionOptions. While a file is written
+ * the sink keeps its time range, a count of records per level and a
+ * Bloom filter over the values of bloom_fields; when the file is rotated
+ * the index goes to <rotated file>.meta and moves with the file.
+ * tools/search_logs.py reads them to skip every file that cannot hold a
+ * trace id, user id or time range, without opening it.
+ */
+struct SidecarOptions {
+    bool enabled = false;
+
+    // Record fields whose values go into the filter; "trace_id" also
+    // takes the record's trace context
+    std::vector<std::string> bloom_fields = {"trace_id"};
+
+    // Distinct values a file is sized for, and the false-positive rate
+    // at that many; past it the rate climbs but never misses a value
+    size_t expected_values = 100000;
+    double false_positive_rate = 0.01;
+};
+
+/**
+ * @brief The sidecar file format and the code to build and read it (v1.2.0)
+ *
+ * Little-endian throughout: the 8 bytes "ZYRNIXS1"; the size in bytes
+ * of the file it describes as it was when written (u64); the first and
+ * last record time in Unix nanoseconds (i64 each; INT64_MAX and
+ * INT64_MIN with no records); the record count and then one count per
+ * level, Trace to Critical (u64 each); the number of filter keys (u32)
+ * and each key as a u16 length and its bytes; the hash count k (u32);
+ * the filter's size in bits m (u64) and its ceil(m / 8) bytes, bit i
+ * being bit (i % 8) of byte i / 8.
+ *
+ * A value v of key f sets bits (h1 + i * h2) % m for i < k, where h is
+ * the 64-bit FNV-1a hash of f, '=', v, h1 its low 32 bits and h2 its
+ * high 32 bits with the lowest bit set.
+ */
+namespace sidecar {
+
+inline constexpr char magic[8] = {'Z', 'Y', 'R', 'N', 'I', 'X', 'S', '1'};
+inline constexpr std::string_view suffix = ".meta";
+inline constexpr size_t level_count = 6;
+
+/**
+ * @brief 64-bit FNV-1a of key, '=' and value
+ */
+uint64_t hash(std::string_view key, std::string_view value);
+
+/**
+ * @brief A sidecar read back
+ */
+struct Index {
+    uint64_t data_size = 0;
+    int64_t min_ns = INT64_MAX;
+    int64_t max_ns = INT64_MIN;
+    uint64_t records = 0;
+    std::array<uint64_t, level_count> level_counts{};
+    std::vector<std::string> keys;
+    uint32_t hash_count = 0;
+    uint64_t bit_count = 0;
+    std::vector<uint8_t> bits;
+
+    /**
+     * @brief The Index in the sidecar at path, or nullopt if absent or malformed
+     */
+    static std::optional<Index> read(const std::string& path);
+
+    bool is_key(std::string_view key) const;
+
+    /**
+     * @brief False only if no record of the file has value for key;
+     *        true for a key the filter was not built over
+     */
+    bool may_contain(std::string_view key, std::string_view value) const;
+};
+
+/**
+ * @brief Accumulates the index of the file being written; not thread-safe
+ */
+class Builder {
+public:
+    explicit Builder(const SidecarOptions& options);
+
+    void add(const FormattedRecord& record);
+
+    /**
+     * @brief A record without fields, from the legacy log() path
+     */
+    void add(std::chrono::system_clock::time_point timestamp, LogLevel level);
+
+    /**
+     * @brief Write the index to path, through a temporary file and a rename
+     */
+    bool write(const std::string& path, uint64_t data_size) const;
+
+    /**
+     * @brief Carry on from the sidecar at path, if it describes data_size bytes
+     *
+     * For a sink reopening the file it wrote before. Otherwise the index
+     * is marked incomplete, and no sidecar is written for the file: one
+     * that missed the earlier records would let a search skip them.
+     */
+    void resume(const std::string& path, uint64_t data_size);
+
+    /**
+     * @brief Start over for a new, empty file
+     */
+    void reset();
+
+    bool complete() const { return complete_; }
+
+private:
+    void add_value(std::string_view key, std::string_view value);
+
+    Index index_;
+    bool complete_ = true;
+};
+
+}
+
+}
@@ -1,27 +1,144 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <span>
+#include <vector>
 #include "log_level.hpp"
+#include "log_record.hpp"
 #include "formatter.hpp"
+#include "formatted_record.hpp"
+#include "log_clock.hpp"
 
 namespace Zyrnix {
 
+/**
+ * @brief Told when a sink's level changes (v1.2.0)
+ *
+ * Called from LogSink::set_level() under the sink's watcher lock, so it
+ * must not block or call back into the sink.
+ */
+class SinkLevelWatcher {
+public:
+    virtual void sink_level_changed() = 0;
+
+protected:
+    ~SinkLevelWatcher() = default;
+};
+
 class LogSink {
 public:
     virtual ~LogSink() = default;
     virtual void log(const std::string& name, LogLevel level, const std::string& message) = 0;
 
+    /**
+     * @brief Write one record (v1.2.0)
+     *
+     * Logger dispatches through this. record.formatted(formatter) renders
+     * the line once per layout and shares it with every other sink, so
+     * sinks that write formatted text should override this. Name and
+     * message are views, so sinks that write them directly can do so
+     * without a heap copy. The default forwards to log() for sinks that
+     * only implement that, which materializes both as std::string.
+     */
+    virtual void log_record(const FormattedRecord& record) {
+        log(std::string(record.logger_name()), record.level(), std::string(record.message()));
+    }
+
+    /**
+     * @brief Write a batch of records (v1.2.0)
+     *
+     * Called by async consumers with everything drained in one pass.
+     * The default forwards each record to log_record(); sinks that can
+     * write or send a batch at once should override this.
+     */
+    virtual void log_batch(std::span<const FormattedRecord> records) {
+        for (const auto& record : records) {
+            log_record(record);
+        }
+    }
+
+    /**
+     * @brief Push buffered output to its destination (v1.2.0)
+     *
+     * Must not return until everything handed to the sink before the call
+     * has been written (or sent). The default does nothing, for sinks
+     * that write through.
+     */
+    virtual void flush() {}
+
     // Cloud-aware sinks (v1.1.3)
     // Override in cloud sinks (e.g., Loki, CloudWatch, Azure) to enable
     // per-sink redaction routing and health reporting.
     virtual bool is_cloud_sink() const { return false; }
 
-    void set_level(LogLevel lvl) { level = lvl; }
-    LogLevel get_level() const { return level; }
+    /**
+     * @brief Lowest level this sink writes (v1.2.0)
+     *
+     * Logger skips the sink for records below it and rejects records no
+     * sink would take before building them. May be changed at run time:
+     * the loggers holding the sink are told, and recompute their floor
+     * on their next record.
+     */
+    void set_level(LogLevel lvl) {
+        level.store(lvl, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(watchers_mtx_);
+        for (SinkLevelWatcher* watcher : watchers_) {
+            watcher->sink_level_changed();
+        }
+    }
+    LogLevel get_level() const { return level.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Be told of set_level() calls until removed (v1.2.0)
+     *
+     * Each add needs its own remove.
+     */
+    void add_level_watcher(SinkLevelWatcher* watcher) {
+        std::lock_guard<std::mutex> lock(watchers_mtx_);
+        watchers_.push_back(watcher);
+    }
+    void remove_level_watcher(SinkLevelWatcher* watcher) {
+        std::lock_guard<std::mutex> lock(watchers_mtx_);
+        const auto it = std::find(watchers_.begin(), watchers_.end(), watcher);
+        if (it != watchers_.end()) {
+            watchers_.erase(it);
+        }
+    }
+
+    /**
+     * @brief Choose the layout of this sink's lines (v1.2.0)
+     *
+     * Unlike set_level(), not synchronized with logging: configure the sink
+     * before adding it to a logger. Wrapping sinks forward to the sink
+     * that does the writing.
+     */
+    virtual void set_formatter(Formatter f) { formatter = std::move(f); }
+    void set_pattern(const std::string& pattern) { set_formatter(Formatter(pattern)); }
+    const Formatter& get_formatter() const { return formatter; }
 
 protected:
-    LogLevel level = LogLevel::Trace;
+    /**
+     * @brief Write a plain log() call through log_record() (v1.2.0)
+     *
+     * For sinks whose log() means the same as log_record(): the line
+     * renders into the calling thread's RenderCache, stamped now, instead
+     * of into a fresh string per call.
+     */
+    void log_as_record(std::string_view name, LogLevel lvl, std::string_view message) {
+        ScopedRenderCache cache;
+        log_record(FormattedRecord(name, lvl, message, LogClock::now(), cache));
+    }
+
+    std::atomic<LogLevel> level{LogLevel::Trace};
     Formatter formatter;
+
+private:
+    std::mutex watchers_mtx_;
+    std::vector<SinkLevelWatcher*> watchers_;
 };
 
 using LogSinkPtr = std::shared_ptr<LogSink>;
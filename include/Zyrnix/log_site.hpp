@@ -0,0 +1,155 @@
+#pragma once
+#include "log_level.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+class SiteSwitch;
+
+/**
+ * @brief Static description of one logging call site (v1.2.0)
+ *
+ * The XLOG_* macros build one as a static constexpr per expansion, so the
+ * location is resolved by the compiler and a record only carries a
+ * pointer to it. Sites have static storage duration and outlive every
+ * record that points at them, including records still in an async queue.
+ */
+struct LogSite {
+    LogLevel level;
+    const char* file;      // As given by the compiler, usually the full path
+    uint32_t base_offset;  // Where the base name starts within file
+    uint32_t line;
+    const char* function;
+    SiteSwitch* control;   // Runtime enable bit, nullptr if the site has none
+
+    /**
+     * @brief file without its directories
+     */
+    constexpr std::string_view file_name() const { return std::string_view(file).substr(base_offset); }
+
+    /**
+     * @brief Whether SiteRegistry has switched this site on, which lets it
+     *        log below its logger's level
+     */
+    bool forced() const;
+
+    static consteval uint32_t base_name_offset(std::string_view path) {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string_view::npos ? 0 : static_cast<uint32_t>(slash + 1);
+    }
+
+    /**
+     * @brief The site of the caller; std::source_location fills in the rest
+     */
+    static consteval LogSite here(LogLevel level, SiteSwitch* control = nullptr,
+                                  std::source_location location = std::source_location::current()) {
+        return LogSite{level, location.file_name(), base_name_offset(location.file_name()),
+                       static_cast<uint32_t>(location.line()), location.function_name(), control};
+    }
+};
+
+/**
+ * @brief Runtime enable bit of one call site (v1.2.0)
+ *
+ * Declared constinit next to each macro's LogSite, so it needs no guard.
+ * The first time a site is checked it joins the SiteRegistry and picks
+ * up the rules set so far; from then on a check is one relaxed byte load.
+ */
+class SiteSwitch {
+public:
+    constexpr SiteSwitch() = default;
+    SiteSwitch(const SiteSwitch&) = delete;
+    SiteSwitch& operator=(const SiteSwitch&) = delete;
+
+    bool enabled(const LogSite& site) {
+        uint8_t state = state_.load(std::memory_order_relaxed);
+        if (state == Unseen) [[unlikely]] {
+            state = enroll(site);
+        }
+        return state == On;
+    }
+
+private:
+    friend class SiteRegistry;
+    enum : uint8_t { Unseen, Off, On };
+
+    uint8_t enroll(const LogSite& site);
+
+    std::atomic<uint8_t> state_{Unseen};
+};
+
+inline bool LogSite::forced() const {
+    return control && control->enabled(*this);
+}
+
+/**
+ * @brief Every call site that has run, and the rules switching them on (v1.2.0)
+ *
+ * Rules match a glob ('*' and '?') against the site's file, either the
+ * full path or the base name, and another against its function as the
+ * compiler spells it (e.g. "void Parser::read_header(int)", so
+ * "*read_header*" is the usual form). Later rules win. A site that is
+ * switched on logs even when its level is below the logger's; sink
+ * levels still apply. Sites that first run after a rule was added
+ * follow it too.
+ */
+class SiteRegistry {
+public:
+    /**
+     * @brief Switch on matching sites
+     * @return Number of sites seen so far that match
+     */
+    static size_t enable(std::string_view file_glob, std::string_view function_glob = "*");
+
+    /**
+     * @brief Switch off matching sites, e.g. one function within an enabled file
+     * @return Number of sites seen so far that match
+     */
+    static size_t disable(std::string_view file_glob, std::string_view function_glob = "*");
+
+    /**
+     * @brief Drop every rule and switch all sites off
+     */
+    static void reset();
+
+    static std::vector<const LogSite*> sites();
+    static std::vector<const LogSite*> enabled_sites();
+
+    static bool glob_match(std::string_view pattern, std::string_view text);
+
+private:
+    friend class SiteSwitch;
+    static uint8_t enroll(SiteSwitch& control, const LogSite& site);
+    static size_t add_rule(std::string_view file_glob, std::string_view function_glob, bool enable);
+};
+
+inline uint8_t SiteSwitch::enroll(const LogSite& site) {
+    return SiteRegistry::enroll(*this, site);
+}
+
+struct SiteControlResponse {
+    bool success;
+    std::string message;
+    size_t matched_sites;
+
+    std::string to_json() const;
+};
+
+/**
+ * @brief Switch call sites on or off from a control endpoint (v1.2.0)
+ *
+ * The site counterpart of handle_level_change_request(): validates the
+ * request, applies it to the SiteRegistry and reports how many sites
+ * matched.
+ */
+SiteControlResponse handle_site_enable_request(const std::string& file_glob,
+                                               const std::string& function_glob = "*",
+                                               bool enable = true);
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "Zyrnix_features.hpp"
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <mutex>
 #include <memory>
@@ -10,15 +12,87 @@
 #include <deque>
 #include <map>
 #include <shared_mutex>
+#include <thread>
+#include <future>
+#include <span>
+#include "field.hpp"
 #include "log_sink.hpp"
 #include "log_level.hpp"
 #include "log_record.hpp"
+#include "lazy_message.hpp"
+#include "log_site.hpp"
+#include "backtrace_ring.hpp"
+#include "stack_trace.hpp"
+#include "rcu.hpp"
+#include "redaction.hpp"
+#ifndef XLOG_NO_RATE_LIMITING
+#include "dedup.hpp"
+#include "rate_limiter.hpp"
+#endif
+#if XLOG_HAS_FMT
+#include <fmt/format.h>
+#endif
+#ifndef XLOG_NO_ASYNC
+#include "async/async_queue.hpp"
+#include "async/record_pool.hpp"
+#include "sinks/isolated_sink.hpp"
+#endif
 
 namespace Zyrnix {
 
 #ifndef XLOG_NO_FILTERS
 class LogFilter;
 #endif
+class ChildLogger;
+struct ChildRegistry;
+class LevelRules;
+
+#ifndef XLOG_NO_ASYNC
+
+/**
+ * @brief Options for asynchronous logging (v1.2.0)
+ *
+ * In async mode the calling thread only builds a LogRecord and pushes it
+ * onto an AsyncQueue. Consumer threads run filtering, redaction,
+ * formatting and sink dispatch.
+ */
+struct AsyncOptions {
+    size_t worker_threads = 1;          // Number of consumer threads
+    size_t shutdown_timeout_ms = 5000;  // Max time to drain the queue on destruction
+    QueueBackend backend = QueueBackend::Mutex;
+    size_t queue_capacity = 8192;       // 0 = unbounded (Mutex backend only)
+    size_t lane_capacity = 1024;        // PerThreadLanes: slots per producer thread
+    OverflowPolicy overflow_policy = OverflowPolicy::Block;
+    size_t block_timeout_ms = 100;      // Block: max wait for space before dropping
+    size_t sample_rate = 10;            // Sample: keep 1 in N while saturated
+    size_t max_batch_size = 256;        // Records drained and dispatched per pass
+    WaitStrategy wait_strategy = WaitStrategy::Park;
+    size_t spin_iterations = 4000;      // SpinThenPark/Spin: pause rounds before yielding
+    size_t yield_iterations = 64;       // SpinThenPark/Spin: yield rounds before parking
+    size_t record_pool_size = 4096;     // Recycled records, 0 disables the pool
+    bool priority_lane = false;         // Drain records at or above priority_level first
+    LogLevel priority_level = LogLevel::Error;
+    size_t priority_capacity = 1024;
+    bool sync_critical = false;         // Fence the queue, then write Critical on the caller
+    size_t fence_timeout_ms = 1000;     // Max wait for the fence before writing anyway
+    double high_watermark = 0.75;       // Queue fill that raises Backpressure::Elevated, 0 = off
+    double low_watermark = 0.5;         // Queue fill at which pressure is back to Normal
+    TenantOptions tenants;              // Mutex backend: fair shares per tenant (v1.2.0)
+};
+#endif
+
+/**
+ * @brief What became of a record handed to try_log() (v1.2.0)
+ */
+enum class LogStatus {
+    Accepted,     // Written, or queued for the consumer (whose filters may still drop it)
+    DroppedFull,  // The async queue was full, or shutting down
+    Filtered,     // Below the level, or rejected by a filter on the calling thread
+    RateLimited   // Over the logger's set_rate_limit()
+};
+
+class LogMetrics;
+class SinkMetrics;
 
 struct LevelChangeEntry {
     LogLevel old_level;
@@ -30,65 +104,57 @@ struct LevelChangeEntry {
 struct TemporaryLevelChange {
     LogLevel original_level;
     std::chrono::system_clock::time_point revert_time;
+    std::chrono::steady_clock::time_point revert_deadline;  // Used for expiry checks (v1.2.0)
     bool active;
 };
 
 /**
- * @brief Reference-counted sink wrapper for thread-safe removal (v1.1.2)
+ * @brief A sink registered on a logger, optionally under a name (v1.1.2)
  */
 struct SinkEntry {
     LogSinkPtr sink;
     std::string name;
-    std::atomic<bool> marked_for_removal{false};
-    std::atomic<int> ref_count{0};
+    LogLevel level_override = LogLevel::Trace;  // From set_sink_level(); guarded by sinks_mtx_ (v1.2.0)
+    // Higher of level_override and the sink's own level, read once per
+    // record during fan-out; shared by every snapshot holding the entry (v1.2.0)
+    std::atomic<LogLevel> min_level;
+    // "<logger>.<name>", or "<logger>.sink<N>" when unnamed; set when the
+    // entry is first published, null for sinks that keep their own (v1.2.0)
+    std::shared_ptr<SinkMetrics> metrics;
     
     SinkEntry(LogSinkPtr s, std::string n = "") 
-        : sink(std::move(s)), name(std::move(n)) {}
+        : sink(std::move(s)), name(std::move(n)),
+          min_level(sink ? sink->get_level() : LogLevel::Trace) {}
 };
 
 using SinkEntryPtr = std::shared_ptr<SinkEntry>;
 
+#ifndef XLOG_NO_FILTERS
 /**
- * @brief RAII guard for sink reference counting (v1.1.2)
+ * @brief Immutable view of a logger's filters (v1.2.0)
+ *
+ * Swapped in through an RcuPtr by add_filter(), clear_filters() and
+ * set_filter_func(), so filters run concurrently on every logging
+ * thread without taking the logger's mutex. Filters must therefore be
+ * safe to call from several threads at once.
  */
-class SinkGuard {
-public:
-    explicit SinkGuard(SinkEntryPtr entry) : entry_(std::move(entry)) {
-        if (entry_) {
-            entry_->ref_count.fetch_add(1, std::memory_order_acquire);
-        }
-    }
-    
-    ~SinkGuard() {
-        if (entry_) {
-            entry_->ref_count.fetch_sub(1, std::memory_order_release);
-        }
-    }
-    
-    SinkGuard(const SinkGuard&) = delete;
-    SinkGuard& operator=(const SinkGuard&) = delete;
-    
-    SinkGuard(SinkGuard&& other) noexcept : entry_(std::move(other.entry_)) {
-        other.entry_ = nullptr;
-    }
-    
-    SinkGuard& operator=(SinkGuard&& other) noexcept {
-        if (this != &other) {
-            if (entry_) {
-                entry_->ref_count.fetch_sub(1, std::memory_order_release);
-            }
-            entry_ = std::move(other.entry_);
-            other.entry_ = nullptr;
-        }
-        return *this;
-    }
-    
-    LogSink* operator->() const { return entry_ ? entry_->sink.get() : nullptr; }
-    LogSink& operator*() const { return *entry_->sink; }
-    explicit operator bool() const { return entry_ && entry_->sink && !entry_->marked_for_removal; }
-    
-private:
-    SinkEntryPtr entry_;
+struct FilterChain {
+    std::vector<std::shared_ptr<LogFilter>> filters;
+    std::function<bool(const LogRecord&)> func;
+
+    bool empty() const { return filters.empty() && !func; }
+};
+#endif
+
+/**
+ * @brief Immutable view of a logger's sinks (v1.2.0)
+ *
+ * Rebuilt and swapped in through an RcuPtr whenever sinks are added or
+ * removed, so dispatch reads it without taking a lock. Per-sink levels
+ * live in the entries and change in place.
+ */
+struct SinkSnapshot {
+    std::vector<SinkEntryPtr> entries;
 };
 
 class Logger {
@@ -98,9 +164,28 @@ public:
 
     void add_sink(LogSinkPtr sink);
     void add_sink(LogSinkPtr sink, const std::string& name);
+#ifndef XLOG_NO_ASYNC
+    /**
+     * @brief Add a sink, optionally behind its own queue and worker (v1.2.0)
+     *
+     * With options.dedicated_worker the sink is wrapped in an IsolatedSink,
+     * so a slow sink cannot stall the others; its queue depth and drops are
+     * reported through MetricsRegistry::get_sink_metrics(name).
+     */
+    void add_sink(LogSinkPtr sink, const std::string& name, const SinkOptions& options);
+#endif
     void clear_sinks();
     bool remove_sink(const std::string& name, bool wait_for_completion = true);
 
+    /**
+     * @brief Swap the first sink registered under name for sink (v1.2.0)
+     *
+     * One snapshot change, so no record misses both sinks; the entry keeps
+     * its set_sink_level() override. Waits until the old sink is no longer
+     * written to. Returns false if no sink has that name.
+     */
+    bool replace_sink(const std::string& name, LogSinkPtr sink);
+
     // PII/Sensitive data redaction
     void set_redact_patterns(const std::vector<std::string>& patterns);
     void clear_redact_patterns();
@@ -125,17 +210,264 @@ public:
      */
     size_t sink_count() const;
     
-    void log(LogLevel level, const std::string& message);
+    /**
+     * @brief Log message at level
+     *
+     * Takes a view, so literals and std::string both log without a copy.
+     * In sync mode with no filters the text is handed to the sinks as-is;
+     * a record is only materialized for filters or the async queue.
+     */
+    void log(LogLevel level, std::string_view message);
+
+    /**
+     * @brief Log message at site's level, tagged with the call site (v1.2.0)
+     *
+     * What the XLOG_* macros call. The site is built at compile time and
+     * records only point at it, so sinks and patterns (%s, %#, %!) get
+     * the location without any per-call string work.
+     */
+    void log(const LogSite& site, std::string_view message);
+
+    /**
+     * @brief Log a line a rate-limited macro let through (v1.2.0)
+     *
+     * What XLOG_*_EVERY_N and XLOG_*_EVERY_MS call. suppressed is how many
+     * calls the site held back since its last line; when non-zero it is
+     * appended as " [N suppressed]" and counted as filtered in this
+     * logger's LogMetrics.
+     */
+    void log_limited(const LogSite& site, uint64_t suppressed, std::string_view message);
+
+    /**
+     * @brief Log message if it can be done without waiting, and say what became of it (v1.2.0)
+     *
+     * As log(), except that a full async queue rejects the record at once
+     * whatever the overflow policy, instead of blocking the caller:
+     *
+     *     if (logger->try_log(LogLevel::Info, line) == LogStatus::DroppedFull) {
+     *         ++shed;
+     *     }
+     *
+     * Filters run on the calling thread only in sync mode, so an async
+     * logger reports Accepted for anything it queued.
+     */
+    LogStatus try_log(LogLevel level, std::string_view message);
+    LogStatus try_log(const LogSite& site, std::string_view message);
+
+    /**
+     * @brief Count calls a rate-limited site held back, with no line to
+     *        report them on (v1.2.0)
+     */
+    void record_suppressed(uint64_t count);
+
+    /**
+     * @brief Log at site's level the message make builds, building it only if logged (v1.2.0)
+     *
+     * What XLOG_*_LAZY calls. make runs on the calling thread, unless it
+     * is wrapped in deferrable() and this logger is async: then the
+     * closure is queued and the consumer thread runs it (deferred.hpp,
+     * which the macros include). A deferrable closure below the logger's
+     * level goes into the backtrace ring unrun.
+     */
+    template <class F>
+        requires LazyMessage<F> || is_deferrable_v<std::decay_t<F>>
+    void log_lazy(const LogSite& site, F&& make) {
+        if (!may_log(site)) {
+            return;
+        }
+#if XLOG_HAS_FMT
+        if constexpr (is_deferrable_v<std::decay_t<F>>) {
+            if (defer_lazy(site, make.fn)) {
+                return;
+            }
+        }
+#endif
+        decltype(auto) message = build_lazy(make);
+        log_at(site.level, std::string_view(message), &site);
+    }
+
+    /**
+     * @brief Flush every sink, including records still queued (v1.2.0)
+     *
+     * In async mode a fence record is pushed through the queue; the future
+     * becomes ready once every record logged before the call has been
+     * written and each sink's flush() has returned. In sync mode the sinks
+     * are flushed on the calling thread and the future is already ready.
+     * If the queue drops the fence at shutdown the future reports
+     * std::future_error (broken_promise).
+     */
+    std::future<void> flush();
+
+    void trace(std::string_view msg);
+    void debug(std::string_view msg);
+    void info(std::string_view msg);
+    void warn(std::string_view msg);
+    void error(std::string_view msg);
+    void critical(std::string_view msg);
+
+    /**
+     * @brief Log message with typed fields (v1.2.0)
+     *
+     *     logger->info("request done", kv("status", 200), kv("latency_ms", 3.2), kv("ok", true));
+     *
+     * The fields are built on the caller's stack and go into the record's
+     * fields, winning over context fields of the same name; JSON sinks
+     * write numbers and booleans unquoted.
+     */
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void log(LogLevel level, std::string_view message, Fields&&... fields) {
+        if (sinks_accept(level)) {
+            Field list[] = {Field(std::forward<Fields>(fields))...};
+            log_fields(level, message, list);
+        }
+    }
+
+    /**
+     * @brief As above, for fields collected at run time
+     */
+    void log_fields(LogLevel level, std::string_view message, std::span<Field> fields);
+
+    /**
+     * @brief Log a batch of records built by the caller, paying per call
+     *        rather than per record for what they share (v1.2.0)
+     *
+     * For producers with thousands of lines at a time (importers, replay
+     * tools). Each record needs its level and message, and may carry
+     * fields, a site and a trace; an empty logger_name, a zero timestamp
+     * or thread_id and an unset trace are filled in from this logger and
+     * the calling thread, and the thread's context fields are added as
+     * log() would add them. The level, the temporary level and the rate
+     * limit are checked once for the batch; an async logger then claims
+     * queue space for it in one step (AsyncQueue::push_bulk), while a
+     * sync one runs the filters and redaction under one snapshot and
+     * hands each sink the whole batch through LogSink::log_batch(), as
+     * the async consumer does.
+     *
+     * The records are moved from. Returns how many were queued (async) or
+     * reached the sinks (sync).
+     */
+    size_t log_batch(std::span<LogRecord> records);
+
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void trace(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Trace, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void debug(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Debug, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void info(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Info, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void warn(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Warn, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void error(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Error, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void critical(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Critical, message, std::forward<Fields>(fields)...);
+    }
+
+#if XLOG_HAS_FMT
+    /**
+     * @brief Format with fmt and log, only if level is enabled (v1.2.0)
+     *
+     * The format string is checked at compile time (wrap runtime strings
+     * in fmt::runtime()). A disabled call is one atomic load and never
+     * touches the arguments; an enabled one formats into a per-thread
+     * buffer that is logged as a view.
+     */
+    // Not for Fields, which go to the typed-field overloads
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void log(LogLevel level, fmt::format_string<Args...> format, Args&&... args) {
+        if (may_log(level)) {
+            vlog(level, format, fmt::make_format_args(args...));
+        }
+    }
+
+    template <class... Args>
+    void log(const LogSite& site, fmt::format_string<Args...> format, Args&&... args) {
+        if (may_log(site)) {
+            vlog(site.level, format, fmt::make_format_args(args...), &site);
+        }
+    }
+
+    template <class... Args>
+    void log_limited(const LogSite& site, uint64_t suppressed, fmt::format_string<Args...> format, Args&&... args) {
+        record_suppressed(suppressed);
+        if (may_log(site)) {
+            vlog(site.level, format, fmt::make_format_args(args...), &site, suppressed);
+        }
+    }
 
-    void trace(const std::string& msg);
-    void debug(const std::string& msg);
-    void info(const std::string& msg);
-    void warn(const std::string& msg);
-    void error(const std::string& msg);
-    void critical(const std::string& msg);
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void trace(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Trace, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void debug(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Debug, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void info(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Info, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void warn(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Warn, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void error(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Error, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+        requires(!FieldPack<Args...>)
+    void critical(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Critical, format, std::forward<Args>(args)...);
+    }
+#endif
     
     void set_level(LogLevel level);
-    LogLevel get_level() const;
+    LogLevel get_level() const { return min_level(); }
+
+    /**
+     * @brief Lowest level that can reach any sink (v1.2.0)
+     *
+     * The logger's level, raised to the lowest level any of its sinks
+     * accepts (sink levels and overrides). Records below it are rejected
+     * at the top of log() and by the XLOG_* macros, before anything is
+     * built. Inline and one load of a word only configuration changes
+     * write, so a disabled XLOG_* call costs a compare; while a temporary
+     * level is set, a coarse clock read and a second load as well.
+     */
+    LogLevel get_effective_level() const {
+        const uint32_t word = levels_.load(std::memory_order_relaxed);
+        const LogLevel floor = sink_floor_of(word);
+        // Records below the logger's level still go to the backtrace ring,
+        // and a temporary level past its deadline is settled by log()
+        if ((word & backtrace_bit) || temporary_level_lapsed(word)) {
+            return floor;
+        }
+        return std::max(min_level_of(word), floor);
+    }
     
     using LogLevelChangeCallback = std::function<void(LogLevel old_level, LogLevel new_level)>;
     void set_level_dynamic(LogLevel level);  
@@ -143,7 +475,23 @@ public:
     void clear_level_change_callbacks();
     
     void set_level_dynamic(LogLevel level, const std::string& reason);
+
+    /**
+     * @brief Set this logger's and its children's levels from rules matching their names (v1.2.0)
+     *
+     * Stored straight into the levels, without history or callbacks; see
+     * LoggerRegistry::set_level_rules(). Under a temporary level, the rule
+     * sets the level it reverts to.
+     */
+    void apply_level_rules(const LevelRules& rules);
     
+    /**
+     * @brief Raise one sink's level above its own (v1.2.0)
+     *
+     * The override belongs to the sink, so it stays with it when other
+     * sinks are removed. By name, it applies to every sink currently
+     * registered under that name; names with no sink are ignored.
+     */
     void set_sink_level(size_t sink_index, LogLevel level);
     void set_sink_level(const std::string& sink_name, LogLevel level);
     void clear_sink_level_overrides();
@@ -160,47 +508,357 @@ public:
     
 #ifndef XLOG_NO_FILTERS
     void add_filter(std::shared_ptr<LogFilter> filter);
+    // Replace every filter at once; the filter function is kept (v1.2.0)
+    void set_filters(std::vector<std::shared_ptr<LogFilter>> filters);
     void clear_filters();
     void set_filter_func(std::function<bool(const LogRecord&)> func);
 #endif
+
+#ifndef XLOG_NO_RATE_LIMITING
+    /**
+     * @brief Collapse repeated lines into one summary per window (v1.2.0)
+     *
+     * Runs after the filters, just before sink fan-out: on the calling
+     * thread in sync mode, on the consumer in async mode. The first line
+     * of a run is written and its repeats turn into one line ending in
+     * " [repeated N more times, first ..., last ...]". flush() and the
+     * destructor write summaries still pending. Held-back repeats count as
+     * filtered in this logger's LogMetrics.
+     */
+    void set_dedup(const DedupOptions& options = DedupOptions{});
+    void clear_dedup();
+#endif
+
+#ifndef XLOG_NO_RATE_LIMITING
+    /**
+     * @brief Cap the records this logger and its children take per second (v1.2.0)
+     *
+     * A token bucket checked on the calling thread once a record is past
+     * the level, before anything is built or queued. Records over the rate
+     * are counted as filtered in this logger's LogMetrics, and try_log()
+     * reports them as RateLimited.
+     */
+    void set_rate_limit(const RateLimiterOptions& options);
+    void clear_rate_limit();
+#endif
+
+#if XLOG_HAS_FMT
+    /**
+     * @brief Log through a deferred-formatting call site (v1.2.0)
+     *
+     * Used by the XLOG_*_DEFERRED macros (deferred.hpp). In async mode
+     * only the raw argument bytes are copied into a pooled record and a
+     * consumer thread formats them; otherwise this formats right away.
+     */
+    template <class... Args>
+    void log_deferred(const DeferredSite& site, const Args&... args);
+#endif
+
+    /**
+     * @brief Keep the last records below the logger's level for forensics (v1.2.0)
+     *
+     * Records the logger would otherwise reject are copied into a ring of
+     * capacity slots instead, unformatted where they came from an
+     * XLOG_*_DEFERRED site. When a record at dump_level or above is
+     * logged, or on dump_backtrace(), the ring is replayed to the sinks
+     * ahead of it, oldest first, between "backtrace start" and
+     * "backtrace end" lines. Replayed records skip the logger's level;
+     * filters and sink levels still apply, so a sink set to Info will not
+     * show them. Calling it again replaces the ring.
+     */
+    void enable_backtrace(size_t capacity, LogLevel dump_level = LogLevel::Error);
+    void disable_backtrace();
+    void dump_backtrace();
+
+    /**
+     * @brief Attach the call stack to records at level and above (v1.2.0)
+     *
+     * The logging thread only records up to max_frames return addresses
+     * (StackTrace::capture(), about a microsecond); the frames are
+     * symbolized on the async consumer, through the process-wide
+     * SymbolCache, or by the first sink to render them in sync mode.
+     * Formatters write them under the line, structured encoders as a
+     * stack_trace member (error.stack_trace for ECS) and OtlpLogSink as
+     * the exception.stacktrace attribute.
+     */
+    void enable_stack_traces(LogLevel level = LogLevel::Error, size_t max_frames = 32);
+    void disable_stack_traces();
+    bool has_backtrace() const { return backtrace_on(); }
+
+    /**
+     * @brief Named logger for one component, sharing this logger's sinks (v1.2.0)
+     *
+     *     ChildLogger* pool = logger->child("db.pool");  // logs as "<name>.db.pool"
+     *
+     * The child writes through this logger's sinks, filters, redaction,
+     * dedup and async queue; it only has its own name and, optionally, its
+     * own level (see ChildLogger). Asking for the same name again returns
+     * the same child. Children are owned by this logger and live as long
+     * as it does.
+     */
+    ChildLogger* child(std::string_view name);
     
     static std::shared_ptr<Logger> create_stdout_logger(const std::string& name);
     
 #ifndef XLOG_NO_ASYNC
     static std::shared_ptr<Logger> create_async(const std::string& name);
+    static std::shared_ptr<Logger> create_async(const std::string& name, const AsyncOptions& options);
+
+    /**
+     * @brief Switch this logger to asynchronous dispatch (v1.2.0)
+     *
+     * Starts the consumer threads. Must be called before the logger is
+     * shared with other threads; calling it on an async logger is a no-op.
+     */
+    void enable_async(const AsyncOptions& options = AsyncOptions());
+    bool is_async() const { return async_queue_ != nullptr; }
+
+    /**
+     * @brief How full the async queue is; Normal in sync mode (v1.2.0)
+     *
+     * One relaxed load, cheap enough to check before building a line:
+     * callers can log shorter lines or skip optional ones while it is not
+     * Normal. The watermarks come from AsyncOptions.
+     */
+    Backpressure backpressure() const {
+        return async_queue_ ? async_queue_->pressure() : Backpressure::Normal;
+    }
+
+    /**
+     * @brief Be told of every backpressure transition (v1.2.0)
+     *
+     * Called on the logging or consumer thread that crossed the
+     * watermark, with the state before and after. Callbacks may log, but
+     * must not register or clear callbacks.
+     */
+    using BackpressureCallback = std::function<void(Backpressure previous, Backpressure current)>;
+    void register_backpressure_callback(BackpressureCallback callback);
+    void clear_backpressure_callbacks();
 #endif
     
     std::string name;
 
 private:
+    friend class ChildLogger;
+
+    // levels_ holds the logger's level in its low byte, the lowest
+    // SinkEntry::min_level in the next, backtrace_bit while the backtrace
+    // ring is on, floor_stale_bit from a sink's set_level() until the
+    // floor is recomputed and temp_level_bit while the level is a
+    // temporary one, so a level check reads one word. Writers change
+    // their part with update_levels()
+    static constexpr uint32_t level_mask = 0xFF;
+    static constexpr uint32_t floor_shift = 8;
+    static constexpr uint32_t backtrace_bit = 1u << 16;
+    static constexpr uint32_t floor_stale_bit = 1u << 17;
+    static constexpr uint32_t temp_level_bit = 1u << 18;
+    static LogLevel min_level_of(uint32_t word) { return static_cast<LogLevel>(word & level_mask); }
+    static LogLevel sink_floor_of(uint32_t word) { return static_cast<LogLevel>((word >> floor_shift) & level_mask); }
+    LogLevel min_level(std::memory_order order = std::memory_order_relaxed) const {
+        return min_level_of(levels_.load(order));
+    }
+    LogLevel sink_floor() const { return sink_floor_of(levels_.load(std::memory_order_relaxed)); }
+    // Called at the top of log(): brings the floor and each entry's
+    // min_level up to date after a LogSink::set_level()
+    void settle_sink_floor() {
+        if (levels_.load(std::memory_order_relaxed) & floor_stale_bit) {
+            refresh_sink_floor();
+        }
+    }
+    void refresh_sink_floor();
+    // A sink's set_level(): the floor drops to Trace until log() settles
+    // it, so nothing a sink may now take is rejected before then
+    struct FloorWatcher final : SinkLevelWatcher {
+        explicit FloorWatcher(Logger* l) : logger(l) {}
+        void sink_level_changed() override {
+            logger->update_levels((level_mask << floor_shift) | floor_stale_bit, floor_stale_bit);
+        }
+        Logger* logger;
+    };
+    // Past temp_level_deadline_ on the coarse clock, which never runs
+    // ahead of the one log() settles it by; only read with the bit set
+    bool temporary_level_lapsed(uint32_t word) const {
+        return (word & temp_level_bit) && temporary_level_due();
+    }
+    bool temporary_level_due() const;
+    bool backtrace_on() const { return (levels_.load(std::memory_order_relaxed) & backtrace_bit) != 0; }
+    // Replaces the bits under mask with bits; returns the word before
+    uint32_t update_levels(uint32_t mask, uint32_t bits) {
+        uint32_t word = levels_.load(std::memory_order_relaxed);
+        while (!levels_.compare_exchange_weak(word, (word & ~mask) | bits, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+        }
+        return word;
+    }
+    LogLevel exchange_min_level(LogLevel level) {
+        return min_level_of(update_levels(level_mask, static_cast<uint32_t>(level)));
+    }
+
+    bool sinks_accept(LogLevel level) const {
+        return level >= sink_floor();
+    }
+#if XLOG_HAS_FMT
+    // A temporary level past its deadline falls through to log(), which
+    // settles it
+    bool may_log(LogLevel level) const {
+        const uint32_t word = levels_.load(std::memory_order_relaxed);
+        return level >= sink_floor_of(word) &&
+               (level >= min_level_of(word) || (word & backtrace_bit) || temporary_level_lapsed(word));
+    }
+    bool may_log(const LogSite& site) const {
+        return may_log(site.level) || (sinks_accept(site.level) && site.forced());
+    }
+    void vlog(LogLevel level, fmt::string_view format, fmt::format_args args, const LogSite* site = nullptr,
+              uint64_t suppressed = 0);
+#ifndef XLOG_NO_ASYNC
+    bool defers(LogLevel level) const {
+        return async_queue_ && !(sync_critical_ && level == LogLevel::Critical);
+    }
+    LogRecord acquire_record();
+    // record.message holds what deferred decodes, site is where it was logged
+    void push_deferred(const LogSite& site, const DeferredSite& deferred, LogRecord&& record);
+#endif
+    // Queues fn, or captures it for the backtrace ring; false to run it now
+    template <class F>
+    bool defer_lazy(const LogSite& site, const F& fn);
+#endif
+
     std::vector<std::string> redact_patterns_;
     std::vector<std::string> redact_regex_patterns_;
     std::vector<std::string> redact_pii_presets_;
     bool redact_cloud_only_ = false;
+    RcuPtr<Redactor> redactor_;  // nullptr when redaction is off (v1.2.0)
+#ifndef XLOG_NO_RATE_LIMITING
+    RcuPtr<Deduplicator> dedup_;  // nullptr when repeats are not collapsed; writers hold mtx_
+    struct RateLimit {
+        explicit RateLimit(const RateLimiterOptions& options) : limiter(options) {}
+        mutable RateLimiter limiter;  // Spent through the RcuPtr's const view
+    };
+    RcuPtr<RateLimit> rate_limit_;  // nullptr when unlimited; writers hold mtx_
+#endif
+    void rebuild_redactor();
     bool should_log(const LogRecord& record) const;
     void check_temporary_level_expiry();
     void record_level_change(LogLevel old_level, LogLevel new_level, const std::string& reason);
-    void cleanup_removed_sinks(); 
-    void wait_for_sink_drain(SinkEntryPtr& entry); 
-    
+    uint64_t publish_sinks();
+    void update_sink_floor();
+    void wait_for_sink_drain(uint64_t grace_epoch);
+    // may_block false: a full queue rejects the record instead of waiting
+    LogStatus log_at(LogLevel level, std::string_view message, const LogSite* site, bool may_block = true);
+    // Past the level checks; child names the ChildLogger it came through, if any
+    LogStatus emit(LogLevel level, std::string_view message, const LogSite* site, const ChildLogger* child,
+                   bool may_block = true);
+#ifndef XLOG_NO_RATE_LIMITING
+    // With no limit set, one relaxed load
+    bool over_rate_limit() const {
+        return rate_limit_on_.load(std::memory_order_relaxed) && rate_limited();
+    }
+    bool rate_limited() const;
+    size_t rate_limited_batch(size_t count) const;  // How many of count to keep
+#endif
+    void emit_fields(LogLevel level, std::string_view message, std::span<Field> fields, const ChildLogger* child);
+    ChildLogger* make_child(const ChildLogger* parent, std::string_view name);
+    void capture_backtrace(LogLevel level, std::string_view message, const LogSite* site,
+                           const DeferredSite* deferred);
+    // nullptr unless stack traces are on for level
+    std::shared_ptr<StackTrace> capture_stack(LogLevel level) const {
+        if (level < stack_level_.load(std::memory_order_relaxed) ||
+            !stack_traces_on_.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return StackTrace::capture(stack_frames_.load(std::memory_order_relaxed));
+    }
+    // On a record that got past the logger's level
+    void maybe_dump_backtrace(LogLevel level) {
+        if (backtrace_on() && level >= backtrace_dump_level_.load(std::memory_order_relaxed)) {
+            dump_backtrace();
+        }
+    }
+    void dispatch(const LogRecord& record);
+    void dispatch(const FormattedRecord& plain);
+    void fan_out(const FormattedRecord& plain);
+    // Returns how many records got past the filters and the deduplicator
+    size_t dispatch_batch(std::span<LogRecord> batch);
+#ifndef XLOG_NO_ASYNC
+    void dispatch_async_batch(std::vector<LogRecord>& batch, std::shared_lock<std::shared_mutex>& in_flight);
+    bool push_fence(const std::shared_ptr<LogFence>& fence, std::chrono::steady_clock::time_point deadline);
+    bool fence_async(std::chrono::milliseconds timeout);
+#endif
+    void flush_sinks();
+#ifndef XLOG_NO_RATE_LIMITING
+    void replace_dedup(std::unique_ptr<Deduplicator> next);
+    void write_summaries(const std::vector<RepeatSummary>& summaries);
+    void flush_repeats();
+#endif
 
-    std::vector<SinkEntryPtr> sink_entries_;
-    mutable std::shared_mutex sinks_mtx_;  
+#ifndef XLOG_NO_ASYNC
+    void async_worker_loop();
+    bool enqueue_async(LogRecord&& record, bool may_block = true);
+    size_t enqueue_async_batch(std::span<LogRecord> records);
+    void notify_backpressure(Backpressure previous, Backpressure current);
+    void stop_async();
+
+    std::unique_ptr<AsyncQueue> async_queue_;
+    std::unique_ptr<RecordPool> record_pool_;
+    std::vector<std::thread> async_workers_;
+    size_t async_batch_size_ = 256;
+    bool sync_critical_ = false;
+    std::chrono::milliseconds fence_timeout_{1000};
+    // Workers hold this shared while dispatching; a fence takes it
+    // exclusively so batches popped by other workers finish first.
+    std::shared_mutex dispatch_mtx_;
+    std::vector<BackpressureCallback> backpressure_callbacks_;
+    std::mutex backpressure_mtx_;
+#endif
+    std::shared_ptr<LogMetrics> metrics_;  // From MetricsRegistry by name; null under XLOG_NO_METRICS
+
+    // Read by every log call and written only by configuration changes,
+    // so they share a cache line with nothing else: the mutexes and
+    // vectors around them are written under load and would otherwise
+    // keep taking the line away from disabled calls on other cores
+    alignas(64) std::atomic<uint32_t> levels_{0};  // Trace, Trace, no backtrace
+    // Set while any filter is installed; without one, sync log() needs
+    // neither a LogRecord nor mtx_
+    std::atomic<bool> has_filters_{false};
+#ifndef XLOG_NO_RATE_LIMITING
+    std::atomic<bool> rate_limit_on_{false};
+#endif
+    // Steady-clock ticks of temp_level_.revert_deadline, 0 when no
+    // temporary level is set, so log() can skip the check with one load.
+    std::atomic<int64_t> temp_level_deadline_{0};
+    RcuPtr<SinkSnapshot> sinks_;  // Readers only load it; see sink_entries_
+
+    // Writers edit sink_entries_ under sinks_mtx_ and publish a new
+    // snapshot to sinks_.
+    alignas(64) std::vector<SinkEntryPtr> sink_entries_;
+    mutable std::mutex sinks_mtx_;
+    // The distinct sinks of sink_entries_, each told of floor_watcher_;
+    // guarded by sinks_mtx_
+    std::vector<LogSinkPtr> watched_sinks_;
+    FloorWatcher floor_watcher_{this};
+    void watch_sinks();
     
 #ifndef XLOG_NO_FILTERS
-    std::vector<std::shared_ptr<LogFilter>> filters_;
-    std::function<bool(const LogRecord&)> filter_func_;
+    // Writers copy the chain under mtx_ and publish the copy
+    RcuPtr<FilterChain> filters_;
+    void publish_filters(std::unique_ptr<FilterChain> chain);
 #endif
-    std::atomic<LogLevel> min_level_;
+
+    // Swapped under mtx_; backtrace_bit lets log() skip the ring with one load
+    RcuPtr<BacktraceRing> backtrace_;
+    std::atomic<LogLevel> backtrace_dump_level_{LogLevel::Error};
+    std::atomic<bool> stack_traces_on_{false};
+    std::atomic<LogLevel> stack_level_{LogLevel::Error};
+    std::atomic<size_t> stack_frames_{32};
     std::vector<LogLevelChangeCallback> level_change_callbacks_;
     
-    std::map<size_t, LogLevel> sink_level_overrides_;
-    std::map<std::string, LogLevel> sink_level_overrides_by_name_;
     
     std::deque<LevelChangeEntry> level_history_;
     size_t max_history_entries_ = 100;
     
     TemporaryLevelChange temp_level_;
+
+    std::unique_ptr<ChildRegistry> children_;  // Created by the first child(); guarded by mtx_
     
     mutable std::mutex mtx_;  
 };
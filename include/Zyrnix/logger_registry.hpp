@@ -0,0 +1,135 @@
+#pragma once
+#include "logger.hpp"
+#include "level_rules.hpp"
+#include "rcu.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Zyrnix {
+
+class LoggerRegistry;
+
+/**
+ * @brief A registry name that follows whatever logger is registered under it (v1.2.0)
+ *
+ * Taken once with LoggerRegistry::handle(); after that no lookup is done,
+ * and a hot reload that replaces the logger is seen on the next call.
+ *
+ *     static LoggerHandle log = LoggerRegistry::instance().handle("http");
+ *     log->info("request done");
+ *     XLOG_INFO(log, "took {} ms", ms);
+ *
+ * While no logger is registered under the name, calls through -> go to a
+ * logger with no sinks. operator-> pins the logger with an epoch read
+ * section until the end of the full expression; keep get() for longer.
+ */
+class LoggerHandle {
+public:
+    struct Cell;
+
+    class Pinned {
+    public:
+        explicit Pinned(const Cell* cell);
+        Logger* operator->() const { return logger_; }
+
+    private:
+        EpochDomain::ReadGuard read_;
+        Logger* logger_;
+    };
+
+    LoggerHandle() = default;
+
+    /**
+     * @brief The logger registered now, or nullptr
+     */
+    LoggerPtr get() const;
+    explicit operator bool() const;
+    Pinned operator->() const;
+    std::string_view name() const;
+
+private:
+    friend class LoggerRegistry;
+    explicit LoggerHandle(const Cell* cell) : cell_(cell) {}
+
+    const Cell* cell_ = nullptr;
+};
+
+/**
+ * @brief Process-wide loggers by name, read without locks (v1.2.0)
+ *
+ * The names map to an immutable hash table behind an RcuPtr, so get() is
+ * one epoch read section, one lookup and a reference count, and never
+ * waits for a writer. Writers build the next table under a mutex and
+ * swap it in whole, so a reload of many loggers is seen all at once.
+ * Replaced loggers are released after a grace period, on the writer.
+ *
+ * Level rules set with set_level_rules() are applied to each logger when
+ * it is registered and to its children when they are made.
+ */
+class LoggerRegistry {
+public:
+    static LoggerRegistry& instance();
+
+    LoggerPtr get(std::string_view name) const;
+    LoggerHandle handle(std::string_view name);
+
+    /**
+     * @brief Register logger under its name, replacing any logger there
+     */
+    void add(LoggerPtr logger);
+    bool remove(std::string_view name);
+
+    /**
+     * @brief Register or replace each of loggers and drop removed, in one swap
+     */
+    void update(const std::map<std::string, LoggerPtr>& loggers, const std::vector<std::string>& removed = {});
+
+    std::map<std::string, LoggerPtr> get_all() const;
+    size_t size() const;
+
+    /**
+     * @brief Replace the level rules and apply them to every registered logger
+     *
+     * One pass over the loggers and their children; each name a rule
+     * matches gets the rule's level, stored without level history or
+     * callbacks. A name no rule matches keeps the level it has.
+     */
+    void set_level_rules(LevelRules rules);
+    LevelRules level_rules() const;
+
+    /**
+     * @brief The level the current rules give name, if any rule matches
+     */
+    std::optional<LogLevel> rule_level(std::string_view name) const;
+
+    LoggerRegistry(const LoggerRegistry&) = delete;
+    LoggerRegistry& operator=(const LoggerRegistry&) = delete;
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+    // Keys view Cell names, which never move
+    using Table = std::unordered_map<std::string_view, LoggerPtr, StringHash, std::equal_to<>>;
+
+    LoggerRegistry();
+    ~LoggerRegistry();
+
+    LoggerHandle::Cell* cell(std::string_view name);  // Caller holds mtx_
+    uint64_t publish(std::unique_ptr<Table> next);      // Caller holds mtx_
+    void release_replaced(uint64_t grace);
+
+    RcuPtr<Table> table_;
+    RcuPtr<LevelRules> rules_;  // Published under mtx_
+    mutable std::mutex mtx_;
+    std::unordered_map<std::string_view, std::unique_ptr<LoggerHandle::Cell>, StringHash, std::equal_to<>> cells_;
+};
+
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include "log_level.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Zyrnix {
+
+struct MemoryBudgetOptions {
+    size_t limit_bytes = 0;                  // Process-wide cap on buffered bytes, 0 = no budget
+    double sample_fill = 0.8;                // Fill at which records below sample_below are sampled
+    size_t sample_rate = 10;                 // Keep 1 in N of them while sampling
+    LogLevel sample_below = LogLevel::Warn;
+    LogLevel drop_below = LogLevel::Error;   // Dropped once the budget or a share is used up
+};
+
+/**
+ * @brief How much of the budget is in use (v1.2.0)
+ */
+enum class BudgetState : uint8_t {
+    Normal,
+    Sampling,  // Past sample_fill
+    Shedding   // Used up: only drop_below and above get in
+};
+
+struct BudgetAccountUsage {
+    std::string name;
+    size_t used = 0;
+    size_t share = 0;  // Bytes, 0 = none of its own
+};
+
+struct MemoryBudgetStats {
+    size_t limit = 0;
+    size_t used = 0;
+    BudgetState state = BudgetState::Normal;
+    uint64_t sampled_out = 0;
+    uint64_t dropped = 0;
+    std::vector<BudgetAccountUsage> accounts;
+};
+
+class BudgetAccount;
+
+/**
+ * @brief One byte budget for every queue and sink buffer in the process (v1.2.0)
+ *
+ * Async queues, the HTTP sinks' event queues and SignalSafeSink's ring
+ * each charge a BudgetAccount for what they hold. Near the limit records
+ * below sample_below are sampled; at the limit, records below drop_below
+ * are dropped and the rest still get in, so an error is never lost to a
+ * chatty debug logger. An account can also be given a share of the limit
+ * by name (an async logger's queue is named after its logger), which
+ * caps it the same way on its own.
+ *
+ *     Zyrnix::MemoryBudget::instance().configure({.limit_bytes = 64 << 20});
+ *     Zyrnix::MemoryBudget::instance().set_share("payments", 0.25);
+ *
+ * Configure it before creating loggers and sinks: accounts opened while
+ * there is no budget stay out of it. Accounts charge the process total
+ * in 16 KB steps, so logging threads rarely touch a shared cache line
+ * and the total reads up to 16 KB per account low.
+ */
+class MemoryBudget {
+public:
+    static MemoryBudget& instance();
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * @brief Set the limit and degrade thresholds; 0 stops limiting
+     */
+    void configure(const MemoryBudgetOptions& options);
+
+    /**
+     * @brief Cap accounts named account at fraction of the limit
+     *
+     * Each account of that name gets the share to itself. 0 removes it.
+     */
+    void set_share(const std::string& account, double fraction);
+    void clear_shares();
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+    size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+    BudgetState state() const;
+
+    MemoryBudgetStats stats() const;
+
+    static constexpr size_t granule = 16 * 1024;
+
+private:
+    friend class BudgetAccount;
+
+    MemoryBudget() = default;
+
+    void attach(BudgetAccount* account);
+    void detach(BudgetAccount* account);
+    size_t share_bytes(const std::string& account) const;  // Under mutex_
+
+    std::atomic<bool> enabled_{false};  // Set by the first configure() with a limit
+    std::atomic<size_t> limit_{0};
+    std::atomic<size_t> sample_at_{0};
+    std::atomic<size_t> sample_permille_{800};
+    std::atomic<size_t> sample_rate_{10};
+    std::atomic<LogLevel> sample_below_{LogLevel::Warn};
+    std::atomic<LogLevel> drop_below_{LogLevel::Error};
+    alignas(64) std::atomic<size_t> used_{0};
+    std::atomic<uint64_t> sampled_out_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    mutable std::mutex mutex_;
+    std::vector<BudgetAccount*> accounts_;
+    std::vector<std::pair<std::string, double>> shares_;
+};
+
+/**
+ * @brief What one queue or buffer charges against the MemoryBudget (v1.2.0)
+ *
+ * Inactive, and free to call, when no budget was configured at
+ * construction. Whatever is still charged is returned on destruction.
+ */
+class BudgetAccount {
+public:
+    explicit BudgetAccount(std::string name);
+    ~BudgetAccount();
+
+    BudgetAccount(const BudgetAccount&) = delete;
+    BudgetAccount& operator=(const BudgetAccount&) = delete;
+
+    bool active() const { return budget_ != nullptr; }
+    const std::string& name() const { return name_; }
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Whether a record of level taking bytes may be buffered
+     *
+     * Applies the degrade path and counts what it turns away.
+     */
+    bool admit(LogLevel level, size_t bytes);
+
+    void charge(size_t bytes) {
+        if (budget_ && bytes > 0) {
+            const size_t before = used_.fetch_add(bytes, std::memory_order_relaxed);
+            if (const size_t steps = (before + bytes) / MemoryBudget::granule - before / MemoryBudget::granule) {
+                budget_->used_.fetch_add(steps * MemoryBudget::granule, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void release(size_t bytes) {
+        if (budget_ && bytes > 0) {
+            const size_t before = used_.fetch_sub(bytes, std::memory_order_relaxed);
+            if (const size_t steps = before / MemoryBudget::granule - (before - bytes) / MemoryBudget::granule) {
+                budget_->used_.fetch_sub(steps * MemoryBudget::granule, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // admit(), then charge() if it passed
+    bool try_charge(LogLevel level, size_t bytes) {
+        if (!budget_) {
+            return true;
+        }
+        if (!admit(level, bytes)) {
+            return false;
+        }
+        charge(bytes);
+        return true;
+    }
+
+private:
+    friend class MemoryBudget;
+
+    const std::string name_;
+    MemoryBudget* budget_ = nullptr;
+    std::atomic<size_t> used_{0};
+    std::atomic<size_t> share_{0};  // Set under the budget's mutex_
+    std::atomic<uint64_t> sample_counter_{0};
+};
+
+}
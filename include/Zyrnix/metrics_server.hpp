@@ -0,0 +1,73 @@
+#pragma once
+#include "log_metrics.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace Zyrnix {
+
+/**
+ * @brief Options for MetricsServer (v1.2.0)
+ */
+struct MetricsServerOptions {
+    std::string address = "127.0.0.1";  // Numeric IPv4 address to listen on
+    uint16_t port = 9464;                // 0 picks a free port; see MetricsServer::port()
+    std::string path = "/metrics";
+    std::string prefix = "Zyrnix";       // Metric name prefix
+    std::chrono::milliseconds io_timeout{2000};  // Per request, reading and writing
+};
+
+/**
+ * @brief Minimal HTTP endpoint that serves MetricsRegistry to scrapers (v1.2.0)
+ *
+ * One thread accepts connections and answers GET on the configured path
+ * with MetricsRegistry::write_exposition(): OpenMetrics when the Accept
+ * header asks for application/openmetrics-text, Prometheus text
+ * otherwise. The thread renders every scrape into the same buffer, so a
+ * scrape allocates nothing once the buffer has grown, and it never holds
+ * the registry's lock while rendering, so logging and registrations do not
+ * wait on it.
+ *
+ * Requests are served one at a time and each connection is closed after
+ * its response. This is for a scraper on a private port, not a general web
+ * server; bind it to an address only scrapers can reach.
+ */
+class MetricsServer {
+public:
+    explicit MetricsServer(const MetricsServerOptions& options = MetricsServerOptions());
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Bind and start serving; false, reported to stderr, if the address cannot be bound
+     */
+    bool start();
+    void stop();
+    bool running() const { return fd_ >= 0; }
+
+    /**
+     * @brief Port being listened on, once started; the chosen one when the option is 0
+     */
+    uint16_t port() const { return port_; }
+    uint64_t scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void serve(int client);
+
+    MetricsServerOptions options_;
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> scrapes_{0};
+    std::thread thread_;
+    std::string request_;
+    std::string body_;
+    std::string head_;
+};
+
+}
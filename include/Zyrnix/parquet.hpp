@@ -0,0 +1,176 @@
+#pragma once
+#include "field.hpp"
+#include "log_level.hpp"
+#include "trace_context.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief A Parquet file writer for log records, built in (v1.2.0)
+ *
+ * Enough of the format for ParquetSink: a flat schema, one column per
+ * record attribute and per declared field, version 1 data pages and
+ * SNAPPY (the built-in snappy::compress) or no compression. Columns are
+ *
+ *     timestamp  INT64 TIMESTAMP(MICROS, UTC)   level   STRING
+ *     logger     STRING                         thread  INT64
+ *     message    STRING                         trace_id, span_id  STRING, optional
+ *     <field>    INT64, DOUBLE, BOOLEAN or STRING per Schema::fields, optional
+ *     fields     STRING (JSON object of the other fields), optional
+ *
+ * A string column chunk is dictionary-encoded when it repeats (the
+ * distinct values are at most half the rows and the dictionary stays
+ * under a megabyte), which always holds for level and logger and
+ * usually for enum-like fields; otherwise it is PLAIN. Each column chunk
+ * of the timestamp carries min/max statistics, so readers can skip row
+ * groups outside a time range. Metadata is Thrift compact protocol, as
+ * the format requires.
+ */
+namespace parquet {
+
+struct FieldColumn {
+    std::string name;
+    FieldType type = FieldType::String;
+};
+
+struct Schema {
+    std::vector<FieldColumn> fields;  // Typed columns for these record fields
+    bool trace = true;                // trace_id and span_id columns
+    bool other_fields = true;         // The undeclared fields, as JSON
+};
+
+enum class Codec : uint8_t { Uncompressed = 0, Snappy = 1 };
+
+/**
+ * @brief Rows gathered column by column, to be written as one row group
+ */
+class RowBatch {
+public:
+    explicit RowBatch(const Schema& schema);
+
+    /**
+     * @brief Append a row; a declared field whose value does not parse as
+     *        its column's type is null there and kept in the fields column
+     */
+    void add(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+             std::string_view logger_name, std::string_view message, const TraceContext* trace,
+             const FieldList* fields);
+
+    size_t rows() const { return rows_; }
+
+    /**
+     * @brief Bytes the values take in memory, roughly
+     */
+    size_t bytes() const;
+
+    void clear();
+
+    enum class Physical : uint8_t { Boolean = 0, Int64 = 2, Double = 5, ByteArray = 6 };
+
+    // Values are stored for defined rows only, as Parquet lays them out
+    struct Column {
+        std::string name;
+        Physical type;
+        bool optional;
+        bool string;      // ByteArray holding UTF-8
+        bool timestamp;   // Int64 microseconds
+        std::vector<int64_t> ints;
+        std::vector<double> doubles;
+        std::vector<uint8_t> bools;
+        std::string bytes;
+        std::vector<uint32_t> ends;  // End of each value in bytes
+        std::vector<uint8_t> defined;  // Per row, optional columns only
+
+        size_t values() const;
+    };
+
+    const std::vector<Column>& columns() const { return columns_; }
+
+private:
+    void push_string(Column& column, std::string_view value);
+    void push_null(Column& column);
+    bool push_field(Column& column, FieldType type, const FieldValue& value);
+
+    Schema schema_;
+    std::vector<Column> columns_;
+    size_t trace_column_ = 0;   // Index of trace_id when schema_.trace
+    size_t field_column_ = 0;   // Index of the first declared field
+    size_t rows_ = 0;
+    std::string json_;  // Scratch for the fields column
+    std::vector<std::string_view> rejected_;  // Declared fields of the row that did not parse
+};
+
+/**
+ * @brief Writes row groups to a file and the footer that makes it readable
+ *
+ * The file is not a valid Parquet file until finish() has written the
+ * footer; a process that dies before then leaves one readers reject.
+ */
+class FileWriter {
+public:
+    FileWriter(const Schema& schema, Codec codec, size_t page_rows = 8192);
+    ~FileWriter();
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool is_open() const { return file_ != nullptr; }
+
+    bool write_row_group(const RowBatch& batch);
+
+    /**
+     * @brief Write the footer and close
+     */
+    bool finish();
+
+    uint64_t rows() const { return rows_; }
+    uint64_t bytes() const { return offset_; }
+
+private:
+    struct ChunkMeta {
+        const RowBatch::Column* column;
+        bool dictionary;
+        uint64_t values;
+        uint64_t uncompressed;
+        uint64_t compressed;
+        uint64_t data_offset;
+        uint64_t dictionary_offset;
+        bool has_range;
+        int64_t min;
+        int64_t max;
+    };
+    struct GroupMeta {
+        std::string columns;  // The encoded ColumnChunk list entries
+        uint64_t total_bytes;
+        uint64_t rows;
+    };
+
+    bool write_chunk(const RowBatch::Column& column, size_t rows, ChunkMeta& meta);
+    bool write_page(int page_type, std::string_view body, uint32_t values, int encoding);
+    bool put(std::string_view bytes);
+
+    Schema schema_;
+    Codec codec_;
+    size_t page_rows_;
+    std::FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    uint64_t rows_ = 0;
+    std::vector<GroupMeta> groups_;
+    std::string schema_bytes_;  // The SchemaElement list entries, encoded once
+    size_t schema_elements_ = 0;
+    std::string page_;       // Scratch buffers, reused page to page
+    std::string compressed_;
+    std::string header_;
+};
+
+}
+
+}
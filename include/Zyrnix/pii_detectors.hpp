@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Built-in PII kinds, usable as a bit set (v1.2.0)
+ */
+enum PiiKind : uint32_t {
+    PiiEmail      = 1u << 0,
+    PiiIpv4       = 1u << 1,
+    PiiCreditCard = 1u << 2,
+    PiiSsn        = 1u << 3,
+};
+
+/**
+ * @brief Hand-written detectors for the built-in redaction presets (v1.2.0)
+ *
+ * Replaces the std::regex presets. A vectorised prefilter jumps to the
+ * next '@' or digit (AVX2 or SSE2 on x86-64, NEON on AArch64, chosen at
+ * runtime), and each candidate is validated exactly:
+ * - email: local@domain.tld with a TLD of two or more letters
+ * - ipv4: four dot-separated octets 0-255, not part of a longer number
+ * - credit_card: 13-16 digits, optionally grouped by ' ' or '-', passing
+ *   the Luhn check
+ * - ssn: ddd-dd-dddd on word boundaries
+ */
+class PiiDetector {
+public:
+    using Span = std::pair<size_t, size_t>;  // [begin, end)
+
+    explicit PiiDetector(uint32_t kinds = 0) : kinds_(kinds) {}
+
+    /**
+     * @brief Map a preset name ("email", "ipv4", "credit_card", "ssn",
+     *        case-insensitive) to its PiiKind bit; 0 if unknown
+     */
+    static uint32_t kind_from_preset(const std::string& preset);
+
+    /**
+     * @brief Name of the prefilter kernel picked for this CPU
+     */
+    static const char* kernel_name();
+
+    bool empty() const { return kinds_ == 0; }
+    uint32_t kinds() const { return kinds_; }
+
+    /**
+     * @brief Collect matches in text as sorted, non-overlapping spans
+     * @return true if anything was found
+     */
+    bool find(std::string_view text, std::vector<Span>& spans) const;
+
+private:
+    uint32_t kinds_;
+};
+
+}
@@ -3,16 +3,62 @@
 #include <chrono>
 #include <functional>
 #include <atomic>
-#include <mutex>
+#include <cstdint>
+#include <time.h>
 
 namespace Zyrnix {
 
+/**
+ * @brief Monotonic nanoseconds at millisecond resolution (v1.2.0)
+ *
+ * The coarse clock where the platform has one; limiters need no better
+ * and it costs a fraction of a steady_clock read.
+ */
+inline uint64_t monotonic_coarse_ns() {
+#ifdef CLOCK_MONOTONIC_COARSE
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(ts.tv_nsec);
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+struct RateLimiterOptions {
+    size_t messages_per_second = 0;
+    size_t burst_capacity = 0;  // 0 for messages_per_second
+
+    // Above 1, each thread claims this many tokens at a time and spends
+    // them without touching the shared bucket (v1.2.0). A thread may
+    // then run up to credit_chunk - 1 tokens ahead of the others.
+    size_t credit_chunk = 1;
+};
+
+/**
+ * @brief Token bucket limiting messages per second (v1.2.0)
+ *
+ * The whole bucket is one 64-bit atomic: the time at which it will be
+ * full again, in sixteenths of a nanosecond since the limiter was made.
+ * Every token moves that time forward by the refill interval, so the
+ * tokens left are how far it is from now plus the burst allowance.
+ * try_log() is one CAS on it with integer arithmetic; refusals do not
+ * write it at all. Time comes from the coarse monotonic clock where the
+ * platform has one, so tokens arrive in steps of a few milliseconds.
+ */
 class RateLimiter {
 public:
     explicit RateLimiter(size_t messages_per_second = 0, size_t burst_capacity = 0);
+    explicit RateLimiter(const RateLimiterOptions& options);
 
     bool try_log();
 
+    /**
+     * @brief Take tokens for up to count messages in one go (v1.2.0)
+     * @return How many of them may be logged; the rest count as dropped
+     */
+    size_t try_log_many(size_t count);
+
     void reset();
 
     size_t available_tokens() const;
@@ -22,14 +68,21 @@ public:
     bool is_enabled() const { return max_tokens_ > 0; }
 
 private:
-    void refill_tokens();
-
-    size_t max_tokens_;                  
-    size_t refill_rate_;                  
-    std::atomic<double> tokens_;          
-    std::chrono::steady_clock::time_point last_refill_;
-    std::atomic<uint64_t> dropped_count_; 
-    mutable std::mutex mutex_;
+    // Take up to wanted tokens; returns how many were granted
+    size_t acquire(size_t wanted);
+    bool try_log_cached();
+    uint64_t now_ticks() const;
+
+    size_t max_tokens_;
+    size_t refill_rate_;
+    size_t credit_chunk_;
+    uint64_t interval_;   // Ticks per token
+    uint64_t tolerance_;  // Ticks the full time may run ahead of now
+    uint64_t epoch_ns_;
+
+    alignas(64) std::atomic<uint64_t> full_at_{0};
+    alignas(64) std::atomic<uint64_t> dropped_count_{0};
+    std::atomic<uint64_t> generation_;  // Changes on reset(), voiding cached credits
 };
 
 class SamplingLimiter {
@@ -77,4 +130,84 @@ private:
     std::atomic<uint64_t> logged_count_;
 };
 
+/**
+ * @brief What a per-site limit decided for one call (v1.2.0)
+ */
+struct LimitDecision {
+    bool emit;
+    uint64_t suppressed;  // Held-back calls to report now: on the line if emit, else to metrics only
+};
+
+/**
+ * @brief State of one XLOG_*_EVERY_N site: the 1st, (n+1)th, ... calls
+ *        get through (v1.2.0)
+ *
+ * The per-site limits are declared constinit next to the macro's LogSite,
+ * so a check is one relaxed atomic on state no other site shares.
+ */
+class EveryNLimit {
+public:
+    constexpr EveryNLimit() = default;
+
+    LimitDecision admit(uint64_t n) {
+        n = n > 0 ? n : 1;
+        const uint64_t call = calls_.fetch_add(1, std::memory_order_relaxed);
+        if (call % n != 0) {
+            return LimitDecision{false, 0};
+        }
+        return LimitDecision{true, call == 0 ? 0 : n - 1};
+    }
+
+private:
+    std::atomic<uint64_t> calls_{0};
+};
+
+/**
+ * @brief State of one XLOG_*_EVERY_MS site: at most one line per period (v1.2.0)
+ */
+class EveryMsLimit {
+public:
+    constexpr EveryMsLimit() = default;
+
+    LimitDecision admit(uint64_t period_ms) {
+        const uint64_t now = monotonic_coarse_ns();
+        uint64_t next = next_ns_.load(std::memory_order_relaxed);
+        // Of several threads arriving when the period is up, one wins the CAS
+        if (now < next || !next_ns_.compare_exchange_strong(next, now + period_ms * 1'000'000ull,
+                                                            std::memory_order_relaxed)) {
+            held_.fetch_add(1, std::memory_order_relaxed);
+            return LimitDecision{false, 0};
+        }
+        return LimitDecision{true, held_.exchange(0, std::memory_order_relaxed)};
+    }
+
+private:
+    std::atomic<uint64_t> next_ns_{0};
+    std::atomic<uint64_t> held_{0};
+};
+
+/**
+ * @brief State of one XLOG_*_FIRST_N site: the first n calls get through (v1.2.0)
+ *
+ * There is no later line to report the rest on, so they reach the
+ * metrics in batches of report_batch.
+ */
+class FirstNLimit {
+public:
+    static constexpr uint64_t report_batch = 1024;
+
+    constexpr FirstNLimit() = default;
+
+    LimitDecision admit(uint64_t n) {
+        const uint64_t call = calls_.fetch_add(1, std::memory_order_relaxed);
+        if (call < n) {
+            return LimitDecision{true, 0};
+        }
+        return LimitDecision{false, (call - n + 1) % report_batch == 0 ? report_batch : 0};
+    }
+
+private:
+    std::atomic<uint64_t> calls_{0};
+};
+
 } // namespace Zyrnix
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Epoch-based grace periods for read-mostly data (v1.2.0)
+ *
+ * Readers announce the epoch they entered in a per-thread slot; a writer
+ * that has unpublished an object bumps the epoch and waits until no slot
+ * still shows an older one. Entering a read section costs one store to a
+ * cache line owned by the calling thread, so readers never contend.
+ *
+ * There is one process-wide domain. Read sections nest on a thread.
+ */
+class EpochDomain {
+public:
+    static EpochDomain& instance();
+
+    /**
+     * @brief RAII read-side critical section
+     *
+     * Pointers loaded from an RcuPtr stay valid until the guard is destroyed.
+     */
+    class ReadGuard {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    /**
+     * @brief Start a new epoch
+     * @return The epoch every reader older than the call has to leave
+     */
+    uint64_t advance();
+
+    /**
+     * @brief Block until every reader that entered before the call has left
+     *
+     * The calling thread's own read section, if any, is not waited for.
+     */
+    void synchronize();
+
+    /**
+     * @brief Non-blocking check that no reader from before target is left
+     */
+    bool has_passed(uint64_t target) const;
+
+    /**
+     * @brief Block until no reader from before target is left
+     *
+     * The calling thread's own read section, if any, is not waited for.
+     */
+    void wait_for(uint64_t target);
+
+    /**
+     * @brief True if the calling thread is inside a ReadGuard
+     */
+    bool in_read_section() const;
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0};   // 0 = not reading
+        std::atomic<bool> in_use{false};
+        uint32_t depth = 0;               // Nesting, touched only by the owner
+    };
+
+private:
+    struct ThreadSlot;
+
+    EpochDomain() = default;
+
+    static Slot* local_slot();
+    Slot* acquire_slot();
+    void release_slot(Slot* slot);
+
+    std::atomic<uint64_t> epoch_{1};
+    mutable std::mutex slots_mtx_;
+    std::vector<std::unique_ptr<Slot>> slots_;  // Never shrinks; slots are reused
+};
+
+/**
+ * @brief Atomically swapped pointer to an immutable object (v1.2.0)
+ *
+ * load() is a single acquire load and must be called inside an
+ * EpochDomain::ReadGuard. publish() swaps in a new object and retires the
+ * old one; it is freed by a later publish() or reclaim() once no reader
+ * can still see it. Writers, including reclaim(), must be serialized by
+ * the owner.
+ */
+template <typename T>
+class RcuPtr {
+public:
+    explicit RcuPtr(std::unique_ptr<T> initial = nullptr)
+        : ptr_(initial.release())
+    {}
+
+    ~RcuPtr() {
+        EpochDomain::instance().synchronize();
+        delete ptr_.load(std::memory_order_relaxed);
+        for (auto& retired : retired_) {
+            delete retired.second;
+        }
+    }
+
+    RcuPtr(const RcuPtr&) = delete;
+    RcuPtr& operator=(const RcuPtr&) = delete;
+
+    const T* load() const { return ptr_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Swap in a new object and retire the old one
+     * @return Grace-period epoch; once EpochDomain::wait_for() returns for
+     *         it, reclaim() frees the old object
+     */
+    uint64_t publish(std::unique_ptr<T> next) {
+        T* old = ptr_.exchange(next.release(), std::memory_order_acq_rel);
+        const uint64_t grace = EpochDomain::instance().advance();
+        if (old) {
+            retired_.emplace_back(grace, old);
+        }
+        reclaim();
+        return grace;
+    }
+
+    /**
+     * @brief Free retired objects no reader can still see
+     */
+    void reclaim() {
+        EpochDomain& domain = EpochDomain::instance();
+        auto it = retired_.begin();
+        while (it != retired_.end()) {
+            if (domain.has_passed(it->first)) {
+                delete it->second;
+                it = retired_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+private:
+    std::atomic<T*> ptr_;
+    std::vector<std::pair<uint64_t, T*>> retired_;  // (epoch, object) waiting for readers
+};
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "aho_corasick.hpp"
+#include "pii_detectors.hpp"
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Redaction rules compiled once from a logger's configuration (v1.2.0)
+ *
+ * Built by Logger::set_redact_* and published as an immutable object, so
+ * the log path never copies pattern lists or constructs a std::regex.
+ * Substring patterns are matched by one Aho-Corasick automaton, regex
+ * patterns are merged into one alternation and PII presets run through
+ * the hand-written PiiDetector. Each is a single pass over the message.
+ */
+class Redactor {
+public:
+    Redactor(const std::vector<std::string>& substr_patterns,
+             const std::vector<std::string>& regex_patterns,
+             const std::vector<std::string>& pii_presets,
+             bool cloud_only);
+
+    /**
+     * @brief True if there is anything to redact
+     */
+    bool active() const { return !substrings_.empty() || !regexes_.empty() || !pii_.empty(); }
+
+    /**
+     * @brief Whether a sink receives the redacted message
+     */
+    bool applies_to(bool is_cloud_sink) const { return !cloud_only_ || is_cloud_sink; }
+
+    /**
+     * @brief Redact a message
+     * @param out Receives the redacted text; only written when something matched
+     * @return true if anything was redacted
+     */
+    bool redact(std::string_view message, std::string& out) const;
+
+    /**
+     * @brief Convenience form of redact() that always returns the result
+     */
+    std::string apply(const std::string& message) const;
+
+    /**
+     * @brief Regex equivalent of a built-in preset ("email", "ipv4",
+     *        "credit_card", "ssn"); empty if unknown
+     *
+     * Presets are matched by PiiDetector; this is kept for callers that
+     * need the pattern in regex form.
+     */
+    static std::string preset_pattern(const std::string& preset);
+
+private:
+    bool redact_regexes(std::string_view in, std::string& out) const;
+    bool redact_pii(std::string_view in, std::string& out) const;
+
+    AhoCorasick substrings_;
+    // Usually one merged regex; one per pattern if merging failed
+    std::vector<std::regex> regexes_;
+    PiiDetector pii_;
+    bool cloud_only_ = false;
+};
+
+}
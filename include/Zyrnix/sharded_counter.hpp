@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Zyrnix {
+
+/**
+ * @brief A thread's slot in sharded metrics (v1.2.0)
+ *
+ * Threads are dealt slots round robin on first use, so up to
+ * metric_shards threads never share one.
+ */
+inline constexpr size_t metric_shards = 16;
+
+inline size_t metric_shard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard = metric_shards;
+    if (shard == metric_shards) {
+        shard = next.fetch_add(1, std::memory_order_relaxed) % metric_shards;
+    }
+    return shard;
+}
+
+/**
+ * @brief Counter split into cache-line-padded per-thread shards (v1.2.0)
+ *
+ * add() touches only the calling thread's line, so threads counting at
+ * once do not bounce a shared line between cores; load() sums the
+ * shards. Reads are not a single snapshot: an add racing a load may or
+ * may not be seen.
+ */
+class ShardedCounter {
+public:
+    void add(uint64_t count = 1) { shards_[metric_shard()].value.fetch_add(count, std::memory_order_relaxed); }
+
+    uint64_t load() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void reset() {
+        for (auto& shard : shards_) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, metric_shards> shards_{};
+};
+
+/**
+ * @brief Running maximum kept per shard, combined on load() (v1.2.0)
+ *
+ * update() reads its own line and writes it only for a new maximum, so
+ * the common case is one uncontended load.
+ */
+class ShardedMax {
+public:
+    void update(uint64_t value) {
+        auto& slot = shards_[metric_shard()].value;
+        uint64_t current = slot.load(std::memory_order_relaxed);
+        while (value > current && !slot.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t load() const {
+        uint64_t highest = 0;
+        for (const auto& shard : shards_) {
+            const uint64_t value = shard.value.load(std::memory_order_relaxed);
+            highest = value > highest ? value : highest;
+        }
+        return highest;
+    }
+
+    void reset() {
+        for (auto& shard : shards_) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, metric_shards> shards_{};
+};
+
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include "binary_log.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief The shared-memory ring written by ShmRingSink, and its reader (v1.2.0)
+ *
+ * A ring is a POSIX shared memory object (/dev/shm/<name>): a 4096-byte
+ * header, then capacity bytes of data, capacity a power of two. Header
+ * fields, in native byte order at fixed offsets:
+ *
+ *     0    char[8]  magic "ZYRNSHM1"
+ *     8    u32      version, 1; written last, so 0 means not ready yet
+ *     12   u32      header size, 4096
+ *     16   u64      capacity
+ *     24   i32      pid of the writing process
+ *     64   u64      head: bytes reserved by writers, ever
+ *     128  u64      tail: bytes consumed by the reader, ever
+ *     192  u32      wake sequence, a futex word
+ *     196  u32      1 while the reader sleeps on it
+ *     200  u32      1 once the writer has closed the ring
+ *     208  u64      entries dropped for want of room
+ *
+ * Entries start 16-byte aligned at position % capacity and never wrap:
+ * a u64 commit word, a u32 payload size, a u32 kind (1 data, 2 padding
+ * to the end of the data area), the payload, and padding to 16 bytes.
+ * Writers reserve space by advancing head with a CAS, so any number of
+ * threads write at once; the commit word is stored last, with release
+ * ordering, as the entry's position + 1. The reader consumes entries in
+ * order while the commit word at tail equals tail + 1, zeroes them and
+ * advances tail. A data payload is one binlog block (see binary_log.hpp)
+ * of one or more records.
+ *
+ * Writers never wait: an entry that does not fit is dropped and counted.
+ * After committing, a writer that finds the sleeping flag set clears it,
+ * bumps the wake sequence and FUTEX_WAKEs the reader.
+ */
+namespace shmring {
+
+inline constexpr char magic[8] = {'Z', 'Y', 'R', 'N', 'S', 'H', 'M', '1'};
+inline constexpr uint32_t format_version = 1;
+inline constexpr size_t header_size = 4096;
+inline constexpr size_t entry_header_size = 16;
+inline constexpr size_t entry_alignment = 16;
+
+enum class EntryKind : uint32_t { Data = 1, Padding = 2 };
+
+struct Header {
+    char magic[8];
+    std::atomic<uint32_t> version;
+    uint32_t header_size;
+    uint64_t capacity;
+    int32_t owner_pid;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> wake_seq;
+    std::atomic<uint32_t> reader_waiting;
+    std::atomic<uint32_t> closed;
+    std::atomic<uint64_t> dropped;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the ring's atomics are shared between processes");
+static_assert(offsetof(Header, version) == 8 && offsetof(Header, capacity) == 16 && offsetof(Header, owner_pid) == 24);
+static_assert(offsetof(Header, head) == 64 && offsetof(Header, tail) == 128);
+static_assert(offsetof(Header, wake_seq) == 192 && offsetof(Header, reader_waiting) == 196 &&
+              offsetof(Header, closed) == 200 && offsetof(Header, dropped) == 208);
+static_assert(sizeof(Header) <= header_size);
+
+/**
+ * @brief Wake the reader if it sleeps; writers call it after committing
+ */
+void notify(Header& header);
+
+/**
+ * @brief The consuming side of a ring, for a collector process
+ *
+ * One reader per ring. Entries are read where they lie in the shared
+ * mapping: the views poll() hands out stay valid until it returns.
+ */
+class Reader {
+public:
+    /**
+     * @param name The ring's name, as given to ShmRingSink ("/myapp.1234")
+     */
+    explicit Reader(const std::string& name);
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /**
+     * @brief Whether the ring was mapped; false if it does not exist or is
+     *        not a ring yet (try again later)
+     */
+    bool is_open() const { return header_ != nullptr; }
+
+    /**
+     * @brief Call emit(std::string_view payload) for each committed entry,
+     *        up to max; returns how many were read
+     */
+    template <class Emit>
+    size_t poll(Emit&& emit, size_t max = SIZE_MAX);
+
+    /**
+     * @brief As poll(), decoding the records: emit(const binlog::DecodedRecord&)
+     */
+    template <class Emit>
+    size_t poll_records(Emit&& emit, size_t max = SIZE_MAX);
+
+    /**
+     * @brief Sleep until an entry is committed, the ring is closed or
+     *        timeout passes; true if an entry is ready
+     */
+    bool wait(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief The writer closed the ring or exited, and every entry is read
+     *
+     * A writer that crashed leaves the object in /dev/shm for shm_unlink().
+     * Exit is detected through the pid, so only in the writer's pid namespace.
+     */
+    bool finished() const;
+
+    uint64_t dropped() const;
+    int owner_pid() const;
+
+private:
+    // The next data entry, skipping padding; false if none is committed
+    bool peek(std::string_view& payload);
+    void pop();  // Release the entry peek() returned
+
+    Header* header_ = nullptr;
+    char* data_ = nullptr;
+    size_t mapped_size_ = 0;
+    uint64_t mask_ = 0;
+    uint64_t entry_size_ = 0;  // Of the entry peek() returned, padding included
+};
+
+template <class Emit>
+size_t Reader::poll(Emit&& emit, size_t max) {
+    size_t count = 0;
+    std::string_view payload;
+    while (count < max && peek(payload)) {
+        emit(payload);
+        pop();
+        ++count;
+    }
+    return count;
+}
+
+template <class Emit>
+size_t Reader::poll_records(Emit&& emit, size_t max) {
+    return poll(
+        [&emit](std::string_view payload) {
+            for (const binlog::BlockRef& block : binlog::scan_blocks(payload)) {
+                binlog::decode_block(payload, block, emit);
+            }
+        },
+        max);
+}
+
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "http_transport.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Zyrnix {
+
+struct ArchiveUploadOptions {
+    // S3 or another service with its API, e.g. GCS through
+    // https://storage.googleapis.com with HMAC keys and region "auto".
+    // Objects go to <endpoint>/<bucket>/<prefix><name>; leave bucket empty
+    // for an endpoint that names it (https://logs.s3.eu-west-1.amazonaws.com)
+    std::string endpoint = "https://s3.us-east-1.amazonaws.com";
+    std::string bucket;
+    std::string prefix;  // e.g. "logs/web-1/"
+
+    // Requests are signed with SigV4 when access_key_id is set
+    std::string region = "us-east-1";
+    std::string access_key_id;
+    std::string secret_access_key;
+    std::string session_token;         // For temporary credentials
+    std::vector<std::string> headers;  // Sent with every request, e.g. "x-amz-storage-class: STANDARD_IA"
+
+    // Files waiting to be uploaded, and the upload state of each; must be
+    // on the same filesystem as the logs so handing a file over is a rename
+    std::string spool_directory;
+
+    // Files above part_size go up as multipart uploads of part_size parts
+    // (S3 needs at least 5 MiB), up to max_in_flight parts at once; each
+    // part in flight is held in memory
+    size_t part_size = 8 * 1024 * 1024;
+    size_t max_in_flight = 4;
+
+    // Total upload bandwidth, shared by the parts in flight; 0 for no limit
+    uint64_t max_bytes_per_second = 0;
+
+    // Read the files at idle I/O priority and nice 19 (Linux)
+    bool low_priority = true;
+
+    long request_timeout_ms = 300000;
+    int max_attempts = 3;  // Per request, by HttpTransport
+
+    // After a failed file the uploader waits this long, doubling up to 16
+    // times it, before trying again
+    std::chrono::seconds retry_delay{30};
+
+    bool insecure_skip_verify = false;
+    std::string ca_cert_path;
+};
+
+/**
+ * @brief Moves finished log files to object storage in the background (v1.2.0)
+ *
+ * Set on CompressionOptions::uploader: instead of entering the .1 .. .N
+ * cascade, each compressed file (with its .idx and .meta) is renamed into
+ * spool_directory, uploaded to <prefix><name> and then deleted, so local
+ * disks only hold what has not reached the bucket yet. One uploader can
+ * serve several sinks.
+ *
+ * The uploader has one thread of its own, at low priority, which reads
+ * the files and hands the requests to the shared HttpTransport. Small
+ * files are one PUT; larger ones are S3 multipart uploads whose upload
+ * id and finished parts are recorded in <name>.upload in the spool, so
+ * after a restart the upload carries on with the parts it lacks. The
+ * spool is scanned when the uploader starts, so files left by an earlier
+ * process go up first, oldest name first.
+ */
+class ArchiveUploader {
+public:
+    explicit ArchiveUploader(const ArchiveUploadOptions& options);
+    ~ArchiveUploader();
+
+    ArchiveUploader(const ArchiveUploader&) = delete;
+    ArchiveUploader& operator=(const ArchiveUploader&) = delete;
+
+    /**
+     * @brief Move path into the spool as name and queue it
+     *
+     * False if the name is taken or the file cannot be moved; the file is
+     * then where it was.
+     */
+    bool add(const std::string& path, const std::string& name);
+
+    /**
+     * @brief Queue a copy of path, for a file the caller keeps using
+     */
+    bool add_copy(const std::string& path, const std::string& name);
+
+    /**
+     * @brief Wait until every queued file is uploaded; false on timeout
+     */
+    bool wait_idle(std::chrono::milliseconds timeout);
+
+    struct Stats {
+        uint64_t files_uploaded;
+        uint64_t bytes_uploaded;
+        uint64_t parts_uploaded;
+        uint64_t failures;  // Files put back for a later retry
+        size_t pending_files;
+    };
+
+    Stats get_stats() const;
+
+private:
+    void run();
+    std::vector<std::string> scan() const;
+    bool upload(const std::string& name);
+    bool upload_multipart(const std::string& name, const std::string& path, uint64_t size);
+    HttpRequest make_request(const std::string& method, const std::string& url, std::string body) const;
+    HttpResponse send(HttpRequest request);
+    void remove_spooled(const std::string& name);
+
+    ArchiveUploadOptions options_;
+    std::string object_base_;  // endpoint/bucket/, with the prefix
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;       // Wakes the uploader thread
+    std::condition_variable done_cv_;  // Requests completed, the spool emptied
+    size_t in_flight_ = 0;
+    bool added_ = false;  // Files added since the last scan
+    bool idle_ = false;   // The last scan found nothing and nothing came since
+    bool stopping_ = false;
+    size_t pending_ = 0;
+
+    std::atomic<uint64_t> files_uploaded_{0};
+    std::atomic<uint64_t> bytes_uploaded_{0};
+    std::atomic<uint64_t> parts_uploaded_{0};
+    std::atomic<uint64_t> failures_{0};
+    std::thread thread_;
+};
+
+}
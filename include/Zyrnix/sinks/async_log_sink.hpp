@@ -0,0 +1,117 @@
+#pragma once
+#include "../coro.hpp"
+#include "../log_sink.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#ifndef XLOG_NO_CLOUD_SINKS
+#include "http_transport.hpp"
+#endif
+
+namespace Zyrnix {
+
+struct AsyncSinkOptions {
+    size_t max_in_flight = 8;     // Batches being written at once; log_batch() waits beyond it
+    size_t max_batch_size = 512;  // Records per write() call
+};
+
+/**
+ * @brief Base for sinks written as coroutines (v1.2.0)
+ *
+ * log_record() and log_batch() copy the records and start write() on
+ * the SinkExecutor, then return. A subclass sends the batch with
+ * co_await and waits out a retry with co_await executor().sleep_for(),
+ * so many batches, from any number of such sinks, are in flight on one
+ * thread. At most max_in_flight batches of a sink run at once; beyond
+ * that log_batch() waits, which pushes back on an async logger's queue
+ * and its overflow policy rather than growing without bound.
+ *
+ * A subclass must call drain() first thing in its destructor, since
+ * write() coroutines still running use its members.
+ */
+class AsyncLogSink : public LogSink {
+public:
+    explicit AsyncLogSink(const AsyncSinkOptions& options = AsyncSinkOptions());
+    ~AsyncLogSink() override;
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+
+    /**
+     * @brief Wait for every write() started so far to finish
+     *
+     * Returns at once on the executor thread, which the writes need.
+     */
+    void flush() override;
+
+    size_t in_flight() const;
+
+protected:
+    /**
+     * @brief Write one batch; resumed on the executor thread
+     *
+     * An exception escaping it is reported on std::cerr and the batch is
+     * dropped.
+     */
+    virtual CoTask<void> write(std::vector<LogRecord> batch) = 0;
+
+    /**
+     * @brief Wait for every write() in flight; subclasses call it in their destructor
+     */
+    void drain();
+
+    SinkExecutor& executor() const { return executor_; }
+
+private:
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    };
+
+    void start(std::vector<LogRecord> batch);
+    static Detached run(AsyncLogSink* self, CoTask<void> task);
+
+    AsyncSinkOptions options_;
+    SinkExecutor& executor_;
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    size_t in_flight_ = 0;
+};
+
+#ifndef XLOG_NO_CLOUD_SINKS
+/**
+ * @brief Awaitable: POST request through HttpTransport and continue on the
+ *        executor with the response (v1.2.0)
+ */
+inline auto http_post_async(HttpRequest request, SinkExecutor& executor = SinkExecutor::instance()) {
+    struct Awaiter {
+        HttpRequest request;
+        SinkExecutor& executor;
+        HttpResponse response;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) {
+            HttpTransport::instance().submit(std::move(request),
+                                             [this, h](const HttpResponse& r, int, HttpRequest&) {
+                                                 response = r;
+                                                 executor.post(h);
+                                             });
+        }
+        HttpResponse await_resume() { return std::move(response); }
+    };
+    return Awaiter{std::move(request), executor, {}};
+}
+#endif
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "../binary_log.hpp"
+#include "../log_sink.hpp"
+#include "flush_policy.hpp"
+#include "log_file.hpp"
+#include <mutex>
+#include <span>
+#include <string>
+
+namespace Zyrnix {
+
+/**
+ * @brief Writes records in the binary log format, unformatted (v1.2.0)
+ *
+ * No layout is rendered and no timestamp formatted: each record goes
+ * into the current block as its level, time, thread, interned logger
+ * name, call site, message and fields (see binlog). A block is written
+ * when it reaches policy.buffer_size (or every_bytes), when a record at
+ * policy.flush_on arrives, on the background flusher's interval and on
+ * flush(). Read the file with the zyrnix_decode tool, which renders any
+ * Formatter pattern or JSON. The sink's own formatter is not used.
+ */
+class BinaryFileSink : public LogSink {
+public:
+    explicit BinaryFileSink(const std::string& filename, const FlushPolicy& policy = FlushPolicy{});
+    ~BinaryFileSink() override;
+
+    BinaryFileSink(const BinaryFileSink&) = delete;
+    BinaryFileSink& operator=(const BinaryFileSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
+
+private:
+    void add(const FormattedRecord& record);
+    void after_add(LogLevel level);
+    void write_block();
+
+    FlushPolicy policy_;
+    std::mutex mtx_;
+    LogFile file_;
+    binlog::BlockWriter block_;
+    std::string out_;
+    size_t block_limit_;
+};
+
+}
@@ -2,18 +2,29 @@
 #include "../Zyrnix_features.hpp"
 #include "../log_sink.hpp"
 #include "../log_record.hpp"
+#include "http_transport.hpp"
+#include "spill_queue.hpp"
+#include "../memory_budget.hpp"
 #include <string>
 #include <vector>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
-#include <thread>
 #include <atomic>
 #include <chrono>
+#include <memory>
 
 namespace Zyrnix {
 
-class CloudWatchSink : public LogSink {
+class CrashWriter;
+
+/**
+ * @brief Sends batches to CloudWatch Logs through HttpTransport
+ *
+ * Batches are cut and posted on the shared I/O thread, which retries
+ * them with the configured backoff; the sink has no thread of its own.
+ */
+class CloudWatchSink : public LogSink, private HttpTransport::Client {
 public:
     struct Config {
         std::string region = "us-east-1";
@@ -22,18 +33,26 @@ public:
         std::string access_key_id;
         std::string secret_access_key;
         
-        size_t batch_size = 100; // Max messages per batch
+        size_t batch_size = 100; // Max messages per batch (at most 10,000)
+        // Max bytes per batch as PutLogEvents counts them: each message
+        // plus 26. The default is the service's limit (v1.2.0)
+        size_t max_batch_bytes = 1024 * 1024;
         size_t batch_timeout_ms = 5000; // Max time to wait before sending batch
         size_t max_retries = 3; // Retry attempts on failure
         size_t retry_delay_ms = 1000; // Initial retry delay (exponential backoff)
         size_t max_queue_size = 10000; // Max messages in queue
+
+        // Disk spill for batches the endpoint cannot take (v1.2.0)
+        SpillOptions spill;
     };
 
     explicit CloudWatchSink(const Config& config);
     ~CloudWatchSink() override;
 
     void log(const std::string& name, LogLevel level, const std::string& message) override;
-    void flush();
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
 
     bool is_cloud_sink() const override { return true; }
 
@@ -43,6 +62,7 @@ public:
         uint64_t messages_dropped;
         uint64_t batches_sent;
         uint64_t retries;
+        uint64_t messages_spilled;  // Written to the spill, replayed or not (v1.2.0)
         size_t queue_size;
     };
 
@@ -50,23 +70,37 @@ public:
 
 private:
     struct LogEvent {
-        std::string message;
-        int64_t timestamp_ms;
+        std::string json;  // The event's object in logEvents
+        size_t size;       // What PutLogEvents counts: message bytes plus 26
     };
 
-    void worker_thread();
-    void send_batch(const std::vector<LogEvent>& events);
-    bool send_to_cloudwatch(const std::vector<LogEvent>& events);
+    void push_event(std::string_view message, LogLevel level, int64_t timestamp_ms);  // Under queue_mutex_
+    size_t batch_limit() const;
+    bool batch_ready() const;  // Under queue_mutex_
+    std::chrono::steady_clock::time_point pump(HttpTransport& transport) override;
+    std::chrono::steady_clock::time_point send_batch(HttpTransport& transport);
+    HttpRequest base_request() const;
+    void on_sent(const HttpResponse& response, int attempts, size_t events, HttpRequest& request);
+    void on_replayed(const HttpResponse& response, uint32_t events);
+    void finish_batch(size_t events);
     std::string create_request_body(const std::vector<LogEvent>& events);
+    // crash::DrainFn: the queued events' JSON objects, one per line (v1.2.0)
+    static void drain_for_crash(const void* sink, CrashWriter& out);
     
     Config config_;
     
     std::queue<LogEvent> queue_;
+    size_t queued_bytes_ = 0;  // Sum of queue_'s sizes
+    BudgetAccount budget_{"CloudWatchSink"};  // Charged queued_bytes_ (v1.2.0)
     std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    std::condition_variable flushed_cv_;  // Signalled when a batch has been sent
+    size_t in_flight_ = 0;                // Events taken off queue_ but not sent yet
+    size_t flush_waiters_ = 0;
+    std::chrono::steady_clock::time_point last_send_;
     
-    std::thread worker_;
     std::atomic<bool> running_;
+    std::unique_ptr<SpillQueue> spill_;
+    int crash_slot_ = -1;
     
     mutable std::mutex stats_mutex_;
     uint64_t messages_sent_;
@@ -76,17 +110,22 @@ private:
     uint64_t retries_;
 };
 
-class AzureMonitorSink : public LogSink {
+/**
+ * @brief Sends batches to Azure Monitor through HttpTransport, as CloudWatchSink
+ */
+class AzureMonitorSink : public LogSink, private HttpTransport::Client {
 public:
     struct Config {
         std::string instrumentation_key;
         std::string ingestion_endpoint = "https://dc.services.visualstudio.com/v2/track";
         
         size_t batch_size = 100;
+        size_t max_batch_bytes = 1024 * 1024;  // Max request body bytes (v1.2.0)
         size_t batch_timeout_ms = 5000;
         size_t max_retries = 3;
         size_t retry_delay_ms = 1000;
         size_t max_queue_size = 10000;
+        SpillOptions spill;  // (v1.2.0)
         
         std::string cloud_role_name;
         std::string cloud_role_instance;
@@ -96,7 +135,8 @@ public:
     ~AzureMonitorSink() override;
 
     void log(const std::string& name, LogLevel level, const std::string& message) override;
-    void flush();
+    void log_record(const FormattedRecord& record) override;
+    void flush() override;
 
     bool is_cloud_sink() const override { return true; }
 
@@ -106,6 +146,7 @@ public:
         uint64_t messages_dropped;
         uint64_t batches_sent;
         uint64_t retries;
+        uint64_t messages_spilled;  // Written to the spill, replayed or not (v1.2.0)
         size_t queue_size;
     };
 
@@ -113,26 +154,36 @@ public:
 
 private:
     struct TelemetryEvent {
-        std::string message;
-        std::string level;
-        std::string timestamp;
-        std::string logger_name;
+        std::string line;  // Encoded when queued, one line of the request body
     };
 
-    void worker_thread();
-    void send_batch(const std::vector<TelemetryEvent>& events);
-    bool send_to_azure(const std::vector<TelemetryEvent>& events);
+    void enqueue(const std::string& formatted, LogLevel level, std::string_view name,
+                 std::chrono::system_clock::time_point timestamp);
+    std::string encode_event(std::string_view message, LogLevel level,
+                             std::chrono::system_clock::time_point timestamp) const;
+    bool batch_ready() const;  // Under queue_mutex_
+    std::chrono::steady_clock::time_point pump(HttpTransport& transport) override;
+    std::chrono::steady_clock::time_point send_batch(HttpTransport& transport);
+    HttpRequest base_request() const;
+    void on_sent(const HttpResponse& response, int attempts, size_t events, HttpRequest& request);
+    void on_replayed(const HttpResponse& response, uint32_t events);
+    void finish_batch(size_t events);
     std::string create_request_body(const std::vector<TelemetryEvent>& events);
-    std::string level_to_severity(LogLevel level);
+    static const char* level_to_severity(LogLevel level);
     
     Config config_;
     
     std::queue<TelemetryEvent> queue_;
+    size_t queued_bytes_ = 0;  // Sum of queue_'s line sizes
+    BudgetAccount budget_{"AzureMonitorSink"};  // Charged queued_bytes_ (v1.2.0)
     std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    std::condition_variable flushed_cv_;  // Signalled when a batch has been sent
+    size_t in_flight_ = 0;                // Events taken off queue_ but not sent yet
+    size_t flush_waiters_ = 0;
+    std::chrono::steady_clock::time_point last_send_;
     
-    std::thread worker_;
     std::atomic<bool> running_;
+    std::unique_ptr<SpillQueue> spill_;
     
     mutable std::mutex stats_mutex_;
     uint64_t messages_sent_;
@@ -144,12 +195,11 @@ private:
 
 class HttpClient {
 public:
-    struct Response {
-        int status_code;
-        std::string body;
-        bool success;
-    };
+    using Response = HttpResponse;
 
+    /**
+     * @brief A blocking POST, on HttpTransport's pooled connections
+     */
     static Response post(
         const std::string& url,
         const std::string& body,
@@ -2,13 +2,25 @@
 #include "../Zyrnix_features.hpp"
 #include "../log_sink.hpp"
 #include "../log_record.hpp"
+#include "../log_sidecar.hpp"
 #include <string>
+#include <string_view>
 #include <memory>
 #include <mutex>
 #include <fstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <thread>
+#include <vector>
 
 namespace Zyrnix {
 
+class ArchiveUploader;
+
 enum class CompressionType {
     None,
     Gzip,
@@ -20,8 +32,80 @@ struct CompressionOptions {
     int level = 6; 
     bool compress_on_rotate = true; 
     bool auto_tune = false;
+
+    // Threads compressing rotated files in the background
+    size_t workers = 1;
+
+    // Rotated files waiting for a worker; a rotation beyond this waits
+    size_t max_pending = 4;
+
+    // Zstd threads per rotated file (ZSTD_c_nbWorkers); 0 compresses on the
+    // pool worker itself
+    int zstd_workers = 0;
+
+    // Zstd long-distance matching for rotated files
+    bool long_distance_matching = false;
+
+    // Compress lines as they are written, into <filename> plus the
+    // extension, instead of compressing each file after rotation
+    bool streaming = false;
+
+    // With streaming, end the open frame (a complete gzip member or zstd
+    // frame) this often, and after frame_size uncompressed bytes
+    std::chrono::milliseconds frame_flush_interval{1000};
+    size_t frame_size = 1024 * 1024;
+
+    // Streaming, plus <file>.idx beside each compressed file: a line per
+    // frame with its offset, length and the first and last record time
+    // (ms since the epoch), for reading a time range without the rest
+    bool seekable = false;
+
+    // Zstd only: train a dictionary from a sample of the lines logged and
+    // compress later files with it, retraining every retrain_interval. It
+    // is stored as <filename>.<dictionary id>.dict, which decoding needs
+    bool train_dictionary = false;
+    size_t dictionary_size = 64 * 1024;
+    size_t dictionary_sample_bytes = 4 * 1024 * 1024;
+    std::chrono::seconds retrain_interval{3600};
+
+    // <rotated file>.meta beside each rotated file, compressed or not: its
+    // time range, level counts and a Bloom filter over chosen field values
+    SidecarOptions sidecar;
+
+    // Hand each finished file to this uploader, as
+    // <filename>.<UTC time>-<n><extension>, instead of keeping it as
+    // .1 .. .<max_files>; trained dictionaries are uploaded too. Needs
+    // the cloud sinks in the build (v1.2.0)
+    std::shared_ptr<ArchiveUploader> uploader;
 };
 
+/**
+ * @brief Size-rotated file whose rotated files are compressed off the logging path
+ *
+ * The current file is <filename>; rotated ones are <filename>.1 (the
+ * newest) to .<max_files>, with the compressor's extension. A rotation
+ * parks the full file under a unique name, queues it and reopens, so
+ * logging threads do not wait for the compressor. Worker threads
+ * compress the queued files and shift them into place in rotation
+ * order. When max_pending files are already waiting, the rotation
+ * blocks until a worker takes one, which holds up logging rather than
+ * piling up plaintext on disk. A file that cannot be compressed (no zlib
+ * or zstd in the build, or an error) is kept uncompressed.
+ *
+ * With options.streaming the lines go through a compressor on the way to
+ * the file, so nothing is written twice and rotation has no compression
+ * left to do. The output is a series of complete frames, one ended every
+ * frame_flush_interval or frame_size bytes and on flush(), so a reader
+ * (or recovery after a crash) decodes everything up to the last one.
+ * max_size then counts uncompressed bytes.
+ *
+ * With options.sidecar the sink indexes each file as it writes it and
+ * leaves the index at <file>.meta, whatever the file is renamed or
+ * compressed to; tools/search_logs.py uses them to skip files.
+ *
+ * With options.uploader finished files leave the disk for object storage
+ * rather than the rotation cascade; see ArchiveUploader.
+ */
 class CompressedFileSink : public LogSink {
 public:
     CompressedFileSink(
@@ -34,7 +118,8 @@ public:
     ~CompressedFileSink() override;
 
     void log(const std::string& name, LogLevel level, const std::string& message) override;
-    void flush();
+    void log_record(const FormattedRecord& record) override;
+    void flush() override;
 
     size_t current_size() const { return current_size_; }
 
@@ -49,16 +134,53 @@ public:
     
     
     void enable_auto_tune(bool enable = true);
-    bool is_auto_tune_enabled() const { return options_.auto_tune; }
-    int get_current_compression_level() const { return current_level_; }
+    bool is_auto_tune_enabled() const;
+    int get_current_compression_level() const;
+
+    /**
+     * @brief Rotated files queued or being compressed
+     */
+    size_t pending_compressions() const;
+
+    /**
+     * @brief Id of the trained dictionary new files use, 0 before the first
+     */
+    uint32_t dictionary_id() const;
 
 private:
+    struct Job {
+        uint64_t sequence;
+        std::string parked;
+        bool streamed;  // Already compressed as it was written
+        // A dictionary training job instead, when there are samples
+        std::string samples;
+        std::vector<size_t> sample_sizes;
+    };
+    struct Dictionary {
+        uint32_t id;
+        std::string bytes;
+    };
+    class StreamEncoder;
+
+    // record is nullptr from the legacy log()
+    void write_line(const std::string& formatted, std::chrono::system_clock::time_point when, LogLevel level,
+                    const FormattedRecord* record);
     void rotate();
-    void compress_file(const std::string& source_path, const std::string& dest_path);
-    bool compress_gzip(const std::string& source, const std::string& dest);
-    bool compress_zstd(const std::string& source, const std::string& dest);
+    std::string current_filename() const;
+    uint64_t on_disk_size() const;  // Of the open file, under mutex_
+    void end_frame();
+    bool compress_file(const std::string& source_path, const std::string& dest_path, int level);
     std::string get_rotated_filename(size_t index) const;
     std::string get_compressed_extension() const;
+
+    void run_worker();
+    void compress_job(const Job& job);
+    void shift_in(uint64_t sequence, std::string path, bool compressed);
+    bool hand_off(uint64_t sequence, const std::string& path, bool compressed);
+    void sample_line(const std::string& formatted);
+    void train_dictionary(const Job& job);
+    std::shared_ptr<const Dictionary> current_dictionary() const;
+    void remove_unused_dictionaries();
     
   
     void update_compression_level();
@@ -72,7 +194,22 @@ private:
     
     std::ofstream file_;
     size_t current_size_;
+
+    // Streaming mode; guarded by mutex_
+    std::unique_ptr<StreamEncoder> encoder_;
+    std::string encoded_;
+    size_t frame_bytes_ = 0;
+    uint64_t stream_original_bytes_ = 0;
+    uint64_t stream_compressed_bytes_ = 0;
+    uint64_t stream_us_ = 0;
+    std::ofstream index_;  // With seekable
+    std::unique_ptr<sidecar::Builder> sidecar_;  // With options.sidecar
+    uint64_t file_offset_ = 0;
+    uint64_t frame_offset_ = 0;
+    int64_t frame_first_ms_ = 0;
+    int64_t frame_last_ms_ = 0;
     
+    // Stats, auto-tune state and the level; updated by the workers
     mutable std::mutex stats_mutex_;
     uint64_t files_compressed_;
     uint64_t original_bytes_;
@@ -85,6 +222,30 @@ private:
     size_t compression_count_;
     
     std::mutex mutex_;
+    uint64_t rotations_ = 0;  // Guarded by mutex_
+
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable space_cv_;
+    std::deque<Job> queue_;
+    size_t in_progress_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    // Dictionary training: samples are collected under mutex_ while a
+    // retrain is due, the workers train and publish under dict_mutex_
+    std::string samples_;
+    std::vector<size_t> sample_sizes_;
+    uint64_t next_training_ns_ = 0;
+    std::atomic<bool> training_{false};  // Cleared by the training worker
+    mutable std::mutex dict_mutex_;
+    std::shared_ptr<const Dictionary> dictionary_;
+    uint32_t previous_dictionary_id_ = 0;
+
+    // Finished jobs are shifted into place in rotation order
+    std::mutex shift_mutex_;
+    uint64_t next_shift_ = 0;
+    std::map<uint64_t, std::pair<std::string, bool>> finished_;
 };
 
 class CompressionUtils {
@@ -95,10 +256,21 @@ public:
         int level = 6
     );
 
+    /**
+     * @brief Compress in fixed-size chunks, so memory does not grow with the file
+     *
+     * workers > 0 hands the compression to that many zstd threads
+     * (ZSTD_c_nbWorkers) where libzstd was built with them.
+     * long_distance_matching finds repeats further back than the window,
+     * at the cost of more memory.
+     */
     static bool compress_file_zstd(
         const std::string& source_path,
         const std::string& dest_path,
-        int level = 3
+        int level = 3,
+        int workers = 0,
+        bool long_distance_matching = false,
+        std::string_view dictionary = {}
     );
 
     static size_t get_file_size(const std::string& path);
@@ -1,6 +1,7 @@
 #pragma once
 #include "file_sink.hpp"
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <ctime>
 
@@ -8,16 +9,22 @@ namespace Zyrnix {
 
 class DailyFileSink : public LogSink {
 public:
-    explicit DailyFileSink(const std::string& base_name);
+    explicit DailyFileSink(const std::string& base_name, const FlushPolicy& policy = FlushPolicy{});
+    ~DailyFileSink() override;
     void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void flush() override;
 
 private:
     std::string base_name;
     std::ofstream file;
     std::mutex mtx;
     std::string current_date;
+    int64_t next_rollover_ns = 0;  // Local midnight
+    LineBuffer buffer;
     void open_file();
-    std::string get_date();
+    std::string_view get_date();
+    void write_line(const std::string& line, LogLevel level);
 };
 
 }
@@ -1,19 +1,48 @@
 #pragma once
 #include "../log_sink.hpp"
-#include <fstream>
+#include "flush_policy.hpp"
+#include "group_commit.hpp"
+#include "log_file.hpp"
+#include <future>
+#include <memory>
 #include <string>
 #include <mutex>
 
 namespace Zyrnix {
 
+/**
+ * @brief Appends lines to a file through a LineBuffer
+ *
+ * See FlushPolicy for when lines reach the file and FileBackend for how;
+ * flush() always writes everything out. Records at policy.sync_on and
+ * sync() go through a GroupCommit, so they share syncs.
+ */
 class FileSink : public LogSink {
 public:
-    explicit FileSink(const std::string& filename);
+    explicit FileSink(const std::string& filename, const FlushPolicy& policy = FlushPolicy{});
+    ~FileSink() override;
     void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
+
+    /**
+     * @brief Get everything logged so far onto disk (v1.2.0)
+     *
+     * The future is ready once it is there, and carries std::system_error
+     * if the sync failed.
+     */
+    std::future<void> sync();
 
 private:
-    std::ofstream file;
+    void write_line(const std::string& line, LogLevel level);
+    bool durable(LogLevel level) const;
+    void start_commit();
+
     std::mutex mtx;
+    LineBuffer buffer;
+    LogFile file;
+    std::unique_ptr<GroupCommit> commit;  // Set by the constructor with sync_on, else by sync()
 };
 
 }
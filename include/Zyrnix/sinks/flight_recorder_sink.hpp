@@ -0,0 +1,77 @@
+#pragma once
+#include "../flight_recorder.hpp"
+#include "../log_sink.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+struct FlightRecorderOptions {
+    size_t capacity = 16 * 1024 * 1024;  // Ring bytes, rounded up to a power of two
+};
+
+/**
+ * @brief Keeps the last capacity bytes of records in a file-backed ring (v1.2.0)
+ *
+ * A black box: the ring is a MAP_SHARED mapping of the file, so what was
+ * written is in the page cache the moment log() returns and survives the
+ * process dying in any way, SIGKILL and the OOM killer included. Only a
+ * kernel crash or power loss before writeback loses it. A logging thread
+ * reserves its entry with one CAS, copies the record in and stores a
+ * commit word: no lock, no system call and no allocation, so it can stay
+ * on at Debug level. The oldest records are overwritten.
+ *
+ * Reopening a file with the same capacity carries on after what is
+ * there, bumping its generation, so the recording of a run that died
+ * survives the restart until the new one laps it; any other file at path
+ * is replaced. tools/zyrnix_flight (or flight::Reader) prints the
+ * recording oldest first. The layout is in flight_recorder.hpp. One
+ * process at a time per file. POSIX only.
+ *
+ * @code
+ * logger->add_sink(std::make_shared<Zyrnix::FlightRecorderSink>("/var/tmp/myapp.flight"));
+ * @endcode
+ */
+class FlightRecorderSink : public LogSink {
+public:
+    explicit FlightRecorderSink(const std::string& path, const FlightRecorderOptions& options = FlightRecorderOptions{});
+    ~FlightRecorderSink() override;
+
+    FlightRecorderSink(const FlightRecorderSink&) = delete;
+    FlightRecorderSink& operator=(const FlightRecorderSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+
+    /**
+     * @brief Start writeback of the ring (msync MS_ASYNC) without waiting
+     *
+     * Records are in the page cache once logged; this only matters for
+     * surviving a kernel crash.
+     */
+    void flush() override;
+
+    bool is_open() const { return header_ != nullptr; }
+    uint64_t generation() const { return header_ ? header_->generation : 0; }
+
+    /**
+     * @brief Records dropped for being larger than a quarter of the ring
+     */
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void write(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+               std::string_view logger_name, std::string_view message);
+
+    std::string path_;
+    flight::Header* header_ = nullptr;
+    char* data_ = nullptr;
+    uint64_t capacity_ = 0;
+    size_t mapped_size_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+}
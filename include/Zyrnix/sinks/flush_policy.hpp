@@ -0,0 +1,205 @@
+#pragma once
+#include "../log_level.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Zyrnix {
+
+class LogSink;
+
+/**
+ * @brief How FileSink and RotatingFileSink hand their buffer to the kernel (v1.2.0)
+ *
+ * Stream writes with a plain write() on the logging thread. IoUring
+ * submits each buffer to an io_uring and returns while it is written;
+ * IoUringRegistered also registers the file and the buffers with the
+ * ring, which saves the kernel mapping them on every write. Both fall
+ * back to Stream where io_uring is not available (not Linux, built with
+ * XLOG_NO_IO_URING, or refused by the kernel).
+ */
+enum class FileBackend {
+    Stream,
+    IoUring,
+    IoUringRegistered
+};
+
+/**
+ * @brief When a buffered sink hands its lines to the OS (v1.2.0)
+ *
+ * Lines collect in a buffer of buffer_size bytes, which goes out in one
+ * write whenever it fills. The other triggers write it out sooner. Each
+ * one can be turned off on its own; with all of them off (never()) only
+ * a full buffer, flush() and closing the sink write anything.
+ *
+ * The default keeps at most about a second of lines in memory and gets
+ * errors onto disk straight away.
+ */
+struct FlushPolicy {
+    size_t buffer_size = 64 * 1024;
+
+    // Write out once this many bytes are waiting; 0 waits for the buffer to fill
+    size_t every_bytes = 0;
+
+    // The background flusher writes out each sink this often; 0 for never
+    std::chrono::milliseconds interval{1000};
+
+    // A record at or above this level goes out at once, with everything before it
+    std::optional<LogLevel> flush_on = LogLevel::Error;
+
+    // Only FileSink, RotatingFileSink and BinaryFileSink look at this
+    FileBackend backend = FileBackend::Stream;
+
+    // Logging a record at or above this level returns once it is on disk.
+    // Concurrent ones share a sync (see GroupCommit). FileSink and
+    // RotatingFileSink only
+    std::optional<LogLevel> sync_on;
+
+    // One write per line, as an unbuffered stream would do
+    static FlushPolicy every_line() {
+        FlushPolicy policy;
+        policy.every_bytes = 1;
+        policy.interval = std::chrono::milliseconds(0);
+        policy.flush_on.reset();
+        return policy;
+    }
+
+    // Every record at or above level is on disk before logging it returns
+    static FlushPolicy durable(LogLevel level = LogLevel::Trace) {
+        FlushPolicy policy;
+        policy.sync_on = level;
+        return policy;
+    }
+
+    // Only a full buffer, flush() and close write, leaving the rest to the OS
+    static FlushPolicy never(size_t buffer_size = 64 * 1024) {
+        FlushPolicy policy;
+        policy.buffer_size = buffer_size;
+        policy.interval = std::chrono::milliseconds(0);
+        policy.flush_on.reset();
+        return policy;
+    }
+};
+
+/**
+ * @brief A sink's pending lines and the policy that writes them out (v1.2.0)
+ *
+ * Not synchronized: the owning sink calls it under its own lock. Out is
+ * a std::ostream or a LogFile; anything with write(const char*,
+ * std::streamsize) and flush() will do. A stream should be unbuffered
+ * (pubsetbuf(nullptr, 0) before open), so each write-out is one write()
+ * of the whole buffer rather than a copy into the stream's own small one.
+ */
+class LineBuffer {
+public:
+    explicit LineBuffer(const FlushPolicy& policy);
+
+    /**
+     * @brief Add line and a newline, writing the buffer out if the policy says so
+     */
+    template <typename Out>
+    void append(Out& out, std::string_view line, LogLevel level) {
+        add(out, line, true, level);
+    }
+
+    /**
+     * @brief As append(), for a record that carries its own framing (v1.2.0)
+     */
+    template <typename Out>
+    void append_record(Out& out, std::string_view record, LogLevel level) {
+        add(out, record, false, level);
+    }
+
+    /**
+     * @brief As append(), with prefix before the line and suffix after it,
+     *        e.g. color codes (v1.2.0)
+     */
+    template <typename Out>
+    void append_wrapped(Out& out, std::string_view prefix, std::string_view line, std::string_view suffix,
+                        LogLevel level) {
+        add(out, line, true, level, prefix, suffix);
+    }
+
+    /**
+     * @brief Write everything pending and flush the stream
+     */
+    template <typename Out>
+    void write_out(Out& out) {
+        if (!buffer_.empty()) {
+            out.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+        out.flush();
+    }
+
+    size_t pending() const { return buffer_.size(); }
+    const FlushPolicy& policy() const { return policy_; }
+
+private:
+    template <typename Out>
+    void add(Out& out, std::string_view line, bool newline, LogLevel level, std::string_view prefix = {},
+             std::string_view suffix = {}) {
+        // Keep whole lines together: a line that will not fit sends the buffer first
+        const size_t size = prefix.size() + line.size() + suffix.size() + newline;
+        if (!buffer_.empty() && buffer_.size() + size > policy_.buffer_size) {
+            out.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+        buffer_.append(prefix);
+        buffer_.append(line);
+        buffer_.append(suffix);
+        if (newline) {
+            buffer_.push_back('\n');
+        }
+
+        if (buffer_.size() >= policy_.buffer_size ||
+            (policy_.every_bytes > 0 && buffer_.size() >= policy_.every_bytes) ||
+            (policy_.flush_on && level >= *policy_.flush_on)) {
+            write_out(out);
+        }
+    }
+
+    FlushPolicy policy_;
+    std::string buffer_;
+};
+
+/**
+ * @brief One thread that flushes buffered sinks on their intervals (v1.2.0)
+ *
+ * Sinks register themselves when their policy has an interval and must
+ * unregister before they are destroyed. remove() waits for a flush of
+ * that sink in progress, so once it returns the flusher no longer
+ * touches it. The thread starts with the first sink and is never
+ * joined, so sinks held by static loggers can unregister during exit.
+ */
+class BackgroundFlusher {
+public:
+    static BackgroundFlusher& instance();
+
+    void add(LogSink* sink, std::chrono::milliseconds interval);
+    void remove(LogSink* sink);
+
+private:
+    BackgroundFlusher() = default;
+    void run();
+
+    struct Entry {
+        LogSink* sink;
+        std::chrono::steady_clock::duration interval;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<Entry> entries_;
+    bool started_ = false;
+};
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Gets a file sink's lines onto disk for many waiters at once (v1.2.0)
+ *
+ * request() returns a future that becomes ready once everything the sink
+ * accepted before the call is on disk. A thread per instance serves the
+ * requests in rounds. Each round calls write_out, which hands the
+ * pending lines to the kernel under the sink's lock and returns a
+ * descriptor for the file (LogFile::open_for_sync()). The round then
+ * syncs that descriptor with the sink unlocked, so writers carry on
+ * meanwhile, and readies every request it took. Requests made during a
+ * sync are all served by the next one: a request waits for at most two
+ * syncs, and however many writers there are, they share them. A failed
+ * sync reaches the round's futures as std::system_error.
+ */
+class GroupCommit {
+public:
+    // Returns a descriptor for the round to sync and close, or -1 if there is no file
+    using WriteOut = std::function<int()>;
+
+    explicit GroupCommit(WriteOut write_out);
+
+    /**
+     * @brief Serve the requests still waiting, then stop
+     */
+    ~GroupCommit();
+
+    GroupCommit(const GroupCommit&) = delete;
+    GroupCommit& operator=(const GroupCommit&) = delete;
+
+    std::future<void> request();
+
+    /**
+     * @brief Syncs issued so far
+     */
+    uint64_t syncs() const { return syncs_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    WriteOut write_out_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<std::promise<void>> waiting_;
+    bool stop_ = false;
+    std::atomic<uint64_t> syncs_{0};
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Zyrnix {
+
+struct HttpResponse {
+    int status_code = 0;
+    std::string body;
+    bool success = false;  // The exchange completed; check status_code for the outcome
+    std::string error;     // Why it did not, when !success, or the grpc-message
+    int grpc_status = -1;  // grpc-status of a gRPC call, -1 if the server sent none (v1.2.0)
+    std::vector<std::string> headers;  // "Name: value", with HttpRequest::capture_headers (v1.2.0)
+};
+
+/**
+ * @brief One request for HttpTransport (v1.2.0)
+ */
+struct HttpRequest {
+    std::string url;
+    std::string method;  // Empty for POST; or "PUT", "DELETE", ...
+    std::string body;
+    std::vector<std::string> headers;  // "Name: value"
+    long timeout_ms = 5000;
+    bool insecure_skip_verify = false;
+    std::string ca_cert_path;
+
+    // Failed connections, 429 and 5xx are retried after retry_delay_ms,
+    // doubling each time, until max_attempts attempts have been made
+    int max_attempts = 1;
+    long retry_delay_ms = 100;
+
+    // A gRPC call: HTTP/2 only (with prior knowledge on http:// URLs), and
+    // the grpc-status trailer decides success; UNAVAILABLE and the other
+    // transient codes are retried like a 503 (v1.2.0)
+    bool grpc = false;
+
+    // Sign with AWS Signature V4 through curl (7.75 or later): the
+    // provider string, e.g. "aws:amz:us-east-1:s3", and "key:secret"
+    std::string aws_sigv4;
+    std::string credentials;
+
+    // Upload at most this many bytes a second; 0 for no limit
+    long max_send_speed = 0;
+
+    // Keep the response headers in HttpResponse::headers
+    bool capture_headers = false;
+};
+
+/**
+ * @brief Called on the I/O thread with the final response, the number of
+ *        attempts it took and the request, which it may take from
+ */
+using HttpCompletion = std::function<void(const HttpResponse& response, int attempts, HttpRequest& request)>;
+
+/**
+ * @brief One I/O thread carrying every cloud sink's requests (v1.2.0)
+ *
+ * Requests run concurrently on a curl multi handle, which keeps
+ * connections alive per host between requests and multiplexes them
+ * over HTTP/2 where the server allows it. At most max_in_flight
+ * requests are in flight at once; the rest wait in order. Retry delays
+ * are timers on the same thread, so no thread sleeps on a failing
+ * endpoint.
+ *
+ * Sinks batch on the I/O thread too: a Client is pumped after wake()
+ * and at the time its previous pump() asked for, and submits whatever
+ * batches are due.
+ */
+class HttpTransport {
+public:
+    struct Options {
+        size_t max_in_flight = 16;
+        long max_host_connections = 4;
+    };
+
+    class Client {
+    public:
+        virtual ~Client() = default;
+
+        /**
+         * @brief Submit due batches; returns when to be pumped again
+         *        (time_point::max() for only after wake())
+         */
+        virtual std::chrono::steady_clock::time_point pump(HttpTransport& transport) = 0;
+    };
+
+    struct Stats {
+        uint64_t requests;   // Completed, successfully or not
+        uint64_t retries;
+        uint64_t failures;   // Completed without a 2xx response
+        size_t in_flight;
+        size_t queued;
+    };
+
+    /**
+     * @brief The transport the built-in sinks share; started on first use
+     */
+    static HttpTransport& instance();
+
+    void set_options(const Options& options);
+
+    /**
+     * @brief Pump client from the I/O thread until detach()
+     */
+    void attach(Client* client);
+
+    /**
+     * @brief Stop pumping client; waits for a pump in progress
+     */
+    void detach(Client* client);
+
+    /**
+     * @brief Pump every client soon, from any thread
+     */
+    void wake();
+
+    void submit(HttpRequest request, HttpCompletion done);
+
+    /**
+     * @brief submit() and wait; must not be called from the I/O thread
+     */
+    HttpResponse post(HttpRequest request);
+
+    Stats get_stats() const;
+
+private:
+    struct Transfer;
+    struct ClientEntry {
+        Client* client;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    HttpTransport();
+    ~HttpTransport() = delete;  // Leaked, so it outlives every static logger's sinks
+    void start();  // Under mutex_
+    void run();
+    void start_transfers();
+    void finish(Transfer* transfer, int result);
+
+    mutable std::mutex mutex_;
+    Options options_;
+    bool options_changed_ = true;
+    bool started_ = false;
+    bool woken_ = false;
+    std::deque<std::unique_ptr<Transfer>> queued_;  // Waiting for an in-flight slot, under mutex_
+    uint64_t requests_ = 0;
+    uint64_t retries_ = 0;
+    uint64_t failures_ = 0;
+    size_t in_flight_ = 0;
+
+    // Held while clients are pumped, which is what lets detach() wait for it
+    std::mutex clients_mutex_;
+    std::vector<ClientEntry> clients_;
+
+    // I/O thread only
+    void* multi_ = nullptr;               // CURLM*
+    std::vector<void*> idle_handles_;     // CURL*, reset and ready for reuse
+    std::vector<std::unique_ptr<Transfer>> active_;
+    std::vector<std::unique_ptr<Transfer>> backing_off_;
+};
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef XLOG_NO_ASYNC
+#include "../log_sink.hpp"
+#include "../async/async_queue.hpp"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Zyrnix {
+
+class SinkMetrics;
+
+/**
+ * @brief Options for giving a sink its own queue and worker (v1.2.0)
+ */
+struct SinkOptions {
+    bool dedicated_worker = false;    // Run the sink on its own thread behind a bounded queue
+    size_t queue_capacity = 8192;     // Records buffered for this sink (0 = unbounded)
+    OverflowPolicy overflow_policy = OverflowPolicy::DropNewest;
+    size_t block_timeout_ms = 100;    // Only used with OverflowPolicy::Block
+    size_t max_batch_size = 256;      // Records handed to the sink per log_batch() call
+    size_t shutdown_timeout_ms = 5000;
+};
+
+/**
+ * @brief Runs a sink on a dedicated worker thread (v1.2.0)
+ *
+ * log(), log_record() and log_batch() only copy the records into a bounded queue, so a
+ * sink that blocks (e.g. a network sink retrying a request) no longer
+ * holds up the other sinks of the logger. Queue depth and drops are
+ * reported through the SinkMetrics registered under the sink's name.
+ * The wrapper's own level stays at Trace: records below the inner
+ * sink's level, read on each call, are dropped before they are queued.
+ */
+class IsolatedSink : public LogSink {
+public:
+    IsolatedSink(LogSinkPtr inner, const std::string& name, const SinkOptions& options = SinkOptions());
+    ~IsolatedSink() override;
+
+    IsolatedSink(const IsolatedSink&) = delete;
+    IsolatedSink& operator=(const IsolatedSink&) = delete;
+
+    void log(const std::string& name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+
+    /**
+     * @brief Wait until the worker has written everything queued so far
+     *
+     * Pushes a fence record and waits (up to shutdown_timeout_ms) for the
+     * worker to reach it and flush the wrapped sink.
+     */
+    void flush() override;
+
+    bool is_cloud_sink() const override { return inner_->is_cloud_sink(); }
+    void set_formatter(Formatter f) override { inner_->set_formatter(std::move(f)); }
+
+    /**
+     * @brief Stop accepting records, drain the queue and join the worker
+     */
+    void stop();
+
+    LogSinkPtr inner() const { return inner_; }
+    size_t queue_depth() const { return queue_.size(); }
+
+private:
+    void enqueue(const FormattedRecord& record);
+    void enqueue(LogRecord record);
+    void worker_loop();
+    void write_batch(std::vector<LogRecord>& batch);
+
+    LogSinkPtr inner_;
+    SinkOptions options_;
+    AsyncQueue queue_;
+    std::shared_ptr<SinkMetrics> metrics_;
+    std::thread worker_;
+};
+
+}
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+#include "../log_sink.hpp"
+#include "../log_level.hpp"
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+namespace Zyrnix {
+
+struct JournaldOptions {
+    std::string identifier;  // SYSLOG_IDENTIFIER; defaults to the program's name
+    std::string socket_path = "/run/systemd/journal/socket";
+};
+
+/**
+ * @brief Sends records to systemd-journald as journal fields (v1.2.0)
+ *
+ * Each record is one datagram in the journal's native protocol, the one
+ * sd_journal_sendv() speaks: MESSAGE, PRIORITY, SYSLOG_IDENTIFIER,
+ * LOGGER, CODE_FILE/CODE_LINE/CODE_FUNC when logged through a macro,
+ * TRACE_ID/SPAN_ID, and the record's fields with their names uppercased
+ * (user.id becomes USER_ID). The datagram is gathered with sendmsg()
+ * straight from the record's message and field values, so nothing is
+ * formatted and the formatter is not used; records too large for a
+ * datagram go through a sealed memfd, as libsystemd does. The socket is
+ * addressed on every send, so a restarted journald is picked up.
+ *
+ * Linux only, and built when ENABLE_JOURNALD is on.
+ */
+class JournaldSink : public LogSink {
+public:
+    explicit JournaldSink(const JournaldOptions& options = JournaldOptions{});
+    ~JournaldSink() override;
+
+    JournaldSink(const JournaldSink&) = delete;
+    JournaldSink& operator=(const JournaldSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+
+private:
+    void write(std::string_view logger_name, LogLevel level, std::string_view message,
+               const FormattedRecord* record);
+    void send(struct ::iovec* iov, size_t count);
+    bool send_memfd(struct ::iovec* iov, size_t count);
+
+    int fd_ = -1;
+    struct ::sockaddr_un addr_;
+    std::string identifier_;  // "SYSLOG_IDENTIFIER=<name>\n"
+};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "../log_sink.hpp"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace Zyrnix {
+
+/**
+ * @brief Builds the real sink when the first record arrives (v1.2.0)
+ *
+ * For configs with many loggers, most of which may never log: a file is
+ * not opened, nor a connection made, until there is something to write.
+ * A formatter set before then is applied to the sink once it is built.
+ * If the factory returns nullptr or throws, records are dropped and
+ * the factory is not called again.
+ */
+class LazySink : public LogSink {
+public:
+    using Factory = std::function<LogSinkPtr()>;
+
+    // cloud answers is_cloud_sink() before the sink exists
+    explicit LazySink(Factory factory, bool cloud = false);
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    // Nothing to flush until the sink exists
+    void flush() override;
+
+    bool is_cloud_sink() const override { return cloud_; }
+    void set_formatter(Formatter f) override;
+
+    bool is_open() const { return open_.load(std::memory_order_acquire); }
+    // nullptr until the first record
+    LogSinkPtr inner() const { return is_open() ? inner_ : nullptr; }
+
+private:
+    LogSink* get();
+
+    Factory factory_;
+    bool cloud_;
+    std::once_flag once_;
+    std::atomic<bool> open_{false};
+    LogSinkPtr inner_;
+    std::optional<Formatter> pending_formatter_;
+};
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "flush_policy.hpp"
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <string>
+
+namespace Zyrnix {
+
+/**
+ * @brief An append-only file written through a FileBackend (v1.2.0)
+ *
+ * What FileSink and RotatingFileSink write to. With FileBackend::Stream
+ * it is an unbuffered std::ofstream, so write() is one write() call. With
+ * an io_uring backend it owns a ring and two page-aligned buffers of
+ * buffer_size bytes: write() copies into the free buffer, submits it at
+ * the file offset it reserved and returns, so the caller fills the next
+ * one while the first is in flight. It waits only when both are. Not
+ * synchronized; the owning sink calls it under its lock.
+ *
+ * The io_uring backends write at offsets counted from the size of the
+ * file when it was opened, so another writer appending to the same file
+ * at the same time is not supported (with Stream it merely interleaves).
+ */
+class LogFile {
+public:
+    LogFile(FileBackend backend, size_t buffer_size);
+    ~LogFile();
+
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    /**
+     * @brief Open filename for appending, closing the file open before
+     */
+    bool open(const std::string& filename);
+    bool is_open() const;
+
+    /**
+     * @brief Wait for writes in flight and close
+     */
+    void close();
+
+    /**
+     * @brief Hand data to the kernel; with io_uring, before it is written
+     */
+    void write(const char* data, std::streamsize size);
+
+    /**
+     * @brief Collect finished writes without waiting for the rest
+     */
+    void flush();
+
+    /**
+     * @brief Return once every earlier write has completed
+     */
+    void wait();
+
+    /**
+     * @brief Wait for writes in flight and get the file's data onto disk
+     *
+     * fdatasync (fsync on macOS) with the caller's lock held; false on
+     * failure or where it is not supported.
+     */
+    bool sync();
+
+    /**
+     * @brief A new descriptor for the open file, or -1
+     *
+     * For syncing the file without holding the sink's lock, while later
+     * lines are written: the descriptor stays on this file through a
+     * rotation. The caller closes it.
+     */
+    int open_for_sync() const;
+
+    /**
+     * @brief fdatasync fd (fsync on macOS); false on failure
+     */
+    static bool sync_descriptor(int fd);
+
+    /**
+     * @brief Bytes in the file, counting writes still in flight
+     */
+    uint64_t size() const { return size_; }
+
+    /**
+     * @brief Whether writes go through io_uring, false after a fallback
+     */
+    bool uses_io_uring() const { return ring_ != nullptr; }
+
+    /**
+     * @brief Writes the kernel failed, whose bytes were dropped
+     */
+    uint64_t write_errors() const { return write_errors_; }
+
+private:
+    struct Ring;
+
+    std::unique_ptr<Ring> ring_;
+    std::ofstream stream_;
+    int fd_ = -1;  // The file, with a ring
+    std::string path_;  // The file, with a stream
+    uint64_t size_ = 0;
+    uint64_t write_errors_ = 0;
+};
+
+}
@@ -1,26 +1,84 @@
 #pragma once
 #include "../log_sink.hpp"
+#include "../memory_budget.hpp"
+#include "../trace_context.hpp"
+#include "http_transport.hpp"
+#include "spill_queue.hpp"
 #include <string>
 #include <vector>
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <condition_variable>
+#include <unordered_map>
 
 namespace Zyrnix {
 
+class CrashWriter;
+
+class SinkMetrics;
+
+/**
+ * @brief Body of a push request (v1.2.0)
+ */
+enum class LokiEncoding {
+    Json,      // application/json
+    JsonGzip,  // application/json, Content-Encoding: gzip (plain JSON without zlib)
+    Protobuf   // application/x-protobuf, snappy-compressed logproto.PushRequest
+};
+
 struct LokiOptions {
     size_t batch_size = 10;
     uint64_t flush_interval_ms = 0;
     long timeout_ms = 5000;
     bool insecure_skip_verify = false;
     std::string ca_cert_path;
+    size_t max_queue_size = 10000;  // Entries waiting to be sent; more are dropped (v1.2.0)
+    LokiEncoding encoding = LokiEncoding::Json;  // Fixed at construction; set_options keeps it (v1.2.0)
+    int gzip_level = 6;
+
+    // Labels added to the sink's labels from each record, making one stream
+    // per distinct set: "level", "logger" or a field key. A record without
+    // the field leaves that label out. Fixed at construction (v1.2.0)
+    std::vector<std::string> stream_labels;
+    // Distinct streams the sink will create; entries beyond it go to the
+    // stream with only the sink's labels (v1.2.0)
+    size_t max_streams = 64;
+    // Send once this many bytes of entries are waiting, whatever their
+    // count; 0 counts entries only (v1.2.0)
+    size_t batch_bytes = 1024 * 1024;
+    // Disk spill for batches Loki cannot take, fixed at construction (v1.2.0)
+    SpillOptions spill;
 };
 
-class LokiSink : public LogSink {
+/**
+ * @brief Pushes entries to Loki from the shared HTTP transport
+ *
+ * log() only appends the encoded entry to its stream's pending buffer.
+ * HttpTransport's I/O thread swaps those buffers for the sink's own once
+ * batch_size entries or batch_bytes bytes are waiting, the oldest entry
+ * has waited flush_interval_ms or flush() is called, and posts every
+ * stream in one push request over a kept-alive connection (HTTP/2 over
+ * TLS where the server offers it). Retries are timers on that thread,
+ * never a sleep on the logging thread, and reuse the body built for the
+ * first attempt.
+ *
+ * With LokiEncoding::Protobuf, entries are logproto EntryAdapter messages
+ * and the logger, level, trace ids and fields go in their structured
+ * metadata; with JSON they are keys of the entry object.
+ */
+class LokiSink : public LogSink, private HttpTransport::Client {
 public:
     LokiSink(const std::string& url, const std::string& labels = "", const LokiOptions& opts = LokiOptions());
+    ~LokiSink() override;
     void log(const std::string& name, LogLevel level, const std::string& message) override;
-    void flush();
+
+    /**
+     * @brief Queue an entry carrying the record's fields and trace ids (v1.2.0)
+     */
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
     const char* name_str() const noexcept { return "LokiSink"; }
 
     bool is_cloud_sink() const override { return true; }
@@ -28,14 +86,73 @@ public:
     void set_options(const LokiOptions& opts);
 
 private:
+    // Entries as comma-separated JSON objects or concatenated protobuf
+    // entries. entries and count are under mutex_; pump() swaps them
+    // into sending, so both keep their capacity. Streams live as long as
+    // the sink, so the I/O thread may read labels without the lock.
+    struct Stream {
+        std::string labels;
+        std::string entries;
+        size_t count = 0;
+        std::string sending;  // I/O thread only
+    };
+
     std::string url_;
     std::string labels_;
     LokiOptions options_;
-    std::vector<std::string> buffer_;
+
+    const LokiEncoding encoding_;
+    const std::vector<std::string> stream_labels_;
+    std::string label_prefix_;  // labels_ without its closing brace
+    std::vector<std::string> http_headers_;
+
+    std::vector<std::unique_ptr<Stream>> streams_;  // The first has only labels_
+    std::unordered_map<std::string, Stream*> stream_index_;
+    std::string label_key_;  // Labels of the entry being appended
+    std::string entry_;      // Protobuf entry before its length is known
+    size_t pending_count_ = 0;
+    size_t pending_bytes_ = 0;
+    BudgetAccount budget_{"LokiSink"};  // Charged pending_bytes_ (v1.2.0)
+    std::chrono::steady_clock::time_point oldest_pending_;
+    size_t in_flight_ = 0;  // Entries swapped out but not sent yet
+    size_t flush_waiters_ = 0;
+    bool running_ = true;
     std::mutex mutex_;
-    std::chrono::system_clock::time_point last_flush_time_{};
+    std::condition_variable flushed_cv_;  // Signalled when a batch has been sent
+
+    std::shared_ptr<SinkMetrics> metrics_;
+    std::unique_ptr<SpillQueue> spill_;
+    int crash_slot_ = -1;
+
+    // I/O thread only
+    std::vector<Stream*> sending_;
+    std::string body_;
+    std::string compressed_;
 
-    void send_batch();
+    // Appends an entry to its stream, under mutex_; false if the queue is full.
+    // record: where the entry's fields come from, or nullptr
+    bool append_entry(std::string_view logger_name, LogLevel level, std::string_view message,
+                      std::chrono::system_clock::time_point timestamp, const TraceContext& trace,
+                      const FormattedRecord* record = nullptr);
+    Stream& stream_for(std::string_view logger_name, LogLevel level, const FormattedRecord* record);
+    void append_json_entry(Stream& stream, std::string_view logger_name, LogLevel level, std::string_view message,
+                           std::chrono::system_clock::time_point timestamp, const TraceContext& trace,
+                           const FormattedRecord* record);
+    void append_protobuf_entry(Stream& stream, std::string_view logger_name, LogLevel level,
+                               std::string_view message, std::chrono::system_clock::time_point timestamp,
+                               const TraceContext& trace, const FormattedRecord* record);
+    bool batch_full() const;  // Under mutex_
+    bool wake_needed(bool was_full, bool was_empty) const;  // Under mutex_, after appending
+    std::chrono::steady_clock::time_point pump(HttpTransport& transport) override;
+    std::chrono::steady_clock::time_point send_batch(HttpTransport& transport);
+    HttpRequest base_request();
+    void on_sent(const HttpResponse& response, int attempts, size_t count, HttpRequest& request);
+    void on_replayed(const HttpResponse& response, uint32_t events);
+    // Builds body_ from sending_; returns the bytes to post
+    std::string_view build_body(const LokiOptions& options);
+    // crash::DrainFn: each stream's labels, then its pending and in-flight
+    // entries as they are encoded (v1.2.0)
+    static void drain_for_crash(const void* sink, CrashWriter& out);
 };
 
 using LokiSinkPtr = std::shared_ptr<LokiSink>;
@@ -0,0 +1,102 @@
+#pragma once
+#include "../log_sink.hpp"
+#include "../rcu.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace Zyrnix {
+
+struct MmapFileOptions {
+    // Each segment is preallocated and mapped at this size
+    size_t segment_size = 64 * 1024 * 1024;
+
+    // Finished segments beyond this many are deleted, oldest first; 0 keeps all
+    size_t max_segments = 0;
+
+    // How often the worker starts writeback of new bytes (msync MS_ASYNC)
+    std::chrono::milliseconds sync_interval{1000};
+};
+
+/**
+ * @brief Appends lines to preallocated, memory-mapped segment files (v1.2.0)
+ *
+ * Segments are named <base_name>.<generation>.log, the generation
+ * counting up from the highest one already on disk, so rolling over
+ * renames nothing. A logging thread reserves its bytes with one
+ * fetch_add on the current segment's cursor and copies the line in; no
+ * lock is taken and no system call made. The thread whose line does not
+ * fit rolls to the next segment, which the worker has already allocated
+ * and mapped, and the worker trims the full one to the bytes used once
+ * every writer has left it (an EpochDomain grace period).
+ *
+ * A line is in the page cache as soon as log() returns, so it survives
+ * the process crashing; only a kernel crash or power loss before
+ * writeback loses it. A segment left behind by a crash keeps its full
+ * preallocated size, with NUL bytes after the last line. Lines longer
+ * than a segment are dropped and counted. POSIX only.
+ */
+class MmapFileSink : public LogSink {
+public:
+    explicit MmapFileSink(const std::string& base_name, const MmapFileOptions& options = MmapFileOptions{});
+    ~MmapFileSink() override;
+
+    MmapFileSink(const MmapFileSink&) = delete;
+    MmapFileSink& operator=(const MmapFileSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+
+    /**
+     * @brief Start writeback of the current segment without waiting for it
+     *
+     * Lines are already in the page cache once logged, so there is
+     * nothing to push; this only asks the kernel to write them sooner.
+     */
+    void flush() override;
+
+    /**
+     * @brief Path of the segment being written
+     */
+    std::string current_path() const;
+
+    /**
+     * @brief Lines dropped: longer than a segment, or no segment could be created
+     */
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Segment;
+
+    void write(std::string_view line);
+    std::unique_ptr<Segment> make_segment(uint64_t generation) const;
+    void roll(const Segment* full);
+    void run();
+
+    std::string base_name_;
+    MmapFileOptions options_;
+    std::atomic<uint64_t> dropped_{0};
+
+    RcuPtr<Segment> current_;
+
+    // Rolling, the spare and retention; also serializes current_'s writers
+    mutable std::mutex mtx_;
+    std::unique_ptr<Segment> spare_;
+    uint64_t next_generation_ = 0;
+    uint64_t current_generation_ = 0;
+    std::deque<std::string> finished_;  // Paths of earlier segments, oldest first
+
+    std::condition_variable cv_;
+    bool stop_ = false;
+    bool rolled_ = false;
+    std::thread worker_;
+};
+
+}
@@ -1,27 +1,100 @@
 #pragma once
 #include "Zyrnix/log_sink.hpp"
-#include <vector>
+#include "Zyrnix/rcu.hpp"
+#include <functional>
 #include <memory>
-
+#include <mutex>
+#include <vector>
 
 namespace Zyrnix {
 
+class ThreadPool;
+
+/**
+ * @brief A group of sinks that share one level, one filter and one record (v1.2.0)
+ *
+ * Every record that passes the group's level (set_level()) and filter is
+ * handed to each child whose own level it reaches, so a check the
+ * children have in common runs once for all of them. Children are kept
+ * in an immutable snapshot swapped in by add_sink() and remove_sink(),
+ * which may be called while other threads log through the group.
+ *
+ * Children run one after another on the logging thread unless they are
+ * added with Dispatch::Pooled and the group has a thread pool: those run
+ * on the pool at the same time as each other and as the inline children,
+ * and the call returns once all of them have finished, so a slow sink
+ * costs the caller its own time rather than adding to everyone else's.
+ * Called from one of the pool's own workers, pooled children run inline.
+ */
 class MultiSink : public LogSink {
 public:
-    MultiSink() = default;
+    enum class Dispatch { Inline, Pooled };
+
+    using Filter = std::function<bool(const FormattedRecord&)>;
+
+    MultiSink();
+    ~MultiSink() override;
+
+    MultiSink(const MultiSink&) = delete;
+    MultiSink& operator=(const MultiSink&) = delete;
+
+    void add_sink(LogSinkPtr sink, Dispatch dispatch = Dispatch::Inline);
+
+    /**
+     * @brief Remove a child; returns once no call still running can reach it
+     * @return false if sink is not in the group
+     */
+    bool remove_sink(const LogSinkPtr& sink);
 
-    void add_sink(LogSinkPtr sink) {
-        sinks.push_back(sink);
-    }
+    size_t size() const;
 
-    void log(const std::string& logger_name, LogLevel level, const std::string& message) override {
-        for (auto& sink : sinks) {
-            sink->log(logger_name, level, message);
-        }
-    }
+    /**
+     * @brief Records the filter rejects reach no child; an empty filter takes all
+     *
+     * Called on every logging thread at once, so it must be thread-safe.
+     */
+    void set_filter(Filter filter);
+
+#ifndef XLOG_NO_ASYNC
+    /**
+     * @brief Pool that runs Dispatch::Pooled children; nullptr runs them inline
+     */
+    void set_thread_pool(std::shared_ptr<ThreadPool> pool);
+#endif
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+
+    // Inline children with the same layout share one rendering of the record
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+
+    // Pooled children flush in parallel, like they log
+    void flush() override;
+
+    // Sets the layout of every current child
+    void set_formatter(Formatter f) override;
+
+    struct Child {
+        LogSinkPtr sink;
+        Dispatch dispatch;
+    };
+
+    struct Group {
+        std::vector<Child> children;
+        Filter filter;
+        std::shared_ptr<ThreadPool> pool;  // Set only when a child runs on it
+        size_t pooled = 0;                 // Children that run on pool
+    };
 
 private:
-    std::vector<LogSinkPtr> sinks;
+    // Caller holds mtx_; returns the grace-period epoch of the old snapshot
+    uint64_t publish();
+
+    mutable std::mutex mtx_;  // Serializes changes to the snapshot
+    std::vector<Child> children_;
+    Filter filter_;
+    std::shared_ptr<ThreadPool> pool_;
+    RcuPtr<Group> group_;
 };
 
 }
@@ -6,6 +6,7 @@ namespace Zyrnix {
 class NullSink : public LogSink {
 public:
     void log(const std::string& logger_name, LogLevel level, const std::string& message) override {}
+    void log_record(const FormattedRecord& record) override {}
 };
 
 }
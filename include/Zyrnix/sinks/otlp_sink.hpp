@@ -0,0 +1,149 @@
+#pragma once
+#include "../log_sink.hpp"
+#include "../trace_context.hpp"
+#include "http_transport.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief How OtlpLogSink reaches the collector (v1.2.0)
+ */
+enum class OtlpProtocol {
+    HttpProtobuf,  // POST application/x-protobuf to the logs URL (port 4318)
+    Grpc           // LogsService/Export over HTTP/2 (port 4317)
+};
+
+struct OtlpOptions {
+    // HttpProtobuf: the full logs URL. Grpc: the collector's base URL,
+    // e.g. http://localhost:4317, unencrypted with h2c on http://
+    std::string endpoint = "http://localhost:4318/v1/logs";
+    OtlpProtocol protocol = OtlpProtocol::HttpProtobuf;
+    std::vector<std::string> headers;  // "Name: value", e.g. an API key
+
+    // Resource attributes; service.name defaults to unknown_service:<program>
+    std::vector<std::pair<std::string, std::string>> resource_attributes;
+
+    // The BatchLogRecordProcessor's settings, at its defaults: records
+    // beyond max_queue_size are dropped, and a batch of up to
+    // max_export_batch_size goes every schedule_delay, or as soon as that
+    // many are waiting
+    size_t max_queue_size = 2048;
+    std::chrono::milliseconds schedule_delay{1000};
+    size_t max_export_batch_size = 512;
+    std::chrono::milliseconds export_timeout{30000};  // Per attempt
+
+    // Failed connections, 429, 5xx and transient gRPC codes are retried
+    int max_attempts = 5;
+    std::chrono::milliseconds retry_delay{1000};  // Doubling each time
+
+    bool insecure_skip_verify = false;
+    std::string ca_cert_path;
+};
+
+/**
+ * @brief Exports records to an OpenTelemetry collector over OTLP (v1.2.0)
+ *
+ * Works as the SDK's BatchLogRecordProcessor with an OTLP exporter: each
+ * record is encoded as an OTLP LogRecord when it is logged and queued,
+ * and HttpTransport's I/O thread sends the queue in batches, one export
+ * in flight at a time. Nothing goes through the formatter: the level
+ * becomes severity_number and severity_text, the message the body, the
+ * record's fields typed attributes (integers as int_value, floats as
+ * double_value, booleans as bool_value), the trace context trace_id,
+ * span_id and flags, and a macro's call site the code.* attributes. The
+ * logger name is the instrumentation scope.
+ *
+ * flush() is forceFlush: it returns once everything queued before it has
+ * been exported or has failed. The destructor does the same.
+ */
+class OtlpLogSink : public LogSink, private HttpTransport::Client {
+public:
+    explicit OtlpLogSink(const OtlpOptions& options = OtlpOptions{});
+    ~OtlpLogSink() override;
+
+    OtlpLogSink(const OtlpLogSink&) = delete;
+    OtlpLogSink& operator=(const OtlpLogSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
+
+    bool is_cloud_sink() const override { return true; }
+
+    struct Stats {
+        uint64_t records_exported;
+        uint64_t records_failed;   // In exports that failed after their retries
+        uint64_t records_dropped;  // Logged while the queue was full
+        uint64_t exports;
+        uint64_t retries;
+        size_t queue_size;
+    };
+
+    Stats get_stats() const;
+
+private:
+    struct Scope {
+        std::string encoded;  // InstrumentationScope message
+    };
+
+    struct QueuedRecord {
+        const Scope* scope;  // Owned by scopes_, which lives as long as the sink
+        std::string encoded;  // LogRecord message
+    };
+
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    static std::string encode(LogLevel level, std::string_view message,
+                              std::chrono::system_clock::time_point timestamp, const TraceContext& trace,
+                              const FormattedRecord* record);
+    // Queues an encoded record, under mutex_; false if the queue is full
+    bool push(std::string_view logger_name, std::string encoded);
+    bool wake_needed(size_t before) const;  // Under mutex_, after pushing
+    std::chrono::steady_clock::time_point pump(HttpTransport& transport) override;
+    void build_body();  // From sending_, into body_
+    void on_sent(const HttpResponse& response, int attempts, size_t count);
+
+    OtlpOptions options_;
+    std::string url_;
+    std::vector<std::string> http_headers_;
+    std::string resource_;  // Resource message, encoded once
+
+    mutable std::mutex mutex_;
+    std::condition_variable flushed_cv_;  // Signalled when an export completes
+    std::deque<QueuedRecord> queue_;
+    std::vector<std::unique_ptr<Scope>> scopes_;
+    std::unordered_map<std::string, Scope*, StringHash, std::equal_to<>> scope_index_;
+    size_t in_flight_ = 0;  // Records taken off queue_ but not exported yet
+    size_t flush_waiters_ = 0;
+    bool running_ = true;
+    std::chrono::steady_clock::time_point last_export_;
+
+    uint64_t records_exported_ = 0;
+    uint64_t records_failed_ = 0;
+    uint64_t records_dropped_ = 0;
+    uint64_t exports_ = 0;
+    uint64_t retries_ = 0;
+
+    // I/O thread only
+    std::vector<QueuedRecord> sending_;
+    std::string body_;
+};
+
+using OtlpLogSinkPtr = std::shared_ptr<OtlpLogSink>;
+
+}
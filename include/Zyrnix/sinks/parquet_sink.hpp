@@ -0,0 +1,127 @@
+#pragma once
+#include "../log_sink.hpp"
+#include "../parquet.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Zyrnix {
+
+struct ParquetOptions {
+    // Columns for record fields, and whether to keep trace ids and the
+    // undeclared fields (as a JSON column)
+    parquet::Schema schema;
+
+    parquet::Codec codec = parquet::Codec::Snappy;
+
+    // A row group is written once this many rows are buffered, or when
+    // the oldest buffered row is row_group_interval old
+    size_t row_group_rows = 65536;
+    std::chrono::milliseconds row_group_interval{std::chrono::seconds(60)};
+
+    // Rows per data page within a column chunk
+    size_t page_rows = 8192;
+
+    // A file is finished and a new one started past either limit; 0 for none
+    uint64_t max_file_rows = 1000000;
+    std::chrono::milliseconds max_file_age{std::chrono::hours(1)};
+
+    // Full row groups waiting for the writer thread; logging blocks past this
+    size_t max_pending = 4;
+};
+
+/**
+ * @brief Writes records as columnar Parquet files, for analytics (v1.2.0)
+ *
+ * Records are gathered column by column in a parquet::RowBatch: the
+ * timestamp, level, logger, thread, message, trace and span id, a typed
+ * column per field in options.schema, and the other fields as JSON. A
+ * full batch goes to a background thread that encodes it as one row
+ * group (dictionary pages for level, logger and other repeated strings,
+ * SNAPPY pages) and appends it to <base_name>.parquet.inprogress, so the
+ * logging thread only appends values. When the file reaches
+ * max_file_rows or max_file_age the thread writes the footer and renames
+ * it to <base_name>-<UTC start time>-<n>.parquet, which is the point it
+ * becomes readable; an in-progress file left by a crash is not, and is
+ * kept as <name>.inprogress.<n> when the next sink starts.
+ *
+ * flush() waits for the full batches to be written; rows still being
+ * gathered are written by row_group_interval, rotate() or destruction,
+ * which all finish the file.
+ */
+class ParquetSink : public LogSink {
+public:
+    explicit ParquetSink(const std::string& base_name, const ParquetOptions& options = ParquetOptions{});
+    ~ParquetSink() override;
+
+    ParquetSink(const ParquetSink&) = delete;
+    ParquetSink& operator=(const ParquetSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
+
+    /**
+     * @brief Write the buffered rows and finish the file; blocks until done
+     */
+    void rotate();
+
+    uint64_t files_written() const { return files_written_.load(std::memory_order_relaxed); }
+    uint64_t rows_written() const { return rows_written_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Row groups or files that could not be written
+     */
+    uint64_t write_errors() const { return write_errors_.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending {
+        std::unique_ptr<parquet::RowBatch> batch;  // nullptr for a rotation only
+        bool finish;                               // Finish the file after it
+    };
+
+    void begin_row();                             // Under mutex_
+    void add_row(const FormattedRecord& record);  // Under mutex_
+    void cut(bool finish);                        // Under mutex_
+    void wait_for_space(std::unique_lock<std::mutex>& lock);
+    void run_writer();
+    void write_batch(const parquet::RowBatch& batch);  // Writer thread
+    void finish_file();                                // Writer thread
+    std::string finished_name() const;
+
+    std::string base_name_;
+    std::string path_;  // The in-progress file
+    ParquetOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable writer_cv_;
+    std::condition_variable done_cv_;
+    std::unique_ptr<parquet::RowBatch> batch_;
+    std::chrono::steady_clock::time_point batch_started_;
+    std::deque<Pending> queue_;
+    std::vector<std::unique_ptr<parquet::RowBatch>> spare_;  // Written batches, for reuse
+    bool busy_ = false;
+    bool stopping_ = false;
+
+    // Writer thread only
+    parquet::FileWriter writer_;
+    std::chrono::system_clock::time_point file_started_;
+    std::chrono::steady_clock::time_point file_deadline_;
+
+    std::atomic<uint64_t> files_written_{0};
+    std::atomic<uint64_t> rows_written_{0};
+    std::atomic<uint64_t> write_errors_{0};
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include "../binary_log.hpp"
+#include "../log_sink.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+struct RecentLogOptions {
+    size_t max_bytes = 8 * 1024 * 1024;  // Sealed blocks kept; the oldest go first
+    size_t block_bytes = 64 * 1024;      // A block is sealed at this size
+};
+
+/**
+ * @brief What to pick out of a RecentLogSink; every condition must hold (v1.2.0)
+ */
+struct RecentLogQuery {
+    LogLevel min_level = LogLevel::Trace;
+    std::string logger;   // Exact name, empty for any
+    std::chrono::system_clock::time_point since = std::chrono::system_clock::time_point::min();
+    std::chrono::system_clock::time_point until = std::chrono::system_clock::time_point::max();
+    std::vector<std::pair<std::string, std::string>> fields;  // Key and the text of its value
+    std::string contains;  // Substring of the message, empty for any
+    size_t limit = 1000;   // The newest this many matches
+
+    /**
+     * @brief Parse a URL query string such as
+     *        level=warn&logger=db&since_ms=1700000000000&field.user=42&contains=timeout&limit=100
+     *
+     * since_ms and until_ms are Unix milliseconds. Unknown keys are an
+     * error, so a typo does not silently match everything.
+     *
+     * @return false with error set if the string does not parse
+     */
+    static bool parse(std::string_view query_string, RecentLogQuery& query, std::string& error);
+};
+
+/**
+ * @brief A record a query returned, owning its strings
+ */
+struct RecentLogRecord {
+    std::chrono::system_clock::time_point timestamp;
+    LogLevel level;
+    uint64_t thread_id;
+    std::string logger_name;
+    std::string message;
+    std::string file;  // Empty without a call site
+    uint32_t line = 0;
+    std::vector<std::pair<std::string, FieldValue>> fields;
+};
+
+struct RecentLogResult {
+    std::vector<RecentLogRecord> records;  // Oldest first
+    size_t blocks_scanned = 0;
+    size_t blocks_skipped = 0;  // Ruled out by their index without decoding
+    bool truncated = false;     // Stopped at limit: older records may match too
+
+    std::string to_json() const;
+};
+
+/**
+ * @brief The last few MB of records, kept in memory to query (v1.2.0)
+ *
+ * For debug endpoints: add it to a logger and fetch recent records
+ * matching a filter from the running process. Records are kept
+ * unformatted in the binary log format (see binlog), with their fields,
+ * in blocks of about block_bytes. Each sealed block carries a small
+ * index, its time range and a bitmap of the levels in it, and is shared
+ * immutably: a query takes the list of blocks under a lock held for a
+ * few pointer copies, then skips the blocks its index rules out and
+ * decodes the rest without holding anything the writers need. A query
+ * also copies the block being filled, without sealing it, so it sees
+ * every record logged before it.
+ *
+ *     auto recent = std::make_shared<Zyrnix::RecentLogSink>();
+ *     logger->add_sink(recent);
+ *     // In the admin server, next to handle_health_check_request():
+ *     body = Zyrnix::handle_recent_logs_request(*recent, request.query_string);
+ *
+ * The sink's own formatter is not used.
+ */
+class RecentLogSink : public LogSink {
+public:
+    explicit RecentLogSink(const RecentLogOptions& options = RecentLogOptions{});
+
+    RecentLogSink(const RecentLogSink&) = delete;
+    RecentLogSink& operator=(const RecentLogSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+
+    RecentLogResult query(const RecentLogQuery& query);
+
+    /**
+     * @brief Bytes held in sealed blocks
+     */
+    size_t size_bytes() const;
+
+    /**
+     * @brief Records pushed out of the ring since the sink was made
+     */
+    uint64_t evicted() const;
+
+private:
+    struct Block {
+        std::string bytes;  // Header and payload, as BlockWriter::finish() writes them
+        binlog::BlockRef ref;
+        int64_t min_ns;
+        int64_t max_ns;
+        uint8_t levels;  // Bit 1 << level for each level in the block
+    };
+
+    void note(std::chrono::system_clock::time_point timestamp, LogLevel level);
+    void seal();  // Under writer_mtx_
+
+    RecentLogOptions options_;
+
+    std::mutex writer_mtx_;
+    binlog::BlockWriter open_;
+    int64_t open_min_ns_ = INT64_MAX;
+    int64_t open_max_ns_ = INT64_MIN;
+    uint8_t open_levels_ = 0;
+
+    mutable std::mutex ring_mtx_;  // Held only to add, drop or copy block pointers
+    std::deque<std::shared_ptr<const Block>> blocks_;
+    size_t ring_bytes_ = 0;
+    uint64_t evicted_ = 0;
+};
+
+/**
+ * @brief Run the query in query_string and return the result as JSON (v1.2.0)
+ *
+ * {"records":[...],"blocks_scanned":n,"blocks_skipped":n,"truncated":false},
+ * or {"error":"..."} when the query string does not parse.
+ */
+std::string handle_recent_logs_request(RecentLogSink& sink, std::string_view query_string);
+
+}
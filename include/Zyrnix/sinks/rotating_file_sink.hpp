@@ -1,24 +1,110 @@
 #pragma once
 #include "file_sink.hpp"
+#include "../log_sidecar.hpp"
 #include <string>
 #include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 namespace Zyrnix {
 
+enum class RotationInterval {
+    None,
+    Hourly,  // At the top of each local hour
+    Daily    // At local midnight
+};
+
+struct RotationOptions {
+    // Rotate once the file reaches this many bytes; 0 for no size limit
+    size_t max_size = 0;
+
+    // Also rotate when the local hour or day changes
+    RotationInterval interval = RotationInterval::None;
+
+    // Rotated files kept, as .0.log to .<max_files>.log
+    size_t max_files = 5;
+
+    // Rotated files are also deleted, oldest first, while together they
+    // exceed this many bytes; the newest is always kept. 0 for no limit
+    uint64_t max_total_bytes = 0;
+
+    // Write <rotated file>.meta, an index of each finished file
+    SidecarOptions sidecar;
+};
+
+/**
+ * @brief Starts a new file by size, by the clock or both (v1.2.0)
+ *
+ * The current file is <base_name>.log and rotated ones are .0.log (the
+ * newest) to .<max_files>.log. For interval rotation the next boundary
+ * is worked out once per rotation, so each line costs one integer compare
+ * against the coarse realtime clock; an empty file is not rotated. A rotation parks the full file under a
+ * unique name and reopens right away; a background thread then moves the
+ * older files up one and the parked one into .0.log, so logging never
+ * waits for that cascade. Until it has run, the newest rotated file is
+ * the .rotating-*.log one; a sink opening the file shifts in any such
+ * file a previous process left behind. Durable records (policy.sync_on, sync()) work
+ * as in FileSink; once they are in use, a rotation syncs the file it
+ * closes.
+ *
+ * With options.sidecar enabled, the sink indexes each file as it writes
+ * it (see SidecarOptions) and writes the index beside the file when it
+ * is parked; the renamer moves it along with the file. On destruction
+ * the open file's index goes to <base_name>.log.meta, and a sink that
+ * reopens the file carries on from it.
+ */
 class RotatingFileSink : public LogSink {
 public:
-    RotatingFileSink(const std::string& base_name, size_t max_size, size_t max_files);
+    RotatingFileSink(const std::string& base_name, size_t max_size, size_t max_files,
+                     const FlushPolicy& policy = FlushPolicy{});
+    RotatingFileSink(const std::string& base_name, const RotationOptions& options,
+                     const FlushPolicy& policy = FlushPolicy{});
+    ~RotatingFileSink() override;
     void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+    void flush() override;
+
+    /**
+     * @brief Get everything logged so far onto disk (v1.2.0)
+     *
+     * As FileSink::sync().
+     */
+    std::future<void> sync();
 
 private:
     std::string base_name;
-    size_t max_size;
-    size_t max_files;
-    size_t current_size = 0;
-    std::ofstream file;
+    RotationOptions options;
+    size_t current_size = 0;  // Including lines still in buffer
+    int64_t next_rollover_ns = INT64_MAX;  // Guarded by mtx
     std::mutex mtx;
+    LineBuffer buffer;
+    LogFile file;
     void rotate();
     void open_file();
+    // record is nullptr from the legacy log()
+    void write_line(const std::string& line, LogLevel level, const FormattedRecord* record);
+    void append_line(const std::string& line, LogLevel level, const FormattedRecord* record);  // Under mtx
+    bool durable(LogLevel level) const;
+    void start_commit();
+    std::unique_ptr<GroupCommit> commit;  // Guarded by mtx once set
+    std::unique_ptr<sidecar::Builder> index;  // With options.sidecar; guarded by mtx
+
+    // The rename cascade, off the logging threads
+    void recover_parked();
+    void shift_in(const std::string& parked);
+    void move_file(const std::string& from, const std::string& to);
+    void enforce_total_bytes();
+    void schedule_rollover();
+    void run_renamer();
+    uint64_t rotations = 0;  // Guarded by mtx
+    std::mutex rename_mtx;
+    std::condition_variable rename_cv;
+    std::deque<std::string> pending;  // Parked files, oldest first
+    bool stopping = false;
+    std::thread renamer;
 };
 
 }
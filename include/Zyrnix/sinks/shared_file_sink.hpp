@@ -0,0 +1,102 @@
+#pragma once
+#include "../log_sink.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+struct SharedFileOptions {
+    // Rotate once the file reaches this many bytes; 0 for no size limit
+    size_t max_size = 0;
+
+    // Rotated files kept, as .0.log to .<max_files>.log
+    size_t max_files = 5;
+
+    // Whether this process may rotate the file. With false it only
+    // follows rotations done by the others, e.g. in all but one worker
+    bool rotator = true;
+
+    // Largest write() a batch is grouped into; records are never split,
+    // so a longer one goes out alone. 4096 (PIPE_BUF on Linux) keeps every
+    // write in the size POSIX and NFS clients append atomically
+    size_t max_write = 4096;
+};
+
+/**
+ * @brief One log file appended to by many processes at once (v1.2.0)
+ *
+ * For prefork servers whose workers all log to <base_name>.log without a
+ * log daemon. The file is opened with O_APPEND and nothing is buffered:
+ * each record is one writev() of the line and its newline, and a batch
+ * is grouped into writes of whole records up to max_write bytes, so the
+ * kernel appends every record in one piece and lines from different
+ * processes never interleave mid-record. Open it before or after fork():
+ * each process follows the file on its own.
+ *
+ * Rotation works as in RotatingFileSink (.0.log is the newest) and is
+ * coordinated through <base_name>.lock: the process that finds the file
+ * full takes an fcntl() lock on it, checks that no other process has
+ * rotated meanwhile, shifts the files and reopens. The others notice the
+ * new file within a second, or sooner when they write a lot, by
+ * comparing the inode behind their descriptor with the path's, and
+ * reopen; records they write until then land, whole, in .0.log.
+ * Rotations run on the logging thread. POSIX only.
+ */
+class SharedFileSink : public LogSink {
+public:
+    explicit SharedFileSink(const std::string& base_name, const SharedFileOptions& options = SharedFileOptions{});
+    ~SharedFileSink() override;
+
+    SharedFileSink(const SharedFileSink&) = delete;
+    SharedFileSink& operator=(const SharedFileSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+
+    bool is_open() const;
+
+    /**
+     * @brief Records the kernel did not take (disk full, I/O errors)
+     */
+    uint64_t write_errors() const { return write_errors_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Rotations this process did, and ones it followed
+     */
+    uint64_t rotations() const { return rotations_.load(std::memory_order_relaxed); }
+    uint64_t reopens() const { return reopens_.load(std::memory_order_relaxed); }
+
+private:
+    struct Piece {
+        const char* data;
+        size_t size;
+    };
+
+    void write_one(std::string_view line);
+    void write_pieces(const Piece* pieces, size_t count, size_t records);
+    void after_write(size_t bytes);
+    void check_file();
+    bool reopen();  // Under the exclusive lock
+    void rotate();  // Under the exclusive lock
+
+    std::string base_name_;
+    std::string path_;
+    SharedFileOptions options_;
+    std::shared_mutex mtx_;  // Shared to write, exclusive to swap fd_
+    int fd_ = -1;
+    int lock_fd_ = -1;
+    std::atomic<uint64_t> since_check_{0};   // Bytes written since check_file()
+    std::atomic<int64_t> next_check_ns_{0};  // realtime_coarse_ns() deadline
+    uint64_t check_bytes_;                   // Check after this many bytes
+    std::atomic<uint64_t> write_errors_{0};
+    std::atomic<uint64_t> rotations_{0};
+    std::atomic<uint64_t> reopens_{0};
+};
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "../log_sink.hpp"
+#include "../shm_ring.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+struct ShmRingOptions {
+    size_t capacity = 4 * 1024 * 1024;  // Data bytes, rounded up to a power of two
+    // Records logged in one batch share an entry up to this many bytes
+    size_t max_entry_bytes = 64 * 1024;
+};
+
+/**
+ * @brief Hands records to a collector on the same host through a
+ *        shared-memory ring (v1.2.0)
+ *
+ * Creates the POSIX shared memory object name (replacing a stale one
+ * left by a crash) and writes each record, or each batch, as a binlog
+ * block into a lock-free ring that any number of threads write at once
+ * (layout in shm_ring.hpp). A collector maps the same object with
+ * shmring::Reader and reads the records in place, sleeping on a futex
+ * in the ring's header while it is empty: nothing is written to a file
+ * or a socket, and a sleeping reader costs writers one system call per
+ * wakeup, none otherwise.
+ *
+ * Writers never wait for the reader: records that find the ring full are
+ * dropped and counted in its header and in get_stats(). Closing the sink
+ * marks the ring closed and unlinks the name; a reader that has it
+ * mapped drains what is left. Use one name per process, e.g. with its
+ * pid. Linux only, and built when ENABLE_SHM_RING is on.
+ */
+class ShmRingSink : public LogSink {
+public:
+    /**
+     * @param name A shm_open() name: a leading '/' and no other ("/myapp.1234")
+     */
+    explicit ShmRingSink(const std::string& name, const ShmRingOptions& options = ShmRingOptions{});
+    ~ShmRingSink() override;
+
+    ShmRingSink(const ShmRingSink&) = delete;
+    ShmRingSink& operator=(const ShmRingSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void log_batch(std::span<const FormattedRecord> records) override;
+
+    /**
+     * @brief Nothing to do: a record is readable once log_record() returns
+     */
+    void flush() override {}
+
+    bool is_open() const { return header_ != nullptr; }
+
+    struct Stats {
+        uint64_t records_written;
+        uint64_t records_dropped;
+    };
+
+    Stats get_stats() const;
+
+private:
+    // Copy one binlog block into the ring; false if it did not fit
+    bool write(std::string_view block);
+
+    std::string name_;
+    size_t max_entry_bytes_;
+    shmring::Header* header_ = nullptr;
+    char* data_ = nullptr;
+    size_t mapped_size_ = 0;
+    uint64_t capacity_ = 0;
+
+    std::atomic<uint64_t> records_written_{0};
+    std::atomic<uint64_t> records_dropped_{0};
+};
+
+}
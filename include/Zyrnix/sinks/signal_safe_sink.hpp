@@ -2,9 +2,12 @@
 
 #include "../log_sink.hpp"
 #include "../log_record.hpp"
+#include "../buffer_memory.hpp"
+#include "../memory_budget.hpp"
 #include <atomic>
-#include <array>
+#include <cstdint>
 #include <cstring>
+#include <memory>
 
 namespace Zyrnix {
 
@@ -21,6 +24,19 @@ namespace Zyrnix {
  * - Fixed-size buffer to avoid malloc in signal handlers
  * - Suitable for SIGSEGV, SIGABRT, etc. handlers
  * - v1.1.2: Improved reentrancy safety and rapid signal handling
+ * - v1.2.0: The ring is mapped and pre-faulted at construction with the
+ *   requested size, so a 4 KB crash sink costs 4 KB and writing never
+ *   page-faults inside a handler. Each line reserves its whole entry with
+ *   one CAS, so lines from concurrent writers never interleave. With
+ *   lanes > 1 each thread writes to one of several rings, picked by its
+ *   thread id, and threads on different lanes do not contend.
+ *
+ * Entries start 16-byte aligned and never wrap: a commit word, the line's
+ * size and kind, then the line. A writer stores the commit word last;
+ * flush() writes out committed entries in order and stops at the first
+ * one still being written, which holds back those behind it until it
+ * commits. Lanes are written out one after another, so lines from
+ * different lanes are grouped by lane rather than in time order.
  * 
  * Limitations:
  * - Fixed buffer size (messages may be dropped if buffer is full)
@@ -45,9 +61,12 @@ public:
     /**
      * @brief Construct signal-safe sink
      * @param path Path to log file (should be opened at construction)
-     * @param buffer_size Size of ring buffer (default 64KB)
+     * @param buffer_size Size of ring buffer (default 64KB), split between
+     *        the lanes; each lane is rounded up to a power of two of at
+     *        least 4 KB
+     * @param lanes Number of rings threads are spread over (v1.2.0)
      */
-    explicit SignalSafeSink(const std::string& path, size_t buffer_size = 65536);
+    explicit SignalSafeSink(const std::string& path, size_t buffer_size = 65536, size_t lanes = 1);
     
     /**
      * @brief Destructor - closes file descriptor
@@ -66,18 +85,30 @@ public:
      * @param message Log message
      */
     void log(const std::string& name, LogLevel level, const std::string& message) override;
+
+    /**
+     * @brief Log a record without copying its message (async-signal-safe)
+     */
+    void log_record(const FormattedRecord& record) override;
     
     /**
      * @brief Flush buffer to disk (async-signal-safe)
      * 
      * v1.1.2: Now fully reentrant - safe to call from nested signal handlers
      */
-    void flush();
+    void flush() override;
     
     /**
      * @brief Check if sink is ready
      */
     bool is_ready() const { return fd_ >= 0; }
+
+    /**
+     * @brief Bytes of ring per lane (v1.2.0)
+     */
+    size_t lane_capacity() const { return static_cast<size_t>(capacity_); }
+
+    size_t lane_count() const { return lane_count_; }
     
     /**
      * @brief Get number of dropped messages due to buffer overflow
@@ -100,22 +131,26 @@ public:
     void exit_signal_handler() { in_signal_handler_.store(false, std::memory_order_release); }
 
 private:
-    int fd_; 
-    
+    struct alignas(64) Lane {
+        char* data = nullptr;
+        std::atomic<uint64_t> head{0};  // Bytes reserved by writers, ever
+        alignas(64) std::atomic<uint64_t> tail{0};  // Bytes written out, ever
+    };
 
-    static constexpr size_t MAX_BUFFER_SIZE = 1048576; 
-    std::array<char, MAX_BUFFER_SIZE> buffer_;
-    std::atomic<size_t> write_pos_{0};
-    std::atomic<size_t> read_pos_{0};
-    size_t capacity_;
-    
+    int fd_;
+    BufferRegion buffer_;  // Every lane, always prefaulted
+    BudgetAccount budget_{"SignalSafeSink"};  // Charged the whole ring up front (v1.2.0)
+    std::unique_ptr<Lane[]> lanes_;
+    size_t lane_count_ = 0;
+    uint64_t capacity_ = 0;  // Per lane, a power of two
 
     std::atomic<size_t> dropped_count_{0};
     std::atomic<bool> in_signal_handler_{false};
-    std::atomic<bool> flush_in_progress_{false};
-    
 
-    void write_to_buffer(const char* data, size_t len);
+    Lane& local_lane();
+    void write_line(LogLevel level, const char* message, size_t len);
+    bool reserve(Lane& lane, uint64_t size, uint64_t& pos);
+    void flush_lane(Lane& lane);
     void flush_buffer();
     
     static void safe_write(int fd, const char* data, size_t len);
@@ -0,0 +1,130 @@
+#pragma once
+#include "http_transport.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+struct SpillOptions {
+    // Where spilled batches go; empty keeps spilling off. Every sink
+    // needs a directory of its own
+    std::string directory;
+
+    // A new segment file is started past this size
+    size_t segment_bytes = 8 * 1024 * 1024;
+
+    // Oldest segments are deleted past this, their events counted as dropped
+    size_t max_bytes = 256 * 1024 * 1024;
+
+    // Replay pace once the endpoint answers again; 0 replays back to back
+    size_t replay_bytes_per_second = 1024 * 1024;
+
+    // How often the oldest spilled batch is tried while the endpoint is down
+    std::chrono::milliseconds retry_interval{5000};
+};
+
+/**
+ * @brief Request bodies a cloud sink could not send, kept on disk (v1.2.0)
+ *
+ * Batches that failed after their retries, and batches cut while the
+ * endpoint is down or the sink's queue is filling up, are appended to
+ * segment files <directory>/<generation>.spill instead of being dropped.
+ * A record is a 16-byte header (magic "ZSP1", body size, event count and
+ * the CRC-32C of the body, each a little-endian u32) followed by the body,
+ * padded to 8 bytes, so a segment can be read or mapped as it is. The
+ * read position lives in <directory>/cursor, so a restarted process
+ * replays what the last one left, and a record torn by a crash ends its
+ * segment without affecting the others.
+ *
+ * replay() runs on the HttpTransport I/O thread from the sink's pump():
+ * one record in flight at a time, every retry_interval while the
+ * endpoint fails and at replay_bytes_per_second once it answers. Records
+ * are written without fsync: they survive the process, not the machine.
+ */
+class SpillQueue {
+public:
+    struct Stats {
+        uint64_t spilled;   // Events written
+        uint64_t replayed;  // Events replayed with a 2xx response
+        uint64_t dropped;   // Events lost to max_bytes, write errors or a rejecting endpoint
+        size_t bytes;       // On disk, waiting to be replayed
+    };
+
+    /**
+     * @brief Called on the I/O thread when a replayed record completes
+     */
+    using Completion = std::function<void(const HttpResponse& response, uint32_t events)>;
+
+    explicit SpillQueue(const SpillOptions& options);
+    ~SpillQueue();  // Waits for a replay in flight
+
+    SpillQueue(const SpillQueue&) = delete;
+    SpillQueue& operator=(const SpillQueue&) = delete;
+
+    /**
+     * @brief Append a request body; false if it could not be written
+     */
+    bool push(std::string_view body, uint32_t events);
+
+    /**
+     * @brief The endpoint failed a live batch: spill new batches until a replay succeeds
+     */
+    void mark_down();
+
+    /**
+     * @brief Whether new batches should be spilled to keep their order behind the backlog
+     */
+    bool diverting() const;
+
+    /**
+     * @brief Submit the oldest record as base with its body, when one is due;
+     *        returns when to be called again
+     */
+    std::chrono::steady_clock::time_point replay(HttpTransport& transport, const HttpRequest& base,
+                                                 Completion done);
+
+    Stats get_stats() const;
+
+private:
+    struct Segment {
+        uint64_t generation;
+        size_t bytes;     // Valid bytes, from the start of the file
+        uint64_t events;  // Not yet replayed
+    };
+
+    std::string segment_path(uint64_t generation) const;
+    void load();
+    void scan(Segment& segment, size_t from);
+    bool read_front(std::string& body, uint32_t& events, size_t& size);  // Under mutex_
+    void pop_front(size_t size, uint32_t events);                       // Under mutex_
+    void drop_segment(size_t index);                                    // Under mutex_
+    void write_cursor();                                                // Under mutex_
+    bool has_records() const;                                           // Under mutex_
+    void finish_replay(const HttpResponse& response, size_t size, uint32_t events, const Completion& done);
+
+    SpillOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable replayed_cv_;
+    std::deque<Segment> segments_;  // The back is being written
+    size_t read_offset_ = 0;        // In the front segment
+    size_t total_bytes_ = 0;
+    uint64_t next_generation_ = 1;
+    std::FILE* writer_ = nullptr;
+    std::FILE* reader_ = nullptr;  // Open on the front segment
+    uint64_t reader_generation_ = 0;
+    bool down_ = false;
+    bool replaying_ = false;
+    std::chrono::steady_clock::time_point next_replay_{};
+    uint64_t spilled_ = 0;
+    uint64_t replayed_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+}
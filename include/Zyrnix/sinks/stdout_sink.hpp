@@ -1,15 +1,79 @@
 #pragma once
 #include "../log_sink.hpp"
 #include "../formatter.hpp"
+#include "flush_policy.hpp"
+#include <mutex>
+#include <string_view>
 
 namespace Zyrnix {
 
+/**
+ * @brief Which descriptor a StdoutSink writes to (v1.2.0)
+ */
+enum class ConsoleStream { Stdout, Stderr };
+
+/**
+ * @brief Whether a StdoutSink colors warnings and errors (v1.2.0)
+ *
+ * Auto colors only a terminal, and not when the NO_COLOR environment
+ * variable is set or TERM is "dumb".
+ */
+enum class ColorMode { Auto, Always, Never };
+
+/**
+ * @brief Writes lines to standard output or standard error through a LineBuffer
+ *
+ * The buffer goes straight to file descriptor 1 (or 2) in one write(),
+ * bypassing std::cout, its locking and its flush per line. Warnings and
+ * errors are wrapped in color codes, appended to the buffer around the
+ * line without building a colored copy, when the descriptor is a
+ * terminal; piped into a container's log collector, lines go out plain.
+ * Anything the program prints through std::cout or stdio meanwhile is
+ * buffered separately and may interleave by write-out, not by line.
+ *
+ * The default policy writes out every 50 ms, so a terminal keeps up
+ * with the program without a write per line.
+ */
 class StdoutSink : public LogSink {
 public:
-    StdoutSink();
+    explicit StdoutSink(const FlushPolicy& policy = default_policy());
+
+    /**
+     * @brief (v1.2.0)
+     */
+    explicit StdoutSink(ConsoleStream stream, ColorMode color = ColorMode::Auto,
+                        const FlushPolicy& policy = default_policy());
+    ~StdoutSink() override;
     void log(const std::string& name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+    void flush() override;
+
+    /**
+     * @brief Whether lines get color codes, as decided at construction (v1.2.0)
+     */
+    bool colored() const { return colored_; }
+
+    static FlushPolicy default_policy() {
+        FlushPolicy policy;
+        policy.buffer_size = 16 * 1024;
+        policy.interval = std::chrono::milliseconds(50);
+        return policy;
+    }
 
 private:
+    // The descriptor as LineBuffer's output: write() until everything is out
+    struct Fd {
+        int fd;
+        void write(const char* data, std::streamsize size);
+        void flush() {}
+    };
+
+    void write_line(LogLevel level, std::string_view line);
+
+    Fd out_;
+    bool colored_;
+    std::mutex mtx;
+    LineBuffer buffer;
 };
 
 }
@@ -0,0 +1,77 @@
+#pragma once
+#include "../field.hpp"
+#include "../log_sink.hpp"
+#include "../log_level.hpp"
+#include "../structured_encoder.hpp"
+#include "../trace_context.hpp"
+#include "flush_policy.hpp"
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief Writes records with their context and fields to a file through a
+ *        StructuredEncoder (v1.2.0)
+ *
+ * Each record holds the timestamp, level, logger name and message, the
+ * trace ids, then the sink's global context (set_context), the logging
+ * thread's LogContext and the record's fields. The encoder picks the
+ * bytes: JSON lines (StructuredJsonSink), ECS or GELF JSON, logfmt,
+ * MessagePack, CBOR or length-delimited protobuf. The global context is
+ * encoded once when it changes, and every record is built in one buffer
+ * reused from line to line.
+ */
+class StructuredSink : public LogSink {
+public:
+    StructuredSink(const std::string& filename, std::unique_ptr<StructuredEncoder> encoder,
+                   const FlushPolicy& policy = FlushPolicy{});
+    StructuredSink(const std::string& filename, StructuredFormat format, const FlushPolicy& policy = FlushPolicy{});
+    ~StructuredSink();
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+
+    /**
+     * @brief Write a record with its typed fields, at its own timestamp
+     */
+    void log_record(const FormattedRecord& record) override;
+    void flush() override;
+
+    void set_context(const std::string& key, const std::string& value);
+    void clear_context();
+
+    void log_with_fields(const std::string& logger_name, LogLevel level, const std::string& message,
+                         const std::map<std::string, std::string>& fields);
+
+    /**
+     * @brief Write a record with typed fields: numbers and booleans native
+     */
+    void log_fields(std::string_view logger_name, LogLevel level, std::string_view message,
+                    std::span<const Field> fields);
+
+private:
+    // Encodes one record into line and buffers it, under mtx: the header,
+    // the global and thread context (less the keys in record_fields), then
+    // field_count members written by emit_fields
+    template <class EmitFields>
+    void write(const StructuredHeader& header, const FieldList* record_fields, size_t field_count,
+               EmitFields&& emit_fields);
+    void rebuild_global();
+
+    std::string filename;
+    std::unique_ptr<StructuredEncoder> encoder;
+    std::map<std::string, std::string> global_context;
+    std::string global_encoded;  // global_context as members, rebuilt when it changes
+    std::ofstream file;
+    std::mutex mtx;
+    LineBuffer buffer;
+    std::string line;  // Reused for every record, under mtx
+};
+
+}
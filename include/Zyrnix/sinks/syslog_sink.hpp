@@ -3,6 +3,7 @@
 #include "../log_level.hpp"
 #include <syslog.h>
 #include <string>
+#include <string_view>
 #include <mutex>
 
 namespace Zyrnix {
@@ -12,8 +13,11 @@ public:
     explicit SyslogSink(const std::string& ident = "", int option = LOG_PID, int facility = LOG_USER);
     ~SyslogSink();
     void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
 
 private:
+    void write(std::string_view logger_name, LogLevel level, std::string_view message);
+
     std::string ident;
     int option;
     int facility;
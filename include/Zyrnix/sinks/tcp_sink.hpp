@@ -0,0 +1,136 @@
+#pragma once
+#include "../log_sink.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace Zyrnix {
+
+/**
+ * @brief How records are delimited on the stream (RFC 6587) (v1.2.0)
+ */
+enum class TcpFraming {
+    NewLine,       // Non-transparent framing: each record ends with '\n'
+    OctetCounting  // "<length> <record>", which lets records contain newlines
+};
+
+/**
+ * @brief What log() does when max_buffer_bytes are waiting (v1.2.0)
+ */
+enum class TcpDropPolicy {
+    DropNewest,  // Discard the record being logged
+    DropOldest,  // Discard the oldest records not yet being sent
+    Block        // Wait for room, holding up the logging thread
+};
+
+struct TcpOptions {
+    TcpFraming framing = TcpFraming::NewLine;
+
+    // Formatted records waiting to be sent, across disconnections
+    size_t max_buffer_bytes = 8 * 1024 * 1024;
+    TcpDropPolicy drop_policy = TcpDropPolicy::DropNewest;
+
+    // Also bounds the TLS handshake, and how long the destructor keeps
+    // sending what is left
+    std::chrono::milliseconds connect_timeout{5000};
+
+    // Reconnect delay after a failure, doubling up to reconnect_max
+    std::chrono::milliseconds reconnect_min{100};
+    std::chrono::milliseconds reconnect_max{30000};
+
+    // TLS needs a build with OpenSSL; without it the sink sends nothing
+    bool tls = false;
+    std::string tls_server_name;  // For SNI and certificate checks; defaults to the host
+    std::string ca_cert_path;     // Defaults to the system's trust store
+    bool insecure_skip_verify = false;
+};
+
+/**
+ * @brief Streams records to a TCP or TLS collector (v1.2.0)
+ *
+ * log() formats and frames the record into a queue and returns; a thread
+ * per sink owns the connection. It connects without blocking, within
+ * connect_timeout, and reconnects with exponential backoff when the
+ * connection fails or the peer closes it. Whatever is queued goes out in
+ * one gathered sendmsg() of up to 512 records (one SSL_write() of up to
+ * 64 KiB with TLS), so a busy sink costs a system call per batch, not per
+ * record. A record cut off by a broken connection is sent again whole on
+ * the next one, so framing is never torn.
+ *
+ * Memory is bounded by max_buffer_bytes, with drop_policy deciding what
+ * gives. Records logged while disconnected wait in the buffer. POSIX only.
+ */
+class TcpSink : public LogSink {
+public:
+    TcpSink(const std::string& host, unsigned short port, const TcpOptions& options = TcpOptions{});
+    ~TcpSink() override;
+
+    TcpSink(const TcpSink&) = delete;
+    TcpSink& operator=(const TcpSink&) = delete;
+
+    void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+
+    /**
+     * @brief Wait until everything logged so far is written to the socket,
+     *        or the sink is waiting to reconnect
+     */
+    void flush() override;
+
+    struct Stats {
+        uint64_t records_sent;
+        uint64_t records_dropped;
+        uint64_t bytes_sent;
+        uint64_t connects;  // Successful, including the first
+        size_t buffered_bytes;
+        bool connected;
+    };
+
+    Stats get_stats() const;
+
+private:
+    struct Connection;
+    enum class Progress { Sent, Blocked, Failed };
+
+    void enqueue(const std::string& line);
+    void run();
+    bool connect_once(Connection& connection);
+    Progress send_some(Connection& connection);
+    void consume(size_t bytes);
+    void disconnect(Connection& connection);
+    void wake();
+
+    const std::string host_;
+    const unsigned short port_;
+    const TcpOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable space_cv_;    // Signalled when bytes leave the buffer
+    std::condition_variable flushed_cv_;  // Signalled when the buffer empties or the connection fails
+    std::deque<std::string> pending_;     // Framed records, filled by log()
+    size_t buffered_bytes_ = 0;           // pending_ and sending_ together
+    bool closing_ = false;
+    bool backing_off_ = false;
+    uint64_t records_sent_ = 0;
+    uint64_t records_dropped_ = 0;
+    uint64_t bytes_sent_ = 0;
+    uint64_t connects_ = 0;
+    bool connected_ = false;
+
+    // I/O thread only
+    std::deque<std::string> sending_;  // Swapped out of pending_
+    size_t front_offset_ = 0;          // Bytes of sending_.front() already written
+    std::string tls_buffer_;           // Whole records from the front of sending_, for SSL_write
+    size_t tls_written_ = 0;
+
+    int wake_pipe_[2] = {-1, -1};
+    std::thread thread_;
+};
+
+}
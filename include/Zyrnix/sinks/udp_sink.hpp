@@ -1,26 +1,90 @@
 #pragma once
 #include "../log_sink.hpp"
 #include "../log_level.hpp"
+#include <chrono>
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <vector>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 
 namespace Zyrnix {
 
+/**
+ * @brief How UdpSink groups lines into datagrams (v1.2.0)
+ *
+ * The defaults send each line as its own datagram when it is logged.
+ * With batch_size above 1 or pack_lines, datagrams collect in a buffer and go out
+ * together in one sendmmsg() once batch_size are waiting, when a
+ * flush_on record is logged, on flush() and every flush_interval.
+ */
+struct UdpOptions {
+    // Datagrams sent per system call
+    size_t batch_size = 1;
+
+    // The background flusher sends what is waiting this often; 0 for never
+    std::chrono::milliseconds flush_interval{100};
+
+    // Pack consecutive lines into one datagram of up to max_datagram
+    // bytes; a batch then goes once batch_size datagrams are full
+    bool pack_lines = false;
+
+    // A 1500-byte MTU less the IPv6 and UDP headers, so packed datagrams
+    // are not fragmented. Longer lines still go whole, in a datagram of their own
+    size_t max_datagram = 1452;
+
+    // A record at or above this level goes out at once, with everything before it
+    std::optional<LogLevel> flush_on = LogLevel::Error;
+};
+
+/**
+ * @brief Sends "name: message" lines to a UDP collector
+ *
+ * The socket is connected to the collector once, so the kernel resolves
+ * the route when the sink is created rather than on every send.
+ */
 class UdpSink : public LogSink {
 public:
-    UdpSink(const std::string& host, unsigned short port);
+    UdpSink(const std::string& host, unsigned short port, const UdpOptions& options = UdpOptions{});
     ~UdpSink();
     void log(const std::string& logger_name, LogLevel level, const std::string& message) override;
+    void log_record(const FormattedRecord& record) override;
+
+    /**
+     * @brief Send the datagrams waiting in the buffer (v1.2.0)
+     */
+    void flush() override;
 
 private:
+    struct Datagram {
+        size_t offset;  // In buffer
+        size_t size;
+    };
+
+    bool batching() const { return options.batch_size > 1 || options.pack_lines; }
+    void send(std::string_view logger_name, std::string_view message);
+    void buffer_line(std::string_view logger_name, LogLevel level, std::string_view message);
+    void send_buffered();  // Under mtx
+
     int sockfd;
     struct ::sockaddr_storage dest;
     socklen_t dest_len;
     std::mutex mtx;
     bool initialized;
+    bool connected = false;
+
+    UdpOptions options;
+    std::string buffer;
+    std::vector<Datagram> datagrams;
+    std::vector<struct ::iovec> iovecs;
+#ifdef __linux__
+    std::vector<struct ::mmsghdr> messages;
+#endif
 };
 
 }
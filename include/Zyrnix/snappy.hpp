@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+/**
+ * @brief Snappy block compression, for Loki's protobuf push (v1.2.0)
+ *
+ * Writes the raw block format (not the framing format) that Loki and
+ * Prometheus remote write expect: the uncompressed length as a varint,
+ * then literals and back-references found with a hash of 4-byte
+ * sequences over 64 KiB blocks. Built in, so no libsnappy is needed.
+ */
+namespace snappy {
+
+/**
+ * @brief Append the compressed form of input to out
+ */
+void compress(std::string_view input, std::string& out);
+
+/**
+ * @brief Most bytes compress() can append for input_size bytes
+ */
+constexpr size_t max_compressed_length(size_t input_size) {
+    return 32 + input_size + input_size / 6;
+}
+
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Zyrnix {
+
+inline constexpr size_t XLOG_MAX_STACK_FRAMES = 64;
+
+/**
+ * @brief Frame text by return address, least recently used out first (v1.2.0)
+ *
+ * dladdr() and demangling cost microseconds a frame, and the stacks that
+ * log errors mostly run through the same code, so StackTrace looks each
+ * address up here first. Only the threads that symbolize take its mutex,
+ * never a thread capturing a stack.
+ */
+class SymbolCache {
+public:
+    explicit SymbolCache(size_t capacity = 4096);
+
+    SymbolCache(const SymbolCache&) = delete;
+    SymbolCache& operator=(const SymbolCache&) = delete;
+
+    /**
+     * @brief The process-wide cache StackTrace uses
+     */
+    static SymbolCache& instance();
+
+    /**
+     * @brief "function+0x1f (module)", or "(module+0x4a3f)" for an
+     *        address in a module whose symbols are not exported
+     */
+    std::string lookup(void* address);
+
+    /**
+     * @brief Entries kept; a smaller capacity evicts at once
+     */
+    void set_capacity(size_t capacity);
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t entries;
+    };
+
+    Stats get_stats() const;
+
+private:
+    using Entry = std::pair<void*, std::string>;
+
+    void trim();  // Under mutex_
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::list<Entry> entries_;  // Most recently used first
+    std::unordered_map<void*, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+/**
+ * @brief Return addresses of a logging call, symbolized later (v1.2.0)
+ *
+ * capture() only walks the stack and keeps the raw addresses: with
+ * backtrace(3), about a microsecond for 30 frames once the unwinder is
+ * loaded. The frames are turned into text on the first call to
+ * symbolize(), frames() or text(), which the async consumer makes before
+ * the record reaches the sinks, with every lookup going through
+ * SymbolCache. Leading frames inside Zyrnix are left out once their
+ * names are known.
+ *
+ * Names come from dladdr(), so functions in the executable need it
+ * linked with -rdynamic (CMake's ENABLE_EXPORTS); otherwise a frame reads
+ * "(app+0x4a3f)", which addr2line -e app resolves. On Windows frames are
+ * addresses only.
+ */
+class StackTrace {
+public:
+    /**
+     * @brief The calling thread's stack, at most max_frames deep
+     *
+     * nullptr where stacks cannot be walked.
+     */
+    static std::shared_ptr<StackTrace> capture(size_t max_frames);
+
+    std::span<void* const> addresses() const { return {addresses_, count_}; }
+
+    /**
+     * @brief Work out the frames' text, once; safe from several threads
+     */
+    void symbolize() const;
+
+    /**
+     * @brief One "#N 0x7f3a... function+0x1f (module)" line per frame
+     */
+    const std::vector<std::string>& frames() const;
+
+    /**
+     * @brief frames() joined with newlines
+     */
+    const std::string& text() const;
+
+private:
+    void* addresses_[XLOG_MAX_STACK_FRAMES];
+    size_t count_ = 0;
+    mutable std::once_flag symbolized_;
+    mutable std::vector<std::string> frames_;
+    mutable std::string text_;
+};
+
+}
@@ -0,0 +1,326 @@
+#pragma once
+#include "Zyrnix_features.hpp"
+#include "formatted_record.hpp"
+#include "formatter.hpp"
+#include "lazy_message.hpp"
+#include "log_clock.hpp"
+#include "log_level.hpp"
+#include "log_sink.hpp"
+#include "log_site.hpp"
+#include "timestamp_cache.hpp"
+#include "trace_context.hpp"
+#include "util.hpp"
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if XLOG_HAS_FMT
+#include <fmt/format.h>
+#include "deferred.hpp"
+#endif
+
+namespace Zyrnix {
+
+/**
+ * @brief A StaticLogger's layout, parsed at compile time (v1.2.0)
+ *
+ * The same pattern language as Formatter, rendered by
+ * pattern::Compiled<P> with every flag inlined.
+ */
+template <pattern::Text P>
+struct StaticPattern {
+    static constexpr bool uses_datetime = pattern::uses_datetime(P.view());
+
+    static void format_to(std::string& out, const pattern::Context& ctx) {
+        pattern::Compiled<P>::render(out, ctx);
+    }
+};
+
+/**
+ * @brief A sink StaticLogger hands its own rendering of each line (v1.2.0)
+ *
+ * write() gets the line in the logger's StaticPattern, ending in '\n'.
+ * flush() is optional.
+ */
+template <class S>
+concept StaticLineSink = requires(S& sink, LogLevel level, std::string_view line) {
+    sink.write(level, line);
+};
+
+/**
+ * @brief Writes lines to a stdio stream, one fwrite() each (v1.2.0)
+ */
+class StaticStreamSink {
+public:
+    explicit StaticStreamSink(std::FILE* stream = stdout) : stream_(stream) {}
+
+    void write(LogLevel, std::string_view line) { std::fwrite(line.data(), 1, line.size(), stream_); }
+    void flush() { std::fflush(stream_); }
+
+private:
+    std::FILE* stream_;
+};
+
+/**
+ * @brief A logger whose layout and sinks are fixed at compile time (v1.2.0)
+ *
+ * The sinks are members, held by value in a tuple, and every call to them
+ * is a direct call the compiler can inline: no shared_ptr, no sink list
+ * to walk and no virtual dispatch. Two kinds of sink fit:
+ *
+ * - StaticLineSink types get the line rendered once by Format, a
+ *   StaticPattern, with every flag known at compile time.
+ * - Any LogSink subclass (FileSink, NullSink, ...) gets the
+ *   FormattedRecord through a qualified call to its own log_record(),
+ *   which bypasses the vtable. It renders with its own formatter and
+ *   honours its own level, as under a Logger.
+ *
+ * @code
+ * using AppLog = Zyrnix::StaticLogger<Zyrnix::StaticPattern<"%H:%M:%S [%l] %v">,
+ *                                     Zyrnix::StaticStreamSink, Zyrnix::FileSink>;
+ * AppLog app("app", stderr, "app.log");
+ * XLOG_INFO(&app, "listening on {}", port);
+ * @endcode
+ *
+ * The XLOG_* macros work on a pointer to it as on a Logger; deferred
+ * sites are formatted on the calling thread. There is no async queue,
+ * filter chain, redaction or metrics: a StaticLogger is for hot paths
+ * whose pipeline is known when the program is built, and it coexists
+ * with the dynamic loggers, which stay the way to configure logging at
+ * run time. Thread safe as far as its sinks are.
+ */
+template <class Format, class... Sinks>
+class StaticLogger {
+    static_assert(((StaticLineSink<Sinks> || std::derived_from<Sinks, LogSink>) && ...),
+                  "StaticLogger sinks are StaticLineSink types or LogSink subclasses");
+
+public:
+    explicit StaticLogger(std::string name)
+        requires(std::default_initializable<Sinks> && ...)
+        : name_(std::move(name)) {}
+
+    /**
+     * @brief Construct each sink in place from the matching argument
+     */
+    template <class... Args>
+        requires(sizeof...(Args) == sizeof...(Sinks) && sizeof...(Sinks) > 0)
+    StaticLogger(std::string name, Args&&... args)
+        : name_(std::move(name)), sinks_(std::forward<Args>(args)...) {}
+
+    StaticLogger(const StaticLogger&) = delete;
+    StaticLogger& operator=(const StaticLogger&) = delete;
+
+    const std::string& name() const { return name_; }
+
+    template <size_t I>
+    auto& sink() { return std::get<I>(sinks_); }
+    template <class S>
+    S& sink() { return std::get<S>(sinks_); }
+
+    void set_level(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel get_level() const { return level_.load(std::memory_order_relaxed); }
+    LogLevel get_effective_level() const { return get_level(); }
+    bool should_log(LogLevel level) const { return level >= get_level(); }
+
+    void log(LogLevel level, std::string_view message) {
+        if (should_log(level)) {
+            dispatch(level, message, nullptr);
+        }
+    }
+
+    void log(const LogSite& site, std::string_view message) {
+        if (enabled(site)) {
+            dispatch(site.level, message, &site);
+        }
+    }
+
+    void log_limited(const LogSite& site, uint64_t suppressed, std::string_view message) {
+        record_suppressed(suppressed);
+        if (!enabled(site)) {
+            return;
+        }
+        if (suppressed == 0) {
+            dispatch(site.level, message, &site);
+            return;
+        }
+        std::string line(message);
+        line += " [" + std::to_string(suppressed) + " suppressed]";
+        dispatch(site.level, line, &site);
+    }
+
+    void record_suppressed(uint64_t count) {
+        if (count > 0) {
+            suppressed_.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    // make runs on the calling thread, deferrable() or not
+    template <class F>
+        requires LazyMessage<F> || is_deferrable_v<std::decay_t<F>>
+    void log_lazy(const LogSite& site, F&& make) {
+        if (enabled(site)) {
+            decltype(auto) message = build_lazy(make);
+            dispatch(site.level, std::string_view(message), &site);
+        }
+    }
+
+    /**
+     * @brief Calls held back by rate-limited macros so far
+     */
+    uint64_t suppressed() const { return suppressed_.load(std::memory_order_relaxed); }
+
+    void trace(std::string_view msg) { log(LogLevel::Trace, msg); }
+    void debug(std::string_view msg) { log(LogLevel::Debug, msg); }
+    void info(std::string_view msg) { log(LogLevel::Info, msg); }
+    void warn(std::string_view msg) { log(LogLevel::Warn, msg); }
+    void error(std::string_view msg) { log(LogLevel::Error, msg); }
+    void critical(std::string_view msg) { log(LogLevel::Critical, msg); }
+
+#if XLOG_HAS_FMT
+    template <class... Args>
+    void log(LogLevel level, fmt::format_string<Args...> format, Args&&... args) {
+        if (should_log(level)) {
+            vlog(level, format, fmt::make_format_args(args...));
+        }
+    }
+
+    template <class... Args>
+    void log(const LogSite& site, fmt::format_string<Args...> format, Args&&... args) {
+        if (enabled(site)) {
+            vlog(site.level, format, fmt::make_format_args(args...), &site);
+        }
+    }
+
+    template <class... Args>
+    void log_limited(const LogSite& site, uint64_t suppressed, fmt::format_string<Args...> format, Args&&... args) {
+        record_suppressed(suppressed);
+        if (enabled(site)) {
+            vlog(site.level, format, fmt::make_format_args(args...), &site, suppressed);
+        }
+    }
+
+    /**
+     * @brief What XLOG_*_DEFERRED calls; formats on the calling thread
+     */
+    template <class... Args>
+    void log_deferred(const DeferredSite& site, const Args&... args) {
+        if (enabled(site)) {
+            vlog(site.level, site.format, fmt::make_format_args(args...), &site);
+        }
+    }
+
+    template <class... Args>
+    void trace(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Trace, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    void debug(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Debug, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    void info(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Info, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    void warn(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Warn, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    void error(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Error, format, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    void critical(fmt::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Critical, format, std::forward<Args>(args)...);
+    }
+#endif
+
+    void flush() {
+        std::apply([](auto&... sinks) { (flush_sink(sinks), ...); }, sinks_);
+    }
+
+private:
+    static constexpr bool has_line_sinks = (StaticLineSink<Sinks> || ...);
+
+    // Set for the duration of a call on this thread, so a sink or an
+    // argument's formatter that logs here gets buffers of its own
+    struct Busy {
+        bool& flag;
+        bool outer;
+        explicit Busy(bool& f) : flag(f), outer(f) { flag = true; }
+        ~Busy() { flag = outer; }
+    };
+
+    bool enabled(const LogSite& site) const { return should_log(site.level) || site.forced(); }
+
+    void dispatch(LogLevel level, std::string_view message, const LogSite* site) {
+        const auto now = LogClock::now();
+        ScopedRenderCache cache;
+        const FormattedRecord record(name_, level, message, now, cache, site);
+        if constexpr (has_line_sinks) {
+            thread_local std::string buffer;
+            thread_local bool busy = false;
+            std::string nested;
+            std::string& line = busy ? nested : buffer;
+            Busy hold(busy);
+            line.clear();
+            pattern::Context ctx{now, {}, name_, level, message, record.thread_id(), site, &TraceContext::current()};
+            if constexpr (Format::uses_datetime) {
+                ctx.datetime = TimestampCache::local(now);
+            }
+            Format::format_to(line, ctx);
+            line.push_back('\n');
+            std::apply([&](auto&... sinks) { (deliver(sinks, record, line), ...); }, sinks_);
+        } else {
+            std::apply([&](auto&... sinks) { (deliver(sinks, record, std::string_view()), ...); }, sinks_);
+        }
+    }
+
+    template <class S>
+    static void deliver(S& sink, const FormattedRecord& record, std::string_view line) {
+        if constexpr (StaticLineSink<S>) {
+            sink.write(record.level(), line);
+        } else {
+            sink.S::log_record(record);
+        }
+    }
+
+    template <class S>
+    static void flush_sink(S& sink) {
+        if constexpr (std::derived_from<S, LogSink>) {
+            sink.S::flush();
+        } else if constexpr (requires { sink.flush(); }) {
+            sink.flush();
+        }
+    }
+
+#if XLOG_HAS_FMT
+    void vlog(LogLevel level, fmt::string_view format, fmt::format_args args, const LogSite* site = nullptr,
+              uint64_t suppressed = 0) {
+        thread_local fmt::memory_buffer buffer;
+        thread_local bool busy = false;
+        fmt::memory_buffer nested;
+        fmt::memory_buffer& out = busy ? nested : buffer;
+        Busy hold(busy);
+        out.clear();
+        fmt::vformat_to(fmt::appender(out), format, args);
+        if (suppressed > 0) {
+            fmt::format_to(fmt::appender(out), " [{} suppressed]", suppressed);
+        }
+        dispatch(level, std::string_view(out.data(), out.size()), site);
+    }
+#endif
+
+    std::string name_;
+    std::atomic<LogLevel> level_{LogLevel::Trace};
+    std::atomic<uint64_t> suppressed_{0};
+    std::tuple<Sinks...> sinks_;
+};
+
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include "field.hpp"
+#include "log_level.hpp"
+#include "trace_context.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Zyrnix {
+
+class FormattedRecord;
+
+/**
+ * @brief The fixed part of a structured record (v1.2.0)
+ */
+struct StructuredHeader {
+    std::chrono::system_clock::time_point timestamp;
+    LogLevel level;
+    std::string_view logger_name;
+    std::string_view message;
+    const TraceContext* trace = nullptr;  // Left out when nullptr or !valid()
+};
+
+/**
+ * @brief Turns structured records into bytes for StructuredSink (v1.2.0)
+ *
+ * A record is begin(), one member() per context entry and field, then
+ * end(). Every call appends to the caller's buffer, which the sink
+ * reuses from line to line. A member's encoding must not depend on its
+ * position: the sink encodes its global context once and copies those
+ * bytes into every record.
+ *
+ * The record keys are timestamp, level, logger and message, then
+ * trace_id and span_id while a trace is set, then the members.
+ */
+class StructuredEncoder {
+public:
+    virtual ~StructuredEncoder() = default;
+
+    /**
+     * @brief Start a record; members says how many member() calls follow
+     */
+    virtual void begin(std::string& out, const StructuredHeader& header, size_t members) = 0;
+
+    virtual void member(std::string& out, std::string_view key, FieldType type, std::string_view text) = 0;
+    void member(std::string& out, std::string_view key, const FieldValue& value) {
+        member(out, key, value.type(), value.text());
+    }
+
+    /**
+     * @brief Finish the record begun at out[start], framing included
+     */
+    virtual void end(std::string& out, size_t start) = 0;
+
+    /**
+     * @brief Members for every entry of the calling thread's LogContext
+     */
+    virtual void thread_context(std::string& out);
+
+    /**
+     * @brief Members for every field of record
+     */
+    virtual void record_fields(std::string& out, const FormattedRecord& record);
+
+    /**
+     * @brief The member for a record's stack trace, frames one per line (v1.2.0)
+     *
+     * Counted in begin()'s members; stack_trace unless the format has a
+     * name of its own for it.
+     */
+    virtual void stack_trace(std::string& out, std::string_view frames) {
+        member(out, "stack_trace", FieldType::String, frames);
+    }
+
+    /**
+     * @brief Whether the output is text, written to files in text mode
+     */
+    virtual bool text() const { return false; }
+};
+
+/**
+ * @brief One JSON object per line, as StructuredJsonSink has always written
+ *
+ * Reads LogContext's cached fragment and the record's shared field
+ * encoding instead of escaping them again.
+ */
+class JsonEncoder : public StructuredEncoder {
+public:
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void member(std::string& out, std::string_view key, FieldType type, std::string_view text) override;
+    using StructuredEncoder::member;
+    void end(std::string& out, size_t start) override;
+    void thread_context(std::string& out) override;
+    void record_fields(std::string& out, const FormattedRecord& record) override;
+    bool text() const override { return true; }
+};
+
+/**
+ * @brief A stream of MessagePack maps, one per record
+ *
+ * The timestamp is the timestamp extension type (-1); numbers and
+ * booleans are native, everything else a str.
+ */
+class MsgPackEncoder : public StructuredEncoder {
+public:
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void member(std::string& out, std::string_view key, FieldType type, std::string_view text) override;
+    using StructuredEncoder::member;
+    void end(std::string&, size_t) override {}
+};
+
+/**
+ * @brief A CBOR sequence (RFC 8742) of maps, one per record
+ *
+ * The timestamp is tag 1 over float64 epoch seconds; numbers and
+ * booleans are native, everything else a text string.
+ */
+class CborEncoder : public StructuredEncoder {
+public:
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void member(std::string& out, std::string_view key, FieldType type, std::string_view text) override;
+    using StructuredEncoder::member;
+    void end(std::string&, size_t) override {}
+};
+
+/**
+ * @brief Length-delimited protobuf: a varint size, then the record message
+ *
+ * The same framing as writeDelimitedTo, for this schema:
+ *
+ *     message LogRecord {
+ *       fixed64 time_unix_nano = 1;
+ *       int32 level = 2;          // LogLevel: 0 trace ... 5 critical
+ *       string logger = 3;
+ *       string message = 4;
+ *       bytes trace_id = 5;       // 16 bytes, absent without a trace
+ *       bytes span_id = 6;        // 8 bytes
+ *       repeated Field fields = 7;
+ *     }
+ *     message Field {
+ *       string key = 1;
+ *       oneof value {
+ *         string string_value = 2;
+ *         sint64 int_value = 3;
+ *         double double_value = 4;
+ *         bool bool_value = 5;
+ *       }
+ *     }
+ */
+class ProtobufEncoder : public StructuredEncoder {
+public:
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void member(std::string& out, std::string_view key, FieldType type, std::string_view text) override;
+    using StructuredEncoder::member;
+    void end(std::string& out, size_t start) override;
+};
+
+/**
+ * @brief One logfmt line per record: key=value pairs separated by spaces
+ *
+ * The keys are ts, level (lower case), logger and msg, then trace_id and
+ * span_id. A value is written bare unless it is empty or holds a space,
+ * '=', a quote, a backslash or a control character; then it is quoted
+ * with JSON escapes, as Go's logfmt readers expect. Numbers and booleans
+ * are always bare.
+ */
+class LogfmtEncoder : public StructuredEncoder {
+public:
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void member(std::string& out, std::string_view key, FieldType type, std::string_view text) override;
+    using StructuredEncoder::member;
+    void end(std::string& out, size_t start) override;
+    bool text() const override { return true; }
+};
+
+/**
+ * @brief Elastic Common Schema JSON lines, as the ecs-logging libraries
+ *        write them
+ *
+ * Starts with @timestamp, log.level and message, then ecs.version,
+ * log.logger, trace.id and span.id. Members are the same as JsonEncoder's,
+ * so the cached context and field encodings are reused as they are; a
+ * stack trace is error.stack_trace.
+ */
+class EcsEncoder : public JsonEncoder {
+public:
+    static constexpr std::string_view ecs_version = "8.11.0";
+
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void stack_trace(std::string& out, std::string_view frames) override {
+        member(out, "error.stack_trace", FieldType::String, frames);
+    }
+};
+
+/**
+ * @brief GELF 1.1 (Graylog) JSON lines
+ *
+ * short_message is the message, timestamp is epoch seconds with
+ * milliseconds and level the syslog severity. The logger, trace ids and
+ * every member are additional fields, named with a leading '_'. Booleans
+ * are written as strings, since GELF values are strings or numbers.
+ */
+class GelfEncoder : public StructuredEncoder {
+public:
+    /**
+     * @brief host is the GELF host field; empty means gethostname()
+     */
+    explicit GelfEncoder(std::string host = {});
+
+    void begin(std::string& out, const StructuredHeader& header, size_t members) override;
+    void member(std::string& out, std::string_view key, FieldType type, std::string_view text) override;
+    using StructuredEncoder::member;
+    void end(std::string& out, size_t start) override;
+    bool text() const override { return true; }
+
+private:
+    std::string host_json_;  // host, already quoted and escaped
+};
+
+enum class StructuredFormat { Json, MsgPack, Cbor, Protobuf, Logfmt, Ecs, Gelf };
+
+std::unique_ptr<StructuredEncoder> make_encoder(StructuredFormat format);
+
+}
@@ -3,17 +3,32 @@
 #include "sinks/structured_json_sink.hpp"
 #include <map>
 #include <memory>
+#include <string_view>
+#include <utility>
 
 namespace Zyrnix {
 
 
+/**
+ * @brief Logger front end for structured fields
+ *
+ * Since v1.2.0 every call builds one record with its fields and sends it
+ * through the Logger: its level, filters, redaction, metrics and async
+ * queue apply, and every sink of the logger gets the fields, encoded to
+ * JSON once per record however many sinks write JSON. set_context()
+ * stays specific to the JSON sink.
+ */
 class StructuredLogger {
 public:
   
     static std::shared_ptr<StructuredLogger> create(const std::string& name, const std::string& filename);
     
-    StructuredLogger(std::shared_ptr<Logger> logger, std::shared_ptr<StructuredJsonSink> sink);
+    StructuredLogger(std::shared_ptr<Logger> logger, std::shared_ptr<StructuredSink> sink);
     
+    /**
+     * @brief The logger records go through, to add sinks or set levels (v1.2.0)
+     */
+    const std::shared_ptr<Logger>& get_logger() const { return logger; }
   
     void set_context(const std::string& key, const std::string& value);
     
@@ -28,9 +43,56 @@ public:
     void error(const std::string& message, const std::map<std::string, std::string>& fields = {});
     void critical(const std::string& message, const std::map<std::string, std::string>& fields = {});
 
+    /**
+     * @brief Log with typed fields built on the stack (v1.2.0)
+     *
+     *     slog->info("request done", kv("status", 200), kv("latency_ms", 3.2), kv("ok", true));
+     *
+     * Numbers and booleans are written as JSON numbers and booleans, and
+     * no map is built.
+     */
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void log(LogLevel level, std::string_view message, Fields&&... fields) {
+        logger->log(level, message, std::forward<Fields>(fields)...);
+    }
+
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void trace(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Trace, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void debug(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Debug, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void info(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Info, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void warn(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Warn, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void error(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Error, message, std::forward<Fields>(fields)...);
+    }
+    template <class... Fields>
+        requires FieldPack<Fields...>
+    void critical(std::string_view message, Fields&&... fields) {
+        log(LogLevel::Critical, message, std::forward<Fields>(fields)...);
+    }
+
 private:
+    void log_map(LogLevel level, std::string_view message, const std::map<std::string, std::string>& fields);
+
     std::shared_ptr<Logger> logger;
-    std::shared_ptr<StructuredJsonSink> json_sink;
+    std::shared_ptr<StructuredSink> json_sink;
 };
 
 }
@@ -0,0 +1,70 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+namespace Zyrnix {
+
+/**
+ * @brief Where the library's own threads run and allocate (v1.2.0)
+ *
+ * Covers every thread Zyrnix starts: async logger workers, ThreadPool
+ * workers, dedicated sink workers, the shared HTTP I/O thread, the
+ * background flusher, TCP, mmap, group-commit and rename workers, and
+ * ConfigWatcher.
+ */
+struct ThreadPlacement {
+    // CPUs the threads may run on, e.g. parse_cpu_list("2-3,34-35"); empty
+    // leaves them wherever the scheduler puts them
+    std::vector<int> cpus;
+
+    // When every CPU in cpus is on one NUMA node, allocate async queues,
+    // record pools and pool deques on that node, and have the threads
+    // prefer it for what they allocate themselves
+    bool numa_local = true;
+};
+
+/**
+ * @brief Set the placement of threads started from now on (v1.2.0)
+ *
+ * Call it before creating loggers and sinks; threads already running keep
+ * their CPUs. Linux only; elsewhere threads are only named.
+ */
+void set_thread_placement(ThreadPlacement placement);
+ThreadPlacement get_thread_placement();
+
+/**
+ * @brief Parse a CPU list in the kernel's format ("0-3,8,10-11") (v1.2.0)
+ * @return The CPUs in ascending order, empty if list is malformed
+ */
+std::vector<int> parse_cpu_list(std::string_view list);
+
+/**
+ * @brief Name the calling thread and apply the placement (v1.2.0)
+ *
+ * Called first by every thread the library starts. name shows in top -H,
+ * perf and gdb; the kernel keeps 15 characters of it.
+ */
+void init_background_thread(const char* name);
+
+/**
+ * @brief Allocations in its scope prefer the placement's NUMA node (v1.2.0)
+ *
+ * Wraps the construction of memory a background thread consumes, so the
+ * pages are faulted in on that thread's node rather than the creator's.
+ * Does nothing without a single-node placement.
+ */
+class NumaLocalScope {
+public:
+    NumaLocalScope();
+    ~NumaLocalScope();
+
+    NumaLocalScope(const NumaLocalScope&) = delete;
+    NumaLocalScope& operator=(const NumaLocalScope&) = delete;
+
+private:
+    bool active_ = false;
+    int old_mode_ = 0;
+    unsigned long old_nodes_[16] = {};  // Up to 1024 nodes, the kernel's default maximum
+};
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <time.h>
+
+namespace Zyrnix {
+
+/**
+ * @brief Sub-second digits appended after the seconds (v1.2.0)
+ */
+enum class TimePrecision {
+    Seconds,       // "HH:MM:SS"
+    Milliseconds,  // "HH:MM:SS.mmm"
+    Microseconds   // "HH:MM:SS.uuuuuu"
+};
+
+/**
+ * @brief Per-thread cache of rendered timestamps (v1.2.0)
+ *
+ * localtime_r/gmtime_r and strftime only run when the second changes;
+ * records logged within the same second reuse the cached text. The
+ * returned views point into thread-local storage and stay valid until
+ * the next call of the same function on the same thread.
+ */
+class TimestampCache {
+public:
+    /**
+     * @brief "YYYY-MM-DD HH:MM:SS" in local time
+     */
+    static std::string_view local(std::chrono::system_clock::time_point when);
+
+    /**
+     * @brief "YYYY-MM-DDTHH:MM:SS" in UTC, without the trailing 'Z'
+     */
+    static std::string_view utc(std::chrono::system_clock::time_point when);
+
+    /**
+     * @brief Append ".mmm" or ".uuuuuu" for precision; nothing for Seconds
+     */
+    static void append_fraction(std::string& out, std::chrono::system_clock::time_point when,
+                                TimePrecision precision);
+
+    /**
+     * @brief Length of the fraction append_fraction() writes
+     */
+    static size_t fraction_size(TimePrecision precision);
+};
+
+/**
+ * @brief Wall-clock nanoseconds since the epoch at millisecond resolution (v1.2.0)
+ *
+ * The coarse realtime clock where the platform has one, for checks
+ * against a precomputed deadline that can afford to be a few ms late.
+ */
+inline int64_t realtime_coarse_ns() {
+#ifdef CLOCK_REALTIME_COARSE
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000ll + static_cast<int64_t>(ts.tv_nsec);
+#else
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief When the local hour (or day) after when begins, in epoch nanoseconds (v1.2.0)
+ *
+ * Computed with mktime(), so daylight saving changes are honoured.
+ * Compare realtime_coarse_ns() against it rather than formatting the
+ * date of every record.
+ */
+int64_t next_local_rollover_ns(std::chrono::system_clock::time_point when, bool daily);
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace Zyrnix {
+
+/**
+ * @brief W3C trace context of the calling thread: trace id, span id, flags (v1.2.0)
+ *
+ * Kept in a thread_local of fixed size rather than in LogContext, so
+ * setting it costs a copy of 25 bytes and records take it by value with
+ * no allocation. Formatters render it with %x (trace id) and %y (span
+ * id); StructuredJsonSink and LokiSink add trace_id and span_id keys.
+ * All of them leave it out while no trace is set.
+ *
+ * wrap() carries the context into work run on another thread:
+ *
+ *     pool.submit(TraceContext::wrap([&] { handle(request); }));
+ */
+struct TraceContext {
+    std::array<uint8_t, 16> trace_id{};
+    std::array<uint8_t, 8> span_id{};
+    uint8_t flags = 0;  // Bit 0: sampled
+
+    static constexpr size_t trace_id_hex_size = 32;
+    static constexpr size_t span_id_hex_size = 16;
+
+    /**
+     * @brief Whether a trace is set: W3C reserves the all-zero trace id
+     */
+    bool valid() const {
+        for (uint8_t byte : trace_id) {
+            if (byte != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool sampled() const { return (flags & 1) != 0; }
+
+    /**
+     * @brief Lowercase hex of the ids, written to out
+     */
+    void write_trace_id(char (&out)[trace_id_hex_size]) const;
+    void write_span_id(char (&out)[span_id_hex_size]) const;
+    void append_trace_id(std::string& out) const;
+    void append_span_id(std::string& out) const;
+
+    /**
+     * @brief A traceparent header value: "00-<trace id>-<span id>-<flags>"
+     */
+    std::string traceparent() const;
+
+    /**
+     * @brief Parse a traceparent header; nullopt if malformed or all-zero
+     */
+    static std::optional<TraceContext> from_traceparent(std::string_view header);
+
+    /**
+     * @brief The calling thread's context; valid() is false if none is set
+     */
+    static const TraceContext& current();
+    static void set(const TraceContext& context);
+    static void clear();
+
+    /**
+     * @brief task, run under the calling thread's context wherever it is called
+     */
+    template <class F>
+    static auto wrap(F&& task);
+
+    bool operator==(const TraceContext& other) const = default;
+};
+
+/**
+ * @brief Sets the thread's trace context for a scope, restoring the
+ *        previous one on exit (v1.2.0)
+ */
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const TraceContext& context) : previous_(TraceContext::current()) {
+        TraceContext::set(context);
+    }
+    ~ScopedTrace() { TraceContext::set(previous_); }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    TraceContext previous_;
+};
+
+template <class F>
+auto TraceContext::wrap(F&& task) {
+    return [context = current(), task = std::forward<F>(task)](auto&&... args) mutable -> decltype(auto) {
+        ScopedTrace scope(context);
+        return task(std::forward<decltype(args)>(args)...);
+    };
+}
+
+}
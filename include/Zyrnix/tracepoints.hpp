@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief USDT probes on the logging path (v1.2.0)
+ *
+ * XLOG_PROBE(name, args...) places a SystemTap/DTrace-compatible static
+ * probe "zyrnix:name": a single nop plus an ELF .note.stapsdt entry that
+ * tells bpftrace, perf and stap where the probe is and where each
+ * argument lives. Untraced, that nop is the whole cost; a tracer attaching
+ * rewrites it into a trap, with no rebuild:
+ *
+ *     bpftrace -e 'usdt:./libZyrnix.so:zyrnix:sink__write__end
+ *                  { @[str(arg1)] = hist(arg3); }'
+ *
+ * Arguments are integers or pointers (strings are const char*, read with
+ * str()), at most five. Probes whose arguments cost something to compute,
+ * such as a latency, have a semaphore that tracers raise while attached;
+ * XLOG_PROBE_ENABLED(name) reads it so that work is skipped otherwise.
+ *
+ * The notes are written here rather than through <sys/sdt.h>, so probes
+ * need no systemtap headers at build time. Built for ELF on x86-64 and
+ * AArch64 with GCC or Clang; elsewhere, or with -DXLOG_ENABLE_USDT=OFF,
+ * probes compile to nothing and XLOG_PROBE_ENABLED() is false.
+ */
+#if !defined(XLOG_NO_USDT) && defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define XLOG_HAS_USDT 1
+#endif
+
+#ifdef XLOG_HAS_USDT
+
+namespace Zyrnix::detail {
+
+// Argument size in the note: negative for signed types, as sdt.h writes it
+// after the %n in the template negates it
+template <class T>
+constexpr int sdt_size() {
+    using Arg = std::decay_t<T>;
+    return (std::is_signed_v<Arg> ? 1 : -1) * static_cast<int>(sizeof(Arg));
+}
+
+}
+
+#define XLOG_PROBE_SEMAPHORE(name) zyrnix_##name##_semaphore
+#define XLOG_PROBE_DECLARE_SEMAPHORE(name) \
+    extern "C" volatile unsigned short XLOG_PROBE_SEMAPHORE(name) __attribute__((visibility("hidden")))
+#define XLOG_PROBE_DEFINE_SEMAPHORE(name)                                                           \
+    extern "C" {                                                                                    \
+    volatile unsigned short XLOG_PROBE_SEMAPHORE(name)                                              \
+        __attribute__((visibility("hidden"), section(".probes"), used)) = 0;                        \
+    }                                                                                               \
+    static_assert(true)
+#define XLOG_PROBE_ENABLED(name) (__builtin_expect(XLOG_PROBE_SEMAPHORE(name) != 0, 0))
+
+#define XLOG_SDT_NOTE(name, semaphore, args)                                   \
+    "990: nop\n"                                                               \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                              \
+    ".balign 4\n"                                                              \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                         \
+    "991: .asciz \"stapsdt\"\n"                                                \
+    "992: .balign 4\n"                                                         \
+    "993: .8byte 990b\n"                                                       \
+    ".8byte _.stapsdt.base\n"                                                  \
+    ".8byte " semaphore "\n"                                                   \
+    ".asciz \"zyrnix\"\n"                                                      \
+    ".asciz \"" #name "\"\n"                                                   \
+    ".asciz \"" args "\"\n"                                                    \
+    "994: .balign 4\n"                                                         \
+    ".popsection\n"                                                            \
+    ".ifndef _.stapsdt.base\n"                                                 \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"    \
+    ".weak _.stapsdt.base\n"                                                   \
+    ".hidden _.stapsdt.base\n"                                                 \
+    "_.stapsdt.base: .space 1\n"                                               \
+    ".size _.stapsdt.base, 1\n"                                                \
+    ".popsection\n"                                                            \
+    ".endif\n"
+
+#define XLOG_SDT_FMT1 "%n[s1]@%[a1]"
+#define XLOG_SDT_FMT2 XLOG_SDT_FMT1 " %n[s2]@%[a2]"
+#define XLOG_SDT_FMT3 XLOG_SDT_FMT2 " %n[s3]@%[a3]"
+#define XLOG_SDT_FMT4 XLOG_SDT_FMT3 " %n[s4]@%[a4]"
+#define XLOG_SDT_FMT5 XLOG_SDT_FMT4 " %n[s5]@%[a5]"
+
+#define XLOG_SDT_ARG(n, x) [s##n] "n"(::Zyrnix::detail::sdt_size<decltype(x)>()), [a##n] "nor"(x)
+#define XLOG_SDT_ARGS1(a) XLOG_SDT_ARG(1, a)
+#define XLOG_SDT_ARGS2(a, b) XLOG_SDT_ARGS1(a), XLOG_SDT_ARG(2, b)
+#define XLOG_SDT_ARGS3(a, b, c) XLOG_SDT_ARGS2(a, b), XLOG_SDT_ARG(3, c)
+#define XLOG_SDT_ARGS4(a, b, c, d) XLOG_SDT_ARGS3(a, b, c), XLOG_SDT_ARG(4, d)
+#define XLOG_SDT_ARGS5(a, b, c, d, e) XLOG_SDT_ARGS4(a, b, c, d), XLOG_SDT_ARG(5, e)
+
+#define XLOG_SDT_COUNT(...) XLOG_SDT_COUNT_(__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define XLOG_SDT_COUNT_(_1, _2, _3, _4, _5, n, ...) n
+#define XLOG_SDT_CAT(a, b) XLOG_SDT_CAT_(a, b)
+#define XLOG_SDT_CAT_(a, b) a##b
+
+#define XLOG_SDT_PROBE(name, semaphore, ...)                                                       \
+    __asm__ __volatile__(XLOG_SDT_NOTE(name, semaphore, XLOG_SDT_CAT(XLOG_SDT_FMT, XLOG_SDT_COUNT(__VA_ARGS__))) \
+                         : : XLOG_SDT_CAT(XLOG_SDT_ARGS, XLOG_SDT_COUNT(__VA_ARGS__))(__VA_ARGS__))
+
+#define XLOG_PROBE(name, ...) XLOG_SDT_PROBE(name, "0", __VA_ARGS__)
+// For a probe with a semaphore from XLOG_PROBE_DECLARE_SEMAPHORE()
+#define XLOG_PROBE_GUARDED(name, ...) \
+    XLOG_SDT_PROBE(name, XLOG_SDT_STR(XLOG_PROBE_SEMAPHORE(name)), __VA_ARGS__)
+#define XLOG_SDT_STR(x) XLOG_SDT_STR_(x)
+#define XLOG_SDT_STR_(x) #x
+
+#else
+
+#define XLOG_PROBE_DECLARE_SEMAPHORE(name) static_assert(true)
+#define XLOG_PROBE_DEFINE_SEMAPHORE(name) static_assert(true)
+#define XLOG_PROBE_ENABLED(name) false
+#define XLOG_PROBE(name, ...) do {} while (0)
+#define XLOG_PROBE_GUARDED(name, ...) do {} while (0)
+
+#endif
+
+// Probes that carry a latency; only timed while a tracer is attached
+XLOG_PROBE_DECLARE_SEMAPHORE(log__return);
+XLOG_PROBE_DECLARE_SEMAPHORE(redact);
+XLOG_PROBE_DECLARE_SEMAPHORE(sink__write__end);
@@ -1,10 +1,19 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 namespace Zyrnix {
 
 std::string trim(const std::string& s);
 
+/**
+ * @brief Numeric id of the calling thread (v1.2.0)
+ *
+ * The kernel thread id on Linux, so it matches what top and gdb show;
+ * elsewhere a hash of std::this_thread::get_id(). Cached per thread.
+ */
+uint64_t current_thread_id();
+
 /**
  * @brief Platform path utilities (v1.1.2)
  * 
@@ -9,8 +9,10 @@ LoggerPtr create_logger(const std::string& name, const Config&) {
     return std::make_shared<Logger>(name);
 }
 
+#ifndef XLOG_NO_ASYNC
 AsyncLoggerPtr create_async_logger(LoggerPtr logger, const Config&) {
     return std::make_shared<AsyncLogger>(logger);
 }
+#endif
 
 }
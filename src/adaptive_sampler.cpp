@@ -0,0 +1,120 @@
+#include "Zyrnix/adaptive_sampler.hpp"
+#include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/rate_limiter.hpp"
+#include <algorithm>
+
+namespace Zyrnix {
+
+AdaptiveSampler::AdaptiveSampler(const AdaptiveSamplingOptions& options)
+    : options_(options)
+    , interval_ns_(static_cast<uint64_t>(std::max<int64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(options.interval).count(), 1)))
+{
+    options_.max_sample_rate = std::max<size_t>(options_.max_sample_rate, 1);
+    last_writes_.resize(options_.sinks.size());
+    last_errors_.resize(options_.sinks.size());
+    for (size_t i = 0; i < options_.sinks.size(); ++i) {
+        if (options_.sinks[i]) {
+            last_writes_[i] = options_.sinks[i]->get_writes();
+            last_errors_[i] = options_.sinks[i]->get_errors();
+        }
+    }
+    next_eval_ns_.store(monotonic_coarse_ns() + interval_ns_, std::memory_order_relaxed);
+    if (options_.metrics) {
+        options_.metrics->update_sample_rate(1);
+    }
+}
+
+AdaptiveSampler::~AdaptiveSampler() = default;
+
+double AdaptiveSampler::pressure() const {
+    return static_cast<double>(pressure_permille_.load(std::memory_order_relaxed)) / 1000.0;
+}
+
+double AdaptiveSampler::measure() const {
+    double pressure = 0.0;
+    if (const LogMetrics* metrics = options_.metrics.get()) {
+        if (const size_t capacity = metrics->get_queue_capacity()) {
+            pressure = std::max(pressure, static_cast<double>(metrics->get_current_queue_depth()) /
+                                              static_cast<double>(capacity));
+        }
+        if (options_.latency_budget_us > 0) {
+            pressure = std::max(pressure, static_cast<double>(metrics->get_recent_log_latency_us()) /
+                                              static_cast<double>(options_.latency_budget_us));
+        }
+    }
+    for (size_t i = 0; i < options_.sinks.size(); ++i) {
+        const SinkMetrics* sink = options_.sinks[i].get();
+        if (!sink) {
+            continue;
+        }
+        const uint64_t writes = sink->get_writes();
+        const uint64_t errors = sink->get_errors();
+        const uint64_t new_writes = writes - last_writes_[i];
+        const uint64_t new_errors = errors - last_errors_[i];
+        last_writes_[i] = writes;
+        last_errors_[i] = errors;
+        if (new_errors > 0 && options_.error_rate_budget > 0) {
+            const double rate = static_cast<double>(new_errors) / static_cast<double>(new_writes + new_errors);
+            pressure = std::max(pressure, rate / options_.error_rate_budget);
+        }
+    }
+    return std::min(pressure, 1.0);
+}
+
+void AdaptiveSampler::evaluate() const {
+    std::unique_lock<std::mutex> lock(eval_mtx_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;  // Another thread is already at it
+    }
+    const double pressure = measure();
+    pressure_permille_.store(static_cast<uint64_t>(pressure * 1000.0), std::memory_order_relaxed);
+
+    const size_t rate = rate_.load(std::memory_order_relaxed);
+    size_t next = rate;
+    if (pressure > options_.engage_at) {
+        next = std::min(rate * 2, options_.max_sample_rate);
+    } else if (pressure < options_.release_at) {
+        next = std::max<size_t>(rate / 2, 1);
+    }
+    if (next != rate) {
+        rate_.store(next, std::memory_order_relaxed);
+        if (options_.metrics) {
+            options_.metrics->update_sample_rate(next);
+        }
+    }
+}
+
+bool AdaptiveSampler::admit(LogLevel level) const {
+    const uint64_t now = monotonic_coarse_ns();
+    uint64_t next_eval = next_eval_ns_.load(std::memory_order_relaxed);
+    if (now >= next_eval &&
+        next_eval_ns_.compare_exchange_strong(next_eval, now + interval_ns_, std::memory_order_relaxed)) {
+        evaluate();
+    }
+
+    if (level >= options_.protected_level) {
+        return true;
+    }
+    const size_t rate = rate_.load(std::memory_order_relaxed);
+    if (rate <= 1) {
+        return true;
+    }
+    // Per thread, so the hot path writes nothing shared
+    thread_local uint64_t seen = 0;
+    if (seen++ % rate == 0) {
+        return true;
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+FilterVerdict AdaptiveSampler::prefilter(const RecordView& view) const {
+    return admit(view.level) ? FilterVerdict::Accept : FilterVerdict::Reject;
+}
+
+bool AdaptiveSampler::should_log(const LogRecord& record) const {
+    return admit(record.level);
+}
+
+}
@@ -0,0 +1,135 @@
+#include "Zyrnix/aho_corasick.hpp"
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace Zyrnix {
+
+namespace {
+constexpr uint32_t no_state = std::numeric_limits<uint32_t>::max();
+}
+
+AhoCorasick::AhoCorasick(const std::vector<std::string>& patterns) {
+    // Only bytes that appear in a pattern get their own column
+    for (const auto& pat : patterns) {
+        for (unsigned char c : pat) {
+            if (byte_class_[c] == 0) {
+                byte_class_[c] = static_cast<uint16_t>(class_count_++);
+            }
+        }
+    }
+
+    // Trie, with missing edges marked no_state
+    transitions_.assign(class_count_, no_state);
+    match_length_.assign(1, 0);
+    for (const auto& pat : patterns) {
+        if (pat.empty()) {
+            continue;
+        }
+        uint32_t state = 0;
+        for (unsigned char c : pat) {
+            const size_t slot = static_cast<size_t>(state) * class_count_ + byte_class_[c];
+            if (transitions_[slot] == no_state) {
+                const uint32_t created = static_cast<uint32_t>(match_length_.size());
+                transitions_[slot] = created;
+                transitions_.resize(transitions_.size() + class_count_, no_state);
+                match_length_.push_back(0);
+            }
+            state = transitions_[slot];
+        }
+        match_length_[state] = std::max<uint32_t>(match_length_[state], static_cast<uint32_t>(pat.size()));
+        ++pattern_count_;
+    }
+    if (pattern_count_ <= small_set_limit) {
+        for (const auto& pat : patterns) {
+            if (!pat.empty()) {
+                small_set_.push_back(pat);
+            }
+        }
+    }
+
+    // Breadth-first pass: fill failure transitions so every state has a
+    // complete row, and inherit the longest match of the failure state.
+    std::vector<uint32_t> failure(match_length_.size(), 0);
+    std::queue<uint32_t> pending;
+    for (uint32_t cls = 0; cls < class_count_; ++cls) {
+        uint32_t& target = transitions_[cls];
+        if (target == no_state) {
+            target = 0;
+        } else {
+            failure[target] = 0;
+            pending.push(target);
+        }
+    }
+    while (!pending.empty()) {
+        const uint32_t state = pending.front();
+        pending.pop();
+        match_length_[state] = std::max(match_length_[state], match_length_[failure[state]]);
+        for (uint32_t cls = 0; cls < class_count_; ++cls) {
+            uint32_t& target = transitions_[static_cast<size_t>(state) * class_count_ + cls];
+            const uint32_t fallback = transitions_[static_cast<size_t>(failure[state]) * class_count_ + cls];
+            if (target == no_state) {
+                target = fallback;
+            } else {
+                failure[target] = fallback;
+                pending.push(target);
+            }
+        }
+    }
+}
+
+bool AhoCorasick::contains_any(std::string_view text) const {
+    if (empty()) {
+        return false;
+    }
+    uint32_t state = 0;
+    for (unsigned char c : text) {
+        state = next(state, c);
+        if (match_length_[state] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AhoCorasick::mask_small(std::string_view text, std::string& out, char fill) const {
+    bool matched = false;
+    for (const auto& pat : small_set_) {
+        // Step by one so overlapping occurrences are masked too
+        for (size_t pos = text.find(pat); pos != std::string_view::npos; pos = text.find(pat, pos + 1)) {
+            if (!matched) {
+                out.assign(text.data(), text.size());
+                matched = true;
+            }
+            std::fill_n(out.begin() + static_cast<std::ptrdiff_t>(pos), pat.size(), fill);
+        }
+    }
+    return matched;
+}
+
+bool AhoCorasick::mask(std::string_view text, std::string& out, char fill) const {
+    if (empty()) {
+        return false;
+    }
+    if (!small_set_.empty()) {
+        return mask_small(text, out, fill);
+    }
+    bool matched = false;
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        state = next(state, static_cast<unsigned char>(text[i]));
+        const uint32_t length = match_length_[state];
+        if (length == 0) {
+            continue;
+        }
+        if (!matched) {
+            out.assign(text.data(), text.size());
+            matched = true;
+        }
+        // Shorter matches ending here are suffixes of the longest one
+        std::fill_n(out.begin() + static_cast<std::ptrdiff_t>(i + 1 - length), length, fill);
+    }
+    return matched;
+}
+
+}
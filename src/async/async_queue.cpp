@@ -1,45 +1,1024 @@
 #include "Zyrnix/async/async_queue.hpp"
+#include "Zyrnix/async/mpmc_ring.hpp"
+#include "Zyrnix/async/spsc_ring.hpp"
+#include "Zyrnix/crash_drain.hpp"
+#include "Zyrnix/deferred.hpp"
 #include "Zyrnix/logger.hpp"
 #include "Zyrnix/log_sink.hpp"
 #include "Zyrnix/formatter.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace Zyrnix {
 
+struct AsyncQueue::Lane {
+    explicit Lane(uint64_t lane_id, size_t capacity) : id(lane_id), ring(capacity) {}
+
+    const uint64_t id;
+    SpscRing<LogRecord> ring;
+    std::atomic<uint64_t> dropped{0};     // Written only by the owning thread
+    std::atomic<bool> retired{false};     // Owning thread exited
+    std::atomic<bool> detached{false};    // Owning queue destroyed
+};
+
+namespace {
+
+std::atomic<uint64_t> next_queue_id{1};
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Lanes owned by the current thread, keyed by queue id. Ids are never
+// reused, so an entry for a destroyed queue can never be matched again.
+struct ThreadLanes {
+    std::vector<std::pair<uint64_t, std::shared_ptr<AsyncQueue::Lane>>> entries;
+
+    ~ThreadLanes() {
+        for (auto& entry : entries) {
+            entry.second->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadLanes thread_lanes;
+
+}
+
+static AsyncQueueOptions unbounded_options(size_t shutdown_timeout_ms) {
+    AsyncQueueOptions options;
+    options.capacity = 0;
+    options.shutdown_timeout_ms = shutdown_timeout_ms;
+    return options;
+}
+
 AsyncQueue::AsyncQueue(size_t shutdown_timeout_ms)
-    : shutdown_timeout_ms_(shutdown_timeout_ms) {
+    : AsyncQueue(unbounded_options(shutdown_timeout_ms)) {
+}
+
+AsyncQueue::AsyncQueue(const AsyncQueueOptions& options)
+    : backend_(options.backend)
+    , queue_id_(next_queue_id.fetch_add(1, std::memory_order_relaxed))
+    , lane_capacity_(options.lane_capacity)
+    , capacity_(options.capacity)
+    , overflow_policy_(options.overflow_policy)
+    , block_timeout_ms_(options.block_timeout_ms)
+    , sample_rate_(options.sample_rate > 0 ? options.sample_rate : 1)
+    , budget_(options.budget_account)
+    , high_permille_(options.high_watermark > 0 ? static_cast<size_t>(std::min(options.high_watermark, 1.0) * 1000) : 0)
+    , low_permille_(static_cast<size_t>(std::clamp(options.low_watermark, 0.0, options.high_watermark) * 1000))
+    , wait_strategy_(options.wait_strategy)
+    , spin_iterations_(options.spin_iterations)
+    , yield_iterations_(options.yield_iterations)
+    , shutdown_timeout_ms_(options.shutdown_timeout_ms) {
+    if (backend_ == QueueBackend::LockFreeRing) {
+        ring_ = std::make_unique<MpmcRing<LogRecord>>(options.capacity);
+    }
+    if (options.priority_lane) {
+        priority_ring_ = std::make_unique<MpmcRing<LogRecord>>(options.priority_capacity);
+        priority_level_ = options.priority_level;
+    }
+    if (!options.tenants.field.empty()) {
+        if (backend_ == QueueBackend::Mutex) {
+            queue_.configure(options.tenants, MetricsRegistry::instance().get_tenant_metrics(options.budget_account));
+        } else {
+            std::cerr << "AsyncQueue: tenant fairness needs QueueBackend::Mutex; ignoring tenants.field"
+                      << std::endl;
+        }
+    }
+    if (backend_ == QueueBackend::Mutex && capacity_ > 0 && !queue_.fair()) {
+        queue_.reserve(capacity_);
+    }
+    crash_slot_ = crash::register_source(this, &AsyncQueue::drain_for_crash);
 }
 
 AsyncQueue::~AsyncQueue() {
+    crash::unregister_source(crash_slot_);
     shutdown(true);
+
+    std::lock_guard<std::mutex> lock(lanes_mtx_);
+    for (auto& lane : lanes_) {
+        lane->detached.store(true, std::memory_order_release);
+    }
 }
 
 bool AsyncQueue::push(LogRecord&& record) {
+    return push_record(std::move(record), true);
+}
+
+bool AsyncQueue::try_push(LogRecord&& record) {
+    return push_record(std::move(record), false);
+}
+
+bool AsyncQueue::push_record(LogRecord&& record, bool may_block) {
     if (shutdown_.load(std::memory_order_acquire)) {
         return false;
     }
+    size_t bytes = 0;
+    if (budget_.active()) {
+        bytes = TenantQueue::cost(record);
+        if (!budget_.try_charge(record.level, bytes)) {
+            count_overflow(over_budget_);
+            return false;
+        }
+    }
+    bool pushed;
+
+    // A full priority lane falls back to the normal path rather than dropping
+    if (priority_ring_ && record.level >= priority_level_ &&
+        priority_ring_->try_push(std::move(record))) {
+        notify_consumer();
+        return true;
+    }
     
+    switch (backend_) {
+        case QueueBackend::LockFreeRing: pushed = push_ring(std::move(record), may_block); break;
+        case QueueBackend::PerThreadLanes: pushed = push_lane(std::move(record), may_block); break;
+        default: pushed = push_mutex(std::move(record), may_block); break;
+    }
+    if (!pushed) {
+        budget_.release(bytes);
+    }
+    return pushed;
+}
+
+size_t AsyncQueue::push_bulk(std::span<LogRecord> records, bool may_block) {
+    size_t queued = 0;
+    size_t next = 0;
+    while (next < records.size() && !shutdown_.load(std::memory_order_acquire)) {
+        size_t run = 0;
+        while (next + run < records.size() &&
+               !(priority_ring_ && records[next + run].level >= priority_level_)) {
+            ++run;
+        }
+        bool over_budget = false;
+        const size_t placed = run > 0 ? push_run(records.subspan(next, run), over_budget) : 0;
+        queued += placed;
+        next += placed;
+        if (over_budget) {
+            ++next;  // Turned away, and counted, by push_run()
+        } else if (next < records.size()) {
+            // A priority record, or the first that did not fit
+            queued += push_record(std::move(records[next]), may_block) ? 1 : 0;
+            ++next;
+        }
+    }
+    return queued;
+}
+
+// over_budget is set when every record charged was placed and the next
+// one was turned away by the budget
+size_t AsyncQueue::push_run(std::span<LogRecord> records, bool& over_budget) {
+    size_t count = records.size();
+    if (budget_.active()) {
+        count = 0;
+        while (count < records.size() &&
+               budget_.try_charge(records[count].level, TenantQueue::cost(records[count]))) {
+            ++count;
+        }
+        if (count == 0) {
+            over_budget = true;
+            count_overflow(over_budget_);
+            return 0;
+        }
+    }
+
+    size_t placed;
+    switch (backend_) {
+        case QueueBackend::LockFreeRing:
+            placed = ring_->try_push_bulk(records.data(), count);
+            if (placed > 0 && watching_rise()) {
+                check_rising(ring_->size(), ring_->capacity());
+            }
+            break;
+        case QueueBackend::PerThreadLanes: {
+            Lane* lane = local_lane();
+            placed = lane->ring.try_push_bulk(records.data(), count);
+            if (placed > 0 && watching_rise()) {
+                check_rising(lane->ring.size(), lane->ring.capacity());
+            }
+            break;
+        }
+        default:
+            placed = push_mutex_run(records.first(count));
+            break;
+    }
+    if (placed > 0 && backend_ != QueueBackend::Mutex) {
+        notify_consumer();
+    }
+    for (size_t k = placed; k < count && budget_.active(); ++k) {
+        budget_.release(TenantQueue::cost(records[k]));
+    }
+    if (placed == count && count < records.size()) {
+        over_budget = true;
+        count_overflow(over_budget_);
+    }
+    return placed;
+}
+
+size_t AsyncQueue::push_mutex_run(std::span<LogRecord> records) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    size_t placed = records.size();
+    if (capacity_ > 0) {
+        placed = std::min(placed, capacity_ - std::min(queue_.size(), capacity_));
+    }
+    for (size_t k = 0; k < placed; ++k) {
+        TenantQueue::Tenant* tenant = queue_.tenant_of(records[k]);
+        // push() turns it away, counted, on its own
+        if (!queue_.within_quota(tenant, records[k])) {
+            placed = k;
+            break;
+        }
+        queue_.push(tenant, std::move(records[k]));
+    }
+    const size_t depth = queue_.size();
+    approx_size_.store(depth, std::memory_order_relaxed);
+    const size_t waiting = placed > 0 ? waiting_consumers_.load(std::memory_order_relaxed) : 0;
+    lock.unlock();
+    if (placed > 0 && capacity_ > 0 && watching_rise()) {
+        check_rising(depth, capacity_);
+    }
+    // Enough records for more than one parked consumer
+    if (waiting > 1 && placed > 1) {
+        cv_.notify_all();
+    } else if (waiting > 0) {
+        cv_.notify_one();
+    }
+    return placed;
+}
+
+bool AsyncQueue::push_mutex(LogRecord&& record, bool may_block) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    bool evicted = false;
+
+    // A tenant at its quota is refused whatever the policy, so it never
+    // holds up the other tenants' producers
+    TenantQueue::Tenant* tenant = queue_.tenant_of(record);
+    if (!queue_.within_quota(tenant, record)) {
+        queue_.refuse(tenant);
+        lock.unlock();
+        count_overflow(over_quota_);
+        return false;
+    }
+    if (capacity_ > 0 && queue_.size() >= capacity_ && high_permille_ > 0 &&
+        pressure_.load(std::memory_order_relaxed) != Backpressure::Saturated) {
+        // The callback may log; it never runs under mtx_
+        lock.unlock();
+        saturate();
+        lock.lock();
+    }
+    if (capacity_ > 0 && queue_.size() >= capacity_) {
+        switch (overflow_policy_) {
+            case OverflowPolicy::Block: {
+                if (!may_block) {
+                    lock.unlock();
+                    count_overflow(dropped_newest_);
+                    return false;
+                }
+                blocked_producers_.fetch_add(1, std::memory_order_relaxed);
+                bool has_space = space_cv_.wait_for(lock, std::chrono::milliseconds(block_timeout_ms_), [this] {
+                    return queue_.size() < capacity_ || shutdown_.load(std::memory_order_acquire);
+                });
+                blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+                if (!has_space || shutdown_.load(std::memory_order_acquire)) {
+                    lock.unlock();
+                    count_overflow(block_timeouts_);
+                    return false;
+                }
+                break;
+            }
+            case OverflowPolicy::DropNewest:
+                lock.unlock();
+                count_overflow(dropped_newest_);
+                return false;
+            case OverflowPolicy::Sample:
+                if (!sample_keep()) {
+                    lock.unlock();
+                    count_overflow(sampled_out_);
+                    return false;
+                }
+                [[fallthrough]];
+            case OverflowPolicy::DropOldest:
+                // With tenants, from the one holding the most
+                budget_.release(budget_.active() ? TenantQueue::cost(queue_.victim()) : 0);
+                queue_.pop_victim();
+                evicted = true;
+                break;
+        }
+    }
+
+    queue_.push(tenant, std::move(record));
+    const size_t depth = queue_.size();
+    approx_size_.store(depth, std::memory_order_relaxed);
+    // Only signal a consumer that has actually parked
+    const bool wake = waiting_consumers_.load(std::memory_order_relaxed) > 0;
+    lock.unlock();
+    if (capacity_ > 0 && watching_rise()) {
+        check_rising(depth, capacity_);
+    }
+    if (wake) {
+        cv_.notify_one();
+    }
+    if (evicted) {
+        count_overflow(evicted_oldest_);
+    }
+    return true;
+}
+
+bool AsyncQueue::push_ring(LogRecord&& record, bool may_block) {
+    if (ring_->try_push(std::move(record))) {
+        if (watching_rise()) {
+            check_rising(ring_->size(), ring_->capacity());
+        }
+        notify_consumer();
+        return true;
+    }
+
+    saturate();
+    switch (overflow_policy_) {
+        case OverflowPolicy::Block: {
+            if (!may_block) {
+                count_overflow(dropped_newest_);
+                return false;
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(block_timeout_ms_);
+            while (wait_for_space([this] { return ring_->size() < ring_->capacity(); }, deadline)) {
+                if (ring_->try_push(std::move(record))) {
+                    notify_consumer();
+                    return true;
+                }
+            }
+            count_overflow(block_timeouts_);
+            return false;
+        }
+        case OverflowPolicy::DropNewest:
+            count_overflow(dropped_newest_);
+            return false;
+        case OverflowPolicy::Sample:
+            if (!sample_keep()) {
+                count_overflow(sampled_out_);
+                return false;
+            }
+            [[fallthrough]];
+        case OverflowPolicy::DropOldest: {
+            // Other producers may refill the slot we free; give up after
+            // a few rounds rather than evicting without bound.
+            LogRecord victim;
+            for (int attempt = 0; attempt < 4; ++attempt) {
+                if (ring_->try_pop(victim)) {
+                    budget_.release(budget_.active() ? TenantQueue::cost(victim) : 0);
+                    count_overflow(evicted_oldest_);
+                }
+                if (ring_->try_push(std::move(record))) {
+                    notify_consumer();
+                    return true;
+                }
+            }
+            count_overflow(dropped_newest_);
+            return false;
+        }
+    }
+    return false;
+}
+
+bool AsyncQueue::push_lane(LogRecord&& record, bool may_block) {
+    Lane* lane = local_lane();
+    if (lane->ring.try_push(std::move(record))) {
+        if (watching_rise()) {
+            check_rising(lane->ring.size(), lane->ring.capacity());
+        }
+        notify_consumer();
+        return true;
+    }
+    saturate();
+
+    auto drop = [&](std::atomic<uint64_t>& counter) {
+        lane->dropped.store(lane->dropped.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        count_overflow(counter, lane->id);
+        return false;
+    };
+
+    switch (overflow_policy_) {
+        case OverflowPolicy::Sample:
+            if (!sample_keep()) {
+                return drop(sampled_out_);
+            }
+            [[fallthrough]];
+        case OverflowPolicy::Block: {
+            if (!may_block) {
+                return drop(dropped_newest_);
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(block_timeout_ms_);
+            while (wait_for_space([lane] { return lane->ring.size() < lane->ring.capacity(); }, deadline)) {
+                if (lane->ring.try_push(std::move(record))) {
+                    notify_consumer();
+                    return true;
+                }
+            }
+            return drop(block_timeouts_);
+        }
+        case OverflowPolicy::DropNewest:
+        case OverflowPolicy::DropOldest:
+            return drop(dropped_newest_);
+    }
+    return false;
+}
+
+bool AsyncQueue::wait_for_space(const std::function<bool()>& has_space,
+                                std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    blocked_producers_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool ok = space_cv_.wait_until(lock, deadline, [&] {
+        return has_space() || shutdown_.load(std::memory_order_acquire);
+    });
+    blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+    return ok && !shutdown_.load(std::memory_order_acquire);
+}
+
+void AsyncQueue::notify_producers() {
+    // Pairs with the fence in wait_for_space()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (blocked_producers_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+    }
+    space_cv_.notify_all();
+}
+
+bool AsyncQueue::sample_keep() {
+    return sample_counter_.fetch_add(1, std::memory_order_relaxed) % sample_rate_ == 0;
+}
+
+void AsyncQueue::count_overflow(std::atomic<uint64_t>& counter, uint64_t lane_id) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    if (drop_callback_) {
+        drop_callback_(1, lane_id);
+    }
+}
+
+void AsyncQueue::saturate() {
+    if (high_permille_ == 0) {
+        return;
+    }
+    Backpressure current = pressure_.load(std::memory_order_relaxed);
+    while (current != Backpressure::Saturated) {
+        if (pressure_.compare_exchange_weak(current, Backpressure::Saturated, std::memory_order_relaxed)) {
+            if (pressure_callback_) {
+                pressure_callback_(current, Backpressure::Saturated);
+            }
+            return;
+        }
+    }
+}
+
+void AsyncQueue::check_falling(size_t depth, size_t capacity) {
+    const Backpressure current = pressure_.load(std::memory_order_relaxed);
+    if (current == Backpressure::Normal || capacity == 0) {
+        return;
+    }
+    if (depth * 1000 <= capacity * low_permille_) {
+        transition(current, Backpressure::Normal);
+    } else if (current == Backpressure::Saturated && depth * 1000 < capacity * high_permille_) {
+        transition(current, Backpressure::Elevated);
+    }
+}
+
+// Only the thread whose CAS wins reports the change
+void AsyncQueue::transition(Backpressure from, Backpressure to) {
+    if (pressure_.compare_exchange_strong(from, to, std::memory_order_relaxed) && pressure_callback_) {
+        pressure_callback_(from, to);
+    }
+}
+
+OverflowStats AsyncQueue::overflow_stats() const {
+    OverflowStats stats;
+    stats.dropped_newest = dropped_newest_.load(std::memory_order_relaxed);
+    stats.evicted_oldest = evicted_oldest_.load(std::memory_order_relaxed);
+    stats.sampled_out = sampled_out_.load(std::memory_order_relaxed);
+    stats.block_timeouts = block_timeouts_.load(std::memory_order_relaxed);
+    stats.over_budget = over_budget_.load(std::memory_order_relaxed);
+    stats.over_quota = over_quota_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+AsyncQueue::Lane* AsyncQueue::local_lane() {
+    auto& entries = thread_lanes.entries;
+    for (auto& entry : entries) {
+        if (entry.first == queue_id_) {
+            return entry.second.get();
+        }
+    }
+
+    // First push from this thread: drop lanes of dead queues, then register.
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const auto& entry) {
+        return entry.second->detached.load(std::memory_order_acquire);
+    }), entries.end());
+
+    std::shared_ptr<Lane> lane;
+    {
+        std::lock_guard<std::mutex> lock(lanes_mtx_);
+        lane = std::make_shared<Lane>(next_lane_id_++, lane_capacity_);
+        lanes_.push_back(lane);
+        for (auto& slot : crash_lanes_) {
+            if (!slot.load(std::memory_order_relaxed)) {
+                slot.store(lane.get(), std::memory_order_release);
+                break;
+            }
+        }
+        lanes_version_.fetch_add(1, std::memory_order_release);
+    }
+    entries.emplace_back(queue_id_, lane);
+    return lane.get();
+}
+
+uint64_t AsyncQueue::current_lane_id() const {
+    for (const auto& entry : thread_lanes.entries) {
+        if (entry.first == queue_id_) {
+            return entry.second->id;
+        }
+    }
+    return 0;
+}
+
+std::vector<LaneStats> AsyncQueue::lane_stats() const {
+    std::vector<LaneStats> stats;
+    std::lock_guard<std::mutex> lock(lanes_mtx_);
+    stats.reserve(lanes_.size());
+    for (const auto& lane : lanes_) {
+        LaneStats s;
+        s.lane_id = lane->id;
+        s.depth = lane->ring.size();
+        s.dropped = lane->dropped.load(std::memory_order_relaxed);
+        s.retired = lane->retired.load(std::memory_order_acquire);
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void AsyncQueue::notify_consumer() {
+    // Pairs with the fence in pop(): either we see the waiting consumer,
+    // or the consumer sees our record before it parks.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_consumers_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
     {
         std::lock_guard<std::mutex> lock(mtx_);
-        queue_.push(std::move(record));
     }
     cv_.notify_one();
-    return true;
+}
+
+bool AsyncQueue::spin_once(size_t& round, std::chrono::steady_clock::time_point deadline) {
+    if (wait_strategy_ == WaitStrategy::Park) {
+        return false;
+    }
+    if (round < spin_iterations_) {
+        cpu_relax();
+        ++round;
+        return true;
+    }
+    if (round < spin_iterations_ + yield_iterations_) {
+        std::this_thread::yield();
+        ++round;
+        return true;
+    }
+    if (wait_strategy_ == WaitStrategy::Spin) {
+        ++round;
+        if ((round & 1023) == 0 && std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        cpu_relax();
+        return true;
+    }
+    return false;
+}
+
+void AsyncQueue::count_wakeup(size_t round) {
+    if (round == 0) {
+        return;
+    }
+    if (round > spin_iterations_ && round <= spin_iterations_ + yield_iterations_) {
+        yield_wakeups_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        spin_wakeups_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+WaitStats AsyncQueue::wait_stats() const {
+    WaitStats stats;
+    stats.spin_budget = wait_strategy_ == WaitStrategy::Park ? 0 : spin_iterations_ + yield_iterations_;
+    stats.spin_wakeups = spin_wakeups_.load(std::memory_order_relaxed);
+    stats.yield_wakeups = yield_wakeups_.load(std::memory_order_relaxed);
+    stats.parks = parks_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 bool AsyncQueue::pop(LogRecord& record) {
-    std::unique_lock<std::mutex> lock(mtx_);
-    
-    cv_.wait(lock, [this] {
-        return !queue_.empty() || shutdown_.load(std::memory_order_acquire);
+    const bool popped = pop_record(record);
+    if (popped && budget_.active()) {
+        budget_.release(TenantQueue::cost(record));
+    }
+    return popped;
+}
+
+bool AsyncQueue::pop_record(LogRecord& record) {
+    constexpr auto forever = std::chrono::steady_clock::time_point::max();
+    size_t round = 0;
+
+    if (backend_ == QueueBackend::Mutex) {
+        while (approx_size_.load(std::memory_order_relaxed) == 0 && !has_priority() &&
+               !shutdown_.load(std::memory_order_acquire) && spin_once(round, forever)) {
+        }
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (storage_empty() && !shutdown_.load(std::memory_order_acquire)) {
+            parks_.fetch_add(1, std::memory_order_relaxed);
+            waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv_.wait(lock, [this] {
+                return !storage_empty() || shutdown_.load(std::memory_order_acquire);
+            });
+            waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        } else {
+            count_wakeup(round);
+        }
+
+        if (pop_priority(&record, 1) == 1) {
+            if (storage_empty()) {
+                drain_cv_.notify_all();
+            }
+            return true;
+        }
+        if (!try_pop_locked(record)) {
+            return false;
+        }
+        const size_t remaining = queue_.size();
+        lock.unlock();
+        check_falling(remaining, capacity_);
+        return true;
+    }
+
+    for (;;) {
+        if (try_pop_lock_free(&record, 1) == 1) {
+            count_wakeup(round);
+            after_lock_free_pop(1);
+            return true;
+        }
+        if (shutdown_.load(std::memory_order_acquire) && storage_empty()) {
+            return false;
+        }
+        if (round == 0 && backend_ == QueueBackend::PerThreadLanes) {
+            reclaim_retired_lanes();
+        }
+        if (spin_once(round, forever)) {
+            continue;
+        }
+        round = 0;
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (storage_empty() && !shutdown_.load(std::memory_order_acquire)) {
+            parks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cv_.wait(lock, [this] {
+            return !storage_empty() || shutdown_.load(std::memory_order_acquire);
+        });
+        waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool AsyncQueue::pop_bulk(std::vector<LogRecord>& out, size_t max_records,
+                          std::chrono::milliseconds timeout) {
+    // The consumer keeps what it took in out until its next call, so a
+    // crash handler looks there too
+    std::atomic<const std::vector<LogRecord>*>* tracked = nullptr;
+    for (auto& slot : crash_batches_) {
+        if (slot.load(std::memory_order_relaxed) == &out) {
+            tracked = &slot;
+            break;
+        }
+    }
+    for (size_t i = 0; !tracked && i < std::size(crash_batches_); ++i) {
+        const std::vector<LogRecord>* empty = nullptr;
+        if (crash_batches_[i].compare_exchange_strong(empty, &out, std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+            tracked = &crash_batches_[i];
+        }
+    }
+    const size_t base = out.size();
+    const bool more = pop_bulk_records(out, max_records, timeout);
+    if (budget_.active()) {
+        size_t bytes = 0;
+        for (size_t i = base; i < out.size(); ++i) {
+            bytes += TenantQueue::cost(out[i]);
+        }
+        budget_.release(bytes);
+    }
+    if (!more && tracked) {
+        tracked->store(nullptr, std::memory_order_release);
+    }
+    return more;
+}
+
+bool AsyncQueue::pop_bulk_records(std::vector<LogRecord>& out, size_t max_records,
+                                  std::chrono::milliseconds timeout) {
+    if (max_records == 0) {
+        max_records = 1;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    size_t round = 0;
+
+    if (backend_ == QueueBackend::Mutex) {
+        while (approx_size_.load(std::memory_order_relaxed) == 0 && !has_priority() &&
+               !shutdown_.load(std::memory_order_acquire) && spin_once(round, deadline)) {
+        }
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (storage_empty() && !shutdown_.load(std::memory_order_acquire)) {
+            parks_.fetch_add(1, std::memory_order_relaxed);
+            waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv_.wait_until(lock, deadline, [this] {
+                return !storage_empty() || shutdown_.load(std::memory_order_acquire);
+            });
+            waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        } else {
+            count_wakeup(round);
+        }
+
+        // The priority lane always goes first
+        const size_t base = out.size();
+        out.resize(base + max_records);
+        size_t popped = pop_priority(out.data() + base, max_records);
+        out.resize(base + popped);
+        while (!queue_.empty() && popped < max_records) {
+            out.push_back(std::move(queue_.front()));
+            queue_.pop();
+            ++popped;
+        }
+        if (popped > 0) {
+            const size_t remaining = queue_.size();
+            approx_size_.store(remaining, std::memory_order_relaxed);
+            if (storage_empty()) {
+                drain_cv_.notify_all();
+            }
+            if (blocked_producers_.load(std::memory_order_relaxed) > 0) {
+                space_cv_.notify_all();
+            }
+            lock.unlock();
+            check_falling(remaining, capacity_);
+        }
+        return popped > 0 || !shutdown_.load(std::memory_order_acquire);
+    }
+
+    const size_t base = out.size();
+    for (;;) {
+        out.resize(base + max_records);
+        size_t popped = try_pop_lock_free(out.data() + base, max_records);
+        out.resize(base + popped);
+        if (popped > 0) {
+            count_wakeup(round);
+            after_lock_free_pop(popped);
+            return true;
+        }
+        if (shutdown_.load(std::memory_order_acquire) && storage_empty()) {
+            return false;
+        }
+        if (round == 0 && backend_ == QueueBackend::PerThreadLanes) {
+            reclaim_retired_lanes();
+        }
+        if (spin_once(round, deadline)) {
+            continue;
+        }
+        round = 0;
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (storage_empty() && !shutdown_.load(std::memory_order_acquire)) {
+            parks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        bool ready = cv_.wait_until(lock, deadline, [this] {
+            return !storage_empty() || shutdown_.load(std::memory_order_acquire);
+        });
+        waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        if (!ready) {
+            return true;
+        }
+    }
+}
+
+size_t AsyncQueue::pop_priority(LogRecord* out, size_t max_records) {
+    size_t popped = 0;
+    if (priority_ring_) {
+        while (popped < max_records && priority_ring_->try_pop(out[popped])) {
+            ++popped;
+        }
+    }
+    return popped;
+}
+
+bool AsyncQueue::has_priority() const {
+    return priority_ring_ && !priority_ring_->empty();
+}
+
+size_t AsyncQueue::try_pop_lock_free(LogRecord* out, size_t max_records) {
+    size_t popped = pop_priority(out, max_records);
+    if (popped == max_records) {
+        return popped;
+    }
+    out += popped;
+    max_records -= popped;
+
+    if (backend_ == QueueBackend::PerThreadLanes) {
+        return popped + pop_from_lanes(out, max_records);
+    }
+
+    size_t from_ring = 0;
+    while (from_ring < max_records && ring_->try_pop(out[from_ring])) {
+        ++from_ring;
+    }
+    return popped + from_ring;
+}
+
+void AsyncQueue::after_lock_free_pop(size_t popped) {
+    if (popped == 0) {
+        return;
+    }
+    if (ring_) {
+        check_falling(ring_->size(), ring_->capacity());
+    }
+    notify_producers();
+    if (shutdown_.load(std::memory_order_acquire) && storage_empty()) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        drain_cv_.notify_all();
+    }
+}
+
+size_t AsyncQueue::pop_from_lanes(LogRecord* out, size_t max_records) {
+    std::lock_guard<std::mutex> lock(consumer_mtx_);
+
+    uint64_t version = lanes_version_.load(std::memory_order_acquire);
+    if (version != consumer_lanes_version_) {
+        std::lock_guard<std::mutex> lanes_lock(lanes_mtx_);
+        consumer_lanes_ = lanes_;
+        consumer_lanes_version_ = lanes_version_.load(std::memory_order_relaxed);
+    }
+
+    size_t popped = 0;
+    while (popped < max_records) {
+        // Merge: take the oldest head record across all lanes
+        Lane* best = nullptr;
+        LogRecord* best_record = nullptr;
+        for (auto& lane : consumer_lanes_) {
+            LogRecord* head = lane->ring.front();
+            if (head && (!best_record || head->timestamp < best_record->timestamp)) {
+                best = lane.get();
+                best_record = head;
+            }
+        }
+
+        if (!best) {
+            break;
+        }
+
+        out[popped++] = std::move(*best_record);
+        best->ring.pop();
+    }
+    if (popped > 0 && pressure_.load(std::memory_order_relaxed) != Backpressure::Normal) {
+        size_t fullest = 0;
+        for (const auto& lane : consumer_lanes_) {
+            fullest = std::max(fullest, lane->ring.size());
+        }
+        check_falling(fullest, consumer_lanes_.front()->ring.capacity());
+    }
+    return popped;
+}
+
+bool AsyncQueue::lanes_empty() const {
+    std::lock_guard<std::mutex> lock(lanes_mtx_);
+    for (const auto& lane : lanes_) {
+        if (!lane->ring.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AsyncQueue::reclaim_retired_lanes() {
+    std::lock_guard<std::mutex> lock(lanes_mtx_);
+    // retired is set after the thread's last push, so retired-then-empty
+    // means the lane can never receive another record.
+    auto it = std::remove_if(lanes_.begin(), lanes_.end(), [this](const std::shared_ptr<Lane>& lane) {
+        if (!lane->retired.load(std::memory_order_acquire) || !lane->ring.empty()) {
+            return false;
+        }
+        for (auto& slot : crash_lanes_) {
+            if (slot.load(std::memory_order_relaxed) == lane.get()) {
+                slot.store(nullptr, std::memory_order_release);
+            }
+        }
+        return true;
     });
-    
+    if (it != lanes_.end()) {
+        lanes_.erase(it, lanes_.end());
+        lanes_version_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+namespace {
+
+void write_crash_line(const LogRecord& record, CrashWriter& out) {
+    if (record.fence) {
+        return;
+    }
+    out.write("[");
+    out.write(level_name(record.level));
+    out.write("] [");
+    out.write(record.logger_name);
+    out.write("] ");
+#if XLOG_HAS_FMT
+    if (record.deferred) {
+        // The arguments are still encoded; the format string is all the
+        // handler can safely show
+        out.write(record.deferred->format);
+        out.write(" (arguments not formatted)\n");
+        return;
+    }
+#endif
+    out.write(record.message);
+    out.write("\n");
+}
+
+}
+
+void AsyncQueue::drain_for_crash(const void* source, CrashWriter& out) {
+    const auto& queue = *static_cast<const AsyncQueue*>(source);
+    bool headed = false;
+    auto visit = [&](const LogRecord& record) {
+        if (!headed) {
+            out.write("[Zyrnix] queued:\n");
+            headed = true;
+        }
+        write_crash_line(record, out);
+    };
+    // Batches the consumers took are older than anything still queued
+    for (const auto& slot : queue.crash_batches_) {
+        const std::vector<LogRecord>* batch = slot.load(std::memory_order_acquire);
+        if (batch && !batch->empty()) {
+            out.write("[Zyrnix] taken by the consumer, possibly written out already:\n");
+            for (const LogRecord& record : *batch) {
+                write_crash_line(record, out);
+            }
+        }
+    }
+    if (queue.priority_ring_) {
+        queue.priority_ring_->for_each_queued(visit);
+    }
+    switch (queue.backend_) {
+        case QueueBackend::LockFreeRing:
+            queue.ring_->for_each_queued(visit);
+            break;
+        case QueueBackend::PerThreadLanes:
+            for (const auto& slot : queue.crash_lanes_) {
+                if (const Lane* lane = slot.load(std::memory_order_acquire)) {
+                    lane->ring.for_each_queued(visit);
+                }
+            }
+            break;
+        default:
+            queue.queue_.for_each_queued(visit);
+            break;
+    }
+}
+
+bool AsyncQueue::try_pop_locked(LogRecord& record) {
     if (queue_.empty()) {
         return false;
     }
     
     record = std::move(queue_.front());
     queue_.pop();
+    approx_size_.store(queue_.size(), std::memory_order_relaxed);
     
+    if (blocked_producers_.load(std::memory_order_relaxed) > 0) {
+        space_cv_.notify_one();
+    }
 
     if (queue_.empty()) {
         drain_cv_.notify_all();
@@ -48,19 +1027,82 @@ bool AsyncQueue::pop(LogRecord& record) {
     return true;
 }
 
+bool AsyncQueue::storage_empty() const {
+    if (has_priority()) {
+        return false;
+    }
+    switch (backend_) {
+        case QueueBackend::LockFreeRing: return ring_->empty();
+        case QueueBackend::PerThreadLanes: return lanes_empty();
+        default: return queue_.empty();
+    }
+}
+
+size_t AsyncQueue::drain_and_count() {
+    size_t dropped = 0;
+    size_t bytes = 0;
+    LogRecord discarded;
+    auto discard = [&] {
+        bytes += TenantQueue::cost(discarded);
+        ++dropped;
+    };
+    if (priority_ring_) {
+        while (priority_ring_->try_pop(discarded)) {
+            discard();
+        }
+    }
+    if (backend_ == QueueBackend::PerThreadLanes) {
+        while (pop_from_lanes(&discarded, 1) == 1) {
+            discard();
+        }
+    } else if (ring_) {
+        while (ring_->try_pop(discarded)) {
+            discard();
+        }
+    } else {
+        while (!queue_.empty()) {
+            bytes += TenantQueue::cost(queue_.front());
+            ++dropped;
+            queue_.pop();
+        }
+        approx_size_.store(0, std::memory_order_relaxed);
+    }
+    budget_.release(bytes);
+    return dropped;
+}
+
 bool AsyncQueue::empty() const {
+    if (backend_ != QueueBackend::Mutex) {
+        return storage_empty();
+    }
     std::lock_guard<std::mutex> lock(mtx_);
-    return queue_.empty();
+    return storage_empty();
 }
 
 size_t AsyncQueue::size() const {
+    const size_t priority = priority_ring_ ? priority_ring_->size() : 0;
+    if (ring_) {
+        return priority + ring_->size();
+    }
+    if (backend_ == QueueBackend::PerThreadLanes) {
+        size_t total = 0;
+        std::lock_guard<std::mutex> lock(lanes_mtx_);
+        for (const auto& lane : lanes_) {
+            total += lane->ring.size();
+        }
+        return priority + total;
+    }
     std::lock_guard<std::mutex> lock(mtx_);
-    return queue_.size();
+    return priority + queue_.size();
 }
 
 bool AsyncQueue::shutdown(bool wait_for_drain) {
     shutdown_.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+    }
     cv_.notify_all();
+    space_cv_.notify_all();
     
     if (!wait_for_drain) {
         return empty();
@@ -70,14 +1112,11 @@ bool AsyncQueue::shutdown(bool wait_for_drain) {
     
     bool drained = drain_cv_.wait_for(lock, 
         std::chrono::milliseconds(shutdown_timeout_ms_),
-        [this] { return queue_.empty(); }
+        [this] { return storage_empty(); }
     );
     
     if (!drained) {
-        dropped_count_.store(queue_.size(), std::memory_order_release);
-        while (!queue_.empty()) {
-            queue_.pop();
-        }
+        dropped_count_.store(drain_and_count(), std::memory_order_release);
     }
     
     return drained;
@@ -0,0 +1,46 @@
+#include "Zyrnix/async/record_pool.hpp"
+#include "Zyrnix/async/mpmc_ring.hpp"
+
+namespace Zyrnix {
+
+RecordPool::RecordPool(size_t capacity)
+    : free_(std::make_unique<MpmcRing<LogRecord>>(capacity)) {
+}
+
+RecordPool::~RecordPool() = default;
+
+bool RecordPool::acquire(LogRecord& out) {
+    if (free_->try_pop(out)) {
+        return true;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void RecordPool::release(LogRecord&& record) {
+    // clear() keeps string capacity and the map's bucket array
+    record.logger_name.clear();
+    record.message.clear();
+    record.fields.clear();
+    record.fence.reset();
+    record.site = nullptr;
+    record.deferred = nullptr;
+    record.stack.reset();
+    record.backtrace = false;
+    record.child_level = false;
+    // A full pool simply lets the record go
+    free_->try_push(std::move(record));
+}
+
+void RecordPool::release(std::vector<LogRecord>& batch) {
+    for (auto& record : batch) {
+        release(std::move(record));
+    }
+    batch.clear();
+}
+
+size_t RecordPool::capacity() const {
+    return free_->capacity();
+}
+
+}
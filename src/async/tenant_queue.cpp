@@ -0,0 +1,169 @@
+#include "Zyrnix/async/async_queue.hpp"
+#include <algorithm>
+
+namespace Zyrnix {
+
+void TenantQueue::configure(const TenantOptions& options, std::shared_ptr<TenantMetrics> metrics) {
+    field_ = options.field;
+    quantum_ = std::max<size_t>(options.quantum_bytes, 1);
+    quota_ = options.quota_bytes;
+    max_tenants_ = std::max<size_t>(options.max_tenants, 1);
+    metrics_ = std::move(metrics);
+    if (metrics_) {
+        metrics_->set_quota_bytes(quota_);
+    }
+}
+
+TenantQueue::Tenant* TenantQueue::tenant_of(const LogRecord& record) {
+    if (field_.empty()) {
+        return nullptr;
+    }
+    const FieldValue* value = record.fields.find(field_);
+    std::string_view key = value ? std::string_view(value->text()) : std::string_view();
+    if (auto it = tenants_.find(key); it != tenants_.end()) {
+        return it->second.get();
+    }
+    if (tenants_.size() - (shared_ ? 1 : 0) >= max_tenants_) {
+        key = {};
+    }
+    if (key.empty() && shared_) {
+        return shared_;
+    }
+    auto tenant = std::make_unique<Tenant>();
+    tenant->key.assign(key);
+    if (metrics_) {
+        tenant->counters = metrics_->tenant(tenant->key);
+    }
+    Tenant* made = tenant.get();
+    tenants_.emplace(made->key, std::move(tenant));
+    if (key.empty()) {
+        shared_ = made;
+    }
+    return made;
+}
+
+void TenantQueue::refuse(Tenant* tenant) {
+    if (tenant && tenant->counters) {
+        tenant->counters->over_quota.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TenantQueue::push(Tenant* tenant, LogRecord&& record) {
+    ++size_;
+    if (!tenant) {
+        single_.push(std::move(record));
+        return;
+    }
+    tenant->bytes += cost(record);
+    tenant->records.push(std::move(record));
+    if (!tenant->active) {
+        link_back(tenant);
+        tenant->active = true;
+    }
+    if (tenant->counters) {
+        tenant->counters->enqueued.fetch_add(1, std::memory_order_relaxed);
+        tenant->counters->queued.store(tenant->records.size(), std::memory_order_relaxed);
+        tenant->counters->queued_bytes.store(tenant->bytes, std::memory_order_relaxed);
+    }
+}
+
+LogRecord& TenantQueue::front() {
+    if (!fair()) {
+        return single_.front();
+    }
+    for (;;) {
+        Tenant* tenant = head_;
+        LogRecord& next = tenant->records.front();
+        front_cost_ = cost(next);
+        // Alone, it has nobody to yield its turn to
+        if (tenant == tail_) {
+            return next;
+        }
+        if (!tenant->in_turn) {
+            tenant->deficit += quantum_;
+            tenant->in_turn = true;
+        }
+        if (front_cost_ <= tenant->deficit) {
+            return next;
+        }
+        // Turn over; what it has left carries into its next one
+        tenant->in_turn = false;
+        unlink(tenant);
+        link_back(tenant);
+    }
+}
+
+void TenantQueue::pop() {
+    if (!fair()) {
+        single_.pop();
+        --size_;
+        return;
+    }
+    Tenant* tenant = head_;
+    tenant->deficit -= std::min(tenant->deficit, front_cost_);
+    remove_front(tenant, front_cost_);
+}
+
+LogRecord& TenantQueue::victim() {
+    if (!fair()) {
+        return single_.front();
+    }
+    victim_ = head_;
+    for (Tenant* tenant = head_->next; tenant; tenant = tenant->next) {
+        if (tenant->bytes > victim_->bytes) {
+            victim_ = tenant;
+        }
+    }
+    LogRecord& oldest = victim_->records.front();
+    front_cost_ = cost(oldest);
+    return oldest;
+}
+
+void TenantQueue::pop_victim() {
+    if (!fair()) {
+        single_.pop();
+        --size_;
+        return;
+    }
+    if (victim_->counters) {
+        victim_->counters->evicted.fetch_add(1, std::memory_order_relaxed);
+    }
+    remove_front(victim_, front_cost_);
+}
+
+void TenantQueue::remove_front(Tenant* tenant, size_t bytes) {
+    tenant->records.pop();
+    tenant->bytes -= std::min(tenant->bytes, bytes);
+    --size_;
+    if (tenant->counters) {
+        tenant->counters->queued.store(tenant->records.size(), std::memory_order_relaxed);
+        tenant->counters->queued_bytes.store(tenant->bytes, std::memory_order_relaxed);
+    }
+    if (tenant->records.empty()) {
+        unlink(tenant);
+        tenant->active = false;
+        tenant->in_turn = false;
+        tenant->deficit = 0;
+        tenant->bytes = 0;
+    }
+}
+
+void TenantQueue::link_back(Tenant* tenant) {
+    tenant->prev = tail_;
+    tenant->next = nullptr;
+    if (tail_) {
+        tail_->next = tenant;
+    } else {
+        head_ = tenant;
+    }
+    tail_ = tenant;
+}
+
+void TenantQueue::unlink(Tenant* tenant) {
+    (tenant->prev ? tenant->prev->next : head_) = tenant->next;
+    (tenant->next ? tenant->next->prev : tail_) = tenant->prev;
+    tenant->prev = nullptr;
+    tenant->next = nullptr;
+}
+
+}
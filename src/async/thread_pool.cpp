@@ -1,41 +1,168 @@
 #include "Zyrnix/async/thread_pool.hpp"
-#include "Zyrnix/logger.hpp"
-#include "Zyrnix/log_sink.hpp"
-#include "Zyrnix/async/async_logger.hpp"
+#include "Zyrnix/async/mpmc_ring.hpp"
+#include "Zyrnix/async/work_stealing_deque.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <exception>
+#include <iostream>
+#include <string>
 
 namespace Zyrnix {
 
-ThreadPool::ThreadPool(size_t threads) : running(true) {
-    for (size_t i = 0; i < threads; ++i) {
-        workers.emplace_back([this] { worker(); });
+namespace {
+
+constexpr size_t no_worker = static_cast<size_t>(-1);
+constexpr size_t injected_capacity = 4096;
+constexpr size_t free_capacity = 1024;
+
+struct CurrentWorker {
+    const ThreadPool* pool = nullptr;
+    size_t index = no_worker;
+};
+
+thread_local CurrentWorker current_worker;
+
+}
+
+struct ThreadPool::Worker {
+    WorkStealingDeque<Task*> deque;
+    std::thread thread;
+};
+
+ThreadPool::ThreadPool(size_t threads) {
+    NumaLocalScope numa;
+    injected_ = std::make_unique<MpmcRing<Task*>>(injected_capacity);
+    free_ = std::make_unique<MpmcRing<Task*>>(free_capacity);
+    const size_t count = threads == 0 ? 1 : threads;
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Started once every deque exists, since workers steal from all of them
+    for (size_t i = 0; i < count; ++i) {
+        workers_[i]->thread = std::thread([this, i] { worker(i); });
     }
 }
 
 ThreadPool::~ThreadPool() {
-    running = false;
-    cv.notify_all();
-    for (auto& t : workers) if (t.joinable()) t.join();
+    running_.store(false);
+    wake_seq_.fetch_add(1, std::memory_order_release);
+    wake_seq_.notify_all();
+    for (auto& w : workers_) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+    Task* task = nullptr;
+    while (free_->try_pop(task)) {
+        delete task;
+    }
 }
 
-void ThreadPool::enqueue(std::function<void()> task) {
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        tasks.push(std::move(task));
+void ThreadPool::push(Task&& task) {
+    Task* slot = nullptr;
+    if (!free_->try_pop(slot)) {
+        slot = new Task;
+    }
+    *slot = std::move(task);
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    if (current_worker.pool == this) {
+        workers_[current_worker.index]->deque.push(slot);
+    } else if (!injected_->try_push(std::move(slot))) {
+        std::lock_guard<std::mutex> lock(overflow_mtx_);
+        overflow_.push_back(slot);
+        overflow_size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Pairs with the fence a worker goes through between announcing that
+    // it sleeps and looking for work once more: either it sees the task
+    // or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) > 0) {
+        wake_seq_.fetch_add(1, std::memory_order_release);
+        wake_seq_.notify_one();
     }
-    cv.notify_one();
 }
 
-void ThreadPool::worker() {
-    while (running) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(mtx);
-            cv.wait(lock, [this]{ return !tasks.empty() || !running; });
-            if (!running && tasks.empty()) return;
-            task = std::move(tasks.front());
-            tasks.pop();
+Task* ThreadPool::find_task(size_t self) {
+    Task* task = nullptr;
+    if (self != no_worker && workers_[self]->deque.pop(task)) {
+        return task;
+    }
+    if (injected_->try_pop(task)) {
+        return task;
+    }
+    if (overflow_size_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(overflow_mtx_);
+        if (!overflow_.empty()) {
+            task = overflow_.front();
+            overflow_.pop_front();
+            overflow_size_.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    // Steal, starting next to ourselves so thieves spread over the victims
+    const size_t count = workers_.size();
+    for (size_t k = 1; k <= count; ++k) {
+        const size_t victim = (self + k) % count;
+        if (victim != self && workers_[victim]->deque.steal(task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::run(Task* task) {
+    try {
+        (*task)();
+    } catch (const std::exception& e) {
+        std::cerr << "ThreadPool: task threw: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "ThreadPool: task threw an unknown exception" << std::endl;
+    }
+    task->reset();
+    if (!free_->try_push(std::move(task))) {
+        delete task;
+    }
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pending_.notify_all();
+    }
+}
+
+void ThreadPool::wait_idle() {
+    size_t pending = pending_.load(std::memory_order_acquire);
+    while (pending != 0) {
+        pending_.wait(pending, std::memory_order_acquire);
+        pending = pending_.load(std::memory_order_acquire);
+    }
+}
+
+bool ThreadPool::in_worker() const {
+    return current_worker.pool == this;
+}
+
+void ThreadPool::worker(size_t index) {
+    init_background_thread(("xlog-pool-" + std::to_string(index)).c_str());
+    current_worker = CurrentWorker{this, index};
+    for (;;) {
+        if (Task* task = find_task(index)) {
+            run(task);
+            continue;
+        }
+
+        const uint32_t seq = wake_seq_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Task* task = find_task(index);
+        if (!task) {
+            if (!running_.load()) {
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            wake_seq_.wait(seq, std::memory_order_acquire);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        if (task) {
+            run(task);
         }
-        task();
     }
 }
 
@@ -0,0 +1,80 @@
+#include "Zyrnix/backtrace_ring.hpp"
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+namespace Zyrnix {
+
+struct BacktraceRing::Slot {
+    std::atomic<bool> busy{false};
+    uint64_t index = UINT64_MAX;  // Which push the slot holds
+    LogLevel level = LogLevel::Trace;
+    std::chrono::system_clock::time_point when;
+    uint64_t thread_id = 0;
+    const LogSite* site = nullptr;
+    const DeferredSite* deferred = nullptr;
+    std::string message;
+
+    void lock() {
+        while (busy.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    void unlock() { busy.store(false, std::memory_order_release); }
+};
+
+BacktraceRing::BacktraceRing(size_t capacity) {
+    const size_t slots = std::bit_ceil(std::max<size_t>(capacity, 1));
+    mask_ = slots - 1;
+    slots_ = std::make_unique<Slot[]>(slots);
+}
+
+BacktraceRing::~BacktraceRing() = default;
+
+void BacktraceRing::push(LogLevel level, std::string_view message, const LogSite* site,
+                         const DeferredSite* deferred, std::chrono::system_clock::time_point when,
+                         uint64_t thread_id) const {
+    const uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+    slot.lock();
+    slot.index = index;
+    slot.level = level;
+    slot.when = when;
+    slot.thread_id = thread_id;
+    slot.site = site;
+    slot.deferred = deferred;
+    slot.message.assign(message);
+    slot.unlock();
+}
+
+std::vector<LogRecord> BacktraceRing::take(const std::string& logger_name) const {
+    std::lock_guard<std::mutex> lock(take_mtx_);
+    const uint64_t end = head_.load(std::memory_order_acquire);
+    const uint64_t begin = std::max(tail_, end > capacity() ? end - capacity() : 0);
+    tail_ = end;
+
+    std::vector<LogRecord> records;
+    records.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t index = begin; index < end; ++index) {
+        Slot& slot = slots_[index & mask_];
+        slot.lock();
+        // A slot still being written for this index, or already reused by
+        // a later push, is skipped
+        if (slot.index == index) {
+            LogRecord record;
+            record.logger_name = logger_name;
+            record.level = slot.level;
+            record.message = slot.message;
+            record.timestamp = slot.when;
+            record.thread_id = slot.thread_id;
+            record.site = slot.site;
+            record.deferred = slot.deferred;
+            record.backtrace = true;
+            records.push_back(std::move(record));
+        }
+        slot.unlock();
+    }
+    return records;
+}
+
+}
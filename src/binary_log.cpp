@@ -0,0 +1,405 @@
+#include "Zyrnix/binary_log.hpp"
+#include <array>
+#include <charconv>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define XLOG_BINLOG_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Zyrnix {
+namespace binlog {
+
+namespace {
+
+// Slicing-by-8 tables for the reflected Castagnoli polynomial, the same
+// CRC-32C as the SSE4.2 crc32 instruction computes
+constexpr std::array<std::array<uint32_t, 256>, 8> make_crc_tables() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+        }
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (size_t t = 1; t < 8; ++t) {
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr auto crc_tables = make_crc_tables();
+
+uint32_t crc32c_scalar(const unsigned char* p, size_t size, uint32_t crc) {
+    while (size >= 8) {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, p, 4);
+        std::memcpy(&high, p + 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        low = __builtin_bswap32(low);
+        high = __builtin_bswap32(high);
+#endif
+        low ^= crc;
+        crc = crc_tables[7][low & 0xFF] ^ crc_tables[6][(low >> 8) & 0xFF] ^
+              crc_tables[5][(low >> 16) & 0xFF] ^ crc_tables[4][low >> 24] ^
+              crc_tables[3][high & 0xFF] ^ crc_tables[2][(high >> 8) & 0xFF] ^
+              crc_tables[1][(high >> 16) & 0xFF] ^ crc_tables[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ crc_tables[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(XLOG_BINLOG_X86)
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(const unsigned char* p, size_t size, uint32_t crc) {
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (size--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+using CrcFn = uint32_t (*)(const unsigned char*, size_t, uint32_t);
+
+CrcFn select_crc() {
+#if defined(XLOG_BINLOG_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32c_sse42;
+    }
+#endif
+    return crc32c_scalar;
+}
+
+const CrcFn crc_kernel = select_crc();
+
+constexpr size_t max_varint = 10;
+constexpr size_t max_head = 2 + 7 * max_varint;  // Kind, level and up to seven varints
+
+char* put_varint(char* p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<char>(value);
+    return p;
+}
+
+void put_varint(std::string& out, uint64_t value) {
+    char bytes[max_varint];
+    out.append(bytes, static_cast<size_t>(put_varint(bytes, value) - bytes));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void put_u32(char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+uint32_t get_u32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Only values that print back exactly the same are stored as integers
+bool as_integer(std::string_view text, int64_t& value) {
+    if (text.empty() || text.size() > 20 || (text[0] == '0' && text.size() > 1) ||
+        (text[0] == '-' && (text.size() == 1 || text[1] == '0'))) {
+        return false;
+    }
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+
+}
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+    return ~crc_kernel(static_cast<const unsigned char*>(data), size, ~crc);
+}
+
+uint32_t BlockWriter::intern(std::string_view text) {
+    auto it = strings_.find(text);
+    if (it != strings_.end()) {
+        return it->second;
+    }
+    const uint32_t id = static_cast<uint32_t>(strings_.size());
+    strings_.emplace(std::string(text), id);
+    put_varint(payload_, text.size() + 1);
+    payload_.push_back(static_cast<char>(Entry::String));
+    payload_.append(text);
+    return id;
+}
+
+void BlockWriter::add(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+                      std::string_view logger_name, const LogSite* site, std::string_view message) {
+    // No fields means nothing can be interned mid-record, so the record
+    // goes straight into the payload
+    char head[max_head];
+    const size_t head_size = encode_head(head, timestamp, level, thread_id, logger_name, site, message.size());
+    put_varint(payload_, head_size + message.size() + 1);
+    payload_.append(head, head_size);
+    payload_.append(message);
+    payload_.push_back(0);  // Field count
+    ++records_;
+}
+
+void BlockWriter::begin_record(std::chrono::system_clock::time_point timestamp, LogLevel level,
+                               uint64_t thread_id, std::string_view logger_name, const LogSite* site,
+                               std::string_view message, size_t field_count) {
+    char head[max_head];
+    entry_.assign(head, encode_head(head, timestamp, level, thread_id, logger_name, site, message.size()));
+    entry_.append(message);
+    put_varint(entry_, field_count);
+}
+
+size_t BlockWriter::encode_head(char* head, std::chrono::system_clock::time_point timestamp, LogLevel level,
+                                uint64_t thread_id, std::string_view logger_name, const LogSite* site,
+                                size_t message_size) {
+    // Strings first, so their definitions precede the record using them
+    if (last_logger_id_ == no_string || logger_name != last_logger_) {
+        last_logger_.assign(logger_name);
+        last_logger_id_ = intern(logger_name);
+    }
+    uint32_t file_id = 0;
+    uint32_t function_id = 0;
+    if (site) {
+        auto site_id = [this](const char* text) {
+            auto it = site_strings_.find(text);
+            if (it == site_strings_.end()) {
+                it = site_strings_.emplace(text, intern(text ? text : "")).first;
+            }
+            return it->second;
+        };
+        file_id = site_id(site->file);
+        function_id = site_id(site->function);
+    }
+
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    char* p = head;
+    *p++ = static_cast<char>(Entry::Record);
+    *p++ = static_cast<char>(level);
+    p = put_varint(p, zigzag(ns - previous_ns_));
+    previous_ns_ = ns;
+    p = put_varint(p, thread_id);
+    p = put_varint(p, last_logger_id_);
+    if (site) {
+        p = put_varint(p, uint64_t{file_id} + 1);
+        p = put_varint(p, function_id);
+        p = put_varint(p, site->line);
+    } else {
+        p = put_varint(p, 0);
+    }
+    p = put_varint(p, message_size);
+    return static_cast<size_t>(p - head);
+}
+
+void BlockWriter::add_field(std::string_view key, const FieldValue& value) {
+    // intern() may append a definition to the payload, never to entry_
+    put_varint(entry_, intern(key));
+    const auto type = static_cast<uint8_t>(value.type());
+    const std::string& text = value.text();
+    int64_t integer;
+    if (value.type() == FieldType::Bool) {
+        entry_.push_back(static_cast<char>(type | packed_field));
+        put_varint(entry_, text == "true" ? 1 : 0);
+    } else if (value.type() != FieldType::Float && as_integer(text, integer)) {
+        entry_.push_back(static_cast<char>(type | packed_field));
+        put_varint(entry_, zigzag(integer));
+    } else {
+        entry_.push_back(static_cast<char>(type));
+        put_varint(entry_, text.size());
+        entry_.append(text);
+    }
+}
+
+void BlockWriter::end_record() {
+    put_varint(payload_, entry_.size());
+    payload_.append(entry_);
+    ++records_;
+}
+
+BlockRef BlockWriter::copy_to(std::string& out) const {
+    if (records_ == 0 && payload_.empty()) {
+        return BlockRef{};
+    }
+    const BlockRef block{out.size() + block_header_size, static_cast<uint32_t>(payload_.size()), records_,
+                         crc32c(payload_.data(), payload_.size())};
+    char header[block_header_size];
+    put_u32(header, block_magic);
+    put_u32(header + 4, block.size);
+    put_u32(header + 8, block.records);
+    put_u32(header + 12, block.crc);
+    out.append(header, sizeof(header));
+    out.append(payload_);
+    return block;
+}
+
+BlockRef BlockWriter::finish(std::string& out) {
+    const BlockRef block = copy_to(out);
+    if (records_ == 0 && payload_.empty()) {
+        return block;
+    }
+    payload_.clear();
+    strings_.clear();
+    last_logger_id_ = no_string;
+    site_strings_.clear();
+    previous_ns_ = 0;
+    records_ = 0;
+    return block;
+}
+
+std::vector<BlockRef> scan_blocks(std::string_view file, size_t* damaged) {
+    std::vector<BlockRef> blocks;
+    size_t pos = 0;
+    if (file.size() >= sizeof(file_magic) && std::memcmp(file.data(), file_magic, sizeof(file_magic)) == 0) {
+        pos = sizeof(file_magic);
+    }
+    while (pos + block_header_size <= file.size()) {
+        const char* header = file.data() + pos;
+        if (get_u32(header) != block_magic) {
+            ++pos;  // Garbage: look for the next block
+            continue;
+        }
+        const BlockRef block{pos + block_header_size, get_u32(header + 4), get_u32(header + 8), get_u32(header + 12)};
+        // Cut short, a damaged size or a damaged block's data; keep
+        // looking after it
+        if (block.offset + block.size > file.size() ||
+            crc32c(file.data() + block.offset, block.size) != block.crc) {
+            if (damaged) {
+                ++*damaged;
+            }
+            ++pos;
+            continue;
+        }
+        blocks.push_back(block);
+        pos = block.offset + block.size;
+    }
+    return blocks;
+}
+
+namespace detail {
+
+bool read_varint(const char*& p, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const auto byte = static_cast<uint8_t>(*p++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool decode_record(const char*& p, const char* end, const std::vector<std::string_view>& strings,
+                   int64_t& previous_ns, DecodedRecord& record) {
+    auto string_at = [&strings](uint64_t id, std::string_view& out) {
+        if (id >= strings.size()) {
+            return false;
+        }
+        out = strings[id];
+        return true;
+    };
+    auto bytes = [&p, end](std::string_view& out) {
+        uint64_t length;
+        if (!read_varint(p, end, length) || length > static_cast<uint64_t>(end - p)) {
+            return false;
+        }
+        out = std::string_view(p, static_cast<size_t>(length));
+        p += length;
+        return true;
+    };
+
+    if (p >= end) {
+        return false;
+    }
+    record.level = static_cast<LogLevel>(static_cast<uint8_t>(*p++));
+    uint64_t delta, thread_id, logger_id, file_id;
+    if (!read_varint(p, end, delta) || !read_varint(p, end, thread_id) || !read_varint(p, end, logger_id) ||
+        !string_at(logger_id, record.logger_name) || !read_varint(p, end, file_id)) {
+        return false;
+    }
+    previous_ns += unzigzag(delta);
+    record.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(previous_ns)));
+    record.thread_id = thread_id;
+    record.file = {};
+    record.function = {};
+    record.line = 0;
+    if (file_id != 0) {
+        uint64_t function_id, line;
+        if (!string_at(file_id - 1, record.file) || !read_varint(p, end, function_id) ||
+            !string_at(function_id, record.function) || !read_varint(p, end, line)) {
+            return false;
+        }
+        record.line = static_cast<uint32_t>(line);
+    }
+    uint64_t field_count;
+    if (!bytes(record.message) || !read_varint(p, end, field_count)) {
+        return false;
+    }
+    record.fields.clear();
+    for (uint64_t i = 0; i < field_count; ++i) {
+        uint64_t key_id;
+        std::string_view key;
+        if (!read_varint(p, end, key_id) || !string_at(key_id, key) || p >= end) {
+            return false;
+        }
+        const auto tag = static_cast<uint8_t>(*p++);
+        const auto type = static_cast<FieldType>(tag & ~packed_field);
+        if (tag & packed_field) {
+            uint64_t value;
+            if (!read_varint(p, end, value)) {
+                return false;
+            }
+            if (type == FieldType::Bool) {
+                record.fields.emplace_back(key, FieldValue(value != 0));
+            } else if (type == FieldType::Integer) {
+                record.fields.emplace_back(key, FieldValue(unzigzag(value)));
+            } else {
+                record.fields.emplace_back(key, FieldValue(std::to_string(unzigzag(value))));
+            }
+        } else {
+            std::string_view value;
+            if (!bytes(value)) {
+                return false;
+            }
+            record.fields.emplace_back(key, FieldValue::of(type, value));
+        }
+    }
+    return true;
+}
+
+}
+
+}
+}
@@ -0,0 +1,249 @@
+#include "Zyrnix/buffer_memory.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define XLOG_HAS_MMAP 1
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+struct MemoryState {
+    std::mutex mtx;
+    BufferMemory memory;
+    std::atomic<uint64_t> mapped_bytes{0};
+    std::atomic<uint64_t> huge_page_bytes{0};
+    std::atomic<uint64_t> locked_bytes{0};
+    std::atomic<uint64_t> hugetlb_fallbacks{0};
+    std::atomic<uint64_t> lock_failures{0};
+    std::once_flag lock_warning;
+};
+
+// Leaked, like the other process-wide singletons: rings may be freed
+// from static destructors
+MemoryState& state() {
+    static auto* s = new MemoryState;
+    return *s;
+}
+
+size_t round_up(size_t value, size_t unit) {
+    return (value + unit - 1) / unit * unit;
+}
+
+#ifdef XLOG_HAS_MMAP
+size_t page_size() {
+    static const size_t size = [] {
+        const long page = ::sysconf(_SC_PAGESIZE);
+        return page > 0 ? static_cast<size_t>(page) : size_t{4096};
+    }();
+    return size;
+}
+
+#ifdef __linux__
+// Hugepagesize from /proc/meminfo: the size MAP_HUGETLB hands out, and
+// the one THP folds aligned ranges into
+size_t huge_page_size() {
+    static const size_t size = [] {
+        size_t kib = 2048;
+        if (std::FILE* meminfo = std::fopen("/proc/meminfo", "r")) {
+            char line[128];
+            while (std::fgets(line, sizeof(line), meminfo)) {
+                unsigned long value = 0;
+                if (std::sscanf(line, "Hugepagesize: %lu kB", &value) == 1 && value > 0) {
+                    kib = value;
+                    break;
+                }
+            }
+            std::fclose(meminfo);
+        }
+        return kib * 1024;
+    }();
+    return size;
+}
+#endif
+
+void populate(void* map, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    if (::madvise(map, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    // Written back unchanged, so file mappings keep their contents
+    auto* bytes = static_cast<volatile char*>(map);
+    for (size_t offset = 0; offset < size; offset += page_size()) {
+        bytes[offset] = bytes[offset];
+    }
+}
+
+bool lock_pages(void* map, size_t size) {
+    if (::mlock(map, size) == 0) {
+        return true;
+    }
+    MemoryState& s = state();
+    s.lock_failures.fetch_add(1, std::memory_order_relaxed);
+    std::call_once(s.lock_warning, [size] {
+        std::cerr << "BufferMemory: cannot mlock " << size
+                  << " bytes; raise RLIMIT_MEMLOCK (ulimit -l) to lock log buffers" << std::endl;
+    });
+    return false;
+}
+
+// An anonymous mapping starting on an alignment boundary, trimmed out of
+// a larger one
+void* map_aligned(size_t size, size_t alignment) {
+    void* map = ::mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return nullptr;
+    }
+    const auto start = reinterpret_cast<uintptr_t>(map);
+    const uintptr_t aligned = round_up(start, alignment);
+    if (aligned > start) {
+        ::munmap(map, aligned - start);
+    }
+    if (const size_t tail = start + alignment - aligned; tail > 0) {
+        ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+}
+
+void set_buffer_memory(BufferMemory memory) {
+    MemoryState& s = state();
+    std::lock_guard<std::mutex> lock(s.mtx);
+    s.memory = memory;
+}
+
+BufferMemory get_buffer_memory() {
+    MemoryState& s = state();
+    std::lock_guard<std::mutex> lock(s.mtx);
+    return s.memory;
+}
+
+BufferMemoryStats get_buffer_memory_stats() {
+    MemoryState& s = state();
+    return BufferMemoryStats{
+        s.mapped_bytes.load(std::memory_order_relaxed),
+        s.huge_page_bytes.load(std::memory_order_relaxed),
+        s.locked_bytes.load(std::memory_order_relaxed),
+        s.hugetlb_fallbacks.load(std::memory_order_relaxed),
+        s.lock_failures.load(std::memory_order_relaxed),
+    };
+}
+
+BufferRegion::BufferRegion(size_t bytes, size_t alignment, bool prefault) : alignment_(alignment) {
+    bytes = std::max<size_t>(bytes, 1);
+    BufferMemory memory = get_buffer_memory();
+    memory.prefault |= prefault;
+    const bool wanted = memory.huge_pages || memory.prefault || memory.lock;
+#ifdef XLOG_HAS_MMAP
+    if (wanted && (prefault || bytes >= memory.min_bytes) && alignment <= page_size()) {
+        MemoryState& s = state();
+        void* map = nullptr;
+        size_t length = round_up(bytes, page_size());
+#ifdef __linux__
+        if (memory.huge_pages) {
+            const size_t huge = huge_page_size();
+            length = round_up(bytes, huge);
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+            if (memory.prefault) {
+                flags |= MAP_POPULATE;
+            }
+            map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (map == MAP_FAILED) {
+                s.hugetlb_fallbacks.fetch_add(1, std::memory_order_relaxed);
+                // Advised before the first fault, so THP can back the
+                // range with huge pages from the start
+                map = map_aligned(length, huge);
+                if (map) {
+                    ::madvise(map, length, MADV_HUGEPAGE);
+                    if (memory.prefault) {
+                        populate(map, length);
+                    }
+                }
+            }
+            huge_ = map != nullptr;
+        }
+#endif
+        if (!map) {
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+            if (memory.prefault) {
+                flags |= MAP_POPULATE;
+            }
+#endif
+            map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (map == MAP_FAILED) {
+                return;
+            }
+#ifndef MAP_POPULATE
+            if (memory.prefault) {
+                populate(map, length);
+            }
+#endif
+        }
+        data_ = map;
+        bytes_ = bytes;
+        mapped_ = length;
+        locked_ = memory.lock && lock_pages(map, length);
+        s.mapped_bytes.fetch_add(length, std::memory_order_relaxed);
+        if (huge_) {
+            s.huge_page_bytes.fetch_add(length, std::memory_order_relaxed);
+        }
+        if (locked_) {
+            s.locked_bytes.fetch_add(length, std::memory_order_relaxed);
+        }
+        return;
+    }
+#else
+    (void)wanted;
+#endif
+    data_ = ::operator new(bytes, std::align_val_t(alignment), std::nothrow);
+    bytes_ = data_ ? bytes : 0;
+}
+
+BufferRegion::~BufferRegion() {
+    if (!data_) {
+        return;
+    }
+    if (mapped_ == 0) {
+        ::operator delete(data_, std::align_val_t(alignment_));
+        return;
+    }
+#ifdef XLOG_HAS_MMAP
+    MemoryState& s = state();
+    ::munmap(data_, mapped_);  // Drops the lock with it
+    s.mapped_bytes.fetch_sub(mapped_, std::memory_order_relaxed);
+    if (huge_) {
+        s.huge_page_bytes.fetch_sub(mapped_, std::memory_order_relaxed);
+    }
+    if (locked_) {
+        s.locked_bytes.fetch_sub(mapped_, std::memory_order_relaxed);
+    }
+#endif
+}
+
+void prepare_mapping(void* map, size_t size) {
+#ifdef XLOG_HAS_MMAP
+    const BufferMemory memory = get_buffer_memory();
+    if (memory.prefault) {
+        populate(map, size);
+    }
+    if (memory.lock) {
+        lock_pages(map, size);
+    }
+#else
+    (void)map;
+    (void)size;
+#endif
+}
+
+}
@@ -0,0 +1,147 @@
+#include "Zyrnix/child_logger.hpp"
+#include "Zyrnix/level_rules.hpp"
+#include "Zyrnix/logger_registry.hpp"
+
+namespace Zyrnix {
+
+ChildLogger* Logger::child(std::string_view child_name) {
+    return make_child(nullptr, child_name);
+}
+
+ChildLogger* Logger::make_child(const ChildLogger* parent, std::string_view child_name) {
+    ChildRegistry* registry;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!children_) {
+            children_ = std::make_unique<ChildRegistry>();
+        }
+        registry = children_.get();
+    }
+
+    std::string full(parent ? parent->name() : std::string_view(name));
+    full += '.';
+    full += child_name;
+    const InternedName* interned = &InternedName::intern(full);
+
+    std::lock_guard<std::mutex> lock(registry->mtx);
+    auto it = registry->by_name.find(interned);
+    if (it != registry->by_name.end()) {
+        return it->second.get();
+    }
+    auto created = std::unique_ptr<ChildLogger>(new ChildLogger(this, parent, interned));
+    if (parent) {
+        created->level_.store(parent->level_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    if (auto level = LoggerRegistry::instance().rule_level(interned->text)) {
+        created->own_.store(static_cast<uint8_t>(*level), std::memory_order_relaxed);
+        created->level_.store(static_cast<uint8_t>(*level), std::memory_order_relaxed);
+    }
+    ChildLogger* raw = created.get();
+    registry->by_name.emplace(interned, std::move(created));
+    registry->order.push_back(raw);
+    return raw;
+}
+
+void Logger::apply_level_rules(const LevelRules& rules) {
+    ChildRegistry* registry;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (auto level = rules.match(name)) {
+            // Under a temporary level the rule is the level it reverts to
+            if (temp_level_.active) {
+                temp_level_.original_level = *level;
+            } else {
+                exchange_min_level(*level);
+            }
+        }
+        registry = children_.get();
+    }
+    if (!registry) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registry->mtx);
+    bool matched = false;
+    for (ChildLogger* child : registry->order) {
+        if (auto level = rules.match(child->name())) {
+            child->own_.store(static_cast<uint8_t>(*level), std::memory_order_relaxed);
+            matched = true;
+        }
+    }
+    if (matched) {
+        registry->resolve_levels();
+    }
+}
+
+void ChildRegistry::resolve_levels() {
+    for (ChildLogger* child : order) {
+        uint8_t level = child->own_.load(std::memory_order_relaxed);
+        if (level == ChildLogger::inherit && child->parent_) {
+            level = child->parent_->level_.load(std::memory_order_relaxed);
+        }
+        child->level_.store(level, std::memory_order_relaxed);
+    }
+}
+
+ChildLogger* ChildLogger::child(std::string_view child_name) {
+    return root_->make_child(this, child_name);
+}
+
+void ChildLogger::set_level(LogLevel level) {
+    std::lock_guard<std::mutex> lock(root_->children_->mtx);
+    own_.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    root_->children_->resolve_levels();
+}
+
+void ChildLogger::inherit_level() {
+    std::lock_guard<std::mutex> lock(root_->children_->mtx);
+    own_.store(inherit, std::memory_order_relaxed);
+    root_->children_->resolve_levels();
+}
+
+void ChildLogger::log(LogLevel level, std::string_view message) {
+    if (enabled(level)) {
+        root_->emit(level, message, nullptr, this);
+    }
+}
+
+void ChildLogger::log(const LogSite& site, std::string_view message) {
+    if (enabled(site)) {
+        root_->emit(site.level, message, &site, this);
+    }
+}
+
+void ChildLogger::log_limited(const LogSite& site, uint64_t suppressed, std::string_view message) {
+    record_suppressed(suppressed);
+    if (!enabled(site)) {
+        return;
+    }
+    if (suppressed == 0) {
+        root_->emit(site.level, message, &site, this);
+        return;
+    }
+    std::string line(message);
+    line += " [" + std::to_string(suppressed) + " suppressed]";
+    root_->emit(site.level, line, &site, this);
+}
+
+void ChildLogger::log_fields(LogLevel level, std::string_view message, std::span<Field> fields) {
+    if (enabled(level)) {
+        root_->emit_fields(level, message, fields, this);
+    }
+}
+
+#if XLOG_HAS_FMT
+// A buffer on the stack rather than the root's per-thread one, which an
+// argument's formatter logging through the root would clobber
+void ChildLogger::vlog(LogLevel level, fmt::string_view format, fmt::format_args args, const LogSite* site,
+                       uint64_t suppressed) {
+    fmt::memory_buffer buffer;
+    fmt::vformat_to(fmt::appender(buffer), format, args);
+    if (suppressed > 0) {
+        fmt::format_to(fmt::appender(buffer), " [{} suppressed]", suppressed);
+    }
+    root_->emit(level, std::string_view(buffer.data(), buffer.size()), site, this);
+}
+#endif
+
+}
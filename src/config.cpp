@@ -3,15 +3,26 @@
 #include "Zyrnix/sinks/stdout_sink.hpp"
 #include "Zyrnix/sinks/file_sink.hpp"
 #include "Zyrnix/sinks/rotating_file_sink.hpp"
+#ifndef _WIN32
+#include "Zyrnix/sinks/shared_file_sink.hpp"
+#endif
 #include "Zyrnix/sinks/loki_sink.hpp"
+#include "Zyrnix/sinks/lazy_sink.hpp"
+#include "Zyrnix/sinks/parquet_sink.hpp"
+#ifndef XLOG_NO_FILTERS
+#include "Zyrnix/log_filter.hpp"
+#endif
 
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <string_view>
 namespace Zyrnix {
 
 
 std::vector<LoggerConfig> ConfigLoader::configs_;
+LevelRules ConfigLoader::level_rules_;
 static std::string g_last_error;
 
 static std::vector<std::string> split_and_trim(const std::string& value) {
@@ -42,6 +53,262 @@ static std::vector<std::string> split_and_trim(const std::string& value) {
     return result;
 }
 
+namespace {
+
+// Single-pass reader over the config text (v1.2.0). Each value is read
+// once, in place; members the loader does not know are skipped without
+// being built.
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : text_(text) {}
+
+    const std::string& error() const { return error_; }
+
+    bool at_end() {
+        skip_whitespace();
+        return pos_ >= text_.size();
+    }
+
+    // on_member(key) reads the member's value; a trailing comma is allowed
+    template <class F>
+    bool object(F&& on_member) {
+        if (!expect('{')) return false;
+        std::string key;
+        while (true) {
+            skip_whitespace();
+            if (consume('}')) return true;
+            if (!string(key) || !expect(':') || !on_member(key)) return false;
+            skip_whitespace();
+            if (consume('}')) return true;
+            if (!expect(',')) return false;
+        }
+    }
+
+    template <class F>
+    bool array(F&& on_element) {
+        if (!expect('[')) return false;
+        while (true) {
+            skip_whitespace();
+            if (consume(']')) return true;
+            if (!on_element()) return false;
+            skip_whitespace();
+            if (consume(']')) return true;
+            if (!expect(',')) return false;
+        }
+    }
+
+    bool string(std::string& out) {
+        if (!expect('"')) return false;
+        out.clear();
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size()) break;
+            const char escaped = text_[pos_++];
+            switch (escaped) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case 'r': out.push_back('\r'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'u': if (!unicode_escape(out)) return false; break;
+                default: out.push_back(escaped); break;
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool boolean(bool& out) {
+        skip_whitespace();
+        if (text_.substr(pos_, 4) == "true") {
+            pos_ += 4;
+            out = true;
+            return true;
+        }
+        if (text_.substr(pos_, 5) == "false") {
+            pos_ += 5;
+            out = false;
+            return true;
+        }
+        return fail("expected true or false");
+    }
+
+    bool number(size_t& out) {
+        skip_whitespace();
+        const size_t start = pos_;
+        uint64_t value = 0;
+        while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+            value = value * 10 + static_cast<uint64_t>(text_[pos_++] - '0');
+        }
+        if (pos_ == start) return fail("expected a non-negative integer");
+        out = static_cast<size_t>(value);
+        return true;
+    }
+
+    // Any value as text: strings unescaped, arrays of scalars joined with
+    // commas, objects as written
+    bool text(std::string& out) {
+        skip_whitespace();
+        const char c = peek();
+        if (c == '"') return string(out);
+        if (c == '[') {
+            const size_t start = pos_;
+            out.clear();
+            std::string item;
+            bool flat = true;
+            if (!array([&] {
+                    skip_whitespace();
+                    flat = flat && peek() != '[' && peek() != '{';
+                    if (!text(item)) return false;
+                    if (!out.empty()) out.push_back(',');
+                    out += item;
+                    return true;
+                })) {
+                return false;
+            }
+            if (!flat) out.assign(text_.substr(start, pos_ - start));
+            return true;
+        }
+        const size_t start = pos_;
+        if (!skip()) return false;
+        out.assign(text_.substr(start, pos_ - start));
+        return true;
+    }
+
+    bool skip() {
+        skip_whitespace();
+        const char c = peek();
+        if (c == '{') return object([&](const std::string&) { return skip(); });
+        if (c == '[') return array([&] { return skip(); });
+        if (c == '"') {
+            std::string ignored;
+            return string(ignored);
+        }
+        const size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '-' ||
+                                        text_[pos_] == '+' || text_[pos_] == '.')) {
+            ++pos_;
+        }
+        return pos_ > start || fail("expected a value");
+    }
+
+    bool fail(const std::string& what) {
+        if (error_.empty()) {
+            error_ = "Malformed configuration at offset " + std::to_string(pos_) + ": " + what;
+        }
+        return false;
+    }
+
+private:
+    void skip_whitespace() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' || text_[pos_] == '\t')) {
+            ++pos_;
+        }
+    }
+    char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+    bool consume(char c) {
+        if (peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+    bool expect(char c) {
+        skip_whitespace();
+        return consume(c) || fail(std::string("expected '") + c + "'");
+    }
+
+    // \uXXXX as UTF-8; surrogate pairs are not combined
+    bool unicode_escape(std::string& out) {
+        if (pos_ + 4 > text_.size()) return fail("short \\u escape");
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char h = text_[pos_++];
+            code <<= 4;
+            if (h >= '0' && h <= '9') code |= static_cast<unsigned>(h - '0');
+            else if (h >= 'a' && h <= 'f') code |= static_cast<unsigned>(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') code |= static_cast<unsigned>(h - 'A' + 10);
+            else return fail("bad \\u escape");
+        }
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        return true;
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+// Every member but "type" becomes sink_params["<type>_<key>"], so "path"
+// of a file sink is "file_path" and a sink's "pattern" is "<type>_pattern"
+bool read_sink(JsonReader& json, LoggerConfig& config) {
+    std::string type;
+    std::vector<std::pair<std::string, std::string>> params;
+    const bool ok = json.object([&](const std::string& key) {
+        if (key == "type") return json.string(type);
+        params.emplace_back(key, std::string());
+        return json.text(params.back().second);
+    });
+    if (!ok) return false;
+    if (type.empty()) return true;
+    config.sinks.push_back(type);
+    for (auto& [key, value] : params) {
+        config.sink_params[type + "_" + key] = std::move(value);
+    }
+    return true;
+}
+
+bool read_logger(JsonReader& json, LoggerConfig& config, std::string& level) {
+    return json.object([&](const std::string& key) {
+        if (key == "name") return json.string(config.name);
+        if (key == "level") return json.string(level);
+        if (key == "async") return json.boolean(config.async);
+        // Async queue configuration (v1.2.0)
+        if (key == "queue_capacity") return json.number(config.queue_capacity);
+        if (key == "overflow_policy") return json.string(config.overflow_policy);
+        if (key == "block_timeout_ms") return json.number(config.block_timeout_ms);
+        if (key == "sample_rate") return json.number(config.sample_rate);
+        if (key == "priority_level") return json.string(config.priority_level);
+        if (key == "sync_critical") return json.boolean(config.sync_critical);
+        if (key == "lazy_sinks") return json.boolean(config.lazy_sinks);
+        if (key == "pattern") return json.string(config.pattern);
+        if (key == "filter") return json.string(config.filter);
+        // Optional redaction configuration (v1.1.3)
+        if (key == "redact_substrings") return json.text(config.redact_substrings);
+        if (key == "redact_regexes") return json.text(config.redact_regexes);
+        if (key == "redact_presets") return json.text(config.redact_presets);
+        if (key == "redact_cloud_only") return json.boolean(config.redact_cloud_only);
+        if (key == "sinks") return json.array([&] { return read_sink(json, config); });
+        return json.skip();
+    });
+}
+
+}
+
+#ifndef XLOG_NO_ASYNC
+static OverflowPolicy parse_overflow_policy(const std::string& value) {
+    std::string lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    if (lower == "drop_newest" || lower == "drop") return OverflowPolicy::DropNewest;
+    if (lower == "drop_oldest") return OverflowPolicy::DropOldest;
+    if (lower == "sample") return OverflowPolicy::Sample;
+    return OverflowPolicy::Block;
+}
+#endif
+
 bool ConfigLoader::load_from_json(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -62,96 +329,342 @@ std::vector<LoggerConfig> ConfigLoader::get_logger_configs() {
     return configs_;
 }
 
-std::map<std::string, std::shared_ptr<Logger>> ConfigLoader::create_loggers() {
-    std::map<std::string, std::shared_ptr<Logger>> loggers;
-    
-    for (const auto& config : configs_) {
-        std::shared_ptr<Logger> logger;
+LevelRules ConfigLoader::get_level_rules() {
+    return level_rules_;
+}
+
+// The sink's own pattern, else the logger's, else the default
+static std::string sink_pattern(const LoggerConfig& config, const std::string& sink_type) {
+    auto it = config.sink_params.find(sink_type + "_pattern");
+    return it != config.sink_params.end() ? it->second : config.pattern;
+}
+
+// nullptr for an unknown type or one missing a required parameter
+static LogSinkPtr create_sink(const LoggerConfig& config, const std::string& sink_type) {
+    auto with_pattern = [&](LogSinkPtr sink) {
+        const std::string pattern = sink_pattern(config, sink_type);
+        if (!pattern.empty()) {
+            sink->set_pattern(pattern);
+        }
+        return sink;
+    };
+
+    if (sink_type == "stdout") {
+        return with_pattern(std::make_shared<StdoutSink>());
+    } else if (sink_type == "file") {
+        auto it = config.sink_params.find("file_path");
+        std::string path = (it != config.sink_params.end()) ? it->second : "app.log";
+        return with_pattern(std::make_shared<FileSink>(path));
+    } else if (sink_type == "rotating") {
+        auto path_it = config.sink_params.find("rotating_path");
+        auto size_it = config.sink_params.find("rotating_max_size");
+        auto files_it = config.sink_params.find("rotating_max_files");
+        auto interval_it = config.sink_params.find("rotating_interval");
+        auto total_it = config.sink_params.find("rotating_max_total_bytes");
+        auto sidecar_it = config.sink_params.find("rotating_sidecar_fields");
         
-        if (config.async) {
-            logger = Logger::create_async(config.name);
-        } else {
-            logger = std::make_shared<Logger>(config.name);
+        std::string path = (path_it != config.sink_params.end()) ? path_it->second : "app.log";
+        RotationOptions rotation;
+        rotation.max_size = (size_it != config.sink_params.end()) ? std::stoull(size_it->second) : 10485760;
+        rotation.max_files = (files_it != config.sink_params.end()) ? std::stoull(files_it->second) : 5;
+        if (interval_it != config.sink_params.end()) {
+            if (interval_it->second == "hourly") {
+                rotation.interval = RotationInterval::Hourly;
+            } else if (interval_it->second == "daily") {
+                rotation.interval = RotationInterval::Daily;
+            }
+        }
+        if (total_it != config.sink_params.end()) {
+            rotation.max_total_bytes = std::stoull(total_it->second);
+        }
+        if (sidecar_it != config.sink_params.end()) {
+            // Comma-separated field names, e.g. trace_id,user_id
+            rotation.sidecar.enabled = true;
+            rotation.sidecar.bloom_fields = split_and_trim(sidecar_it->second);
         }
         
-        logger->set_level(config.level);
+        return with_pattern(std::make_shared<RotatingFileSink>(path, rotation));
+    } else if (sink_type == "shared_file") {
+#ifndef _WIN32
+        auto path_it = config.sink_params.find("shared_file_path");
+        auto size_it = config.sink_params.find("shared_file_max_size");
+        auto files_it = config.sink_params.find("shared_file_max_files");
+        auto rotator_it = config.sink_params.find("shared_file_rotator");
 
-        // Apply redaction configuration (v1.1.3)
-        if (!config.redact_substrings.empty()) {
-            logger->set_redact_patterns(split_and_trim(config.redact_substrings));
+        // Base name: the sink appends .log itself
+        std::string base = (path_it != config.sink_params.end()) ? path_it->second : "app";
+        SharedFileOptions opts;
+        if (size_it != config.sink_params.end()) {
+            opts.max_size = static_cast<size_t>(std::stoull(size_it->second));
         }
-        if (!config.redact_regexes.empty()) {
-            logger->set_redact_regex_patterns(split_and_trim(config.redact_regexes));
+        if (files_it != config.sink_params.end()) {
+            opts.max_files = static_cast<size_t>(std::stoull(files_it->second));
         }
-        if (!config.redact_presets.empty()) {
-            logger->set_redact_pii_presets(split_and_trim(config.redact_presets));
+        if (rotator_it != config.sink_params.end()) {
+            std::string v = rotator_it->second;
+            std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+            opts.rotator = (v == "true" || v == "1");
         }
-        logger->set_redact_apply_to_cloud_only(config.redact_cloud_only);
-        
-        for (const auto& sink_type : config.sinks) {
-            if (sink_type == "stdout") {
-                logger->add_sink(std::make_shared<StdoutSink>());
-            } else if (sink_type == "file") {
-                auto it = config.sink_params.find("file_path");
-                std::string path = (it != config.sink_params.end()) ? it->second : "app.log";
-                logger->add_sink(std::make_shared<FileSink>(path));
-            } else if (sink_type == "rotating") {
-                auto path_it = config.sink_params.find("rotating_path");
-                auto size_it = config.sink_params.find("rotating_max_size");
-                auto files_it = config.sink_params.find("rotating_max_files");
-                
-                std::string path = (path_it != config.sink_params.end()) ? path_it->second : "app.log";
-                size_t max_size = (size_it != config.sink_params.end()) ? std::stoull(size_it->second) : 10485760;
-                size_t max_files = (files_it != config.sink_params.end()) ? std::stoull(files_it->second) : 5;
-                
-                logger->add_sink(std::make_shared<RotatingFileSink>(path, max_size, max_files));
-            } else if (sink_type == "loki") {
-#ifndef XLOG_NO_CLOUD_SINKS
-                auto url_it = config.sink_params.find("loki_url");
-                auto labels_it = config.sink_params.find("loki_labels");
-                auto batch_it = config.sink_params.find("loki_batch_size");
-                auto flush_it = config.sink_params.find("loki_flush_interval_ms");
-                auto timeout_it = config.sink_params.find("loki_timeout_ms");
-                auto insecure_it = config.sink_params.find("loki_insecure_skip_verify");
-                auto ca_it = config.sink_params.find("loki_ca_cert_path");
-
-                std::string url = (url_it != config.sink_params.end()) ? url_it->second : "";
-                std::string labels = (labels_it != config.sink_params.end()) ? labels_it->second : "";
-
-                LokiOptions opts;
-                if (batch_it != config.sink_params.end()) {
-                    opts.batch_size = static_cast<size_t>(std::stoull(batch_it->second));
-                }
-                if (flush_it != config.sink_params.end()) {
-                    opts.flush_interval_ms = static_cast<uint64_t>(std::stoull(flush_it->second));
-                }
-                if (timeout_it != config.sink_params.end()) {
-                    opts.timeout_ms = static_cast<long>(std::stol(timeout_it->second));
-                }
-                if (insecure_it != config.sink_params.end()) {
-                    std::string v = insecure_it->second;
-                    std::transform(v.begin(), v.end(), v.begin(), ::tolower);
-                    opts.insecure_skip_verify = (v == "true" || v == "1");
-                }
-                if (ca_it != config.sink_params.end()) {
-                    opts.ca_cert_path = ca_it->second;
+        return with_pattern(std::make_shared<SharedFileSink>(base, opts));
+#endif
+    } else if (sink_type == "parquet") {
+        auto path_it = config.sink_params.find("parquet_path");
+        auto fields_it = config.sink_params.find("parquet_fields");
+        auto group_it = config.sink_params.find("parquet_row_group_rows");
+        auto rows_it = config.sink_params.find("parquet_max_file_rows");
+        auto codec_it = config.sink_params.find("parquet_codec");
+
+        // Base name: files are <base>-<time>-<n>.parquet
+        std::string base = (path_it != config.sink_params.end()) ? path_it->second : "app";
+        ParquetOptions opts;
+        if (fields_it != config.sink_params.end()) {
+            // name:type, type one of string, int, float, bool
+            for (const auto& entry : split_and_trim(fields_it->second)) {
+                const size_t colon = entry.find(':');
+                parquet::FieldColumn column{entry.substr(0, colon), FieldType::String};
+                const std::string type = colon == std::string::npos ? "string" : entry.substr(colon + 1);
+                if (type == "int") {
+                    column.type = FieldType::Integer;
+                } else if (type == "float") {
+                    column.type = FieldType::Float;
+                } else if (type == "bool") {
+                    column.type = FieldType::Bool;
                 }
+                opts.schema.fields.push_back(std::move(column));
+            }
+        }
+        if (group_it != config.sink_params.end()) {
+            opts.row_group_rows = static_cast<size_t>(std::stoull(group_it->second));
+        }
+        if (rows_it != config.sink_params.end()) {
+            opts.max_file_rows = std::stoull(rows_it->second);
+        }
+        if (codec_it != config.sink_params.end() && codec_it->second == "none") {
+            opts.codec = parquet::Codec::Uncompressed;
+        }
+        return std::make_shared<ParquetSink>(base, opts);
+    } else if (sink_type == "loki") {
+#ifndef XLOG_NO_CLOUD_SINKS
+        auto url_it = config.sink_params.find("loki_url");
+        auto labels_it = config.sink_params.find("loki_labels");
+        auto batch_it = config.sink_params.find("loki_batch_size");
+        auto flush_it = config.sink_params.find("loki_flush_interval_ms");
+        auto timeout_it = config.sink_params.find("loki_timeout_ms");
+        auto insecure_it = config.sink_params.find("loki_insecure_skip_verify");
+        auto ca_it = config.sink_params.find("loki_ca_cert_path");
+        auto queue_it = config.sink_params.find("loki_max_queue_size");
+        auto encoding_it = config.sink_params.find("loki_encoding");
+        auto stream_labels_it = config.sink_params.find("loki_stream_labels");
+        auto max_streams_it = config.sink_params.find("loki_max_streams");
+        auto batch_bytes_it = config.sink_params.find("loki_batch_bytes");
+        auto spill_it = config.sink_params.find("loki_spill_directory");
+        auto spill_bytes_it = config.sink_params.find("loki_spill_max_bytes");
 
-                if (!url.empty()) {
-                    logger->add_sink(std::make_shared<LokiSink>(url, labels, opts));
+        std::string url = (url_it != config.sink_params.end()) ? url_it->second : "";
+        std::string labels = (labels_it != config.sink_params.end()) ? labels_it->second : "";
+
+        LokiOptions opts;
+        if (batch_it != config.sink_params.end()) {
+            opts.batch_size = static_cast<size_t>(std::stoull(batch_it->second));
+        }
+        if (flush_it != config.sink_params.end()) {
+            opts.flush_interval_ms = static_cast<uint64_t>(std::stoull(flush_it->second));
+        }
+        if (timeout_it != config.sink_params.end()) {
+            opts.timeout_ms = static_cast<long>(std::stol(timeout_it->second));
+        }
+        if (insecure_it != config.sink_params.end()) {
+            std::string v = insecure_it->second;
+            std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+            opts.insecure_skip_verify = (v == "true" || v == "1");
+        }
+        if (ca_it != config.sink_params.end()) {
+            opts.ca_cert_path = ca_it->second;
+        }
+        if (queue_it != config.sink_params.end()) {
+            opts.max_queue_size = static_cast<size_t>(std::stoull(queue_it->second));
+        }
+        if (encoding_it != config.sink_params.end()) {
+            std::string v = encoding_it->second;
+            std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+            if (v == "gzip") {
+                opts.encoding = LokiEncoding::JsonGzip;
+            } else if (v == "protobuf") {
+                opts.encoding = LokiEncoding::Protobuf;
+            }
+        }
+        if (stream_labels_it != config.sink_params.end()) {
+            // Comma-separated: level,logger,route
+            std::istringstream names(stream_labels_it->second);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                name.erase(0, name.find_first_not_of(" \t"));
+                name.erase(name.find_last_not_of(" \t") + 1);
+                if (!name.empty()) {
+                    opts.stream_labels.push_back(name);
                 }
-#endif
             }
         }
-        
-        loggers[config.name] = logger;
+        if (max_streams_it != config.sink_params.end()) {
+            opts.max_streams = static_cast<size_t>(std::stoull(max_streams_it->second));
+        }
+        if (batch_bytes_it != config.sink_params.end()) {
+            opts.batch_bytes = static_cast<size_t>(std::stoull(batch_bytes_it->second));
+        }
+        if (spill_it != config.sink_params.end()) {
+            opts.spill.directory = spill_it->second;
+        }
+        if (spill_bytes_it != config.sink_params.end()) {
+            opts.spill.max_bytes = static_cast<size_t>(std::stoull(spill_bytes_it->second));
+        }
+
+        if (!url.empty()) {
+            return with_pattern(std::make_shared<LokiSink>(url, labels, opts));
+        }
+#endif
+    }
+    return nullptr;
+}
+
+static LogSinkPtr config_sink(const LoggerConfig& config, const std::string& sink_type) {
+    if (!config.lazy_sinks) {
+        return create_sink(config, sink_type);
+    }
+    return std::make_shared<LazySink>([config, sink_type] { return create_sink(config, sink_type); },
+                                      sink_type == "loki");
+}
+
+// Everything a sink of sink_type is built from, to tell whether a reload
+// changed it
+static std::map<std::string, std::string> sink_settings(const LoggerConfig& config, const std::string& sink_type) {
+    const std::string prefix = sink_type + "_";
+    std::map<std::string, std::string> settings;
+    for (auto it = config.sink_params.lower_bound(prefix);
+         it != config.sink_params.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        settings.insert(*it);
+    }
+    settings[prefix + "pattern"] = sink_pattern(config, sink_type);
+    return settings;
+}
+
+static void set_redaction(Logger& logger, const LoggerConfig& config) {
+    logger.set_redact_patterns(split_and_trim(config.redact_substrings));
+    logger.set_redact_regex_patterns(split_and_trim(config.redact_regexes));
+    logger.set_redact_pii_presets(split_and_trim(config.redact_presets));
+    logger.set_redact_apply_to_cloud_only(config.redact_cloud_only);
+}
+
+#ifndef XLOG_NO_FILTERS
+static std::vector<std::shared_ptr<LogFilter>> config_filters(const LoggerConfig& config) {
+    std::vector<std::shared_ptr<LogFilter>> filters;
+    // Checked when the configuration was parsed
+    if (!config.filter.empty()) {
+        if (auto filter = ExpressionFilter::compile(config.filter)) {
+            filters.push_back(filter);
+        }
+    }
+    return filters;
+}
+#endif
+
+std::shared_ptr<Logger> ConfigLoader::create_logger(const LoggerConfig& config) {
+    std::shared_ptr<Logger> logger;
+
+    if (config.async) {
+#ifndef XLOG_NO_ASYNC
+        AsyncOptions options;
+        options.queue_capacity = config.queue_capacity;
+        options.overflow_policy = parse_overflow_policy(config.overflow_policy);
+        options.block_timeout_ms = config.block_timeout_ms;
+        options.sample_rate = config.sample_rate;
+        if (!config.priority_level.empty()) {
+            options.priority_lane = true;
+            options.priority_level = parse_log_level(config.priority_level);
+        }
+        options.sync_critical = config.sync_critical;
+        logger = Logger::create_async(config.name, options);
+#else
+        logger = std::make_shared<Logger>(config.name);
+#endif
+    } else {
+        logger = std::make_shared<Logger>(config.name);
+    }
+
+    logger->set_level(config.level);
+    // Redaction configuration (v1.1.3)
+    set_redaction(*logger, config);
+#ifndef XLOG_NO_FILTERS
+    logger->set_filters(config_filters(config));
+#endif
+
+    // Named by type, which is how reconfigure() finds them again
+    for (const auto& sink_type : config.sinks) {
+        if (auto sink = config_sink(config, sink_type)) {
+            logger->add_sink(std::move(sink), sink_type);
+        }
+    }
+    return logger;
+}
+
+std::map<std::string, std::shared_ptr<Logger>> ConfigLoader::create_loggers() {
+    std::map<std::string, std::shared_ptr<Logger>> loggers;
+    for (const auto& config : configs_) {
+        loggers[config.name] = create_logger(config);
     }
-    
     return loggers;
 }
 
+// The queue is set up once, in enable_async()
+static bool same_async_setup(const LoggerConfig& a, const LoggerConfig& b) {
+    return a.async == b.async &&
+           (!a.async || (a.queue_capacity == b.queue_capacity && a.overflow_policy == b.overflow_policy &&
+                         a.block_timeout_ms == b.block_timeout_ms && a.sample_rate == b.sample_rate &&
+                         a.priority_level == b.priority_level && a.sync_critical == b.sync_critical));
+}
+
+bool ConfigLoader::reconfigure(Logger& logger, const LoggerConfig& running, const LoggerConfig& next) {
+    if (running.name != next.name || !same_async_setup(running, next)) {
+        return false;
+    }
+
+    if (running.level != next.level) {
+        logger.set_level_dynamic(next.level, "config reload");
+    }
+    if (running.redact_substrings != next.redact_substrings || running.redact_regexes != next.redact_regexes ||
+        running.redact_presets != next.redact_presets || running.redact_cloud_only != next.redact_cloud_only) {
+        set_redaction(logger, next);
+    }
+#ifndef XLOG_NO_FILTERS
+    if (running.filter != next.filter) {
+        logger.set_filters(config_filters(next));
+    }
+#endif
+
+    // Unchanged sinks, open files and connections included, stay as they are
+    for (const auto& sink_type : running.sinks) {
+        if (std::find(next.sinks.begin(), next.sinks.end(), sink_type) == next.sinks.end()) {
+            logger.remove_sink(sink_type);
+        }
+    }
+    for (const auto& sink_type : next.sinks) {
+        const bool existed = std::find(running.sinks.begin(), running.sinks.end(), sink_type) != running.sinks.end();
+        if (existed && running.lazy_sinks == next.lazy_sinks &&
+            sink_settings(running, sink_type) == sink_settings(next, sink_type)) {
+            continue;
+        }
+        auto sink = config_sink(next, sink_type);
+        if (!sink) {
+            logger.remove_sink(sink_type);
+        } else if (!existed || !logger.replace_sink(sink_type, sink)) {
+            logger.add_sink(std::move(sink), sink_type);
+        }
+    }
+    return true;
+}
+
 void ConfigLoader::clear() {
     configs_.clear();
+    level_rules_ = LevelRules();
 }
 
 std::string ConfigLoader::get_last_error() {
@@ -173,216 +686,59 @@ LogLevel ConfigLoader::parse_log_level(const std::string& level) {
 }
 
 bool ConfigLoader::parse_json_internal(const std::string& content) {
- 
-    
     configs_.clear();
+    level_rules_ = LevelRules();
     g_last_error.clear();
-    
-    
-    size_t loggers_pos = content.find("\"loggers\"");
-    if (loggers_pos == std::string::npos) {
-        g_last_error = "Missing \"loggers\" array in configuration";
-        return false;
-    }
 
-    size_t array_start = content.find('[', loggers_pos);
-    if (array_start == std::string::npos) {
-        g_last_error = "Malformed configuration: expected '[' after \"loggers\"";
-        return false;
-    }
-    
-   
-    size_t pos = array_start + 1;
-    while (pos < content.length()) {
- 
-        while (pos < content.length() && (content[pos] == ' ' || content[pos] == '\n' || content[pos] == '\r' || content[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= content.length() || content[pos] == ']') {
-            break; 
-        }
-        
-        if (content[pos] != '{') {
-            pos++;
-            continue;
-        }
-        
-  
-        size_t obj_start = pos;
-        size_t obj_end = content.find('}', obj_start);
-        if (obj_end == std::string::npos) {
-            g_last_error = "Malformed logger object in configuration";
-            break;
-        }
-        
-        std::string obj = content.substr(obj_start, obj_end - obj_start + 1);
-        
-        LoggerConfig config;
-        
-
-        size_t name_pos = obj.find("\"name\"");
-        if (name_pos != std::string::npos) {
-            size_t colon = obj.find(':', name_pos);
-            size_t quote1 = obj.find('"', colon);
-            size_t quote2 = obj.find('"', quote1 + 1);
-            if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                config.name = obj.substr(quote1 + 1, quote2 - quote1 - 1);
-            }
-        }
-        
-
-        size_t level_pos = obj.find("\"level\"");
-        if (level_pos != std::string::npos) {
-            size_t colon = obj.find(':', level_pos);
-            size_t quote1 = obj.find('"', colon);
-            size_t quote2 = obj.find('"', quote1 + 1);
-            if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                std::string level_str = obj.substr(quote1 + 1, quote2 - quote1 - 1);
-                config.level = parse_log_level(level_str);
-            }
-        }
-        
-
-        size_t async_pos = obj.find("\"async\"");
-        if (async_pos != std::string::npos) {
-            size_t colon = obj.find(':', async_pos);
-            size_t true_pos = obj.find("true", colon);
-            config.async = (true_pos != std::string::npos && true_pos < obj_end);
-        }
-        
-
-        size_t sinks_pos = obj.find("\"sinks\"");
-        if (sinks_pos != std::string::npos) {
-            size_t sinks_array_start = obj.find('[', sinks_pos);
-            size_t sinks_array_end = obj.find(']', sinks_array_start);
-            if (sinks_array_start != std::string::npos && sinks_array_end != std::string::npos) {
-                std::string sinks_content = obj.substr(sinks_array_start + 1, sinks_array_end - sinks_array_start - 1);
-                
-
-                size_t sink_pos = 0;
-                while (sink_pos < sinks_content.length()) {
-                    size_t sink_obj_start = sinks_content.find('{', sink_pos);
-                    if (sink_obj_start == std::string::npos) break;
-                    
-                    size_t sink_obj_end = sinks_content.find('}', sink_obj_start);
-                    if (sink_obj_end == std::string::npos) break;
-                    
-                    std::string sink_obj = sinks_content.substr(sink_obj_start, sink_obj_end - sink_obj_start + 1);
-                    
-            
-                    size_t type_pos = sink_obj.find("\"type\"");
-                    if (type_pos != std::string::npos) {
-                        size_t colon = sink_obj.find(':', type_pos);
-                        size_t quote1 = sink_obj.find('"', colon);
-                        size_t quote2 = sink_obj.find('"', quote1 + 1);
-                        if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                            std::string sink_type = sink_obj.substr(quote1 + 1, quote2 - quote1 - 1);
-                            config.sinks.push_back(sink_type);
-                            
-                 
-                            if (sink_type == "file" || sink_type == "rotating") {
-                                size_t path_pos = sink_obj.find("\"path\"");
-                                if (path_pos != std::string::npos) {
-                                    size_t colon2 = sink_obj.find(':', path_pos);
-                                    size_t pquote1 = sink_obj.find('"', colon2);
-                                    size_t pquote2 = sink_obj.find('"', pquote1 + 1);
-                                    if (pquote1 != std::string::npos && pquote2 != std::string::npos) {
-                                        std::string path = sink_obj.substr(pquote1 + 1, pquote2 - pquote1 - 1);
-                                        if (sink_type == "file") {
-                                            config.sink_params["file_path"] = path;
-                                        } else {
-                                            config.sink_params["rotating_path"] = path;
-                                        }
-                                    }
-                                }
-                                
-                                if (sink_type == "rotating") {
-                                    size_t max_size_pos = sink_obj.find("\"max_size\"");
-                                    if (max_size_pos != std::string::npos) {
-                                        size_t colon3 = sink_obj.find(':', max_size_pos);
-                                        size_t num_start = colon3 + 1;
-                                        while (num_start < sink_obj.length() && !isdigit(sink_obj[num_start])) num_start++;
-                                        size_t num_end = num_start;
-                                        while (num_end < sink_obj.length() && isdigit(sink_obj[num_end])) num_end++;
-                                        if (num_start < num_end) {
-                                            config.sink_params["rotating_max_size"] = sink_obj.substr(num_start, num_end - num_start);
-                                        }
-                                    }
-                                    
-                                    size_t max_files_pos = sink_obj.find("\"max_files\"");
-                                    if (max_files_pos != std::string::npos) {
-                                        size_t colon4 = sink_obj.find(':', max_files_pos);
-                                        size_t num_start = colon4 + 1;
-                                        while (num_start < sink_obj.length() && !isdigit(sink_obj[num_start])) num_start++;
-                                        size_t num_end = num_start;
-                                        while (num_end < sink_obj.length() && isdigit(sink_obj[num_end])) num_end++;
-                                        if (num_start < num_end) {
-                                            config.sink_params["rotating_max_files"] = sink_obj.substr(num_start, num_end - num_start);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    
-                    sink_pos = sink_obj_end + 1;
+    JsonReader json(content);
+    bool found = false;
+    std::string level;
+    const bool ok = json.object([&](const std::string& key) {
+        if (key == "levels") {
+            return json.object([&](const std::string& pattern) {
+                if (!json.string(level)) return false;
+                if (!level_rules_.add(pattern, parse_log_level(level))) {
+                    return json.fail("invalid level pattern \"" + pattern + "\"");
                 }
-            }
+                return true;
+            });
         }
-
-        // Optional redaction configuration (v1.1.3)
-        size_t rs_pos = obj.find("\"redact_substrings\"");
-        if (rs_pos != std::string::npos) {
-            size_t colon = obj.find(':', rs_pos);
-            size_t quote1 = obj.find('"', colon);
-            size_t quote2 = obj.find('"', quote1 + 1);
-            if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                config.redact_substrings = obj.substr(quote1 + 1, quote2 - quote1 - 1);
+        if (key != "loggers") return json.skip();
+        found = true;
+        return json.array([&] {
+            LoggerConfig config;
+            level.clear();
+            if (!read_logger(json, config, level)) return false;
+            if (!level.empty()) config.level = parse_log_level(level);
+#ifndef XLOG_NO_FILTERS
+            // A bad expression fails the whole load, so a hot reload keeps
+            // the loggers it has rather than dropping the filter
+            std::string filter_error;
+            if (!config.filter.empty() && !ExpressionFilter::compile(config.filter, &filter_error)) {
+                return json.fail("invalid filter for logger \"" + config.name + "\": " + filter_error);
             }
-        }
-
-        size_t rr_pos = obj.find("\"redact_regexes\"");
-        if (rr_pos != std::string::npos) {
-            size_t colon = obj.find(':', rr_pos);
-            size_t quote1 = obj.find('"', colon);
-            size_t quote2 = obj.find('"', quote1 + 1);
-            if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                config.redact_regexes = obj.substr(quote1 + 1, quote2 - quote1 - 1);
-            }
-        }
-
-        size_t rp_pos = obj.find("\"redact_presets\"");
-        if (rp_pos != std::string::npos) {
-            size_t colon = obj.find(':', rp_pos);
-            size_t quote1 = obj.find('"', colon);
-            size_t quote2 = obj.find('"', quote1 + 1);
-            if (quote1 != std::string::npos && quote2 != std::string::npos) {
-                config.redact_presets = obj.substr(quote1 + 1, quote2 - quote1 - 1);
+#endif
+            if (!config.name.empty()) {
+                configs_.push_back(std::move(config));
             }
-        }
-
-        size_t rco_pos = obj.find("\"redact_cloud_only\"");
-        if (rco_pos != std::string::npos) {
-            size_t colon = obj.find(':', rco_pos);
-            size_t true_pos = obj.find("true", colon);
-            config.redact_cloud_only = (true_pos != std::string::npos && true_pos < obj_end);
-        }
-        
-        if (!config.name.empty()) {
-            configs_.push_back(config);
-        }
-        
-        pos = obj_end + 1;
+            return true;
+        });
+    });
+    if (!ok || !json.at_end()) {
+        if (ok) json.fail("trailing characters after the configuration");
+        g_last_error = json.error();
+        configs_.clear();
+        level_rules_ = LevelRules();
+        return false;
+    }
+    if (!found) {
+        g_last_error = "Missing \"loggers\" array in configuration";
+        return false;
     }
-    
     if (configs_.empty()) {
-        if (g_last_error.empty()) {
-            g_last_error = "No valid logger configurations found";
-        }
+        g_last_error = "No valid logger configurations found";
         return false;
     }
-
     return true;
 }
 
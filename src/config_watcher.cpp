@@ -1,10 +1,50 @@
 #include "Zyrnix/config_watcher.hpp"
+#include "Zyrnix/thread_placement.hpp"
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#include <sys/event.h>
+#define XLOG_HAS_KQUEUE 1
+#endif
 
 namespace Zyrnix {
 
-ConfigWatcher::ConfigWatcher(const std::string& config_path, std::function<void()> on_change, std::chrono::milliseconds poll_interval)
-    : config_path_(config_path), on_change_(on_change), poll_interval_(poll_interval) {}
+namespace {
+
+// The directory holding path, where renames over it show up
+std::string parent_directory(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+std::string file_name(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// A wait that ends debounce after the first event, so a directory that is
+// never quiet (a log written next to the config) still gets checked
+int remaining_ms(std::chrono::steady_clock::time_point due) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(due - std::chrono::steady_clock::now());
+    return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+}
+
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& config_path, std::function<void()> on_change,
+                             std::chrono::milliseconds poll_interval, std::chrono::milliseconds debounce)
+    : config_path_(config_path), on_change_(on_change), poll_interval_(poll_interval), debounce_(debounce) {}
 
 ConfigWatcher::~ConfigWatcher() {
     stop();
@@ -12,26 +52,252 @@ ConfigWatcher::~ConfigWatcher() {
 
 void ConfigWatcher::start() {
     if (running_) return;
+    if (pipe(wake_fds_) != 0) {
+        wake_fds_[0] = wake_fds_[1] = -1;
+    }
+    for (int fd : wake_fds_) {
+        if (fd >= 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    // Taken here, so an edit made right after start() is not missed
+    last_ = read_state();
     running_ = true;
     watcher_thread_ = std::thread(&ConfigWatcher::watch_loop, this);
 }
 
 void ConfigWatcher::stop() {
     running_ = false;
+    if (wake_fds_[1] >= 0) {
+        const char byte = 0;
+        (void)!write(wake_fds_[1], &byte, 1);
+    }
     if (watcher_thread_.joinable()) watcher_thread_.join();
+    for (int& fd : wake_fds_) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+ConfigWatcher::FileState ConfigWatcher::read_state() const {
+    FileState state;
+    struct stat st;
+    // stat() follows a symlinked config to what it points at now
+    if (stat(config_path_.c_str(), &st) != 0) {
+        return state;
+    }
+    state.exists = true;
+    state.device = static_cast<uint64_t>(st.st_dev);
+    state.inode = static_cast<uint64_t>(st.st_ino);
+    state.size = static_cast<int64_t>(st.st_size);
+#if defined(__APPLE__)
+    state.mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    state.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return state;
+}
+
+void ConfigWatcher::check() {
+    const FileState state = read_state();
+    // A file caught mid-deploy (gone) is reloaded once it is back
+    if (!state.exists || state == last_) {
+        return;
+    }
+    last_ = state;
+    if (on_change_) on_change_();
+}
+
+bool ConfigWatcher::wait(std::chrono::milliseconds timeout) {
+    if (!running_) {
+        return false;
+    }
+    if (wake_fds_[0] < 0) {
+        std::this_thread::sleep_for(timeout);
+        return running_;
+    }
+    struct pollfd wake = {wake_fds_[0], POLLIN, 0};
+    poll(&wake, 1, static_cast<int>(timeout.count()));
+    return running_;
 }
 
 void ConfigWatcher::watch_loop() {
+    init_background_thread("xlog-config");
+    if (watch_inotify() || watch_kqueue()) {
+        return;
+    }
+    mode_.store(Mode::Polling, std::memory_order_relaxed);
+    watch_polling();
+}
+
+// An event only marks the directory dirty; check() decides whether the
+// file itself changed. Renames and creations of any name count, which
+// catches a symlinked config whose target was swapped, as Kubernetes does
+// with ConfigMaps; writes count only to the config's own name.
+bool ConfigWatcher::watch_inotify() {
+#ifdef __linux__
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const uint32_t events = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                            IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(fd, parent_directory(config_path_).c_str(), events) < 0) {
+        std::cerr << "ConfigWatcher: cannot watch directory of " << config_path_ << ": " << std::strerror(errno)
+                  << ", polling instead" << std::endl;
+        close(fd);
+        return false;
+    }
+    mode_.store(Mode::Inotify, std::memory_order_relaxed);
+
+    const std::string name = file_name(config_path_);
+    const uint32_t writes = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB;
+    struct pollfd fds[2] = {{fd, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+    const nfds_t count = wake_fds_[0] >= 0 ? 2 : 1;
+    bool dirty = false;
+    bool lost = false;
+    std::chrono::steady_clock::time_point due;
     while (running_) {
-        struct stat st;
-        if (stat(config_path_.c_str(), &st) == 0) {
-            if (last_mtime_ == 0) last_mtime_ = st.st_mtime;
-            if (st.st_mtime != last_mtime_) {
-                last_mtime_ = st.st_mtime;
-                if (on_change_) on_change_();
+        // Idle, sleep until an event or stop()
+        const int timeout = dirty ? remaining_ms(due) : (count == 2 ? -1 : 1000);
+        const int ready = poll(fds, count, timeout);
+        if (ready < 0 && errno != EINTR) {
+            lost = true;
+            break;
+        }
+        if (ready == 0) {
+            if (dirty) {
+                dirty = false;
+                check();
+            }
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            alignas(struct inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+                    offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+                    if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                        lost = true;  // The directory itself went away
+                    } else if ((event->mask & writes) == event->mask && event->len > 0 && name != event->name) {
+                        continue;
+                    }
+                    if (!dirty) {
+                        dirty = true;
+                        due = std::chrono::steady_clock::now() + debounce_;
+                    }
+                }
             }
         }
-        std::this_thread::sleep_for(poll_interval_);
+        if (lost) {
+            break;
+        }
+    }
+    close(fd);
+    if (lost && running_) {
+        mode_.store(Mode::Polling, std::memory_order_relaxed);
+        watch_polling();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// kqueue has no directory-entry names, so it watches the directory for
+// renames and creations and the file for writes, reopening the file
+// whenever it was replaced.
+bool ConfigWatcher::watch_kqueue() {
+#ifdef XLOG_HAS_KQUEUE
+    const int kq = kqueue();
+    if (kq < 0) {
+        return false;
+    }
+    const int dir_fd = open(parent_directory(config_path_).c_str(), O_RDONLY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        close(kq);
+        return false;
+    }
+    mode_.store(Mode::Kqueue, std::memory_order_relaxed);
+
+    struct kevent change;
+    EV_SET(&change, dir_fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE | NOTE_DELETE | NOTE_RENAME, 0, nullptr);
+    kevent(kq, &change, 1, nullptr, 0, nullptr);
+    if (wake_fds_[0] >= 0) {
+        EV_SET(&change, wake_fds_[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+        kevent(kq, &change, 1, nullptr, 0, nullptr);
+    }
+    int file_fd = -1;
+    auto watch_file = [&] {
+        if (file_fd >= 0) {
+            close(file_fd);  // Closing also removes its event
+        }
+        file_fd = open(config_path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_fd >= 0) {
+            struct kevent file_change;
+            EV_SET(&file_change, file_fd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+                   NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME, 0, nullptr);
+            kevent(kq, &file_change, 1, nullptr, 0, nullptr);
+        }
+    };
+    watch_file();
+
+    bool dirty = false;
+    bool lost = false;
+    std::chrono::steady_clock::time_point due;
+    while (running_ && !lost) {
+        const int left = dirty ? remaining_ms(due) : 0;
+        struct timespec timeout = {static_cast<time_t>(left / 1000), static_cast<long>(left % 1000) * 1000000};
+        struct kevent events[8];
+        const int ready = kevent(kq, nullptr, 0, events, 8, dirty ? &timeout : nullptr);
+        if (ready < 0 && errno != EINTR) {
+            lost = true;
+            break;
+        }
+        if (ready == 0) {
+            if (dirty) {
+                dirty = false;
+                watch_file();  // The path may name a new file by now
+                check();
+            }
+            continue;
+        }
+        for (int i = 0; i < ready; ++i) {
+            if (static_cast<int>(events[i].ident) == wake_fds_[0]) {
+                continue;
+            }
+            if (static_cast<int>(events[i].ident) == dir_fd && (events[i].fflags & (NOTE_DELETE | NOTE_RENAME))) {
+                lost = true;  // The directory itself went away
+            }
+            if (!dirty) {
+                dirty = true;
+                due = std::chrono::steady_clock::now() + debounce_;
+            }
+        }
+    }
+    if (file_fd >= 0) {
+        close(file_fd);
+    }
+    close(dir_fd);
+    close(kq);
+    if (lost && running_) {
+        mode_.store(Mode::Polling, std::memory_order_relaxed);
+        watch_polling();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ConfigWatcher::watch_polling() {
+    while (wait(poll_interval_)) {
+        check();
     }
 }
 
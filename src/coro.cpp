@@ -0,0 +1,62 @@
+#include "Zyrnix/coro.hpp"
+#include "Zyrnix/thread_placement.hpp"
+
+namespace Zyrnix {
+
+SinkExecutor& SinkExecutor::instance() {
+    static SinkExecutor* executor = new SinkExecutor();
+    return *executor;
+}
+
+SinkExecutor::SinkExecutor() {
+    std::thread thread(&SinkExecutor::run, this);
+    thread_id_ = thread.get_id();
+    thread.detach();
+}
+
+void SinkExecutor::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ready_.push_back(handle);
+    }
+    cv_.notify_one();
+}
+
+void SinkExecutor::post_at(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        timers_.push(Timer{deadline, timer_seq_++, handle});
+    }
+    cv_.notify_one();
+}
+
+void SinkExecutor::run() {
+    init_background_thread("xlog-coro");
+    std::unique_lock<std::mutex> lock(mtx_);
+    std::deque<std::coroutine_handle<>> batch;
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            ready_.push_back(timers_.top().handle);
+            timers_.pop();
+        }
+        if (ready_.empty()) {
+            if (timers_.empty()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, timers_.top().deadline);
+            }
+            continue;
+        }
+        // Resume outside the lock: coroutines post and set timers themselves
+        batch.swap(ready_);
+        lock.unlock();
+        for (auto handle : batch) {
+            handle.resume();
+        }
+        batch.clear();
+        lock.lock();
+    }
+}
+
+}
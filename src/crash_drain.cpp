@@ -0,0 +1,180 @@
+#include "Zyrnix/crash_drain.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace Zyrnix {
+
+void CrashWriter::write(std::string_view text) {
+    while (!text.empty()) {
+        if (used_ == sizeof(buffer_)) {
+            flush();
+        }
+        const size_t n = std::min(text.size(), sizeof(buffer_) - used_);
+        std::memcpy(buffer_ + used_, text.data(), n);
+        used_ += n;
+        text.remove_prefix(n);
+    }
+}
+
+void CrashWriter::write(unsigned long long value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    write(std::string_view(digits + sizeof(digits) - n, n));
+}
+
+void CrashWriter::flush() {
+#ifndef _WIN32
+    size_t written = 0;
+    while (written < used_) {
+        const ssize_t ret = ::write(fd_, buffer_ + written, used_ - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(ret);
+    }
+#endif
+    used_ = 0;
+}
+
+namespace crash {
+
+namespace {
+
+constexpr int max_sources = 64;
+
+// Plain atomics in static storage, so the handler reads them without
+// locks or allocation
+std::atomic<const void*> sources[max_sources];
+std::atomic<DrainFn> drains[max_sources];
+
+std::atomic<int> crash_fd{-1};
+std::atomic<bool> crashing{false};
+
+#ifndef _WIN32
+constexpr int handled_signals[] = {SIGSEGV, SIGABRT, SIGBUS};
+struct sigaction previous[sizeof(handled_signals) / sizeof(handled_signals[0])];
+
+// Large enough for the drain's CrashWriter; a SIGSEGV from a stack
+// overflow needs somewhere else to run
+alignas(16) char alt_stack[64 * 1024];
+
+void restore_handlers() {
+    for (size_t i = 0; i < sizeof(handled_signals) / sizeof(handled_signals[0]); ++i) {
+        ::sigaction(handled_signals[i], &previous[i], nullptr);
+    }
+}
+
+void on_crash(int sig, siginfo_t*, void*) {
+    // A crash inside the drain itself falls straight through to the
+    // previous handler
+    if (!crashing.exchange(true)) {
+        const int fd = crash_fd.load(std::memory_order_acquire);
+        if (fd >= 0) {
+            {
+                CrashWriter out(fd);
+                out.write("[Zyrnix] caught signal ");
+                out.write(static_cast<unsigned long long>(sig));
+                out.write(", writing out queued records\n");
+            }
+            drain(fd);
+            ::fsync(fd);
+        }
+    }
+    restore_handlers();
+    ::raise(sig);
+}
+#endif
+
+}
+
+int register_source(const void* source, DrainFn drain_fn) {
+    for (int slot = 0; slot < max_sources; ++slot) {
+        const void* expected = nullptr;
+        if (sources[slot].compare_exchange_strong(expected, source, std::memory_order_acq_rel)) {
+            drains[slot].store(drain_fn, std::memory_order_release);
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void unregister_source(int slot) {
+    if (slot < 0 || slot >= max_sources) {
+        return;
+    }
+    drains[slot].store(nullptr, std::memory_order_release);
+    sources[slot].store(nullptr, std::memory_order_release);
+}
+
+void drain(int fd) {
+    CrashWriter out(fd);
+    for (int slot = 0; slot < max_sources; ++slot) {
+        const DrainFn drain_fn = drains[slot].load(std::memory_order_acquire);
+        const void* source = sources[slot].load(std::memory_order_acquire);
+        if (drain_fn && source) {
+            drain_fn(source, out);
+        }
+    }
+}
+
+bool install(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return false;
+#else
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const int old_fd = crash_fd.exchange(fd, std::memory_order_acq_rel);
+    if (old_fd >= 0) {
+        // Already installed: only the file changes
+        ::close(old_fd);
+        return true;
+    }
+
+    stack_t stack{};
+    stack.ss_sp = alt_stack;
+    stack.ss_size = sizeof(alt_stack);
+    ::sigaltstack(&stack, nullptr);
+
+    struct sigaction action{};
+    action.sa_sigaction = on_crash;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(handled_signals) / sizeof(handled_signals[0]); ++i) {
+        ::sigaction(handled_signals[i], &action, &previous[i]);
+    }
+    return true;
+#endif
+}
+
+void uninstall() {
+#ifndef _WIN32
+    const int fd = crash_fd.exchange(-1, std::memory_order_acq_rel);
+    if (fd < 0) {
+        return;
+    }
+    restore_handlers();
+    ::close(fd);
+#endif
+}
+
+}
+
+}
@@ -0,0 +1,74 @@
+#include "Zyrnix/cycle_clock.hpp"
+#include <thread>
+#if defined(XLOG_HAS_RDTSC) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+// An invariant TSC ticks at one rate whatever the core's frequency or
+// sleep state, and is synchronized across cores
+bool invariant_tsc() {
+#if defined(XLOG_HAS_RDTSC) && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000007u) {
+        return false;
+    }
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#elif defined(XLOG_HAS_RDTSC)
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007u) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+struct Reference {
+    uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+};
+
+Reference take_reference() {
+#ifdef XLOG_HAS_RDTSC
+    return Reference{__rdtsc(), std::chrono::steady_clock::now()};
+#else
+    return Reference{0, std::chrono::steady_clock::now()};
+#endif
+}
+
+// Taken at load, so by the first sampled call the span is usually long
+const Reference load_reference = take_reference();
+
+}
+
+const bool CycleClock::uses_tsc_ = invariant_tsc();
+
+double CycleClock::ns_per_tick() {
+#ifdef XLOG_HAS_RDTSC
+    static const double rate = [] {
+        constexpr auto min_span = std::chrono::milliseconds(1);
+        const auto since = std::chrono::steady_clock::now() - load_reference.time;
+        if (since < min_span) {
+            std::this_thread::sleep_for(min_span - since);
+        }
+        const Reference end = take_reference();
+        const double ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end.time - load_reference.time).count());
+        const double ticks = static_cast<double>(end.ticks - load_reference.ticks);
+        return ticks > 0 ? ns / ticks : 1.0;
+    }();
+    return rate;
+#else
+    return 1.0;
+#endif
+}
+
+}
@@ -0,0 +1,121 @@
+#include "Zyrnix/dedup.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <mutex>
+
+namespace Zyrnix {
+
+namespace {
+
+uint64_t line_hash(LogLevel level, std::string_view message) {
+    uint64_t h = std::hash<std::string_view>{}(message) ^ (static_cast<uint64_t>(level) * 0x9e3779b97f4a7c15ull);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h | 1;  // 0 marks an empty slot
+}
+
+void append_time(std::string& out, std::chrono::system_clock::time_point when) {
+    out.append(TimestampCache::local(when));
+    TimestampCache::append_fraction(out, when, TimePrecision::Milliseconds);
+}
+
+}
+
+struct Deduplicator::Slot {
+    std::mutex mtx;
+    uint64_t hash = 0;
+    LogLevel level = LogLevel::Trace;
+    const LogSite* site = nullptr;
+    std::string message;
+    std::chrono::system_clock::time_point window_start;  // When the written line was logged
+    std::chrono::system_clock::time_point first;
+    std::chrono::system_clock::time_point last;
+    uint64_t repeats = 0;
+};
+
+Deduplicator::Deduplicator(const DedupOptions& options)
+    : options_(options)
+    , window_(std::chrono::duration_cast<std::chrono::system_clock::duration>(options.window))
+{
+    const size_t slots = std::bit_ceil(std::max<size_t>(options_.slots, 1));
+    mask_ = slots - 1;
+    slots_ = std::make_unique<Slot[]>(slots);
+}
+
+Deduplicator::~Deduplicator() = default;
+
+// Caller holds slot.mtx
+void Deduplicator::summarize(Slot& slot, std::vector<RepeatSummary>& summaries) const {
+    RepeatSummary summary{slot.level, slot.site, slot.last, slot.repeats, std::string()};
+    summary.message.reserve(slot.message.size() + 96);
+    summary.message.append(slot.message);
+    summary.message.append(" [repeated ");
+    summary.message.append(std::to_string(slot.repeats));
+    summary.message.append(slot.repeats == 1 ? " more time, first " : " more times, first ");
+    append_time(summary.message, slot.first);
+    summary.message.append(", last ");
+    append_time(summary.message, slot.last);
+    summary.message.push_back(']');
+    summaries.push_back(std::move(summary));
+    slot.repeats = 0;
+}
+
+bool Deduplicator::admit(LogLevel level, std::string_view message, const LogSite* site,
+                         std::chrono::system_clock::time_point now,
+                         std::vector<RepeatSummary>& summaries) const {
+    const int64_t ticks = now.time_since_epoch().count();
+    int64_t sweep_at = next_sweep_.load(std::memory_order_relaxed);
+    if (ticks >= sweep_at &&
+        next_sweep_.compare_exchange_strong(sweep_at, ticks + window_.count(), std::memory_order_relaxed)) {
+        drain(now, false, summaries);
+    }
+
+    const uint64_t hash = line_hash(level, message);
+    Slot& slot = slots_[hash & mask_];
+    std::lock_guard<std::mutex> lock(slot.mtx);
+    if (slot.hash == hash && slot.level == level && slot.message == message) {
+        if (now - slot.window_start < window_) {
+            if (slot.repeats++ == 0) {
+                slot.first = now;
+            }
+            slot.last = now;
+            collapsed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Window over: sum up the run and write this line to start the next
+        if (slot.repeats > 0) {
+            summarize(slot, summaries);
+        }
+        slot.window_start = now;
+        slot.site = site;
+        return true;
+    }
+
+    if (slot.repeats > 0) {
+        summarize(slot, summaries);
+    }
+    slot.hash = hash;
+    slot.level = level;
+    slot.site = site;
+    slot.message.assign(message);  // Reuses the slot's capacity
+    slot.window_start = now;
+    return true;
+}
+
+void Deduplicator::drain(std::chrono::system_clock::time_point now, bool all,
+                         std::vector<RepeatSummary>& summaries) const {
+    for (size_t i = 0; i <= mask_; ++i) {
+        Slot& slot = slots_[i];
+        std::lock_guard<std::mutex> lock(slot.mtx);
+        if (slot.repeats > 0 && (all || now - slot.window_start >= window_)) {
+            summarize(slot, summaries);
+            // Forget the line, so its next repeat is written again
+            slot.hash = 0;
+        }
+    }
+}
+
+}
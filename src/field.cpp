@@ -0,0 +1,76 @@
+#include "Zyrnix/field.hpp"
+#include "Zyrnix/json_escape.hpp"
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+namespace Zyrnix {
+
+void FieldValue::append_json(std::string& out) const {
+    if (type_ == FieldType::String) {
+        json::append_string(out, text_);
+    } else {
+        out.append(text_);
+    }
+}
+
+namespace {
+
+struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+// Never destroyed: records may still name their keys during exit
+struct KeyTable {
+    std::mutex mtx;
+    std::unordered_set<std::string, KeyHash, std::equal_to<>> keys;  // Nodes never move
+};
+
+KeyTable& key_table() {
+    static KeyTable* table = new KeyTable;
+    return *table;
+}
+
+}
+
+std::string_view intern_field_key(std::string_view key) {
+    // Keyed by where the caller's key is; the compare catches a buffer
+    // that now holds another key
+    struct Slot {
+        const char* source = nullptr;
+        std::string_view interned;
+    };
+    thread_local std::array<Slot, 64> cache;
+    Slot& slot = cache[(reinterpret_cast<uintptr_t>(key.data()) >> 3 ^ key.size()) % cache.size()];
+    if (slot.source == key.data() && slot.interned == key) {
+        return slot.interned;
+    }
+
+    KeyTable& table = key_table();
+    std::string_view interned;
+    {
+        std::lock_guard<std::mutex> lock(table.mtx);
+        auto it = table.keys.find(key);
+        if (it == table.keys.end()) {
+            it = table.keys.emplace(key).first;
+        }
+        interned = *it;
+    }
+    slot = {key.data(), interned};
+    return interned;
+}
+
+void FieldList::spill(Entry&& next) {
+    heap_.reserve(inline_capacity * 2);
+    for (auto& entry : *this) {
+        heap_.push_back(std::move(entry));
+    }
+    for (; size_ > 0; --size_) {
+        slots_[size_ - 1].~Entry();
+    }
+    heap_.push_back(std::move(next));
+}
+
+}
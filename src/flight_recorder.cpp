@@ -0,0 +1,108 @@
+#include "Zyrnix/flight_recorder.hpp"
+#include "Zyrnix/binary_log.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Zyrnix::flight {
+
+Reader::Reader(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size) {
+        ::close(fd);
+        return;
+    }
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    const auto* header = static_cast<const Header*>(map);
+    const uint64_t capacity = header->capacity;
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+        header->version.load(std::memory_order_acquire) != format_version ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        header_size + capacity > static_cast<uint64_t>(st.st_size)) {
+        munmap(map, static_cast<size_t>(st.st_size));
+        return;
+    }
+    header_ = header;
+    data_ = static_cast<const char*>(map) + header_size;
+    mapped_size_ = static_cast<size_t>(st.st_size);
+    madvise(map, mapped_size_, MADV_SEQUENTIAL);
+}
+
+Reader::~Reader() {
+    if (header_) {
+        munmap(const_cast<Header*>(header_), mapped_size_);
+    }
+}
+
+uint64_t Reader::generation() const {
+    return header_ ? header_->generation : 0;
+}
+
+uint64_t Reader::capacity() const {
+    return header_ ? header_->capacity : 0;
+}
+
+bool Reader::entry_at(uint64_t pos, uint64_t head, Record& record, bool& is_record, uint64_t& next) {
+    const uint64_t capacity = header_->capacity;
+    const uint64_t offset = pos & (capacity - 1);
+    if (capacity - offset < entry_header_size) {
+        return false;
+    }
+    const char* entry = data_ + offset;
+    uint64_t commit;
+    uint32_t size;
+    uint32_t crc;
+    std::memcpy(&commit, entry, sizeof(commit));
+    std::memcpy(&size, entry + 8, sizeof(size));
+    std::memcpy(&crc, entry + 12, sizeof(crc));
+    if (commit != pos + 1) {
+        return false;
+    }
+    const bool padding = (size & padding_flag) != 0;
+    size &= ~padding_flag;
+    const uint64_t total = (entry_header_size + size + entry_alignment - 1) & ~static_cast<uint64_t>(entry_alignment - 1);
+    if (total > capacity - offset || pos + total > head) {
+        return false;
+    }
+    next = pos + total;
+    if (padding) {
+        return true;
+    }
+
+    const char* payload = entry + entry_header_size;
+    if (size < record_header_size || binlog::crc32c(payload, size) != crc) {
+        ++damaged_;
+        return true;
+    }
+    int64_t ns;
+    uint32_t generation;
+    uint16_t name_size;
+    std::memcpy(&ns, payload, sizeof(ns));
+    std::memcpy(&record.thread_id, payload + 8, sizeof(record.thread_id));
+    std::memcpy(&generation, payload + 16, sizeof(generation));
+    std::memcpy(&name_size, payload + 22, sizeof(name_size));
+    if (record_header_size + name_size > size) {
+        ++damaged_;
+        return true;
+    }
+    record.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    record.level = static_cast<LogLevel>(static_cast<uint8_t>(payload[20]));
+    record.generation = generation;
+    record.logger_name = std::string_view(payload + record_header_size, name_size);
+    record.message = std::string_view(payload + record_header_size + name_size, size - record_header_size - name_size);
+    is_record = true;
+    return true;
+}
+
+}
@@ -0,0 +1,147 @@
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/json_escape.hpp"
+#include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/cycle_clock.hpp"
+#include <atomic>
+
+namespace Zyrnix {
+
+namespace {
+
+thread_local SinkMetrics* format_meter = nullptr;
+
+void render(std::string& out, const Formatter& formatter, std::chrono::system_clock::time_point timestamp,
+            std::string_view logger_name, LogLevel level, std::string_view message, uint64_t thread_id,
+            const LogSite* site, const TraceContext* trace, const StackTrace* stack) {
+    if (!format_meter) {
+        formatter.format_to(out, timestamp, logger_name, level, message, thread_id, site, trace, stack);
+        return;
+    }
+    const uint64_t start = CycleClock::now();
+    formatter.format_to(out, timestamp, logger_name, level, message, thread_id, site, trace, stack);
+    format_meter->record_format_ns(CycleClock::to_ns(CycleClock::now() - start));
+}
+
+// Past this a buffer is released on reset rather than kept, so one huge
+// line does not pin its size for the thread's lifetime
+constexpr size_t max_kept_capacity = 64 * 1024;
+
+void clear_keeping(std::string& buffer) {
+    if (buffer.capacity() > max_kept_capacity) {
+        std::string().swap(buffer);
+    } else {
+        buffer.clear();
+    }
+}
+
+std::atomic<size_t> render_high_water{0};
+
+thread_local RenderCache thread_cache;
+thread_local bool thread_cache_lent = false;
+
+}
+
+void RenderCache::reset() {
+    note_high_water();
+    layout_ = nullptr;
+    clear_keeping(text_);
+    // The layouts stay, so a thread writing to sinks of several layouts
+    // does not copy their patterns and regrow their lines every record
+    for (size_t i = 0; i < other_count_; ++i) {
+        clear_keeping(other_layouts_[i].second);
+    }
+    other_count_ = 0;
+    clear_keeping(fields_json_);
+    fields_json_ready_ = false;
+}
+
+void RenderCache::note_high_water() const {
+    size_t held = text_.capacity() + fields_json_.capacity();
+    for (size_t i = 0; i < other_count_; ++i) {
+        held += other_layouts_[i].second.capacity();
+    }
+    // A relaxed load per record; the store only while the mark is rising
+    size_t mark = render_high_water.load(std::memory_order_relaxed);
+    while (held > mark && !render_high_water.compare_exchange_weak(mark, held, std::memory_order_relaxed)) {
+    }
+}
+
+size_t RenderCache::high_water_bytes() {
+    return render_high_water.load(std::memory_order_relaxed);
+}
+
+ScopedRenderCache::ScopedRenderCache() {
+    if (thread_cache_lent) {
+        nested_ = std::make_unique<RenderCache>();
+        cache_ = nested_.get();
+        return;
+    }
+    thread_cache_lent = true;
+    thread_cache.reset();
+    cache_ = &thread_cache;
+}
+
+ScopedRenderCache::~ScopedRenderCache() {
+    if (nested_) {
+        nested_->note_high_water();
+    } else {
+        thread_cache_lent = false;
+    }
+}
+
+FormatTiming::FormatTiming(SinkMetrics* meter) : previous_(format_meter) {
+    format_meter = meter;
+}
+
+FormatTiming::~FormatTiming() {
+    format_meter = previous_;
+}
+
+const FormattedRecord::Fields& FormattedRecord::fields() const {
+    static const Fields none;
+    return fields_ ? *fields_ : none;
+}
+
+const std::string& FormattedRecord::formatted(const Formatter& formatter) const {
+    const std::string& layout = formatter.layout();
+    RenderCache& cache = *cache_;
+    if (cache.layout_ == nullptr) {
+        render(cache.text_, formatter, timestamp_, logger_name_, level_, message_, thread_id_, site_, trace_, stack_);
+        cache.layout_ = &layout;
+        return cache.text_;
+    }
+    if (cache.layout_ == &layout || *cache.layout_ == layout) {
+        return cache.text_;
+    }
+    auto& others = cache.other_layouts_;
+    for (size_t i = 0; i < cache.other_count_; ++i) {
+        if (others[i].first == layout) {
+            return others[i].second;
+        }
+    }
+    if (cache.other_count_ == others.size()) {
+        others.emplace_back();
+    }
+    auto& [other, text] = others[cache.other_count_++];
+    if (other != layout) {
+        other.assign(layout);
+    }
+    render(text, formatter, timestamp_, logger_name_, level_, message_, thread_id_, site_, trace_, stack_);
+    return text;
+}
+
+const std::string& FormattedRecord::fields_json() const {
+    RenderCache& cache = *cache_;
+    if (!cache.fields_json_ready_) {
+        for (const auto& [key, value] : fields()) {
+            cache.fields_json_.push_back(',');
+            json::append_string(cache.fields_json_, key);
+            cache.fields_json_.push_back(':');
+            value.append_json(cache.fields_json_);
+        }
+        cache.fields_json_ready_ = true;
+    }
+    return cache.fields_json_;
+}
+
+}
@@ -1,33 +1,104 @@
 #include "Zyrnix/formatter.hpp"
+#include "Zyrnix/log_clock.hpp"
 #include "Zyrnix/log_level.hpp"
+#include "Zyrnix/stack_trace.hpp"
+#include "Zyrnix/aho_corasick.hpp"
+#include "Zyrnix/util.hpp"
 #include <chrono>
-#include <iomanip>
-#include <sstream>
 
 namespace Zyrnix {
 
+namespace {
+
+const std::string& pattern_for(TimePrecision precision) {
+    static const std::string seconds = Formatter::default_pattern;
+    static const std::string millis = "%Y-%m-%d %H:%M:%S.%e [%l] %n: %v";
+    static const std::string micros = "%Y-%m-%d %H:%M:%S.%f [%l] %n: %v";
+    switch (precision) {
+        case TimePrecision::Milliseconds: return millis;
+        case TimePrecision::Microseconds: return micros;
+        default: return seconds;
+    }
+}
+
+}
+
+// Every sink holds a Formatter, so the default layout is the compiled one
+Formatter::Formatter() : Formatter(compiled<"%Y-%m-%d %H:%M:%S [%l] %n: %v">()) {}
+
+Formatter::Formatter(std::string pattern) : pattern_(std::move(pattern)) {
+    pattern::parse(pattern_, [this](const pattern::Item& item) {
+        items_.push_back(item);
+        uses_datetime_ = uses_datetime_ || pattern::is_date_flag(item.flag);
+    });
+}
+
+Formatter::Formatter(TimePrecision precision) : Formatter(pattern_for(precision)) {}
+
 std::string Formatter::format(const std::string& logger_name, LogLevel level, const std::string& message) {
-    auto now = std::chrono::system_clock::now();
-    auto t = std::chrono::system_clock::to_time_t(now);
-    std::tm buf;
-    localtime_r(&t, &buf);
-    std::stringstream ss;
-    ss << std::put_time(&buf, "%Y-%m-%d %H:%M:%S");
-    ss << " [" << to_string(level) << "] ";
-    ss << logger_name << ": " << message;
-    return ss.str();
+    return format(LogClock::now(), logger_name, level, message, current_thread_id(), nullptr,
+                  &TraceContext::current());
 }
 
-std::string Formatter::redact(const std::string& message, const std::vector<std::string>& patterns) {
-    std::string redacted = message;
-    for (const auto& pat : patterns) {
-        size_t pos = 0;
-        while ((pos = redacted.find(pat, pos)) != std::string::npos) {
-            redacted.replace(pos, pat.length(), std::string(pat.length(), '*'));
-            pos += pat.length();
+std::string Formatter::format(std::chrono::system_clock::time_point timestamp, std::string_view logger_name,
+                              LogLevel level, std::string_view message) const {
+    return format(timestamp, logger_name, level, message, current_thread_id(), nullptr, &TraceContext::current());
+}
+
+std::string Formatter::format(std::chrono::system_clock::time_point timestamp, std::string_view logger_name,
+                              LogLevel level, std::string_view message, uint64_t thread_id,
+                              const LogSite* site, const TraceContext* trace) const {
+    std::string out;
+    format_to(out, timestamp, logger_name, level, message, thread_id, site, trace);
+    return out;
+}
+
+void Formatter::format_to(std::string& out, std::chrono::system_clock::time_point timestamp,
+                          std::string_view logger_name, LogLevel level, std::string_view message,
+                          uint64_t thread_id, const LogSite* site, const TraceContext* trace,
+                          const StackTrace* stack) const {
+    pattern::Context ctx{timestamp, {}, logger_name, level, message, thread_id, site, trace};
+    if (uses_datetime_) {
+        ctx.datetime = TimestampCache::local(timestamp);
+    }
+    // Literals, the date and the level all fit in the pattern's length
+    // plus a little, so a line grows the buffer at most once
+    out.reserve(out.size() + pattern_.size() + logger_name.size() + message.size() + 32);
+    render(out, ctx);
+    if (stack) {
+        for (const auto& frame : stack->frames()) {
+            out.append("\n    ");
+            out.append(frame);
         }
     }
-    return redacted;
+}
+
+void Formatter::render(std::string& out, const pattern::Context& ctx) const {
+    if (compiled_) {
+        compiled_(out, ctx);
+        return;
+    }
+    for (const auto& item : items_) {
+        if (item.flag == pattern::Flag::Literal) {
+            out.append(pattern_, item.offset, item.length);
+        } else {
+            pattern::write_flag(out, item.flag, ctx);
+        }
+    }
+}
+
+std::string Formatter::redact(const std::string& message, const std::vector<std::string>& patterns) {
+    // Callers pass the same pattern list over and over, so keep the
+    // automaton for the last list seen on this thread.
+    thread_local std::vector<std::string> cached_patterns;
+    thread_local AhoCorasick matcher;
+    if (patterns != cached_patterns) {
+        cached_patterns = patterns;
+        matcher = AhoCorasick(patterns);
+    }
+
+    std::string redacted;
+    return matcher.mask(message, redacted) ? redacted : message;
 }
 
 }
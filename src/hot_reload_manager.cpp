@@ -33,21 +33,45 @@ void HotReloadManager::reload() {
         return;
     }
 
-    loggers_ = ConfigLoader::create_loggers();
+    std::map<std::string, Running> next;
+    std::map<std::string, std::shared_ptr<Logger>> created;
+    for (const auto& config : ConfigLoader::get_logger_configs()) {
+        auto it = running_.find(config.name);
+        if (it != running_.end() && ConfigLoader::reconfigure(*it->second.logger, it->second.config, config)) {
+            next[config.name] = Running{config, it->second.logger};
+            ++loggers_updated_;
+            continue;
+        }
+        auto logger = ConfigLoader::create_logger(config);
+        created[config.name] = logger;
+        next[config.name] = Running{config, std::move(logger)};
+        ++loggers_rebuilt_;
+    }
+    std::vector<std::string> dropped;
+    for (const auto& [name, running] : running_) {
+        if (!next.count(name)) {
+            dropped.push_back(name);
+        }
+    }
+    // Rules first, over the loggers kept; update() applies them to the new ones
+    LoggerRegistry::instance().set_level_rules(ConfigLoader::get_level_rules());
+    LoggerRegistry::instance().update(created, dropped);
+    running_ = std::move(next);
     last_reload_time_ = std::chrono::system_clock::now();
     ++reload_successes_;
     std::cout << "Reloaded logger configuration from: " << config_path_ << std::endl;
 }
 
 std::shared_ptr<Logger> HotReloadManager::get_logger(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto it = loggers_.find(name);
-    return (it != loggers_.end()) ? it->second : nullptr;
+    return LoggerRegistry::instance().get(name);
+}
+
+LoggerHandle HotReloadManager::get_handle(const std::string& name) {
+    return LoggerRegistry::instance().handle(name);
 }
 
 std::map<std::string, std::shared_ptr<Logger>> HotReloadManager::get_all_loggers() {
-    std::lock_guard<std::mutex> lock(mtx_);
-    return loggers_;
+    return LoggerRegistry::instance().get_all();
 }
 
 } // namespace Zyrnix
@@ -0,0 +1,46 @@
+#include "Zyrnix/interned_name.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace Zyrnix {
+
+namespace {
+
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+struct NameTable {
+    std::mutex mtx;
+    // Keyed by views of the names themselves, which never move
+    std::unordered_map<std::string_view, const InternedName*, StringHash, std::equal_to<>> names;
+};
+
+// Leaked, like the names: loggers in static storage may log during exit
+NameTable& table() {
+    static auto* t = new NameTable;
+    return *t;
+}
+
+}
+
+const InternedName& InternedName::intern(std::string_view name) {
+    NameTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mtx);
+    auto it = t.names.find(name);
+    if (it != t.names.end()) {
+        return *it->second;
+    }
+    const auto* interned = new InternedName{std::string(name), static_cast<uint32_t>(t.names.size())};
+    t.names.emplace(interned->text, interned);
+    return *interned;
+}
+
+uint32_t InternedName::count() {
+    NameTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mtx);
+    return static_cast<uint32_t>(t.names.size());
+}
+
+}
@@ -0,0 +1,160 @@
+#include "Zyrnix/json_escape.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define XLOG_JSON_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define XLOG_JSON_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Zyrnix {
+namespace json {
+
+namespace {
+
+inline bool needs_escape(char c) {
+    const auto byte = static_cast<unsigned char>(c);
+    return byte < 0x20 || byte == '"' || byte == '\\';
+}
+
+size_t scan_scalar(const char* p, size_t size, size_t from) {
+    for (size_t i = from; i < size; ++i) {
+        if (needs_escape(p[i])) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#if defined(XLOG_JSON_X86)
+size_t scan_sse2(const char* p, size_t size) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        // Unsigned v <= 0x1F is max(v, 0x1F) == 0x1F
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                          _mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+        const int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+    return scan_scalar(p, size, i);
+}
+
+__attribute__((target("avx2")))
+size_t scan_avx2(const char* p, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i hits =
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+                            _mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control));
+        const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    return i + scan_sse2(p + i, size - i);
+}
+#endif
+
+#if defined(XLOG_JSON_NEON)
+size_t scan_neon(const char* p, size_t size) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + i));
+        const uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)), vcltq_u8(v, space));
+        if (vmaxvq_u8(hits) != 0) {
+            return scan_scalar(p, i + 16, i);
+        }
+    }
+    return scan_scalar(p, size, i);
+}
+#endif
+
+#if !defined(XLOG_JSON_X86) && !defined(XLOG_JSON_NEON)
+size_t scan_portable(const char* p, size_t size) {
+    return scan_scalar(p, size, 0);
+}
+#endif
+
+using ScanFn = size_t (*)(const char*, size_t);
+
+struct Kernel {
+    ScanFn scan;
+    const char* name;
+};
+
+Kernel select_kernel() {
+#if defined(XLOG_JSON_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {scan_avx2, "avx2"};
+    }
+    return {scan_sse2, "sse2"};
+#elif defined(XLOG_JSON_NEON)
+    return {scan_neon, "neon"};
+#else
+    return {scan_portable, "scalar"};
+#endif
+}
+
+const Kernel& kernel() {
+    static const Kernel k = select_kernel();
+    return k;
+}
+
+void append_escape(std::string& out, char c) {
+    switch (c) {
+        case '"': out.append("\\\"", 2); return;
+        case '\\': out.append("\\\\", 2); return;
+        case '\n': out.append("\\n", 2); return;
+        case '\r': out.append("\\r", 2); return;
+        case '\t': out.append("\\t", 2); return;
+        case '\b': out.append("\\b", 2); return;
+        case '\f': out.append("\\f", 2); return;
+        default: {
+            static constexpr char hex[] = "0123456789abcdef";
+            const auto byte = static_cast<unsigned char>(c);
+            const char escaped[6] = {'\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xF]};
+            out.append(escaped, sizeof(escaped));
+        }
+    }
+}
+
+}
+
+size_t find_escape(std::string_view text) {
+    return kernel().scan(text.data(), text.size());
+}
+
+const char* escape_kernel_name() {
+    return kernel().name;
+}
+
+void append_escaped(std::string& out, std::string_view text) {
+    const ScanFn scan = kernel().scan;
+    while (!text.empty()) {
+        const size_t run = scan(text.data(), text.size());
+        out.append(text.data(), run);
+        if (run == text.size()) {
+            return;
+        }
+        append_escape(out, text[run]);
+        text.remove_prefix(run + 1);
+    }
+}
+
+}
+}
@@ -0,0 +1,191 @@
+#include "Zyrnix/keyed_rate_limiter.hpp"
+#include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/log_site.hpp"
+#include "Zyrnix/rate_limiter.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr size_t group_size = 8;
+constexpr uint64_t ticks_per_second = 16'000'000'000ull;  // As in RateLimiter
+constexpr uint64_t report_every = 1024;
+constexpr size_t max_label = 80;
+
+uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h | 1;  // 0 marks an empty slot
+}
+
+uint64_t hash_text(std::string_view text) {
+    return mix(std::hash<std::string_view>{}(text));
+}
+
+// Drop counts at which a key is reported: powers of two, then every 1024
+bool is_report_point(uint64_t dropped) {
+    return dropped <= report_every ? std::has_single_bit(dropped) : dropped % report_every == 0;
+}
+
+uint64_t previous_report_point(uint64_t dropped) {
+    return dropped <= report_every ? dropped / 2 : dropped - report_every;
+}
+
+}
+
+struct KeyedRateLimiter::Slot {
+    std::atomic<uint64_t> key{0};
+    std::atomic<uint64_t> full_at{0};  // As in RateLimiter: the time the bucket is full again
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint8_t> referenced{0};
+};
+
+KeyedRateLimiter::KeyedRateLimiter(const KeyedRateLimiterOptions& options)
+    : options_(options)
+    , epoch_ns_(monotonic_coarse_ns())
+{
+    const size_t rate = options_.messages_per_second;
+    const size_t burst = options_.burst_capacity > 0 ? options_.burst_capacity : rate;
+    interval_ = rate > 0 ? std::max<uint64_t>(ticks_per_second / rate, 1) : 1;
+    tolerance_ = burst <= UINT64_MAX / 4 / interval_ ? burst * interval_ : UINT64_MAX / 4;
+
+    const size_t groups = std::bit_ceil(std::max<size_t>((options_.capacity + group_size - 1) / group_size, 1));
+    slot_count_ = groups * group_size;
+    set_mask_ = groups - 1;
+    slots_ = std::make_unique<Slot[]>(slot_count_);
+    hands_ = std::make_unique<std::atomic<uint8_t>[]>(groups);
+
+#ifndef XLOG_NO_METRICS
+    if (!options_.metrics_name.empty()) {
+        metrics_ = MetricsRegistry::instance().get_limiter_metrics(options_.metrics_name);
+    }
+#endif
+}
+
+KeyedRateLimiter::~KeyedRateLimiter() = default;
+
+uint64_t KeyedRateLimiter::now_ticks() const {
+    if (options_.messages_per_second == 0) {
+        return 0;
+    }
+    return (monotonic_coarse_ns() - epoch_ns_) * 16;
+}
+
+KeyedRateLimiter::Slot* KeyedRateLimiter::find_or_claim(uint64_t hash) const {
+    const size_t group_index = static_cast<size_t>(hash >> 7) & set_mask_;
+    Slot* group = &slots_[group_index * group_size];
+    for (size_t i = 0; i < group_size; ++i) {
+        if (group[i].key.load(std::memory_order_relaxed) == hash) {
+            if (!group[i].referenced.load(std::memory_order_relaxed)) {
+                group[i].referenced.store(1, std::memory_order_relaxed);
+            }
+            return &group[i];
+        }
+    }
+
+    auto claim = [hash](Slot& slot, uint64_t expected) {
+        if (!slot.key.compare_exchange_strong(expected, hash, std::memory_order_relaxed)) {
+            return false;
+        }
+        // A full bucket for the new key
+        slot.full_at.store(0, std::memory_order_relaxed);
+        slot.dropped.store(0, std::memory_order_relaxed);
+        slot.referenced.store(1, std::memory_order_relaxed);
+        return true;
+    };
+    for (size_t i = 0; i < group_size; ++i) {
+        if (group[i].key.load(std::memory_order_relaxed) == 0 && claim(group[i], 0)) {
+            return &group[i];
+        }
+    }
+
+    // Clock sweep: a key seen since the hand last passed gets a second chance
+    std::atomic<uint8_t>& hand = hands_[group_index];
+    for (;;) {
+        Slot& slot = group[hand.fetch_add(1, std::memory_order_relaxed) % group_size];
+        if (slot.referenced.exchange(0, std::memory_order_relaxed)) {
+            continue;
+        }
+        if (claim(slot, slot.key.load(std::memory_order_relaxed))) {
+            return &slot;
+        }
+    }
+}
+
+bool KeyedRateLimiter::admit(uint64_t hash, const RecordView* view, std::string_view key) const {
+    Slot* slot = find_or_claim(hash);
+    const uint64_t now = now_ticks();
+    uint64_t full_at = slot->full_at.load(std::memory_order_relaxed);
+    for (;;) {
+        const uint64_t start = std::max(full_at, now);
+        if (start - now + interval_ > tolerance_) {
+            break;
+        }
+        if (slot->full_at.compare_exchange_weak(full_at, start + interval_, std::memory_order_relaxed,
+                                                std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t dropped = slot->dropped.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (metrics_ && is_report_point(dropped)) {
+        report(view, key, dropped);
+    }
+    return false;
+}
+
+// Runs a few times per key, so it can afford to build the label
+void KeyedRateLimiter::report(const RecordView* view, std::string_view key, uint64_t dropped) const {
+#ifndef XLOG_NO_METRICS
+    std::string label;
+    if (view && options_.key_by == KeyedRateLimiterOptions::KeyBy::Site && view->site) {
+        label.assign(view->site->file_name());
+        label += ':';
+        label += std::to_string(view->site->line);
+    } else {
+        label.assign(key.substr(0, max_label));
+    }
+    metrics_->record_offender(label, dropped, dropped - previous_report_point(dropped));
+#else
+    (void)view;
+    (void)key;
+    (void)dropped;
+#endif
+}
+
+bool KeyedRateLimiter::try_log(std::string_view key) const {
+    return admit(hash_text(key), nullptr, key);
+}
+
+FilterVerdict KeyedRateLimiter::prefilter(const RecordView& view) const {
+    using KeyBy = KeyedRateLimiterOptions::KeyBy;
+    switch (options_.key_by) {
+        case KeyBy::Site:
+            if (view.site) {
+                return admit(mix(reinterpret_cast<uintptr_t>(view.site)), &view, view.message)
+                           ? FilterVerdict::Accept : FilterVerdict::Reject;
+            }
+            break;  // Keyed on the message instead
+        case KeyBy::Field: {
+            const std::string* value = view.field(options_.field);
+            if (!value) {
+                return FilterVerdict::Accept;
+            }
+            return admit(hash_text(*value), &view, *value) ? FilterVerdict::Accept : FilterVerdict::Reject;
+        }
+        case KeyBy::Message:
+            break;
+    }
+    return admit(hash_text(view.message), &view, view.message) ? FilterVerdict::Accept : FilterVerdict::Reject;
+}
+
+bool KeyedRateLimiter::should_log(const LogRecord& record) const {
+    return prefilter(RecordView(record)) == FilterVerdict::Accept;
+}
+
+}
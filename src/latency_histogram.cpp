@@ -0,0 +1,63 @@
+#include "Zyrnix/latency_histogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Zyrnix {
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < 2 * sub_buckets) {
+        return index;
+    }
+    const uint64_t shift = index / sub_buckets - 1;
+    const uint64_t mantissa = index - shift * sub_buckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snap;
+    snap.buckets.resize(bucket_count);
+    // count is summed from the buckets so that percentiles agree with it
+    for (size_t i = 0; i < bucket_count; ++i) {
+        snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        snap.count += snap.buckets[i];
+    }
+    snap.sum_ns = sum_.load(std::memory_order_relaxed);
+    snap.max_ns = max_.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    const double clamped = std::clamp(q, 0.0, 1.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // The bucket's top, but never past the largest value seen
+            return max_ns > 0 ? std::min(bucket_upper_bound(i), max_ns) : bucket_upper_bound(i);
+        }
+    }
+    return max_ns;
+}
+
+uint64_t LatencyHistogram::Snapshot::count_at_most(uint64_t limit_ns) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < buckets.size() && bucket_upper_bound(i) <= limit_ns; ++i) {
+        total += buckets[i];
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,108 @@
+#include "Zyrnix/level_rules.hpp"
+#include <algorithm>
+
+namespace Zyrnix {
+
+namespace {
+
+std::vector<std::string_view> split(std::string_view name) {
+    std::vector<std::string_view> segments;
+    size_t start = 0;
+    while (true) {
+        const size_t dot = name.find('.', start);
+        segments.push_back(name.substr(start, dot == std::string_view::npos ? std::string_view::npos : dot - start));
+        if (dot == std::string_view::npos) {
+            return segments;
+        }
+        start = dot + 1;
+    }
+}
+
+// A match's rank: one bit per leading segment matched literally, first
+// segment highest, then the pattern's length in the low bits
+constexpr size_t ranked_segments = 58;
+
+uint64_t rank(uint64_t literals, size_t pattern_length) {
+    return literals | std::min<uint64_t>(pattern_length, 63);
+}
+
+}
+
+bool LevelRules::add(std::string_view pattern, LogLevel level) {
+    const std::vector<std::string_view> segments = split(pattern);
+    if (std::any_of(segments.begin(), segments.end(), [](std::string_view s) { return s.empty(); })) {
+        return false;
+    }
+
+    uint32_t node = 0;
+    const bool trailing_star = segments.back() == "*";
+    const size_t literal_end = segments.size() - (trailing_star ? 1 : 0);
+    for (size_t i = 0; i < literal_end; ++i) {
+        uint32_t next;
+        if (segments[i] == "*") {
+            next = nodes_[node].star;
+            if (next == none) {
+                next = static_cast<uint32_t>(nodes_.size());
+                nodes_[node].star = next;
+                nodes_.emplace_back();
+            }
+        } else {
+            auto it = nodes_[node].children.find(segments[i]);
+            if (it != nodes_[node].children.end()) {
+                next = it->second;
+            } else {
+                next = static_cast<uint32_t>(nodes_.size());
+                nodes_[node].children.emplace(std::string(segments[i]), next);
+                nodes_.emplace_back();
+            }
+        }
+        node = next;
+    }
+    (trailing_star ? nodes_[node].subtree : nodes_[node].exact) = static_cast<uint8_t>(level);
+    patterns_.insert_or_assign(std::string(pattern), level);
+    return true;
+}
+
+std::optional<LogLevel> LevelRules::match(std::string_view name) const {
+    if (patterns_.empty()) {
+        return std::nullopt;
+    }
+    const std::vector<std::string_view> segments = split(name);
+    uint64_t best = 0;
+    uint8_t level = unset;
+    match(0, segments, 0, 0, best, level);
+    if (level == unset) {
+        return std::nullopt;
+    }
+    return static_cast<LogLevel>(level);
+}
+
+// depth segments are consumed; literals has a bit for each that was
+// matched by name rather than by "*"
+void LevelRules::match(uint32_t node, const std::vector<std::string_view>& segments, size_t depth, uint64_t literals,
+                       uint64_t& best, uint8_t& level) const {
+    const Node& at = nodes_[node];
+    auto consider = [&](uint8_t candidate, size_t pattern_length) {
+        const uint64_t score = rank(literals, pattern_length);
+        if (candidate != unset && score > best) {
+            best = score;
+            level = candidate;
+        }
+    };
+    if (depth == segments.size()) {
+        consider(at.exact, depth);
+        return;
+    }
+    consider(at.subtree, depth + 1);
+
+    auto it = at.children.find(segments[depth]);
+    if (it != at.children.end()) {
+        const uint64_t bit = depth < ranked_segments ? uint64_t{1} << (63 - depth) : 0;
+        match(it->second, segments, depth + 1, literals | bit, best, level);
+    }
+    if (at.star != none) {
+        match(at.star, segments, depth + 1, literals, best, level);
+    }
+}
+
+}
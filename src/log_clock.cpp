@@ -0,0 +1,94 @@
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/cycle_clock.hpp"
+#include <ctime>
+
+namespace Zyrnix {
+
+namespace {
+
+// The wall time at one tick count, under a seqlock: readers retry while
+// sequence is odd or changed under them
+struct Anchor {
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<int64_t> wall_ns{0};
+    std::atomic<uint64_t> stale_after{0};  // Ticks since the anchor after which to re-take it
+    std::atomic<double> ns_per_tick{1.0};
+    std::atomic<bool> updating{false};
+};
+
+Anchor anchor;
+
+int64_t system_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// One thread at a time; the others keep using the old anchor meanwhile
+void take_anchor() {
+    if (anchor.updating.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+    const uint64_t ticks = CycleClock::now();
+    const int64_t wall = system_ns();
+    const uint32_t sequence = anchor.sequence.load(std::memory_order_relaxed);
+    anchor.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    anchor.ticks.store(ticks, std::memory_order_relaxed);
+    anchor.wall_ns.store(wall, std::memory_order_relaxed);
+    anchor.sequence.store(sequence + 2, std::memory_order_release);
+    anchor.updating.store(false, std::memory_order_release);
+}
+
+}
+
+std::atomic<ClockSource> LogClock::source_{ClockSource::Precise};
+
+void LogClock::set_source(ClockSource source) {
+#ifndef CLOCK_REALTIME_COARSE
+    if (source == ClockSource::Coarse) {
+        source = ClockSource::Precise;
+    }
+#endif
+    if (source == ClockSource::Tsc) {
+        if (!CycleClock::uses_tsc()) {
+            source = ClockSource::Precise;
+        } else {
+            const double rate = CycleClock::ns_per_tick();
+            anchor.ns_per_tick.store(rate, std::memory_order_relaxed);
+            anchor.stale_after.store(static_cast<uint64_t>(1e9 / rate), std::memory_order_relaxed);
+            take_anchor();
+        }
+    }
+    source_.store(source, std::memory_order_release);
+}
+
+void LogClock::resync() {
+    if (source() == ClockSource::Tsc) {
+        take_anchor();
+    }
+}
+
+LogClock::time_point LogClock::tsc_now() {
+    const uint64_t now = CycleClock::now();
+    uint32_t sequence;
+    uint64_t ticks;
+    int64_t wall;
+    do {
+        sequence = anchor.sequence.load(std::memory_order_acquire);
+        ticks = anchor.ticks.load(std::memory_order_relaxed);
+        wall = anchor.wall_ns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) != 0 || anchor.sequence.load(std::memory_order_relaxed) != sequence);
+
+    // Signed: the anchor may have been taken after this thread read now
+    const int64_t elapsed = static_cast<int64_t>(now - ticks);
+    if (elapsed > static_cast<int64_t>(anchor.stale_after.load(std::memory_order_relaxed))) {
+        take_anchor();
+    }
+    const double ns = static_cast<double>(elapsed) * anchor.ns_per_tick.load(std::memory_order_relaxed);
+    return time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::nanoseconds(wall + static_cast<int64_t>(ns))));
+}
+
+}
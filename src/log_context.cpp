@@ -1,12 +1,22 @@
 #include "Zyrnix/log_context.hpp"
+#include "Zyrnix/json_escape.hpp"
 #include <algorithm>
 
 namespace Zyrnix {
 
 thread_local LogContext::ContextMap LogContext::context_;
+thread_local std::string LogContext::json_;
+thread_local bool LogContext::json_stale_ = false;
 
 void LogContext::set(const std::string& key, const std::string& value) {
-    context_[key] = value;
+    auto [it, added] = context_.try_emplace(key, value);
+    if (!added) {
+        if (it->second == value) {
+            return;  // Handlers often set the same value again
+        }
+        it->second = value;
+    }
+    json_stale_ = true;
 }
 
 std::string LogContext::get(const std::string& key) {
@@ -18,11 +28,15 @@ std::string LogContext::get(const std::string& key) {
 }
 
 void LogContext::remove(const std::string& key) {
-    context_.erase(key);
+    if (context_.erase(key)) {
+        json_stale_ = true;
+    }
 }
 
 void LogContext::clear() {
     context_.clear();
+    json_.clear();
+    json_stale_ = false;
 }
 
 LogContext::ContextMap LogContext::get_all() {
@@ -33,6 +47,29 @@ bool LogContext::contains(const std::string& key) {
     return context_.find(key) != context_.end();
 }
 
+const std::string* LogContext::find(const std::string& key) {
+    auto it = context_.find(key);
+    return it != context_.end() ? &it->second : nullptr;
+}
+
+const LogContext::ContextMap& LogContext::current() {
+    return context_;
+}
+
+const std::string& LogContext::json_fragment() {
+    if (json_stale_) {
+        json_.clear();
+        for (const auto& [key, value] : context_) {
+            json_.push_back(',');
+            json::append_string(json_, key);
+            json_.push_back(':');
+            json::append_string(json_, value);
+        }
+        json_stale_ = false;
+    }
+    return json_;
+}
+
 ScopedContext::ScopedContext() = default;
 
 ScopedContext::ScopedContext(const LogContext::ContextMap& initial_context) {
@@ -1,10 +1,138 @@
 #include "Zyrnix/log_filter.hpp"
 #include "Zyrnix/log_context.hpp"
+#include "Zyrnix/log_site.hpp"
+#include <algorithm>
+#include <cctype>
+#include <optional>
+
+#ifdef XLOG_HAS_RE2
+#include <re2/re2.h>
+#include <re2/set.h>
+#endif
 
 namespace Zyrnix {
 
+namespace {
+
+FilterVerdict verdict(bool keep) {
+    return keep ? FilterVerdict::Accept : FilterVerdict::Reject;
+}
+
+}
+
+/**
+ * @brief One pattern, or a set of them, compiled for whichever engine
+ *        could take it
+ *
+ * Immutable once built, so filters and the cache share it between threads.
+ */
+class CompiledRegex {
+public:
+    static std::shared_ptr<const CompiledRegex> compile(const std::vector<std::string>& patterns,
+                                                        const RegexFilterOptions& options) {
+        auto compiled = std::make_shared<CompiledRegex>();
+        if (patterns.empty()) {
+            return compiled;  // Matches nothing
+        }
+#ifdef XLOG_HAS_RE2
+        if (options.engine == RegexEngine::RE2 && compiled->compile_re2(patterns, options)) {
+            return compiled;
+        }
+#endif
+        // A set becomes one alternation, still a single scan of the text
+        std::string joined;
+        if (patterns.size() == 1) {
+            joined = patterns.front();
+        } else {
+            for (const auto& pattern : patterns) {
+                joined += joined.empty() ? "(?:" : "|(?:";
+                joined += pattern;
+                joined += ')';
+            }
+        }
+        compiled->std_.emplace(joined, options.case_insensitive
+                                           ? std::regex::ECMAScript | std::regex::icase
+                                           : std::regex::ECMAScript);
+        return compiled;
+    }
+
+    bool search(std::string_view text) const {
+#ifdef XLOG_HAS_RE2
+        const re2::StringPiece piece(text.data(), text.size());
+        if (re2_) {
+            return RE2::PartialMatch(piece, *re2_);
+        }
+        if (set_) {
+            return set_->Match(piece, nullptr);
+        }
+#endif
+        return std_ && std::regex_search(text.begin(), text.end(), *std_);
+    }
+
+    RegexEngine engine() const {
+        return has_re2() ? RegexEngine::RE2 : RegexEngine::Std;
+    }
+
+private:
+    std::optional<std::regex> std_;
+
+#ifdef XLOG_HAS_RE2
+    std::unique_ptr<RE2> re2_;
+    std::unique_ptr<RE2::Set> set_;
+
+    bool has_re2() const { return re2_ || set_; }
+
+    bool compile_re2(const std::vector<std::string>& patterns, const RegexFilterOptions& options) {
+        RE2::Options re2_options;
+        re2_options.set_case_sensitive(!options.case_insensitive);
+        re2_options.set_log_errors(false);
+        if (patterns.size() == 1) {
+            auto single = std::make_unique<RE2>(patterns.front(), re2_options);
+            if (!single->ok()) {
+                return false;
+            }
+            re2_ = std::move(single);
+            return true;
+        }
+        auto set = std::make_unique<RE2::Set>(re2_options, RE2::UNANCHORED);
+        for (const auto& pattern : patterns) {
+            if (set->Add(pattern, nullptr) < 0) {
+                return false;
+            }
+        }
+        if (!set->Compile()) {
+            return false;
+        }
+        set_ = std::move(set);
+        return true;
+    }
+#else
+    bool has_re2() const { return false; }
+#endif
+};
+
+RecordView::RecordView(std::string_view logger, LogLevel lvl, std::string_view text, const LogSite* where)
+    : logger_name(logger), level(lvl), message(text), site(where) {}
+
+RecordView::RecordView(const LogRecord& record)
+    : logger_name(record.logger_name), level(record.level), message(record.message),
+      site(record.site), fields(&record.fields) {}
+
+const std::string* RecordView::field(const std::string& key) const {
+    if (fields) {
+        if (const FieldValue* value = fields->find(key)) {
+            return &value->text();
+        }
+    }
+    return LogContext::find(key);
+}
+
 LevelFilter::LevelFilter(LogLevel min_level) : min_level_(min_level) {}
 
+FilterVerdict LevelFilter::prefilter(const RecordView& view) const {
+    return verdict(view.level >= min_level_);
+}
+
 bool LevelFilter::should_log(const LogRecord& record) const {
     return record.level >= min_level_;
 }
@@ -12,14 +140,31 @@ bool LevelFilter::should_log(const LogRecord& record) const {
 FieldFilter::FieldFilter(const std::string& field_name, const std::string& expected_value)
     : field_name_(field_name), expected_value_(expected_value) {}
 
+// A missing field compares as empty
+FilterVerdict FieldFilter::prefilter(const RecordView& view) const {
+    const std::string* value = view.field(field_name_);
+    return verdict(value ? *value == expected_value_ : expected_value_.empty());
+}
+
 bool FieldFilter::should_log(const LogRecord& record) const {
-    auto context = LogContext::get_all();
-    auto it = context.find(field_name_);
-    if (it != context.end()) {
-        return it->second == expected_value_;
+    return prefilter(RecordView(record)) == FilterVerdict::Accept;
+}
+
+SiteFilter::SiteFilter(std::string file_glob, std::string function_glob)
+    : file_glob_(std::move(file_glob)), function_glob_(std::move(function_glob)) {}
+
+FilterVerdict SiteFilter::prefilter(const RecordView& view) const {
+    const LogSite* site = view.site;
+    if (!site) {
+        return FilterVerdict::Reject;
     }
-    
-    return record.get_field(field_name_) == expected_value_;
+    return verdict((SiteRegistry::glob_match(file_glob_, site->file) ||
+                    SiteRegistry::glob_match(file_glob_, site->file_name())) &&
+                   SiteRegistry::glob_match(function_glob_, site->function));
+}
+
+bool SiteFilter::should_log(const LogRecord& record) const {
+    return prefilter(RecordView(record)) == FilterVerdict::Accept;
 }
 
 LambdaFilter::LambdaFilter(FilterFunc func) : filter_func_(std::move(func)) {}
@@ -34,6 +179,25 @@ void CompositeFilter::add_filter(std::shared_ptr<LogFilter> filter) {
     filters_.push_back(std::move(filter));
 }
 
+// Decided here only when the children that could decide settle it
+FilterVerdict CompositeFilter::prefilter(const RecordView& view) const {
+    // AND is settled by any Reject, OR by any Accept
+    const FilterVerdict settles = mode_ == Mode::AND ? FilterVerdict::Reject : FilterVerdict::Accept;
+    bool undecided = false;
+    for (const auto& filter : filters_) {
+        const FilterVerdict v = filter->prefilter(view);
+        if (v == settles) {
+            return settles;
+        }
+        undecided = undecided || v == FilterVerdict::Undecided;
+    }
+    if (undecided) {
+        return FilterVerdict::Undecided;
+    }
+    // Empty, or every child went the other way
+    return filters_.empty() || mode_ == Mode::AND ? FilterVerdict::Accept : FilterVerdict::Reject;
+}
+
 bool CompositeFilter::should_log(const LogRecord& record) const {
     if (filters_.empty()) {
         return true;
@@ -57,55 +221,47 @@ bool CompositeFilter::should_log(const LogRecord& record) const {
 }
 
 RegexFilter::RegexFilter(const std::string& pattern, bool invert)
-    : pattern_str_(pattern), 
-      regex_(pattern), 
-      invert_(invert),
-      case_insensitive_(false),
-      track_stats_(true) {}
+    : RegexFilter("", pattern, RegexFilterOptions{false, invert, true}) {}
 
 RegexFilter::RegexFilter(const std::string& field_name, const std::string& pattern, bool invert)
-    : pattern_str_(pattern), 
-      regex_(pattern), 
-      field_name_(field_name), 
-      invert_(invert),
-      case_insensitive_(false),
-      track_stats_(true) {}
+    : RegexFilter(field_name, pattern, RegexFilterOptions{false, invert, true}) {}
 
 RegexFilter::RegexFilter(const std::string& pattern, const RegexFilterOptions& options)
-    : pattern_str_(pattern),
-      regex_(pattern, options.case_insensitive ? std::regex::icase : std::regex::ECMAScript),
-      invert_(options.invert),
-      case_insensitive_(options.case_insensitive),
-      track_stats_(options.track_stats) {}
+    : RegexFilter("", pattern, options) {}
 
 RegexFilter::RegexFilter(const std::string& field_name, const std::string& pattern, const RegexFilterOptions& options)
     : pattern_str_(pattern),
-      regex_(pattern, options.case_insensitive ? std::regex::icase : std::regex::ECMAScript),
+      regex_(CompiledRegex::compile({pattern}, options)),
       field_name_(field_name),
       invert_(options.invert),
       case_insensitive_(options.case_insensitive),
       track_stats_(options.track_stats) {}
 
-bool RegexFilter::should_log(const LogRecord& record) const {
-    std::string target;
-    
-    if (field_name_.empty()) {
-        target = record.message;
-    } else {
-        auto context = LogContext::get_all();
-        auto it = context.find(field_name_);
-        if (it != context.end()) {
-            target = it->second;
-        } else {
-            target = record.get_field(field_name_);
-        }
+RegexEngine RegexFilter::engine() const {
+    return regex_->engine();
+}
+
+// Searches the view in place, so neither stage copies the message
+bool RegexFilter::decide(const RecordView& view) const {
+    std::string_view target = view.message;
+    if (!field_name_.empty()) {
+        const std::string* value = view.field(field_name_);
+        target = value ? std::string_view(*value) : std::string_view();
     }
-    
-    bool matches = std::regex_search(target, regex_);
+
+    bool matches = regex_->search(target);
     update_stats(matches);
     return invert_ ? !matches : matches;
 }
 
+FilterVerdict RegexFilter::prefilter(const RecordView& view) const {
+    return verdict(decide(view));
+}
+
+bool RegexFilter::should_log(const LogRecord& record) const {
+    return decide(RecordView(record));
+}
+
 void RegexFilter::update_stats(bool matched) const {
     if (track_stats_) {
         if (matched) {
@@ -129,6 +285,56 @@ void RegexFilter::reset_stats() {
     miss_count_.store(0, std::memory_order_relaxed);
 }
 
+RegexSetFilter::RegexSetFilter(const std::vector<std::string>& patterns, const RegexFilterOptions& options)
+    : RegexSetFilter("", patterns, options) {}
+
+RegexSetFilter::RegexSetFilter(const std::string& field_name, const std::vector<std::string>& patterns,
+                               const RegexFilterOptions& options)
+    : patterns_(patterns),
+      regex_(CompiledRegex::compile(patterns, options)),
+      field_name_(field_name),
+      invert_(options.invert),
+      track_stats_(options.track_stats) {}
+
+RegexEngine RegexSetFilter::engine() const {
+    return regex_->engine();
+}
+
+bool RegexSetFilter::decide(const RecordView& view) const {
+    std::string_view target = view.message;
+    if (!field_name_.empty()) {
+        const std::string* value = view.field(field_name_);
+        target = value ? std::string_view(*value) : std::string_view();
+    }
+
+    bool matches = regex_->search(target);
+    if (track_stats_) {
+        (matches ? match_count_ : miss_count_).fetch_add(1, std::memory_order_relaxed);
+    }
+    return invert_ ? !matches : matches;
+}
+
+FilterVerdict RegexSetFilter::prefilter(const RecordView& view) const {
+    return verdict(decide(view));
+}
+
+bool RegexSetFilter::should_log(const LogRecord& record) const {
+    return decide(RecordView(record));
+}
+
+FilterStats RegexSetFilter::get_stats() const {
+    FilterStats stats;
+    stats.matches = match_count_.load(std::memory_order_relaxed);
+    stats.misses = miss_count_.load(std::memory_order_relaxed);
+    stats.total_checks = stats.matches + stats.misses;
+    return stats;
+}
+
+void RegexSetFilter::reset_stats() {
+    match_count_.store(0, std::memory_order_relaxed);
+    miss_count_.store(0, std::memory_order_relaxed);
+}
+
 RegexFilterCache& RegexFilterCache::instance() {
     static RegexFilterCache instance;
     return instance;
@@ -138,7 +344,8 @@ std::string RegexFilterCache::make_cache_key(const std::string& pattern, const s
                                              const RegexFilterOptions& options) const {
     std::string key = pattern + "|" + field + "|" +
                       (options.case_insensitive ? "i" : "") +
-                      (options.invert ? "v" : "");
+                      (options.invert ? "v" : "") +
+                      (options.engine == RegexEngine::RE2 ? "2" : "");
     return key;
 }
 
@@ -191,14 +398,465 @@ std::shared_ptr<RegexFilter> RegexFilterCache::get_precompiled(const std::string
     return nullptr;
 }
 
+std::shared_ptr<RegexSetFilter> RegexFilterCache::get_or_create_set(
+    const std::vector<std::string>& patterns,
+    const RegexFilterOptions& options) {
+    return get_or_create_set("", patterns, options);
+}
+
+std::shared_ptr<RegexSetFilter> RegexFilterCache::get_or_create_set(
+    const std::string& field_name,
+    const std::vector<std::string>& patterns,
+    const RegexFilterOptions& options) {
+
+    // Length-prefixed, so no choice of pattern text can collide
+    std::string joined;
+    for (const auto& pattern : patterns) {
+        joined += std::to_string(pattern.size());
+        joined += ':';
+        joined += pattern;
+    }
+    std::string key = make_cache_key(joined, field_name, options);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = sets_.find(key);
+    if (it != sets_.end()) {
+        cache_hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+
+    cache_misses_.fetch_add(1, std::memory_order_relaxed);
+
+    auto filter = std::make_shared<RegexSetFilter>(field_name, patterns, options);
+    sets_[key] = filter;
+    return filter;
+}
+
 void RegexFilterCache::clear() {
     std::lock_guard<std::mutex> lock(mutex_);
     cache_.clear();
+    sets_.clear();
 }
 
 size_t RegexFilterCache::cache_size() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return cache_.size();
+    return cache_.size() + sets_.size();
 }
 
-} 
+
+struct ExpressionFilter::Instruction {
+    enum class Op : uint8_t {
+        Constant,     // value = a != 0
+        Level,        // value = level <compare> level
+        Equals,       // value = text == strings[a]
+        Contains,     // value = text contains strings[a]; regexes without metacharacters
+        Matches,      // value = regexes[a] finds text
+        FieldSet,     // value = field strings[key] is set
+        Not,
+        JumpIfFalse,  // Go to a, keeping value, if value is false
+        JumpIfTrue
+    };
+    enum class Compare : uint8_t { Eq, Ne, Lt, Le, Gt, Ge };
+    enum class Source : uint8_t { Message, Logger, Field };  // The text an Op reads
+
+    Op op;
+    Compare compare = Compare::Eq;
+    Source source = Source::Message;
+    LogLevel level = LogLevel::Trace;
+    uint32_t a = 0;
+    uint32_t key = 0;  // Field name, in strings
+};
+
+/**
+ * @brief Recursive descent over the expression, emitting instructions as
+ *        it goes
+ *
+ * Every term sets the single result register and every && or || jumps
+ * past its right side once the left side decides, so no stack is needed.
+ */
+class ExpressionFilter::Compiler {
+public:
+    Compiler(const std::string& text, ExpressionFilter& out) : text_(text), out_(out) {}
+
+    bool run(std::string& error) {
+        if (next() && parse_or() && (token_ == Token::End || fail("expected && or ||"))) {
+            return true;
+        }
+        error = error_;
+        return false;
+    }
+
+private:
+    using Op = Instruction::Op;
+    using Compare = Instruction::Compare;
+    using Source = Instruction::Source;
+
+    enum class Token {
+        End, Name, String, Regex,
+        And, Or, Not, Open, Close,
+        Eq, Ne, Lt, Le, Gt, Ge, Match, NoMatch
+    };
+
+    static constexpr int max_depth = 64;
+
+    const std::string& text_;
+    ExpressionFilter& out_;
+    size_t pos_ = 0;
+    size_t token_start_ = 0;
+    Token token_ = Token::End;
+    std::string lexeme_;
+    bool ignore_case_ = false;  // The last Regex token ended in /i
+    int depth_ = 0;
+    std::string error_;
+
+    bool fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " at offset " + std::to_string(token_start_);
+        }
+        return false;
+    }
+
+    static bool is_name_char(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '-';
+    }
+
+    // Reads up to the closing quote; a backslash takes the next character
+    // literally, except that regexes keep it unless it escapes the '/'
+    bool read_quoted(char quote, bool keep_escapes) {
+        lexeme_.clear();
+        for (++pos_; pos_ < text_.size(); ++pos_) {
+            const char c = text_[pos_];
+            if (c == quote) {
+                ++pos_;
+                return true;
+            }
+            if (c == '\\' && pos_ + 1 < text_.size()) {
+                const char escaped = text_[++pos_];
+                if (keep_escapes && escaped != quote) {
+                    lexeme_.push_back('\\');
+                }
+                lexeme_.push_back(escaped);
+            } else {
+                lexeme_.push_back(c);
+            }
+        }
+        return fail(quote == '"' ? "unterminated string" : "unterminated regex");
+    }
+
+    bool next() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+        token_start_ = pos_;
+        if (pos_ == text_.size()) {
+            token_ = Token::End;
+            return true;
+        }
+        const char c = text_[pos_];
+        const char c2 = pos_ + 1 < text_.size() ? text_[pos_ + 1] : '\0';
+        auto symbol = [&](Token token, size_t length) {
+            token_ = token;
+            pos_ += length;
+            return true;
+        };
+        switch (c) {
+            case '(': return symbol(Token::Open, 1);
+            case ')': return symbol(Token::Close, 1);
+            case '~': return symbol(Token::Match, 1);
+            case '&': return c2 == '&' ? symbol(Token::And, 2) : fail("expected &&");
+            case '|': return c2 == '|' ? symbol(Token::Or, 2) : fail("expected ||");
+            case '=': return c2 == '=' ? symbol(Token::Eq, 2) : fail("expected ==");
+            case '!':
+                if (c2 == '=') return symbol(Token::Ne, 2);
+                if (c2 == '~') return symbol(Token::NoMatch, 2);
+                return symbol(Token::Not, 1);
+            case '<': return c2 == '=' ? symbol(Token::Le, 2) : symbol(Token::Lt, 1);
+            case '>': return c2 == '=' ? symbol(Token::Ge, 2) : symbol(Token::Gt, 1);
+            case '"':
+                token_ = Token::String;
+                return read_quoted('"', false);
+            case '/':
+                token_ = Token::Regex;
+                if (!read_quoted('/', true)) {
+                    return false;
+                }
+                ignore_case_ = pos_ < text_.size() && text_[pos_] == 'i' &&
+                               (pos_ + 1 == text_.size() || !is_name_char(text_[pos_ + 1]));
+                pos_ += ignore_case_ ? 1 : 0;
+                return true;
+            default:
+                break;
+        }
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_') {
+            return fail(std::string("unexpected '") + c + "'");
+        }
+        while (pos_ < text_.size() && is_name_char(text_[pos_])) {
+            ++pos_;
+        }
+        token_ = Token::Name;
+        lexeme_ = text_.substr(token_start_, pos_ - token_start_);
+        return true;
+    }
+
+    size_t emit(Instruction instruction) {
+        out_.code_.push_back(instruction);
+        return out_.code_.size() - 1;
+    }
+
+    uint32_t add_string(std::string value) {
+        out_.strings_.push_back(std::move(value));
+        return static_cast<uint32_t>(out_.strings_.size() - 1);
+    }
+
+    static bool is_literal(const std::string& pattern) {
+        return pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+    }
+
+    // A plain substring search for patterns with nothing to interpret
+    bool add_pattern(Instruction& instruction) {
+        const bool ignore_case = token_ == Token::Regex && ignore_case_;
+        if (!ignore_case && is_literal(lexeme_)) {
+            instruction.op = Op::Contains;
+            instruction.a = add_string(lexeme_);
+            return true;
+        }
+        RegexFilterOptions options;
+        options.case_insensitive = ignore_case;
+        options.track_stats = false;
+        options.engine = RegexEngine::RE2;
+        try {
+            out_.regexes_.push_back(CompiledRegex::compile({lexeme_}, options));
+        } catch (const std::regex_error&) {
+            return fail("invalid regex");
+        }
+        instruction.op = Op::Matches;
+        instruction.a = static_cast<uint32_t>(out_.regexes_.size() - 1);
+        return true;
+    }
+
+    // Chains of && (or ||) all jump to the end of the chain
+    bool parse_chain(Token joiner, Op jump, bool (Compiler::*operand)()) {
+        if (!(this->*operand)()) {
+            return false;
+        }
+        std::vector<size_t> exits;
+        while (token_ == joiner) {
+            exits.push_back(emit(Instruction{jump}));
+            if (!next() || !(this->*operand)()) {
+                return false;
+            }
+        }
+        for (size_t exit : exits) {
+            out_.code_[exit].a = static_cast<uint32_t>(out_.code_.size());
+        }
+        return true;
+    }
+
+    bool parse_or() { return parse_chain(Token::Or, Op::JumpIfTrue, &Compiler::parse_and); }
+    bool parse_and() { return parse_chain(Token::And, Op::JumpIfFalse, &Compiler::parse_unary); }
+
+    bool parse_unary() {
+        if (token_ == Token::Not || token_ == Token::Open) {
+            if (++depth_ > max_depth) {
+                return fail("expression nested too deeply");
+            }
+            bool ok;
+            if (token_ == Token::Not) {
+                ok = next() && parse_unary();
+                emit(Instruction{Op::Not});
+            } else {
+                ok = next() && parse_or() &&
+                     (token_ == Token::Close || fail("expected )")) && next();
+            }
+            --depth_;
+            return ok;
+        }
+        return parse_term();
+    }
+
+    static bool parse_level(std::string name, LogLevel& level) {
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        static constexpr std::pair<std::string_view, LogLevel> names[] = {
+            {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug}, {"info", LogLevel::Info},
+            {"warn", LogLevel::Warn}, {"warning", LogLevel::Warn}, {"error", LogLevel::Error},
+            {"critical", LogLevel::Critical}};
+        for (const auto& [text, value] : names) {
+            if (name == text) {
+                level = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parse_level_term() {
+        Instruction instruction{Op::Level};
+        switch (token_) {
+            case Token::Eq: instruction.compare = Compare::Eq; break;
+            case Token::Ne: instruction.compare = Compare::Ne; break;
+            case Token::Lt: instruction.compare = Compare::Lt; break;
+            case Token::Le: instruction.compare = Compare::Le; break;
+            case Token::Gt: instruction.compare = Compare::Gt; break;
+            case Token::Ge: instruction.compare = Compare::Ge; break;
+            default: return fail("expected a comparison after level");
+        }
+        if (!next()) {
+            return false;
+        }
+        if ((token_ != Token::Name && token_ != Token::String) || !parse_level(lexeme_, instruction.level)) {
+            return fail("expected a level name");
+        }
+        emit(instruction);
+        return next();
+    }
+
+    // msg, logger or field.<name>, which was just read
+    bool parse_text_term(Source source, std::string field) {
+        Instruction instruction{Op::Equals};
+        instruction.source = source;
+        if (source == Source::Field) {
+            instruction.key = add_string(std::move(field));
+        }
+        const Token compare = token_;
+        if (compare != Token::Eq && compare != Token::Ne &&
+            compare != Token::Match && compare != Token::NoMatch) {
+            if (source == Source::Field) {
+                instruction.op = Op::FieldSet;
+                emit(instruction);
+                return true;
+            }
+            return fail("expected ==, !=, ~ or !~");
+        }
+        if (!next()) {
+            return false;
+        }
+        if (compare == Token::Eq || compare == Token::Ne) {
+            if (token_ != Token::String) {
+                return fail("expected a \"string\"");
+            }
+            instruction.a = add_string(lexeme_);
+        } else {
+            if (token_ != Token::Regex && token_ != Token::String) {
+                return fail("expected a /regex/");
+            }
+            if (!add_pattern(instruction)) {
+                return false;
+            }
+        }
+        emit(instruction);
+        if (compare == Token::Ne || compare == Token::NoMatch) {
+            emit(Instruction{Op::Not});
+        }
+        return next();
+    }
+
+    bool parse_term() {
+        if (token_ != Token::Name) {
+            return fail("expected level, msg, logger or field.<name>");
+        }
+        const std::string name = lexeme_;
+        const size_t start = token_start_;
+        if (name == "true" || name == "false") {
+            Instruction constant{Op::Constant};
+            constant.a = name == "true" ? 1 : 0;
+            emit(constant);
+            return next();
+        }
+        if (!next()) {
+            return false;
+        }
+        if (name == "level") {
+            return parse_level_term();
+        }
+        if (name == "msg" || name == "message") {
+            return parse_text_term(Source::Message, {});
+        }
+        if (name == "logger") {
+            return parse_text_term(Source::Logger, {});
+        }
+        if (name.rfind("field.", 0) == 0 && name.size() > 6) {
+            return parse_text_term(Source::Field, name.substr(6));
+        }
+        token_start_ = start;
+        return fail("unknown operand '" + name + "'");
+    }
+};
+
+ExpressionFilter::ExpressionFilter() = default;
+ExpressionFilter::~ExpressionFilter() = default;
+
+std::shared_ptr<ExpressionFilter> ExpressionFilter::compile(const std::string& text, std::string* error) {
+    std::shared_ptr<ExpressionFilter> filter(new ExpressionFilter());
+    filter->text_ = text;
+    std::string reason;
+    if (!Compiler(text, *filter).run(reason)) {
+        if (error) {
+            *error = reason;
+        }
+        return nullptr;
+    }
+    return filter;
+}
+
+// A missing field reads as empty, as in FieldFilter
+std::string_view ExpressionFilter::text(const RecordView& view, const Instruction& in) const {
+    switch (in.source) {
+        case Instruction::Source::Logger: return view.logger_name;
+        case Instruction::Source::Field: {
+            const std::string* field = view.field(strings_[in.key]);
+            return field ? std::string_view(*field) : std::string_view();
+        }
+        default: return view.message;
+    }
+}
+
+bool ExpressionFilter::evaluate(const RecordView& view) const {
+    using Op = Instruction::Op;
+    using Compare = Instruction::Compare;
+    bool value = true;
+    size_t pc = 0;
+    const size_t end = code_.size();
+    while (pc < end) {
+        const Instruction& in = code_[pc++];
+        switch (in.op) {
+            case Op::Constant: value = in.a != 0; break;
+            case Op::Level:
+                switch (in.compare) {
+                    case Compare::Eq: value = view.level == in.level; break;
+                    case Compare::Ne: value = view.level != in.level; break;
+                    case Compare::Lt: value = view.level < in.level; break;
+                    case Compare::Le: value = view.level <= in.level; break;
+                    case Compare::Gt: value = view.level > in.level; break;
+                    case Compare::Ge: value = view.level >= in.level; break;
+                }
+                break;
+            case Op::Equals: value = text(view, in) == strings_[in.a]; break;
+            case Op::Contains: value = text(view, in).find(strings_[in.a]) != std::string_view::npos; break;
+            case Op::Matches: value = regexes_[in.a]->search(text(view, in)); break;
+            case Op::FieldSet: value = view.field(strings_[in.key]) != nullptr; break;
+            case Op::Not: value = !value; break;
+            case Op::JumpIfFalse:
+                if (!value) {
+                    pc = in.a;
+                }
+                break;
+            case Op::JumpIfTrue:
+                if (value) {
+                    pc = in.a;
+                }
+                break;
+        }
+    }
+    return value;
+}
+
+FilterVerdict ExpressionFilter::prefilter(const RecordView& view) const {
+    return verdict(evaluate(view));
+}
+
+bool ExpressionFilter::should_log(const LogRecord& record) const {
+    return evaluate(RecordView(record));
+}
+
+}
@@ -1,11 +1,131 @@
 #include "Zyrnix/log_health.hpp"
 #include "Zyrnix/logger.hpp"
+#include "Zyrnix/thread_placement.hpp"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdlib>
 
 namespace Zyrnix {
 
+namespace {
+
+HealthStatus overall_status(const std::map<std::string, HealthCheckResult>& results) {
+    bool has_unhealthy = false;
+    bool has_degraded = false;
+    
+    for (const auto& [name, result] : results) {
+        if (result.status == HealthStatus::Unhealthy) {
+            has_unhealthy = true;
+        } else if (result.status == HealthStatus::Degraded) {
+            has_degraded = true;
+        }
+    }
+    
+    if (has_unhealthy) {
+        return HealthStatus::Unhealthy;
+    } else if (has_degraded) {
+        return HealthStatus::Degraded;
+    } else {
+        return HealthStatus::Healthy;
+    }
+}
+
+std::string render_json(const std::map<std::string, HealthCheckResult>& results) {
+    std::ostringstream oss;
+    oss << "{\n";
+    oss << "  \"overall_status\": \"";
+    
+    switch (overall_status(results)) {
+        case HealthStatus::Healthy: oss << "healthy"; break;
+        case HealthStatus::Degraded: oss << "degraded"; break;
+        case HealthStatus::Unhealthy: oss << "unhealthy"; break;
+    }
+    oss << "\",\n";
+    
+    oss << "  \"loggers\": [\n";
+    bool first = true;
+    for (const auto& [name, result] : results) {
+        if (!first) oss << ",\n";
+        first = false;
+        
+        oss << "    {\n";
+        oss << "      \"name\": \"" << name << "\",\n";
+        
+
+        std::string result_json = result.to_json();
+        std::istringstream iss(result_json);
+        std::string line;
+        bool first_line = true;
+        while (std::getline(iss, line)) {
+            if (!first_line) oss << "\n";
+            if (!line.empty()) {
+                oss << "      " << line;
+            }
+            first_line = false;
+        }
+        oss << "\n    }";
+    }
+    oss << "\n  ]\n";
+    oss << "}";
+    
+    return oss.str();
+}
+
+AggregateHealthResult aggregate(std::map<std::string, HealthCheckResult> individual_results) {
+    AggregateHealthResult agg;
+    agg.timestamp = std::chrono::system_clock::now();
+    agg.total_loggers = individual_results.size();
+    agg.healthy_count = 0;
+    agg.degraded_count = 0;
+    agg.unhealthy_count = 0;
+    agg.total_messages_logged = 0;
+    agg.total_messages_dropped = 0;
+    agg.total_errors = 0;
+    agg.avg_messages_per_second = 0.0;
+    agg.worst_logger_status = HealthStatus::Healthy;
+    
+    for (const auto& [name, result] : individual_results) {
+        agg.total_messages_logged += result.messages_logged;
+        agg.total_messages_dropped += result.messages_dropped;
+        agg.total_errors += result.errors;
+        agg.avg_messages_per_second += result.messages_per_second;
+        
+        switch (result.status) {
+            case HealthStatus::Healthy:
+                agg.healthy_count++;
+                break;
+            case HealthStatus::Degraded:
+                agg.degraded_count++;
+                if (agg.worst_logger_status == HealthStatus::Healthy) {
+                    agg.worst_logger_name = name;
+                    agg.worst_logger_status = HealthStatus::Degraded;
+                }
+                break;
+            case HealthStatus::Unhealthy:
+                agg.unhealthy_count++;
+                if (agg.worst_logger_status != HealthStatus::Unhealthy) {
+                    agg.worst_logger_name = name;
+                    agg.worst_logger_status = HealthStatus::Unhealthy;
+                }
+                break;
+        }
+    }
+    
+    if (agg.unhealthy_count > 0) {
+        agg.overall_status = HealthStatus::Unhealthy;
+    } else if (agg.degraded_count > 0) {
+        agg.overall_status = HealthStatus::Degraded;
+    } else {
+        agg.overall_status = HealthStatus::Healthy;
+    }
+    agg.individual_results = std::move(individual_results);
+    
+    return agg;
+}
+
+}
+
 std::string HealthCheckResult::to_json() const {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(2);
@@ -199,8 +319,10 @@ HealthStatus HealthChecker::determine_status(
 }
 
 HealthRegistry& HealthRegistry::instance() {
-    static HealthRegistry registry;
-    return registry;
+    // Leaked, like LoggerRegistry: the ticker and RCU readers may still
+    // reach it during exit
+    static auto* registry = new HealthRegistry();
+    return *registry;
 }
 
 void HealthRegistry::register_logger(const std::string& name, std::shared_ptr<Logger> logger) {
@@ -239,8 +361,8 @@ HealthCheckResult HealthRegistry::check_logger(const std::string& name) const {
     
     const auto& checker = it->second.custom_checker ? it->second.custom_checker : health_checker_;
 
-    LogMetrics metrics;
-    HealthCheckResult result = checker->check_logger(*logger, metrics);
+    auto metrics = MetricsRegistry::instance().get_logger_metrics(name);
+    HealthCheckResult result = checker->check_logger(*logger, *metrics);
     
     result.last_error_message = it->second.last_error_message;
     result.last_error_time = it->second.last_error_time;
@@ -256,8 +378,8 @@ std::map<std::string, HealthCheckResult> HealthRegistry::check_all() const {
         auto logger = entry.logger.lock();
         if (logger) {
             const auto& checker = entry.custom_checker ? entry.custom_checker : health_checker_;
-            LogMetrics metrics;
-            HealthCheckResult result = checker->check_logger(*logger, metrics);
+            auto metrics = MetricsRegistry::instance().get_logger_metrics(name);
+            HealthCheckResult result = checker->check_logger(*logger, *metrics);
             result.last_error_message = entry.last_error_message;
             result.last_error_time = entry.last_error_time;
             results[name] = result;
@@ -268,74 +390,23 @@ std::map<std::string, HealthCheckResult> HealthRegistry::check_all() const {
 }
 
 std::string HealthRegistry::export_json() const {
-    auto results = check_all();
-    
-    std::ostringstream oss;
-    oss << "{\n";
-    oss << "  \"overall_status\": \"";
-    
-    auto overall = get_overall_status();
-    switch (overall) {
-        case HealthStatus::Healthy: oss << "healthy"; break;
-        case HealthStatus::Degraded: oss << "degraded"; break;
-        case HealthStatus::Unhealthy: oss << "unhealthy"; break;
-    }
-    oss << "\",\n";
-    
-    oss << "  \"loggers\": [\n";
-    bool first = true;
-    for (const auto& [name, result] : results) {
-        if (!first) oss << ",\n";
-        first = false;
-        
-        oss << "    {\n";
-        oss << "      \"name\": \"" << name << "\",\n";
-        
-
-        std::string result_json = result.to_json();
-        std::istringstream iss(result_json);
-        std::string line;
-        bool first_line = true;
-        while (std::getline(iss, line)) {
-            if (!first_line) oss << "\n";
-            if (!line.empty()) {
-                oss << "      " << line;
-            }
-            first_line = false;
+    {
+        EpochDomain::ReadGuard read;
+        if (const HealthSnapshot* snapshot = snapshot_.load()) {
+            return snapshot->json;
         }
-        oss << "\n    }";
     }
-    oss << "\n  ]\n";
-    oss << "}";
-    
-    return oss.str();
+    return render_json(check_all());
 }
 
 HealthStatus HealthRegistry::get_overall_status() const {
-    auto results = check_all();
-    
-    if (results.empty()) {
-        return HealthStatus::Healthy;
-    }
-    
-    bool has_unhealthy = false;
-    bool has_degraded = false;
-    
-    for (const auto& [name, result] : results) {
-        if (result.status == HealthStatus::Unhealthy) {
-            has_unhealthy = true;
-        } else if (result.status == HealthStatus::Degraded) {
-            has_degraded = true;
+    {
+        EpochDomain::ReadGuard read;
+        if (const HealthSnapshot* snapshot = snapshot_.load()) {
+            return snapshot->aggregate.overall_status;
         }
     }
-    
-    if (has_unhealthy) {
-        return HealthStatus::Unhealthy;
-    } else if (has_degraded) {
-        return HealthStatus::Degraded;
-    } else {
-        return HealthStatus::Healthy;
-    }
+    return overall_status(check_all());
 }
 
 void HealthRegistry::set_health_checker(std::shared_ptr<HealthChecker> checker) {
@@ -397,63 +468,131 @@ void HealthRegistry::auto_register(const std::string& name, std::shared_ptr<Logg
 
 void HealthRegistry::notify_state_change(const std::string& name, HealthStatus old_status,
                                          HealthStatus new_status, const HealthCheckResult& result) {
-    for (const auto& callback : state_change_callbacks_) {
+    std::vector<HealthStateChangeCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callbacks = state_change_callbacks_;
+    }
+    for (const auto& callback : callbacks) {
         callback(name, old_status, new_status, result);
     }
 }
 
 AggregateHealthResult HealthRegistry::check_all_aggregate() const {
-    auto individual_results = check_all();
-    
-    AggregateHealthResult agg;
-    agg.timestamp = std::chrono::system_clock::now();
-    agg.total_loggers = individual_results.size();
-    agg.healthy_count = 0;
-    agg.degraded_count = 0;
-    agg.unhealthy_count = 0;
-    agg.total_messages_logged = 0;
-    agg.total_messages_dropped = 0;
-    agg.total_errors = 0;
-    agg.avg_messages_per_second = 0.0;
-    agg.worst_logger_status = HealthStatus::Healthy;
-    agg.individual_results = individual_results;
-    
-    for (const auto& [name, result] : individual_results) {
-        agg.total_messages_logged += result.messages_logged;
-        agg.total_messages_dropped += result.messages_dropped;
-        agg.total_errors += result.errors;
-        agg.avg_messages_per_second += result.messages_per_second;
-        
-        switch (result.status) {
-            case HealthStatus::Healthy:
-                agg.healthy_count++;
-                break;
-            case HealthStatus::Degraded:
-                agg.degraded_count++;
-                if (agg.worst_logger_status == HealthStatus::Healthy) {
-                    agg.worst_logger_name = name;
-                    agg.worst_logger_status = HealthStatus::Degraded;
-                }
-                break;
-            case HealthStatus::Unhealthy:
-                agg.unhealthy_count++;
-                if (agg.worst_logger_status != HealthStatus::Unhealthy) {
-                    agg.worst_logger_name = name;
-                    agg.worst_logger_status = HealthStatus::Unhealthy;
-                }
-                break;
+    {
+        EpochDomain::ReadGuard read;
+        if (const HealthSnapshot* snapshot = snapshot_.load()) {
+            return snapshot->aggregate;
         }
     }
-    
-    if (agg.unhealthy_count > 0) {
-        agg.overall_status = HealthStatus::Unhealthy;
-    } else if (agg.degraded_count > 0) {
-        agg.overall_status = HealthStatus::Degraded;
-    } else {
-        agg.overall_status = HealthStatus::Healthy;
+    return aggregate(check_all());
+}
+
+std::string HealthRegistry::health_json(const std::string& logger_name) const {
+    {
+        EpochDomain::ReadGuard read;
+        if (const HealthSnapshot* snapshot = snapshot_.load()) {
+            if (logger_name.empty()) {
+                return snapshot->json;
+            }
+            auto it = snapshot->logger_json.find(logger_name);
+            if (it != snapshot->logger_json.end()) {
+                return it->second;
+            }
+        }
+    }
+    // Unknown and expired loggers report themselves through check_logger()
+    return logger_name.empty() ? render_json(check_all()) : check_logger(logger_name).to_json();
+}
+
+void HealthRegistry::evaluate_now() {
+    std::lock_guard<std::mutex> evaluating(evaluate_mutex_);
+    auto results = check_all();
+
+    struct Change {
+        const std::string* name;
+        HealthStatus old_status;
+    };
+    std::vector<Change> changes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, result] : results) {
+            auto it = loggers_.find(name);
+            if (it != loggers_.end() && it->second.last_status != result.status) {
+                changes.push_back({&name, it->second.last_status});
+                it->second.last_status = result.status;
+            }
+        }
+    }
+
+    auto snapshot = std::make_unique<HealthSnapshot>();
+    snapshot->json = render_json(results);
+    for (const auto& [name, result] : results) {
+        snapshot->logger_json.emplace(name, result.to_json());
+    }
+    snapshot->aggregate = aggregate(std::move(results));
+    const HealthSnapshot& published = *snapshot;
+    snapshot_.publish(std::move(snapshot));
+
+    // After publishing, so a callback that reads the health sees this tick.
+    // published stays valid: only evaluations under evaluate_mutex_ retire it
+    for (const auto& change : changes) {
+        const HealthCheckResult& result = published.aggregate.individual_results.at(*change.name);
+        notify_state_change(*change.name, change.old_status, result.status, result);
+    }
+}
+
+void HealthRegistry::start_background_evaluation(std::chrono::milliseconds interval) {
+    static std::once_flag stop_at_exit;
+    // The ticker reads MetricsRegistry, so it must stop before that is
+    // destroyed; an atexit handler registered after it runs first
+    MetricsRegistry::instance();
+    std::call_once(stop_at_exit, [] {
+        std::atexit([] { HealthRegistry::instance().stop_background_evaluation(); });
+    });
+
+    std::lock_guard<std::mutex> lock(tick_mutex_);
+    interval_ = std::max(interval, std::chrono::milliseconds(1));
+    if (ticker_.joinable()) {
+        tick_cv_.notify_one();
+        return;
+    }
+    stopping_ = false;
+    ticker_ = std::thread(&HealthRegistry::run_ticker, this);
+}
+
+void HealthRegistry::stop_background_evaluation() {
+    {
+        std::lock_guard<std::mutex> lock(tick_mutex_);
+        if (!ticker_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+    }
+    tick_cv_.notify_one();
+    ticker_.join();
+
+    std::lock_guard<std::mutex> evaluating(evaluate_mutex_);
+    const uint64_t grace = snapshot_.publish(nullptr);
+    EpochDomain::instance().wait_for(grace);
+    snapshot_.reclaim();
+}
+
+bool HealthRegistry::background_evaluation_running() const {
+    std::lock_guard<std::mutex> lock(tick_mutex_);
+    return ticker_.joinable();
+}
+
+void HealthRegistry::run_ticker() {
+    init_background_thread("xlog-health");
+    std::unique_lock<std::mutex> lock(tick_mutex_);
+    while (!stopping_) {
+        lock.unlock();
+        evaluate_now();
+        lock.lock();
+        // A new interval wakes this early and counts from then
+        tick_cv_.wait_for(lock, interval_, [this] { return stopping_; });
     }
-    
-    return agg;
 }
 
 std::string AggregateHealthResult::to_json() const {
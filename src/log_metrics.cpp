@@ -1,67 +1,265 @@
 #include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/formatted_record.hpp"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
 
 namespace Zyrnix {
 
+namespace {
+
+std::string escape_label(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
 
-LogMetrics::LogMetrics()
-    : start_time_(std::chrono::steady_clock::now())
-{
+// Prometheus bucket bounds, 1 us to 10 s in 1-2.5-5 steps. Each counts
+// the histogram buckets lying wholly below it, so a count is at most one
+// bucket (6.25%) short of the exact one.
+struct PrometheusBound {
+    uint64_t ns;
+    const char* le;
+};
+
+constexpr PrometheusBound prometheus_bounds[] = {
+    {1000, "0.000001"},        {2500, "0.0000025"},       {5000, "0.000005"},
+    {10000, "0.00001"},        {25000, "0.000025"},       {50000, "0.00005"},
+    {100000, "0.0001"},        {250000, "0.00025"},       {500000, "0.0005"},
+    {1000000, "0.001"},        {2500000, "0.0025"},       {5000000, "0.005"},
+    {10000000, "0.01"},        {25000000, "0.025"},       {50000000, "0.05"},
+    {100000000, "0.1"},        {250000000, "0.25"},       {500000000, "0.5"},
+    {1000000000, "1"},         {2500000000, "2.5"},       {5000000000, "5"},
+    {10000000000, "10"},
+};
+
+constexpr size_t prometheus_bound_count = std::size(prometheus_bounds);
+
+// Snapshot::count_at_most() of every bound, in one pass over the buckets
+std::array<uint64_t, prometheus_bound_count> bound_counts(const LatencyHistogram::Snapshot& snap) {
+    std::array<uint64_t, prometheus_bound_count> counts{};
+    if (snap.count == 0) {
+        return counts;
+    }
+    size_t i = 0;
+    uint64_t below = 0;
+    for (size_t b = 0; b < prometheus_bound_count; ++b) {
+        while (i < snap.buckets.size() && LatencyHistogram::bucket_upper_bound(i) <= prometheus_bounds[b].ns) {
+            below += snap.buckets[i++];
+        }
+        counts[b] = below;
+    }
+    return counts;
 }
 
-void LogMetrics::record_message_logged() {
-    counters_.messages_logged.fetch_add(1, std::memory_order_relaxed);
+// labels is empty or "name=\"value\"," ready to go before le
+void write_histogram(std::ostream& out, const std::string& name, const std::string& help,
+                     const std::string& labels, const LatencyHistogram::Snapshot& snap) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " histogram\n";
+    const auto counts = bound_counts(snap);
+    for (size_t b = 0; b < prometheus_bound_count; ++b) {
+        out << name << "_bucket{" << labels << "le=\"" << prometheus_bounds[b].le << "\"} " << counts[b] << "\n";
+    }
+    out << name << "_bucket{" << labels << "le=\"+Inf\"} " << snap.count << "\n";
+    const std::string plain = labels.empty() ? "" : "{" + labels.substr(0, labels.size() - 1) + "}";
+    out << name << "_sum" << plain << " " << std::fixed << std::setprecision(9)
+        << static_cast<double>(snap.sum_ns) / 1e9 << "\n"
+        << name << "_count" << plain << " " << snap.count << "\n\n";
 }
 
-void LogMetrics::record_message_dropped() {
-    counters_.messages_dropped.fetch_add(1, std::memory_order_relaxed);
+void append_number(std::string& out, uint64_t value) {
+    char buf[24];
+    out.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
 }
 
-void LogMetrics::record_message_filtered() {
-    counters_.messages_filtered.fetch_add(1, std::memory_order_relaxed);
+void append_number(std::string& out, double value, int precision) {
+    char buf[64];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision);
+    if (result.ec == std::errc()) {
+        out.append(buf, result.ptr);
+    } else {
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);  // Too long for fixed
+    }
 }
 
-void LogMetrics::record_flush() {
-    counters_.flushes.fetch_add(1, std::memory_order_relaxed);
+// Appends the text exposition a family at a time. In OpenMetrics a
+// counter's metadata names it without _total, and the text ends in # EOF
+class Exposition {
+public:
+    Exposition(std::string& out, const std::string& prefix, ExpositionFormat format)
+        : out_(out), prefix_(prefix), format_(format) {}
+
+    // Starts family <prefix>_<name>; its samples follow
+    void family(const char* name, const char* type, const char* help) {
+        name_.assign(prefix_).append("_").append(name);
+        const bool counter = std::strcmp(type, "counter") == 0;
+        suffix_ = counter ? "_total" : "";
+        const char* meta_suffix = counter && format_ == ExpositionFormat::Prometheus ? "_total" : "";
+        out_.append("# HELP ").append(name_).append(meta_suffix).append(" ").append(help).append("\n");
+        out_.append("# TYPE ").append(name_).append(meta_suffix).append(" ").append(type).append("\n");
+    }
+
+    // labels is empty or label="value" pairs joined by commas
+    void sample(std::string_view labels, uint64_t value, std::string_view extra = {}) {
+        series(suffix_, labels, extra);
+        append_number(out_, value);
+        out_ += '\n';
+    }
+
+    void sample(std::string_view labels, double value, int precision) {
+        series(suffix_, labels, {});
+        append_number(out_, value, precision);
+        out_ += '\n';
+    }
+
+    // Left out until it has a value: untimed loggers and sinks would
+    // otherwise fill most of the scrape with zero buckets
+    void histogram(std::string_view labels, const LatencyHistogram::Snapshot& snap, std::string_view extra = {}) {
+        if (snap.count == 0) {
+            return;
+        }
+        const auto counts = bound_counts(snap);
+        le_.assign(extra).append(extra.empty() ? "le=\"" : ",le=\"");
+        const size_t le_start = le_.size();
+        for (size_t b = 0; b <= prometheus_bound_count; ++b) {
+            le_.resize(le_start);
+            le_.append(b < prometheus_bound_count ? prometheus_bounds[b].le : "+Inf").append("\"");
+            series("_bucket", labels, le_);
+            append_number(out_, b < prometheus_bound_count ? counts[b] : snap.count);
+            out_ += '\n';
+        }
+        series("_sum", labels, extra);
+        append_number(out_, static_cast<double>(snap.sum_ns) / 1e9, 9);
+        out_ += '\n';
+        series("_count", labels, extra);
+        append_number(out_, snap.count);
+        out_ += '\n';
+    }
+
+    void finish() {
+        if (format_ == ExpositionFormat::OpenMetrics) {
+            out_.append("# EOF\n");
+        }
+    }
+
+private:
+    void series(std::string_view suffix, std::string_view labels, std::string_view extra) {
+        out_.append(name_).append(suffix);
+        if (!labels.empty() || !extra.empty()) {
+            out_ += '{';
+            out_.append(labels);
+            if (!labels.empty() && !extra.empty()) {
+                out_ += ',';
+            }
+            out_.append(extra).append("} ");
+        } else {
+            out_ += ' ';
+        }
+    }
+
+    std::string& out_;
+    const std::string& prefix_;
+    ExpositionFormat format_;
+    std::string name_;
+    std::string le_;
+    const char* suffix_ = "";
+};
+
+void write_percentiles(std::ostream& json, const LatencyHistogram::Snapshot& snap) {
+    json << "{\"count\":" << snap.count
+         << ",\"p50\":" << snap.percentile(0.50)
+         << ",\"p90\":" << snap.percentile(0.90)
+         << ",\"p99\":" << snap.percentile(0.99)
+         << ",\"p999\":" << snap.percentile(0.999)
+         << ",\"max\":" << snap.max_ns << "}";
 }
 
-void LogMetrics::record_error() {
-    counters_.errors.fetch_add(1, std::memory_order_relaxed);
 }
 
-void LogMetrics::record_log_duration(uint64_t microseconds) {
-    timings_.total_log_time_us.fetch_add(microseconds, std::memory_order_relaxed);
-    
-    uint64_t current_max = timings_.max_log_latency_us.load(std::memory_order_relaxed);
-    while (microseconds > current_max) {
-        if (timings_.max_log_latency_us.compare_exchange_weak(current_max, microseconds, std::memory_order_relaxed)) {
-            break;
-        }
+const char* to_string(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::Filter: return "filter";
+        case PipelineStage::Redact: return "redact";
+        case PipelineStage::Enqueue: return "enqueue";
     }
+    return "unknown";
+}
+
+LogMetrics::LogMetrics()
+    : start_time_(std::chrono::steady_clock::now())
+{
+}
+
+void LogMetrics::record_log_duration(uint64_t microseconds) {
+    timings_.total_log_time_us.add(microseconds);
+    timings_.recent_log_latency_us.store(microseconds, std::memory_order_relaxed);
+    timings_.max_log_latency_us.update(microseconds);
 }
 
 void LogMetrics::record_flush_duration(uint64_t microseconds) {
-    timings_.total_flush_time_us.fetch_add(microseconds, std::memory_order_relaxed);
-    
-    uint64_t current_max = timings_.max_flush_latency_us.load(std::memory_order_relaxed);
-    while (microseconds > current_max) {
-        if (timings_.max_flush_latency_us.compare_exchange_weak(current_max, microseconds, std::memory_order_relaxed)) {
-            break;
-        }
-    }
+    record_flush_duration_ns(microseconds * 1000);
+}
+
+void LogMetrics::record_flush_duration_ns(uint64_t nanoseconds) {
+    timings_.flush_ns.record(nanoseconds);
+    const uint64_t microseconds = nanoseconds / 1000;
+    timings_.total_flush_time_us.add(microseconds);
+    timings_.max_flush_latency_us.update(microseconds);
 }
 
 void LogMetrics::update_queue_depth(size_t depth) {
     queue_metrics_.current_depth.store(depth, std::memory_order_relaxed);
-    
-    size_t current_max = queue_metrics_.max_depth.load(std::memory_order_relaxed);
-    while (depth > current_max) {
-        if (queue_metrics_.max_depth.compare_exchange_weak(current_max, depth, std::memory_order_relaxed)) {
-            break;
-        }
+    queue_metrics_.max_depth.update(depth);
+}
+
+void LogMetrics::set_timing_interval(uint32_t one_in) {
+    uint32_t interval = 1;
+    while (interval < one_in && interval < (1u << 31)) {
+        interval <<= 1;
     }
+    timing_mask_.store(interval - 1, std::memory_order_relaxed);
+}
+
+void LogMetrics::set_queue_capacity(size_t capacity) {
+    queue_metrics_.capacity.store(capacity, std::memory_order_relaxed);
+}
+
+void LogMetrics::update_sample_rate(size_t rate) {
+    queue_metrics_.sample_rate.store(rate, std::memory_order_relaxed);
+}
+
+void LogMetrics::record_lane_dropped(uint64_t lane_id) {
+    counters_.messages_dropped.add();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++lane_drops_[lane_id];
+}
+
+std::map<uint64_t, uint64_t> LogMetrics::get_lane_drops() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lane_drops_;
+}
+
+void LogMetrics::update_consumer_wait(size_t spin_budget, uint64_t spin_wakeups,
+                                      uint64_t yield_wakeups, uint64_t parks) {
+    queue_metrics_.spin_budget.store(spin_budget, std::memory_order_relaxed);
+    queue_metrics_.spin_wakeups.store(spin_wakeups, std::memory_order_relaxed);
+    queue_metrics_.yield_wakeups.store(yield_wakeups, std::memory_order_relaxed);
+    queue_metrics_.parks.store(parks, std::memory_order_relaxed);
 }
 
 double LogMetrics::get_messages_per_second() const {
@@ -72,12 +270,12 @@ double LogMetrics::get_messages_per_second() const {
         return 0.0;
     }
     
-    return static_cast<double>(counters_.messages_logged.load(std::memory_order_relaxed)) / elapsed_seconds;
+    return static_cast<double>(counters_.messages_logged.load()) / elapsed_seconds;
 }
 
 double LogMetrics::get_average_log_latency_us() const {
-    uint64_t total_time = timings_.total_log_time_us.load(std::memory_order_relaxed);
-    uint64_t count = counters_.messages_logged.load(std::memory_order_relaxed);
+    uint64_t total_time = timings_.total_log_time_us.load();
+    uint64_t count = counters_.messages_logged.load();
     
     if (count == 0) {
         return 0.0;
@@ -87,8 +285,8 @@ double LogMetrics::get_average_log_latency_us() const {
 }
 
 double LogMetrics::get_average_flush_latency_us() const {
-    uint64_t total_time = timings_.total_flush_time_us.load(std::memory_order_relaxed);
-    uint64_t count = counters_.flushes.load(std::memory_order_relaxed);
+    uint64_t total_time = timings_.total_flush_time_us.load();
+    uint64_t count = counters_.flushes.load();
     
     if (count == 0) {
         return 0.0;
@@ -100,19 +298,28 @@ double LogMetrics::get_average_flush_latency_us() const {
 void LogMetrics::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    counters_.messages_logged.store(0, std::memory_order_relaxed);
-    counters_.messages_dropped.store(0, std::memory_order_relaxed);
-    counters_.messages_filtered.store(0, std::memory_order_relaxed);
-    counters_.flushes.store(0, std::memory_order_relaxed);
-    counters_.errors.store(0, std::memory_order_relaxed);
-    
-    timings_.total_log_time_us.store(0, std::memory_order_relaxed);
-    timings_.total_flush_time_us.store(0, std::memory_order_relaxed);
-    timings_.max_log_latency_us.store(0, std::memory_order_relaxed);
-    timings_.max_flush_latency_us.store(0, std::memory_order_relaxed);
+    counters_.messages_logged.reset();
+    counters_.messages_dropped.reset();
+    counters_.messages_filtered.reset();
+    counters_.flushes.reset();
+    counters_.errors.reset();
+    counters_.pool_misses.reset();
+    
+    timings_.total_log_time_us.reset();
+    timings_.total_flush_time_us.reset();
+    timings_.max_log_latency_us.reset();
+    timings_.max_flush_latency_us.reset();
+    timings_.recent_log_latency_us.store(0, std::memory_order_relaxed);
+    timings_.log_call_ns.reset();
+    timings_.queue_wait_ns.reset();
+    timings_.flush_ns.reset();
+    for (auto& stage : stages_ns_) {
+        stage.reset();
+    }
     
     queue_metrics_.current_depth.store(0, std::memory_order_relaxed);
-    queue_metrics_.max_depth.store(0, std::memory_order_relaxed);
+    queue_metrics_.max_depth.reset();
+    lane_drops_.clear();
     
     start_time_ = std::chrono::steady_clock::now();
 }
@@ -131,12 +338,13 @@ LogMetrics::Snapshot LogMetrics::get_snapshot() const {
     snap.max_flush_latency_us = get_max_flush_latency_us();
     snap.current_queue_depth = get_current_queue_depth();
     snap.max_queue_depth = get_max_queue_depth();
+    snap.sample_rate = get_sample_rate();
     snap.timestamp = std::chrono::steady_clock::now();
     
     return snap;
 }
 
-std::string LogMetrics::export_prometheus(const std::string& prefix) const {
+std::string LogMetrics::export_prometheus(const std::string& prefix, const std::string& logger_label) const {
     std::ostringstream out;
     
     out << "# HELP " << prefix << "_messages_logged_total Total number of messages logged\n"
@@ -165,6 +373,19 @@ std::string LogMetrics::export_prometheus(const std::string& prefix) const {
         << "# TYPE " << prefix << "_log_latency_us_max gauge\n"
         << prefix << "_log_latency_us_max " << get_max_log_latency_us() << "\n\n";
     
+    write_histogram(out, prefix + "_log_call_latency_seconds",
+                    "Time spent in sampled log calls past the level check", "",
+                    get_log_call_latency());
+    write_histogram(out, prefix + "_queue_wait_seconds",
+                    "Time records spent in the async queue", "", get_queue_wait_latency());
+    write_histogram(out, prefix + "_flush_latency_seconds", "Time to flush all sinks", "", get_flush_latency());
+    const std::string logger = logger_label.empty() ? "" : "logger=\"" + escape_label(logger_label) + "\",";
+    for (size_t i = 0; i < pipeline_stage_count; ++i) {
+        const auto stage = static_cast<PipelineStage>(i);
+        write_histogram(out, prefix + "_stage_latency_seconds", "Time in each pipeline stage, on sampled calls",
+                        logger + "stage=\"" + to_string(stage) + "\",", get_stage_latency(stage));
+    }
+    
     out << "# HELP " << prefix << "_queue_depth Current async queue depth\n"
         << "# TYPE " << prefix << "_queue_depth gauge\n"
         << prefix << "_queue_depth " << get_current_queue_depth() << "\n\n";
@@ -173,6 +394,34 @@ std::string LogMetrics::export_prometheus(const std::string& prefix) const {
         << "# TYPE " << prefix << "_queue_depth_max gauge\n"
         << prefix << "_queue_depth_max " << get_max_queue_depth() << "\n\n";
     
+    out << "# HELP " << prefix << "_sample_rate Low-severity records kept 1 in N by adaptive sampling\n"
+        << "# TYPE " << prefix << "_sample_rate gauge\n"
+        << prefix << "_sample_rate " << get_sample_rate() << "\n\n";
+    
+    out << "# HELP " << prefix << "_consumer_spin_budget Spin/yield rounds before an idle consumer parks\n"
+        << "# TYPE " << prefix << "_consumer_spin_budget gauge\n"
+        << prefix << "_consumer_spin_budget " << get_spin_budget() << "\n\n";
+    
+    out << "# HELP " << prefix << "_consumer_wakeups_total Idle consumer wakeups by wait phase\n"
+        << "# TYPE " << prefix << "_consumer_wakeups_total counter\n"
+        << prefix << "_consumer_wakeups_total{phase=\"spin\"} " << get_spin_wakeups() << "\n"
+        << prefix << "_consumer_wakeups_total{phase=\"yield\"} " << get_yield_wakeups() << "\n"
+        << prefix << "_consumer_wakeups_total{phase=\"park\"} " << get_consumer_parks() << "\n\n";
+    
+    auto lane_drops = get_lane_drops();
+    if (!lane_drops.empty()) {
+        out << "# HELP " << prefix << "_lane_dropped_total Messages dropped per producer lane\n"
+            << "# TYPE " << prefix << "_lane_dropped_total counter\n";
+        for (const auto& [lane, dropped] : lane_drops) {
+            out << prefix << "_lane_dropped_total{lane=\"" << lane << "\"} " << dropped << "\n";
+        }
+        out << "\n";
+    }
+    
+    out << "# HELP " << prefix << "_record_pool_misses_total Async records allocated because the pool was empty\n"
+        << "# TYPE " << prefix << "_record_pool_misses_total counter\n"
+        << prefix << "_record_pool_misses_total " << get_pool_misses() << "\n\n";
+    
     out << "# HELP " << prefix << "_errors_total Total number of logging errors\n"
         << "# TYPE " << prefix << "_errors_total counter\n"
         << prefix << "_errors_total " << get_errors() << "\n\n";
@@ -189,14 +438,32 @@ std::string LogMetrics::export_json() const {
          << "\"messages_filtered\":" << get_messages_filtered() << ","
          << "\"flushes\":" << get_flushes() << ","
          << "\"errors\":" << get_errors() << ","
+         << "\"record_pool_misses\":" << get_pool_misses() << ","
          << "\"messages_per_second\":" << std::fixed << std::setprecision(2) << get_messages_per_second() << ","
          << "\"avg_log_latency_us\":" << std::fixed << std::setprecision(2) << get_average_log_latency_us() << ","
          << "\"avg_flush_latency_us\":" << std::fixed << std::setprecision(2) << get_average_flush_latency_us() << ","
          << "\"max_log_latency_us\":" << get_max_log_latency_us() << ","
          << "\"max_flush_latency_us\":" << get_max_flush_latency_us() << ","
          << "\"current_queue_depth\":" << get_current_queue_depth() << ","
-         << "\"max_queue_depth\":" << get_max_queue_depth()
-         << "}";
+         << "\"max_queue_depth\":" << get_max_queue_depth() << ","
+         << "\"sample_rate\":" << get_sample_rate() << ","
+         << "\"consumer_spin_budget\":" << get_spin_budget() << ","
+         << "\"consumer_spin_wakeups\":" << get_spin_wakeups() << ","
+         << "\"consumer_yield_wakeups\":" << get_yield_wakeups() << ","
+         << "\"consumer_parks\":" << get_consumer_parks() << ","
+         << "\"log_call_latency_ns\":";
+    write_percentiles(json, get_log_call_latency());
+    json << ",\"queue_wait_ns\":";
+    write_percentiles(json, get_queue_wait_latency());
+    json << ",\"flush_latency_ns\":";
+    write_percentiles(json, get_flush_latency());
+    json << ",\"stages_ns\":{";
+    for (size_t i = 0; i < pipeline_stage_count; ++i) {
+        const auto stage = static_cast<PipelineStage>(i);
+        json << (i ? "," : "") << "\"" << to_string(stage) << "\":";
+        write_percentiles(json, get_stage_latency(stage));
+    }
+    json << "}}";
     
     return json.str();
 }
@@ -208,8 +475,13 @@ SinkMetrics::SinkMetrics(const std::string& sink_name)
 }
 
 void SinkMetrics::record_write(size_t bytes) {
-    writes_.fetch_add(1, std::memory_order_relaxed);
-    bytes_written_.fetch_add(bytes, std::memory_order_relaxed);
+    writes_.add();
+    bytes_written_.add(bytes);
+}
+
+void SinkMetrics::record_writes(uint64_t count, uint64_t bytes) {
+    writes_.add(count);
+    bytes_written_.add(bytes);
 }
 
 void SinkMetrics::record_flush() {
@@ -221,12 +493,27 @@ void SinkMetrics::record_error() {
 }
 
 void SinkMetrics::record_write_duration(uint64_t microseconds) {
-    total_write_time_us_.fetch_add(microseconds, std::memory_order_relaxed);
+    record_write_duration_ns(microseconds * 1000);
+}
+
+void SinkMetrics::record_write_duration_ns(uint64_t nanoseconds) {
+    write_ns_.record(nanoseconds);
+    total_write_time_us_.fetch_add(nanoseconds / 1000, std::memory_order_relaxed);
+}
+
+void SinkMetrics::update_queue_depth(size_t depth) {
+    queue_depth_.store(depth, std::memory_order_relaxed);
+}
+
+void SinkMetrics::record_dropped(uint64_t count) {
+    if (count > 0) {
+        dropped_.fetch_add(count, std::memory_order_relaxed);
+    }
 }
 
 double SinkMetrics::get_average_write_latency_us() const {
     uint64_t total_time = total_write_time_us_.load(std::memory_order_relaxed);
-    uint64_t count = writes_.load(std::memory_order_relaxed);
+    uint64_t count = writes_.load();
     
     if (count == 0) {
         return 0.0;
@@ -251,9 +538,175 @@ std::string SinkMetrics::export_prometheus(const std::string& prefix) const {
         << prefix << "_sink_write_latency_us_avg{sink=\"" << name_ << "\"} " 
         << std::fixed << std::setprecision(2) << get_average_write_latency_us() << "\n\n";
     
+    write_histogram(out, prefix + "_sink_write_latency_seconds", "Time per batch written by sink",
+                    "sink=\"" + escape_label(name_) + "\",", get_write_latency());
+    write_histogram(out, prefix + "_sink_format_latency_seconds", "Time rendering records with the sink's layout",
+                    "sink=\"" + escape_label(name_) + "\",", get_format_latency());
+    
+    out << "# HELP " << prefix << "_sink_queue_depth Records waiting in the sink's dedicated queue\n"
+        << "# TYPE " << prefix << "_sink_queue_depth gauge\n"
+        << prefix << "_sink_queue_depth{sink=\"" << name_ << "\"} " << get_queue_depth() << "\n\n";
+    
+    out << "# HELP " << prefix << "_sink_dropped_total Records dropped by the sink's dedicated queue\n"
+        << "# TYPE " << prefix << "_sink_dropped_total counter\n"
+        << prefix << "_sink_dropped_total{sink=\"" << name_ << "\"} " << get_dropped() << "\n\n";
+    
+    return out.str();
+}
+
+std::string SinkMetrics::export_json() const {
+    std::ostringstream json;
+    json << "{"
+         << "\"writes\":" << get_writes() << ","
+         << "\"bytes_written\":" << get_bytes_written() << ","
+         << "\"flushes\":" << get_flushes() << ","
+         << "\"errors\":" << get_errors() << ","
+         << "\"queue_depth\":" << get_queue_depth() << ","
+         << "\"dropped\":" << get_dropped() << ","
+         << "\"avg_write_latency_us\":" << std::fixed << std::setprecision(2) << get_average_write_latency_us() << ","
+         << "\"write_latency_ns\":";
+    write_percentiles(json, get_write_latency());
+    json << ",\"format_latency_ns\":";
+    write_percentiles(json, get_format_latency());
+    json << "}";
+    return json.str();
+}
+
+LimiterMetrics::LimiterMetrics(const std::string& limiter_name, size_t max_keys)
+    : name_(limiter_name), max_keys_(std::max<size_t>(max_keys, 1)) {}
+
+void LimiterMetrics::record_offender(const std::string& key, uint64_t dropped, uint64_t newly_dropped) {
+    dropped_.fetch_add(newly_dropped, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& offender : offenders_) {
+        if (offender.key == key) {
+            offender.dropped = std::max(offender.dropped, dropped);
+            return;
+        }
+    }
+    if (offenders_.size() < max_keys_) {
+        offenders_.push_back(Offender{key, dropped});
+        return;
+    }
+    auto smallest = std::min_element(offenders_.begin(), offenders_.end(),
+                                     [](const Offender& a, const Offender& b) { return a.dropped < b.dropped; });
+    if (smallest->dropped < dropped) {
+        *smallest = Offender{key, dropped};
+    }
+}
+
+std::vector<LimiterMetrics::Offender> LimiterMetrics::top_offenders() const {
+    std::vector<Offender> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sorted = offenders_;
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Offender& a, const Offender& b) { return a.dropped > b.dropped; });
+    return sorted;
+}
+
+std::string LimiterMetrics::export_prometheus(const std::string& prefix) const {
+    std::ostringstream out;
+
+    out << "# HELP " << prefix << "_limiter_dropped_total Records dropped by keyed rate limiter\n"
+        << "# TYPE " << prefix << "_limiter_dropped_total counter\n"
+        << prefix << "_limiter_dropped_total{limiter=\"" << name_ << "\"} " << get_dropped() << "\n\n";
+
+    out << "# HELP " << prefix << "_limiter_key_dropped_total Records dropped for the limiter's top keys\n"
+        << "# TYPE " << prefix << "_limiter_key_dropped_total counter\n";
+    for (const auto& offender : top_offenders()) {
+        out << prefix << "_limiter_key_dropped_total{limiter=\"" << name_ << "\",key=\""
+            << escape_label(offender.key) << "\"} " << offender.dropped << "\n";
+    }
+    out << "\n";
+
     return out.str();
 }
 
+std::string LimiterMetrics::export_json() const {
+    std::ostringstream json;
+    json << "{\"dropped\":" << get_dropped() << ",\"top_offenders\":[";
+    bool first = true;
+    for (const auto& offender : top_offenders()) {
+        if (!first) json << ",";
+        json << "{\"key\":\"" << escape_label(offender.key) << "\",\"dropped\":" << offender.dropped << "}";
+        first = false;
+    }
+    json << "]}";
+    return json.str();
+}
+
+
+TenantMetrics::TenantMetrics(const std::string& queue_name) : name_(queue_name) {}
+
+std::shared_ptr<TenantMetrics::Counters> TenantMetrics::tenant(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& counters = tenants_[key];
+    if (!counters) {
+        counters = std::make_shared<Counters>();
+    }
+    return counters;
+}
+
+std::vector<TenantMetrics::Snapshot> TenantMetrics::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Snapshot> tenants;
+    tenants.reserve(tenants_.size());
+    for (const auto& [key, counters] : tenants_) {
+        tenants.push_back(Snapshot{key,
+                                   counters->queued.load(std::memory_order_relaxed),
+                                   counters->queued_bytes.load(std::memory_order_relaxed),
+                                   counters->enqueued.load(std::memory_order_relaxed),
+                                   counters->over_quota.load(std::memory_order_relaxed),
+                                   counters->evicted.load(std::memory_order_relaxed)});
+    }
+    return tenants;
+}
+
+std::string TenantMetrics::export_prometheus(const std::string& prefix) const {
+    std::ostringstream out;
+    const auto tenants = snapshot();
+    const std::string queue = "queue=\"" + escape_label(name_) + "\"";
+
+    out << "# HELP " << prefix << "_tenant_quota_bytes Bytes each tenant may hold queued, 0 = no quota\n"
+        << "# TYPE " << prefix << "_tenant_quota_bytes gauge\n"
+        << prefix << "_tenant_quota_bytes{" << queue << "} " << get_quota_bytes() << "\n\n";
+
+    auto family = [&](const char* name, const char* type, const char* help, auto&& value) {
+        out << "# HELP " << prefix << "_" << name << " " << help << "\n"
+            << "# TYPE " << prefix << "_" << name << " " << type << "\n";
+        for (const auto& tenant : tenants) {
+            out << prefix << "_" << name << "{" << queue << ",tenant=\"" << escape_label(tenant.tenant) << "\"} "
+                << value(tenant) << "\n";
+        }
+        out << "\n";
+    };
+    family("tenant_queued_bytes", "gauge", "Bytes queued per tenant",
+           [](const Snapshot& t) { return t.queued_bytes; });
+    family("tenant_enqueued_total", "counter", "Records queued per tenant",
+           [](const Snapshot& t) { return t.enqueued; });
+    family("tenant_dropped_total", "counter", "Records refused at the tenant's quota or evicted",
+           [](const Snapshot& t) { return t.over_quota + t.evicted; });
+
+    return out.str();
+}
+
+std::string TenantMetrics::export_json() const {
+    std::ostringstream json;
+    json << "{\"quota_bytes\":" << get_quota_bytes() << ",\"tenants\":{";
+    bool first = true;
+    for (const auto& tenant : snapshot()) {
+        if (!first) json << ",";
+        json << "\"" << escape_label(tenant.tenant) << "\":{\"queued\":" << tenant.queued
+             << ",\"queued_bytes\":" << tenant.queued_bytes << ",\"enqueued\":" << tenant.enqueued
+             << ",\"over_quota\":" << tenant.over_quota << ",\"evicted\":" << tenant.evicted << "}";
+        first = false;
+    }
+    json << "},\"render_buffer_high_water_bytes\":" << RenderCache::high_water_bytes() << "}";
+    return json.str();
+}
 
 MetricsRegistry& MetricsRegistry::instance() {
     static MetricsRegistry registry;
@@ -270,6 +723,7 @@ std::shared_ptr<LogMetrics> MetricsRegistry::get_logger_metrics(const std::strin
     
     auto metrics = std::make_shared<LogMetrics>();
     logger_metrics_[logger_name] = metrics;
+    entries_.reset();
     return metrics;
 }
 
@@ -283,75 +737,251 @@ std::shared_ptr<SinkMetrics> MetricsRegistry::get_sink_metrics(const std::string
     
     auto metrics = std::make_shared<SinkMetrics>(sink_name);
     sink_metrics_[sink_name] = metrics;
+    entries_.reset();
     return metrics;
 }
 
-std::map<std::string, LogMetrics::Snapshot> MetricsRegistry::get_all_logger_snapshots() const {
+std::shared_ptr<LimiterMetrics> MetricsRegistry::get_limiter_metrics(const std::string& limiter_name) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::map<std::string, LogMetrics::Snapshot> snapshots;
-    for (const auto& pair : logger_metrics_) {
-        snapshots[pair.first] = pair.second->get_snapshot();
+
+    auto it = limiter_metrics_.find(limiter_name);
+    if (it != limiter_metrics_.end()) {
+        return it->second;
     }
-    
-    return snapshots;
+
+    auto metrics = std::make_shared<LimiterMetrics>(limiter_name);
+    limiter_metrics_[limiter_name] = metrics;
+    entries_.reset();
+    return metrics;
 }
 
-std::string MetricsRegistry::export_all_prometheus(const std::string& prefix) const {
+std::shared_ptr<TenantMetrics> MetricsRegistry::get_tenant_metrics(const std::string& queue_name) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::ostringstream out;
-    
-    for (const auto& pair : logger_metrics_) {
-        out << "# Logger: " << pair.first << "\n";
-        out << pair.second->export_prometheus(prefix + "_logger");
+
+    auto it = tenant_metrics_.find(queue_name);
+    if (it != tenant_metrics_.end()) {
+        return it->second;
     }
+
+    auto metrics = std::make_shared<TenantMetrics>(queue_name);
+    tenant_metrics_[queue_name] = metrics;
+    entries_.reset();
+    return metrics;
+}
+
+std::shared_ptr<const MetricsRegistry::Entries> MetricsRegistry::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!entries_) {
+        auto entries = std::make_shared<Entries>();
+        auto copy = [](const auto& from, auto& to, const char* kind) {
+            to.reserve(from.size());
+            for (const auto& [name, metrics] : from) {
+                to.push_back({name, std::string(kind) + "=\"" + escape_label(name) + "\"", metrics});
+            }
+        };
+        copy(logger_metrics_, entries->loggers, "logger");
+        copy(sink_metrics_, entries->sinks, "sink");
+        copy(limiter_metrics_, entries->limiters, "limiter");
+        copy(tenant_metrics_, entries->tenants, "queue");
+        entries_ = std::move(entries);
+    }
+    return entries_;
+}
+
+std::map<std::string, LogMetrics::Snapshot> MetricsRegistry::get_all_logger_snapshots() const {
+    const auto all = entries();
     
-    for (const auto& pair : sink_metrics_) {
-        out << pair.second->export_prometheus(prefix);
+    std::map<std::string, LogMetrics::Snapshot> snapshots;
+    for (const auto& entry : all->loggers) {
+        snapshots[entry.name] = entry.metrics->get_snapshot();
     }
     
-    return out.str();
+    return snapshots;
+}
+
+std::string MetricsRegistry::export_all_prometheus(const std::string& prefix) const {
+    std::string out;
+    write_exposition(out, prefix);
+    return out;
+}
+
+void MetricsRegistry::write_exposition(std::string& out, const std::string& prefix, ExpositionFormat format) const {
+    const auto all = entries();
+    out.clear();
+    Exposition x(out, prefix, format);
+
+    // A family per metric, a series per object, so each value is read once
+    auto family = [&](const auto& entries, const char* name, const char* type, const char* help, auto&& write) {
+        x.family(name, type, help);
+        for (const auto& entry : entries) {
+            write(entry.label, *entry.metrics);
+        }
+    };
+    using L = const LogMetrics&;
+    using S = const SinkMetrics&;
+    using Label = const std::string&;
+
+    const auto& loggers = all->loggers;
+    family(loggers, "logger_messages_logged", "counter", "Total number of messages logged",
+           [&](Label l, L m) { x.sample(l, m.get_messages_logged()); });
+    family(loggers, "logger_messages_dropped", "counter", "Total number of messages dropped",
+           [&](Label l, L m) { x.sample(l, m.get_messages_dropped()); });
+    family(loggers, "logger_messages_filtered", "counter", "Total number of messages filtered",
+           [&](Label l, L m) { x.sample(l, m.get_messages_filtered()); });
+    family(loggers, "logger_messages_per_second", "gauge", "Current logging rate",
+           [&](Label l, L m) { x.sample(l, m.get_messages_per_second(), 2); });
+    family(loggers, "logger_log_latency_us_avg", "gauge", "Average log call latency in microseconds",
+           [&](Label l, L m) { x.sample(l, m.get_average_log_latency_us(), 2); });
+    family(loggers, "logger_log_latency_us_max", "gauge", "Maximum log call latency in microseconds",
+           [&](Label l, L m) { x.sample(l, m.get_max_log_latency_us()); });
+    family(loggers, "logger_log_call_latency_seconds", "histogram",
+           "Time spent in sampled log calls past the level check",
+           [&](Label l, L m) { x.histogram(l, m.get_log_call_latency()); });
+    family(loggers, "logger_queue_wait_seconds", "histogram", "Time records spent in the async queue",
+           [&](Label l, L m) { x.histogram(l, m.get_queue_wait_latency()); });
+    family(loggers, "logger_flush_latency_seconds", "histogram", "Time to flush all sinks",
+           [&](Label l, L m) { x.histogram(l, m.get_flush_latency()); });
+    family(loggers, "logger_stage_latency_seconds", "histogram", "Time in each pipeline stage, on sampled calls",
+           [&](Label l, L m) {
+               for (size_t i = 0; i < pipeline_stage_count; ++i) {
+                   const auto stage = static_cast<PipelineStage>(i);
+                   x.histogram(l, m.get_stage_latency(stage), std::string("stage=\"") + to_string(stage) + "\"");
+               }
+           });
+    family(loggers, "logger_queue_depth", "gauge", "Current async queue depth",
+           [&](Label l, L m) { x.sample(l, static_cast<uint64_t>(m.get_current_queue_depth())); });
+    family(loggers, "logger_queue_depth_max", "gauge", "Maximum async queue depth",
+           [&](Label l, L m) { x.sample(l, static_cast<uint64_t>(m.get_max_queue_depth())); });
+    family(loggers, "logger_sample_rate", "gauge", "Low-severity records kept 1 in N by adaptive sampling",
+           [&](Label l, L m) { x.sample(l, static_cast<uint64_t>(m.get_sample_rate())); });
+    family(loggers, "logger_consumer_spin_budget", "gauge", "Spin/yield rounds before an idle consumer parks",
+           [&](Label l, L m) { x.sample(l, static_cast<uint64_t>(m.get_spin_budget())); });
+    family(loggers, "logger_consumer_wakeups", "counter", "Idle consumer wakeups by wait phase",
+           [&](Label l, L m) {
+               x.sample(l, m.get_spin_wakeups(), "phase=\"spin\"");
+               x.sample(l, m.get_yield_wakeups(), "phase=\"yield\"");
+               x.sample(l, m.get_consumer_parks(), "phase=\"park\"");
+           });
+    family(loggers, "logger_lane_dropped", "counter", "Messages dropped per producer lane",
+           [&](Label l, L m) {
+               for (const auto& [lane, dropped] : m.get_lane_drops()) {
+                   x.sample(l, dropped, "lane=\"" + std::to_string(lane) + "\"");
+               }
+           });
+    family(loggers, "logger_record_pool_misses", "counter", "Async records allocated because the pool was empty",
+           [&](Label l, L m) { x.sample(l, m.get_pool_misses()); });
+    family(loggers, "logger_errors", "counter", "Total number of logging errors",
+           [&](Label l, L m) { x.sample(l, m.get_errors()); });
+
+    const auto& sinks = all->sinks;
+    family(sinks, "sink_writes", "counter", "Total writes by sink",
+           [&](Label l, S m) { x.sample(l, m.get_writes()); });
+    family(sinks, "sink_bytes_written", "counter", "Total bytes written by sink",
+           [&](Label l, S m) { x.sample(l, m.get_bytes_written()); });
+    family(sinks, "sink_write_latency_us_avg", "gauge", "Average write latency by sink",
+           [&](Label l, S m) { x.sample(l, m.get_average_write_latency_us(), 2); });
+    family(sinks, "sink_write_latency_seconds", "histogram", "Time per batch written by sink",
+           [&](Label l, S m) { x.histogram(l, m.get_write_latency()); });
+    family(sinks, "sink_format_latency_seconds", "histogram", "Time rendering records with the sink's layout",
+           [&](Label l, S m) { x.histogram(l, m.get_format_latency()); });
+    family(sinks, "sink_queue_depth", "gauge", "Records waiting in the sink's dedicated queue",
+           [&](Label l, S m) { x.sample(l, static_cast<uint64_t>(m.get_queue_depth())); });
+    family(sinks, "sink_dropped", "counter", "Records dropped by the sink's dedicated queue",
+           [&](Label l, S m) { x.sample(l, m.get_dropped()); });
+
+    const auto& limiters = all->limiters;
+    family(limiters, "limiter_dropped", "counter", "Records dropped by keyed rate limiter",
+           [&](Label l, const LimiterMetrics& m) { x.sample(l, m.get_dropped()); });
+    family(limiters, "limiter_key_dropped", "counter", "Records dropped for the limiter's top keys",
+           [&](Label l, const LimiterMetrics& m) {
+               for (const auto& offender : m.top_offenders()) {
+                   x.sample(l, offender.dropped, "key=\"" + escape_label(offender.key) + "\"");
+               }
+           });
+
+    const auto& tenants = all->tenants;
+    using T = const TenantMetrics&;
+    family(tenants, "tenant_quota_bytes", "gauge", "Bytes each tenant may hold queued, 0 = no quota",
+           [&](Label l, T m) { x.sample(l, m.get_quota_bytes()); });
+    family(tenants, "tenant_queued_bytes", "gauge", "Bytes queued per tenant",
+           [&](Label l, T m) {
+               for (const auto& tenant : m.snapshot()) {
+                   x.sample(l, tenant.queued_bytes, "tenant=\"" + escape_label(tenant.tenant) + "\"");
+               }
+           });
+    family(tenants, "tenant_enqueued", "counter", "Records queued per tenant",
+           [&](Label l, T m) {
+               for (const auto& tenant : m.snapshot()) {
+                   x.sample(l, tenant.enqueued, "tenant=\"" + escape_label(tenant.tenant) + "\"");
+               }
+           });
+    family(tenants, "tenant_dropped", "counter", "Records dropped per tenant, by reason",
+           [&](Label l, T m) {
+               for (const auto& tenant : m.snapshot()) {
+                   const std::string key = "tenant=\"" + escape_label(tenant.tenant) + "\"";
+                   x.sample(l, tenant.over_quota, key + ",reason=\"quota\"");
+                   x.sample(l, tenant.evicted, key + ",reason=\"evicted\"");
+               }
+           });
+
+    x.family("render_buffer_high_water_bytes", "gauge", "Most bytes a thread's render buffers held for one record or batch");
+    x.sample({}, static_cast<uint64_t>(RenderCache::high_water_bytes()));
+
+    x.finish();
+}
+
+const char* content_type(ExpositionFormat format) {
+    return format == ExpositionFormat::OpenMetrics ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                                                   : "text/plain; version=0.0.4; charset=utf-8";
 }
 
 std::string MetricsRegistry::export_all_json() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    const auto all = entries();
     
     std::ostringstream json;
     json << "{\"loggers\":{";
     
     bool first_logger = true;
-    for (const auto& pair : logger_metrics_) {
+    for (const auto& entry : all->loggers) {
         if (!first_logger) json << ",";
-        json << "\"" << pair.first << "\":" << pair.second->export_json();
+        json << "\"" << entry.name << "\":" << entry.metrics->export_json();
         first_logger = false;
     }
     
     json << "},\"sinks\":{";
     
     bool first_sink = true;
-    for (const auto& pair : sink_metrics_) {
+    for (const auto& entry : all->sinks) {
         if (!first_sink) json << ",";
-        json << "\"" << pair.first << "\":{"
-             << "\"writes\":" << pair.second->get_writes() << ","
-             << "\"bytes_written\":" << pair.second->get_bytes_written() << ","
-             << "\"flushes\":" << pair.second->get_flushes() << ","
-             << "\"errors\":" << pair.second->get_errors() << ","
-             << "\"avg_write_latency_us\":" << std::fixed << std::setprecision(2) 
-             << pair.second->get_average_write_latency_us()
-             << "}";
+        json << "\"" << entry.name << "\":" << entry.metrics->export_json();
         first_sink = false;
     }
+
+    json << "},\"limiters\":{";
+
+    bool first_limiter = true;
+    for (const auto& entry : all->limiters) {
+        if (!first_limiter) json << ",";
+        json << "\"" << entry.name << "\":" << entry.metrics->export_json();
+        first_limiter = false;
+    }
+
+    json << "},\"tenants\":{";
+
+    bool first_queue = true;
+    for (const auto& entry : all->tenants) {
+        if (!first_queue) json << ",";
+        json << "\"" << entry.name << "\":" << entry.metrics->export_json();
+        first_queue = false;
+    }
     
-    json << "}}";
+    json << "},\"render_buffer_high_water_bytes\":" << RenderCache::high_water_bytes() << "}";
     return json.str();
 }
 
 void MetricsRegistry::reset_all() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    for (auto& pair : logger_metrics_) {
-        pair.second->reset();
+    for (const auto& entry : entries()->loggers) {
+        entry.metrics->reset();
     }
 }
 
@@ -0,0 +1,230 @@
+#include "Zyrnix/log_sidecar.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace Zyrnix {
+
+namespace sidecar {
+
+namespace {
+
+constexpr uint64_t fnv_offset = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+uint64_t fnv1a(uint64_t h, std::string_view text) {
+    for (unsigned char c : text) {
+        h = (h ^ c) * fnv_prime;
+    }
+    return h;
+}
+
+int64_t unix_ns(std::chrono::system_clock::time_point when) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+}
+
+void put(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {}
+
+    bool get(uint64_t& value, size_t bytes) {
+        if (data_.size() - pos_ < bytes) return false;
+        value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_ + i])) << (8 * i);
+        }
+        pos_ += bytes;
+        return true;
+    }
+
+    bool get(std::string_view& out, size_t bytes) {
+        if (data_.size() - pos_ < bytes) return false;
+        out = data_.substr(pos_, bytes);
+        pos_ += bytes;
+        return true;
+    }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+}
+
+uint64_t hash(std::string_view key, std::string_view value) {
+    return fnv1a(fnv1a(fnv1a(fnv_offset, key), "="), value);
+}
+
+std::optional<Index> Index::read(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    Reader reader(data);
+    Index index;
+    std::string_view head;
+    uint64_t value;
+    if (!reader.get(head, sizeof(magic)) || head != std::string_view(magic, sizeof(magic))) {
+        return std::nullopt;
+    }
+    if (!reader.get(index.data_size, 8)) return std::nullopt;
+    if (!reader.get(value, 8)) return std::nullopt;
+    index.min_ns = static_cast<int64_t>(value);
+    if (!reader.get(value, 8)) return std::nullopt;
+    index.max_ns = static_cast<int64_t>(value);
+    if (!reader.get(index.records, 8)) return std::nullopt;
+    for (auto& count : index.level_counts) {
+        if (!reader.get(count, 8)) return std::nullopt;
+    }
+    uint64_t keys;
+    if (!reader.get(keys, 4)) return std::nullopt;
+    for (uint64_t i = 0; i < keys; ++i) {
+        uint64_t length;
+        std::string_view key;
+        if (!reader.get(length, 2) || !reader.get(key, static_cast<size_t>(length))) return std::nullopt;
+        index.keys.emplace_back(key);
+    }
+    if (!reader.get(value, 4)) return std::nullopt;
+    index.hash_count = static_cast<uint32_t>(value);
+    std::string_view bits;
+    if (!reader.get(index.bit_count, 8) || !reader.get(bits, static_cast<size_t>((index.bit_count + 7) / 8))) {
+        return std::nullopt;
+    }
+    index.bits.assign(bits.begin(), bits.end());
+    return index;
+}
+
+bool Index::is_key(std::string_view key) const {
+    return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
+
+bool Index::may_contain(std::string_view key, std::string_view value) const {
+    if (!is_key(key) || bit_count == 0) {
+        return true;
+    }
+    const uint64_t h = hash(key, value);
+    const uint64_t h1 = h & 0xffffffffu;
+    const uint64_t h2 = (h >> 32) | 1;
+    for (uint32_t i = 0; i < hash_count; ++i) {
+        const uint64_t bit = (h1 + i * h2) % bit_count;
+        if ((bits[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Builder::Builder(const SidecarOptions& options) {
+    index_.keys = options.bloom_fields;
+    // The usual optimum: m = -n ln p / (ln 2)^2 bits and k = m / n ln 2 hashes
+    const double n = static_cast<double>(std::max<size_t>(options.expected_values, 1));
+    const double p = std::clamp(options.false_positive_rate, 1e-9, 0.5);
+    const double ln2 = std::log(2.0);
+    index_.bit_count = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(-n * std::log(p) / (ln2 * ln2))), 64);
+    index_.hash_count = std::clamp<uint32_t>(
+        static_cast<uint32_t>(std::lround(static_cast<double>(index_.bit_count) / n * ln2)), 1, 16);
+    index_.bits.assign(static_cast<size_t>((index_.bit_count + 7) / 8), 0);
+}
+
+void Builder::add(std::chrono::system_clock::time_point timestamp, LogLevel level) {
+    const int64_t ns = unix_ns(timestamp);
+    index_.min_ns = std::min(index_.min_ns, ns);
+    index_.max_ns = std::max(index_.max_ns, ns);
+    ++index_.records;
+    ++index_.level_counts[std::min<size_t>(static_cast<size_t>(level), level_count - 1)];
+}
+
+void Builder::add(const FormattedRecord& record) {
+    add(record.timestamp(), record.level());
+    for (const std::string& key : index_.keys) {
+        if (key == "trace_id" && record.trace().valid()) {
+            char hex[TraceContext::trace_id_hex_size];
+            record.trace().write_trace_id(hex);
+            add_value(key, std::string_view(hex, sizeof(hex)));
+        }
+    }
+    for (const auto& field : record.fields()) {
+        for (const std::string& key : index_.keys) {
+            if (field.key == key) {
+                add_value(key, field.value.text());
+            }
+        }
+    }
+}
+
+void Builder::add_value(std::string_view key, std::string_view value) {
+    const uint64_t h = hash(key, value);
+    const uint64_t h1 = h & 0xffffffffu;
+    const uint64_t h2 = (h >> 32) | 1;
+    for (uint32_t i = 0; i < index_.hash_count; ++i) {
+        const uint64_t bit = (h1 + i * h2) % index_.bit_count;
+        index_.bits[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+    }
+}
+
+bool Builder::write(const std::string& path, uint64_t data_size) const {
+    std::string out(magic, sizeof(magic));
+    put(out, data_size, 8);
+    put(out, static_cast<uint64_t>(index_.min_ns), 8);
+    put(out, static_cast<uint64_t>(index_.max_ns), 8);
+    put(out, index_.records, 8);
+    for (uint64_t count : index_.level_counts) {
+        put(out, count, 8);
+    }
+    put(out, index_.keys.size(), 4);
+    for (const std::string& key : index_.keys) {
+        const size_t length = std::min<size_t>(key.size(), UINT16_MAX);
+        put(out, length, 2);
+        out.append(key, 0, length);
+    }
+    put(out, index_.hash_count, 4);
+    put(out, index_.bit_count, 8);
+    out.append(reinterpret_cast<const char*>(index_.bits.data()), index_.bits.size());
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void Builder::resume(const std::string& path, uint64_t data_size) {
+    reset();
+    if (data_size == 0) {
+        return;
+    }
+    const auto index = Index::read(path);
+    if (!index || index->data_size != data_size || index->keys != index_.keys ||
+        index->bit_count != index_.bit_count || index->hash_count != index_.hash_count) {
+        complete_ = false;
+        return;
+    }
+    index_ = *index;
+}
+
+void Builder::reset() {
+    index_.min_ns = INT64_MAX;
+    index_.max_ns = INT64_MIN;
+    index_.records = 0;
+    index_.level_counts.fill(0);
+    std::fill(index_.bits.begin(), index_.bits.end(), uint8_t{0});
+    complete_ = true;
+}
+
+}
+
+}
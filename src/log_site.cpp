@@ -0,0 +1,172 @@
+#include "Zyrnix/log_site.hpp"
+#include <mutex>
+#include <sstream>
+
+namespace Zyrnix {
+
+namespace {
+
+struct Rule {
+    std::string file_glob;
+    std::string function_glob;
+    bool enable;
+};
+
+struct Registry {
+    std::mutex mtx;
+    std::vector<const LogSite*> sites;
+    std::vector<Rule> rules;
+};
+
+Registry& registry() {
+    // Leaked so sites can still be checked during static destruction
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+bool rule_matches(const Rule& rule, const LogSite& site) {
+    return (SiteRegistry::glob_match(rule.file_glob, site.file) ||
+            SiteRegistry::glob_match(rule.file_glob, site.file_name())) &&
+           SiteRegistry::glob_match(rule.function_glob, site.function);
+}
+
+// Called with the registry locked
+bool wanted(const Registry& reg, const LogSite& site) {
+    for (auto it = reg.rules.rbegin(); it != reg.rules.rend(); ++it) {
+        if (rule_matches(*it, site)) {
+            return it->enable;
+        }
+    }
+    return false;
+}
+
+}
+
+bool SiteRegistry::glob_match(std::string_view pattern, std::string_view text) {
+    // Iterative matcher: on a mismatch, retry from just after the last '*'
+    size_t p = 0;
+    size_t t = 0;
+    size_t star = std::string_view::npos;
+    size_t resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+uint8_t SiteRegistry::enroll(SiteSwitch& control, const LogSite& site) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    uint8_t state = control.state_.load(std::memory_order_relaxed);
+    if (state != SiteSwitch::Unseen) {
+        return state;  // Another thread got here first
+    }
+    reg.sites.push_back(&site);
+    state = wanted(reg, site) ? SiteSwitch::On : SiteSwitch::Off;
+    control.state_.store(state, std::memory_order_relaxed);
+    return state;
+}
+
+size_t SiteRegistry::add_rule(std::string_view file_glob, std::string_view function_glob, bool enable) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    // A repeated pattern replaces its earlier rule rather than piling up
+    for (auto it = reg.rules.begin(); it != reg.rules.end(); ++it) {
+        if (it->file_glob == file_glob && it->function_glob == function_glob) {
+            reg.rules.erase(it);
+            break;
+        }
+    }
+    reg.rules.push_back(Rule{std::string(file_glob), std::string(function_glob), enable});
+
+    size_t matched = 0;
+    for (const LogSite* site : reg.sites) {
+        if (rule_matches(reg.rules.back(), *site)) {
+            ++matched;
+        }
+        const bool on = wanted(reg, *site);
+        site->control->state_.store(on ? SiteSwitch::On : SiteSwitch::Off, std::memory_order_relaxed);
+    }
+    return matched;
+}
+
+size_t SiteRegistry::enable(std::string_view file_glob, std::string_view function_glob) {
+    return add_rule(file_glob, function_glob, true);
+}
+
+size_t SiteRegistry::disable(std::string_view file_glob, std::string_view function_glob) {
+    return add_rule(file_glob, function_glob, false);
+}
+
+void SiteRegistry::reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    reg.rules.clear();
+    for (const LogSite* site : reg.sites) {
+        site->control->state_.store(SiteSwitch::Off, std::memory_order_relaxed);
+    }
+}
+
+std::vector<const LogSite*> SiteRegistry::sites() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    return reg.sites;
+}
+
+std::vector<const LogSite*> SiteRegistry::enabled_sites() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    std::vector<const LogSite*> out;
+    for (const LogSite* site : reg.sites) {
+        if (site->control->state_.load(std::memory_order_relaxed) == SiteSwitch::On) {
+            out.push_back(site);
+        }
+    }
+    return out;
+}
+
+std::string SiteControlResponse::to_json() const {
+    std::ostringstream oss;
+    oss << "{\n";
+    oss << "  \"success\": " << (success ? "true" : "false") << ",\n";
+    oss << "  \"message\": \"" << message << "\",\n";
+    oss << "  \"matched_sites\": " << matched_sites << "\n";
+    oss << "}";
+    return oss.str();
+}
+
+SiteControlResponse handle_site_enable_request(const std::string& file_glob,
+                                               const std::string& function_glob,
+                                               bool enable) {
+    SiteControlResponse response;
+    response.matched_sites = 0;
+
+    if (file_glob.empty() || function_glob.empty()) {
+        response.success = false;
+        response.message = "File and function patterns must not be empty";
+        return response;
+    }
+
+    response.matched_sites = enable ? SiteRegistry::enable(file_glob, function_glob)
+                                    : SiteRegistry::disable(file_glob, function_glob);
+    response.success = true;
+    response.message = std::string(enable ? "Enabled " : "Disabled ") +
+                       std::to_string(response.matched_sites) + " call sites";
+    return response;
+}
+
+}
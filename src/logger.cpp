@@ -1,9 +1,19 @@
 #include "Zyrnix/logger.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/child_logger.hpp"
 #include "Zyrnix/log_sink.hpp"
 #include "Zyrnix/log_filter.hpp"
 #include "Zyrnix/sinks/stdout_sink.hpp"
 #include "Zyrnix/async/async_logger.hpp"
+#include "Zyrnix/async/async_queue.hpp"
 #include "Zyrnix/log_health.hpp"
+#include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/cycle_clock.hpp"
+#include "Zyrnix/tracepoints.hpp"
+#include "Zyrnix/log_context.hpp"
+#include "Zyrnix/deferred.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include "Zyrnix/rate_limiter.hpp"
 #include <mutex>
 #include <shared_mutex>
 #include <chrono>
@@ -11,41 +21,228 @@
 #include <algorithm>
 #include <cctype>
 #include <thread>
-#include <regex>
 
 namespace Zyrnix {
 
+namespace {
+
+// Set while a CallTimer is timing this thread's call, so fan_out() times
+// the sinks for the same sampled calls
+thread_local bool timing_call = false;
+
+// Times the Logger call it lives in, when the logger's metrics sample it
+class CallTimer {
+public:
+    explicit CallTimer(LogMetrics* metrics) : metrics_(metrics && metrics->sample_timing() ? metrics : nullptr) {
+        if (metrics_) {
+            timing_call = true;
+            start_ = CycleClock::now();
+        }
+    }
+
+    ~CallTimer() {
+        if (metrics_) {
+            metrics_->record_log_call_ns(CycleClock::to_ns(CycleClock::now() - start_));
+            timing_call = false;
+        }
+    }
+
+    CallTimer(const CallTimer&) = delete;
+    CallTimer& operator=(const CallTimer&) = delete;
+
+private:
+    LogMetrics* metrics_;
+    uint64_t start_ = 0;
+};
+
+// Start of a stage of a sampled call, 0 when the call is not timed
+uint64_t stage_start(bool timed) {
+    return timed ? CycleClock::now() : 0;
+}
+
+uint64_t elapsed_ns(uint64_t start) {
+    return start ? CycleClock::to_ns(CycleClock::now() - start) : 0;
+}
+
+void end_stage(LogMetrics* metrics, PipelineStage stage, uint64_t start) {
+    if (start) {
+        metrics->record_stage_ns(stage, elapsed_ns(start));
+    }
+}
+
+// Fires log__entry now and log__return when the call ends, timing the
+// call only while a tracer is attached to log__return
+class CallProbe {
+public:
+    CallProbe(std::string_view logger, LogLevel level, size_t bytes)
+        : logger_(logger.data()), level_(static_cast<int>(level)),
+          start_(stage_start(XLOG_PROBE_ENABLED(log__return))) {
+        XLOG_PROBE(log__entry, logger_, level_, bytes);
+    }
+
+    ~CallProbe() {
+        XLOG_PROBE_GUARDED(log__return, logger_, level_, elapsed_ns(start_));
+    }
+
+    CallProbe(const CallProbe&) = delete;
+    CallProbe& operator=(const CallProbe&) = delete;
+
+private:
+    const char* logger_;  // Logger and child names are NUL-terminated strings
+    int level_;
+    uint64_t start_;
+};
+
+// dispatch_batch()'s render caches and views, kept per thread from batch
+// to batch. A batch dispatched while the thread's are lent out, from a
+// sink that drains another logger, gets buffers of its own.
+class BatchBuffers {
+public:
+    BatchBuffers() : nested_(lent_) {
+        lent_ = true;
+        if (!nested_) {
+            plain_.clear();
+        }
+    }
+
+    ~BatchBuffers() {
+        if (!nested_) {
+            lent_ = false;
+        }
+    }
+
+    BatchBuffers(const BatchBuffers&) = delete;
+    BatchBuffers& operator=(const BatchBuffers&) = delete;
+
+    std::vector<RenderCache>& caches() { return nested_ ? own_caches_ : caches_; }
+    std::vector<FormattedRecord>& plain() { return nested_ ? own_plain_ : plain_; }
+
+private:
+    static thread_local std::vector<RenderCache> caches_;
+    static thread_local std::vector<FormattedRecord> plain_;
+    static thread_local bool lent_;
+
+    bool nested_;
+    std::vector<RenderCache> own_caches_;
+    std::vector<FormattedRecord> own_plain_;
+};
+
+thread_local std::vector<RenderCache> BatchBuffers::caches_;
+thread_local std::vector<FormattedRecord> BatchBuffers::plain_;
+thread_local bool BatchBuffers::lent_ = false;
+
+// The record may be filtered and written on another thread, which has its
+// own LogContext, so take the caller's context fields now
+void capture_context(LogRecord& record) {
+    record.trace = TraceContext::current();
+#ifndef XLOG_NO_CONTEXT
+    for (const auto& [key, value] : LogContext::current()) {
+        record.fields.emplace(key, value);
+    }
+#else
+    (void)record;
+#endif
+}
+
+#ifndef XLOG_NO_FILTERS
+// Filters [0, tracked) have their stage-one result recorded in pending;
+// any beyond that, and the filter function, always go to stage two
+constexpr size_t tracked_filters = 64;
+
+struct FilterPass {
+    FilterVerdict verdict;
+    uint64_t pending;  // Bit i: filter i was Undecided
+};
+
+FilterPass run_prefilters(const FilterChain& chain, const RecordView& view) {
+    FilterPass pass{FilterVerdict::Accept, 0};
+    const size_t tracked = std::min(chain.filters.size(), tracked_filters);
+    for (size_t i = 0; i < tracked; ++i) {
+        switch (chain.filters[i]->prefilter(view)) {
+            case FilterVerdict::Reject: return FilterPass{FilterVerdict::Reject, 0};
+            case FilterVerdict::Undecided: pass.pending |= uint64_t{1} << i; break;
+            case FilterVerdict::Accept: break;
+        }
+    }
+    if (pass.pending != 0 || chain.func || chain.filters.size() > tracked) {
+        pass.verdict = FilterVerdict::Undecided;
+    }
+    return pass;
+}
+
+bool finish_filters(const FilterChain& chain, const FilterPass& pass, const LogRecord& record) {
+    for (size_t i = 0; i < chain.filters.size(); ++i) {
+        const bool pending = i >= tracked_filters || (pass.pending & (uint64_t{1} << i)) != 0;
+        if (pending && !chain.filters[i]->should_log(record)) {
+            return false;
+        }
+    }
+    return !chain.func || chain.func(record);
+}
+#endif
+
+}
+
 void Logger::set_redact_patterns(const std::vector<std::string>& patterns) {
     std::lock_guard<std::mutex> lock(mtx_);
     redact_patterns_ = patterns;
+    rebuild_redactor();
 }
 
 void Logger::clear_redact_patterns() {
     std::lock_guard<std::mutex> lock(mtx_);
     redact_patterns_.clear();
+    rebuild_redactor();
 }
 
 void Logger::set_redact_regex_patterns(const std::vector<std::string>& patterns) {
     std::lock_guard<std::mutex> lock(mtx_);
     redact_regex_patterns_ = patterns;
+    rebuild_redactor();
 }
 
 void Logger::set_redact_pii_presets(const std::vector<std::string>& presets) {
     std::lock_guard<std::mutex> lock(mtx_);
     redact_pii_presets_ = presets;
+    rebuild_redactor();
 }
 
 void Logger::set_redact_apply_to_cloud_only(bool cloud_only) {
     std::lock_guard<std::mutex> lock(mtx_);
     redact_cloud_only_ = cloud_only;
+    rebuild_redactor();
+}
+
+// Caller holds mtx_. Compiles the patterns once; dispatch only loads the
+// published Redactor.
+void Logger::rebuild_redactor() {
+    auto redactor = std::make_unique<Redactor>(redact_patterns_, redact_regex_patterns_,
+                                               redact_pii_presets_, redact_cloud_only_);
+    if (!redactor->active()) {
+        redactor.reset();
+    }
+    redactor_.publish(std::move(redactor));
 }
 
 Logger::Logger(std::string n) 
-    : name(std::move(n)), min_level_(LogLevel::Trace) {
+    : name(std::move(n)), sinks_(std::make_unique<SinkSnapshot>())
+#ifndef XLOG_NO_FILTERS
+      , filters_(std::make_unique<FilterChain>())
+#endif
+{
     temp_level_.active = false;
+#ifndef XLOG_NO_METRICS
+    metrics_ = MetricsRegistry::instance().get_logger_metrics(name);
+#endif
 }
 
 Logger::~Logger() {
+#ifndef XLOG_NO_ASYNC
+    stop_async();
+#endif
+#ifndef XLOG_NO_RATE_LIMITING
+    flush_repeats();
+#endif
     clear_sinks();
 }
 
@@ -54,129 +251,191 @@ void Logger::add_sink(LogSinkPtr sink) {
 }
 
 void Logger::add_sink(LogSinkPtr sink, const std::string& sink_name) {
-    std::unique_lock<std::shared_mutex> lock(sinks_mtx_);
+    std::lock_guard<std::mutex> lock(sinks_mtx_);
     sink_entries_.push_back(std::make_shared<SinkEntry>(std::move(sink), sink_name));
+    publish_sinks();
 }
 
-void Logger::clear_sinks() {
-    std::unique_lock<std::shared_mutex> lock(sinks_mtx_);
-    
-    for (auto& entry : sink_entries_) {
-        entry->marked_for_removal.store(true, std::memory_order_release);
+#ifndef XLOG_NO_ASYNC
+void Logger::add_sink(LogSinkPtr sink, const std::string& sink_name, const SinkOptions& options) {
+    if (options.dedicated_worker && sink) {
+        std::string metrics_name = sink_name.empty() ? name + ".sink" : sink_name;
+        sink = std::make_shared<IsolatedSink>(std::move(sink), metrics_name, options);
     }
-    
-    for (auto& entry : sink_entries_) {
-        wait_for_sink_drain(entry);
+    add_sink(std::move(sink), sink_name);
+}
+#endif
+
+void Logger::clear_sinks() {
+    uint64_t grace_epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(sinks_mtx_);
+        sink_entries_.clear();
+        grace_epoch = publish_sinks();
     }
-    
-    sink_entries_.clear();
-    
-    std::lock_guard<std::mutex> mtx_lock(mtx_);
-    sink_level_overrides_.clear();
-    sink_level_overrides_by_name_.clear();
+    wait_for_sink_drain(grace_epoch);
 }
 
 bool Logger::remove_sink(const std::string& sink_name, bool wait_for_completion) {
-    SinkEntryPtr entry_to_remove;
-    
+    uint64_t grace_epoch = 0;
     {
-        std::unique_lock<std::shared_mutex> lock(sinks_mtx_);
+        std::lock_guard<std::mutex> lock(sinks_mtx_);
         
         auto it = std::find_if(sink_entries_.begin(), sink_entries_.end(),
             [&sink_name](const SinkEntryPtr& entry) {
-                return entry->name == sink_name && !entry->marked_for_removal;
+                return entry->name == sink_name;
             });
         
         if (it == sink_entries_.end()) {
             return false;
         }
         
-        entry_to_remove = *it;
-        entry_to_remove->marked_for_removal.store(true, std::memory_order_release);
+        sink_entries_.erase(it);
+        grace_epoch = publish_sinks();
     }
     
     if (wait_for_completion) {
-        wait_for_sink_drain(entry_to_remove);
+        wait_for_sink_drain(grace_epoch);
     }
-    
+    return true;
+}
+
+bool Logger::replace_sink(const std::string& sink_name, LogSinkPtr sink) {
+    uint64_t grace_epoch = 0;
+    LogSinkPtr old;
     {
-        std::unique_lock<std::shared_mutex> lock(sinks_mtx_);
-        sink_entries_.erase(
-            std::remove_if(sink_entries_.begin(), sink_entries_.end(),
-                [&sink_name](const SinkEntryPtr& entry) {
-                    return entry->name == sink_name && entry->marked_for_removal;
-                }),
-            sink_entries_.end()
-        );
+        std::lock_guard<std::mutex> lock(sinks_mtx_);
+        auto it = std::find_if(sink_entries_.begin(), sink_entries_.end(),
+            [&sink_name](const SinkEntryPtr& entry) {
+                return entry->name == sink_name;
+            });
+        if (it == sink_entries_.end()) {
+            return false;
+        }
+        // A new entry: snapshots still in use keep the old one
+        auto entry = std::make_shared<SinkEntry>(std::move(sink), sink_name);
+        entry->level_override = (*it)->level_override;
+        old = (*it)->sink;  // Snapshots being read still hold the entry
+        *it = std::move(entry);
+        grace_epoch = publish_sinks();
+    }
+    wait_for_sink_drain(grace_epoch);
+    // Whatever the old sink still buffers goes out before it is dropped
+    if (old) {
+        old->flush();
     }
-    
     return true;
 }
 
 bool Logger::remove_sink(size_t index, bool wait_for_completion) {
-    SinkEntryPtr entry_to_remove;
-    
+    uint64_t grace_epoch = 0;
     {
-        std::unique_lock<std::shared_mutex> lock(sinks_mtx_);
+        std::lock_guard<std::mutex> lock(sinks_mtx_);
         
         if (index >= sink_entries_.size()) {
             return false;
         }
         
-        entry_to_remove = sink_entries_[index];
-        entry_to_remove->marked_for_removal.store(true, std::memory_order_release);
+        sink_entries_.erase(sink_entries_.begin() + static_cast<std::ptrdiff_t>(index));
+        grace_epoch = publish_sinks();
     }
     
     if (wait_for_completion) {
-        wait_for_sink_drain(entry_to_remove);
-    }
-    
- 
-    {
-        std::unique_lock<std::shared_mutex> lock(sinks_mtx_);
-        cleanup_removed_sinks();
+        wait_for_sink_drain(grace_epoch);
     }
-    
     return true;
 }
 
 size_t Logger::sink_count() const {
-    std::shared_lock<std::shared_mutex> lock(sinks_mtx_);
-    return std::count_if(sink_entries_.begin(), sink_entries_.end(),
-        [](const SinkEntryPtr& entry) {
-            return !entry->marked_for_removal;
-        });
+    EpochDomain::ReadGuard read;
+    return sinks_.load()->entries.size();
 }
 
-void Logger::wait_for_sink_drain(SinkEntryPtr& entry) {
+// Caller holds sinks_mtx_
+uint64_t Logger::publish_sinks() {
+#ifndef XLOG_NO_METRICS
+    // New entries are not visible to readers yet. Isolated sinks count
+    // their writes on their own worker.
+    for (size_t i = 0; i < sink_entries_.size(); ++i) {
+        SinkEntry& entry = *sink_entries_[i];
+        if (entry.metrics || !entry.sink || dynamic_cast<IsolatedSink*>(entry.sink.get())) {
+            continue;
+        }
+        entry.metrics = MetricsRegistry::instance().get_sink_metrics(
+            name + "." + (entry.name.empty() ? "sink" + std::to_string(i) : entry.name));
+    }
+#endif
+    auto snapshot = std::make_unique<SinkSnapshot>();
+    snapshot->entries = sink_entries_;
+    const uint64_t epoch = sinks_.publish(std::move(snapshot));
+    watch_sinks();
+    update_sink_floor();
+    return epoch;
+}
 
-    constexpr int max_wait_ms = 5000;
-    constexpr int sleep_interval_ms = 1;
-    int waited_ms = 0;
-    
-    while (entry->ref_count.load(std::memory_order_acquire) > 0 && waited_ms < max_wait_ms) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_interval_ms));
-        waited_ms += sleep_interval_ms;
+// Caller holds sinks_mtx_. Re-reads each sink's own level as well, so it
+// also picks up LogSink::set_level() calls made since the last change.
+void Logger::update_sink_floor() {
+    // Cleared first: a set_level() racing the loop below sets it again,
+    // and then the floor it lowered is left for the next record to redo
+    update_levels(floor_stale_bit, 0);
+    // With no sinks nothing is rejected early, so the floor stays at Trace
+    LogLevel floor = sink_entries_.empty() ? LogLevel::Trace : LogLevel::Critical;
+    for (const auto& entry : sink_entries_) {
+        LogLevel level = entry->level_override;
+        if (entry->sink) {
+            level = std::max(level, entry->sink->get_level());
+        }
+        entry->min_level.store(level, std::memory_order_relaxed);
+        floor = std::min(floor, level);
+    }
+    uint32_t word = levels_.load(std::memory_order_relaxed);
+    while (!(word & floor_stale_bit) &&
+           !levels_.compare_exchange_weak(word, (word & ~(level_mask << floor_shift)) |
+                                                    (static_cast<uint32_t>(floor) << floor_shift),
+                                          std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    }
+}
+
+// Caller holds sinks_mtx_. Registers floor_watcher_ once with each sink
+// it does not watch yet and drops the sinks no entry holds any more
+void Logger::watch_sinks() {
+    auto held = [this](const LogSinkPtr& sink) {
+        return std::any_of(sink_entries_.begin(), sink_entries_.end(),
+                           [&](const SinkEntryPtr& entry) { return entry->sink == sink; });
+    };
+    for (auto it = watched_sinks_.begin(); it != watched_sinks_.end();) {
+        if (held(*it)) {
+            ++it;
+        } else {
+            (*it)->remove_level_watcher(&floor_watcher_);
+            it = watched_sinks_.erase(it);
+        }
+    }
+    for (const auto& entry : sink_entries_) {
+        if (entry->sink &&
+            std::find(watched_sinks_.begin(), watched_sinks_.end(), entry->sink) == watched_sinks_.end()) {
+            entry->sink->add_level_watcher(&floor_watcher_);
+            watched_sinks_.push_back(entry->sink);
+        }
     }
 }
 
-void Logger::cleanup_removed_sinks() {
-    sink_entries_.erase(
-        std::remove_if(sink_entries_.begin(), sink_entries_.end(),
-            [](const SinkEntryPtr& entry) {
-                return entry->marked_for_removal && 
-                       entry->ref_count.load(std::memory_order_acquire) == 0;
-            }),
-        sink_entries_.end()
-    );
+void Logger::refresh_sink_floor() {
+    std::lock_guard<std::mutex> lock(sinks_mtx_);
+    update_sink_floor();
 }
 
-void Logger::set_level(LogLevel level) {
-    min_level_.store(level, std::memory_order_relaxed);
+// Waits for the grace period of a publish, then frees the snapshots it
+// retired, so a removed sink is no longer referenced by the logger.
+void Logger::wait_for_sink_drain(uint64_t grace_epoch) {
+    EpochDomain::instance().wait_for(grace_epoch);
+    std::lock_guard<std::mutex> lock(sinks_mtx_);
+    sinks_.reclaim();
 }
 
-LogLevel Logger::get_level() const {
-    return min_level_.load(std::memory_order_relaxed);
+void Logger::set_level(LogLevel level) {
+    exchange_min_level(level);
 }
 
 void Logger::set_level_dynamic(LogLevel level) {
@@ -186,7 +445,7 @@ void Logger::set_level_dynamic(LogLevel level) {
 void Logger::set_level_dynamic(LogLevel level, const std::string& reason) {
     check_temporary_level_expiry();
     
-    LogLevel old_level = min_level_.exchange(level, std::memory_order_release);
+    LogLevel old_level = exchange_min_level(level);
     
     if (old_level != level) {
         std::lock_guard<std::mutex> lock(mtx_);
@@ -209,22 +468,30 @@ void Logger::clear_level_change_callbacks() {
 }
 
 void Logger::set_sink_level(size_t sink_index, LogLevel level) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    std::shared_lock<std::shared_mutex> sinks_lock(sinks_mtx_);
-    if (sink_index < sink_entries_.size()) {
-        sink_level_overrides_[sink_index] = level;
+    std::lock_guard<std::mutex> sinks_lock(sinks_mtx_);
+    if (sink_index >= sink_entries_.size()) {
+        return;
     }
+    sink_entries_[sink_index]->level_override = level;
+    update_sink_floor();
 }
 
 void Logger::set_sink_level(const std::string& sink_name, LogLevel level) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    sink_level_overrides_by_name_[sink_name] = level;
+    std::lock_guard<std::mutex> sinks_lock(sinks_mtx_);
+    for (const auto& entry : sink_entries_) {
+        if (entry->name == sink_name) {
+            entry->level_override = level;
+        }
+    }
+    update_sink_floor();
 }
 
 void Logger::clear_sink_level_overrides() {
-    std::lock_guard<std::mutex> lock(mtx_);
-    sink_level_overrides_.clear();
-    sink_level_overrides_by_name_.clear();
+    std::lock_guard<std::mutex> sinks_lock(sinks_mtx_);
+    for (const auto& entry : sink_entries_) {
+        entry->level_override = LogLevel::Trace;
+    }
+    update_sink_floor();
 }
 
 void Logger::record_level_change(LogLevel old_level, LogLevel new_level, const std::string& reason) {
@@ -274,13 +541,17 @@ void Logger::set_level_temporary(LogLevel level, std::chrono::seconds duration,
     std::lock_guard<std::mutex> lock(mtx_);
     
     if (!temp_level_.active) {
-        temp_level_.original_level = min_level_.load(std::memory_order_acquire);
+        temp_level_.original_level = min_level(std::memory_order_acquire);
     }
     
     temp_level_.revert_time = std::chrono::system_clock::now() + duration;
+    temp_level_.revert_deadline = std::chrono::steady_clock::now() + duration;
     temp_level_.active = true;
+    temp_level_deadline_.store(temp_level_.revert_deadline.time_since_epoch().count(),
+                               std::memory_order_release);
     
-    LogLevel old_level = min_level_.exchange(level, std::memory_order_release);
+    LogLevel old_level = min_level_of(update_levels(level_mask | temp_level_bit,
+                                                    static_cast<uint32_t>(level) | temp_level_bit));
     
     std::string full_reason = reason.empty() ? 
         "Temporary level change for " + std::to_string(duration.count()) + "s" :
@@ -297,11 +568,12 @@ void Logger::cancel_temporary_level() {
     std::lock_guard<std::mutex> lock(mtx_);
     
     if (temp_level_.active) {
-        LogLevel current = min_level_.load(std::memory_order_acquire);
+        LogLevel current = min_level(std::memory_order_acquire);
         LogLevel original = temp_level_.original_level;
         
-        min_level_.store(original, std::memory_order_release);
+        update_levels(level_mask | temp_level_bit, static_cast<uint32_t>(original));
         temp_level_.active = false;
+        temp_level_deadline_.store(0, std::memory_order_release);
         
         record_level_change(current, original, "Temporary level cancelled");
         
@@ -331,159 +603,962 @@ std::chrono::seconds Logger::remaining_temporary_duration() const {
     return std::chrono::duration_cast<std::chrono::seconds>(temp_level_.revert_time - now);
 }
 
+bool Logger::temporary_level_due() const {
+    const auto deadline = std::chrono::steady_clock::duration(temp_level_deadline_.load(std::memory_order_relaxed));
+    return monotonic_coarse_ns() >= static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(deadline).count());
+}
+
 void Logger::check_temporary_level_expiry() {
+    int64_t deadline = temp_level_deadline_.load(std::memory_order_relaxed);
+    if (deadline == 0) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now.time_since_epoch().count() < deadline) {
+        return;
+    }
+    // Only the thread that clears the deadline reverts the level
+    if (!temp_level_deadline_.compare_exchange_strong(deadline, 0, std::memory_order_acq_rel)) {
+        return;
+    }
+
     std::lock_guard<std::mutex> lock(mtx_);
+    // A new set_level_temporary() may have re-armed it before we got the lock
+    if (!temp_level_.active || now < temp_level_.revert_deadline) {
+        return;
+    }
+
+    LogLevel current = min_level(std::memory_order_acquire);
+    LogLevel original = temp_level_.original_level;
     
-    if (temp_level_.active) {
-        auto now = std::chrono::system_clock::now();
-        if (now >= temp_level_.revert_time) {
-            LogLevel current = min_level_.load(std::memory_order_acquire);
-            LogLevel original = temp_level_.original_level;
-            
-            min_level_.store(original, std::memory_order_release);
-            temp_level_.active = false;
-            
-            record_level_change(current, original, "Temporary level expired");
-            
-            for (const auto& callback : level_change_callbacks_) {
-                callback(current, original);
-            }
-        }
+    update_levels(level_mask | temp_level_bit, static_cast<uint32_t>(original));
+    temp_level_.active = false;
+    
+    record_level_change(current, original, "Temporary level expired");
+    
+    for (const auto& callback : level_change_callbacks_) {
+        callback(current, original);
     }
 }
 
+#ifndef XLOG_NO_FILTERS
+// Caller holds mtx_
+void Logger::publish_filters(std::unique_ptr<FilterChain> chain) {
+    const bool any = !chain->empty();
+    filters_.publish(std::move(chain));
+    has_filters_.store(any, std::memory_order_release);
+}
+
 void Logger::add_filter(std::shared_ptr<LogFilter> filter) {
     std::lock_guard<std::mutex> lock(mtx_);
-    filters_.push_back(std::move(filter));
+    auto chain = std::make_unique<FilterChain>(*filters_.load());
+    chain->filters.push_back(std::move(filter));
+    publish_filters(std::move(chain));
+}
+
+void Logger::set_filters(std::vector<std::shared_ptr<LogFilter>> filters) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto chain = std::make_unique<FilterChain>(*filters_.load());
+    chain->filters = std::move(filters);
+    publish_filters(std::move(chain));
 }
 
 void Logger::clear_filters() {
     std::lock_guard<std::mutex> lock(mtx_);
-    filters_.clear();
-    filter_func_ = nullptr;
+    publish_filters(std::make_unique<FilterChain>());
 }
 
 void Logger::set_filter_func(std::function<bool(const LogRecord&)> func) {
     std::lock_guard<std::mutex> lock(mtx_);
-    filter_func_ = std::move(func);
+    auto chain = std::make_unique<FilterChain>(*filters_.load());
+    chain->func = std::move(func);
+    publish_filters(std::move(chain));
 }
+#endif
 
+// Caller is inside an EpochDomain::ReadGuard
 bool Logger::should_log(const LogRecord& record) const {
-    if (record.level < min_level_.load(std::memory_order_acquire)) {
+    if (record.level < min_level(std::memory_order_acquire) && !record.backtrace && !record.child_level &&
+        !(record.site && record.site->forced())) {
         return false;
     }
-    
-    if (filter_func_ && !filter_func_(record)) {
-        return false;
+
+#ifndef XLOG_NO_FILTERS
+    const FilterChain* chain = filters_.load();
+    if (chain->empty()) {
+        return true;
     }
-    
-    for (const auto& filter : filters_) {
-        if (!filter->should_log(record)) {
-            return false;
-        }
+    const FilterPass pass = run_prefilters(*chain, RecordView(record));
+    if (pass.verdict != FilterVerdict::Undecided) {
+        return pass.verdict == FilterVerdict::Accept;
     }
-    
+    return finish_filters(*chain, pass, record);
+#else
     return true;
+#endif
+}
+
+void Logger::log(LogLevel level, std::string_view message) {
+    log_at(level, message, nullptr);
+}
+
+void Logger::log(const LogSite& site, std::string_view message) {
+    log_at(site.level, message, &site);
+}
+
+void Logger::log_limited(const LogSite& site, uint64_t suppressed, std::string_view message) {
+    record_suppressed(suppressed);
+    if (suppressed == 0) {
+        log_at(site.level, message, &site);
+        return;
+    }
+    std::string line(message);
+    line += " [" + std::to_string(suppressed) + " suppressed]";
+    log_at(site.level, line, &site);
+}
+
+LogStatus Logger::try_log(LogLevel level, std::string_view message) {
+    return log_at(level, message, nullptr, false);
+}
+
+LogStatus Logger::try_log(const LogSite& site, std::string_view message) {
+    return log_at(site.level, message, &site, false);
+}
+
+void Logger::record_suppressed(uint64_t count) {
+    if (count > 0 && metrics_) {
+        metrics_->record_message_filtered(count);
+    }
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
+LogStatus Logger::log_at(LogLevel level, std::string_view message, const LogSite* site, bool may_block) {
+    settle_sink_floor();
+    if (!sinks_accept(level)) {
+        return LogStatus::Filtered;
+    }
     check_temporary_level_expiry();
-    
+
+    if (level < min_level(std::memory_order_acquire) && !(site && site->forced())) {
+        if (backtrace_on()) {
+            capture_backtrace(level, message, site, nullptr);
+        }
+        return LogStatus::Filtered;
+    }
+    maybe_dump_backtrace(level);
+    return emit(level, message, site, nullptr, may_block);
+}
+
+// Past the level checks, this logger's or those of child
+LogStatus Logger::emit(LogLevel level, std::string_view message, const LogSite* site, const ChildLogger* child,
+                       bool may_block) {
+#ifndef XLOG_NO_RATE_LIMITING
+    if (over_rate_limit()) {
+        return LogStatus::RateLimited;
+    }
+#endif
+    const std::string_view logger_name = child ? child->name() : std::string_view(name);
+    CallProbe probe(logger_name, level, message.size());
+    CallTimer timer(metrics_.get());
+    if (metrics_) {
+        metrics_->record_message_logged();
+    }
+    std::shared_ptr<StackTrace> stack = capture_stack(level);
+#ifndef XLOG_NO_ASYNC
+    if (async_queue_ && sync_critical_ && level == LogLevel::Critical) {
+        // Everything queued before this line reaches the sinks first
+        fence_async(fence_timeout_);
+        LogRecord record;
+        record.logger_name = logger_name;
+        record.level = level;
+        record.message = message;
+        record.timestamp = LogClock::now();
+        record.thread_id = current_thread_id();
+        record.site = site;
+        record.child_level = child != nullptr;
+        record.trace = TraceContext::current();
+        record.stack = std::move(stack);
+        dispatch(record);
+        return LogStatus::Accepted;
+    }
+
+    if (async_queue_) {
+        LogRecord record;
+        if (record_pool_ && !record_pool_->acquire(record) && metrics_) {
+            metrics_->record_pool_miss();
+        }
+        // assign() reuses the capacity of a recycled record
+        record.logger_name.assign(logger_name);
+        record.level = level;
+        record.message.assign(message);
+        record.timestamp = LogClock::now();
+        record.thread_id = current_thread_id();
+        record.site = site;
+        record.child_level = child != nullptr;
+        record.stack = std::move(stack);
+        capture_context(record);
+        return enqueue_async(std::move(record), may_block) ? LogStatus::Accepted : LogStatus::DroppedFull;
+    }
+#endif
+
+    auto dispatch_view = [&] {
+        // The caller's text goes to the sinks as a view without being
+        // copied into a record
+        ScopedRenderCache cache;
+        dispatch(FormattedRecord(logger_name, level, message, LogClock::now(), cache, site, stack.get()));
+    };
+
+    if (!has_filters_.load(std::memory_order_acquire)) {
+        dispatch_view();
+        return LogStatus::Accepted;
+    }
+
+#ifndef XLOG_NO_FILTERS
+    // Stage one runs on the caller's strings; a record is only built if
+    // a filter needs one
+    EpochDomain::ReadGuard read;
+    const FilterChain* chain = filters_.load();
+    // A record built for the second stage is filter work too, so it is
+    // timed with the filters
+    const uint64_t filter_start = stage_start(timing_call);
+    const FilterPass pass = run_prefilters(*chain, RecordView(logger_name, level, message, site));
+    if (pass.verdict == FilterVerdict::Reject) {
+        end_stage(metrics_.get(), PipelineStage::Filter, filter_start);
+        XLOG_PROBE(filter__drop, logger_name.data(), static_cast<int>(level), message.size());
+        if (metrics_) {
+            metrics_->record_message_filtered();
+        }
+        return LogStatus::Filtered;
+    }
+    if (pass.verdict == FilterVerdict::Accept) {
+        end_stage(metrics_.get(), PipelineStage::Filter, filter_start);
+        dispatch_view();
+        return LogStatus::Accepted;
+    }
+
     LogRecord record;
-    record.logger_name = name;
+    record.logger_name = logger_name;
     record.level = level;
-    
-    // Copy redaction configuration under lock
-    std::vector<std::string> substr_patterns;
-    std::vector<std::string> regex_patterns;
-    std::vector<std::string> pii_presets;
-    bool redact_cloud_only = false;
+    record.message = message;
+    record.timestamp = LogClock::now();
+    record.thread_id = current_thread_id();
+    record.site = site;
+    record.child_level = child != nullptr;
+    record.stack = std::move(stack);
+    capture_context(record);
+    const bool accepted = finish_filters(*chain, pass, record);
+    end_stage(metrics_.get(), PipelineStage::Filter, filter_start);
+    if (!accepted) {
+        XLOG_PROBE(filter__drop, logger_name.data(), static_cast<int>(level), message.size());
+        if (metrics_) {
+            metrics_->record_message_filtered();
+        }
+        return LogStatus::Filtered;
+    }
+
+    ScopedRenderCache cache;
+    dispatch(FormattedRecord(record, cache));
+#endif
+    return LogStatus::Accepted;
+}
+
+// Typed fields always need a record; past the level checks it takes
+// the same road as a record built for filters
+void Logger::log_fields(LogLevel level, std::string_view message, std::span<Field> fields) {
+    settle_sink_floor();
+    if (!sinks_accept(level)) {
+        return;
+    }
+    check_temporary_level_expiry();
+    if (level < min_level(std::memory_order_acquire)) {
+        if (backtrace_on()) {
+            capture_backtrace(level, message, nullptr, nullptr);
+        }
+        return;
+    }
+    maybe_dump_backtrace(level);
+    emit_fields(level, message, fields, nullptr);
+}
+
+void Logger::emit_fields(LogLevel level, std::string_view message, std::span<Field> fields,
+                         const ChildLogger* child) {
+#ifndef XLOG_NO_RATE_LIMITING
+    if (over_rate_limit()) {
+        return;
+    }
+#endif
+    CallProbe probe(child ? child->name() : std::string_view(name), level, message.size());
+    CallTimer timer(metrics_.get());
+    if (metrics_) {
+        metrics_->record_message_logged();
+    }
+    LogRecord record;
+#ifndef XLOG_NO_ASYNC
+    const bool queued = async_queue_ && !(sync_critical_ && level == LogLevel::Critical);
+    if (queued && record_pool_ && !record_pool_->acquire(record) && metrics_) {
+        metrics_->record_pool_miss();
+    }
+#endif
+    record.logger_name.assign(child ? child->name() : std::string_view(name));
+    record.level = level;
+    record.message.assign(message);
+    record.timestamp = LogClock::now();
+    record.thread_id = current_thread_id();
+    record.child_level = child != nullptr;
+    record.trace = TraceContext::current();
+    record.stack = capture_stack(level);
+    for (auto& field : fields) {
+        record.fields.insert_or_assign(field.key, std::move(field.value));
+    }
+
+#ifndef XLOG_NO_ASYNC
+    if (queued) {
+        capture_context(record);  // Does not replace the fields above
+        enqueue_async(std::move(record));
+        return;
+    }
+    if (async_queue_) {
+        fence_async(fence_timeout_);  // A critical line in sync_critical mode
+    }
+#endif
+    dispatch(record);
+}
+
+size_t Logger::log_batch(std::span<LogRecord> records) {
+    settle_sink_floor();
+    check_temporary_level_expiry();
+    const uint32_t levels = levels_.load(std::memory_order_acquire);
+    const LogLevel min_level = min_level_of(levels);
+    const bool backtrace_on = (levels & backtrace_bit) != 0;
+
+    // Records past the level checks are moved up over those that are not
+    size_t kept = 0;
+    LogLevel highest = LogLevel::Trace;
+    for (auto& record : records) {
+        if (!sinks_accept(record.level)) {
+            continue;
+        }
+        if (record.level < min_level && !(record.site && record.site->forced())) {
+            if (backtrace_on) {
+                capture_backtrace(record.level, record.message, record.site, nullptr);
+            }
+            continue;
+        }
+        highest = std::max(highest, record.level);
+        if (&record != &records[kept]) {
+            records[kept] = std::move(record);
+        }
+        ++kept;
+    }
+    if (kept == 0) {
+        return 0;
+    }
+    maybe_dump_backtrace(highest);
+#ifndef XLOG_NO_RATE_LIMITING
+    if (rate_limit_on_.load(std::memory_order_relaxed)) {
+        kept = rate_limited_batch(kept);
+    }
+#endif
+    records = records.first(kept);
+    if (metrics_) {
+        metrics_->record_message_logged(kept);
+    }
+
+    // The calling thread's defaults, looked up once for the batch; the
+    // records share one stack, since they were all logged from here
+    const auto now = LogClock::now();
+    const uint64_t thread_id = current_thread_id();
+    const TraceContext& trace = TraceContext::current();
+    const std::shared_ptr<StackTrace> stack = capture_stack(highest);
+#ifndef XLOG_NO_CONTEXT
+    const auto& context = LogContext::current();
+#endif
+    for (auto& record : records) {
+        if (record.logger_name.empty()) {
+            record.logger_name = name;
+        }
+        if (record.timestamp.time_since_epoch().count() == 0) {
+            record.timestamp = now;
+        }
+        if (record.thread_id == 0) {
+            record.thread_id = thread_id;
+        }
+        if (!record.trace.valid()) {
+            record.trace = trace;
+        }
+        if (stack && !record.stack && record.level >= stack_level_.load(std::memory_order_relaxed)) {
+            record.stack = stack;
+        }
+#ifndef XLOG_NO_CONTEXT
+        for (const auto& [key, value] : context) {
+            record.fields.emplace(key, value);
+        }
+#endif
+    }
+
+#ifndef XLOG_NO_ASYNC
+    if (async_queue_) {
+        if (!sync_critical_) {
+            return enqueue_async_batch(records);
+        }
+        // Each critical record is written here, after what was queued
+        // ahead of it, splitting the batch
+        size_t accepted = 0;
+        size_t start = 0;
+        for (size_t k = 0; k < records.size(); ++k) {
+            if (records[k].level != LogLevel::Critical) {
+                continue;
+            }
+            accepted += enqueue_async_batch(records.subspan(start, k - start));
+            fence_async(fence_timeout_);
+            dispatch(records[k]);
+            ++accepted;
+            start = k + 1;
+        }
+        return accepted + enqueue_async_batch(records.subspan(start));
+    }
+#endif
+    return dispatch_batch(records);
+}
 
+void Logger::dispatch(const LogRecord& record) {
     {
-        std::lock_guard<std::mutex> lock(mtx_);
-        if (!should_log(record)) {
+        EpochDomain::ReadGuard read;
+        const uint64_t filter_start = stage_start(timing_call);
+        const bool accepted = should_log(record);
+        end_stage(metrics_.get(), PipelineStage::Filter, filter_start);
+        if (!accepted) {
+            XLOG_PROBE(filter__drop, record.logger_name.c_str(), static_cast<int>(record.level),
+                       record.message.size());
+            if (metrics_) {
+                metrics_->record_message_filtered();
+            }
             return;
         }
-        substr_patterns = redact_patterns_;
-        regex_patterns = redact_regex_patterns_;
-        pii_presets = redact_pii_presets_;
-        redact_cloud_only = redact_cloud_only_;
     }
 
-    // Apply redaction once and reuse for sinks that require it
-    std::string redacted_message = message;
-    bool has_redaction = false;
+    // Every sink gets the same FormattedRecord, so the line is rendered
+    // once per layout rather than once per sink.
+    ScopedRenderCache cache;
+    dispatch(FormattedRecord(record, cache));
+}
 
-    if (!substr_patterns.empty() || !regex_patterns.empty() || !pii_presets.empty()) {
-        if (!substr_patterns.empty()) {
-            redacted_message = Formatter::redact(redacted_message, substr_patterns);
+void Logger::dispatch(const FormattedRecord& plain) {
+#ifndef XLOG_NO_RATE_LIMITING
+    EpochDomain::ReadGuard read;
+    if (const Deduplicator* dedup = dedup_.load()) {
+        // Empty unless a run ended, so this only allocates for a summary
+        std::vector<RepeatSummary> summaries;
+        const bool write = dedup->admit(plain.level(), plain.message(), plain.site(), plain.timestamp(),
+                                        summaries);
+        write_summaries(summaries);
+        if (!write) {
+            return;
         }
+    }
+#endif
+    fan_out(plain);
+}
+
+void Logger::fan_out(const FormattedRecord& plain) {
+    const LogLevel level = plain.level();
 
-        std::vector<std::regex> compiled;
-        compiled.reserve(regex_patterns.size() + pii_presets.size());
+    EpochDomain::ReadGuard read;
+    const Redactor* redactor = redactor_.load();
 
-        for (const auto& pat : regex_patterns) {
-            try {
-                compiled.emplace_back(pat, std::regex::ECMAScript);
-            } catch (...) {
-                // Ignore invalid regex patterns to avoid throwing on log path
+    // Redacted lazily: only once a sink that takes redacted output accepts
+    // this record, then reused for the rest of the fan-out.
+    std::string redacted_message;
+    RenderCache redacted_cache;
+    FormattedRecord redacted = plain;
+    enum { NotYet, Unchanged, Changed } redaction = NotYet;
+
+    const SinkSnapshot* sinks = sinks_.load();
+    for (size_t i = 0; i < sinks->entries.size(); ++i) {
+        const SinkEntry& entry = *sinks->entries[i];
+        if (level < entry.min_level.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        LogSink* sink = entry.sink.get();
+        if (!sink) {
+            continue;
+        }
+        const FormattedRecord* to_log = &plain;
+        if (redactor && redactor->applies_to(sink->is_cloud_sink())) {
+            if (redaction == NotYet) {
+                const uint64_t redact_start = stage_start(timing_call || XLOG_PROBE_ENABLED(redact));
+                redaction = redactor->redact(plain.message(), redacted_message) ? Changed : Unchanged;
+                if (redaction == Changed) {
+                    redacted = FormattedRecord(plain, redacted_message, redacted_cache);
+                }
+                const uint64_t redact_ns = elapsed_ns(redact_start);
+                if (timing_call) {
+                    metrics_->record_stage_ns(PipelineStage::Redact, redact_ns);
+                }
+                XLOG_PROBE_GUARDED(redact, plain.logger_name().data(), plain.message().size(),
+                                   redaction == Changed ? redacted_message.size() : plain.message().size(), redact_ns);
             }
+            if (redaction == Changed) {
+                to_log = &redacted;
+            }
+        }
+        const size_t bytes = to_log->message().size();
+        XLOG_PROBE(sink__write__start, plain.logger_name().data(), entry.name.c_str(), size_t{1}, bytes);
+        SinkMetrics* meter = entry.metrics.get();
+        if (meter) {
+            meter->record_write(bytes);
         }
+        const bool timed = meter && timing_call;
+        const uint64_t start = stage_start(timed || XLOG_PROBE_ENABLED(sink__write__end));
+        if (!timed) {
+            sink->log_record(*to_log);
+        } else {
+            FormatTiming formatting(meter);
+            sink->log_record(*to_log);
+        }
+        const uint64_t write_ns = elapsed_ns(start);
+        if (timed) {
+            meter->record_write_duration_ns(write_ns);
+        }
+        XLOG_PROBE_GUARDED(sink__write__end, plain.logger_name().data(), entry.name.c_str(), size_t{1}, write_ns);
+    }
+}
 
-        // Built-in PII presets (v1.1.3)
-        for (const auto& preset : pii_presets) {
-            std::string lower = preset;
-            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
-            try {
-                if (lower == "email") {
-                    compiled.emplace_back("[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\\.[A-Za-z]{2,}", std::regex::ECMAScript);
-                } else if (lower == "ipv4") {
-                    compiled.emplace_back("(25[0-5]|2[0-4]\\d|[01]?\\d?\\d)(\\.(25[0-5]|2[0-4]\\d|[01]?\\d?\\d)){3}", std::regex::ECMAScript);
-                } else if (lower == "credit_card") {
-                    compiled.emplace_back("\\b(?:\\d[ -]*?){13,16}\\b", std::regex::ECMAScript);
-                } else if (lower == "ssn") {
-                    compiled.emplace_back("\\b\\d{3}-\\d{2}-\\d{4}\\b", std::regex::ECMAScript);
-                }
-            } catch (...) {
-                // Ignore preset compilation failures
+size_t Logger::dispatch_batch(std::span<LogRecord> batch) {
+    // Stages of a sampled batch are timed for the whole batch
+    const bool timed = metrics_ && metrics_->sample_timing();
+    {
+        EpochDomain::ReadGuard read;
+        const size_t queued = batch.size();
+        const uint64_t filter_start = stage_start(timed);
+        // Rejected records are left moved-from past the end of the span
+        batch = batch.first(std::remove_if(batch.begin(), batch.end(), [this](const LogRecord& record) {
+            if (should_log(record)) {
+                return false;
             }
+            XLOG_PROBE(filter__drop, record.logger_name.c_str(), static_cast<int>(record.level),
+                       record.message.size());
+            return true;
+        }) - batch.begin());
+        end_stage(metrics_.get(), PipelineStage::Filter, filter_start);
+        if (metrics_ && batch.size() < queued) {
+            metrics_->record_message_filtered(queued - batch.size());
         }
 
-        for (const auto& rx : compiled) {
-            redacted_message = std::regex_replace(redacted_message, rx, "***");
+#ifndef XLOG_NO_RATE_LIMITING
+        // Summaries go out ahead of the whole batch; their timestamps say
+        // where each run ended
+        if (const Deduplicator* dedup = dedup_.load()) {
+            std::vector<RepeatSummary> summaries;
+            batch = batch.first(std::remove_if(batch.begin(), batch.end(), [&](const LogRecord& record) {
+                return !dedup->admit(record.level, record.message, record.site, record.timestamp, summaries);
+            }) - batch.begin());
+            write_summaries(summaries);
         }
+#endif
+    }
 
-        has_redaction = (redacted_message != message);
+    if (batch.empty()) {
+        return 0;
     }
 
-    std::shared_lock<std::shared_mutex> sinks_lock(sinks_mtx_);
-    for (size_t i = 0; i < sink_entries_.size(); ++i) {
-        auto& entry = sink_entries_[i];
-        if (entry->marked_for_removal.load(std::memory_order_acquire)) {
+    EpochDomain::ReadGuard read;
+    const Redactor* redactor = redactor_.load();
+
+    // One FormattedRecord per record, shared by every sink (and by the
+    // level-filtered views below), so each line renders once per layout.
+    // The caches are this thread's, reset rather than rebuilt, so a worker
+    // that has warmed up renders its lines without allocating.
+    BatchBuffers buffers;
+    std::vector<RenderCache>& caches = buffers.caches();
+    if (caches.size() < batch.size()) {
+        caches.resize(batch.size());
+    }
+    std::vector<FormattedRecord>& plain = buffers.plain();
+    for (size_t k = 0; k < batch.size(); ++k) {
+        caches[k].reset();
+        plain.emplace_back(batch[k], caches[k]);
+    }
+
+    // Redacted lazily, like dispatch(): records are redacted the first time
+    // a sink that takes redacted output accepts them, and the redacted view
+    // is only built once something actually changed. Unchanged records
+    // keep sharing the plain rendering.
+    std::vector<FormattedRecord> redacted;
+    std::vector<std::string> redacted_messages;
+    std::vector<RenderCache> redacted_caches;
+    int redacted_from = static_cast<int>(LogLevel::Critical) + 1;  // Levels >= this are done
+    std::string out;
+    auto redacted_view = [&](LogLevel min_level) -> const std::vector<FormattedRecord>& {
+        const int from = static_cast<int>(min_level);
+        if (from < redacted_from) {
+            const uint64_t redact_start = stage_start(timed);
+            for (size_t k = 0; k < batch.size(); ++k) {
+                const int level = static_cast<int>(batch[k].level);
+                if (level < from || level >= redacted_from) {
+                    continue;
+                }
+                const uint64_t probe_start = stage_start(XLOG_PROBE_ENABLED(redact));
+                const bool changed = redactor->redact(batch[k].message, out);
+                XLOG_PROBE_GUARDED(redact, batch[k].logger_name.c_str(), batch[k].message.size(),
+                                   changed ? out.size() : batch[k].message.size(), elapsed_ns(probe_start));
+                if (!changed) {
+                    continue;
+                }
+                if (redacted.empty()) {
+                    redacted = plain;
+                    redacted_messages.resize(batch.size());
+                    redacted_caches.resize(batch.size());
+                }
+                redacted_messages[k] = std::move(out);
+                redacted[k] = FormattedRecord(batch[k], redacted_messages[k], redacted_caches[k]);
+            }
+            redacted_from = from;
+            end_stage(metrics_.get(), PipelineStage::Redact, redact_start);
+        }
+        return redacted.empty() ? plain : redacted;
+    };
+
+    std::vector<FormattedRecord> scratch;
+    const SinkSnapshot* sinks = sinks_.load();
+    for (size_t i = 0; i < sinks->entries.size(); ++i) {
+        LogSink* sink = sinks->entries[i]->sink.get();
+        if (!sink) {
             continue;
         }
-        auto override_it = sink_level_overrides_.find(i);
-        if (override_it != sink_level_overrides_.end()) {
-            if (level < override_it->second) {
+
+        const LogLevel min_level = sinks->entries[i]->min_level.load(std::memory_order_relaxed);
+        const bool use_redacted = redactor && redactor->applies_to(sink->is_cloud_sink());
+        std::span<const FormattedRecord> records(use_redacted ? redacted_view(min_level) : plain);
+
+        if (min_level > LogLevel::Trace) {
+            scratch.clear();
+            for (const auto& record : records) {
+                if (record.level() >= min_level) {
+                    scratch.push_back(record);
+                }
+            }
+            if (scratch.empty()) {
                 continue;
             }
+            records = std::span<const FormattedRecord>(scratch);
+        }
+
+        const SinkEntry& entry = *sinks->entries[i];
+        SinkMetrics* meter = entry.metrics.get();
+        uint64_t bytes = 0;
+        for (const auto& record : records) {
+            bytes += record.message().size();
+        }
+        XLOG_PROBE(sink__write__start, name.c_str(), entry.name.c_str(), records.size(), bytes);
+        if (meter) {
+            meter->record_writes(records.size(), bytes);
+        }
+        const bool timed_write = meter && timed;
+        const uint64_t start = stage_start(timed_write || XLOG_PROBE_ENABLED(sink__write__end));
+        if (!timed_write) {
+            sink->log_batch(records);
+        } else {
+            FormatTiming formatting(meter);
+            sink->log_batch(records);
+        }
+        const uint64_t write_ns = elapsed_ns(start);
+        if (timed_write) {
+            meter->record_write_duration_ns(write_ns);
+        }
+        XLOG_PROBE_GUARDED(sink__write__end, name.c_str(), entry.name.c_str(), records.size(), write_ns);
+    }
+    return batch.size();
+}
+
+std::future<void> Logger::flush() {
+#ifndef XLOG_NO_ASYNC
+    if (async_queue_) {
+        auto fence = std::make_shared<LogFence>();
+        fence->flush_sinks = true;
+        auto done = fence->done.get_future();
+        if (push_fence(fence, std::chrono::steady_clock::time_point::max())) {
+            return done;
+        }
+        // Shutting down: stop_async() drains what is left, so just flush
+    }
+#endif
+    flush_sinks();
+    std::promise<void> ready;
+    ready.set_value();
+    return ready.get_future();
+}
+
+void Logger::flush_sinks() {
+#ifndef XLOG_NO_RATE_LIMITING
+    flush_repeats();
+#endif
+    const auto start = std::chrono::steady_clock::now();
+    {
+        EpochDomain::ReadGuard read;
+        for (const auto& entry : sinks_.load()->entries) {
+            if (entry->sink) {
+                entry->sink->flush();
+                if (entry->metrics) {
+                    entry->metrics->record_flush();
+                }
+            }
+        }
+    }
+    if (metrics_) {
+        metrics_->record_flush();
+        metrics_->record_flush_duration_ns(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+    }
+}
+
+void Logger::enable_backtrace(size_t capacity, LogLevel dump_level) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    backtrace_dump_level_.store(dump_level, std::memory_order_relaxed);
+    backtrace_.publish(std::make_unique<BacktraceRing>(capacity));
+    update_levels(backtrace_bit, backtrace_bit);
+}
+
+void Logger::disable_backtrace() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    update_levels(backtrace_bit, 0);
+    backtrace_.publish(nullptr);
+}
+
+void Logger::enable_stack_traces(LogLevel level, size_t max_frames) {
+    // The first walk loads the unwinder, which allocates and takes the
+    // loader lock; better here than on the first error
+    StackTrace::capture(1);
+    stack_frames_.store(max_frames, std::memory_order_relaxed);
+    stack_level_.store(level, std::memory_order_relaxed);
+    stack_traces_on_.store(true, std::memory_order_release);
+}
+
+void Logger::disable_stack_traces() {
+    stack_traces_on_.store(false, std::memory_order_release);
+}
+
+void Logger::capture_backtrace(LogLevel level, std::string_view message, const LogSite* site,
+                               const DeferredSite* deferred) {
+    EpochDomain::ReadGuard read;
+    if (const BacktraceRing* ring = backtrace_.load()) {
+        ring->push(level, message, site, deferred, LogClock::now(), current_thread_id());
+    }
+}
+
+void Logger::dump_backtrace() {
+    std::vector<LogRecord> records;
+    {
+        EpochDomain::ReadGuard read;
+        if (const BacktraceRing* ring = backtrace_.load()) {
+            records = ring->take(name);
+        }
+    }
+    if (records.empty()) {
+        return;
+    }
+
+    auto marker = [this](std::string text) {
+        LogRecord record;
+        record.logger_name = name;
+        record.level = LogLevel::Info;
+        record.message = std::move(text);
+        record.timestamp = LogClock::now();
+        record.thread_id = current_thread_id();
+        record.backtrace = true;
+        return record;
+    };
+    records.insert(records.begin(), marker("backtrace start (" + std::to_string(records.size()) + " records)"));
+    records.push_back(marker("backtrace end"));
+
+#ifndef XLOG_NO_ASYNC
+    if (async_queue_) {
+        // Through the queue, so the dump lands ahead of the record that
+        // triggered it; the consumer decodes deferred ones
+        for (auto& record : records) {
+            enqueue_async(std::move(record));
+        }
+        return;
+    }
+#endif
+#if XLOG_HAS_FMT
+    std::string decoded;
+#endif
+    for (auto& record : records) {
+#if XLOG_HAS_FMT
+        if (record.deferred) {
+            record.deferred->decode(record.message, record.deferred->format, decoded);
+            record.message.swap(decoded);
+            record.deferred = nullptr;
+        }
+#endif
+        dispatch(record);
+    }
+}
+
+#ifndef XLOG_NO_RATE_LIMITING
+void Logger::set_rate_limit(const RateLimiterOptions& options) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    const bool on = options.messages_per_second > 0;
+    rate_limit_.publish(on ? std::make_unique<RateLimit>(options) : nullptr);
+    rate_limit_on_.store(on, std::memory_order_release);
+}
+
+void Logger::clear_rate_limit() {
+    set_rate_limit(RateLimiterOptions{});
+}
+
+bool Logger::rate_limited() const {
+    EpochDomain::ReadGuard read;
+    const RateLimit* limit = rate_limit_.load();
+    if (!limit || limit->limiter.try_log()) {
+        return false;
+    }
+    if (metrics_) {
+        metrics_->record_message_filtered();
+    }
+    return true;
+}
+
+size_t Logger::rate_limited_batch(size_t count) const {
+    EpochDomain::ReadGuard read;
+    const RateLimit* limit = rate_limit_.load();
+    if (!limit) {
+        return count;
+    }
+    const size_t granted = limit->limiter.try_log_many(count);
+    if (metrics_ && granted < count) {
+        metrics_->record_message_filtered(count - granted);
+    }
+    return granted;
+}
+
+void Logger::set_dedup(const DedupOptions& options) {
+    replace_dedup(std::make_unique<Deduplicator>(options));
+}
+
+void Logger::clear_dedup() {
+    replace_dedup(nullptr);
+}
+
+void Logger::replace_dedup(std::unique_ptr<Deduplicator> next) {
+    std::vector<RepeatSummary> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        {
+            EpochDomain::ReadGuard read;
+            if (const Deduplicator* old = dedup_.load()) {
+                old->drain(LogClock::now(), true, pending);
+            }
         }
-        SinkGuard guard(entry);
-        if (guard) {
-            const bool is_cloud = guard->is_cloud_sink();
-            const bool use_redacted = has_redaction && (!redact_cloud_only || is_cloud);
-            const std::string& msg_to_log = use_redacted ? redacted_message : message;
-            guard->log(name, level, msg_to_log);
+        dedup_.publish(std::move(next));
+    }
+    write_summaries(pending);
+}
+
+void Logger::write_summaries(const std::vector<RepeatSummary>& summaries) {
+    uint64_t repeats = 0;
+    for (const auto& summary : summaries) {
+        RenderCache cache;
+        fan_out(FormattedRecord(name, summary.level, summary.message, summary.last, cache, summary.site));
+        repeats += summary.repeats;
+    }
+    record_suppressed(repeats);
+}
+
+void Logger::flush_repeats() {
+    std::vector<RepeatSummary> pending;
+    {
+        EpochDomain::ReadGuard read;
+        if (const Deduplicator* dedup = dedup_.load()) {
+            dedup->drain(LogClock::now(), true, pending);
         }
     }
+    write_summaries(pending);
 }
+#endif
 
-void Logger::trace(const std::string& msg) { log(LogLevel::Trace, msg); }
-void Logger::debug(const std::string& msg) { log(LogLevel::Debug, msg); }
-void Logger::info(const std::string& msg) { log(LogLevel::Info, msg); }
-void Logger::warn(const std::string& msg) { log(LogLevel::Warn, msg); }
-void Logger::error(const std::string& msg) { log(LogLevel::Error, msg); }
-void Logger::critical(const std::string& msg) { log(LogLevel::Critical, msg); }
+#if XLOG_HAS_FMT
+void Logger::vlog(LogLevel level, fmt::string_view format, fmt::format_args args, const LogSite* site,
+                  uint64_t suppressed) {
+    thread_local fmt::memory_buffer buffer;
+    thread_local bool busy = false;
+    if (busy) {
+        // An argument's formatter or a sink is logging from inside this
+        // call, and the outer message still lives in buffer
+        fmt::memory_buffer nested;
+        fmt::vformat_to(fmt::appender(nested), format, args);
+        if (suppressed > 0) {
+            fmt::format_to(fmt::appender(nested), " [{} suppressed]", suppressed);
+        }
+        log_at(level, std::string_view(nested.data(), nested.size()), site);
+        return;
+    }
+    struct Busy {
+        bool& flag;
+        explicit Busy(bool& f) : flag(f) { flag = true; }
+        ~Busy() { flag = false; }
+    } hold(busy);
+    buffer.clear();
+    fmt::vformat_to(fmt::appender(buffer), format, args);
+    if (suppressed > 0) {
+        fmt::format_to(fmt::appender(buffer), " [{} suppressed]", suppressed);
+    }
+    log_at(level, std::string_view(buffer.data(), buffer.size()), site);
+}
+#endif
+
+#if XLOG_HAS_FMT && !defined(XLOG_NO_ASYNC)
+LogRecord Logger::acquire_record() {
+    LogRecord record;
+    if (record_pool_ && !record_pool_->acquire(record) && metrics_) {
+        metrics_->record_pool_miss();
+    }
+    return record;
+}
+
+// record.message already holds the captured arguments
+void Logger::push_deferred(const LogSite& site, const DeferredSite& deferred, LogRecord&& record) {
+    settle_sink_floor();
+    check_temporary_level_expiry();
+    const LogLevel level = site.level;
+    if (level < min_level(std::memory_order_acquire) && !site.forced()) {
+        if (backtrace_on()) {
+            capture_backtrace(level, record.message, &site, &deferred);
+        }
+        if (record_pool_) {
+            record_pool_->release(std::move(record));
+        }
+        return;
+    }
+    maybe_dump_backtrace(level);
+#ifndef XLOG_NO_RATE_LIMITING
+    if (over_rate_limit()) {
+        if (record_pool_) {
+            record_pool_->release(std::move(record));
+        }
+        return;
+    }
+#endif
+    record.logger_name.assign(name);
+    record.level = level;
+    record.timestamp = LogClock::now();
+    record.thread_id = current_thread_id();
+    record.site = &site;
+    record.deferred = &deferred;
+    record.stack = capture_stack(level);
+    capture_context(record);
+    enqueue_async(std::move(record));
+}
+#endif
+
+void Logger::trace(std::string_view msg) { log(LogLevel::Trace, msg); }
+void Logger::debug(std::string_view msg) { log(LogLevel::Debug, msg); }
+void Logger::info(std::string_view msg) { log(LogLevel::Info, msg); }
+void Logger::warn(std::string_view msg) { log(LogLevel::Warn, msg); }
+void Logger::error(std::string_view msg) { log(LogLevel::Error, msg); }
+void Logger::critical(std::string_view msg) { log(LogLevel::Critical, msg); }
 
 std::shared_ptr<Logger> Logger::create_stdout_logger(const std::string& name) {
     auto logger = std::make_shared<Logger>(name);
@@ -494,14 +1569,289 @@ std::shared_ptr<Logger> Logger::create_stdout_logger(const std::string& name) {
     return logger;
 }
 
+#ifndef XLOG_NO_ASYNC
 std::shared_ptr<Logger> Logger::create_async(const std::string& name) {
+    return create_async(name, AsyncOptions());
+}
+
+std::shared_ptr<Logger> Logger::create_async(const std::string& name, const AsyncOptions& options) {
     auto logger = std::make_shared<Logger>(name);
+    logger->enable_async(options);
     
     HealthRegistry::auto_register(name, logger);
     
     return logger;
 }
 
+void Logger::enable_async(const AsyncOptions& options) {
+    if (async_queue_) {
+        return;
+    }
+
+    AsyncQueueOptions queue_options;
+    queue_options.backend = options.backend;
+    queue_options.capacity = options.queue_capacity;
+    queue_options.lane_capacity = options.lane_capacity;
+    queue_options.shutdown_timeout_ms = options.shutdown_timeout_ms;
+    queue_options.overflow_policy = options.overflow_policy;
+    queue_options.block_timeout_ms = options.block_timeout_ms;
+    queue_options.sample_rate = options.sample_rate;
+    queue_options.wait_strategy = options.wait_strategy;
+    queue_options.spin_iterations = options.spin_iterations;
+    queue_options.yield_iterations = options.yield_iterations;
+    queue_options.priority_lane = options.priority_lane;
+    queue_options.priority_level = options.priority_level;
+    queue_options.priority_capacity = options.priority_capacity;
+    queue_options.high_watermark = options.high_watermark;
+    queue_options.low_watermark = options.low_watermark;
+    queue_options.budget_account = name;
+    queue_options.tenants = options.tenants;
+    sync_critical_ = options.sync_critical;
+    fence_timeout_ = std::chrono::milliseconds(options.fence_timeout_ms);
+    {
+        // Rings are filled in here; fault their pages in on the workers' node
+        NumaLocalScope numa;
+        async_queue_ = std::make_unique<AsyncQueue>(queue_options);
+        if (options.record_pool_size > 0) {
+            record_pool_ = std::make_unique<RecordPool>(options.record_pool_size);
+        }
+    }
+    async_batch_size_ = options.max_batch_size > 0 ? options.max_batch_size : 1;
+    async_queue_->set_pressure_callback([this](Backpressure previous, Backpressure current) {
+        notify_backpressure(previous, current);
+    });
+
+    if (metrics_) {
+        metrics_->set_queue_capacity(options.queue_capacity);
+        auto metrics = metrics_;
+        async_queue_->set_drop_callback([metrics](uint64_t count, uint64_t lane_id) {
+            if (lane_id != 0) {
+                metrics->record_lane_dropped(lane_id);
+            } else {
+                metrics->record_message_dropped(count);
+            }
+        });
+    }
+
+    size_t workers = options.worker_threads > 0 ? options.worker_threads : 1;
+    for (size_t i = 0; i < workers; ++i) {
+        async_workers_.emplace_back([this] { async_worker_loop(); });
+    }
+}
+
+bool Logger::enqueue_async(LogRecord&& record, bool may_block) {
+    const int level = static_cast<int>(record.level);
+    const size_t bytes = record.message.size();
+    const uint64_t enqueue_start = stage_start(timing_call);
+    const bool queued = may_block ? async_queue_->push(std::move(record)) : async_queue_->try_push(std::move(record));
+    end_stage(metrics_.get(), PipelineStage::Enqueue, enqueue_start);
+    if (!queued) {
+        XLOG_PROBE(queue__drop, name.c_str(), level, bytes);
+        // Overflow drops are counted by the queue's drop callback
+        if (metrics_ && async_queue_->is_shutting_down()) {
+            metrics_->record_message_dropped();
+        }
+        return false;
+    }
+    XLOG_PROBE(queue__push, name.c_str(), level, bytes);
+    if (metrics_) {
+        metrics_->observe_queue_depth(async_queue_->size());
+    }
+    return true;
+}
+
+size_t Logger::enqueue_async_batch(std::span<LogRecord> records) {
+    if (records.empty()) {
+        return 0;
+    }
+    const uint64_t enqueue_start = stage_start(metrics_ && metrics_->sample_timing());
+    const size_t queued = async_queue_->push_bulk(records);
+    end_stage(metrics_.get(), PipelineStage::Enqueue, enqueue_start);
+    if (metrics_) {
+        // Overflow drops are counted by the queue's drop callback
+        if (queued < records.size() && async_queue_->is_shutting_down()) {
+            metrics_->record_message_dropped(records.size() - queued);
+        }
+        metrics_->observe_queue_depth(async_queue_->size());
+    }
+    return queued;
+}
+
+void Logger::register_backpressure_callback(BackpressureCallback callback) {
+    std::lock_guard<std::mutex> lock(backpressure_mtx_);
+    backpressure_callbacks_.push_back(std::move(callback));
+}
+
+void Logger::clear_backpressure_callbacks() {
+    std::lock_guard<std::mutex> lock(backpressure_mtx_);
+    backpressure_callbacks_.clear();
+}
+
+void Logger::notify_backpressure(Backpressure previous, Backpressure current) {
+    std::lock_guard<std::mutex> lock(backpressure_mtx_);
+    for (const auto& callback : backpressure_callbacks_) {
+        callback(previous, current);
+    }
+}
+
+void Logger::async_worker_loop() {
+    init_background_thread("xlog-async");
+    std::vector<LogRecord> batch;
+    batch.reserve(async_batch_size_);
+#if XLOG_HAS_FMT
+    std::string decoded;
+#endif
+    for (;;) {
+        batch.clear();
+        if (!async_queue_->pop_bulk(batch, async_batch_size_)) {
+            break;
+        }
+        if (batch.empty()) {
+            continue;
+        }
+        XLOG_PROBE(queue__pop, name.c_str(), batch.size(), async_queue_->size());
+        if (metrics_) {
+            const auto dequeued = LogClock::now();
+            for (const auto& record : batch) {
+                const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(dequeued - record.timestamp).count();
+                metrics_->record_queue_wait_ns(waited > 0 ? static_cast<uint64_t>(waited) : 0);
+            }
+        }
+#if XLOG_HAS_FMT
+        // Deferred records carry argument bytes; format them here, off the
+        // logging thread, before filters and sinks look at the message.
+        // The swap leaves their old buffer to decode the next one into.
+        for (auto& record : batch) {
+            if (record.deferred) {
+                record.deferred->decode(record.message, record.deferred->format, decoded);
+                record.message.swap(decoded);
+                record.deferred = nullptr;
+            }
+        }
+#endif
+        // Likewise the stacks the logging threads only walked
+        for (const auto& record : batch) {
+            if (record.stack) {
+                record.stack->symbolize();
+            }
+        }
+        if (metrics_) {
+            metrics_->update_queue_depth(async_queue_->size());
+            WaitStats wait = async_queue_->wait_stats();
+            metrics_->update_consumer_wait(wait.spin_budget, wait.spin_wakeups,
+                                           wait.yield_wakeups, wait.parks);
+        }
+        // Records are mostly in call order, so the front is about the oldest
+        const auto oldest = batch.front().timestamp;
+        {
+            std::shared_lock<std::shared_mutex> in_flight(dispatch_mtx_);
+            dispatch_async_batch(batch, in_flight);
+        }
+        if (metrics_) {
+            const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                LogClock::now() - oldest).count();
+            metrics_->record_log_duration(latency > 0 ? static_cast<uint64_t>(latency) : 0);
+        }
+        if (record_pool_) {
+            record_pool_->release(batch);
+        }
+    }
+}
+
+void Logger::dispatch_async_batch(std::vector<LogRecord>& batch,
+                                  std::shared_lock<std::shared_mutex>& in_flight) {
+    auto is_fence = [](const LogRecord& record) { return record.fence != nullptr; };
+    if (std::none_of(batch.begin(), batch.end(), is_fence)) {
+        dispatch_batch(batch);
+        return;
+    }
+
+    // Dispatch everything ahead of each fence before completing it. The
+    // records move into the segment with their buffers, so the segment
+    // goes back to the pool and the emptied batch does not.
+    std::vector<LogRecord> segment;
+    segment.reserve(batch.size());
+    auto dispatch_segment = [&] {
+        dispatch_batch(segment);
+        if (record_pool_) {
+            record_pool_->release(segment);
+        }
+        segment.clear();
+    };
+    for (auto& record : batch) {
+        if (!record.fence) {
+            segment.push_back(std::move(record));
+            continue;
+        }
+        if (!segment.empty()) {
+            dispatch_segment();
+        }
+        if (async_workers_.size() > 1) {
+            in_flight.unlock();
+            { std::unique_lock<std::shared_mutex> wait_others(dispatch_mtx_); }
+            in_flight.lock();
+        }
+        if (record.fence->flush_sinks) {
+            flush_sinks();
+        }
+        record.fence->done.set_value();
+        record.fence.reset();
+    }
+    if (!segment.empty()) {
+        dispatch_segment();
+    }
+    batch.clear();
+}
+
+bool Logger::push_fence(const std::shared_ptr<LogFence>& fence,
+                        std::chrono::steady_clock::time_point deadline) {
+    LogRecord marker;
+    marker.level = LogLevel::Trace;  // Keeps the marker out of the priority lane
+    marker.timestamp = LogClock::now();
+    marker.fence = fence;
+
+    // The marker must not be lost to the overflow policy, so retry until
+    // there is room or the deadline passes.
+    while (!async_queue_->push(std::move(marker))) {
+        if (async_queue_->is_shutting_down() || std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+        marker.fence = fence;
+    }
+    return true;
+}
+
+bool Logger::fence_async(std::chrono::milliseconds timeout) {
+    auto fence = std::make_shared<LogFence>();
+    auto done = fence->done.get_future();
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    if (!push_fence(fence, deadline)) {
+        return false;
+    }
+    return done.wait_until(deadline) == std::future_status::ready;
+}
+
+void Logger::stop_async() {
+    if (!async_queue_) {
+        return;
+    }
+
+    async_queue_->shutdown(true);
+    for (auto& worker : async_workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    async_workers_.clear();
+
+    if (metrics_) {
+        metrics_->record_message_dropped(async_queue_->dropped_on_shutdown());
+        metrics_->update_queue_depth(0);
+    }
+}
+#endif
+
 std::string LogLevelControlResponse::to_json() const {
     std::ostringstream oss;
     oss << "{\n";
@@ -0,0 +1,196 @@
+#include "Zyrnix/logger_registry.hpp"
+
+namespace Zyrnix {
+
+// One per name ever asked for or registered; never freed, so handles stay valid
+struct LoggerHandle::Cell {
+    std::string name;
+    // Into the current table, or nullptr while nothing is registered
+    std::atomic<const LoggerPtr*> current{nullptr};
+};
+
+namespace {
+
+// What handles log to while their name has no logger. Leaked, like the
+// registry
+Logger* unregistered() {
+    static auto* logger = new Logger("unregistered");
+    return logger;
+}
+
+}
+
+LoggerHandle::Pinned::Pinned(const Cell* cell) {
+    const LoggerPtr* current = cell ? cell->current.load(std::memory_order_acquire) : nullptr;
+    logger_ = current ? current->get() : unregistered();
+}
+
+LoggerPtr LoggerHandle::get() const {
+    if (!cell_) {
+        return nullptr;
+    }
+    EpochDomain::ReadGuard read;
+    const LoggerPtr* current = cell_->current.load(std::memory_order_acquire);
+    return current ? *current : nullptr;
+}
+
+LoggerHandle::operator bool() const {
+    return cell_ && cell_->current.load(std::memory_order_acquire) != nullptr;
+}
+
+LoggerHandle::Pinned LoggerHandle::operator->() const {
+    return Pinned(cell_);
+}
+
+std::string_view LoggerHandle::name() const {
+    return cell_ ? std::string_view(cell_->name) : std::string_view();
+}
+
+LoggerRegistry& LoggerRegistry::instance() {
+    // Leaked: loggers in static storage may look others up during exit
+    static auto* registry = new LoggerRegistry();
+    return *registry;
+}
+
+LoggerRegistry::LoggerRegistry() : table_(std::make_unique<Table>()), rules_(std::make_unique<LevelRules>()) {}
+
+LoggerRegistry::~LoggerRegistry() = default;
+
+LoggerPtr LoggerRegistry::get(std::string_view name) const {
+    EpochDomain::ReadGuard read;
+    const Table* table = table_.load();
+    auto it = table->find(name);
+    return it != table->end() ? it->second : nullptr;
+}
+
+LoggerHandle LoggerRegistry::handle(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return LoggerHandle(cell(name));
+}
+
+LoggerHandle::Cell* LoggerRegistry::cell(std::string_view name) {
+    auto it = cells_.find(name);
+    if (it != cells_.end()) {
+        return it->second.get();
+    }
+    auto created = std::make_unique<LoggerHandle::Cell>();
+    created->name = std::string(name);
+    LoggerHandle::Cell* raw = created.get();
+    cells_.emplace(raw->name, std::move(created));
+    return raw;
+}
+
+// Cells are pointed into next before it is published, so a handle that
+// still sees the old table loaded it before the grace period began
+uint64_t LoggerRegistry::publish(std::unique_ptr<Table> next) {
+    for (auto& [name, cell] : cells_) {
+        auto it = next->find(name);
+        cell->current.store(it != next->end() ? &it->second : nullptr, std::memory_order_release);
+    }
+    return table_.publish(std::move(next));
+}
+
+// Replaced loggers are flushed and stopped here rather than on the next
+// write. Not under mtx_: a reader waited for may be taking a handle.
+void LoggerRegistry::release_replaced(uint64_t grace) {
+    EpochDomain::instance().wait_for(grace);
+    std::lock_guard<std::mutex> lock(mtx_);
+    table_.reclaim();
+    rules_.reclaim();
+}
+
+void LoggerRegistry::add(LoggerPtr logger) {
+    if (!logger) {
+        return;
+    }
+    uint64_t grace;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto next = std::make_unique<Table>(*table_.load());
+        const LoggerHandle::Cell* named = cell(logger->name);
+        logger->apply_level_rules(*rules_.load());
+        next->insert_or_assign(named->name, std::move(logger));
+        grace = publish(std::move(next));
+    }
+    release_replaced(grace);
+}
+
+bool LoggerRegistry::remove(std::string_view name) {
+    uint64_t grace;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!table_.load()->contains(name)) {
+            return false;
+        }
+        auto next = std::make_unique<Table>(*table_.load());
+        next->erase(next->find(name));
+        grace = publish(std::move(next));
+    }
+    release_replaced(grace);
+    return true;
+}
+
+void LoggerRegistry::update(const std::map<std::string, LoggerPtr>& loggers, const std::vector<std::string>& removed) {
+    uint64_t grace;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto next = std::make_unique<Table>(*table_.load());
+        for (const auto& name : removed) {
+            auto it = next->find(name);
+            if (it != next->end()) {
+                next->erase(it);
+            }
+        }
+        for (const auto& [name, logger] : loggers) {
+            if (logger) {
+                logger->apply_level_rules(*rules_.load());
+                next->insert_or_assign(cell(name)->name, logger);
+            }
+        }
+        grace = publish(std::move(next));
+    }
+    release_replaced(grace);
+}
+
+std::map<std::string, LoggerPtr> LoggerRegistry::get_all() const {
+    EpochDomain::ReadGuard read;
+    const Table* table = table_.load();
+    std::map<std::string, LoggerPtr> all;
+    for (const auto& [name, logger] : *table) {
+        all.emplace(std::string(name), logger);
+    }
+    return all;
+}
+
+size_t LoggerRegistry::size() const {
+    EpochDomain::ReadGuard read;
+    return table_.load()->size();
+}
+
+// Under mtx_, so a logger registered meanwhile gets either the old rules
+// and then this pass, or the new rules
+void LoggerRegistry::set_level_rules(LevelRules rules) {
+    uint64_t grace;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto next = std::make_unique<LevelRules>(std::move(rules));
+        const LevelRules& applied = *next;
+        grace = rules_.publish(std::move(next));
+        for (const auto& [name, logger] : *table_.load()) {
+            logger->apply_level_rules(applied);
+        }
+    }
+    release_replaced(grace);
+}
+
+LevelRules LoggerRegistry::level_rules() const {
+    EpochDomain::ReadGuard read;
+    return *rules_.load();
+}
+
+std::optional<LogLevel> LoggerRegistry::rule_level(std::string_view name) const {
+    EpochDomain::ReadGuard read;
+    return rules_.load()->match(name);
+}
+
+}
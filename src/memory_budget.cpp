@@ -0,0 +1,142 @@
+#include "Zyrnix/memory_budget.hpp"
+#include <algorithm>
+
+namespace Zyrnix {
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+void MemoryBudget::configure(const MemoryBudgetOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t permille = static_cast<size_t>(std::clamp(options.sample_fill, 0.0, 1.0) * 1000);
+    limit_.store(options.limit_bytes, std::memory_order_relaxed);
+    sample_permille_.store(permille, std::memory_order_relaxed);
+    sample_at_.store(options.limit_bytes / 1000 * permille, std::memory_order_relaxed);
+    sample_rate_.store(std::max<size_t>(options.sample_rate, 1), std::memory_order_relaxed);
+    sample_below_.store(options.sample_below, std::memory_order_relaxed);
+    drop_below_.store(std::max(options.drop_below, options.sample_below), std::memory_order_relaxed);
+    for (BudgetAccount* account : accounts_) {
+        account->share_.store(share_bytes(account->name()), std::memory_order_relaxed);
+    }
+    if (options.limit_bytes > 0) {
+        enabled_.store(true, std::memory_order_release);
+    }
+}
+
+void MemoryBudget::set_share(const std::string& account, double fraction) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(shares_.begin(), shares_.end(), [&](const auto& share) { return share.first == account; });
+    if (fraction <= 0) {
+        if (it != shares_.end()) {
+            shares_.erase(it);
+        }
+    } else if (it != shares_.end()) {
+        it->second = std::min(fraction, 1.0);
+    } else {
+        shares_.emplace_back(account, std::min(fraction, 1.0));
+    }
+    for (BudgetAccount* open : accounts_) {
+        if (open->name() == account) {
+            open->share_.store(share_bytes(account), std::memory_order_relaxed);
+        }
+    }
+}
+
+void MemoryBudget::clear_shares() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shares_.clear();
+    for (BudgetAccount* account : accounts_) {
+        account->share_.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t MemoryBudget::share_bytes(const std::string& account) const {
+    for (const auto& share : shares_) {
+        if (share.first == account) {
+            return static_cast<size_t>(static_cast<double>(limit_.load(std::memory_order_relaxed)) * share.second);
+        }
+    }
+    return 0;
+}
+
+BudgetState MemoryBudget::state() const {
+    const size_t limit = limit_.load(std::memory_order_relaxed);
+    const size_t used = used_.load(std::memory_order_relaxed);
+    if (limit == 0 || used < sample_at_.load(std::memory_order_relaxed)) {
+        return BudgetState::Normal;
+    }
+    return used < limit ? BudgetState::Sampling : BudgetState::Shedding;
+}
+
+MemoryBudgetStats MemoryBudget::stats() const {
+    MemoryBudgetStats stats;
+    stats.limit = limit();
+    stats.used = used();
+    stats.state = state();
+    stats.sampled_out = sampled_out_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.accounts.reserve(accounts_.size());
+    for (const BudgetAccount* account : accounts_) {
+        stats.accounts.push_back({account->name(), account->used(), account->share_.load(std::memory_order_relaxed)});
+    }
+    return stats;
+}
+
+void MemoryBudget::attach(BudgetAccount* account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    account->share_.store(share_bytes(account->name()), std::memory_order_relaxed);
+    accounts_.push_back(account);
+}
+
+void MemoryBudget::detach(BudgetAccount* account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accounts_.erase(std::remove(accounts_.begin(), accounts_.end(), account), accounts_.end());
+}
+
+BudgetAccount::BudgetAccount(std::string name) : name_(std::move(name)) {
+    MemoryBudget& budget = MemoryBudget::instance();
+    if (budget.enabled_.load(std::memory_order_acquire)) {
+        budget_ = &budget;
+        budget.attach(this);
+    }
+}
+
+BudgetAccount::~BudgetAccount() {
+    if (budget_) {
+        release(used_.load(std::memory_order_relaxed));
+        budget_->detach(this);
+    }
+}
+
+bool BudgetAccount::admit(LogLevel level, size_t bytes) {
+    if (!budget_ || level >= budget_->drop_below_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    const size_t limit = budget_->limit_.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+    const size_t share = share_.load(std::memory_order_relaxed);
+    const size_t mine = used_.load(std::memory_order_relaxed) + bytes;
+    const size_t total = budget_->used_.load(std::memory_order_relaxed) + bytes;
+    if (total > limit || (share > 0 && mine > share)) {
+        budget_->dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (level >= budget_->sample_below_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    const bool sampling = total > budget_->sample_at_.load(std::memory_order_relaxed) ||
+                          (share > 0 && mine > share / 1000 * budget_->sample_permille_.load(std::memory_order_relaxed));
+    if (sampling && sample_counter_.fetch_add(1, std::memory_order_relaxed) %
+                        budget_->sample_rate_.load(std::memory_order_relaxed) != 0) {
+        budget_->sampled_out_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,206 @@
+#include "Zyrnix/metrics_server.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+namespace Zyrnix {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;
+#endif
+
+constexpr size_t max_request = 8192;
+constexpr int accept_poll_ms = 200;  // How soon stop() is noticed
+
+bool send_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t sent = ::send(fd, data.data(), data.size(), send_flags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+// Value of header name in the header block, empty if absent
+std::string_view header(std::string_view headers, std::string_view name) {
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t end = headers.find("\r\n", pos);
+        if (end == std::string_view::npos) {
+            end = headers.size();
+        }
+        const std::string_view line = headers.substr(pos, end - pos);
+        const size_t colon = line.find(':');
+        if (colon != std::string_view::npos && iequals(line.substr(0, colon), name)) {
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && value.front() == ' ') {
+                value.remove_prefix(1);
+            }
+            return value;
+        }
+        pos = end + 2;
+    }
+    return {};
+}
+
+}
+
+MetricsServer::MetricsServer(const MetricsServerOptions& options) : options_(options) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options_.port);
+    if (::inet_pton(AF_INET, options_.address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "MetricsServer: not an IPv4 address: " << options_.address << std::endl;
+        return false;
+    }
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "MetricsServer: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0) {
+        std::cerr << "MetricsServer: cannot listen on " << options_.address << ":" << options_.port
+                  << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+    fd_ = fd;
+    stopping_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (fd_ < 0) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_relaxed);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void MetricsServer::run() {
+    init_background_thread("xlog-metrics");
+    pollfd pfd{fd_, POLLIN, 0};
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        const int ready = ::poll(&pfd, 1, accept_poll_ms);
+        if (ready <= 0) {
+            continue;
+        }
+        const int client = ::accept(fd_, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        timeval timeout{};
+        timeout.tv_sec = static_cast<time_t>(options_.io_timeout.count() / 1000);
+        timeout.tv_usec = static_cast<suseconds_t>((options_.io_timeout.count() % 1000) * 1000);
+        ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+        const int on = 1;
+        ::setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        serve(client);
+        ::close(client);
+    }
+}
+
+void MetricsServer::serve(int client) {
+    request_.clear();
+    char buf[2048];
+    size_t head_end;
+    while ((head_end = request_.find("\r\n\r\n")) == std::string::npos) {
+        if (request_.size() >= max_request) {
+            send_all(client, "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            return;
+        }
+        const ssize_t got = ::recv(client, buf, sizeof(buf), 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return;  // Closed or timed out before a whole request came
+        }
+        request_.append(buf, static_cast<size_t>(got));
+    }
+
+    const std::string_view request(request_.data(), head_end);
+    const size_t line_end = std::min(request.find("\r\n"), request.size());
+    const std::string_view line = request.substr(0, line_end);
+    const size_t method_end = line.find(' ');
+    const size_t target_end = line.find(' ', method_end == std::string_view::npos ? line.size() : method_end + 1);
+    if (method_end == std::string_view::npos || target_end == std::string_view::npos) {
+        send_all(client, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+    const std::string_view method = line.substr(0, method_end);
+    std::string_view target = line.substr(method_end + 1, target_end - method_end - 1);
+    target = target.substr(0, target.find('?'));
+    if (target != options_.path) {
+        send_all(client, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+    if (method != "GET" && method != "HEAD") {
+        send_all(client, "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, HEAD\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+
+    const std::string_view headers = request.substr(std::min(line_end + 2, request.size()));
+    const ExpositionFormat format = header(headers, "Accept").find("application/openmetrics-text") != std::string_view::npos
+                                        ? ExpositionFormat::OpenMetrics
+                                        : ExpositionFormat::Prometheus;
+    MetricsRegistry::instance().write_exposition(body_, options_.prefix, format);
+    scrapes_.fetch_add(1, std::memory_order_relaxed);
+
+    head_.assign("HTTP/1.1 200 OK\r\nContent-Type: ");
+    head_.append(content_type(format));
+    head_.append("\r\nContent-Length: ").append(std::to_string(body_.size()));
+    head_.append("\r\nConnection: close\r\n\r\n");
+    if (send_all(client, head_) && method == "GET") {
+        send_all(client, body_);
+    }
+}
+
+}
@@ -0,0 +1,654 @@
+#include "Zyrnix/parquet.hpp"
+#include "Zyrnix/json_escape.hpp"
+#include "Zyrnix/snappy.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+#ifndef XLOG_VERSION
+#define XLOG_VERSION "unknown"
+#endif
+
+namespace Zyrnix {
+
+namespace parquet {
+
+namespace {
+
+constexpr char magic[4] = {'P', 'A', 'R', '1'};
+constexpr size_t max_dictionary_bytes = 1 << 20;
+
+// parquet.thrift enums
+enum Encoding : int { plain = 0, plain_dictionary = 2, rle = 3 };
+enum PageType : int { data_page = 0, dictionary_page = 2 };
+enum ConvertedType : int { utf8 = 0, timestamp_micros = 10 };
+enum Repetition : int { required = 0, optional = 1 };
+
+// Thrift compact protocol, the parts the Parquet footer and page headers use
+class Thrift {
+public:
+    enum Type : uint8_t { bool_true = 1, bool_false = 2, i32_type = 5, i64_type = 6, binary_type = 8,
+                          list_type = 9, struct_type = 12 };
+
+    explicit Thrift(std::string& out) : out_(out) {}
+
+    void i32(int16_t id, int32_t value) {
+        field(id, i32_type);
+        varint(zigzag(value));
+    }
+    void i64(int16_t id, int64_t value) {
+        field(id, i64_type);
+        varint(zigzag(value));
+    }
+    void binary(int16_t id, std::string_view value) {
+        field(id, binary_type);
+        varint(value.size());
+        out_.append(value);
+    }
+    void boolean(int16_t id, bool value) { field(id, value ? bool_true : bool_false); }
+
+    void begin_struct(int16_t id) {
+        field(id, struct_type);
+        begin_element();
+    }
+    void end_struct() { end_element(); }
+
+    void begin_list(int16_t id, Type element, size_t size) {
+        field(id, list_type);
+        if (size < 15) {
+            out_.push_back(static_cast<char>((size << 4) | element));
+        } else {
+            out_.push_back(static_cast<char>(0xF0 | element));
+            varint(size);
+        }
+    }
+    // A struct inside a list has no field header
+    void begin_element() {
+        stack_.push_back(last_);
+        last_ = 0;
+    }
+    void end_element() {
+        out_.push_back(0);  // STOP
+        last_ = stack_.back();
+        stack_.pop_back();
+    }
+    void list_i32(int32_t value) { varint(zigzag(value)); }
+    void list_binary(std::string_view value) {
+        varint(value.size());
+        out_.append(value);
+    }
+
+    void stop() { out_.push_back(0); }
+
+private:
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<char>(value));
+    }
+
+    void field(int16_t id, uint8_t type) {
+        const int delta = id - last_;
+        if (delta > 0 && delta <= 15) {
+            out_.push_back(static_cast<char>((delta << 4) | type));
+        } else {
+            out_.push_back(static_cast<char>(type));
+            varint(zigzag(id));
+        }
+        last_ = id;
+    }
+
+    std::string& out_;
+    int16_t last_ = 0;
+    std::vector<int16_t> stack_;
+};
+
+void put_le(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+void put_uleb(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// The RLE / bit-packed hybrid: runs of 8 or more equal values as RLE,
+// everything between them bit-packed in groups of 8
+void put_hybrid(std::string& out, const uint32_t* values, size_t count, int bit_width) {
+    const size_t value_bytes = static_cast<size_t>((bit_width + 7) / 8);
+    auto run_at = [&](size_t i) {
+        size_t j = i;
+        while (j < count && values[j] == values[i]) ++j;
+        return j - i;
+    };
+    size_t i = 0;
+    while (i < count) {
+        const size_t run = run_at(i);
+        if (run >= 8) {
+            put_uleb(out, run << 1);
+            put_le(out, values[i], value_bytes);
+            i += run;
+            continue;
+        }
+        const size_t start = i;
+        size_t groups = 0;
+        while (i < count && (groups == 0 || run_at(i) < 8)) {
+            i = std::min(i + 8, count);
+            ++groups;
+        }
+        put_uleb(out, (groups << 1) | 1);
+        // LSB first across the packed bytes; the last group is padded with 0
+        uint64_t buffer = 0;
+        int bits = 0;
+        for (size_t v = start; v < start + groups * 8; ++v) {
+            buffer |= static_cast<uint64_t>(v < count ? values[v] : 0) << bits;
+            bits += bit_width;
+            while (bits >= 8) {
+                out.push_back(static_cast<char>(buffer));
+                buffer >>= 8;
+                bits -= 8;
+            }
+        }
+    }
+}
+
+// Optional columns only: 1 for a row with a value, as a 4-byte length
+// and the hybrid encoding at bit width 1
+void put_definition_levels(std::string& out, const std::vector<uint8_t>& defined, size_t begin, size_t end) {
+    std::vector<uint32_t> levels(defined.begin() + static_cast<std::ptrdiff_t>(begin),
+                                 defined.begin() + static_cast<std::ptrdiff_t>(end));
+    const size_t at = out.size();
+    put_le(out, 0, 4);
+    put_hybrid(out, levels.data(), levels.size(), 1);
+    const uint32_t length = static_cast<uint32_t>(out.size() - at - 4);
+    for (size_t i = 0; i < 4; ++i) {
+        out[at + i] = static_cast<char>(length >> (8 * i));
+    }
+}
+
+int bit_width_for(size_t dictionary_size) {
+    int width = 1;
+    while ((size_t{1} << width) < dictionary_size) ++width;
+    return width;
+}
+
+std::string_view value_at(const RowBatch::Column& column, size_t i) {
+    const uint32_t begin = i == 0 ? 0 : column.ends[i - 1];
+    return std::string_view(column.bytes).substr(begin, column.ends[i] - begin);
+}
+
+}
+
+// RowBatch
+
+size_t RowBatch::Column::values() const {
+    switch (type) {
+        case Physical::Int64: return ints.size();
+        case Physical::Double: return doubles.size();
+        case Physical::Boolean: return bools.size();
+        case Physical::ByteArray: return ends.size();
+    }
+    return 0;
+}
+
+RowBatch::RowBatch(const Schema& schema) : schema_(schema) {
+    auto add = [this](std::string name, Physical type, bool optional, bool string, bool timestamp = false) {
+        Column column;
+        column.name = std::move(name);
+        column.type = type;
+        column.optional = optional;
+        column.string = string;
+        column.timestamp = timestamp;
+        columns_.push_back(std::move(column));
+    };
+    add("timestamp", Physical::Int64, false, false, true);
+    add("level", Physical::ByteArray, false, true);
+    add("logger", Physical::ByteArray, false, true);
+    add("thread", Physical::Int64, false, false);
+    add("message", Physical::ByteArray, false, true);
+    if (schema_.trace) {
+        trace_column_ = columns_.size();
+        add("trace_id", Physical::ByteArray, true, true);
+        add("span_id", Physical::ByteArray, true, true);
+    }
+    field_column_ = columns_.size();
+    for (const auto& field : schema_.fields) {
+        switch (field.type) {
+            case FieldType::Integer: add(field.name, Physical::Int64, true, false); break;
+            case FieldType::Float: add(field.name, Physical::Double, true, false); break;
+            case FieldType::Bool: add(field.name, Physical::Boolean, true, false); break;
+            case FieldType::String: add(field.name, Physical::ByteArray, true, true); break;
+        }
+    }
+    if (schema_.other_fields) {
+        add("fields", Physical::ByteArray, true, true);
+    }
+}
+
+void RowBatch::push_string(Column& column, std::string_view value) {
+    column.bytes.append(value);
+    column.ends.push_back(static_cast<uint32_t>(column.bytes.size()));
+    if (column.optional) {
+        column.defined.push_back(1);
+    }
+}
+
+void RowBatch::push_null(Column& column) {
+    column.defined.push_back(0);
+}
+
+// False, storing a null, for a value that does not parse as the column's type
+bool RowBatch::push_field(Column& column, FieldType type, const FieldValue& value) {
+    const std::string& text = value.text();
+    switch (type) {
+        case FieldType::Integer: {
+            int64_t number;
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+            if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+                push_null(column);
+                return false;
+            }
+            column.ints.push_back(number);
+            break;
+        }
+        case FieldType::Float: {
+            double number;
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+            if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+                push_null(column);
+                return false;
+            }
+            column.doubles.push_back(number);
+            break;
+        }
+        case FieldType::Bool:
+            if (text != "true" && text != "false") {
+                push_null(column);
+                return false;
+            }
+            column.bools.push_back(text == "true" ? 1 : 0);
+            break;
+        case FieldType::String:
+            push_string(column, text);
+            return true;
+    }
+    column.defined.push_back(1);
+    return true;
+}
+
+void RowBatch::add(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+                   std::string_view logger_name, std::string_view message, const TraceContext* trace,
+                   const FieldList* fields) {
+    columns_[0].ints.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count());
+    push_string(columns_[1], level_name(level));
+    push_string(columns_[2], logger_name);
+    columns_[3].ints.push_back(static_cast<int64_t>(thread_id));
+    push_string(columns_[4], message);
+    if (schema_.trace) {
+        if (trace && trace->valid()) {
+            char trace_hex[TraceContext::trace_id_hex_size];
+            char span_hex[TraceContext::span_id_hex_size];
+            trace->write_trace_id(trace_hex);
+            trace->write_span_id(span_hex);
+            push_string(columns_[trace_column_], std::string_view(trace_hex, sizeof(trace_hex)));
+            push_string(columns_[trace_column_ + 1], std::string_view(span_hex, sizeof(span_hex)));
+        } else {
+            push_null(columns_[trace_column_]);
+            push_null(columns_[trace_column_ + 1]);
+        }
+    }
+    rejected_.clear();
+    for (size_t i = 0; i < schema_.fields.size(); ++i) {
+        const FieldValue* value = fields ? fields->find(schema_.fields[i].name) : nullptr;
+        if (value) {
+            if (!push_field(columns_[field_column_ + i], schema_.fields[i].type, *value)) {
+                rejected_.push_back(schema_.fields[i].name);
+            }
+        } else {
+            push_null(columns_[field_column_ + i]);
+        }
+    }
+    if (schema_.other_fields) {
+        json_.clear();
+        if (fields) {
+            for (const auto& [key, value] : *fields) {
+                // A declared field is only here when its column could not hold it
+                const bool declared = std::any_of(schema_.fields.begin(), schema_.fields.end(),
+                                                  [&](const FieldColumn& column) { return column.name == key; });
+                if (declared && std::find(rejected_.begin(), rejected_.end(), key) == rejected_.end()) continue;
+                json_.push_back(json_.empty() ? '{' : ',');
+                json::append_string(json_, key);
+                json_.push_back(':');
+                value.append_json(json_);
+            }
+        }
+        if (json_.empty()) {
+            push_null(columns_.back());
+        } else {
+            json_.push_back('}');
+            push_string(columns_.back(), json_);
+        }
+    }
+    ++rows_;
+}
+
+size_t RowBatch::bytes() const {
+    size_t total = 0;
+    for (const auto& column : columns_) {
+        total += column.ints.size() * 8 + column.doubles.size() * 8 + column.bools.size() +
+                 column.bytes.size() + column.ends.size() * 4 + column.defined.size();
+    }
+    return total;
+}
+
+void RowBatch::clear() {
+    for (auto& column : columns_) {
+        column.ints.clear();
+        column.doubles.clear();
+        column.bools.clear();
+        column.bytes.clear();
+        column.ends.clear();
+        column.defined.clear();
+    }
+    rows_ = 0;
+}
+
+// FileWriter
+
+FileWriter::FileWriter(const Schema& schema, Codec codec, size_t page_rows)
+    : schema_(schema), codec_(codec), page_rows_(std::max<size_t>(page_rows, 1)) {
+    // The schema is a root group and then the columns, depth first
+    const RowBatch layout(schema_);
+    Thrift thrift(schema_bytes_);
+    thrift.begin_element();
+    thrift.binary(4, "schema");
+    thrift.i32(5, static_cast<int32_t>(layout.columns().size()));
+    thrift.end_element();
+    for (const auto& column : layout.columns()) {
+        thrift.begin_element();
+        thrift.i32(1, static_cast<int32_t>(column.type));
+        thrift.i32(3, column.optional ? optional : required);
+        thrift.binary(4, column.name);
+        if (column.string) {
+            thrift.i32(6, utf8);
+            thrift.begin_struct(10);  // LogicalType
+            thrift.begin_struct(1);   // STRING
+            thrift.end_struct();
+            thrift.end_struct();
+        } else if (column.timestamp) {
+            thrift.i32(6, timestamp_micros);
+            thrift.begin_struct(10);  // LogicalType
+            thrift.begin_struct(8);   // TIMESTAMP
+            thrift.boolean(1, true);  // isAdjustedToUTC
+            thrift.begin_struct(2);   // unit
+            thrift.begin_struct(2);   // MICROS
+            thrift.end_struct();
+            thrift.end_struct();
+            thrift.end_struct();
+            thrift.end_struct();
+        }
+        thrift.end_element();
+    }
+    schema_elements_ = layout.columns().size() + 1;
+}
+
+FileWriter::~FileWriter() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool FileWriter::open(const std::string& path) {
+    if (file_) {
+        std::fclose(file_);
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    offset_ = 0;
+    rows_ = 0;
+    groups_.clear();
+    return file_ && put(std::string_view(magic, sizeof(magic)));
+}
+
+bool FileWriter::put(std::string_view bytes) {
+    if (!file_ || std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size()) {
+        return false;
+    }
+    offset_ += bytes.size();
+    return true;
+}
+
+bool FileWriter::write_page(int page_type, std::string_view body, uint32_t values, int encoding) {
+    std::string_view stored = body;
+    if (codec_ == Codec::Snappy) {
+        compressed_.clear();
+        snappy::compress(body, compressed_);
+        stored = compressed_;
+    }
+    header_.clear();
+    Thrift thrift(header_);
+    thrift.i32(1, page_type);
+    thrift.i32(2, static_cast<int32_t>(body.size()));
+    thrift.i32(3, static_cast<int32_t>(stored.size()));
+    if (page_type == dictionary_page) {
+        thrift.begin_struct(7);
+        thrift.i32(1, static_cast<int32_t>(values));
+        thrift.i32(2, encoding);
+        thrift.end_struct();
+    } else {
+        thrift.begin_struct(5);
+        thrift.i32(1, static_cast<int32_t>(values));
+        thrift.i32(2, encoding);
+        thrift.i32(3, rle);  // Definition levels
+        thrift.i32(4, rle);  // Repetition levels
+        thrift.end_struct();
+    }
+    thrift.stop();
+    return put(header_) && put(stored);
+}
+
+bool FileWriter::write_chunk(const RowBatch::Column& column, size_t rows, ChunkMeta& meta) {
+    const uint64_t start = offset_;
+    meta.column = &column;
+    meta.values = rows;
+    meta.dictionary = false;
+    meta.dictionary_offset = 0;
+    meta.uncompressed = 0;
+    meta.has_range = column.timestamp && !column.ints.empty();
+    if (meta.has_range) {
+        const auto [min, max] = std::minmax_element(column.ints.begin(), column.ints.end());
+        meta.min = *min;
+        meta.max = *max;
+    }
+
+    // Dictionary-encode strings that repeat
+    std::vector<uint32_t> indices;
+    std::vector<std::string_view> dictionary;
+    if (column.type == RowBatch::Physical::ByteArray && column.values() > 0) {
+        std::unordered_map<std::string_view, uint32_t> ids;
+        size_t dictionary_bytes = 0;
+        indices.reserve(column.values());
+        bool worth_it = true;
+        for (size_t i = 0; i < column.values() && worth_it; ++i) {
+            const std::string_view value = value_at(column, i);
+            const auto [it, added] = ids.emplace(value, static_cast<uint32_t>(dictionary.size()));
+            if (added) {
+                dictionary.push_back(value);
+                dictionary_bytes += value.size() + 4;
+                worth_it = dictionary_bytes <= max_dictionary_bytes;
+            }
+            indices.push_back(it->second);
+        }
+        meta.dictionary = worth_it && dictionary.size() * 2 <= column.values();
+        if (meta.dictionary) {
+            page_.clear();
+            for (std::string_view value : dictionary) {
+                put_le(page_, value.size(), 4);
+                page_.append(value);
+            }
+            meta.dictionary_offset = offset_;
+            if (!write_page(dictionary_page, page_, static_cast<uint32_t>(dictionary.size()), plain_dictionary)) {
+                return false;
+            }
+            meta.uncompressed += header_.size() + page_.size();
+        }
+    }
+
+    meta.data_offset = offset_;
+    const int bit_width = meta.dictionary ? bit_width_for(dictionary.size()) : 0;
+    size_t value = 0;  // First value of the page, counting defined rows only
+    for (size_t row = 0; row < rows; row += page_rows_) {
+        const size_t end = std::min(row + page_rows_, rows);
+        size_t values = end - row;
+        page_.clear();
+        if (column.optional) {
+            put_definition_levels(page_, column.defined, row, end);
+            values = static_cast<size_t>(std::count(column.defined.begin() + static_cast<std::ptrdiff_t>(row),
+                                                    column.defined.begin() + static_cast<std::ptrdiff_t>(end), 1));
+        }
+        if (meta.dictionary) {
+            page_.push_back(static_cast<char>(bit_width));
+            put_hybrid(page_, indices.data() + value, values, bit_width);
+        } else {
+            switch (column.type) {
+                case RowBatch::Physical::Int64:
+                    for (size_t i = value; i < value + values; ++i) {
+                        put_le(page_, static_cast<uint64_t>(column.ints[i]), 8);
+                    }
+                    break;
+                case RowBatch::Physical::Double:
+                    for (size_t i = value; i < value + values; ++i) {
+                        uint64_t bits;
+                        std::memcpy(&bits, &column.doubles[i], sizeof(bits));
+                        put_le(page_, bits, 8);
+                    }
+                    break;
+                case RowBatch::Physical::Boolean: {
+                    // Bit-packed, LSB first
+                    size_t at = page_.size();
+                    page_.append((values + 7) / 8, '\0');
+                    for (size_t i = 0; i < values; ++i) {
+                        if (column.bools[value + i]) {
+                            page_[at + i / 8] = static_cast<char>(page_[at + i / 8] | (1 << (i % 8)));
+                        }
+                    }
+                    break;
+                }
+                case RowBatch::Physical::ByteArray:
+                    for (size_t i = value; i < value + values; ++i) {
+                        const std::string_view text = value_at(column, i);
+                        put_le(page_, text.size(), 4);
+                        page_.append(text);
+                    }
+                    break;
+            }
+        }
+        if (!write_page(data_page, page_, static_cast<uint32_t>(end - row), meta.dictionary ? plain_dictionary : plain)) {
+            return false;
+        }
+        meta.uncompressed += header_.size() + page_.size();  // Headers count, as in the compressed size
+        value += values;
+    }
+    meta.compressed = offset_ - start;
+    return true;
+}
+
+bool FileWriter::write_row_group(const RowBatch& batch) {
+    if (!file_ || batch.rows() == 0) {
+        return batch.rows() == 0;
+    }
+    GroupMeta group;
+    group.rows = batch.rows();
+    group.total_bytes = 0;
+    Thrift thrift(group.columns);
+    for (const auto& column : batch.columns()) {
+        ChunkMeta meta;
+        if (!write_chunk(column, batch.rows(), meta)) {
+            return false;
+        }
+        group.total_bytes += meta.uncompressed;
+        // ColumnChunk
+        thrift.begin_element();
+        thrift.i64(2, static_cast<int64_t>(meta.dictionary ? meta.dictionary_offset : meta.data_offset));
+        thrift.begin_struct(3);  // ColumnMetaData
+        thrift.i32(1, static_cast<int32_t>(column.type));
+        thrift.begin_list(2, Thrift::i32_type, 2);
+        thrift.list_i32(meta.dictionary ? plain_dictionary : plain);
+        thrift.list_i32(rle);
+        thrift.begin_list(3, Thrift::binary_type, 1);
+        thrift.list_binary(column.name);
+        thrift.i32(4, static_cast<int32_t>(codec_));
+        thrift.i64(5, static_cast<int64_t>(meta.values));
+        thrift.i64(6, static_cast<int64_t>(meta.uncompressed));
+        thrift.i64(7, static_cast<int64_t>(meta.compressed));
+        thrift.i64(9, static_cast<int64_t>(meta.data_offset));
+        if (meta.dictionary) {
+            thrift.i64(11, static_cast<int64_t>(meta.dictionary_offset));
+        }
+        if (meta.has_range) {
+            // Statistics: the deprecated max/min too, for older readers
+            std::string min;
+            std::string max;
+            put_le(min, static_cast<uint64_t>(meta.min), 8);
+            put_le(max, static_cast<uint64_t>(meta.max), 8);
+            thrift.begin_struct(12);
+            thrift.binary(1, max);
+            thrift.binary(2, min);
+            thrift.i64(3, 0);
+            thrift.binary(5, max);
+            thrift.binary(6, min);
+            thrift.end_struct();
+        }
+        thrift.end_struct();
+        thrift.end_element();
+    }
+    rows_ += group.rows;
+    groups_.push_back(std::move(group));
+    return true;
+}
+
+bool FileWriter::finish() {
+    if (!file_) {
+        return false;
+    }
+    const size_t columns = schema_elements_ - 1;
+    std::string footer;
+    Thrift thrift(footer);
+    thrift.i32(1, 1);  // version
+    thrift.begin_list(2, Thrift::struct_type, schema_elements_);
+    footer.append(schema_bytes_);
+    thrift.i64(3, static_cast<int64_t>(rows_));
+    thrift.begin_list(4, Thrift::struct_type, groups_.size());
+    for (const auto& group : groups_) {
+        thrift.begin_element();
+        thrift.begin_list(1, Thrift::struct_type, columns);
+        footer.append(group.columns);
+        thrift.i64(2, static_cast<int64_t>(group.total_bytes));
+        thrift.i64(3, static_cast<int64_t>(group.rows));
+        thrift.end_element();
+    }
+    thrift.binary(6, "Zyrnix version " XLOG_VERSION);
+    thrift.stop();
+    put_le(footer, footer.size(), 4);
+    footer.append(magic, sizeof(magic));
+    const bool ok = put(footer) && std::fflush(file_) == 0;
+    const bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    return ok && closed;
+}
+
+}
+
+}
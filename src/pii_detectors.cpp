@@ -0,0 +1,449 @@
+#include "Zyrnix/pii_detectors.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define XLOG_PII_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define XLOG_PII_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+enum CharClass : uint8_t {
+    ClassDigit       = 1 << 0,
+    ClassAlpha       = 1 << 1,
+    ClassWord        = 1 << 2,  // \w
+    ClassEmailLocal  = 1 << 3,  // [A-Za-z0-9._%+-]
+    ClassEmailDomain = 1 << 4,  // [A-Za-z0-9.-]
+};
+
+struct CharTable {
+    uint8_t flags[256] = {};
+
+    constexpr CharTable() {
+        for (int c = 0; c < 256; ++c) {
+            const bool digit = c >= '0' && c <= '9';
+            const bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            uint8_t f = 0;
+            f |= digit ? ClassDigit : 0;
+            f |= alpha ? ClassAlpha : 0;
+            f |= (digit || alpha || c == '_') ? ClassWord : 0;
+            f |= (digit || alpha || c == '.' || c == '_' || c == '%' || c == '+' || c == '-') ? ClassEmailLocal : 0;
+            f |= (digit || alpha || c == '.' || c == '-') ? ClassEmailDomain : 0;
+            flags[c] = f;
+        }
+    }
+};
+
+constexpr CharTable char_table;
+
+inline bool char_is(unsigned char c, uint8_t cls) { return (char_table.flags[c] & cls) != 0; }
+inline bool is_digit(unsigned char c) { return static_cast<unsigned char>(c - '0') < 10; }
+inline bool is_alpha(unsigned char c) { return char_is(c, ClassAlpha); }
+inline bool is_word(unsigned char c) { return char_is(c, ClassWord); }
+inline bool is_email_local(unsigned char c) { return char_is(c, ClassEmailLocal); }
+inline bool is_email_domain(unsigned char c) { return char_is(c, ClassEmailDomain); }
+
+// ---------------------------------------------------------------------------
+// Prefilter kernels: classify a 64-byte block into one bit per byte for
+// digits, '@' and the separators '.', '-' and ' '.
+// ---------------------------------------------------------------------------
+
+struct BlockMasks {
+    uint64_t digit;
+    uint64_t at;
+    uint64_t sep;
+};
+
+using ClassifyFn = BlockMasks (*)(const char* p);
+
+[[maybe_unused]] BlockMasks classify_scalar(const char* p) {
+    BlockMasks m{0, 0, 0};
+    for (unsigned k = 0; k < 64; ++k) {
+        const unsigned char c = static_cast<unsigned char>(p[k]);
+        m.digit |= static_cast<uint64_t>(is_digit(c)) << k;
+        m.at |= static_cast<uint64_t>(c == '@') << k;
+        m.sep |= static_cast<uint64_t>(c == '.' || c == '-' || c == ' ') << k;
+    }
+    return m;
+}
+
+#if defined(XLOG_PII_X86)
+
+BlockMasks classify_sse2(const char* p) {
+    const __m128i at = _mm_set1_epi8('@');
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i dot = _mm_set1_epi8('.');
+    const __m128i dash = _mm_set1_epi8('-');
+    const __m128i space = _mm_set1_epi8(' ');
+    BlockMasks m{0, 0, 0};
+    for (unsigned k = 0; k < 64; k += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k));
+        const __m128i d = _mm_sub_epi8(v, zero);
+        const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+        const __m128i seps = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, dot), _mm_cmpeq_epi8(v, dash)),
+                                          _mm_cmpeq_epi8(v, space));
+        m.digit |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(digits))) << k;
+        m.at |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, at)))) << k;
+        m.sep |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(seps))) << k;
+    }
+    return m;
+}
+
+__attribute__((target("avx2")))
+BlockMasks classify_avx2(const char* p) {
+    const __m256i at = _mm256_set1_epi8('@');
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i dot = _mm256_set1_epi8('.');
+    const __m256i dash = _mm256_set1_epi8('-');
+    const __m256i space = _mm256_set1_epi8(' ');
+    BlockMasks m{0, 0, 0};
+    for (unsigned k = 0; k < 64; k += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + k));
+        const __m256i d = _mm256_sub_epi8(v, zero);
+        const __m256i digits = _mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d);
+        const __m256i seps = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, dot), _mm256_cmpeq_epi8(v, dash)), _mm256_cmpeq_epi8(v, space));
+        m.digit |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(digits))) << k;
+        m.at |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, at)))) << k;
+        m.sep |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(seps))) << k;
+    }
+    return m;
+}
+
+#elif defined(XLOG_PII_NEON)
+
+// NEON has no movemask: weight each lane by its bit and add pairwise.
+inline uint64_t neon_movemask64(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d) {
+    const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t s0 = vpaddq_u8(vandq_u8(a, weights), vandq_u8(b, weights));
+    uint8x16_t s1 = vpaddq_u8(vandq_u8(c, weights), vandq_u8(d, weights));
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+
+BlockMasks classify_neon(const char* p) {
+    const uint8x16_t at = vdupq_n_u8('@');
+    const uint8x16_t zero = vdupq_n_u8('0');
+    const uint8x16_t ten = vdupq_n_u8(10);
+    const uint8x16_t dot = vdupq_n_u8('.');
+    const uint8x16_t dash = vdupq_n_u8('-');
+    const uint8x16_t space = vdupq_n_u8(' ');
+    uint8x16_t v[4];
+    uint8x16_t seps[4];
+    for (unsigned k = 0; k < 4; ++k) {
+        v[k] = vld1q_u8(reinterpret_cast<const uint8_t*>(p + k * 16));
+        seps[k] = vorrq_u8(vorrq_u8(vceqq_u8(v[k], dot), vceqq_u8(v[k], dash)), vceqq_u8(v[k], space));
+    }
+    BlockMasks m;
+    m.digit = neon_movemask64(vcltq_u8(vsubq_u8(v[0], zero), ten), vcltq_u8(vsubq_u8(v[1], zero), ten),
+                              vcltq_u8(vsubq_u8(v[2], zero), ten), vcltq_u8(vsubq_u8(v[3], zero), ten));
+    m.at = neon_movemask64(vceqq_u8(v[0], at), vceqq_u8(v[1], at), vceqq_u8(v[2], at), vceqq_u8(v[3], at));
+    m.sep = neon_movemask64(seps[0], seps[1], seps[2], seps[3]);
+    return m;
+}
+
+#endif
+
+struct Kernel {
+    ClassifyFn classify;
+    const char* name;
+};
+
+Kernel select_kernel() {
+#if defined(XLOG_PII_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {classify_avx2, "avx2"};
+    }
+    return {classify_sse2, "sse2"};
+#elif defined(XLOG_PII_NEON)
+    return {classify_neon, "neon"};
+#else
+    return {classify_scalar, "scalar"};
+#endif
+}
+
+const Kernel& kernel() {
+    static const Kernel k = select_kernel();
+    return k;
+}
+
+// ---------------------------------------------------------------------------
+// Validators. Each is called with pos on a candidate byte and returns the
+// end of the match, or 0 (no match can end at offset 0).
+// ---------------------------------------------------------------------------
+
+// pos is on '@'; begin receives the start of the local part. Mirrors
+// [A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\.[A-Za-z]{2,} with the regex's backtracking:
+// the match ends after the last ".letters{2,}" run inside the domain.
+size_t match_email(std::string_view s, size_t pos, size_t floor, size_t& begin) {
+    size_t b = pos;
+    while (b > floor && is_email_local(static_cast<unsigned char>(s[b - 1]))) {
+        --b;
+    }
+    if (b == pos) {
+        return 0;
+    }
+    size_t domain_end = pos + 1;
+    while (domain_end < s.size() && is_email_domain(static_cast<unsigned char>(s[domain_end]))) {
+        ++domain_end;
+    }
+    size_t end = 0;
+    for (size_t dot = pos + 2; dot < domain_end; ++dot) {
+        if (s[dot] != '.') {
+            continue;
+        }
+        size_t tld_end = dot + 1;
+        while (tld_end < domain_end && is_alpha(static_cast<unsigned char>(s[tld_end]))) {
+            ++tld_end;
+        }
+        if (tld_end - dot - 1 >= 2) {
+            end = tld_end;
+        }
+    }
+    if (end != 0) {
+        begin = b;
+    }
+    return end;
+}
+
+// pos is on the first digit of a run. Four octets 0-255 separated by '.',
+// with no digit or ".digit" continuing the run on either side.
+size_t match_ipv4(std::string_view s, size_t pos) {
+    if (pos >= 2 && s[pos - 1] == '.' && is_digit(static_cast<unsigned char>(s[pos - 2]))) {
+        return 0;
+    }
+    size_t i = pos;
+    for (int octet = 0; octet < 4; ++octet) {
+        if (octet > 0) {
+            if (i >= s.size() || s[i] != '.') {
+                return 0;
+            }
+            ++i;
+        }
+        unsigned value = 0;
+        size_t digits = 0;
+        while (i < s.size() && is_digit(static_cast<unsigned char>(s[i]))) {
+            if (++digits > 3) {
+                return 0;
+            }
+            value = value * 10 + static_cast<unsigned>(s[i] - '0');
+            ++i;
+        }
+        if (digits == 0 || value > 255) {
+            return 0;
+        }
+    }
+    if (i + 1 < s.size() && s[i] == '.' && is_digit(static_cast<unsigned char>(s[i + 1]))) {
+        return 0;
+    }
+    return i;
+}
+
+// pos is on the first digit of a run at a word boundary: ddd-dd-dddd\b
+size_t match_ssn(std::string_view s, size_t pos) {
+    if (pos + 11 > s.size()) {
+        return 0;
+    }
+    const char* p = s.data() + pos;
+    for (size_t k : {0, 1, 2, 4, 5, 7, 8, 9, 10}) {
+        if (!is_digit(static_cast<unsigned char>(p[k]))) {
+            return 0;
+        }
+    }
+    if (p[3] != '-' || p[6] != '-') {
+        return 0;
+    }
+    const size_t end = pos + 11;
+    if (end < s.size() && is_word(static_cast<unsigned char>(s[end]))) {
+        return 0;
+    }
+    return end;
+}
+
+bool luhn_valid(const uint8_t* digits, size_t count) {
+    unsigned sum = 0;
+    bool dbl = false;
+    for (size_t k = count; k-- > 0;) {
+        unsigned d = digits[k];
+        if (dbl) {
+            d *= 2;
+            if (d > 9) {
+                d -= 9;
+            }
+        }
+        sum += d;
+        dbl = !dbl;
+    }
+    return sum % 10 == 0;
+}
+
+// pos is on the first digit of a run at a word boundary. Up to 16 digits,
+// optionally separated by runs of ' ' or '-'; the longest 13-16 digit prefix
+// that ends on a word boundary and passes Luhn wins.
+size_t match_credit_card(std::string_view s, size_t pos) {
+    uint8_t digits[16];
+    size_t ends[16];
+    size_t count = 0;
+    size_t i = pos;
+    while (i < s.size() && count < 16) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        if (is_digit(c)) {
+            digits[count] = static_cast<uint8_t>(c - '0');
+            ends[count++] = ++i;
+            continue;
+        }
+        if (c != ' ' && c != '-') {
+            break;
+        }
+        size_t j = i;
+        while (j < s.size() && (s[j] == ' ' || s[j] == '-')) {
+            ++j;
+        }
+        if (j == s.size() || !is_digit(static_cast<unsigned char>(s[j]))) {
+            break;
+        }
+        i = j;
+    }
+    for (size_t n = count; n >= 13; --n) {
+        const size_t end = ends[n - 1];
+        if (end < s.size() && is_word(static_cast<unsigned char>(s[end]))) {
+            continue;
+        }
+        if (luhn_valid(digits, n)) {
+            return end;
+        }
+    }
+    return 0;
+}
+
+// Digit runs worth validating: every match starts with a run followed by
+// '.', '-' or ' ', or with a long run of card digits. Marks each digit
+// whose run ends on such a separator (or is 8+ digits long) by smearing
+// the run ends back through the run, 8 digits at a time. A run reaching
+// the end of the block is kept, since it may continue into the next.
+inline uint64_t digit_run_filter(const BlockMasks& m) {
+    uint64_t keep = m.digit & ((m.sep >> 1) | (1ull << 63));
+    uint64_t run = m.digit;
+    keep |= (keep >> 1) & run;
+    run &= run >> 1;
+    keep |= (keep >> 2) & run;
+    run &= run >> 2;
+    keep |= (keep >> 4) & run;
+    run &= run >> 4;
+    return keep | run;
+}
+
+}
+
+uint32_t PiiDetector::kind_from_preset(const std::string& preset) {
+    std::string lower = preset;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "email") {
+        return PiiEmail;
+    }
+    if (lower == "ipv4") {
+        return PiiIpv4;
+    }
+    if (lower == "credit_card") {
+        return PiiCreditCard;
+    }
+    if (lower == "ssn") {
+        return PiiSsn;
+    }
+    return 0;
+}
+
+const char* PiiDetector::kernel_name() {
+    return kernel().name;
+}
+
+bool PiiDetector::find(std::string_view text, std::vector<Span>& spans) const {
+    const size_t first = spans.size();
+    if (kinds_ == 0) {
+        return false;
+    }
+    const bool want_at = (kinds_ & PiiEmail) != 0;
+    const bool want_digit = (kinds_ & (PiiIpv4 | PiiCreditCard | PiiSsn)) != 0;
+    const ClassifyFn classify = kernel().classify;
+    const char* p = text.data();
+    const size_t n = text.size();
+
+    // Candidates are '@' and the first digit of each run that could start a
+    // match; the rest of a run never does. An email's local part can reach back over a
+    // previous span, so overlaps are merged at the end.
+    size_t resume = 0;
+    uint64_t prev_digit = 0;
+    for (size_t base = 0; base < n; base += 64) {
+        BlockMasks m;
+        if (n - base >= 64) {
+            m = classify(p + base);
+        } else {
+            char tail[64] = {};
+            std::memcpy(tail, p + base, n - base);
+            m = classify(tail);
+        }
+        uint64_t candidates = 0;
+        if (want_digit) {
+            candidates |= m.digit & ~((m.digit << 1) | prev_digit) & digit_run_filter(m);
+        }
+        if (want_at) {
+            candidates |= m.at;
+        }
+        prev_digit = m.digit >> 63;
+
+        while (candidates != 0) {
+            const size_t pos = base + static_cast<size_t>(__builtin_ctzll(candidates));
+            candidates &= candidates - 1;
+            if (pos < resume) {
+                continue;
+            }
+            size_t begin = pos;
+            size_t end = 0;
+            if (p[pos] == '@') {
+                end = match_email(text, pos, resume, begin);
+            } else {
+                const bool boundary = pos == 0 || !is_word(static_cast<unsigned char>(p[pos - 1]));
+                if (boundary && (kinds_ & PiiSsn)) {
+                    end = match_ssn(text, pos);
+                }
+                if (end == 0 && boundary && (kinds_ & PiiCreditCard)) {
+                    end = match_credit_card(text, pos);
+                }
+                if (end == 0 && (kinds_ & PiiIpv4)) {
+                    end = match_ipv4(text, pos);
+                }
+            }
+            if (end != 0) {
+                spans.emplace_back(begin, end);
+                resume = end;
+            }
+        }
+    }
+
+    if (spans.size() - first > 1) {
+        std::sort(spans.begin() + static_cast<std::ptrdiff_t>(first), spans.end());
+        size_t out = first;
+        for (size_t k = first + 1; k < spans.size(); ++k) {
+            if (spans[k].first < spans[out].second) {
+                spans[out].second = std::max(spans[out].second, spans[k].second);
+            } else {
+                spans[++out] = spans[k];
+            }
+        }
+        spans.resize(out + 1);
+    }
+    return spans.size() > first;
+}
+
+}
@@ -3,13 +3,79 @@
 
 namespace Zyrnix {
 
+namespace {
+
+constexpr uint64_t ticks_per_second = 16'000'000'000ull;  // Fixed point, 1/16 ns
+
+std::atomic<uint64_t> next_generation{1};
+
+// Credits a thread has claimed, for the one limiter it used last
+struct CreditCache {
+    const void* owner = nullptr;
+    uint64_t generation = 0;
+    size_t credits = 0;
+};
+
+thread_local CreditCache credit_cache;
+
+}
+
 RateLimiter::RateLimiter(size_t messages_per_second, size_t burst_capacity)
-    : max_tokens_(burst_capacity > 0 ? burst_capacity : messages_per_second)
-    , refill_rate_(messages_per_second)
-    , tokens_(static_cast<double>(max_tokens_))
-    , last_refill_(std::chrono::steady_clock::now())
-    , dropped_count_(0)
+    : RateLimiter(RateLimiterOptions{messages_per_second, burst_capacity, 1}) {}
+
+RateLimiter::RateLimiter(const RateLimiterOptions& options)
+    : max_tokens_(options.burst_capacity > 0 ? options.burst_capacity : options.messages_per_second)
+    , refill_rate_(options.messages_per_second)
+    , credit_chunk_(std::max<size_t>(options.credit_chunk, 1))
+    , epoch_ns_(monotonic_coarse_ns())
+    , generation_(next_generation.fetch_add(1, std::memory_order_relaxed))
 {
+    // Without a refill rate time stands still and the burst is all there is
+    interval_ = refill_rate_ > 0 ? std::max<uint64_t>(ticks_per_second / refill_rate_, 1) : 1;
+    tolerance_ = max_tokens_ <= UINT64_MAX / 4 / interval_ ? max_tokens_ * interval_ : UINT64_MAX / 4;
+}
+
+uint64_t RateLimiter::now_ticks() const {
+    if (refill_rate_ == 0) {
+        return 0;
+    }
+    return (monotonic_coarse_ns() - epoch_ns_) * 16;
+}
+
+size_t RateLimiter::acquire(size_t wanted) {
+    const uint64_t now = now_ticks();
+    uint64_t full_at = full_at_.load(std::memory_order_relaxed);
+    for (;;) {
+        // A bucket that filled up in the past is simply full now
+        const uint64_t start = std::max(full_at, now);
+        const uint64_t headroom = tolerance_ - std::min(start - now, tolerance_);
+        const size_t granted = static_cast<size_t>(std::min<uint64_t>(headroom / interval_, wanted));
+        if (granted == 0) {
+            return 0;
+        }
+        if (full_at_.compare_exchange_weak(full_at, start + granted * interval_,
+                                           std::memory_order_relaxed, std::memory_order_relaxed)) {
+            return granted;
+        }
+    }
+}
+
+bool RateLimiter::try_log_cached() {
+    CreditCache& cache = credit_cache;
+    const uint64_t generation = generation_.load(std::memory_order_relaxed);
+    if (cache.owner == this && cache.generation == generation && cache.credits > 0) {
+        --cache.credits;
+        return true;
+    }
+    const size_t granted = acquire(credit_chunk_);
+    if (granted == 0) {
+        return false;
+    }
+    // Credits left over for another limiter are given up
+    cache.owner = this;
+    cache.generation = generation;
+    cache.credits = granted - 1;
+    return true;
 }
 
 bool RateLimiter::try_log() {
@@ -17,12 +83,7 @@ bool RateLimiter::try_log() {
         return true;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    refill_tokens();
-
-    double current = tokens_.load(std::memory_order_relaxed);
-    if (current >= 1.0) {
-        tokens_.store(current - 1.0, std::memory_order_relaxed);
+    if (credit_chunk_ > 1 ? try_log_cached() : acquire(1) == 1) {
         return true;
     }
 
@@ -30,28 +91,27 @@ bool RateLimiter::try_log() {
     return false;
 }
 
-void RateLimiter::refill_tokens() {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_refill_).count();
-    
-    if (elapsed > 0) {
-        double tokens_to_add = (refill_rate_ * elapsed) / 1000.0;
-        double current = tokens_.load(std::memory_order_relaxed);
-        double new_tokens = std::min(current + tokens_to_add, static_cast<double>(max_tokens_));
-        tokens_.store(new_tokens, std::memory_order_relaxed);
-        last_refill_ = now;
+size_t RateLimiter::try_log_many(size_t count) {
+    if (!is_enabled() || count == 0) {
+        return count;
+    }
+    const size_t granted = acquire(count);
+    if (granted < count) {
+        dropped_count_.fetch_add(count - granted, std::memory_order_relaxed);
     }
+    return granted;
 }
 
 void RateLimiter::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    tokens_.store(static_cast<double>(max_tokens_), std::memory_order_relaxed);
+    generation_.store(next_generation.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    full_at_.store(now_ticks(), std::memory_order_relaxed);
     dropped_count_.store(0, std::memory_order_relaxed);
-    last_refill_ = std::chrono::steady_clock::now();
 }
 
 size_t RateLimiter::available_tokens() const {
-    return static_cast<size_t>(tokens_.load(std::memory_order_relaxed));
+    const uint64_t now = now_ticks();
+    const uint64_t start = std::max(full_at_.load(std::memory_order_relaxed), now);
+    return static_cast<size_t>((tolerance_ - std::min(start - now, tolerance_)) / interval_);
 }
 
 SamplingLimiter::SamplingLimiter(size_t sample_rate)
@@ -0,0 +1,127 @@
+#include "Zyrnix/rcu.hpp"
+#include <chrono>
+#include <thread>
+
+namespace Zyrnix {
+
+// Owns the calling thread's slot and hands it back when the thread exits
+struct EpochDomain::ThreadSlot {
+    Slot* slot = nullptr;
+
+    ~ThreadSlot() {
+        if (slot) {
+            EpochDomain::instance().release_slot(slot);
+        }
+    }
+};
+
+EpochDomain& EpochDomain::instance() {
+    // Never destroyed, so threads that exit during static destruction can
+    // still release their slot.
+    static EpochDomain* domain = new EpochDomain();
+    return *domain;
+}
+
+EpochDomain::Slot* EpochDomain::local_slot() {
+    thread_local ThreadSlot local;
+    if (!local.slot) {
+        local.slot = instance().acquire_slot();
+    }
+    return local.slot;
+}
+
+EpochDomain::Slot* EpochDomain::acquire_slot() {
+    std::lock_guard<std::mutex> lock(slots_mtx_);
+    for (auto& slot : slots_) {
+        bool expected = false;
+        if (slot->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return slot.get();
+        }
+    }
+    slots_.push_back(std::make_unique<Slot>());
+    slots_.back()->in_use.store(true, std::memory_order_release);
+    return slots_.back().get();
+}
+
+void EpochDomain::release_slot(Slot* slot) {
+    slot->depth = 0;
+    slot->epoch.store(0, std::memory_order_release);
+    slot->in_use.store(false, std::memory_order_release);
+}
+
+EpochDomain::ReadGuard::ReadGuard() {
+    Slot* slot = local_slot();
+    if (slot->depth++ == 0) {
+        slot->epoch.store(instance().epoch_.load(std::memory_order_acquire),
+                          std::memory_order_relaxed);
+        // Pairs with the fence in advance(): either the writer sees this
+        // slot, or this reader sees the writer's new pointer.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+EpochDomain::ReadGuard::~ReadGuard() {
+    Slot* slot = local_slot();
+    if (--slot->depth == 0) {
+        slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+bool EpochDomain::in_read_section() const {
+    return local_slot()->depth > 0;
+}
+
+uint64_t EpochDomain::advance() {
+    const uint64_t target = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return target;
+}
+
+bool EpochDomain::has_passed(uint64_t target) const {
+    std::lock_guard<std::mutex> lock(slots_mtx_);
+    for (const auto& slot : slots_) {
+        const uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < target) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EpochDomain::synchronize() {
+    wait_for(advance());
+}
+
+void EpochDomain::wait_for(uint64_t target) {
+    // Copy the slot list so threads can register while we wait; slots are
+    // never freed, only reused.
+    std::vector<Slot*> slots;
+    {
+        std::lock_guard<std::mutex> lock(slots_mtx_);
+        slots.reserve(slots_.size());
+        for (auto& slot : slots_) {
+            slots.push_back(slot.get());
+        }
+    }
+
+    // A caller inside its own read section cannot wait for itself
+    Slot* self = local_slot();
+    for (Slot* slot : slots) {
+        if (slot == self) {
+            continue;
+        }
+        for (size_t round = 0;; ++round) {
+            const uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+            if (epoch == 0 || epoch >= target) {
+                break;
+            }
+            if (round < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,151 @@
+#include "Zyrnix/redaction.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace Zyrnix {
+
+std::string Redactor::preset_pattern(const std::string& preset) {
+    std::string lower = preset;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "email") {
+        return "[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\\.[A-Za-z]{2,}";
+    }
+    if (lower == "ipv4") {
+        return "(25[0-5]|2[0-4]\\d|[01]?\\d?\\d)(\\.(25[0-5]|2[0-4]\\d|[01]?\\d?\\d)){3}";
+    }
+    if (lower == "credit_card") {
+        return "\\b(?:\\d[ -]*?){13,16}\\b";
+    }
+    if (lower == "ssn") {
+        return "\\b\\d{3}-\\d{2}-\\d{4}\\b";
+    }
+    return "";
+}
+
+Redactor::Redactor(const std::vector<std::string>& substr_patterns,
+                   const std::vector<std::string>& regex_patterns,
+                   const std::vector<std::string>& pii_presets,
+                   bool cloud_only)
+    : substrings_(substr_patterns)
+    , cloud_only_(cloud_only)
+{
+    uint32_t kinds = 0;
+    for (const auto& preset : pii_presets) {
+        kinds |= PiiDetector::kind_from_preset(preset);
+    }
+    pii_ = PiiDetector(kinds);
+
+    // Validate each pattern on its own so one bad pattern does not
+    // disable the rest; invalid ones are ignored as before.
+    std::vector<std::string> sources;
+    std::vector<std::regex> separate;
+    auto add = [&](const std::string& source) {
+        if (source.empty()) {
+            return;
+        }
+        try {
+            separate.emplace_back(source, std::regex::ECMAScript);
+            sources.push_back(source);
+        } catch (...) {
+        }
+    };
+    for (const auto& pat : regex_patterns) {
+        add(pat);
+    }
+
+    if (sources.size() <= 1) {
+        regexes_ = std::move(separate);
+        return;
+    }
+
+    std::string merged;
+    for (const auto& source : sources) {
+        if (!merged.empty()) {
+            merged += '|';
+        }
+        merged += "(?:" + source + ")";
+    }
+    try {
+        regexes_.emplace_back(merged, std::regex::ECMAScript | std::regex::optimize);
+    } catch (...) {
+        // e.g. back-references that no longer line up once merged
+        regexes_ = std::move(separate);
+    }
+}
+
+bool Redactor::redact_regexes(std::string_view in, std::string& out) const {
+    bool changed = false;
+    std::string_view current = in;
+    std::string buffer;
+    for (const auto& rx : regexes_) {
+        const char* begin = current.data();
+        const char* finish = current.data() + current.size();
+        auto it = std::cregex_iterator(begin, finish, rx);
+        const auto end = std::cregex_iterator();
+        if (it == end) {
+            continue;
+        }
+        buffer.clear();
+        buffer.reserve(current.size());
+        const char* last = begin;
+        for (; it != end; ++it) {
+            const auto& match = (*it)[0];
+            if (match.length() == 0) {
+                continue;
+            }
+            buffer.append(last, match.first);
+            buffer += "***";
+            last = match.second;
+            changed = true;
+        }
+        buffer.append(last, finish);
+        out.swap(buffer);
+        current = out;
+    }
+    return changed;
+}
+
+// Writes into out directly so a caller reusing out keeps its capacity;
+// in must not alias out.
+bool Redactor::redact_pii(std::string_view in, std::string& out) const {
+    thread_local std::vector<PiiDetector::Span> spans;
+    spans.clear();
+    if (!pii_.find(in, spans)) {
+        return false;
+    }
+    out.clear();
+    out.reserve(in.size());
+    size_t last = 0;
+    for (const auto& span : spans) {
+        out.append(in.substr(last, span.first - last));
+        out += "***";
+        last = span.second;
+    }
+    out.append(in.substr(last));
+    return true;
+}
+
+bool Redactor::redact(std::string_view message, std::string& out) const {
+    std::string substituted;
+    bool changed = substrings_.mask(message, substituted);
+    std::string regex_out;
+    if (!regexes_.empty() && redact_regexes(changed ? substituted : message, regex_out)) {
+        substituted.swap(regex_out);
+        changed = true;
+    }
+    // PII detection runs last and writes the final result itself
+    if (!pii_.empty() && redact_pii(changed ? substituted : message, out)) {
+        return true;
+    }
+    if (changed) {
+        out = std::move(substituted);
+    }
+    return changed;
+}
+
+std::string Redactor::apply(const std::string& message) const {
+    std::string out;
+    return redact(message, out) ? out : message;
+}
+
+}
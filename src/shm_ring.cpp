@@ -0,0 +1,156 @@
+#include "Zyrnix/shm_ring.hpp"
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+namespace Zyrnix {
+namespace shmring {
+
+namespace {
+
+// Shared (not FUTEX_PRIVATE_FLAG): the word is woken from other processes
+long futex(std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, value, timeout, nullptr, 0);
+}
+
+uint64_t load_commit(const char* entry) {
+    return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(const_cast<char*>(entry)))
+        .load(std::memory_order_acquire);
+}
+
+}
+
+void notify(Header& header) {
+    // Pairs with the reader's fence between raising the flag and looking
+    // at the ring once more, so either it sees the entry or we see the flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header.reader_waiting.load(std::memory_order_relaxed) != 0 &&
+        header.reader_waiting.exchange(0, std::memory_order_relaxed) != 0) {
+        header.wake_seq.fetch_add(1, std::memory_order_release);
+        futex(header.wake_seq, FUTEX_WAKE, 1, nullptr);
+    }
+}
+
+Reader::Reader(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) <= header_size) {
+        ::close(fd);
+        return;
+    }
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    auto* header = static_cast<Header*>(map);
+    const uint64_t capacity = header->capacity;
+    if (header->version.load(std::memory_order_acquire) != format_version ||
+        std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->header_size != header_size ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        header_size + capacity > static_cast<uint64_t>(st.st_size)) {
+        munmap(map, static_cast<size_t>(st.st_size));
+        return;
+    }
+    header_ = header;
+    data_ = static_cast<char*>(map) + header_size;
+    mapped_size_ = static_cast<size_t>(st.st_size);
+    mask_ = capacity - 1;
+}
+
+Reader::~Reader() {
+    if (header_) {
+        munmap(header_, mapped_size_);
+    }
+}
+
+bool Reader::peek(std::string_view& payload) {
+    if (!header_) {
+        return false;
+    }
+    for (;;) {
+        const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        const char* entry = data_ + (tail & mask_);
+        if (load_commit(entry) != tail + 1) {
+            return false;
+        }
+        uint32_t size;
+        uint32_t kind;
+        std::memcpy(&size, entry + 8, sizeof(size));
+        std::memcpy(&kind, entry + 12, sizeof(kind));
+        entry_size_ = (entry_header_size + size + entry_alignment - 1) & ~(entry_alignment - 1);
+        if (static_cast<EntryKind>(kind) == EntryKind::Data) {
+            payload = std::string_view(entry + entry_header_size, size);
+            return true;
+        }
+        pop();
+    }
+}
+
+void Reader::pop() {
+    const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    // Zeroed, so no commit word of an earlier lap is left for a later one
+    // to be mistaken for
+    std::memset(data_ + (tail & mask_), 0, entry_size_);
+    header_->tail.store(tail + entry_size_, std::memory_order_release);
+}
+
+bool Reader::wait(std::chrono::milliseconds timeout) {
+    if (!header_) {
+        return false;
+    }
+    const auto ready = [this] {
+        const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        return load_commit(data_ + (tail & mask_)) == tail + 1;
+    };
+    const uint32_t seq = header_->wake_seq.load(std::memory_order_acquire);
+    header_->reader_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ready() && header_->closed.load(std::memory_order_relaxed) == 0) {
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        ts.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000;
+        futex(header_->wake_seq, FUTEX_WAIT, seq, &ts);
+    }
+    header_->reader_waiting.store(0, std::memory_order_relaxed);
+    return ready();
+}
+
+bool Reader::finished() const {
+    if (!header_) {
+        return true;
+    }
+    const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    if (load_commit(data_ + (tail & mask_)) == tail + 1) {
+        return false;
+    }
+    if (header_->closed.load(std::memory_order_acquire) != 0) {
+        // Closing comes after the last commit
+        return load_commit(data_ + (tail & mask_)) != tail + 1;
+    }
+    return ::kill(header_->owner_pid, 0) != 0 && errno == ESRCH;
+}
+
+uint64_t Reader::dropped() const {
+    return header_ ? header_->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+int Reader::owner_pid() const {
+    return header_ ? header_->owner_pid : 0;
+}
+
+}
+}
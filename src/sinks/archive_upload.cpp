@@ -0,0 +1,461 @@
+#include "Zyrnix/sinks/archive_upload.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <strings.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Zyrnix {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::string_view state_suffix = ".upload";
+constexpr std::string_view temporary_suffix = ".tmp";
+
+bool ends_with(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// RFC 3986 unreserved characters stay, and so do the slashes of the key
+std::string encode_key(std::string_view key) {
+    static constexpr char hex[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : key) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' ||
+            c == '.' || c == '~' || c == '/') {
+            out.push_back(static_cast<char>(c));
+        } else {
+            out.push_back('%');
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 15]);
+        }
+    }
+    return out;
+}
+
+bool ok(const HttpResponse& response) {
+    return response.success && response.status_code >= 200 && response.status_code < 300;
+}
+
+std::string header_value(const HttpResponse& response, std::string_view name) {
+    for (const auto& header : response.headers) {
+        const size_t colon = header.find(':');
+        if (colon == name.size() && strncasecmp(header.data(), name.data(), name.size()) == 0) {
+            size_t start = colon + 1;
+            while (start < header.size() && header[start] == ' ') ++start;
+            return header.substr(start);
+        }
+    }
+    return {};
+}
+
+std::string xml_element(const std::string& body, std::string_view name) {
+    const std::string open = "<" + std::string(name) + ">";
+    const size_t start = body.find(open);
+    if (start == std::string::npos) {
+        return {};
+    }
+    const size_t end = body.find("</" + std::string(name) + ">", start);
+    if (end == std::string::npos) {
+        return {};
+    }
+    return body.substr(start + open.size(), end - start - open.size());
+}
+
+bool read_range(const std::string& path, uint64_t offset, size_t size, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    out.resize(size);
+    in.seekg(static_cast<std::streamoff>(offset));
+    return in.read(out.data(), static_cast<std::streamsize>(size)) && static_cast<size_t>(in.gcount()) == size;
+}
+
+// Disk time only when no one else wants it, and the lowest CPU priority
+void lower_priority() {
+#ifdef __linux__
+    const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    setpriority(PRIO_PROCESS, tid, 19);
+    constexpr int ioprio_who_process = 1;
+    constexpr int ioprio_class_idle = 3;
+    syscall(SYS_ioprio_set, ioprio_who_process, static_cast<int>(tid), ioprio_class_idle << 13);
+#endif
+}
+
+// The parts of one multipart upload, filled in by completions on the
+// HttpTransport thread
+struct Parts {
+    std::map<int, std::string> etags;
+    std::vector<std::pair<int, std::string>> unsaved;  // Finished, not yet in the state file
+    bool failed = false;
+    bool gone = false;  // The service no longer knows the upload id
+};
+
+}
+
+ArchiveUploader::ArchiveUploader(const ArchiveUploadOptions& options) : options_(options) {
+    options_.part_size = std::max<size_t>(options_.part_size, 5 * 1024 * 1024);
+    options_.max_in_flight = std::max<size_t>(options_.max_in_flight, 1);
+    object_base_ = options_.endpoint;
+    while (!object_base_.empty() && object_base_.back() == '/') object_base_.pop_back();
+    object_base_ += "/";
+    if (!options_.bucket.empty()) {
+        object_base_ += options_.bucket + "/";
+    }
+    object_base_ += encode_key(options_.prefix);
+    std::error_code ec;
+    fs::create_directories(options_.spool_directory, ec);
+    thread_ = std::thread([this] { run(); });
+}
+
+ArchiveUploader::~ArchiveUploader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    done_cv_.notify_all();
+    thread_.join();
+}
+
+bool ArchiveUploader::add(const std::string& path, const std::string& name) {
+    const fs::path target = fs::path(options_.spool_directory) / name;
+    std::error_code ec;
+    if (fs::exists(target, ec)) {
+        return false;
+    }
+    fs::rename(path, target, ec);
+    if (ec) {
+        // Not the same filesystem after all: copy, then let go of the original
+        if (!add_copy(path, name)) {
+            return false;
+        }
+        fs::remove(path, ec);
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        added_ = true;
+        idle_ = false;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+bool ArchiveUploader::add_copy(const std::string& path, const std::string& name) {
+    const fs::path target = fs::path(options_.spool_directory) / name;
+    const fs::path temporary = target.string() + std::string(temporary_suffix);
+    std::error_code ec;
+    if (fs::exists(target, ec)) {
+        return false;
+    }
+    // Through a temporary name, so a scan never sees half a file
+    if (!fs::copy_file(path, temporary, fs::copy_options::overwrite_existing, ec)) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    fs::rename(temporary, target, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        added_ = true;
+        idle_ = false;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+bool ArchiveUploader::wait_idle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return done_cv_.wait_for(lock, timeout, [this] { return idle_ || stopping_; }) && idle_;
+}
+
+ArchiveUploader::Stats ArchiveUploader::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{files_uploaded_.load(std::memory_order_relaxed), bytes_uploaded_.load(std::memory_order_relaxed),
+                 parts_uploaded_.load(std::memory_order_relaxed), failures_.load(std::memory_order_relaxed), pending_};
+}
+
+// Names in the spool to upload, oldest first: the sinks name files by
+// time, and a file sorts before the .idx and .meta that go with it
+std::vector<std::string> ArchiveUploader::scan() const {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (fs::directory_iterator it(options_.spool_directory, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        if (!it->is_regular_file(ec) || ends_with(name, state_suffix) || ends_with(name, temporary_suffix)) {
+            continue;
+        }
+        names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void ArchiveUploader::run() {
+    init_background_thread("xlog-upload");
+    if (options_.low_priority) {
+        lower_priority();
+    }
+    int backoff = 1;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        added_ = false;
+        lock.unlock();
+        const std::vector<std::string> names = scan();
+        lock.lock();
+        pending_ = names.size();
+        if (names.empty()) {
+            if (!added_) {
+                idle_ = true;
+                done_cv_.notify_all();
+                cv_.wait(lock, [this] { return stopping_ || added_; });
+            }
+            continue;
+        }
+
+        bool failed = false;
+        for (const std::string& name : names) {
+            if (stopping_) break;
+            lock.unlock();
+            const bool uploaded = upload(name);
+            lock.lock();
+            if (!uploaded) {
+                failed = true;
+                break;
+            }
+            --pending_;
+        }
+        if (failed && !stopping_) {
+            // Most failures are the endpoint's or the network's, so the
+            // whole spool waits rather than each file trying in turn
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            cv_.wait_for(lock, options_.retry_delay * backoff, [this] { return stopping_; });
+            backoff = std::min(backoff * 2, 16);
+        } else {
+            backoff = 1;
+        }
+    }
+}
+
+HttpRequest ArchiveUploader::make_request(const std::string& method, const std::string& url, std::string body) const {
+    HttpRequest request;
+    request.url = url;
+    request.method = method;
+    request.body = std::move(body);
+    request.headers = options_.headers;
+    if (!options_.session_token.empty()) {
+        request.headers.push_back("x-amz-security-token: " + options_.session_token);
+    }
+    if (!options_.access_key_id.empty()) {
+        request.aws_sigv4 = "aws:amz:" + options_.region + ":s3";
+        request.credentials = options_.access_key_id + ":" + options_.secret_access_key;
+    }
+    request.timeout_ms = options_.request_timeout_ms;
+    request.max_attempts = options_.max_attempts;
+    request.retry_delay_ms = 1000;
+    request.insecure_skip_verify = options_.insecure_skip_verify;
+    request.ca_cert_path = options_.ca_cert_path;
+    request.capture_headers = true;
+    if (options_.max_bytes_per_second > 0) {
+        request.max_send_speed = static_cast<long>(
+            std::max<uint64_t>(options_.max_bytes_per_second / options_.max_in_flight, 1));
+    }
+    return request;
+}
+
+HttpResponse ArchiveUploader::send(HttpRequest request) {
+    auto result = std::make_shared<std::pair<bool, HttpResponse>>();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++in_flight_;
+    }
+    HttpTransport::instance().submit(std::move(request), [this, result](const HttpResponse& response, int, HttpRequest&) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result->second = response;
+        result->first = true;
+        --in_flight_;
+        done_cv_.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&result] { return result->first; });
+    return std::move(result->second);
+}
+
+void ArchiveUploader::remove_spooled(const std::string& name) {
+    const fs::path path = fs::path(options_.spool_directory) / name;
+    std::error_code ec;
+    fs::remove(path, ec);
+    fs::remove(path.string() + std::string(state_suffix), ec);
+}
+
+bool ArchiveUploader::upload(const std::string& name) {
+    const std::string path = (fs::path(options_.spool_directory) / name).string();
+    std::error_code ec;
+    const uint64_t size = fs::file_size(path, ec);
+    if (ec) {
+        return true;  // Gone already
+    }
+    if (size > options_.part_size) {
+        return upload_multipart(name, path, size);
+    }
+    std::string body;
+    if (!read_range(path, 0, static_cast<size_t>(size), body)) {
+        std::cerr << "ArchiveUploader: cannot read " << path << std::endl;
+        return false;
+    }
+    const HttpResponse response = send(make_request("PUT", object_base_ + encode_key(name), std::move(body)));
+    if (!ok(response)) {
+        std::cerr << "ArchiveUploader: PUT " << name << " failed: "
+                  << (response.success ? "HTTP " + std::to_string(response.status_code) : response.error)
+                  << std::endl;
+        return false;
+    }
+    remove_spooled(name);
+    files_uploaded_.fetch_add(1, std::memory_order_relaxed);
+    bytes_uploaded_.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+// The state file is "upload_id <id>" and then a "part <n> <etag>" line per
+// finished part, appended as they finish
+bool ArchiveUploader::upload_multipart(const std::string& name, const std::string& path, uint64_t size) {
+    const std::string url = object_base_ + encode_key(name);
+    const std::string state_path = path + std::string(state_suffix);
+    auto parts = std::make_shared<Parts>();
+    std::string upload_id;
+    {
+        std::ifstream in(state_path);
+        std::string word;
+        while (in >> word) {
+            if (word == "upload_id") {
+                in >> upload_id;
+            } else if (word == "part") {
+                int number = 0;
+                std::string etag;
+                in >> number >> etag;
+                if (number > 0 && !etag.empty()) {
+                    parts->etags[number] = etag;
+                }
+            }
+        }
+    }
+    if (upload_id.empty()) {
+        parts->etags.clear();
+        const HttpResponse response = send(make_request("POST", url + "?uploads", {}));
+        upload_id = ok(response) ? xml_element(response.body, "UploadId") : std::string();
+        if (upload_id.empty()) {
+            std::cerr << "ArchiveUploader: cannot start the upload of " << name << ": "
+                      << (response.success ? "HTTP " + std::to_string(response.status_code) : response.error)
+                      << std::endl;
+            return false;
+        }
+        std::ofstream out(state_path, std::ios::trunc);
+        out << "upload_id " << upload_id << "\n";
+    }
+
+    std::ofstream state(state_path, std::ios::app);
+    auto save = [&] {
+        for (const auto& [number, etag] : parts->unsaved) {
+            state << "part " << number << " " << etag << "\n";
+        }
+        state.flush();
+        parts->unsaved.clear();
+    };
+    const int count = static_cast<int>((size + options_.part_size - 1) / options_.part_size);
+    for (int number = 1; number <= count; ++number) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait(lock, [this] { return in_flight_ < options_.max_in_flight; });
+            save();
+            if (parts->failed || parts->gone || stopping_) break;
+            if (parts->etags.count(number)) continue;
+            ++in_flight_;
+        }
+        const uint64_t offset = static_cast<uint64_t>(number - 1) * options_.part_size;
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(options_.part_size, size - offset));
+        std::string body;
+        if (!read_range(path, offset, length, body)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --in_flight_;
+            parts->failed = true;
+            std::cerr << "ArchiveUploader: cannot read " << path << std::endl;
+            break;
+        }
+        HttpRequest request = make_request(
+            "PUT", url + "?partNumber=" + std::to_string(number) + "&uploadId=" + upload_id, std::move(body));
+        HttpTransport::instance().submit(std::move(request), [this, parts, number, length](
+                                                                 const HttpResponse& response, int, HttpRequest&) {
+            const std::string etag = ok(response) ? header_value(response, "ETag") : std::string();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!etag.empty()) {
+                parts->etags[number] = etag;
+                parts->unsaved.emplace_back(number, etag);
+                parts_uploaded_.fetch_add(1, std::memory_order_relaxed);
+                bytes_uploaded_.fetch_add(length, std::memory_order_relaxed);
+            } else if (response.status_code == 404) {
+                parts->gone = true;
+            } else {
+                parts->failed = true;
+            }
+            --in_flight_;
+            done_cv_.notify_all();
+        });
+    }
+    {
+        // Parts are recorded as they finish, so a restart does not send
+        // them again
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (in_flight_ > 0) {
+            done_cv_.wait(lock, [this, &parts] { return in_flight_ == 0 || !parts->unsaved.empty(); });
+            save();
+        }
+        save();
+    }
+    state.close();
+    if (parts->gone) {
+        // Aborted or expired on the service's side: start over next time
+        std::error_code ec;
+        fs::remove(state_path, ec);
+        return false;
+    }
+    if (parts->failed || static_cast<int>(parts->etags.size()) < count) {
+        return false;
+    }
+
+    std::string body = "<CompleteMultipartUpload>";
+    for (const auto& [number, etag] : parts->etags) {
+        body += "<Part><PartNumber>" + std::to_string(number) + "</PartNumber><ETag>" + etag + "</ETag></Part>";
+    }
+    body += "</CompleteMultipartUpload>";
+    const HttpResponse response = send(make_request("POST", url + "?uploadId=" + upload_id, std::move(body)));
+    // S3 can answer 200 and still fail, with an <Error> in the body
+    if (!ok(response) || response.body.find("<Error>") != std::string::npos) {
+        std::cerr << "ArchiveUploader: cannot complete the upload of " << name << ": "
+                  << (response.success ? "HTTP " + std::to_string(response.status_code) : response.error)
+                  << std::endl;
+        if (response.status_code == 404) {
+            std::error_code ec;
+            fs::remove(state_path, ec);
+        }
+        return false;
+    }
+    remove_spooled(name);
+    files_uploaded_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+}
@@ -0,0 +1,103 @@
+#include "Zyrnix/sinks/async_log_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace Zyrnix {
+
+namespace {
+
+// The FormattedRecord does not outlive the call, and the write does
+LogRecord copy_record(const FormattedRecord& record) {
+    LogRecord copy;
+    copy.logger_name = record.logger_name();
+    copy.level = record.level();
+    copy.message = record.message();
+    copy.timestamp = record.timestamp();
+    copy.thread_id = record.thread_id();
+    copy.fields = record.fields();
+    copy.trace = record.trace();
+    copy.site = record.site();
+    return copy;
+}
+
+}
+
+AsyncLogSink::AsyncLogSink(const AsyncSinkOptions& options)
+    : options_(options), executor_(SinkExecutor::instance()) {
+    options_.max_in_flight = std::max<size_t>(options_.max_in_flight, 1);
+    options_.max_batch_size = std::max<size_t>(options_.max_batch_size, 1);
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    drain();
+}
+
+void AsyncLogSink::log(const std::string& logger_name, LogLevel lvl, const std::string& message) {
+    log_as_record(logger_name, lvl, message);
+}
+
+void AsyncLogSink::log_record(const FormattedRecord& record) {
+    std::vector<LogRecord> batch;
+    batch.push_back(copy_record(record));
+    start(std::move(batch));
+}
+
+void AsyncLogSink::log_batch(std::span<const FormattedRecord> records) {
+    while (!records.empty()) {
+        const size_t count = std::min(records.size(), options_.max_batch_size);
+        std::vector<LogRecord> batch;
+        batch.reserve(count);
+        for (const auto& record : records.first(count)) {
+            batch.push_back(copy_record(record));
+        }
+        start(std::move(batch));
+        records = records.subspan(count);
+    }
+}
+
+void AsyncLogSink::start(std::vector<LogRecord> batch) {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // The executor cannot wait for writes it has to run itself
+        if (!executor_.in_executor()) {
+            cv_.wait(lock, [this] { return in_flight_ < options_.max_in_flight; });
+        }
+        ++in_flight_;
+    }
+    run(this, write(std::move(batch)));
+}
+
+AsyncLogSink::Detached AsyncLogSink::run(AsyncLogSink* self, CoTask<void> task) {
+    co_await self->executor_.schedule();
+    try {
+        co_await task;
+    } catch (const std::exception& e) {
+        std::cerr << "AsyncLogSink: write failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "AsyncLogSink: write failed" << std::endl;
+    }
+    // Notified under the lock: once drain() can return, self may be gone
+    std::lock_guard<std::mutex> lock(self->mtx_);
+    --self->in_flight_;
+    self->cv_.notify_all();
+}
+
+void AsyncLogSink::flush() {
+    if (executor_.in_executor()) return;
+    drain();
+}
+
+void AsyncLogSink::drain() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+size_t AsyncLogSink::in_flight() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return in_flight_;
+}
+
+}
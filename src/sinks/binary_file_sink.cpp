@@ -0,0 +1,83 @@
+#include "Zyrnix/sinks/binary_file_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/util.hpp"
+#include <algorithm>
+
+namespace Zyrnix {
+
+BinaryFileSink::BinaryFileSink(const std::string& filename, const FlushPolicy& policy)
+    : policy_(policy), file_(policy.backend, policy.buffer_size) {
+    block_limit_ = std::max<size_t>(policy_.every_bytes > 0 ? std::min(policy_.every_bytes, policy_.buffer_size)
+                                                            : policy_.buffer_size, 1);
+    if (file_.open(filename) && file_.size() == 0) {
+        file_.write(binlog::file_magic, sizeof(binlog::file_magic));
+    }
+    BackgroundFlusher::instance().add(this, policy.interval);
+}
+
+BinaryFileSink::~BinaryFileSink() {
+    BackgroundFlusher::instance().remove(this);
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (file_.is_open()) {
+        write_block();
+        file_.close();
+    }
+}
+
+void BinaryFileSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    if (level < get_level()) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!file_.is_open()) return;
+    block_.add(LogClock::now(), level, current_thread_id(), logger_name, nullptr, message);
+    after_add(level);
+}
+
+void BinaryFileSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!file_.is_open()) return;
+    add(record);
+    after_add(record.level());
+}
+
+void BinaryFileSink::log_batch(std::span<const FormattedRecord> records) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!file_.is_open()) return;
+    for (const auto& record : records) {
+        if (record.level() < get_level()) continue;
+        add(record);
+        after_add(record.level());
+    }
+}
+
+void BinaryFileSink::add(const FormattedRecord& record) {
+    block_.add(record.timestamp(), record.level(), record.thread_id(), record.logger_name(), record.site(),
+               record.message(), record.fields());
+}
+
+void BinaryFileSink::after_add(LogLevel level) {
+    if (block_.size() >= block_limit_ || (policy_.flush_on && level >= *policy_.flush_on)) {
+        write_block();
+    }
+}
+
+void BinaryFileSink::write_block() {
+    if (block_.empty()) {
+        return;
+    }
+    out_.clear();
+    block_.finish(out_);
+    file_.write(out_.data(), static_cast<std::streamsize>(out_.size()));
+    file_.flush();
+}
+
+void BinaryFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (file_.is_open()) {
+        write_block();
+        file_.wait();
+    }
+}
+
+}
@@ -1,19 +1,42 @@
 #include "Zyrnix/sinks/cloud_sinks.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/crash_drain.hpp"
 #include "Zyrnix/log_record.hpp"
-#include <sstream>
-#include <iomanip>
+#include "Zyrnix/timestamp_cache.hpp"
+#include "Zyrnix/json_escape.hpp"
 #include <ctime>
 #include <algorithm>
 
-#ifdef XLOG_HAS_CURL
-#include <curl/curl.h>
-#endif
-
 namespace Zyrnix {
 
+namespace {
+
+// PutLogEvents counts each event as its UTF-8 message plus 26 bytes,
+// and takes at most 10,000 events and 256 KiB per event
+constexpr size_t cloudwatch_event_overhead = 26;
+constexpr size_t cloudwatch_max_events = 10000;
+constexpr size_t cloudwatch_max_event_bytes = 256 * 1024 - cloudwatch_event_overhead;
+
+// Application Insights keeps the first 32,768 characters of a message
+constexpr size_t azure_max_message_bytes = 32768;
+
+// Cut at a character boundary, so the JSON stays valid UTF-8
+std::string_view truncate_utf8(std::string_view text, size_t max_bytes) {
+    if (text.size() <= max_bytes) {
+        return text;
+    }
+    size_t end = max_bytes;
+    while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+        --end;
+    }
+    return text.substr(0, end);
+}
+
+}
 
 CloudWatchSink::CloudWatchSink(const Config& config)
     : config_(config)
+    , last_send_(std::chrono::steady_clock::now())
     , running_(true)
     , messages_sent_(0)
     , messages_failed_(0)
@@ -21,145 +44,249 @@ CloudWatchSink::CloudWatchSink(const Config& config)
     , batches_sent_(0)
     , retries_(0)
 {
-    worker_ = std::thread(&CloudWatchSink::worker_thread, this);
+    if (!config_.spill.directory.empty()) {
+        spill_ = std::make_unique<SpillQueue>(config_.spill);
+    }
+    HttpTransport::instance().attach(this);
+    crash_slot_ = crash::register_source(this, &CloudWatchSink::drain_for_crash);
 }
 
 CloudWatchSink::~CloudWatchSink() {
+    crash::unregister_source(crash_slot_);
+    // Send what is queued, then wait for the last completion before going
     running_ = false;
-    queue_cv_.notify_all();
-    if (worker_.joinable()) {
-        worker_.join();
+    HttpTransport::instance().wake();
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        flushed_cv_.wait(lock, [this] { return queue_.empty() && in_flight_ == 0; });
+    }
+    HttpTransport::instance().detach(this);
+    spill_.reset();  // Waits for a replay whose completion uses the stats
+}
+
+void CloudWatchSink::drain_for_crash(const void* source, CrashWriter& out) {
+    const auto& sink = *static_cast<const CloudWatchSink*>(source);
+    if (sink.queue_.empty()) {
+        return;
+    }
+    out.write("[CloudWatchSink] ");
+    out.write(sink.config_.log_group_name);
+    out.write("/");
+    out.write(sink.config_.log_stream_name);
+    out.write("\n");
+    // std::queue hides its deque; the adaptor's protected member is the
+    // only way to walk it without popping
+    struct Events : std::queue<LogEvent> {
+        static const container_type& of(const std::queue<LogEvent>& queue) {
+            return queue.*&Events::c;
+        }
+    };
+    for (const LogEvent& event : Events::of(sink.queue_)) {
+        out.write(event.json);
+        out.write("\n");
     }
 }
 
 void CloudWatchSink::log(const std::string& name, LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    
-    if (queue_.size() >= config_.max_queue_size) {
+    log_as_record(name, level, message);
+}
+
+void CloudWatchSink::log_record(const FormattedRecord& record) {
+    log_batch(std::span<const FormattedRecord>(&record, 1));
+}
+
+void CloudWatchSink::log_batch(std::span<const FormattedRecord> records) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        const bool was_empty = queue_.empty();
+        const bool was_ready = batch_ready();
+        for (const auto& record : records) {
+            push_event(record.formatted(formatter), record.level(), std::chrono::duration_cast<std::chrono::milliseconds>(
+                record.timestamp().time_since_epoch()
+            ).count());
+        }
+        wake = (was_empty && !queue_.empty()) || (!was_ready && batch_ready());
+    }
+    if (wake) {
+        HttpTransport::instance().wake();
+    }
+}
+
+void CloudWatchSink::push_event(std::string_view message, LogLevel level, int64_t timestamp_ms) {
+    message = truncate_utf8(message, cloudwatch_max_event_bytes);
+    if (queue_.size() >= config_.max_queue_size ||
+        !budget_.try_charge(level, message.size() + cloudwatch_event_overhead)) {
         messages_dropped_++;
         return;
     }
 
     LogEvent event;
-    event.message = formatter.format(name, level, message);
-    event.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()
-    ).count();
+    event.json.reserve(message.size() + 48);
+    event.json.append("{\"timestamp\":");
+    event.json.append(std::to_string(timestamp_ms));
+    event.json.append(",\"message\":");
+    json::append_string(event.json, message);
+    event.json.push_back('}');
+    event.size = message.size() + cloudwatch_event_overhead;
+
+    queued_bytes_ += event.size;
+    queue_.push(std::move(event));
+}
 
-    queue_.push(event);
-    queue_cv_.notify_one();
+size_t CloudWatchSink::batch_limit() const {
+    return std::clamp<size_t>(config_.batch_size, 1, cloudwatch_max_events);
+}
+
+bool CloudWatchSink::batch_ready() const {
+    return queue_.size() >= batch_limit() || queued_bytes_ >= config_.max_batch_bytes;
 }
 
 void CloudWatchSink::flush() {
-    while (true) {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (queue_.empty()) {
-            break;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // Ask for whatever is queued to be sent instead of waiting for
+    // batch_size or batch_timeout_ms, then wait until nothing is unsent.
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    ++flush_waiters_;
+    HttpTransport::instance().wake();
+    flushed_cv_.wait(lock, [this] {
+        return (queue_.empty() && in_flight_ == 0) || !running_;
+    });
+    --flush_waiters_;
+}
+
+std::chrono::steady_clock::time_point CloudWatchSink::pump(HttpTransport& transport) {
+    auto next = send_batch(transport);
+    if (spill_) {
+        next = std::min(next, spill_->replay(transport, base_request(), [this](const HttpResponse& response,
+                                                                                  uint32_t events) {
+            on_replayed(response, events);
+        }));
     }
+    return next;
 }
 
-void CloudWatchSink::worker_thread() {
+std::chrono::steady_clock::time_point CloudWatchSink::send_batch(HttpTransport& transport) {
+    const auto now = std::chrono::steady_clock::now();
+    const auto timeout = std::chrono::milliseconds(config_.batch_timeout_ms);
+    bool divert = false;
     std::vector<LogEvent> batch;
-    auto last_send = std::chrono::steady_clock::now();
-
-    while (running_) {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        
-        queue_cv_.wait_for(lock, std::chrono::milliseconds(100), [this] {
-            return !queue_.empty() || !running_;
-        });
-
-        if (!running_ && queue_.empty()) {
-            break;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (queue_.empty()) {
+            return std::chrono::steady_clock::time_point::max();
         }
-
-        while (!queue_.empty() && batch.size() < config_.batch_size) {
-            batch.push_back(queue_.front());
+        const bool due = flush_waiters_ > 0 || !running_ || batch_ready() || now - last_send_ >= timeout;
+        if (!due) {
+            return last_send_ + timeout;
+        }
+        // As many events as both PutLogEvents limits allow; one event
+        // always fits, since push_event() truncates it
+        const size_t limit = batch_limit();
+        size_t bytes = 0;
+        while (!queue_.empty() && batch.size() < limit) {
+            const size_t size = queue_.front().size;
+            if (!batch.empty() && bytes + size > config_.max_batch_bytes) {
+                break;
+            }
+            bytes += size;
+            batch.push_back(std::move(queue_.front()));
             queue_.pop();
         }
+        queued_bytes_ -= bytes;
+        budget_.release(bytes);
+        in_flight_ += batch.size();
+        last_send_ = now;
+        // Straight to disk while the endpoint is down, or before the queue overflows
+        divert = spill_ && (spill_->diverting() || queue_.size() + batch.size() >= config_.max_queue_size / 2);
+    }
 
-        lock.unlock();
-
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_send).count();
-        
-        if (!batch.empty() && (batch.size() >= config_.batch_size || elapsed >= static_cast<long>(config_.batch_timeout_ms))) {
-            send_batch(batch);
-            batch.clear();
-            last_send = now;
+    const size_t count = batch.size();
+    if (divert) {
+        if (!spill_->push(create_request_body(batch), static_cast<uint32_t>(count))) {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            messages_failed_ += count;
         }
+        finish_batch(count);
+        return now;
     }
 
-    if (!batch.empty()) {
-        send_batch(batch);
-    }
+    HttpRequest request = base_request();
+    request.body = create_request_body(batch);
+    transport.submit(std::move(request), [this, count](const HttpResponse& response, int attempts,
+                                                       HttpRequest& sent) {
+        on_sent(response, attempts, count, sent);
+    });
+    return now;  // Pumped again at once, for what is still queued
 }
 
-void CloudWatchSink::send_batch(const std::vector<LogEvent>& events) {
-    size_t retry_count = 0;
-    size_t delay = config_.retry_delay_ms;
-    bool success = false;
+HttpRequest CloudWatchSink::base_request() const {
+    HttpRequest request;
+    request.url = "https://logs." + config_.region + ".amazonaws.com/";
+    request.headers = {"Content-Type: application/x-amz-json-1.1", "X-Amz-Target: Logs_20140328.PutLogEvents"};
+    request.max_attempts = static_cast<int>(config_.max_retries) + 1;
+    request.retry_delay_ms = static_cast<long>(config_.retry_delay_ms);
+    return request;
+}
 
-    while (retry_count <= config_.max_retries && !success) {
-        success = send_to_cloudwatch(events);
-        
-        if (!success && retry_count < config_.max_retries) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-            delay *= 2;
-            retry_count++;
-            
-            std::lock_guard<std::mutex> lock(stats_mutex_);
-            retries_++;
+void CloudWatchSink::on_sent(const HttpResponse& response, int attempts, size_t events, HttpRequest& request) {
+    const bool sent = response.success && response.status_code == 200;
+    bool spilled = false;
+    if (!sent && spill_ && (!response.success || response.status_code == 429 || response.status_code >= 500)) {
+        // Kept for the replayer, and later batches follow it to disk until a replay gets through
+        spilled = spill_->push(request.body, static_cast<uint32_t>(events));
+        spill_->mark_down();
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        batches_sent_++;
+        retries_ += attempts > 1 ? static_cast<uint64_t>(attempts - 1) : 0;
+        if (sent) {
+            messages_sent_ += events;
+        } else if (!spilled) {
+            messages_failed_ += events;
         }
     }
+    finish_batch(events);
+}
 
+void CloudWatchSink::on_replayed(const HttpResponse& response, uint32_t events) {
     std::lock_guard<std::mutex> lock(stats_mutex_);
-    batches_sent_++;
-    
-    if (success) {
-        messages_sent_ += events.size();
-    } else {
-        messages_failed_ += events.size();
+    if (response.success && response.status_code == 200) {
+        batches_sent_++;
+        messages_sent_ += events;
+    } else if (response.success && response.status_code != 429 && response.status_code < 500) {
+        messages_failed_ += events;  // Rejected, and dropped from the spill
     }
 }
 
-bool CloudWatchSink::send_to_cloudwatch(const std::vector<LogEvent>& events) {
-    if (events.empty()) {
-        return true;
-    }
-
-    std::string body = create_request_body(events);
-    std::string url = "https://logs." + config_.region + ".amazonaws.com/";
-
-    std::vector<std::pair<std::string, std::string>> headers = {
-        {"Content-Type", "application/x-amz-json-1.1"},
-        {"X-Amz-Target", "Logs_20140328.PutLogEvents"}
-    };
-
-    auto response = HttpClient::post(url, body, headers);
-    return response.success && response.status_code == 200;
+void CloudWatchSink::finish_batch(size_t events) {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    in_flight_ -= events;
+    // Under the lock: once it is released the destructor may go ahead
+    flushed_cv_.notify_all();
 }
 
 std::string CloudWatchSink::create_request_body(const std::vector<LogEvent>& events) {
-    std::ostringstream json;
-    json << "{"
-         << "\"logGroupName\":\"" << config_.log_group_name << "\","
-         << "\"logStreamName\":\"" << config_.log_stream_name << "\","
-         << "\"logEvents\":[";
+    size_t size = 96 + config_.log_group_name.size() + config_.log_stream_name.size();
+    for (const auto& event : events) {
+        size += event.json.size() + 1;
+    }
 
+    std::string json;
+    json.reserve(size);
+    json.append("{\"logGroupName\":");
+    json::append_string(json, config_.log_group_name);
+    json.append(",\"logStreamName\":");
+    json::append_string(json, config_.log_stream_name);
+    json.append(",\"logEvents\":[");
     for (size_t i = 0; i < events.size(); ++i) {
-        if (i > 0) json << ",";
-        json << "{"
-             << "\"timestamp\":" << events[i].timestamp_ms << ","
-             << "\"message\":\"" << events[i].message << "\""
-             << "}";
+        if (i > 0) json.push_back(',');
+        json.append(events[i].json);
     }
-
-    json << "]}";
-    return json.str();
+    json.append("]}");
+    return json;
 }
+
 CloudWatchSink::Stats CloudWatchSink::get_stats() const {
     std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(stats_mutex_));
     std::lock_guard<std::mutex> queue_lock(const_cast<std::mutex&>(queue_mutex_));
@@ -170,6 +297,7 @@ CloudWatchSink::Stats CloudWatchSink::get_stats() const {
     stats.messages_dropped = messages_dropped_;
     stats.batches_sent = batches_sent_;
     stats.retries = retries_;
+    stats.messages_spilled = spill_ ? spill_->get_stats().spilled : 0;
     stats.queue_size = queue_.size();
     
     return stats;
@@ -178,6 +306,7 @@ CloudWatchSink::Stats CloudWatchSink::get_stats() const {
 
 AzureMonitorSink::AzureMonitorSink(const Config& config)
     : config_(config)
+    , last_send_(std::chrono::steady_clock::now())
     , running_(true)
     , messages_sent_(0)
     , messages_failed_(0)
@@ -185,161 +314,221 @@ AzureMonitorSink::AzureMonitorSink(const Config& config)
     , batches_sent_(0)
     , retries_(0)
 {
-    worker_ = std::thread(&AzureMonitorSink::worker_thread, this);
+    if (!config_.spill.directory.empty()) {
+        spill_ = std::make_unique<SpillQueue>(config_.spill);
+    }
+    HttpTransport::instance().attach(this);
 }
 
 AzureMonitorSink::~AzureMonitorSink() {
     running_ = false;
-    queue_cv_.notify_all();
-    if (worker_.joinable()) {
-        worker_.join();
+    HttpTransport::instance().wake();
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        flushed_cv_.wait(lock, [this] { return queue_.empty() && in_flight_ == 0; });
     }
+    HttpTransport::instance().detach(this);
+    spill_.reset();  // Waits for a replay whose completion uses the stats
 }
 
 void AzureMonitorSink::log(const std::string& name, LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    
-    if (queue_.size() >= config_.max_queue_size) {
-        messages_dropped_++;
-        return;
-    }
-
-    TelemetryEvent event;
-    event.message = formatter.format(name, level, message);
-    event.level = level_to_severity(level);
-    event.logger_name = name;
-    
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm;
-    gmtime_r(&time_t, &tm);
-    
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S") << "Z";
-    event.timestamp = oss.str();
+    log_as_record(name, level, message);
+}
 
-    queue_.push(event);
-    queue_cv_.notify_one();
+void AzureMonitorSink::log_record(const FormattedRecord& record) {
+    enqueue(record.formatted(formatter), record.level(), record.logger_name(), record.timestamp());
 }
 
-void AzureMonitorSink::flush() {
-    while (true) {
+void AzureMonitorSink::enqueue(const std::string& formatted, LogLevel level, std::string_view,
+                               std::chrono::system_clock::time_point timestamp) {
+    bool wake;
+    {
         std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (queue_.empty()) {
-            break;
+
+        if (queue_.size() >= config_.max_queue_size) {
+            messages_dropped_++;
+            return;
+        }
+
+        const bool was_ready = batch_ready();
+        TelemetryEvent event;
+        event.line = encode_event(formatted, level, timestamp);
+        if (!budget_.try_charge(level, event.line.size())) {
+            messages_dropped_++;
+            return;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queued_bytes_ += event.line.size();
+        queue_.push(std::move(event));
+        wake = queue_.size() == 1 || (!was_ready && batch_ready());
+    }
+    if (wake) {
+        HttpTransport::instance().wake();
     }
 }
 
-void AzureMonitorSink::worker_thread() {
-    std::vector<TelemetryEvent> batch;
-    auto last_send = std::chrono::steady_clock::now();
+std::string AzureMonitorSink::encode_event(std::string_view message, LogLevel level,
+                                           std::chrono::system_clock::time_point timestamp) const {
+    message = truncate_utf8(message, azure_max_message_bytes);
+    std::string line;
+    line.reserve(message.size() + 256);
+    line.append("{\"name\":\"Microsoft.ApplicationInsights.Message\",\"time\":\"");
+    line.append(TimestampCache::utc(timestamp));
+    line.append("Z\",\"iKey\":");
+    json::append_string(line, config_.instrumentation_key);
+    line.append(",\"data\":{\"baseType\":\"MessageData\",\"baseData\":{\"ver\":2,\"message\":");
+    json::append_string(line, message);
+    line.append(",\"severityLevel\":\"");
+    line.append(level_to_severity(level));
+    line.append("\"}");
+    if (!config_.cloud_role_name.empty()) {
+        line.append(",\"cloud\":{\"roleName\":");
+        json::append_string(line, config_.cloud_role_name);
+        line.push_back('}');
+    }
+    line.append("}}\n");
+    return line;
+}
 
-    while (running_) {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        
-        queue_cv_.wait_for(lock, std::chrono::milliseconds(100), [this] {
-            return !queue_.empty() || !running_;
-        });
+bool AzureMonitorSink::batch_ready() const {
+    return queue_.size() >= std::max<size_t>(config_.batch_size, 1) || queued_bytes_ >= config_.max_batch_bytes;
+}
 
-        if (!running_ && queue_.empty()) {
-            break;
-        }
+void AzureMonitorSink::flush() {
+    // Ask for whatever is queued to be sent instead of waiting for
+    // batch_size or batch_timeout_ms, then wait until nothing is unsent.
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    ++flush_waiters_;
+    HttpTransport::instance().wake();
+    flushed_cv_.wait(lock, [this] {
+        return (queue_.empty() && in_flight_ == 0) || !running_;
+    });
+    --flush_waiters_;
+}
 
-        while (!queue_.empty() && batch.size() < config_.batch_size) {
-            batch.push_back(queue_.front());
+std::chrono::steady_clock::time_point AzureMonitorSink::pump(HttpTransport& transport) {
+    auto next = send_batch(transport);
+    if (spill_) {
+        next = std::min(next, spill_->replay(transport, base_request(), [this](const HttpResponse& response,
+                                                                                  uint32_t events) {
+            on_replayed(response, events);
+        }));
+    }
+    return next;
+}
+
+std::chrono::steady_clock::time_point AzureMonitorSink::send_batch(HttpTransport& transport) {
+    const auto now = std::chrono::steady_clock::now();
+    const auto timeout = std::chrono::milliseconds(config_.batch_timeout_ms);
+    bool divert = false;
+    std::vector<TelemetryEvent> batch;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (queue_.empty()) {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        const bool due = flush_waiters_ > 0 || !running_ || batch_ready() || now - last_send_ >= timeout;
+        if (!due) {
+            return last_send_ + timeout;
+        }
+        const size_t limit = std::max<size_t>(config_.batch_size, 1);
+        size_t bytes = 0;
+        while (!queue_.empty() && batch.size() < limit) {
+            const size_t size = queue_.front().line.size();
+            if (!batch.empty() && bytes + size > config_.max_batch_bytes) {
+                break;
+            }
+            bytes += size;
+            batch.push_back(std::move(queue_.front()));
             queue_.pop();
         }
+        queued_bytes_ -= bytes;
+        budget_.release(bytes);
+        in_flight_ += batch.size();
+        last_send_ = now;
+        // Straight to disk while the endpoint is down, or before the queue overflows
+        divert = spill_ && (spill_->diverting() || queue_.size() + batch.size() >= config_.max_queue_size / 2);
+    }
 
-        lock.unlock();
-
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_send).count();
-        
-        if (!batch.empty() && (batch.size() >= config_.batch_size || elapsed >= static_cast<long>(config_.batch_timeout_ms))) {
-            send_batch(batch);
-            batch.clear();
-            last_send = now;
+    const size_t count = batch.size();
+    if (divert) {
+        if (!spill_->push(create_request_body(batch), static_cast<uint32_t>(count))) {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            messages_failed_ += count;
         }
+        finish_batch(count);
+        return now;
     }
 
-    if (!batch.empty()) {
-        send_batch(batch);
-    }
+    HttpRequest request = base_request();
+    request.body = create_request_body(batch);
+    transport.submit(std::move(request), [this, count](const HttpResponse& response, int attempts,
+                                                       HttpRequest& sent) {
+        on_sent(response, attempts, count, sent);
+    });
+    return now;  // Pumped again at once, for what is still queued
 }
 
-void AzureMonitorSink::send_batch(const std::vector<TelemetryEvent>& events) {
-    size_t retry_count = 0;
-    size_t delay = config_.retry_delay_ms;
-    bool success = false;
+HttpRequest AzureMonitorSink::base_request() const {
+    HttpRequest request;
+    request.url = config_.ingestion_endpoint;
+    request.headers = {"Content-Type: application/json", "charset: utf-8"};
+    request.max_attempts = static_cast<int>(config_.max_retries) + 1;
+    request.retry_delay_ms = static_cast<long>(config_.retry_delay_ms);
+    return request;
+}
 
-    while (retry_count <= config_.max_retries && !success) {
-        success = send_to_azure(events);
-        
-        if (!success && retry_count < config_.max_retries) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-            delay *= 2;
-            retry_count++;
-            
-            std::lock_guard<std::mutex> lock(stats_mutex_);
-            retries_++;
+void AzureMonitorSink::on_sent(const HttpResponse& response, int attempts, size_t events, HttpRequest& request) {
+    const bool sent = response.success && (response.status_code == 200 || response.status_code == 206);
+    bool spilled = false;
+    if (!sent && spill_ && (!response.success || response.status_code == 429 || response.status_code >= 500)) {
+        // Kept for the replayer, and later batches follow it to disk until a replay gets through
+        spilled = spill_->push(request.body, static_cast<uint32_t>(events));
+        spill_->mark_down();
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        batches_sent_++;
+        retries_ += attempts > 1 ? static_cast<uint64_t>(attempts - 1) : 0;
+        if (sent) {
+            messages_sent_ += events;
+        } else if (!spilled) {
+            messages_failed_ += events;
         }
     }
+    finish_batch(events);
+}
 
+void AzureMonitorSink::on_replayed(const HttpResponse& response, uint32_t events) {
     std::lock_guard<std::mutex> lock(stats_mutex_);
-    batches_sent_++;
-    
-    if (success) {
-        messages_sent_ += events.size();
-    } else {
-        messages_failed_ += events.size();
+    if (response.success && (response.status_code == 200 || response.status_code == 206)) {
+        batches_sent_++;
+        messages_sent_ += events;
+    } else if (response.success && response.status_code != 429 && response.status_code < 500) {
+        messages_failed_ += events;  // Rejected, and dropped from the spill
     }
 }
 
-bool AzureMonitorSink::send_to_azure(const std::vector<TelemetryEvent>& events) {
-    if (events.empty()) {
-        return true;
-    }
-
-    std::string body = create_request_body(events);
-    
-    std::vector<std::pair<std::string, std::string>> headers = {
-        {"Content-Type", "application/json"},
-        {"charset", "utf-8"}
-    };
-
-    auto response = HttpClient::post(config_.ingestion_endpoint, body, headers);
-    return response.success && (response.status_code == 200 || response.status_code == 206);
+void AzureMonitorSink::finish_batch(size_t events) {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    in_flight_ -= events;
+    // Under the lock: once it is released the destructor may go ahead
+    flushed_cv_.notify_all();
 }
 
 std::string AzureMonitorSink::create_request_body(const std::vector<TelemetryEvent>& events) {
-    std::ostringstream json;
-    
+    size_t size = 0;
     for (const auto& event : events) {
-        json << "{"
-             << "\"name\":\"Microsoft.ApplicationInsights.Message\","
-             << "\"time\":\"" << event.timestamp << "\","
-             << "\"iKey\":\"" << config_.instrumentation_key << "\","
-             << "\"data\":{"
-             << "\"baseType\":\"MessageData\","
-             << "\"baseData\":{"
-             << "\"ver\":2,"
-             << "\"message\":\"" << event.message << "\","
-             << "\"severityLevel\":\"" << event.level << "\""
-             << "}";
-        
-        if (!config_.cloud_role_name.empty()) {
-            json << ",\"cloud\":{\"roleName\":\"" << config_.cloud_role_name << "\"}";
-        }
-        
-        json << "}}\n";
+        size += event.line.size();
     }
-    
-    return json.str();
+    std::string body;
+    body.reserve(size);
+    for (const auto& event : events) {
+        body.append(event.line);
+    }
+    return body;
 }
 
-std::string AzureMonitorSink::level_to_severity(LogLevel level) {
+const char* AzureMonitorSink::level_to_severity(LogLevel level) {
     switch (level) {
         case LogLevel::Trace:
         case LogLevel::Debug:
@@ -367,19 +556,13 @@ AzureMonitorSink::Stats AzureMonitorSink::get_stats() const {
     stats.messages_dropped = messages_dropped_;
     stats.batches_sent = batches_sent_;
     stats.retries = retries_;
+    stats.messages_spilled = spill_ ? spill_->get_stats().spilled : 0;
     stats.queue_size = queue_.size();
     
     return stats;
 }
 
 
-#ifdef XLOG_HAS_CURL
-static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
-#endif
-
 HttpClient::Response HttpClient::post(
     const std::string& url,
     const std::string& body,
@@ -390,38 +573,13 @@ HttpClient::Response HttpClient::post(
     response.status_code = 0;
 
 #ifdef XLOG_HAS_CURL
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        return response;
-    }
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
-
-    struct curl_slist* header_list = nullptr;
+    HttpRequest request;
+    request.url = url;
+    request.body = body;
     for (const auto& header : headers) {
-        std::string header_str = header.first + ": " + header.second;
-        header_list = curl_slist_append(header_list, header_str.c_str());
-    }
-    if (header_list) {
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
-    }
-
-    CURLcode res = curl_easy_perform(curl);
-    
-    if (res == CURLE_OK) {
-        long status_code;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
-        response.status_code = static_cast<int>(status_code);
-        response.success = true;
-    }
-
-    if (header_list) {
-        curl_slist_free_all(header_list);
+        request.headers.push_back(header.first + ": " + header.second);
     }
-    curl_easy_cleanup(curl);
+    response = HttpTransport::instance().post(std::move(request));
 #else
     std::string cmd = "curl -X POST -d '" + body + "' '" + url + "'";
     for (const auto& header : headers) {
@@ -1,7 +1,20 @@
 #include "Zyrnix/sinks/compressed_file_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/sinks/flush_policy.hpp"
+#include "Zyrnix/rate_limiter.hpp"
+#include "Zyrnix/tracepoints.hpp"
+#ifndef XLOG_NO_CLOUD_SINKS
+#include "Zyrnix/sinks/archive_upload.hpp"
+#endif
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <set>
+#include <vector>
 #include <sys/stat.h>
 
 #ifdef XLOG_HAS_ZLIB
@@ -10,10 +23,169 @@
 
 #ifdef XLOG_HAS_ZSTD
 #include <zstd.h>
+#include <zdict.h>
 #endif
 
 namespace Zyrnix {
 
+// The compressor behind streaming mode: lines in, a series of complete
+// gzip members or zstd frames out
+class CompressedFileSink::StreamEncoder {
+public:
+    static std::unique_ptr<StreamEncoder> create(CompressionType type, int level) {
+        std::unique_ptr<StreamEncoder> encoder(new StreamEncoder(type));
+        return encoder->init(level) ? std::move(encoder) : nullptr;
+    }
+
+    ~StreamEncoder() {
+#ifdef XLOG_HAS_ZLIB
+        if (type_ == CompressionType::Gzip && initialized_) {
+            deflateEnd(&zs_);
+        }
+#endif
+#ifdef XLOG_HAS_ZSTD
+        if (cctx_) {
+            ZSTD_freeCCtx(cctx_);
+        }
+#endif
+    }
+
+    // Compress data, appending whatever output is ready to out
+    bool write(const char* data, size_t size, std::string& out) {
+#ifdef XLOG_HAS_ZLIB
+        if (type_ == CompressionType::Gzip) {
+            zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            zs_.avail_in = static_cast<uInt>(size);
+            do {
+                zs_.next_out = reinterpret_cast<Bytef*>(chunk_.data());
+                zs_.avail_out = static_cast<uInt>(chunk_.size());
+                if (deflate(&zs_, Z_NO_FLUSH) == Z_STREAM_ERROR) {
+                    return false;
+                }
+                out.append(chunk_.data(), chunk_.size() - zs_.avail_out);
+            } while (zs_.avail_out == 0);
+            return true;
+        }
+#endif
+#ifdef XLOG_HAS_ZSTD
+        if (type_ == CompressionType::Zstd) {
+            ZSTD_inBuffer in{data, size, 0};
+            while (in.pos < in.size) {
+                ZSTD_outBuffer output{chunk_.data(), chunk_.size(), 0};
+                if (ZSTD_isError(ZSTD_compressStream2(cctx_, &output, &in, ZSTD_e_continue))) {
+                    return false;
+                }
+                out.append(chunk_.data(), output.pos);
+            }
+            return true;
+        }
+#endif
+        (void)data;
+        (void)size;
+        (void)out;
+        return false;
+    }
+
+    // End the frame, so everything written so far decodes on its own
+    bool end_frame(std::string& out) {
+#ifdef XLOG_HAS_ZLIB
+        if (type_ == CompressionType::Gzip) {
+            zs_.avail_in = 0;
+            int ret;
+            do {
+                zs_.next_out = reinterpret_cast<Bytef*>(chunk_.data());
+                zs_.avail_out = static_cast<uInt>(chunk_.size());
+                ret = deflate(&zs_, Z_FINISH);
+                if (ret == Z_STREAM_ERROR) {
+                    return false;
+                }
+                out.append(chunk_.data(), chunk_.size() - zs_.avail_out);
+            } while (ret != Z_STREAM_END);
+            return deflateReset(&zs_) == Z_OK;  // The next member
+        }
+#endif
+#ifdef XLOG_HAS_ZSTD
+        if (type_ == CompressionType::Zstd) {
+            ZSTD_inBuffer in{nullptr, 0, 0};
+            size_t remaining;
+            do {
+                ZSTD_outBuffer output{chunk_.data(), chunk_.size(), 0};
+                remaining = ZSTD_compressStream2(cctx_, &output, &in, ZSTD_e_end);
+                if (ZSTD_isError(remaining)) {
+                    return false;
+                }
+                out.append(chunk_.data(), output.pos);
+            } while (remaining != 0);
+            return true;
+        }
+#endif
+        (void)out;
+        return false;
+    }
+
+    // Used for the frames after this call; empty for none. Between frames only
+    void set_dictionary(std::string_view dictionary) {
+#ifdef XLOG_HAS_ZSTD
+        if (type_ == CompressionType::Zstd) {
+            ZSTD_CCtx_loadDictionary(cctx_, dictionary.data(), dictionary.size());
+        }
+#endif
+        (void)dictionary;
+    }
+
+    // Between frames only
+    void set_level(int level) {
+#ifdef XLOG_HAS_ZLIB
+        if (type_ == CompressionType::Gzip) {
+            deflateParams(&zs_, std::clamp(level, 1, 9), Z_DEFAULT_STRATEGY);
+        }
+#endif
+#ifdef XLOG_HAS_ZSTD
+        if (type_ == CompressionType::Zstd) {
+            ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level);
+        }
+#endif
+        (void)level;
+    }
+
+private:
+    explicit StreamEncoder(CompressionType type) : type_(type), chunk_(64 * 1024) {}
+
+    bool init(int level) {
+#ifdef XLOG_HAS_ZLIB
+        if (type_ == CompressionType::Gzip) {
+            std::memset(&zs_, 0, sizeof(zs_));
+            // 15 + 16: a gzip header and trailer around each member
+            initialized_ = deflateInit2(&zs_, std::clamp(level, 1, 9), Z_DEFLATED, 15 + 16, 8,
+                                        Z_DEFAULT_STRATEGY) == Z_OK;
+            return initialized_;
+        }
+#endif
+#ifdef XLOG_HAS_ZSTD
+        if (type_ == CompressionType::Zstd) {
+            cctx_ = ZSTD_createCCtx();
+            if (!cctx_) {
+                return false;
+            }
+            ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level);
+            return true;
+        }
+#endif
+        (void)level;
+        return false;
+    }
+
+    CompressionType type_;
+    std::vector<char> chunk_;
+#ifdef XLOG_HAS_ZLIB
+    z_stream zs_;
+    bool initialized_ = false;
+#endif
+#ifdef XLOG_HAS_ZSTD
+    ZSTD_CCtx* cctx_ = nullptr;
+#endif
+};
+
 CompressedFileSink::CompressedFileSink(
     const std::string& filename,
     size_t max_size,
@@ -32,29 +204,133 @@ CompressedFileSink::CompressedFileSink(
     , last_compression_duration_us_(0)
     , compression_count_(0)
 {
-    file_.open(base_filename_, std::ios::app);
+#ifndef XLOG_HAS_ZSTD
+    options_.train_dictionary = false;
+#endif
+    if (options_.type != CompressionType::Zstd) {
+        options_.train_dictionary = false;
+    }
+    if (options_.seekable) {
+        options_.streaming = true;
+    }
+    if (options_.streaming && options_.type != CompressionType::None) {
+        // Without the library this is the plain mode, and files stay uncompressed
+        encoder_ = StreamEncoder::create(options_.type, options_.level);
+    }
+    // Appending to a compressed file adds frames after the ones there
+    file_.open(current_filename(), encoder_ ? std::ios::app | std::ios::binary : std::ios::app);
     if (file_.is_open()) {
         file_.seekp(0, std::ios::end);
         current_size_ = file_.tellp();
     }
+    file_offset_ = current_size_;
+    if (encoder_ && options_.seekable) {
+        index_.open(current_filename() + ".idx", std::ios::app);
+    }
+    if (options_.sidecar.enabled) {
+        sidecar_ = std::make_unique<sidecar::Builder>(options_.sidecar);
+        sidecar_->resume(current_filename() + std::string(sidecar::suffix), current_size_);
+    }
+    options_.max_pending = std::max<size_t>(options_.max_pending, 1);
+    options_.frame_size = std::max<size_t>(options_.frame_size, 1);
+    const size_t workers = std::max<size_t>(options_.workers, 1);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back(&CompressedFileSink::run_worker, this);
+    }
+    if (encoder_) {
+        BackgroundFlusher::instance().add(this, options_.frame_flush_interval);
+    }
 }
 
 CompressedFileSink::~CompressedFileSink() {
-    if (file_.is_open()) {
-        file_.close();
+    if (encoder_) {
+        BackgroundFlusher::instance().remove(this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_frame();
+        if (file_.is_open()) {
+            file_.close();
+            if (sidecar_ && sidecar_->complete()) {
+                sidecar_->write(current_filename() + std::string(sidecar::suffix), on_disk_size());
+            }
+        }
+        index_.close();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+    // Workers finish the queue before they exit
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
     }
 }
 
 void CompressedFileSink::log(const std::string& name, LogLevel level, const std::string& message) {
+    log_as_record(name, level, message);
+}
+
+void CompressedFileSink::log_record(const FormattedRecord& record) {
+    write_line(record.formatted(formatter), record.timestamp(), record.level(), &record);
+}
+
+void CompressedFileSink::write_line(const std::string& formatted, std::chrono::system_clock::time_point when,
+                                    LogLevel level, const FormattedRecord* record) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (!file_.is_open()) {
         return;
     }
 
-    std::string formatted = formatter.format(name, level, message);
-    file_ << formatted << '\n';
-    current_size_ += formatted.size() + 1;
+    if (options_.train_dictionary) {
+        sample_line(formatted);
+    }
+    const size_t bytes = formatted.size() + 1;
+    if (encoder_) {
+        const auto start = std::chrono::steady_clock::now();
+        const bool ok = encoder_->write(formatted.data(), formatted.size(), encoded_) &&
+                        encoder_->write("\n", 1, encoded_);
+        stream_us_ += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (!ok) {
+            return;
+        }
+        if (index_.is_open()) {
+            const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(when.time_since_epoch()).count();
+            if (frame_bytes_ == 0) {
+                frame_offset_ = file_offset_;
+                frame_first_ms_ = frame_last_ms_ = ms;
+            }
+            // Records from an async queue can arrive slightly out of order
+            frame_first_ms_ = std::min(frame_first_ms_, ms);
+            frame_last_ms_ = std::max(frame_last_ms_, ms);
+        }
+        if (!encoded_.empty()) {
+            file_.write(encoded_.data(), static_cast<std::streamsize>(encoded_.size()));
+            stream_compressed_bytes_ += encoded_.size();
+            file_offset_ += encoded_.size();
+            encoded_.clear();
+        }
+        stream_original_bytes_ += bytes;
+        frame_bytes_ += bytes;
+        if (frame_bytes_ >= options_.frame_size) {
+            end_frame();
+        }
+    } else {
+        file_ << formatted << '\n';
+    }
+    current_size_ += bytes;
+    if (sidecar_) {
+        if (record) {
+            sidecar_->add(*record);
+        } else {
+            sidecar_->add(when, level);
+        }
+    }
 
     if (current_size_ >= max_size_) {
         rotate();
@@ -63,135 +339,401 @@ void CompressedFileSink::log(const std::string& name, LogLevel level, const std:
 
 void CompressedFileSink::flush() {
     std::lock_guard<std::mutex> lock(mutex_);
+    end_frame();
     if (file_.is_open()) {
         file_.flush();
     }
 }
 
+uint64_t CompressedFileSink::on_disk_size() const {
+    return encoder_ ? file_offset_ : current_size_;
+}
+
+std::string CompressedFileSink::current_filename() const {
+    return encoder_ ? base_filename_ + get_compressed_extension() : base_filename_;
+}
+
+void CompressedFileSink::end_frame() {
+    if (!encoder_ || frame_bytes_ == 0 || !file_.is_open()) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    encoder_->end_frame(encoded_);
+    stream_us_ += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    file_.write(encoded_.data(), static_cast<std::streamsize>(encoded_.size()));
+    file_.flush();
+    stream_compressed_bytes_ += encoded_.size();
+    file_offset_ += encoded_.size();
+    encoded_.clear();
+    frame_bytes_ = 0;
+    if (index_.is_open()) {
+        // After the frame itself, so an entry never points past the data
+        index_ << frame_offset_ << ' ' << (file_offset_ - frame_offset_) << ' '
+               << frame_first_ms_ << ' ' << frame_last_ms_ << '\n';
+        index_.flush();
+    }
+}
+
 void CompressedFileSink::rotate() {
+    XLOG_PROBE(rotate, base_filename_.c_str(), current_size_);
+    if (encoder_) {
+        end_frame();
+        // The file was compressed as it went; count it now
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        last_compression_time_ = std::chrono::steady_clock::now();
+        last_compression_duration_us_ = stream_us_;
+        compression_count_++;
+        files_compressed_++;
+        original_bytes_ += stream_original_bytes_;
+        compressed_bytes_ += stream_compressed_bytes_;
+        if (options_.auto_tune) {
+            update_compression_level();
+        }
+        encoder_->set_level(current_level_);
+        stream_original_bytes_ = 0;
+        stream_compressed_bytes_ = 0;
+        stream_us_ = 0;
+    }
     if (file_.is_open()) {
         file_.close();
     }
 
-    if (max_files_ > 0) {
-        std::string oldest = get_rotated_filename(max_files_);
-        std::remove(oldest.c_str());
+    // Park under a name no other rotation uses; the workers take it from there
+    const auto stamp = std::chrono::system_clock::now().time_since_epoch().count();
+    const uint64_t sequence = rotations_++;
+    std::string parked = base_filename_ + ".rotating-" + std::to_string(stamp) + "-" + std::to_string(sequence);
+    if (index_.is_open()) {
+        index_.close();
+        std::rename((current_filename() + ".idx").c_str(), (parked + ".idx").c_str());
+    }
+    if (std::rename(current_filename().c_str(), parked.c_str()) == 0) {
+        // Before the job is queued, so the workers find it with the file
+        if (sidecar_ && sidecar_->complete()) {
+            sidecar_->write(parked + std::string(sidecar::suffix), on_disk_size());
+        }
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        // Backpressure: wait for a worker rather than queue without bound
+        space_cv_.wait(lock, [this] { return queue_.size() < options_.max_pending || stopping_; });
+        queue_.push_back({sequence, std::move(parked), encoder_ != nullptr, {}, {}});
+        lock.unlock();
+        queue_cv_.notify_one();
+    } else {
+        // Nothing parked, yet later rotations still wait for this one's turn
+        shift_in(sequence, std::string(), false);
     }
 
-    for (size_t i = max_files_; i > 0; --i) {
-        std::string old_name = (i == 1) ? base_filename_ : get_rotated_filename(i - 1);
-        std::string new_name = get_rotated_filename(i);
-        std::rename(old_name.c_str(), new_name.c_str());
+    if (sidecar_) {
+        std::remove((current_filename() + std::string(sidecar::suffix)).c_str());
+        sidecar_->reset();
+    }
+    file_.open(current_filename(), encoder_ ? std::ios::trunc | std::ios::binary : std::ios::trunc);
+    current_size_ = 0;
+    file_offset_ = 0;
+    if (encoder_ && options_.seekable) {
+        index_.open(current_filename() + ".idx", std::ios::trunc);
+    }
+    if (encoder_ && options_.train_dictionary) {
+        // One dictionary per file, so decoding a file needs only that one
+        auto dictionary = current_dictionary();
+        encoder_->set_dictionary(dictionary ? std::string_view(dictionary->bytes) : std::string_view());
     }
+}
 
-    if (options_.compress_on_rotate && options_.type != CompressionType::None) {
-        std::string source = get_rotated_filename(1);
-        std::string dest = source + get_compressed_extension();
-        
-        size_t original_size = CompressionUtils::get_file_size(source);
-        
-        auto start = std::chrono::steady_clock::now();
-        compress_file(source, dest);
-        auto end = std::chrono::steady_clock::now();
-        
-        last_compression_time_ = end;
-        last_compression_duration_us_ = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        compression_count_++;
-        
-        size_t compressed_size = CompressionUtils::get_file_size(dest);
-        
-        if (compressed_size > 0) {
-            std::remove(source.c_str()); 
-            
-            std::lock_guard<std::mutex> stats_lock(stats_mutex_);
-            files_compressed_++;
-            original_bytes_ += original_size;
-            compressed_bytes_ += compressed_size;
-            
-
-            if (options_.auto_tune) {
-                update_compression_level();
-            }
-        }
+void CompressedFileSink::sample_line(const std::string& formatted) {
+    if (training_.load(std::memory_order_acquire)) {
+        return;
+    }
+    const uint64_t now = monotonic_coarse_ns();
+    if (now < next_training_ns_) {
+        return;
+    }
+    samples_.append(formatted);
+    sample_sizes_.push_back(formatted.size());
+    if (samples_.size() < options_.dictionary_sample_bytes) {
+        return;
     }
 
-    file_.open(base_filename_, std::ios::trunc);
-    current_size_ = 0;
+    training_.store(true, std::memory_order_release);
+    next_training_ns_ = now + static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(options_.retrain_interval).count());
+    Job job{0, std::string(), false, std::move(samples_), std::move(sample_sizes_)};
+    samples_.clear();
+    sample_sizes_.clear();
+    {
+        // Past max_pending if need be: there is only ever one of these
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        queue_.push_back(std::move(job));
+    }
+    queue_cv_.notify_one();
 }
 
-void CompressedFileSink::compress_file(const std::string& source_path, const std::string& dest_path) {
-    bool success = false;
-    
-    switch (options_.type) {
-        case CompressionType::Gzip:
-            success = compress_gzip(source_path, dest_path);
-            break;
-        case CompressionType::Zstd:
-            success = compress_zstd(source_path, dest_path);
-            break;
-        default:
-            break;
+void CompressedFileSink::train_dictionary(const Job& job) {
+#ifdef XLOG_HAS_ZSTD
+    std::string dictionary(std::max<size_t>(options_.dictionary_size, 256), '\0');
+    const size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), job.samples.data(),
+                                              job.sample_sizes.data(), static_cast<unsigned>(job.sample_sizes.size()));
+    if (!ZDICT_isError(size)) {
+        dictionary.resize(size);
+        const uint32_t id = ZDICT_getDictID(dictionary.data(), size);
+        // Written before any file uses it, or that file could not be read
+        std::ofstream out(base_filename_ + "." + std::to_string(id) + ".dict", std::ios::binary | std::ios::trunc);
+        out.write(dictionary.data(), static_cast<std::streamsize>(size));
+        out.close();
+#ifndef XLOG_NO_CLOUD_SINKS
+        // Uploaded files need it to be read; the sink keeps its own
+        if (id != 0 && out && options_.uploader) {
+            const std::string path = base_filename_ + "." + std::to_string(id) + ".dict";
+            options_.uploader->add_copy(path, std::filesystem::path(path).filename().string());
+        }
+#endif
+        if (id != 0 && out) {
+            std::lock_guard<std::mutex> lock(dict_mutex_);
+            previous_dictionary_id_ = dictionary_ ? dictionary_->id : 0;
+            dictionary_ = std::make_shared<const Dictionary>(Dictionary{id, std::move(dictionary)});
+        }
     }
-    
-    (void)success; 
+#else
+    (void)job;
+#endif
+    training_.store(false, std::memory_order_release);
 }
 
-bool CompressedFileSink::compress_gzip(const std::string& source, const std::string& dest) {
-#ifdef XLOG_HAS_ZLIB
-    std::ifstream in(source, std::ios::binary);
-    if (!in) return false;
+std::shared_ptr<const CompressedFileSink::Dictionary> CompressedFileSink::current_dictionary() const {
+    std::lock_guard<std::mutex> lock(dict_mutex_);
+    return dictionary_;
+}
 
-    gzFile out = gzopen(dest.c_str(), ("wb" + std::to_string(options_.level)).c_str());
-    if (!out) return false;
+uint32_t CompressedFileSink::dictionary_id() const {
+    auto dictionary = current_dictionary();
+    return dictionary ? dictionary->id : 0;
+}
 
-    char buffer[8192];
-    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
-        gzwrite(out, buffer, static_cast<unsigned>(in.gcount()));
+void CompressedFileSink::remove_unused_dictionaries() {
+#ifdef XLOG_HAS_ZSTD
+    // The current and previous dictionary stay, since a file still being
+    // compressed may use either; otherwise only those the kept files name
+    std::set<uint32_t> used;
+    {
+        std::lock_guard<std::mutex> lock(dict_mutex_);
+        if (dictionary_) {
+            used.insert(dictionary_->id);
+        }
+        used.insert(previous_dictionary_id_);
+    }
+    auto add_frame_dictionary = [&used](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        char header[18];  // ZSTD_FRAMEHEADERSIZE_MAX
+        in.read(header, sizeof(header));
+        used.insert(ZSTD_getDictID_fromFrame(header, static_cast<size_t>(in.gcount())));
+    };
+    for (size_t i = 1; i <= max_files_; ++i) {
+        add_frame_dictionary(get_rotated_filename(i) + get_compressed_extension());
+    }
+    if (encoder_) {
+        add_frame_dictionary(current_filename());
     }
 
-    gzclose(out);
-    return true;
-#else
-    std::string cmd = "gzip -" + std::to_string(options_.level) + " -c \"" + source + "\" > \"" + dest + "\"";
-    return std::system(cmd.c_str()) == 0;
+    namespace fs = std::filesystem;
+    const fs::path base(base_filename_);
+    const fs::path dir = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    const std::string prefix = base.filename().string() + ".";
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        if (name.size() <= prefix.size() + 5 || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - 5, 5, ".dict") != 0) {
+            continue;
+        }
+        const std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - 5);
+        if (!std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        if (!used.count(static_cast<uint32_t>(std::stoul(digits)))) {
+            std::error_code remove_ec;
+            fs::remove(it->path(), remove_ec);
+        }
+    }
 #endif
 }
 
-bool CompressedFileSink::compress_zstd(const std::string& source, const std::string& dest) {
-#ifdef XLOG_HAS_ZSTD
-    std::ifstream in(source, std::ios::binary);
-    if (!in) return false;
+void CompressedFileSink::run_worker() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    for (;;) {
+        queue_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // Stopping, and nothing left to do
+        }
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        ++in_progress_;
+        lock.unlock();
+        space_cv_.notify_one();
+        compress_job(job);
+        lock.lock();
+        --in_progress_;
+    }
+}
 
-    in.seekg(0, std::ios::end);
-    size_t file_size = in.tellg();
-    in.seekg(0, std::ios::beg);
+void CompressedFileSink::compress_job(const Job& job) {
+    if (!job.sample_sizes.empty()) {
+        train_dictionary(job);
+        return;
+    }
+    if (job.streamed) {
+        shift_in(job.sequence, job.parked, true);
+        return;
+    }
+    if (!options_.compress_on_rotate || options_.type == CompressionType::None) {
+        shift_in(job.sequence, job.parked, false);
+        return;
+    }
 
-    std::vector<char> input_buffer(file_size);
-    in.read(input_buffer.data(), file_size);
+    int level;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        level = current_level_;
+    }
+    const std::string dest = job.parked + get_compressed_extension();
+    const size_t original_size = CompressionUtils::get_file_size(job.parked);
 
-    size_t compressed_bound = ZSTD_compressBound(file_size);
-    std::vector<char> output_buffer(compressed_bound);
+    auto start = std::chrono::steady_clock::now();
+    const bool compressed = compress_file(job.parked, dest, level);
+    auto end = std::chrono::steady_clock::now();
 
-    size_t compressed_size = ZSTD_compress(
-        output_buffer.data(), compressed_bound,
-        input_buffer.data(), file_size,
-        options_.level
-    );
+    if (!compressed) {
+        std::remove(dest.c_str());
+        shift_in(job.sequence, job.parked, false);
+        return;
+    }
+    std::remove(job.parked.c_str());
+    std::rename((job.parked + std::string(sidecar::suffix)).c_str(), (dest + std::string(sidecar::suffix)).c_str());
+    const size_t compressed_size = CompressionUtils::get_file_size(dest);
+    XLOG_PROBE(compress, dest.c_str(), original_size, compressed_size,
+               static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        last_compression_time_ = end;
+        last_compression_duration_us_ = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        compression_count_++;
+        files_compressed_++;
+        original_bytes_ += original_size;
+        compressed_bytes_ += compressed_size;
 
-    if (ZSTD_isError(compressed_size)) {
-        return false;
+        if (options_.auto_tune) {
+            update_compression_level();
+        }
     }
+    shift_in(job.sequence, dest, true);
+}
 
-    std::ofstream out(dest, std::ios::binary);
-    out.write(output_buffer.data(), compressed_size);
-    
+void CompressedFileSink::shift_in(uint64_t sequence, std::string path, bool compressed) {
+    std::lock_guard<std::mutex> lock(shift_mutex_);
+    finished_.emplace(sequence, std::make_pair(std::move(path), compressed));
+
+    // Workers finish out of order; .1 must still end up the newest
+    const std::string extension = get_compressed_extension();
+    while (!finished_.empty() && finished_.begin()->first == next_shift_) {
+        auto [ready, ready_compressed] = std::move(finished_.begin()->second);
+        finished_.erase(finished_.begin());
+        ++next_shift_;
+        if (ready.empty()) {
+            continue;
+        }
+        if (options_.uploader && hand_off(next_shift_ - 1, ready, ready_compressed)) {
+            continue;
+        }
+        const std::string meta(sidecar::suffix);
+        if (max_files_ == 0) {
+            std::remove(ready.c_str());
+            std::remove((ready + ".idx").c_str());
+            std::remove((ready + meta).c_str());
+            continue;
+        }
+
+        // A slot holds either the plain or the compressed name, and a
+        // compressed one may have its frame index next to it; either may
+        // have a sidecar
+        auto remove_slot = [&extension, &meta](const std::string& name) {
+            std::remove(name.c_str());
+            std::remove((name + meta).c_str());
+            std::remove((name + extension).c_str());
+            std::remove((name + extension + ".idx").c_str());
+            std::remove((name + extension + meta).c_str());
+        };
+        auto move_slot = [&extension, &meta](const std::string& from, const std::string& to) {
+            std::rename(from.c_str(), to.c_str());
+            std::rename((from + meta).c_str(), (to + meta).c_str());
+            if (!extension.empty()) {
+                std::rename((from + extension).c_str(), (to + extension).c_str());
+                std::rename((from + extension + ".idx").c_str(), (to + extension + ".idx").c_str());
+                std::rename((from + extension + meta).c_str(), (to + extension + meta).c_str());
+            }
+        };
+        remove_slot(get_rotated_filename(max_files_));
+        for (size_t i = max_files_; i > 1; --i) {
+            move_slot(get_rotated_filename(i - 1), get_rotated_filename(i));
+        }
+        const std::string newest = get_rotated_filename(1) + (ready_compressed ? extension : "");
+        std::rename(ready.c_str(), newest.c_str());
+        std::rename((ready + ".idx").c_str(), (newest + ".idx").c_str());
+        std::rename((ready + meta).c_str(), (newest + meta).c_str());
+        if (options_.train_dictionary) {
+            remove_unused_dictionaries();
+        }
+    }
+}
+
+// Into the uploader's spool, named by time so the bucket lists files in
+// order; false, leaving the file to the cascade, if it cannot be moved
+bool CompressedFileSink::hand_off(uint64_t sequence, const std::string& path, bool compressed) {
+#ifndef XLOG_NO_CLOUD_SINKS
+    const std::time_t second = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm{};
+    gmtime_r(&second, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &tm);
+    const std::string name = std::filesystem::path(base_filename_).filename().string() + "." + stamp + "-" +
+                             std::to_string(sequence) + (compressed ? get_compressed_extension() : "");
+    if (!options_.uploader->add(path, name)) {
+        return false;
+    }
+    for (const std::string& suffix : {std::string(".idx"), std::string(sidecar::suffix)}) {
+        if (std::filesystem::exists(path + suffix)) {
+            options_.uploader->add(path + suffix, name + suffix);
+        }
+    }
     return true;
 #else
-    std::string cmd = "zstd -" + std::to_string(options_.level) + " -q -f \"" + source + "\" -o \"" + dest + "\"";
-    return std::system(cmd.c_str()) == 0;
+    (void)sequence;
+    (void)path;
+    (void)compressed;
+    return false;
 #endif
 }
 
+size_t CompressedFileSink::pending_compressions() const {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    return queue_.size() + in_progress_;
+}
+
+bool CompressedFileSink::compress_file(const std::string& source_path, const std::string& dest_path, int level) {
+    switch (options_.type) {
+        case CompressionType::Gzip:
+            return CompressionUtils::compress_file_gzip(source_path, dest_path, level);
+        case CompressionType::Zstd:
+        {
+            auto dictionary = options_.train_dictionary ? current_dictionary() : nullptr;
+            return CompressionUtils::compress_file_zstd(source_path, dest_path, level, options_.zstd_workers,
+                                                        options_.long_distance_matching,
+                                                        dictionary ? std::string_view(dictionary->bytes)
+                                                                   : std::string_view());
+        }
+        default:
+            return false;
+    }
+}
+
 std::string CompressedFileSink::get_rotated_filename(size_t index) const {
     return base_filename_ + "." + std::to_string(index);
 }
@@ -221,6 +763,14 @@ CompressedFileSink::CompressionStats CompressedFileSink::get_compression_stats()
     return stats;
 }
 
+namespace {
+
+// Read and write chunk for the file compressors; memory use stays at a few
+// of these whatever the size of the file
+constexpr size_t compress_chunk_size = 256 * 1024;
+
+}
+
 bool CompressionUtils::compress_file_gzip(
     const std::string& source_path,
     const std::string& dest_path,
@@ -232,56 +782,84 @@ bool CompressionUtils::compress_file_gzip(
 
     gzFile out = gzopen(dest_path.c_str(), ("wb" + std::to_string(level)).c_str());
     if (!out) return false;
+    gzbuffer(out, static_cast<unsigned>(compress_chunk_size));
 
-    char buffer[8192];
-    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
-        gzwrite(out, buffer, static_cast<unsigned>(in.gcount()));
+    std::vector<char> buffer(compress_chunk_size);
+    bool ok = true;
+    while (ok && (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0)) {
+        ok = gzwrite(out, buffer.data(), static_cast<unsigned>(in.gcount())) > 0;
     }
 
-    gzclose(out);
-    return true;
+    return gzclose(out) == Z_OK && ok;
 #else
-    std::string cmd = "gzip -" + std::to_string(level) + " -c \"" + source_path + "\" > \"" + dest_path + "\"";
-    return std::system(cmd.c_str()) == 0;
+    (void)source_path;
+    (void)dest_path;
+    (void)level;
+    return false;
 #endif
 }
 
 bool CompressionUtils::compress_file_zstd(
     const std::string& source_path,
     const std::string& dest_path,
-    int level
+    int level,
+    int workers,
+    bool long_distance_matching,
+    std::string_view dictionary
 ) {
 #ifdef XLOG_HAS_ZSTD
     std::ifstream in(source_path, std::ios::binary);
     if (!in) return false;
+    std::ofstream out(dest_path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
 
-    in.seekg(0, std::ios::end);
-    size_t file_size = in.tellg();
-    in.seekg(0, std::ios::beg);
-
-    std::vector<char> input_buffer(file_size);
-    in.read(input_buffer.data(), file_size);
-
-    size_t compressed_bound = ZSTD_compressBound(file_size);
-    std::vector<char> output_buffer(compressed_bound);
-
-    size_t compressed_size = ZSTD_compress(
-        output_buffer.data(), compressed_bound,
-        input_buffer.data(), file_size,
-        level
-    );
-
-    if (ZSTD_isError(compressed_size)) {
+    std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (!cctx) return false;
+    ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, level);
+    if (workers > 0) {
+        // Refused by a libzstd built without threads; then it runs on this one
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_nbWorkers, workers);
+    }
+    if (long_distance_matching) {
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_enableLongDistanceMatching, 1);
+    }
+    if (!dictionary.empty() && ZSTD_isError(ZSTD_CCtx_loadDictionary(cctx.get(), dictionary.data(), dictionary.size()))) {
         return false;
     }
 
-    std::ofstream out(dest_path, std::ios::binary);
-    out.write(output_buffer.data(), compressed_size);
-    
-    return true;
+    std::vector<char> input(compress_chunk_size);
+    std::vector<char> output(ZSTD_CStreamOutSize());
+    for (;;) {
+        in.read(input.data(), static_cast<std::streamsize>(input.size()));
+        const size_t got = static_cast<size_t>(in.gcount());
+        const bool last = got < input.size();
+        ZSTD_inBuffer src{input.data(), got, 0};
+        size_t remaining;
+        do {
+            ZSTD_outBuffer dst{output.data(), output.size(), 0};
+            remaining = ZSTD_compressStream2(cctx.get(), &dst, &src, last ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining)) {
+                return false;
+            }
+            out.write(output.data(), static_cast<std::streamsize>(dst.pos));
+        } while (last ? remaining != 0 : src.pos < src.size);
+        if (last) {
+            break;
+        }
+    }
+    if (in.bad()) {
+        return false;
+    }
+    out.close();
+    return static_cast<bool>(out);
 #else
-    std::string cmd = "zstd -" + std::to_string(level) + " -q -f \"" + source_path + "\" -o \"" + dest_path + "\"";
-    return std::system(cmd.c_str()) == 0;
+    (void)source_path;
+    (void)dest_path;
+    (void)level;
+    (void)workers;
+    (void)long_distance_matching;
+    (void)dictionary;
+    return false;
 #endif
 }
 
@@ -297,7 +875,7 @@ bool CompressionUtils::is_gzip_available() {
 #ifdef XLOG_HAS_ZLIB
     return true;
 #else
-    return std::system("which gzip > /dev/null 2>&1") == 0;
+    return false;
 #endif
 }
 
@@ -305,18 +883,28 @@ bool CompressionUtils::is_zstd_available() {
 #ifdef XLOG_HAS_ZSTD
     return true;
 #else
-    return std::system("which zstd > /dev/null 2>&1") == 0;
+    return false;
 #endif
 }
 
 void CompressedFileSink::enable_auto_tune(bool enable) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(stats_mutex_);
     options_.auto_tune = enable;
     if (enable) {
         current_level_ = options_.level;
     }
 }
 
+bool CompressedFileSink::is_auto_tune_enabled() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return options_.auto_tune;
+}
+
+int CompressedFileSink::get_current_compression_level() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return current_level_;
+}
+
 void CompressedFileSink::update_compression_level() {
     if (compression_count_ < 3) {
         return;
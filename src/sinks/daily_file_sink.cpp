@@ -1,39 +1,69 @@
 #include "Zyrnix/sinks/daily_file_sink.hpp"
 #include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
 #include <filesystem>
 namespace fs = std::filesystem;
 
 namespace Zyrnix {
 
-DailyFileSink::DailyFileSink(const std::string& base) : base_name(base) {
-    current_date = get_date();
+DailyFileSink::DailyFileSink(const std::string& base, const FlushPolicy& policy)
+    : base_name(base), buffer(policy) {
+    current_date.assign(get_date());
+    next_rollover_ns = next_local_rollover_ns(std::chrono::system_clock::now(), true);
     open_file();
+    BackgroundFlusher::instance().add(this, policy.interval);
 }
 
-std::string DailyFileSink::get_date() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm_buf;
-    localtime_r(&t, &tm_buf);
-    char buf[16];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm_buf);
-    return std::string(buf);
+DailyFileSink::~DailyFileSink() {
+    BackgroundFlusher::instance().remove(this);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (file.is_open()) {
+        buffer.write_out(file);
+    }
+}
+
+std::string_view DailyFileSink::get_date() {
+    return TimestampCache::local(std::chrono::system_clock::now()).substr(0, 10);
 }
 
 void DailyFileSink::open_file() {
+    // Unbuffered, as LineBuffer does the buffering; set before each open
+    file.rdbuf()->pubsetbuf(nullptr, 0);
     file.open(base_name + "_" + current_date + ".log", std::ios::app);
 }
 
 void DailyFileSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
-    if (level < get_level()) return;
+    log_as_record(logger_name, level, message);
+}
+
+void DailyFileSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    write_line(record.formatted(formatter), record.level());
+}
+
+void DailyFileSink::write_line(const std::string& line, LogLevel level) {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string today = get_date();
-    if (today != current_date) {
-        current_date = today;
+    // One integer compare per line; the date is only formatted at midnight
+    if (realtime_coarse_ns() >= next_rollover_ns) {
+        // Yesterday's lines go to yesterday's file
+        if (file.is_open()) {
+            buffer.write_out(file);
+        }
+        current_date.assign(get_date());
+        next_rollover_ns = next_local_rollover_ns(std::chrono::system_clock::now(), true);
         file.close();
         open_file();
     }
-    file << formatter.format(logger_name, level, message) << std::endl;
+    if (file.is_open()) {
+        buffer.append(file, line, level);
+    }
+}
+
+void DailyFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (file.is_open()) {
+        buffer.write_out(file);
+    }
 }
 
 }
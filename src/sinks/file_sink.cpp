@@ -1,25 +1,100 @@
 #include "Zyrnix/sinks/file_sink.hpp"
 #include "Zyrnix/log_sink.hpp"
-#include "Zyrnix/util.hpp"
-#include <fstream>
 #include <mutex>
 
 namespace Zyrnix {
 
-FileSink::FileSink(const std::string& filename) {
-#ifdef _WIN32
-    std::wstring wpath = path::to_native(filename);
-    file.open(wpath, std::ios::app);
-#else
-    file.open(filename, std::ios::app);
-#endif
+FileSink::FileSink(const std::string& filename, const FlushPolicy& policy)
+    : buffer(policy), file(policy.backend, policy.buffer_size) {
+    file.open(filename);
+    if (policy.sync_on) {
+        start_commit();
+    }
+    BackgroundFlusher::instance().add(this, policy.interval);
+}
+
+FileSink::~FileSink() {
+    BackgroundFlusher::instance().remove(this);
+    commit.reset();  // Serves the syncs still waiting
+    std::lock_guard<std::mutex> lock(mtx);
+    if (file.is_open()) {
+        buffer.write_out(file);
+        file.close();
+    }
 }
 
 void FileSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
-    if (level < get_level()) return;
+    log_as_record(logger_name, level, message);
+}
+
+void FileSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    write_line(record.formatted(formatter), record.level());
+}
+
+void FileSink::write_line(const std::string& line, LogLevel level) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file.is_open()) return;
+        buffer.append(file, line, level);
+    }
+    if (durable(level)) {
+        commit->request().wait();
+    }
+}
+
+void FileSink::log_batch(std::span<const FormattedRecord> records) {
+    bool sync = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file.is_open()) return;
+
+        for (const auto& record : records) {
+            if (record.level() < get_level()) continue;
+            buffer.append(file, record.formatted(formatter), record.level());
+            sync = sync || durable(record.level());
+        }
+    }
+    // One wait covers the whole batch
+    if (sync) {
+        commit->request().wait();
+    }
+}
+
+bool FileSink::durable(LogLevel level) const {
+    const auto& sync_on = buffer.policy().sync_on;
+    return sync_on && level >= *sync_on;
+}
+
+std::future<void> FileSink::sync() {
+    GroupCommit* committer;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!commit) {
+            start_commit();
+        }
+        committer = commit.get();
+    }
+    return committer->request();
+}
+
+void FileSink::start_commit() {
+    commit = std::make_unique<GroupCommit>([this] {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file.is_open()) {
+            return -1;
+        }
+        buffer.write_out(file);
+        file.wait();
+        return file.open_for_sync();
+    });
+}
+
+void FileSink::flush() {
     std::lock_guard<std::mutex> lock(mtx);
     if (file.is_open()) {
-        file << formatter.format(logger_name, level, message) << std::endl;
+        buffer.write_out(file);
+        file.wait();
     }
 }
 
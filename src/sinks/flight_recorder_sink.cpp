@@ -0,0 +1,161 @@
+#include "Zyrnix/sinks/flight_recorder_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/binary_log.hpp"
+#include "Zyrnix/buffer_memory.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/util.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace Zyrnix {
+
+namespace {
+
+// A file already holding a recording of this capacity, to carry on after
+bool reusable(const flight::Header& header, uint64_t capacity) {
+    return std::memcmp(header.magic, flight::magic, sizeof(flight::magic)) == 0 &&
+           header.version.load(std::memory_order_acquire) == flight::format_version &&
+           header.header_size == flight::header_size && header.capacity == capacity;
+}
+
+void store_commit(char* entry, uint64_t value) {
+    std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(entry)).store(value, std::memory_order_release);
+}
+
+}
+
+FlightRecorderSink::FlightRecorderSink(const std::string& path, const FlightRecorderOptions& options)
+    : path_(path) {
+    capacity_ = std::bit_ceil(std::max<uint64_t>(options.capacity, 4096));
+    const size_t size = flight::header_size + static_cast<size_t>(capacity_);
+
+    const int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "FlightRecorderSink: cannot open " << path_ << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    struct stat st;
+    const bool existing = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size;
+    // Allocated up front: writing into a hole the disk has no room for
+    // would be a SIGBUS instead of an error here
+    int err = ftruncate(fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+#ifdef __linux__
+    if (err == 0) {
+        err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+    }
+#endif
+    void* map = MAP_FAILED;
+    if (err == 0) {
+        map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        err = map == MAP_FAILED ? errno : 0;
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "FlightRecorderSink: cannot map " << path_ << ": " << std::strerror(err) << std::endl;
+        return;
+    }
+
+    // Faulted in and locked as BufferMemory says, like MmapFileSink's
+    // segments, so a line is never held up by a page fault or swap-in
+    prepare_mapping(map, size);
+
+    auto* header = static_cast<flight::Header*>(map);
+    if (existing && reusable(*header, capacity_)) {
+        ++header->generation;
+    } else {
+        // Anything else is replaced; zeroed, no commit word reads as written
+        std::memset(map, 0, size);
+        header = new (map) flight::Header{};
+        std::memcpy(header->magic, flight::magic, sizeof(flight::magic));
+        header->header_size = flight::header_size;
+        header->capacity = capacity_;
+        header->generation = 1;
+        header->version.store(flight::format_version, std::memory_order_release);
+    }
+    header_ = header;
+    data_ = static_cast<char*>(map) + flight::header_size;
+    mapped_size_ = size;
+}
+
+FlightRecorderSink::~FlightRecorderSink() {
+    if (header_) {
+        munmap(header_, mapped_size_);
+    }
+}
+
+void FlightRecorderSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    write(LogClock::now(), level, current_thread_id(), logger_name, message);
+}
+
+void FlightRecorderSink::log_record(const FormattedRecord& record) {
+    write(record.timestamp(), record.level(), record.thread_id(), record.logger_name(), record.message());
+}
+
+void FlightRecorderSink::flush() {
+    if (header_) {
+        msync(header_, mapped_size_, MS_ASYNC);
+    }
+}
+
+void FlightRecorderSink::write(std::chrono::system_clock::time_point timestamp, LogLevel level, uint64_t thread_id,
+                               std::string_view logger_name, std::string_view message) {
+    if (!header_) {
+        return;
+    }
+    logger_name = logger_name.substr(0, UINT16_MAX);
+    const uint64_t payload = flight::record_header_size + logger_name.size() + message.size();
+    const uint64_t size = (flight::entry_header_size + payload + flight::entry_alignment - 1) &
+                          ~static_cast<uint64_t>(flight::entry_alignment - 1);
+    if (size > capacity_ / 4) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Reserve the entry, and the padding to the end of the ring if it
+    // would wrap. Nothing waits for a reader: the oldest entries go.
+    uint64_t pos = header_->head.load(std::memory_order_relaxed);
+    uint64_t pad;
+    do {
+        const uint64_t offset = pos & (capacity_ - 1);
+        pad = capacity_ - offset < size ? capacity_ - offset : 0;
+    } while (!header_->head.compare_exchange_weak(pos, pos + pad + size, std::memory_order_relaxed,
+                                                  std::memory_order_relaxed));
+
+    if (pad > 0) {
+        char* entry = data_ + (pos & (capacity_ - 1));
+        const uint32_t pad_size = static_cast<uint32_t>(pad - flight::entry_header_size) | flight::padding_flag;
+        std::memcpy(entry + 8, &pad_size, sizeof(pad_size));
+        store_commit(entry, pos + 1);
+        pos += pad;
+    }
+
+    char* entry = data_ + (pos & (capacity_ - 1));
+    char* p = entry + flight::entry_header_size;
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    const uint32_t generation = static_cast<uint32_t>(header_->generation);
+    const uint8_t level_byte[2] = {static_cast<uint8_t>(level), 0};
+    const uint16_t name_size = static_cast<uint16_t>(logger_name.size());
+    std::memcpy(p, &ns, sizeof(ns));
+    std::memcpy(p + 8, &thread_id, sizeof(thread_id));
+    std::memcpy(p + 16, &generation, sizeof(generation));
+    std::memcpy(p + 20, level_byte, sizeof(level_byte));
+    std::memcpy(p + 22, &name_size, sizeof(name_size));
+    std::memcpy(p + flight::record_header_size, logger_name.data(), logger_name.size());
+    std::memcpy(p + flight::record_header_size + logger_name.size(), message.data(), message.size());
+
+    const uint32_t payload_size = static_cast<uint32_t>(payload);
+    const uint32_t crc = binlog::crc32c(p, payload);
+    std::memcpy(entry + 8, &payload_size, sizeof(payload_size));
+    std::memcpy(entry + 12, &crc, sizeof(crc));
+    store_commit(entry, pos + 1);
+}
+
+}
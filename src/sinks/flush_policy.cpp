@@ -0,0 +1,61 @@
+#include "Zyrnix/sinks/flush_policy.hpp"
+#include "Zyrnix/log_sink.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <algorithm>
+
+namespace Zyrnix {
+
+LineBuffer::LineBuffer(const FlushPolicy& policy) : policy_(policy) {
+    policy_.buffer_size = std::max<size_t>(policy_.buffer_size, 1);
+    buffer_.reserve(policy_.buffer_size);
+}
+
+BackgroundFlusher& BackgroundFlusher::instance() {
+    // Leaked, so it outlives every static logger's sinks
+    static BackgroundFlusher* flusher = new BackgroundFlusher;
+    return *flusher;
+}
+
+void BackgroundFlusher::add(LogSink* sink, std::chrono::milliseconds interval) {
+    if (!sink || interval.count() <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    entries_.push_back({sink, interval, std::chrono::steady_clock::now() + interval});
+    if (!started_) {
+        started_ = true;
+        std::thread(&BackgroundFlusher::run, this).detach();
+    }
+    cv_.notify_one();
+}
+
+void BackgroundFlusher::remove(LogSink* sink) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::erase_if(entries_, [sink](const Entry& entry) { return entry.sink == sink; });
+}
+
+void BackgroundFlusher::run() {
+    init_background_thread("xlog-flush");
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+        if (entries_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto next = std::min_element(entries_.begin(), entries_.end(),
+                                     [](const Entry& a, const Entry& b) { return a.due < b.due; })->due;
+        if (cv_.wait_until(lock, next) == std::cv_status::no_timeout) {
+            continue;  // A sink came or went; look again
+        }
+        const auto now = std::chrono::steady_clock::now();
+        // Flushed under mtx_, which is what lets remove() wait for it
+        for (auto& entry : entries_) {
+            if (entry.due <= now) {
+                entry.sink->flush();
+                entry.due = now + entry.interval;
+            }
+        }
+    }
+}
+
+}
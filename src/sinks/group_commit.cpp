@@ -0,0 +1,76 @@
+#include "Zyrnix/sinks/group_commit.hpp"
+#include "Zyrnix/sinks/log_file.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <cerrno>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace Zyrnix {
+
+GroupCommit::GroupCommit(WriteOut write_out) : write_out_(std::move(write_out)) {
+    thread_ = std::thread(&GroupCommit::run, this);
+}
+
+GroupCommit::~GroupCommit() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+std::future<void> GroupCommit::request() {
+    std::promise<void> promise;
+    auto done = promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        waiting_.push_back(std::move(promise));
+    }
+    cv_.notify_one();
+    return done;
+}
+
+void GroupCommit::run() {
+    init_background_thread("xlog-commit");
+    std::vector<std::promise<void>> round;
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+        cv_.wait(lock, [this] { return stop_ || !waiting_.empty(); });
+        if (waiting_.empty()) {
+            return;  // Stopping
+        }
+        round.swap(waiting_);
+        lock.unlock();
+
+        // Everything the round's callers logged is in the buffer by now
+        const int fd = write_out_();
+        int error = 0;
+        if (fd >= 0) {
+            if (!LogFile::sync_descriptor(fd)) {
+                error = errno ? errno : EIO;
+            }
+            syncs_.fetch_add(1, std::memory_order_relaxed);
+#if defined(__unix__) || defined(__APPLE__)
+            ::close(fd);
+#endif
+        } else {
+            error = EBADF;
+        }
+        for (auto& promise : round) {
+            if (error) {
+                promise.set_exception(std::make_exception_ptr(
+                    std::system_error(error, std::generic_category(), "log sync failed")));
+            } else {
+                promise.set_value();
+            }
+        }
+        round.clear();
+        lock.lock();
+    }
+}
+
+}
@@ -0,0 +1,373 @@
+#include "Zyrnix/sinks/http_transport.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <algorithm>
+#include <charconv>
+#include <future>
+#include <string_view>
+#include <strings.h>
+#include <thread>
+#include <utility>
+#include <curl/curl.h>
+
+namespace Zyrnix {
+
+namespace {
+
+struct GrpcStatus {
+    int status = -1;
+    std::string message;
+};
+
+}
+
+struct HttpTransport::Transfer {
+    HttpRequest request;
+    HttpCompletion done;
+    CURL* easy = nullptr;
+    curl_slist* headers = nullptr;
+    std::string response;
+    std::vector<std::string> response_headers;  // With request.capture_headers
+    GrpcStatus grpc;  // From the trailers of a gRPC call
+    int attempts = 0;
+    std::chrono::steady_clock::time_point retry_at{};
+};
+
+namespace {
+
+size_t append_response(char* data, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append(data, size * nmemb);
+    return size * nmemb;
+}
+
+// gRPC sends grpc-status in the trailers, or in the headers of a reply
+// with no body; curl hands both to the header callback
+size_t read_grpc_header(char* data, size_t size, size_t nmemb, void* userp) {
+    auto* grpc = static_cast<GrpcStatus*>(userp);
+    std::string_view line(data, size * nmemb);
+    const size_t colon = line.find(':');
+    if (colon != std::string_view::npos) {
+        const std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == '\r' || value.back() == '\n')) value.remove_suffix(1);
+        if (name.size() == 11 && strncasecmp(name.data(), "grpc-status", 11) == 0) {
+            int status = -1;
+            std::from_chars(value.data(), value.data() + value.size(), status);
+            grpc->status = status;
+        } else if (name.size() == 12 && strncasecmp(name.data(), "grpc-message", 12) == 0) {
+            grpc->message.assign(value);
+        }
+    }
+    return size * nmemb;
+}
+
+size_t append_header(char* data, size_t size, size_t nmemb, void* userp) {
+    std::string_view line(data, size * nmemb);
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.remove_suffix(1);
+    if (line.find(':') != std::string_view::npos) {
+        static_cast<std::vector<std::string>*>(userp)->emplace_back(line);
+    }
+    return size * nmemb;
+}
+
+// CANCELLED, DEADLINE_EXCEEDED, RESOURCE_EXHAUSTED, ABORTED, OUT_OF_RANGE,
+// UNAVAILABLE and DATA_LOSS, as the OTLP specification lists them
+bool retryable_grpc(int status) {
+    switch (status) {
+        case 1: case 4: case 8: case 10: case 11: case 14: case 15: return true;
+        default: return false;
+    }
+}
+
+bool retryable(CURLcode result, long status, const GrpcStatus* grpc) {
+    if (grpc && result == CURLE_OK && status == 200) {
+        return retryable_grpc(grpc->status);
+    }
+    return result != CURLE_OK || status == 429 || status >= 500;
+}
+
+}
+
+HttpTransport& HttpTransport::instance() {
+    // Leaked, so it outlives every static logger's sinks
+    static HttpTransport* transport = new HttpTransport;
+    return *transport;
+}
+
+HttpTransport::HttpTransport() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    multi_ = curl_multi_init();
+}
+
+void HttpTransport::start() {
+    if (!started_) {
+        started_ = true;
+        std::thread(&HttpTransport::run, this).detach();
+    }
+}
+
+void HttpTransport::set_options(const Options& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        options_changed_ = true;
+    }
+    curl_multi_wakeup(static_cast<CURLM*>(multi_));
+}
+
+void HttpTransport::attach(Client* client) {
+    {
+        std::lock_guard<std::mutex> clients_lock(clients_mutex_);
+        clients_.push_back({client, std::chrono::steady_clock::now()});
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    start();
+}
+
+void HttpTransport::detach(Client* client) {
+    std::lock_guard<std::mutex> clients_lock(clients_mutex_);
+    std::erase_if(clients_, [client](const ClientEntry& entry) { return entry.client == client; });
+}
+
+void HttpTransport::wake() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        woken_ = true;
+    }
+    curl_multi_wakeup(static_cast<CURLM*>(multi_));
+}
+
+void HttpTransport::submit(HttpRequest request, HttpCompletion done) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    transfer->done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.push_back(std::move(transfer));
+        start();
+    }
+    curl_multi_wakeup(static_cast<CURLM*>(multi_));
+}
+
+HttpResponse HttpTransport::post(HttpRequest request) {
+    std::promise<HttpResponse> promise;
+    auto result = promise.get_future();
+    submit(std::move(request), [&promise](const HttpResponse& response, int, HttpRequest&) { promise.set_value(response); });
+    return result.get();
+}
+
+HttpTransport::Stats HttpTransport::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{requests_, retries_, failures_, in_flight_, queued_.size()};
+}
+
+void HttpTransport::run() {
+    init_background_thread("xlog-http");
+    CURLM* multi = static_cast<CURLM*>(multi_);
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        bool woken;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken = std::exchange(woken_, false);
+            if (std::exchange(options_changed_, false)) {
+                curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, options_.max_host_connections);
+                curl_multi_setopt(multi, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX));
+            }
+        }
+
+        auto next = now + std::chrono::seconds(1);
+        {
+            std::lock_guard<std::mutex> clients_lock(clients_mutex_);
+            for (auto& entry : clients_) {
+                if (woken || entry.due <= now) {
+                    entry.due = entry.client->pump(*this);
+                }
+                next = std::min(next, entry.due);
+            }
+        }
+
+        // Retries whose delay is over go ahead of new requests
+        for (auto it = backing_off_.begin(); it != backing_off_.end();) {
+            if ((*it)->retry_at <= now) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queued_.push_front(std::move(*it));
+                it = backing_off_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        start_transfers();
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        int left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &left)) {
+            if (msg->msg == CURLMSG_DONE) {
+                Transfer* transfer = nullptr;
+                curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+                finish(transfer, msg->data.result);
+            }
+        }
+        for (const auto& transfer : backing_off_) {
+            next = std::min(next, transfer->retry_at);  // Including retries finish() just scheduled
+        }
+
+        bool startable;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            startable = !queued_.empty() && active_.size() < options_.max_in_flight;
+        }
+        const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - std::chrono::steady_clock::now());
+        const int timeout_ms = startable ? 0 : static_cast<int>(std::clamp<int64_t>(wait.count(), 0, 1000));
+        curl_multi_poll(multi, nullptr, 0, timeout_ms, nullptr);
+    }
+}
+
+void HttpTransport::start_transfers() {
+    CURLM* multi = static_cast<CURLM*>(multi_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!queued_.empty() && active_.size() < options_.max_in_flight) {
+        std::unique_ptr<Transfer> transfer = std::move(queued_.front());
+        queued_.pop_front();
+        if (transfer->attempts == 0) {
+            ++in_flight_;
+        }
+        lock.unlock();
+
+        if (!transfer->easy) {
+            CURL* easy = nullptr;
+            if (!idle_handles_.empty()) {
+                easy = static_cast<CURL*>(idle_handles_.back());
+                idle_handles_.pop_back();
+            } else {
+                easy = curl_easy_init();
+            }
+            if (!easy) {
+                HttpResponse response;
+                response.error = "curl_easy_init failed";
+                lock.lock();
+                ++requests_;
+                ++failures_;
+                --in_flight_;
+                lock.unlock();
+                if (transfer->done) {
+                    transfer->done(response, 0, transfer->request);
+                }
+                lock.lock();
+                continue;
+            }
+
+            const HttpRequest& request = transfer->request;
+            for (const auto& header : request.headers) {
+                transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+            }
+            curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+            if (!request.method.empty()) {
+                curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+            }
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request.body.data());
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request.body.size()));
+            curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer->headers);
+            curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, request.timeout_ms > 0 ? request.timeout_ms : 0L);
+            if (!request.ca_cert_path.empty()) {
+                curl_easy_setopt(easy, CURLOPT_CAINFO, request.ca_cert_path.c_str());
+            }
+            curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, request.insecure_skip_verify ? 0L : 1L);
+            curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, request.insecure_skip_verify ? 0L : 2L);
+            curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+            curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+            if (!request.aws_sigv4.empty()) {
+#if LIBCURL_VERSION_NUM >= 0x074b00
+                curl_easy_setopt(easy, CURLOPT_AWS_SIGV4, request.aws_sigv4.c_str());
+                curl_easy_setopt(easy, CURLOPT_USERPWD, request.credentials.c_str());
+#endif
+            }
+            if (request.max_send_speed > 0) {
+                curl_easy_setopt(easy, CURLOPT_MAX_SEND_SPEED_LARGE, static_cast<curl_off_t>(request.max_send_speed));
+            }
+            if (request.grpc) {
+                const bool cleartext = request.url.compare(0, 7, "http://") == 0;
+                curl_easy_setopt(easy, CURLOPT_HTTP_VERSION,
+                                 static_cast<long>(cleartext ? CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE
+                                                             : CURL_HTTP_VERSION_2_0));
+                curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, read_grpc_header);
+                curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer->grpc);
+            } else {
+                curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+                if (request.capture_headers) {
+                    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, append_header);
+                    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer->response_headers);
+                }
+            }
+            curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);  // Prefer multiplexing onto an open connection
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, append_response);
+            curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer->response);
+            curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer.get());
+            transfer->easy = easy;
+        }
+
+        transfer->response.clear();
+        transfer->response_headers.clear();
+        transfer->grpc = GrpcStatus{};
+        ++transfer->attempts;
+        curl_multi_add_handle(multi, transfer->easy);
+        active_.push_back(std::move(transfer));
+        lock.lock();
+    }
+}
+
+void HttpTransport::finish(Transfer* transfer, int result_code) {
+    const auto result = static_cast<CURLcode>(result_code);
+    CURL* easy = transfer->easy;
+    long status = 0;
+    if (result == CURLE_OK) {
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+    }
+    curl_multi_remove_handle(static_cast<CURLM*>(multi_), easy);
+
+    auto it = std::find_if(active_.begin(), active_.end(),
+                           [transfer](const std::unique_ptr<Transfer>& t) { return t.get() == transfer; });
+    std::unique_ptr<Transfer> owned = std::move(*it);
+    active_.erase(it);
+
+    if (retryable(result, status, owned->request.grpc ? &owned->grpc : nullptr) && owned->attempts < owned->request.max_attempts) {
+        const long delay = owned->request.retry_delay_ms << (owned->attempts - 1);
+        owned->retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++retries_;
+        }
+        backing_off_.push_back(std::move(owned));
+        return;
+    }
+
+    HttpResponse response;
+    response.success = result == CURLE_OK;
+    response.status_code = static_cast<int>(status);
+    response.body = std::move(owned->response);
+    response.headers = std::move(owned->response_headers);
+    if (!response.success) {
+        response.error = curl_easy_strerror(result);
+    } else if (owned->request.grpc) {
+        response.grpc_status = owned->grpc.status;
+        response.error = std::move(owned->grpc.message);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++requests_;
+        if (status < 200 || status >= 300 || (owned->request.grpc && response.grpc_status != 0)) {
+            ++failures_;
+        }
+        --in_flight_;
+    }
+    if (owned->done) {
+        owned->done(response, owned->attempts, owned->request);
+    }
+
+    curl_slist_free_all(owned->headers);
+    curl_easy_reset(easy);  // The connection stays in the multi handle's cache
+    idle_handles_.push_back(easy);
+}
+
+}
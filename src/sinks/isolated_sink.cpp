@@ -0,0 +1,204 @@
+#ifndef XLOG_NO_ASYNC
+#include "Zyrnix/sinks/isolated_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#ifndef XLOG_NO_METRICS
+#include "Zyrnix/log_metrics.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+AsyncQueueOptions make_queue_options(const SinkOptions& options) {
+    AsyncQueueOptions queue_options;
+    queue_options.backend = QueueBackend::Mutex;
+    queue_options.capacity = options.queue_capacity;
+    queue_options.overflow_policy = options.overflow_policy;
+    queue_options.block_timeout_ms = options.block_timeout_ms;
+    queue_options.shutdown_timeout_ms = options.shutdown_timeout_ms;
+    return queue_options;
+}
+
+}
+
+IsolatedSink::IsolatedSink(LogSinkPtr inner, const std::string& name, const SinkOptions& options)
+    : inner_(std::move(inner))
+    , options_(options)
+    , queue_(make_queue_options(options))
+{
+    if (options_.max_batch_size == 0) {
+        options_.max_batch_size = 1;
+    }
+#ifndef XLOG_NO_METRICS
+    metrics_ = MetricsRegistry::instance().get_sink_metrics(name);
+    queue_.set_drop_callback([metrics = metrics_](uint64_t count, uint64_t) {
+        metrics->record_dropped(count);
+    });
+#else
+    (void)name;
+#endif
+    worker_ = std::thread(&IsolatedSink::worker_loop, this);
+}
+
+IsolatedSink::~IsolatedSink() {
+    stop();
+}
+
+void IsolatedSink::stop() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    queue_.shutdown(true);
+    worker_.join();
+#ifndef XLOG_NO_METRICS
+    metrics_->record_dropped(queue_.dropped_on_shutdown());
+    metrics_->update_queue_depth(0);
+#endif
+}
+
+void IsolatedSink::log(const std::string& name, LogLevel level, const std::string& message) {
+    if (level < inner_->get_level()) {
+        return;
+    }
+    LogRecord record;
+    record.logger_name = name;
+    record.level = level;
+    record.message = message;
+    record.timestamp = LogClock::now();
+    record.thread_id = current_thread_id();
+    enqueue(std::move(record));
+}
+
+void IsolatedSink::log_record(const FormattedRecord& record) {
+    if (record.level() < inner_->get_level()) {
+        return;
+    }
+    enqueue(record);
+}
+
+void IsolatedSink::log_batch(std::span<const FormattedRecord> records) {
+    for (const auto& record : records) {
+        if (record.level() < inner_->get_level()) {
+            continue;
+        }
+        enqueue(record);
+    }
+}
+
+void IsolatedSink::flush() {
+    auto fence = std::make_shared<LogFence>();
+    fence->flush_sinks = true;
+    auto done = fence->done.get_future();
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(options_.shutdown_timeout_ms);
+
+    LogRecord marker;
+    marker.level = LogLevel::Trace;
+    marker.timestamp = LogClock::now();
+    marker.fence = fence;
+    // Unlike log records the fence must not be dropped when the queue is full
+    while (!queue_.push(std::move(marker))) {
+        if (queue_.is_shutting_down() || std::chrono::steady_clock::now() >= deadline) {
+            return;
+        }
+        std::this_thread::yield();
+        marker.fence = fence;
+    }
+    done.wait_until(deadline);
+}
+
+// The FormattedRecord does not outlive the call, so keep a copy carrying
+// the message this sink was given (which may be redacted)
+void IsolatedSink::enqueue(const FormattedRecord& record) {
+    LogRecord copy;
+    copy.logger_name = record.logger_name();
+    copy.level = record.level();
+    copy.message = record.message();
+    copy.timestamp = record.timestamp();
+    copy.thread_id = record.thread_id();
+    copy.fields = record.fields();
+    copy.trace = record.trace();
+    enqueue(std::move(copy));
+}
+
+void IsolatedSink::enqueue(LogRecord record) {
+    record.fence.reset();
+    if (!queue_.push(std::move(record)) && queue_.is_shutting_down()) {
+#ifndef XLOG_NO_METRICS
+        metrics_->record_dropped();
+#endif
+    }
+}
+
+void IsolatedSink::worker_loop() {
+    init_background_thread("xlog-sink");
+    std::vector<LogRecord> batch;
+    std::vector<LogRecord> segment;
+    batch.reserve(options_.max_batch_size);
+    for (;;) {
+        batch.clear();
+        if (!queue_.pop_bulk(batch, options_.max_batch_size)) {
+            break;
+        }
+        if (batch.empty()) {
+            continue;
+        }
+#ifndef XLOG_NO_METRICS
+        metrics_->update_queue_depth(queue_.size());
+#endif
+        // Write everything ahead of a fence, flush, then complete it
+        segment.clear();
+        for (auto& record : batch) {
+            if (!record.fence) {
+                segment.push_back(std::move(record));
+                continue;
+            }
+            write_batch(segment);
+            segment.clear();
+            try {
+                inner_->flush();
+#ifndef XLOG_NO_METRICS
+                metrics_->record_flush();
+#endif
+            } catch (...) {
+#ifndef XLOG_NO_METRICS
+                metrics_->record_error();
+#endif
+            }
+            record.fence->done.set_value();
+            record.fence.reset();
+        }
+        write_batch(segment);
+    }
+}
+
+void IsolatedSink::write_batch(std::vector<LogRecord>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+#ifndef XLOG_NO_METRICS
+    ScopedTimer timer([this](uint64_t ns) { metrics_->record_write_duration_ns(ns); }, ScopedTimer::Unit::Nanoseconds);
+#endif
+    try {
+        std::vector<RenderCache> caches(batch.size());
+        std::vector<FormattedRecord> records;
+        records.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            records.emplace_back(batch[i], caches[i]);
+        }
+        inner_->log_batch(records);
+#ifndef XLOG_NO_METRICS
+        for (const auto& record : batch) {
+            metrics_->record_write(record.message.size());
+        }
+#endif
+    } catch (...) {
+#ifndef XLOG_NO_METRICS
+        metrics_->record_error();
+#endif
+    }
+}
+
+}
+#endif
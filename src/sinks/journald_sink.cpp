@@ -0,0 +1,265 @@
+#include "Zyrnix/sinks/journald_sink.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr std::string_view priorities[] = {"PRIORITY=7\n", "PRIORITY=7\n", "PRIORITY=6\n",
+                                           "PRIORITY=4\n", "PRIORITY=3\n", "PRIORITY=2\n"};
+constexpr size_t max_name = 64;
+constexpr size_t fixed_scratch = 512;  // Names, CODE_LINE and the trace ids
+constexpr size_t scratch_per_field = 6 + max_name + 1 + 8;
+
+char newline[] = "\n";
+
+std::string program_name() {
+#if defined(__GLIBC__)
+    return program_invocation_short_name;
+#else
+    return "zyrnix";
+#endif
+}
+
+// Journal field names are [A-Z0-9_], at most 64 long, not starting with
+// a digit; a leading '_' marks fields only journald may set
+void append_field_name(std::string& out, std::string_view key) {
+    while (!key.empty() && key.front() == '_') {
+        key.remove_prefix(1);
+    }
+    const size_t start = out.size();
+    if (key.empty() || (key.front() >= '0' && key.front() <= '9')) {
+        out += "FIELD_";
+    }
+    for (char c : key) {
+        if (out.size() - start == max_name) {
+            break;
+        }
+        if (c >= 'a' && c <= 'z') {
+            out += static_cast<char>(c - 'a' + 'A');
+        } else if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+            out += c;
+        } else {
+            out += '_';
+        }
+    }
+}
+
+/**
+ * Gathers one entry: names and lengths go to scratch, which is reserved
+ * up front so the iovecs pointing into it stay valid, values are
+ * referenced where they are
+ */
+class Entry {
+public:
+    Entry(std::string& scratch, std::vector<iovec>& iov, size_t reserve) : scratch_(scratch), iov_(iov) {
+        scratch_.clear();
+        scratch_.reserve(reserve);
+        iov_.clear();
+    }
+
+    void add_fixed(std::string_view text) { push(text.data(), text.size()); }
+
+    void add(std::string_view name, std::string_view value) {
+        const size_t start = scratch_.size();
+        scratch_ += name;
+        finish(start, value);
+    }
+
+    void add_record_field(std::string_view key, std::string_view value) {
+        const size_t start = scratch_.size();
+        append_field_name(scratch_, key);
+        finish(start, value);
+    }
+
+    void add_scratch(size_t start) { push(scratch_.data() + start, scratch_.size() - start); }
+
+    std::string& scratch() { return scratch_; }
+
+private:
+    void push(const char* data, size_t size) { iov_.push_back({const_cast<char*>(data), size}); }
+
+    // NAME=value\n, or NAME\n<le64 size>value\n when the value spans lines
+    void finish(size_t start, std::string_view value) {
+        if (value.find('\n') == std::string_view::npos) {
+            scratch_ += '=';
+        } else {
+            scratch_ += '\n';
+            uint64_t size = value.size();
+            char bytes[8];
+            for (char& byte : bytes) {
+                byte = static_cast<char>(size & 0xff);
+                size >>= 8;
+            }
+            scratch_.append(bytes, sizeof(bytes));
+        }
+        add_scratch(start);
+        push(value.data(), value.size());
+        push(newline, 1);
+    }
+
+    std::string& scratch_;
+    std::vector<iovec>& iov_;
+};
+
+}
+
+JournaldSink::JournaldSink(const JournaldOptions& options) {
+    std::memset(&addr_, 0, sizeof(addr_));
+    addr_.sun_family = AF_UNIX;
+    if (options.socket_path.size() >= sizeof(addr_.sun_path)) {
+        std::cerr << "JournaldSink: socket path too long: " << options.socket_path << std::endl;
+        return;
+    }
+    std::memcpy(addr_.sun_path, options.socket_path.c_str(), options.socket_path.size());
+
+    identifier_ = "SYSLOG_IDENTIFIER=";
+    identifier_ += options.identifier.empty() ? program_name() : options.identifier;
+    std::replace(identifier_.begin(), identifier_.end(), '\n', ' ');
+    identifier_ += '\n';
+
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        std::cerr << "JournaldSink: cannot create socket: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    // As libsystemd does: large entries are worth a bigger buffer, and
+    // go through a memfd past it
+    const int size = 8 * 1024 * 1024;
+    setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+}
+
+JournaldSink::~JournaldSink() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void JournaldSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    write(logger_name, level, message, nullptr);
+}
+
+void JournaldSink::log_record(const FormattedRecord& record) {
+    write(record.logger_name(), record.level(), record.message(), &record);
+}
+
+void JournaldSink::write(std::string_view logger_name, LogLevel level, std::string_view message,
+                         const FormattedRecord* record) {
+    if (fd_ < 0) return;
+    const FieldList* fields = record && !record->fields().empty() ? &record->fields() : nullptr;
+    const size_t field_count = fields ? fields->size() : 0;
+
+    thread_local std::string scratch;
+    thread_local std::vector<iovec> iov;
+    Entry entry(scratch, iov, fixed_scratch + field_count * scratch_per_field);
+
+    entry.add("MESSAGE", message);
+    entry.add_fixed(priorities[std::clamp(static_cast<int>(level), 0, 5)]);
+    entry.add_fixed(identifier_);
+    if (!logger_name.empty()) {
+        entry.add("LOGGER", logger_name);
+    }
+
+    if (record) {
+        if (const LogSite* site = record->site()) {
+            entry.add("CODE_FILE", site->file);
+            const size_t start = entry.scratch().size();
+            char digits[16];
+            entry.scratch() += "CODE_LINE=";
+            entry.scratch().append(digits, std::to_chars(digits, digits + sizeof(digits), site->line).ptr);
+            entry.scratch() += '\n';
+            entry.add_scratch(start);
+            entry.add("CODE_FUNC", site->function);
+        }
+        const TraceContext& trace = record->trace();
+        if (trace.valid()) {
+            const size_t start = entry.scratch().size();
+            entry.scratch() += "TRACE_ID=";
+            trace.append_trace_id(entry.scratch());
+            entry.scratch() += "\nSPAN_ID=";
+            trace.append_span_id(entry.scratch());
+            entry.scratch() += '\n';
+            entry.add_scratch(start);
+        }
+    }
+
+    if (fields) {
+        for (const auto& field : *fields) {
+            entry.add_record_field(field.key, field.value.text());
+        }
+    }
+
+    send(iov.data(), iov.size());
+}
+
+void JournaldSink::send(iovec* iov, size_t count) {
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &addr_;
+    msg.msg_namelen = sizeof(addr_);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    for (;;) {
+        if (::sendmsg(fd_, &msg, MSG_NOSIGNAL) >= 0) {
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EMSGSIZE || errno == ENOBUFS) {
+            send_memfd(iov, count);
+        }
+        return;  // journald is not running: dropped, like sd_journal_sendv()
+    }
+}
+
+bool JournaldSink::send_memfd(iovec* iov, size_t count) {
+    const int memfd = memfd_create("journal-entry", MFD_ALLOW_SEALING | MFD_CLOEXEC);
+    if (memfd < 0) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t done = 0; ok && done < count;) {
+        const size_t batch = std::min<size_t>(count - done, IOV_MAX);
+        size_t expected = 0;
+        for (size_t i = done; i < done + batch; ++i) {
+            expected += iov[i].iov_len;
+        }
+        ok = ::writev(memfd, iov + done, static_cast<int>(batch)) == static_cast<ssize_t>(expected);
+        done += batch;
+    }
+    ok = ok && fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+
+    if (ok) {
+        // The entry is the passed file alone, with no payload
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        std::memset(control, 0, sizeof(control));
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &addr_;
+        msg.msg_namelen = sizeof(addr_);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+        ok = ::sendmsg(fd_, &msg, MSG_NOSIGNAL) >= 0;
+    }
+    ::close(memfd);
+    return ok;
+}
+
+}
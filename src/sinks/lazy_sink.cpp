@@ -0,0 +1,61 @@
+#include "Zyrnix/sinks/lazy_sink.hpp"
+#include <iostream>
+
+namespace Zyrnix {
+
+LazySink::LazySink(Factory factory, bool cloud) : factory_(std::move(factory)), cloud_(cloud) {}
+
+LogSink* LazySink::get() {
+    if (!open_.load(std::memory_order_acquire)) {
+        std::call_once(once_, [this] {
+            try {
+                inner_ = factory_();
+            } catch (const std::exception& e) {
+                std::cerr << "LazySink: opening sink failed: " << e.what() << std::endl;
+            }
+            if (inner_ && pending_formatter_) {
+                inner_->set_formatter(std::move(*pending_formatter_));
+            }
+            factory_ = nullptr;
+            open_.store(true, std::memory_order_release);
+        });
+    }
+    return inner_.get();
+}
+
+void LazySink::log(const std::string& logger_name, LogLevel lvl, const std::string& message) {
+    if (LogSink* sink = get()) {
+        sink->log(logger_name, lvl, message);
+    }
+}
+
+void LazySink::log_record(const FormattedRecord& record) {
+    if (LogSink* sink = get()) {
+        sink->log_record(record);
+    }
+}
+
+void LazySink::log_batch(std::span<const FormattedRecord> records) {
+    if (LogSink* sink = get()) {
+        sink->log_batch(records);
+    }
+}
+
+void LazySink::flush() {
+    if (is_open() && inner_) {
+        inner_->flush();
+    }
+}
+
+// Like every sink's, only called before the sink is shared
+void LazySink::set_formatter(Formatter f) {
+    if (is_open()) {
+        if (inner_) {
+            inner_->set_formatter(std::move(f));
+        }
+        return;
+    }
+    pending_formatter_ = std::move(f);
+}
+
+}
@@ -0,0 +1,446 @@
+#include "Zyrnix/sinks/log_file.hpp"
+#include "Zyrnix/util.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__linux__) && !defined(XLOG_NO_IO_URING) && __has_include(<linux/io_uring.h>)
+#define XLOG_HAS_IO_URING 1
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define XLOG_HAS_IO_URING 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Zyrnix {
+
+#if XLOG_HAS_IO_URING
+
+namespace {
+
+int uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int uring_register(int ring_fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+// Write all of data at offset on the calling thread, for what the ring
+// could not
+bool write_all(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        const ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+}
+
+struct LogFile::Ring {
+    struct Buffer {
+        char* data = nullptr;
+        size_t size = 0;
+        uint64_t offset = 0;
+        bool busy = false;
+    };
+
+    int ring_fd = -1;
+    bool fixed_buffers = false;
+    bool fixed_file = false;
+    bool want_fixed_file = false;
+    int file = -1;
+
+    void* sq_map = MAP_FAILED;
+    size_t sq_map_size = 0;
+    void* cq_map = MAP_FAILED;
+    size_t cq_map_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    size_t capacity = 0;
+    Buffer buffers[2];
+    size_t next = 0;  // The buffer to fill next
+    unsigned in_flight = 0;
+    uint64_t* errors = nullptr;
+
+    static std::unique_ptr<Ring> create(size_t buffer_size, bool registered, uint64_t* errors);
+    ~Ring();
+
+    bool map(const io_uring_params& params);
+    void attach(int fd);
+    void detach();
+    bool submit(size_t index);
+    void reap();
+    void wait_one();
+    void complete(const io_uring_cqe& cqe);
+};
+
+std::unique_ptr<LogFile::Ring> LogFile::Ring::create(size_t buffer_size, bool registered, uint64_t* errors) {
+    auto ring = std::make_unique<Ring>();
+    ring->errors = errors;
+    io_uring_params params{};
+    ring->ring_fd = uring_setup(4, &params);
+    if (ring->ring_fd < 0 || !ring->map(params)) {
+        return nullptr;
+    }
+
+    constexpr size_t page = 4096;
+    ring->capacity = (std::max<size_t>(buffer_size, 1) + page - 1) / page * page;
+    iovec iovs[2];
+    for (size_t i = 0; i < 2; ++i) {
+        ring->buffers[i].data = static_cast<char*>(std::aligned_alloc(page, ring->capacity));
+        if (!ring->buffers[i].data) {
+            return nullptr;
+        }
+        iovs[i].iov_base = ring->buffers[i].data;
+        iovs[i].iov_len = ring->capacity;
+    }
+    if (registered) {
+        // Pinned memory counts against RLIMIT_MEMLOCK; without it the
+        // plain opcodes still work
+        ring->fixed_buffers = uring_register(ring->ring_fd, IORING_REGISTER_BUFFERS, iovs, 2) == 0;
+        ring->want_fixed_file = true;
+    }
+    return ring;
+}
+
+bool LogFile::Ring::map(const io_uring_params& params) {
+    sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        sq_map_size = cq_map_size = std::max(sq_map_size, cq_map_size);
+    }
+    sq_map = mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                  IORING_OFF_SQ_RING);
+    if (sq_map == MAP_FAILED) {
+        return false;
+    }
+    if (!single) {
+        cq_map = mmap(nullptr, cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                      IORING_OFF_CQ_RING);
+        if (cq_map == MAP_FAILED) {
+            return false;
+        }
+    }
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqe_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                         IORING_OFF_SQES);
+    if (sqe_map == MAP_FAILED) {
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(sqe_map);
+
+    char* sq = static_cast<char*>(sq_map);
+    char* cq = static_cast<char*>(single ? sq_map : cq_map);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+LogFile::Ring::~Ring() {
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+    if (cq_map != MAP_FAILED) munmap(cq_map, cq_map_size);
+    if (sq_map != MAP_FAILED) munmap(sq_map, sq_map_size);
+    if (ring_fd >= 0) ::close(ring_fd);  // Also drops the registrations
+    for (auto& buffer : buffers) {
+        std::free(buffer.data);
+    }
+}
+
+void LogFile::Ring::attach(int fd) {
+    file = fd;
+    if (want_fixed_file) {
+        fixed_file = uring_register(ring_fd, IORING_REGISTER_FILES, &fd, 1) == 0;
+    }
+}
+
+// Caller has waited for everything in flight
+void LogFile::Ring::detach() {
+    if (fixed_file) {
+        uring_register(ring_fd, IORING_UNREGISTER_FILES, nullptr, 0);
+        fixed_file = false;
+    }
+    file = -1;
+}
+
+bool LogFile::Ring::submit(size_t index) {
+    Buffer& buffer = buffers[index];
+    const unsigned tail = *sq_tail;
+    const unsigned slot = tail & *sq_mask;
+    io_uring_sqe& sqe = sqes[slot];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe.fd = fixed_file ? 0 : file;
+    sqe.flags = fixed_file ? IOSQE_FIXED_FILE : 0;
+    sqe.addr = reinterpret_cast<uint64_t>(buffer.data);
+    sqe.len = static_cast<uint32_t>(buffer.size);
+    sqe.off = buffer.offset;
+    sqe.buf_index = static_cast<uint16_t>(index);
+    sqe.user_data = index;
+    sq_array[slot] = slot;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    for (;;) {
+        const int n = uring_enter(ring_fd, 1, 0, 0);
+        if (n >= 0) break;
+        if (errno != EINTR && errno != EAGAIN) {
+            // The kernel did not take it: take the entry back and write it here
+            __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+    }
+    buffer.busy = true;
+    ++in_flight;
+    return true;
+}
+
+void LogFile::Ring::complete(const io_uring_cqe& cqe) {
+    Buffer& buffer = buffers[cqe.user_data & 1];
+    // A short write or a failed opcode (a kernel without IORING_OP_WRITE)
+    // is finished on this thread
+    if (cqe.res != static_cast<int>(buffer.size)) {
+        const size_t done = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+        if (!write_all(file, buffer.data + done, buffer.size - done, buffer.offset + done)) {
+            ++*errors;
+        }
+    }
+    buffer.busy = false;
+    --in_flight;
+}
+
+void LogFile::Ring::reap() {
+    unsigned head = *cq_head;
+    const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        complete(cqes[head & *cq_mask]);
+        ++head;
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+}
+
+void LogFile::Ring::wait_one() {
+    const unsigned before = in_flight;
+    reap();
+    if (in_flight < before) {
+        return;
+    }
+    while (uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno == EINTR) {
+    }
+    reap();
+    if (in_flight == before) {
+        // Waiting failed outright; nothing more will complete through the
+        // ring, so count what it holds as lost
+        for (auto& buffer : buffers) {
+            if (buffer.busy) {
+                buffer.busy = false;
+                ++*errors;
+            }
+        }
+        in_flight = 0;
+    }
+}
+
+#else
+
+struct LogFile::Ring {};
+
+#endif
+
+LogFile::LogFile(FileBackend backend, size_t buffer_size) {
+#if XLOG_HAS_IO_URING
+    if (backend != FileBackend::Stream) {
+        ring_ = Ring::create(buffer_size, backend == FileBackend::IoUringRegistered, &write_errors_);
+    }
+#else
+    (void)backend;
+    (void)buffer_size;
+#endif
+}
+
+LogFile::~LogFile() {
+    close();
+}
+
+bool LogFile::open(const std::string& filename) {
+    close();
+#if XLOG_HAS_IO_URING
+    if (ring_) {
+        // No O_APPEND: each buffer is written at the offset it reserved,
+        // which keeps them in order while two are in flight
+        fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        struct stat st;
+        size_ = ::fstat(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+        ring_->attach(fd_);
+        return true;
+    }
+#endif
+    // The stream is unbuffered: the sink's LineBuffer is the buffer
+    stream_.rdbuf()->pubsetbuf(nullptr, 0);
+    stream_.open(path::to_native(filename), std::ios::app);
+    if (!stream_.is_open()) {
+        return false;
+    }
+    std::error_code ec;
+    const auto bytes = std::filesystem::file_size(std::filesystem::path(path::to_native(filename)), ec);
+    size_ = ec ? 0 : static_cast<uint64_t>(bytes);
+    path_ = filename;
+    return true;
+}
+
+bool LogFile::is_open() const {
+    return fd_ >= 0 || stream_.is_open();
+}
+
+void LogFile::close() {
+#if XLOG_HAS_IO_URING
+    if (fd_ >= 0) {
+        wait();
+        ring_->detach();
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+    if (stream_.is_open()) {
+        stream_.close();
+    }
+    path_.clear();
+}
+
+void LogFile::write(const char* data, std::streamsize size) {
+    if (size <= 0) {
+        return;
+    }
+    size_ += static_cast<uint64_t>(size);
+#if XLOG_HAS_IO_URING
+    if (fd_ >= 0) {
+        Ring& ring = *ring_;
+        uint64_t offset = size_ - static_cast<uint64_t>(size);
+        size_t left = static_cast<size_t>(size);
+        while (left > 0) {
+            Ring::Buffer& buffer = ring.buffers[ring.next];
+            while (buffer.busy) {
+                ring.wait_one();
+            }
+            const size_t chunk = std::min(left, ring.capacity);
+            std::memcpy(buffer.data, data, chunk);
+            buffer.size = chunk;
+            buffer.offset = offset;
+            if (!ring.submit(ring.next) && !write_all(fd_, buffer.data, chunk, offset)) {
+                ++write_errors_;
+            }
+            ring.next ^= 1;
+            data += chunk;
+            offset += chunk;
+            left -= chunk;
+        }
+        return;
+    }
+#endif
+    if (stream_.is_open()) {
+        stream_.write(data, size);
+    }
+}
+
+void LogFile::flush() {
+#if XLOG_HAS_IO_URING
+    if (fd_ >= 0) {
+        ring_->reap();
+        return;
+    }
+#endif
+    if (stream_.is_open()) {
+        stream_.flush();
+    }
+}
+
+void LogFile::wait() {
+#if XLOG_HAS_IO_URING
+    if (fd_ >= 0) {
+        while (ring_->in_flight > 0) {
+            ring_->wait_one();
+        }
+        return;
+    }
+#endif
+    flush();
+}
+
+int LogFile::open_for_sync() const {
+#if defined(__unix__) || defined(__APPLE__)
+    if (fd_ >= 0) {
+        return ::fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+    }
+    if (stream_.is_open()) {
+        // Syncing any descriptor of the file writes back all of its data
+        return ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+#endif
+    return -1;
+}
+
+bool LogFile::sync_descriptor(int fd) {
+#if defined(__APPLE__)
+    return ::fsync(fd) == 0;
+#elif defined(__unix__)
+    return ::fdatasync(fd) == 0;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+bool LogFile::sync() {
+    wait();
+    const int fd = open_for_sync();
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = sync_descriptor(fd);
+#if defined(__unix__) || defined(__APPLE__)
+    ::close(fd);
+#endif
+    return ok;
+}
+
+}
@@ -1,137 +1,548 @@
 #include <Zyrnix/sinks/loki_sink.hpp>
+#include <Zyrnix/crash_drain.hpp>
+#include <Zyrnix/formatted_record.hpp>
 #include <Zyrnix/formatter.hpp>
+#include <Zyrnix/json_escape.hpp>
+#include <Zyrnix/log_clock.hpp>
 #include <Zyrnix/log_message.hpp>
 #include <Zyrnix/log_metrics.hpp>
-#include <sstream>
+#include <Zyrnix/snappy.hpp>
+#include <algorithm>
+#include <charconv>
 #include <iostream>
-#include <thread>
-#include <curl/curl.h>
+
+#ifdef XLOG_HAS_ZLIB
+#include <zlib.h>
+#endif
 
 namespace Zyrnix {
 
-LokiSink::LokiSink(const std::string& url, const std::string& labels, const LokiOptions& opts)
-    : url_(url), labels_(labels), options_(opts) {
-    last_flush_time_ = std::chrono::system_clock::now();
+namespace {
+
+// batch_size 0 has always meant sending every entry on its own
+size_t batch_limit(const LokiOptions& options) {
+    return std::max<size_t>(options.batch_size, 1);
 }
 
-void LokiSink::set_options(const LokiOptions& opts) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    options_ = opts;
+LokiEncoding available_encoding(LokiEncoding encoding) {
+#ifndef XLOG_HAS_ZLIB
+    if (encoding == LokiEncoding::JsonGzip) {
+        return LokiEncoding::Json;
+    }
+#endif
+    return encoding;
 }
 
-void LokiSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(mutex_);
+// Protobuf wire format for logproto.PushRequest:
+//   PushRequest   { repeated StreamAdapter streams = 1; }
+//   StreamAdapter { string labels = 1; repeated EntryAdapter entries = 2; }
+//   EntryAdapter  { Timestamp timestamp = 1; string line = 2;
+//                   repeated LabelPairAdapter structuredMetadata = 3; }
+//   LabelPairAdapter { string name = 1; string value = 2; }
+//   Timestamp     { int64 seconds = 1; int32 nanos = 2; }
+constexpr char tag_varint(int field) { return static_cast<char>(field << 3); }
+constexpr char tag_bytes(int field) { return static_cast<char>(field << 3 | 2); }
 
-    auto now = std::chrono::system_clock::now();
-    auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+size_t varint_size(uint64_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++n;
+    }
+    return n;
+}
 
-    std::ostringstream oss;
-    oss << "{";
-    oss << "\"ts\":\"" << ts << "\",";
-    // Attach logger name and level as Loki entry fields in addition to the raw message
-    oss << "\"logger\":\"" << logger_name << "\",";
-    oss << "\"level\":\"" << to_string(level) << "\",";
-    oss << "\"line\":\"" << message << "\"";
-    oss << "}";
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
 
-    buffer_.push_back(oss.str());
+void put_bytes(std::string& out, char tag, std::string_view bytes) {
+    out.push_back(tag);
+    put_varint(out, bytes.size());
+    out.append(bytes);
+}
 
-    const bool size_trigger = buffer_.size() >= options_.batch_size;
-    const bool time_trigger = options_.flush_interval_ms > 0 &&
-        std::chrono::duration_cast<std::chrono::milliseconds>(now - last_flush_time_).count() >=
-            static_cast<long long>(options_.flush_interval_ms);
+// A Prometheus label value, quoted
+void append_label_value(std::string& out, std::string_view value) {
+    out.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '\\': out.append("\\\\"); break;
+            case '"': out.append("\\\""); break;
+            case '\n': out.append("\\n"); break;
+            default: out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
 
-    if (size_trigger || time_trigger) {
-        send_batch();
-        last_flush_time_ = std::chrono::system_clock::now();
+void put_label_pair(std::string& out, std::string_view name, std::string_view value) {
+    out.push_back(tag_bytes(3));
+    put_varint(out, 2 + varint_size(name.size()) + name.size() + varint_size(value.size()) + value.size());
+    put_bytes(out, tag_bytes(1), name);
+    put_bytes(out, tag_bytes(2), value);
+}
+
+}
+
+LokiSink::LokiSink(const std::string& url, const std::string& labels, const LokiOptions& opts)
+    : url_(url), labels_(labels), options_(opts), encoding_(available_encoding(opts.encoding)),
+      stream_labels_(opts.stream_labels), metrics_(MetricsRegistry::instance().get_sink_metrics(name_str())) {
+    label_prefix_ = labels_.empty() ? std::string("{") : labels_;
+    if (label_prefix_.back() == '}') {
+        label_prefix_.pop_back();
+    }
+    streams_.push_back(std::make_unique<Stream>());
+    streams_.front()->labels = labels_;
+    stream_index_.emplace(labels_, streams_.front().get());
+    if (encoding_ == LokiEncoding::Protobuf) {
+        http_headers_.push_back("Content-Type: application/x-protobuf");
+    } else {
+        http_headers_.push_back("Content-Type: application/json");
+        if (encoding_ == LokiEncoding::JsonGzip) {
+            http_headers_.push_back("Content-Encoding: gzip");
+        }
+    }
+    if (!opts.spill.directory.empty()) {
+        spill_ = std::make_unique<SpillQueue>(opts.spill);
     }
+    HttpTransport::instance().attach(this);
+    crash_slot_ = crash::register_source(this, &LokiSink::drain_for_crash);
 }
 
-void LokiSink::flush() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!buffer_.empty()) {
-        send_batch();
-        last_flush_time_ = std::chrono::system_clock::now();
+LokiSink::~LokiSink() {
+    crash::unregister_source(crash_slot_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    HttpTransport::instance().wake();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushed_cv_.wait(lock, [this] { return pending_count_ == 0 && in_flight_ == 0; });
     }
+    HttpTransport::instance().detach(this);
+    spill_.reset();  // Waits for a replay whose completion uses the sink
 }
 
-void LokiSink::send_batch() {
-    if (buffer_.empty()) return;
+void LokiSink::drain_for_crash(const void* source, CrashWriter& out) {
+    const auto& sink = *static_cast<const LokiSink*>(source);
+    for (const auto& stream : sink.streams_) {
+        if (stream->entries.empty() && stream->sending.empty()) {
+            continue;
+        }
+        out.write("[LokiSink] ");
+        out.write(stream->labels);
+        out.write("\n");
+        out.write(stream->sending);
+        out.write(stream->entries);
+        out.write("\n");
+    }
+}
 
-    std::ostringstream payload;
-    payload << "{" << "\"streams\":[{" << "\"labels\":\"" << labels_ << "\"," << "\"entries\":[";
-    for (size_t i = 0; i < buffer_.size(); ++i) {
-        if (i > 0) payload << ",";
-        payload << buffer_[i];
+void LokiSink::set_options(const LokiOptions& opts) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = opts;
+        options_.encoding = encoding_;  // Pending entries are already encoded
     }
-    payload << "]}]}";
+    HttpTransport::instance().wake();
+}
 
-    // Basic retry with exponential backoff (v1.1.3)
-    const int max_retries = 3;
-    const long base_delay_ms = 100;
+bool LokiSink::append_entry(std::string_view logger_name, LogLevel level, std::string_view message,
+                            std::chrono::system_clock::time_point timestamp, const TraceContext& trace,
+                            const FormattedRecord* record) {
+    if (pending_count_ >= options_.max_queue_size || !budget_.admit(level, message.size())) {
+        metrics_->record_dropped();
+        return false;
+    }
+    Stream& stream = stream_for(logger_name, level, record);
+    const size_t before = stream.entries.size();
+    if (encoding_ == LokiEncoding::Protobuf) {
+        append_protobuf_entry(stream, logger_name, level, message, timestamp, trace, record);
+    } else {
+        append_json_entry(stream, logger_name, level, message, timestamp, trace, record);
+    }
+    ++stream.count;
+    if (pending_count_++ == 0) {
+        oldest_pending_ = std::chrono::steady_clock::now();
+    }
+    pending_bytes_ += stream.entries.size() - before;
+    budget_.charge(stream.entries.size() - before);
+    return true;
+}
+
+LokiSink::Stream& LokiSink::stream_for(std::string_view logger_name, LogLevel level, const FormattedRecord* record) {
+    Stream& base = *streams_.front();
+    if (stream_labels_.empty()) {
+        return base;
+    }
+
+    label_key_.assign(label_prefix_);
+    bool any = false;
+    for (const auto& name : stream_labels_) {
+        std::string_view value;
+        if (name == "level") {
+            value = level_name(level);
+        } else if (name == "logger") {
+            value = logger_name;
+        } else if (const FieldValue* field = record ? record->fields().find(name) : nullptr) {
+            value = field->text();
+        } else {
+            continue;
+        }
+        if (label_key_.size() > 1) {
+            label_key_.push_back(',');
+        }
+        label_key_.append(name);
+        label_key_.push_back('=');
+        append_label_value(label_key_, value);
+        any = true;
+    }
+    if (!any) {
+        return base;
+    }
+    label_key_.push_back('}');
+
+    if (auto it = stream_index_.find(label_key_); it != stream_index_.end()) {
+        return *it->second;
+    }
+    // The cap holds for the sink's lifetime, as Loki's index cost does
+    if (streams_.size() > options_.max_streams) {
+        return base;
+    }
+    streams_.push_back(std::make_unique<Stream>());
+    Stream& stream = *streams_.back();
+    stream.labels = label_key_;
+    stream_index_.emplace(label_key_, &stream);
+    return stream;
+}
+
+bool LokiSink::wake_needed(bool was_full, bool was_empty) const {
+    // Only the push that fills the batch, or that starts the
+    // flush_interval_ms timer, needs the I/O thread
+    return (!was_full && batch_full()) || (was_empty && pending_count_ > 0 && options_.flush_interval_ms > 0);
+}
 
-    auto& registry = MetricsRegistry::instance();
-    auto sink_metrics = registry.get_sink_metrics(name_str());
+bool LokiSink::batch_full() const {
+    return pending_count_ >= batch_limit(options_) ||
+           (options_.batch_bytes > 0 && pending_bytes_ >= options_.batch_bytes);
+}
+
+void LokiSink::append_json_entry(Stream& stream, std::string_view logger_name, LogLevel level,
+                                 std::string_view message, std::chrono::system_clock::time_point timestamp,
+                                 const TraceContext& trace, const FormattedRecord* record) {
+    const auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    char ts_text[24];
+    const auto ts_end = std::to_chars(ts_text, ts_text + sizeof(ts_text), ts).ptr;
 
-    int attempt = 0;
-    CURLcode last_err = CURLE_OK;
+    std::string& entry = stream.entries;
+    if (stream.count > 0) {
+        entry.push_back(',');
+    }
+    entry.append("{\"ts\":\"");
+    entry.append(ts_text, ts_end);
+    // Attach logger name and level as Loki entry fields in addition to the raw message
+    entry.append("\",\"logger\":");
+    json::append_string(entry, logger_name);
+    entry.append(",\"level\":\"");
+    entry.append(level_name(level));
+    entry.append("\",\"line\":");
+    json::append_string(entry, message);
+    if (trace.valid()) {
+        entry.append(",\"trace_id\":\"");
+        trace.append_trace_id(entry);
+        entry.append("\",\"span_id\":\"");
+        trace.append_span_id(entry);
+        entry.push_back('"');
+    }
+    if (record) {
+        entry.append(record->fields_json());
+    }
+    entry.push_back('}');
+}
 
-    while (attempt < max_retries) {
-        CURL* curl = curl_easy_init();
-        if (!curl) {
-            last_err = CURLE_FAILED_INIT;
-            break;
+void LokiSink::append_protobuf_entry(Stream& stream, std::string_view logger_name, LogLevel level,
+                                     std::string_view message, std::chrono::system_clock::time_point timestamp,
+                                     const TraceContext& trace, const FormattedRecord* record) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    const auto seconds = static_cast<uint64_t>(ns / 1000000000);
+    const auto nanos = static_cast<uint64_t>(ns % 1000000000);
+
+    entry_.clear();
+    entry_.push_back(tag_bytes(1));
+    put_varint(entry_, 2 + varint_size(seconds) + varint_size(nanos));
+    entry_.push_back(tag_varint(1));
+    put_varint(entry_, seconds);
+    entry_.push_back(tag_varint(2));
+    put_varint(entry_, nanos);
+    put_bytes(entry_, tag_bytes(2), message);
+    put_label_pair(entry_, "logger", logger_name);
+    put_label_pair(entry_, "level", level_name(level));
+    if (trace.valid()) {
+        char trace_id[TraceContext::trace_id_hex_size];
+        char span_id[TraceContext::span_id_hex_size];
+        trace.write_trace_id(trace_id);
+        trace.write_span_id(span_id);
+        put_label_pair(entry_, "trace_id", std::string_view(trace_id, sizeof(trace_id)));
+        put_label_pair(entry_, "span_id", std::string_view(span_id, sizeof(span_id)));
+    }
+    if (record) {
+        for (const auto& [key, value] : record->fields()) {
+            put_label_pair(entry_, key, value.text());
         }
+    }
 
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
+    put_bytes(stream.entries, tag_bytes(2), entry_);
+}
+
+void LokiSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool was_full = batch_full();
+        const bool was_empty = pending_count_ == 0;
+        append_entry(logger_name, level, message, LogClock::now(), TraceContext::current());
+        wake = wake_needed(was_full, was_empty);
+    }
+    if (wake) {
+        HttpTransport::instance().wake();
+    }
+}
 
-        curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload.str().c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+void LokiSink::log_record(const FormattedRecord& record) {
+    log_batch(std::span<const FormattedRecord>(&record, 1));
+}
 
-        if (options_.timeout_ms > 0) {
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, options_.timeout_ms);
+void LokiSink::log_batch(std::span<const FormattedRecord> records) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool was_full = batch_full();
+        const bool was_empty = pending_count_ == 0;
+        for (const auto& record : records) {
+            append_entry(record.logger_name(), record.level(), record.message(), record.timestamp(), record.trace(),
+                         &record);
         }
+        wake = wake_needed(was_full, was_empty);
+    }
+    if (wake) {
+        HttpTransport::instance().wake();
+    }
+}
+
+void LokiSink::flush() {
+    // Ask for what is pending to be sent, then wait until nothing is unsent
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++flush_waiters_;
+    HttpTransport::instance().wake();
+    flushed_cv_.wait(lock, [this] {
+        return (pending_count_ == 0 && in_flight_ == 0) || !running_;
+    });
+    --flush_waiters_;
+}
+
+std::chrono::steady_clock::time_point LokiSink::pump(HttpTransport& transport) {
+    auto next = send_batch(transport);
+    if (spill_) {
+        next = std::min(next, spill_->replay(transport, base_request(), [this](const HttpResponse& response,
+                                                                                  uint32_t events) {
+            on_replayed(response, events);
+        }));
+    }
+    return next;
+}
 
-        if (!options_.ca_cert_path.empty()) {
-            curl_easy_setopt(curl, CURLOPT_CAINFO, options_.ca_cert_path.c_str());
+HttpRequest LokiSink::base_request() {
+    HttpRequest request;
+    request.url = url_;
+    request.headers = http_headers_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    request.timeout_ms = options_.timeout_ms;
+    request.insecure_skip_verify = options_.insecure_skip_verify;
+    request.ca_cert_path = options_.ca_cert_path;
+    return request;
+}
+
+std::chrono::steady_clock::time_point LokiSink::send_batch(HttpTransport& transport) {
+    constexpr auto idle = std::chrono::steady_clock::time_point::max();
+    const auto now = std::chrono::steady_clock::now();
+    LokiOptions options;
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // One batch at a time: the streams' sending buffers hold it until
+        // the completion, which wakes the transport for the next one
+        if (pending_count_ == 0 || in_flight_ > 0) {
+            return idle;
+        }
+        const auto interval = std::chrono::milliseconds(options_.flush_interval_ms);
+        const bool due = batch_full() || flush_waiters_ > 0 || !running_ ||
+                         (options_.flush_interval_ms > 0 && now - oldest_pending_ >= interval);
+        if (!due) {
+            return options_.flush_interval_ms > 0 ? oldest_pending_ + interval : idle;
         }
 
-        if (options_.insecure_skip_verify) {
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        // Double buffering: logging threads fill the streams' entries while
+        // this batch is sent
+        sending_.clear();
+        for (const auto& stream : streams_) {
+            if (stream->count > 0) {
+                stream->sending.clear();
+                stream->sending.swap(stream->entries);
+                stream->count = 0;
+                sending_.push_back(stream.get());
+            }
         }
+        count = pending_count_;
+        in_flight_ = count;
+        pending_count_ = 0;
+        budget_.release(pending_bytes_);
+        pending_bytes_ = 0;
+        options = options_;
+    }
 
-        last_err = curl_easy_perform(curl);
+    // Built and compressed once; every attempt posts the same bytes
+    const std::string_view body = build_body(options);
+    if (body.empty()) {
+        std::cerr << "LokiSink: compressing the batch failed, dropping " << count << " entries" << std::endl;
+        metrics_->record_error();
+        metrics_->record_dropped(count);
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_ = 0;
+        flushed_cv_.notify_all();
+        return idle;
+    }
 
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+    // Straight to disk while the endpoint is down, or before the queue overflows
+    if (spill_ && (spill_->diverting() || count >= options.max_queue_size / 2)) {
+        if (!spill_->push(body, static_cast<uint32_t>(count))) {
+            metrics_->record_dropped(count);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_ = 0;
+        flushed_cv_.notify_all();
+        return now;  // For what was logged meanwhile
+    }
+
+    HttpRequest request;
+    request.url = url_;
+    request.body.assign(body);
+    request.headers = http_headers_;
+    request.timeout_ms = options.timeout_ms;
+    request.insecure_skip_verify = options.insecure_skip_verify;
+    request.ca_cert_path = options.ca_cert_path;
+    // Basic retry with exponential backoff (v1.1.3)
+    request.max_attempts = 3;
+    request.retry_delay_ms = 100;
+    transport.submit(std::move(request), [this, count](const HttpResponse& response, int attempts,
+                                                       HttpRequest& sent) {
+        on_sent(response, attempts, count, sent);
+    });
+    return idle;
+}
 
-        if (last_err == CURLE_OK) {
-            if (sink_metrics) {
-                sink_metrics->record_flush();
+void LokiSink::on_sent(const HttpResponse& response, int attempts, size_t count, HttpRequest& request) {
+    if (response.success && response.status_code >= 200 && response.status_code < 300) {
+        metrics_->record_flush();
+    } else {
+        metrics_->record_error();
+        if (!response.success) {
+            std::cerr << "LokiSink: push failed after " << attempts << " attempts: " << response.error << std::endl;
+        } else {
+            std::cerr << "LokiSink: push got HTTP " << response.status_code << " after " << attempts
+                      << " attempts" << std::endl;
+        }
+        const bool retryable = !response.success || response.status_code == 429 || response.status_code >= 500;
+        if (retryable && spill_) {
+            // Kept for the replayer, and later batches follow it to disk until a replay gets through
+            if (!spill_->push(request.body, static_cast<uint32_t>(count))) {
+                metrics_->record_dropped(count);
             }
-            buffer_.clear();
-            return;
+            spill_->mark_down();
+        } else {
+            // Drop the batch to avoid unbounded growth
+            metrics_->record_dropped(count);
         }
+    }
 
-        if (sink_metrics) {
-            sink_metrics->record_error();
-        }
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_ = 0;
+        more = pending_count_ > 0;
+        // Under the lock: once it is released the destructor may go ahead
+        flushed_cv_.notify_all();
+    }
+    if (more) {
+        HttpTransport::instance().wake();
+    }
+}
 
-        std::cerr << "LokiSink: send_batch attempt " << (attempt + 1)
-                  << " failed: " << curl_easy_strerror(last_err) << std::endl;
+void LokiSink::on_replayed(const HttpResponse& response, uint32_t events) {
+    if (response.success && response.status_code >= 200 && response.status_code < 300) {
+        metrics_->record_flush();
+    } else if (response.success && response.status_code != 429 && response.status_code < 500) {
+        std::cerr << "LokiSink: spilled push got HTTP " << response.status_code << ", dropping it" << std::endl;
+        metrics_->record_dropped(events);
+    }
+}
 
-        ++attempt;
-        if (attempt < max_retries) {
-            long delay = base_delay_ms * (1L << (attempt - 1));
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+std::string_view LokiSink::build_body(const LokiOptions& options) {
+    body_.clear();
+    if (encoding_ == LokiEncoding::Protobuf) {
+        for (const Stream* stream : sending_) {
+            const std::string& labels = stream->labels;
+            body_.push_back(tag_bytes(1));
+            put_varint(body_, 1 + varint_size(labels.size()) + labels.size() + stream->sending.size());
+            put_bytes(body_, tag_bytes(1), labels);
+            body_.append(stream->sending);
         }
+        compressed_.clear();
+        snappy::compress(body_, compressed_);
+        return compressed_;
     }
 
-    // If we reach here, all retries failed – drop the batch to avoid unbounded growth
-    buffer_.clear();
+    body_.append("{\"streams\":[");
+    for (const Stream* stream : sending_) {
+        if (stream != sending_.front()) {
+            body_.push_back(',');
+        }
+        body_.append("{\"labels\":");
+        json::append_string(body_, stream->labels);
+        body_.append(",\"entries\":[");
+        body_.append(stream->sending);
+        body_.append("]}");
+    }
+    body_.append("]}");
+#ifdef XLOG_HAS_ZLIB
+    if (encoding_ == LokiEncoding::JsonGzip) {
+        z_stream zs{};
+        if (deflateInit2(&zs, std::clamp(options.gzip_level, 1, 9), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+            Z_OK) {
+            return {};
+        }
+        compressed_.resize(deflateBound(&zs, static_cast<uLong>(body_.size())));
+        zs.next_in = reinterpret_cast<Bytef*>(body_.data());
+        zs.avail_in = static_cast<uInt>(body_.size());
+        zs.next_out = reinterpret_cast<Bytef*>(compressed_.data());
+        zs.avail_out = static_cast<uInt>(compressed_.size());
+        const int ret = deflate(&zs, Z_FINISH);
+        compressed_.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END) {
+            return {};
+        }
+        return compressed_;
+    }
+#else
+    (void)options;
+#endif
+    return body_;
 }
 
 } // namespace Zyrnix
@@ -0,0 +1,269 @@
+#include "Zyrnix/sinks/mmap_file_sink.hpp"
+#include "Zyrnix/buffer_memory.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr size_t page_size = 4096;
+
+size_t round_up(size_t bytes, size_t to) {
+    return (bytes + to - 1) / to * to;
+}
+
+std::string segment_path(const std::string& base_name, uint64_t generation) {
+    char number[24];
+    std::snprintf(number, sizeof(number), ".%06llu.log", static_cast<unsigned long long>(generation));
+    return base_name + number;
+}
+
+// Generation of a file name <stem>.<digits>.log, or -1
+int64_t parse_generation(const std::string& name, const std::string& stem) {
+    if (name.size() <= stem.size() + 5 || name.compare(0, stem.size(), stem) != 0 ||
+        name[stem.size()] != '.' || name.compare(name.size() - 4, 4, ".log") != 0) {
+        return -1;
+    }
+    const std::string digits = name.substr(stem.size() + 1, name.size() - stem.size() - 5);
+    if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return -1;
+    }
+    return static_cast<int64_t>(std::stoull(digits));
+}
+
+}
+
+struct MmapFileSink::Segment {
+    uint64_t generation = 0;
+    std::string path;
+    int fd = -1;
+    char* map = nullptr;
+    size_t size = 0;
+    mutable std::atomic<size_t> cursor{0};  // Bytes reserved, possibly past size
+    mutable std::atomic<size_t> end;        // Offset of the first reservation that did not fit
+    mutable std::atomic<size_t> synced{0};  // Written back up to here (worker only)
+
+    explicit Segment(size_t bytes) : size(bytes), end(bytes) {}
+
+    size_t used() const {
+        return std::min(cursor.load(std::memory_order_acquire), end.load(std::memory_order_acquire));
+    }
+
+    // Runs once no writer can still be copying into the map
+    ~Segment() {
+        const size_t bytes = used();
+        if (map) {
+            munmap(map, size);
+        }
+        if (fd >= 0) {
+            if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                // Keeps the preallocated size; the NUL tail is harmless
+            }
+            ::close(fd);
+            if (bytes == 0) {
+                ::unlink(path.c_str());  // A spare, or a segment rolled to at exit
+            }
+        }
+    }
+};
+
+MmapFileSink::MmapFileSink(const std::string& base_name, const MmapFileOptions& options)
+    : base_name_(base_name), options_(options) {
+    options_.segment_size = round_up(std::max<size_t>(options_.segment_size, page_size), page_size);
+
+    // Carry on after the newest segment already there
+    const fs::path base(base_name_);
+    const fs::path dir = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    const std::string stem = base.filename().string();
+    std::vector<std::pair<uint64_t, std::string>> existing;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const int64_t generation = parse_generation(it->path().filename().string(), stem);
+        if (generation >= 0) {
+            existing.emplace_back(static_cast<uint64_t>(generation), it->path().string());
+        }
+    }
+    std::sort(existing.begin(), existing.end());
+    for (auto& [generation, path] : existing) {
+        finished_.push_back(std::move(path));
+        next_generation_ = generation + 1;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    current_generation_ = next_generation_;
+    current_.publish(make_segment(next_generation_++));
+    spare_ = make_segment(next_generation_++);
+    worker_ = std::thread(&MmapFileSink::run, this);
+}
+
+MmapFileSink::~MmapFileSink() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    spare_.reset();
+    // current_ trims and closes the last segment when it goes
+}
+
+std::unique_ptr<MmapFileSink::Segment> MmapFileSink::make_segment(uint64_t generation) const {
+    auto segment = std::make_unique<Segment>(options_.segment_size);
+    segment->generation = generation;
+    segment->path = segment_path(base_name_, generation);
+    segment->fd = ::open(segment->path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (segment->fd < 0) {
+        return nullptr;
+    }
+    // Allocate the blocks now: a store into a hole the disk cannot fill
+    // would be a SIGBUS instead of a dropped line
+#ifdef __linux__
+    const int err = posix_fallocate(segment->fd, 0, static_cast<off_t>(segment->size));
+#else
+    const int err = ftruncate(segment->fd, static_cast<off_t>(segment->size)) == 0 ? 0 : errno;
+#endif
+    if (err != 0) {
+        segment->size = 0;
+        return nullptr;
+    }
+    void* map = mmap(nullptr, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (map == MAP_FAILED) {
+        return nullptr;
+    }
+    segment->map = static_cast<char*>(map);
+    madvise(map, segment->size, MADV_SEQUENTIAL);
+    // The spare is made on the worker, so its faults are taken there and
+    // not by the first lines after a roll
+    prepare_mapping(map, segment->size);
+    return segment;
+}
+
+void MmapFileSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    log_as_record(logger_name, level, message);
+}
+
+void MmapFileSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    write(record.formatted(formatter));
+}
+
+void MmapFileSink::write(std::string_view line) {
+    const size_t bytes = line.size() + 1;
+    if (bytes > options_.segment_size) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    EpochDomain::ReadGuard guard;
+    for (;;) {
+        const Segment* segment = current_.load();
+        if (!segment) {
+            roll(nullptr);
+            if (!(segment = current_.load())) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        const size_t offset = segment->cursor.fetch_add(bytes, std::memory_order_relaxed);
+        if (offset + bytes <= segment->size) {
+            std::memcpy(segment->map + offset, line.data(), line.size());
+            segment->map[offset + line.size()] = '\n';
+            return;
+        }
+        // Did not fit: the segment ends at the lowest such offset
+        size_t end = segment->end.load(std::memory_order_relaxed);
+        while (offset < end && !segment->end.compare_exchange_weak(end, offset, std::memory_order_acq_rel)) {
+        }
+        roll(segment);
+    }
+}
+
+void MmapFileSink::roll(const Segment* full) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    const Segment* current = current_.load();
+    if (current != full) {
+        return;  // Another writer got there first
+    }
+    std::unique_ptr<Segment> next = spare_ ? std::move(spare_) : make_segment(next_generation_++);
+    if (!next && !full) {
+        return;
+    }
+    if (full) {
+        finished_.push_back(full->path);
+    }
+    if (next) {
+        current_generation_ = next->generation;
+    }
+    // The full segment is trimmed once its writers have left
+    current_.publish(std::move(next));
+    rolled_ = true;
+    cv_.notify_one();
+}
+
+void MmapFileSink::flush() {
+    EpochDomain::ReadGuard guard;
+    if (const Segment* segment = current_.load()) {
+        msync(segment->map, round_up(segment->used(), page_size), MS_ASYNC);
+    }
+}
+
+std::string MmapFileSink::current_path() const {
+    EpochDomain::ReadGuard guard;
+    const Segment* segment = current_.load();
+    return segment ? segment->path : std::string();
+}
+
+void MmapFileSink::run() {
+    init_background_thread("xlog-mmap");
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stop_) {
+        cv_.wait_for(lock, options_.sync_interval, [this] { return stop_ || rolled_; });
+        if (stop_) {
+            break;
+        }
+        rolled_ = false;
+
+        if (!spare_) {
+            // Allocating can take a while; rolling meanwhile makes its own
+            const uint64_t generation = next_generation_++;
+            lock.unlock();
+            auto spare = make_segment(generation);
+            lock.lock();
+            // A roll that could not wait took a later generation; this one
+            // would sort before it, so it goes (unlinked, being empty)
+            if (!spare_ && spare && spare->generation > current_generation_) {
+                spare_ = std::move(spare);
+            }
+        }
+        current_.reclaim();
+        while (options_.max_segments > 0 && finished_.size() > options_.max_segments) {
+            ::unlink(finished_.front().c_str());  // Still mapped is fine
+            finished_.pop_front();
+        }
+
+        // Start writeback of the pages filled since the last pass
+        EpochDomain::ReadGuard guard;
+        if (const Segment* segment = current_.load()) {
+            const size_t used = segment->used() / page_size * page_size;
+            const size_t from = segment->synced.load(std::memory_order_relaxed);
+            if (used > from) {
+                msync(segment->map + from, used - from, MS_ASYNC);
+                segment->synced.store(used, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+}
@@ -1,6 +1,222 @@
 #include "Zyrnix/sinks/multi_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <latch>
+
+#ifndef XLOG_NO_ASYNC
+#include "Zyrnix/async/thread_pool.hpp"
+#endif
 
 namespace Zyrnix {
 
-// All implementation is inline in header, but cpp can be empty
+namespace {
+
+// Runs work(child, on_pool) for every child of group: pooled children on
+// the group's pool, the others on the calling thread while those run.
+// Returns once all of them have finished, rethrowing the first exception.
+template <typename Work>
+void fan_out(const MultiSink::Group& group, Work& work) {
+#ifndef XLOG_NO_ASYNC
+    if (group.pooled > 0 && !group.pool->in_worker()) {
+        // One reference per task keeps the std::function small enough to
+        // be stored without an allocation
+        struct Join {
+            Join(Work& w, size_t tasks) : work(w), done(static_cast<std::ptrdiff_t>(tasks)) {}
+
+            Work& work;
+            std::latch done;
+            std::mutex mtx;
+            std::exception_ptr error;
+
+            void run(const MultiSink::Child& child, bool on_pool) {
+                try {
+                    work(child, on_pool);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        } join(work, group.pooled);
+
+        for (const auto& child : group.children) {
+            if (child.dispatch == MultiSink::Dispatch::Pooled) {
+                const MultiSink::Child* c = &child;
+                group.pool->enqueue([&join, c] {
+                    join.run(*c, true);
+                    join.done.count_down();
+                });
+            }
+        }
+        for (const auto& child : group.children) {
+            if (child.dispatch != MultiSink::Dispatch::Pooled) {
+                join.run(child, false);
+            }
+        }
+        join.done.wait();
+        if (join.error) std::rethrow_exception(join.error);
+        return;
+    }
+#endif
+    for (const auto& child : group.children) {
+        work(child, false);
+    }
+}
+
+}
+
+MultiSink::MultiSink() : group_(std::make_unique<Group>()) {}
+
+MultiSink::~MultiSink() = default;
+
+void MultiSink::add_sink(LogSinkPtr sink, Dispatch dispatch) {
+    if (!sink) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    children_.push_back(Child{std::move(sink), dispatch});
+    publish();
+}
+
+bool MultiSink::remove_sink(const LogSinkPtr& sink) {
+    uint64_t grace_epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = std::find_if(children_.begin(), children_.end(),
+                               [&sink](const Child& child) { return child.sink == sink; });
+        if (it == children_.end()) {
+            return false;
+        }
+        children_.erase(it);
+        grace_epoch = publish();
+    }
+    EpochDomain::instance().wait_for(grace_epoch);
+    std::lock_guard<std::mutex> lock(mtx_);
+    group_.reclaim();
+    return true;
+}
+
+size_t MultiSink::size() const {
+    EpochDomain::ReadGuard read;
+    return group_.load()->children.size();
+}
+
+void MultiSink::set_filter(Filter filter) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    filter_ = std::move(filter);
+    publish();
+}
+
+#ifndef XLOG_NO_ASYNC
+void MultiSink::set_thread_pool(std::shared_ptr<ThreadPool> pool) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    pool_ = std::move(pool);
+    publish();
+}
+#endif
+
+uint64_t MultiSink::publish() {
+    auto next = std::make_unique<Group>();
+    next->children = children_;
+    next->filter = filter_;
+    if (pool_) {
+        next->pooled = static_cast<size_t>(std::count_if(children_.begin(), children_.end(), [](const Child& child) {
+            return child.dispatch == Dispatch::Pooled;
+        }));
+        if (next->pooled > 0) {
+            next->pool = pool_;
+        }
+    }
+    return group_.publish(std::move(next));
+}
+
+void MultiSink::log(const std::string& logger_name, LogLevel lvl, const std::string& message) {
+    log_as_record(logger_name, lvl, message);
+}
+
+void MultiSink::log_record(const FormattedRecord& record) {
+    if (record.level() < level) return;
+    EpochDomain::ReadGuard read;
+    const Group& group = *group_.load();
+    if (group.filter && !group.filter(record)) return;
+
+    auto work = [&record](const Child& child, bool on_pool) {
+        if (record.level() < child.sink->get_level()) return;
+        if (on_pool) {
+            // RenderCache is not shared across threads: a pooled child
+            // renders into its worker's
+            ScopedRenderCache cache;
+            child.sink->log_record(FormattedRecord(record, record.message(), cache));
+        } else {
+            child.sink->log_record(record);
+        }
+    };
+    fan_out(group, work);
+}
+
+void MultiSink::log_batch(std::span<const FormattedRecord> records) {
+    EpochDomain::ReadGuard read;
+    const Group& group = *group_.load();
+
+    // Only copy the batch when the group's level or filter drops something
+    std::vector<FormattedRecord> kept;
+    std::span<const FormattedRecord> batch = records;
+    const auto passes = [&](const FormattedRecord& record) {
+        return record.level() >= level && (!group.filter || group.filter(record));
+    };
+    const auto first_dropped = std::find_if_not(records.begin(), records.end(), passes);
+    if (first_dropped != records.end()) {
+        kept.reserve(records.size());
+        kept.assign(records.begin(), first_dropped);
+        std::copy_if(first_dropped + 1, records.end(), std::back_inserter(kept), passes);
+        batch = kept;
+    }
+    if (batch.empty()) return;
+
+    LogLevel lowest = LogLevel::Critical;
+    for (const auto& record : batch) {
+        lowest = std::min(lowest, record.level());
+    }
+
+    auto work = [batch, lowest](const Child& child, bool on_pool) {
+        const LogLevel child_level = child.sink->get_level();
+        if (child_level <= lowest && !on_pool) {
+            child.sink->log_batch(batch);
+            return;
+        }
+        std::vector<RenderCache> caches;
+        std::vector<FormattedRecord> subset;
+        if (on_pool) {
+            caches.resize(batch.size());
+        }
+        subset.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (batch[i].level() < child_level) continue;
+            if (on_pool) {
+                subset.emplace_back(batch[i], batch[i].message(), caches[i]);
+            } else {
+                subset.push_back(batch[i]);
+            }
+        }
+        if (!subset.empty()) {
+            child.sink->log_batch(subset);
+        }
+    };
+    fan_out(group, work);
+}
+
+void MultiSink::flush() {
+    EpochDomain::ReadGuard read;
+    auto work = [](const Child& child, bool) { child.sink->flush(); };
+    fan_out(*group_.load(), work);
+}
+
+void MultiSink::set_formatter(Formatter f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto& child : children_) {
+        child.sink->set_formatter(f);
+    }
+    LogSink::set_formatter(std::move(f));
+}
+
 }
@@ -0,0 +1,479 @@
+#include "Zyrnix/sinks/otlp_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/log_site.hpp"
+#include "Zyrnix/stack_trace.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#ifndef XLOG_VERSION
+#define XLOG_VERSION "unknown"
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+// Protobuf wire format of opentelemetry.proto.collector.logs.v1:
+//   ExportLogsServiceRequest { repeated ResourceLogs resource_logs = 1; }
+//   ResourceLogs  { Resource resource = 1; repeated ScopeLogs scope_logs = 2; }
+//   Resource      { repeated KeyValue attributes = 1; }
+//   ScopeLogs     { InstrumentationScope scope = 1; repeated LogRecord log_records = 2; }
+//   InstrumentationScope { string name = 1; string version = 2; }
+//   LogRecord     { fixed64 time_unix_nano = 1; SeverityNumber severity_number = 2;
+//                   string severity_text = 3; AnyValue body = 5;
+//                   repeated KeyValue attributes = 6; fixed32 flags = 8;
+//                   bytes trace_id = 9; bytes span_id = 10;
+//                   fixed64 observed_time_unix_nano = 11; }
+//   KeyValue      { string key = 1; AnyValue value = 2; }
+//   AnyValue      { oneof { string string_value = 1; bool bool_value = 2;
+//                           int64 int_value = 3; double double_value = 4; } }
+constexpr char tag_varint(int field) { return static_cast<char>(field << 3); }
+constexpr char tag_fixed64(int field) { return static_cast<char>(field << 3 | 1); }
+constexpr char tag_bytes(int field) { return static_cast<char>(field << 3 | 2); }
+constexpr char tag_fixed32(int field) { return static_cast<char>(field << 3 | 5); }
+
+constexpr char grpc_path[] = "/opentelemetry.proto.collector.logs.v1.LogsService/Export";
+
+size_t varint_size(uint64_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void put_fixed(std::string& out, char tag, uint64_t value, int bytes) {
+    out.push_back(tag);
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value & 0xff));
+        value >>= 8;
+    }
+}
+
+void put_bytes(std::string& out, char tag, std::string_view bytes) {
+    out.push_back(tag);
+    put_varint(out, bytes.size());
+    out.append(bytes);
+}
+
+size_t bytes_size(size_t size) {
+    return 1 + varint_size(size) + size;
+}
+
+// A KeyValue whose AnyValue is a string
+void put_string_attribute(std::string& out, char tag, std::string_view key, std::string_view value) {
+    const size_t any = bytes_size(value.size());
+    out.push_back(tag);
+    put_varint(out, bytes_size(key.size()) + bytes_size(any));
+    put_bytes(out, tag_bytes(1), key);
+    out.push_back(tag_bytes(2));
+    put_varint(out, any);
+    put_bytes(out, tag_bytes(1), value);
+}
+
+void put_int_attribute(std::string& out, std::string_view key, int64_t value) {
+    const size_t any = 1 + varint_size(static_cast<uint64_t>(value));
+    out.push_back(tag_bytes(6));
+    put_varint(out, bytes_size(key.size()) + bytes_size(any));
+    put_bytes(out, tag_bytes(1), key);
+    out.push_back(tag_bytes(2));
+    put_varint(out, any);
+    out.push_back(tag_varint(3));
+    put_varint(out, static_cast<uint64_t>(value));
+}
+
+void put_double_attribute(std::string& out, std::string_view key, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    out.push_back(tag_bytes(6));
+    put_varint(out, bytes_size(key.size()) + bytes_size(9));
+    put_bytes(out, tag_bytes(1), key);
+    out.push_back(tag_bytes(2));
+    put_varint(out, 9);
+    put_fixed(out, tag_fixed64(4), bits, 8);
+}
+
+void put_bool_attribute(std::string& out, std::string_view key, bool value) {
+    out.push_back(tag_bytes(6));
+    put_varint(out, bytes_size(key.size()) + bytes_size(2));
+    put_bytes(out, tag_bytes(1), key);
+    out.push_back(tag_bytes(2));
+    put_varint(out, 2);
+    out.push_back(tag_varint(2));
+    out.push_back(value ? 1 : 0);
+}
+
+// Numbers are kept as the text they print as; one too large for an
+// int64 (a big uint64_t) goes as a string
+void put_field(std::string& out, std::string_view key, const FieldValue& value) {
+    const std::string& text = value.text();
+    switch (value.type()) {
+        case FieldType::Integer: {
+            int64_t number;
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+            if (result.ec == std::errc() && result.ptr == text.data() + text.size()) {
+                put_int_attribute(out, key, number);
+                return;
+            }
+            break;
+        }
+        case FieldType::Float: {
+            double number;
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+            if (result.ec == std::errc() && result.ptr == text.data() + text.size()) {
+                put_double_attribute(out, key, number);
+                return;
+            }
+            break;
+        }
+        case FieldType::Bool:
+            put_bool_attribute(out, key, text == "true");
+            return;
+        case FieldType::String:
+            break;
+    }
+    put_string_attribute(out, tag_bytes(6), key, text);
+}
+
+// TRACE, DEBUG, INFO, WARN, ERROR and FATAL, each the first of its range
+int severity_number(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return 1;
+        case LogLevel::Debug: return 5;
+        case LogLevel::Info: return 9;
+        case LogLevel::Warn: return 13;
+        case LogLevel::Error: return 17;
+        case LogLevel::Critical: return 21;
+        default: return 0;
+    }
+}
+
+std::string program_name() {
+#if defined(__GLIBC__)
+    return program_invocation_short_name;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    return getprogname();
+#else
+    return "";
+#endif
+}
+
+// Failed exports that will not be retried, for the log line
+std::string describe(const HttpResponse& response) {
+    if (!response.success) {
+        return response.error;
+    }
+    std::string text = "HTTP " + std::to_string(response.status_code);
+    if (response.grpc_status > 0) {
+        text += ", grpc-status " + std::to_string(response.grpc_status);
+        if (!response.error.empty()) {
+            text += ": " + response.error;
+        }
+    }
+    return text;
+}
+
+}
+
+OtlpLogSink::OtlpLogSink(const OtlpOptions& options) : options_(options) {
+    options_.max_export_batch_size = std::max<size_t>(options_.max_export_batch_size, 1);
+    options_.max_queue_size = std::max(options_.max_queue_size, options_.max_export_batch_size);
+
+    if (options_.protocol == OtlpProtocol::Grpc) {
+        url_ = options_.endpoint;
+        while (!url_.empty() && url_.back() == '/') {
+            url_.pop_back();
+        }
+        url_ += grpc_path;
+        http_headers_.push_back("Content-Type: application/grpc");
+        http_headers_.push_back("TE: trailers");
+    } else {
+        url_ = options_.endpoint;
+        http_headers_.push_back("Content-Type: application/x-protobuf");
+    }
+    http_headers_.insert(http_headers_.end(), options_.headers.begin(), options_.headers.end());
+
+    bool has_service_name = false;
+    for (const auto& [key, value] : options_.resource_attributes) {
+        put_string_attribute(resource_, tag_bytes(1), key, value);
+        has_service_name = has_service_name || key == "service.name";
+    }
+    if (!has_service_name) {
+        put_string_attribute(resource_, tag_bytes(1), "service.name", "unknown_service:" + program_name());
+    }
+    put_string_attribute(resource_, tag_bytes(1), "telemetry.sdk.name", "zyrnix");
+    put_string_attribute(resource_, tag_bytes(1), "telemetry.sdk.language", "cpp");
+    put_string_attribute(resource_, tag_bytes(1), "telemetry.sdk.version", XLOG_VERSION);
+
+    last_export_ = std::chrono::steady_clock::now();
+    HttpTransport::instance().attach(this);
+}
+
+OtlpLogSink::~OtlpLogSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    HttpTransport::instance().wake();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushed_cv_.wait(lock, [this] { return queue_.empty() && in_flight_ == 0; });
+    }
+    HttpTransport::instance().detach(this);
+}
+
+std::string OtlpLogSink::encode(LogLevel level, std::string_view message,
+                                std::chrono::system_clock::time_point timestamp, const TraceContext& trace,
+                                const FormattedRecord* record) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    const std::string_view severity_text = level_name(level);
+
+    std::string out;
+    out.reserve(64 + message.size() + (record ? record->fields().size() * 48 : 0));
+    put_fixed(out, tag_fixed64(1), static_cast<uint64_t>(ns), 8);
+    // Seen when logged: the record was made by this process
+    put_fixed(out, tag_fixed64(11), static_cast<uint64_t>(ns), 8);
+    out.push_back(tag_varint(2));
+    put_varint(out, static_cast<uint64_t>(severity_number(level)));
+    put_bytes(out, tag_bytes(3), severity_text);
+    out.push_back(tag_bytes(5));
+    put_varint(out, bytes_size(message.size()));
+    put_bytes(out, tag_bytes(1), message);
+
+    if (record) {
+        for (const auto& [key, value] : record->fields()) {
+            put_field(out, key, value);
+        }
+        put_int_attribute(out, "thread.id", static_cast<int64_t>(record->thread_id()));
+        if (const LogSite* site = record->site()) {
+            put_string_attribute(out, tag_bytes(6), "code.file.path", site->file);
+            put_int_attribute(out, "code.line.number", site->line);
+            put_string_attribute(out, tag_bytes(6), "code.function.name", site->function);
+        }
+        if (const StackTrace* stack = record->stack()) {
+            put_string_attribute(out, tag_bytes(6), "exception.stacktrace", stack->text());
+        }
+    }
+
+    if (trace.valid()) {
+        put_fixed(out, tag_fixed32(8), trace.flags, 4);
+        put_bytes(out, tag_bytes(9),
+                  std::string_view(reinterpret_cast<const char*>(trace.trace_id.data()), trace.trace_id.size()));
+        put_bytes(out, tag_bytes(10),
+                  std::string_view(reinterpret_cast<const char*>(trace.span_id.data()), trace.span_id.size()));
+    }
+    return out;
+}
+
+bool OtlpLogSink::push(std::string_view logger_name, std::string encoded) {
+    if (queue_.size() >= options_.max_queue_size) {
+        ++records_dropped_;
+        return false;
+    }
+    auto it = scope_index_.find(logger_name);
+    if (it == scope_index_.end()) {
+        scopes_.push_back(std::make_unique<Scope>());
+        put_bytes(scopes_.back()->encoded, tag_bytes(1), logger_name);
+        it = scope_index_.emplace(std::string(logger_name), scopes_.back().get()).first;
+    }
+    queue_.push_back({it->second, std::move(encoded)});
+    return true;
+}
+
+bool OtlpLogSink::wake_needed(size_t before) const {
+    // The first record starts the schedule_delay timer; the one that
+    // fills a batch sends it now
+    const size_t batch = options_.max_export_batch_size;
+    return before == 0 || (before < batch && queue_.size() >= batch);
+}
+
+void OtlpLogSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    std::string encoded = encode(level, message, LogClock::now(), TraceContext::current(), nullptr);
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t before = queue_.size();
+        push(logger_name, std::move(encoded));
+        wake = wake_needed(before);
+    }
+    if (wake) {
+        HttpTransport::instance().wake();
+    }
+}
+
+void OtlpLogSink::log_record(const FormattedRecord& record) {
+    log_batch(std::span<const FormattedRecord>(&record, 1));
+}
+
+void OtlpLogSink::log_batch(std::span<const FormattedRecord> records) {
+    // Encoded before taking the lock, so logging threads only contend on the queue
+    thread_local std::vector<std::string> encoded;
+    encoded.clear();
+    for (const auto& record : records) {
+        encoded.push_back(encode(record.level(), record.message(), record.timestamp(), record.trace(), &record));
+    }
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t before = queue_.size();
+        for (size_t i = 0; i < records.size(); ++i) {
+            push(records[i].logger_name(), std::move(encoded[i]));
+        }
+        wake = wake_needed(before);
+    }
+    if (wake) {
+        HttpTransport::instance().wake();
+    }
+}
+
+void OtlpLogSink::flush() {
+    // forceFlush: export everything queued, then wait until none is in flight
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++flush_waiters_;
+    HttpTransport::instance().wake();
+    flushed_cv_.wait(lock, [this] { return (queue_.empty() && in_flight_ == 0) || !running_; });
+    --flush_waiters_;
+}
+
+OtlpLogSink::Stats OtlpLogSink::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{records_exported_, records_failed_, records_dropped_, exports_, retries_, queue_.size()};
+}
+
+std::chrono::steady_clock::time_point OtlpLogSink::pump(HttpTransport& transport) {
+    constexpr auto idle = std::chrono::steady_clock::time_point::max();
+    const auto now = std::chrono::steady_clock::now();
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // One export at a time, as the processor does; its completion
+        // wakes the transport for the next
+        if (queue_.empty() || in_flight_ > 0) {
+            return idle;
+        }
+        const bool due = flush_waiters_ > 0 || !running_ || queue_.size() >= options_.max_export_batch_size ||
+                         now - last_export_ >= options_.schedule_delay;
+        if (!due) {
+            return last_export_ + options_.schedule_delay;
+        }
+        count = std::min(queue_.size(), options_.max_export_batch_size);
+        sending_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            sending_.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        in_flight_ = count;
+        last_export_ = now;
+    }
+
+    build_body();
+
+    HttpRequest request;
+    request.url = url_;
+    request.body = std::move(body_);
+    request.headers = http_headers_;
+    request.timeout_ms = static_cast<long>(options_.export_timeout.count());
+    request.insecure_skip_verify = options_.insecure_skip_verify;
+    request.ca_cert_path = options_.ca_cert_path;
+    request.max_attempts = std::max(options_.max_attempts, 1);
+    request.retry_delay_ms = static_cast<long>(options_.retry_delay.count());
+    request.grpc = options_.protocol == OtlpProtocol::Grpc;
+    transport.submit(std::move(request), [this, count](const HttpResponse& response, int attempts, HttpRequest&) {
+        on_sent(response, attempts, count);
+    });
+    sending_.clear();
+    return idle;
+}
+
+void OtlpLogSink::build_body() {
+    // One ScopeLogs per logger, keeping each logger's records in order
+    std::stable_sort(sending_.begin(), sending_.end(), [](const QueuedRecord& a, const QueuedRecord& b) {
+        return std::less<const Scope*>()(a.scope, b.scope);
+    });
+
+    std::vector<size_t> scope_sizes;
+    size_t resource_logs = bytes_size(resource_.size());
+    for (size_t i = 0; i < sending_.size();) {
+        const Scope* scope = sending_[i].scope;
+        size_t size = bytes_size(scope->encoded.size());
+        for (; i < sending_.size() && sending_[i].scope == scope; ++i) {
+            size += bytes_size(sending_[i].encoded.size());
+        }
+        scope_sizes.push_back(size);
+        resource_logs += bytes_size(size);
+    }
+    const size_t message = bytes_size(resource_logs);
+
+    body_.clear();
+    const bool grpc = options_.protocol == OtlpProtocol::Grpc;
+    body_.reserve(message + 5);
+    if (grpc) {
+        // Length-prefixed message: uncompressed, then the size big-endian
+        body_.push_back(0);
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            body_.push_back(static_cast<char>((message >> shift) & 0xff));
+        }
+    }
+    body_.push_back(tag_bytes(1));
+    put_varint(body_, resource_logs);
+    put_bytes(body_, tag_bytes(1), resource_);
+    size_t group = 0;
+    for (size_t i = 0; i < sending_.size(); ++group) {
+        const Scope* scope = sending_[i].scope;
+        body_.push_back(tag_bytes(2));
+        put_varint(body_, scope_sizes[group]);
+        put_bytes(body_, tag_bytes(1), scope->encoded);
+        for (; i < sending_.size() && sending_[i].scope == scope; ++i) {
+            put_bytes(body_, tag_bytes(2), sending_[i].encoded);
+        }
+    }
+}
+
+void OtlpLogSink::on_sent(const HttpResponse& response, int attempts, size_t count) {
+    const bool grpc = options_.protocol == OtlpProtocol::Grpc;
+    const bool exported = response.success && response.status_code >= 200 && response.status_code < 300 &&
+                          (!grpc || response.grpc_status == 0);
+    if (!exported) {
+        std::cerr << "OtlpLogSink: export of " << count << " records failed after " << attempts
+                  << " attempts: " << describe(response) << std::endl;
+    }
+
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++exports_;
+        retries_ += static_cast<uint64_t>(std::max(attempts - 1, 0));
+        if (exported) {
+            records_exported_ += count;
+        } else {
+            records_failed_ += count;
+            if (!running_) {
+                // Shutting down against a collector that is not there:
+                // every remaining batch would wait out its retries too
+                records_failed_ += queue_.size();
+                queue_.clear();
+            }
+        }
+        in_flight_ = 0;
+        more = !queue_.empty();
+        // Under the lock: once it is released the destructor may go ahead
+        flushed_cv_.notify_all();
+    }
+    if (more) {
+        HttpTransport::instance().wake();
+    }
+}
+
+}
@@ -0,0 +1,234 @@
+#include "Zyrnix/sinks/parquet_sink.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/util.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+namespace Zyrnix {
+
+ParquetSink::ParquetSink(const std::string& base_name, const ParquetOptions& options)
+    : base_name_(base_name), path_(base_name + ".parquet.inprogress"), options_(options),
+      writer_(options.schema, options.codec, options.page_rows) {
+    options_.row_group_rows = std::max<size_t>(options_.row_group_rows, 1);
+    options_.max_pending = std::max<size_t>(options_.max_pending, 1);
+    // A file without its footer, from a process that did not get to
+    // finish it; set aside rather than overwritten
+    std::error_code ec;
+    if (std::filesystem::exists(path_, ec)) {
+        for (size_t n = 0;; ++n) {
+            const std::string kept = path_ + "." + std::to_string(n);
+            if (!std::filesystem::exists(kept, ec)) {
+                std::filesystem::rename(path_, kept, ec);
+                break;
+            }
+        }
+    }
+    batch_ = std::make_unique<parquet::RowBatch>(options_.schema);
+    thread_ = std::thread([this] { run_writer(); });
+}
+
+ParquetSink::~ParquetSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    writer_cv_.notify_one();
+    thread_.join();
+}
+
+void ParquetSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    if (level < get_level()) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    begin_row();
+    batch_->add(LogClock::now(), level, current_thread_id(), logger_name, message, nullptr, nullptr);
+    if (batch_->rows() >= options_.row_group_rows) {
+        wait_for_space(lock);
+        cut(false);
+    }
+}
+
+void ParquetSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    add_row(record);
+    if (batch_->rows() >= options_.row_group_rows) {
+        wait_for_space(lock);
+        cut(false);
+    }
+}
+
+void ParquetSink::log_batch(std::span<const FormattedRecord> records) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const auto& record : records) {
+        if (record.level() < get_level()) continue;
+        add_row(record);
+        if (batch_->rows() >= options_.row_group_rows) {
+            wait_for_space(lock);
+            cut(false);
+        }
+    }
+}
+
+// The first row of a batch starts its row_group_interval, which the
+// writer thread has to be told to wait for
+void ParquetSink::begin_row() {
+    if (batch_->rows() == 0) {
+        batch_started_ = std::chrono::steady_clock::now();
+        writer_cv_.notify_one();
+    }
+}
+
+void ParquetSink::add_row(const FormattedRecord& record) {
+    begin_row();
+    batch_->add(record.timestamp(), record.level(), record.thread_id(), record.logger_name(), record.message(),
+                &record.trace(), &record.fields());
+}
+
+void ParquetSink::wait_for_space(std::unique_lock<std::mutex>& lock) {
+    done_cv_.wait(lock, [this] { return queue_.size() < options_.max_pending || stopping_; });
+}
+
+// Hand the batch being gathered to the writer and start the next one
+void ParquetSink::cut(bool finish) {
+    Pending pending{nullptr, finish};
+    if (batch_->rows() > 0) {
+        pending.batch = std::move(batch_);
+        if (spare_.empty()) {
+            batch_ = std::make_unique<parquet::RowBatch>(options_.schema);
+        } else {
+            batch_ = std::move(spare_.back());
+            spare_.pop_back();
+        }
+    }
+    if (pending.batch || finish) {
+        queue_.push_back(std::move(pending));
+        writer_cv_.notify_one();
+    }
+}
+
+void ParquetSink::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+void ParquetSink::rotate() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cut(true);
+    done_cv_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+void ParquetSink::run_writer() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Wake for queued work, or when the gathered rows or the open file
+        // are due to be written out
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (batch_->rows() > 0) {
+            deadline = batch_started_ + options_.row_group_interval;
+        }
+        if (writer_.is_open() && options_.max_file_age.count() > 0) {
+            deadline = std::min(deadline, file_deadline_);
+        }
+        // No predicate: begin_row() wakes the thread to take a new deadline
+        if (!stopping_ && queue_.empty()) {
+            if (deadline == std::chrono::steady_clock::time_point::max()) {
+                writer_cv_.wait(lock);
+            } else {
+                writer_cv_.wait_until(lock, deadline);
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (queue_.empty()) {
+            if (stopping_) {
+                if (batch_->rows() == 0 && !writer_.is_open()) break;
+                cut(true);
+            } else if (batch_->rows() > 0 && now >= batch_started_ + options_.row_group_interval) {
+                cut(false);
+            } else if (writer_.is_open() && options_.max_file_age.count() > 0 && now >= file_deadline_) {
+                cut(true);
+            }
+        }
+        if (queue_.empty()) {
+            continue;
+        }
+
+        Pending pending = std::move(queue_.front());
+        queue_.pop_front();
+        busy_ = true;
+        done_cv_.notify_all();  // A slot is free
+        lock.unlock();
+        if (pending.batch) {
+            write_batch(*pending.batch);
+            pending.batch->clear();
+        }
+        if (pending.finish || (options_.max_file_rows > 0 && writer_.rows() >= options_.max_file_rows)) {
+            finish_file();
+        }
+        lock.lock();
+        if (pending.batch) {
+            spare_.push_back(std::move(pending.batch));
+        }
+        busy_ = false;
+        done_cv_.notify_all();
+    }
+}
+
+void ParquetSink::write_batch(const parquet::RowBatch& batch) {
+    if (!writer_.is_open()) {
+        if (!writer_.open(path_)) {
+            std::cerr << "ParquetSink: cannot open " << path_ << std::endl;
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        file_started_ = std::chrono::system_clock::now();
+        file_deadline_ = std::chrono::steady_clock::now() + options_.max_file_age;
+    }
+    if (!writer_.write_row_group(batch)) {
+        std::cerr << "ParquetSink: failed to write a row group to " << path_ << std::endl;
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    rows_written_.fetch_add(batch.rows(), std::memory_order_relaxed);
+}
+
+void ParquetSink::finish_file() {
+    if (!writer_.is_open()) {
+        return;
+    }
+    if (!writer_.finish()) {
+        std::cerr << "ParquetSink: failed to finish " << path_ << std::endl;
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const std::string name = finished_name();
+    if (std::rename(path_.c_str(), name.c_str()) != 0) {
+        std::cerr << "ParquetSink: cannot rename " << path_ << " to " << name << std::endl;
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    files_written_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// <base>-20261014T093000Z-0.parquet; the sequence only tells apart files
+// started within the same second
+std::string ParquetSink::finished_name() const {
+    const std::time_t second = std::chrono::system_clock::to_time_t(file_started_);
+    std::tm tm{};
+    gmtime_r(&second, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &tm);
+    std::error_code ec;
+    for (size_t n = 0;; ++n) {
+        std::string name = base_name_ + "-" + stamp + "-" + std::to_string(n) + ".parquet";
+        if (!std::filesystem::exists(name, ec)) {
+            return name;
+        }
+    }
+}
+
+}
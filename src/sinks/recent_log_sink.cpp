@@ -0,0 +1,341 @@
+#include "Zyrnix/sinks/recent_log_sink.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/json_escape.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
+#include "Zyrnix/util.hpp"
+#include <algorithm>
+#include <charconv>
+
+namespace Zyrnix {
+
+namespace {
+
+using time_point = std::chrono::system_clock::time_point;
+
+// time_point::min() and max() stand for no bound, and would overflow a
+// cast to nanoseconds where the clock counts in coarser units
+int64_t bound_ns(time_point when) {
+    if (when == time_point::min()) return INT64_MIN;
+    if (when == time_point::max()) return INT64_MAX;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+}
+
+uint8_t level_bit(LogLevel level) {
+    return static_cast<uint8_t>(1u << static_cast<unsigned>(level));
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// application/x-www-form-urlencoded: %XX escapes, and + for a space
+bool url_decode(std::string_view text, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '+') {
+            out.push_back(' ');
+        } else if (text[i] == '%') {
+            const int high = i + 2 < text.size() ? hex_digit(text[i + 1]) : -1;
+            const int low = high >= 0 ? hex_digit(text[i + 2]) : -1;
+            if (low < 0) {
+                return false;
+            }
+            out.push_back(static_cast<char>(high * 16 + low));
+            i += 2;
+        } else {
+            out.push_back(text[i]);
+        }
+    }
+    return true;
+}
+
+template <class T>
+bool parse_number(const std::string& text, T& value) {
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+}
+
+bool RecentLogQuery::parse(std::string_view query_string, RecentLogQuery& query, std::string& error) {
+    std::string key;
+    std::string value;
+    while (!query_string.empty()) {
+        const size_t amp = query_string.find('&');
+        const std::string_view pair = query_string.substr(0, amp);
+        query_string = amp == std::string_view::npos ? std::string_view() : query_string.substr(amp + 1);
+        if (pair.empty()) {
+            continue;
+        }
+        const size_t eq = pair.find('=');
+        if (!url_decode(pair.substr(0, eq), key) ||
+            !url_decode(eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1), value)) {
+            error = "bad %-escape in '" + std::string(pair) + "'";
+            return false;
+        }
+        if (key == "level") {
+            const auto [ok, level] = parse_log_level(value);
+            if (!ok) {
+                error = "unknown level '" + value + "'";
+                return false;
+            }
+            query.min_level = level;
+        } else if (key == "logger") {
+            query.logger = value;
+        } else if (key == "since_ms" || key == "until_ms") {
+            int64_t ms;
+            if (!parse_number(value, ms)) {
+                error = key + " takes Unix milliseconds, not '" + value + "'";
+                return false;
+            }
+            const time_point when{std::chrono::duration_cast<time_point::duration>(std::chrono::milliseconds(ms))};
+            (key == "since_ms" ? query.since : query.until) = when;
+        } else if (key == "contains") {
+            query.contains = value;
+        } else if (key == "limit") {
+            if (!parse_number(value, query.limit) || query.limit == 0) {
+                error = "limit takes a positive count, not '" + value + "'";
+                return false;
+            }
+        } else if (key.starts_with("field.") && key.size() > 6) {
+            query.fields.emplace_back(key.substr(6), value);
+        } else {
+            error = "unknown parameter '" + key + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string RecentLogResult::to_json() const {
+    std::string out;
+    out.append("{\"records\":[");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const RecentLogRecord& record = records[i];
+        if (i > 0) {
+            out.push_back(',');
+        }
+        out.append("{\"timestamp\":\"");
+        out.append(TimestampCache::utc(record.timestamp));
+        TimestampCache::append_fraction(out, record.timestamp, TimePrecision::Microseconds);
+        out.append("Z\",\"level\":\"");
+        out.append(level_name(record.level));
+        out.append("\",\"logger\":");
+        json::append_string(out, record.logger_name);
+        out.append(",\"thread\":");
+        out.append(std::to_string(record.thread_id));
+        out.append(",\"message\":");
+        json::append_string(out, record.message);
+        if (!record.file.empty()) {
+            out.append(",\"file\":");
+            json::append_string(out, record.file);
+            out.append(",\"line\":");
+            out.append(std::to_string(record.line));
+        }
+        if (!record.fields.empty()) {
+            out.append(",\"fields\":{");
+            for (size_t f = 0; f < record.fields.size(); ++f) {
+                if (f > 0) {
+                    out.push_back(',');
+                }
+                json::append_string(out, record.fields[f].first);
+                out.push_back(':');
+                record.fields[f].second.append_json(out);
+            }
+            out.push_back('}');
+        }
+        out.push_back('}');
+    }
+    out.append("],\"blocks_scanned\":");
+    out.append(std::to_string(blocks_scanned));
+    out.append(",\"blocks_skipped\":");
+    out.append(std::to_string(blocks_skipped));
+    out.append(",\"truncated\":");
+    out.append(truncated ? "true" : "false");
+    out.push_back('}');
+    return out;
+}
+
+RecentLogSink::RecentLogSink(const RecentLogOptions& options) : options_(options) {
+    options_.block_bytes = std::max<size_t>(options_.block_bytes, 1);
+}
+
+void RecentLogSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    if (level < get_level()) return;
+    const auto now = LogClock::now();
+    std::lock_guard<std::mutex> lock(writer_mtx_);
+    open_.add(now, level, current_thread_id(), logger_name, nullptr, message);
+    note(now, level);
+}
+
+void RecentLogSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    std::lock_guard<std::mutex> lock(writer_mtx_);
+    open_.add(record.timestamp(), record.level(), record.thread_id(), record.logger_name(), record.site(),
+              record.message(), record.fields());
+    note(record.timestamp(), record.level());
+}
+
+void RecentLogSink::log_batch(std::span<const FormattedRecord> records) {
+    std::lock_guard<std::mutex> lock(writer_mtx_);
+    for (const auto& record : records) {
+        if (record.level() < get_level()) continue;
+        open_.add(record.timestamp(), record.level(), record.thread_id(), record.logger_name(), record.site(),
+                  record.message(), record.fields());
+        note(record.timestamp(), record.level());
+    }
+}
+
+void RecentLogSink::note(time_point timestamp, LogLevel level) {
+    const int64_t ns = bound_ns(timestamp);
+    open_min_ns_ = std::min(open_min_ns_, ns);
+    open_max_ns_ = std::max(open_max_ns_, ns);
+    open_levels_ |= level_bit(level);
+    if (open_.size() >= options_.block_bytes) {
+        seal();
+    }
+}
+
+void RecentLogSink::seal() {
+    if (open_.empty()) {
+        return;
+    }
+    auto block = std::make_shared<Block>();
+    block->ref = open_.finish(block->bytes);
+    block->min_ns = open_min_ns_;
+    block->max_ns = open_max_ns_;
+    block->levels = open_levels_;
+    open_min_ns_ = INT64_MAX;
+    open_max_ns_ = INT64_MIN;
+    open_levels_ = 0;
+
+    std::lock_guard<std::mutex> lock(ring_mtx_);
+    ring_bytes_ += block->bytes.size();
+    blocks_.push_back(std::move(block));
+    // Always keep the newest, however small max_bytes is
+    while (ring_bytes_ > options_.max_bytes && blocks_.size() > 1) {
+        ring_bytes_ -= blocks_.front()->bytes.size();
+        evicted_ += blocks_.front()->ref.records;
+        blocks_.pop_front();
+    }
+}
+
+RecentLogResult RecentLogSink::query(const RecentLogQuery& query) {
+    // The sealed blocks and a copy of the open one, taken together so a
+    // seal in between cannot hide records; the open block stays open, so
+    // frequent queries do not cut the ring into small blocks
+    std::vector<std::shared_ptr<const Block>> blocks;
+    {
+        std::lock_guard<std::mutex> lock(writer_mtx_);
+        {
+            std::lock_guard<std::mutex> ring_lock(ring_mtx_);
+            blocks.assign(blocks_.begin(), blocks_.end());
+        }
+        if (!open_.empty()) {
+            auto open = std::make_shared<Block>();
+            open->ref = open_.copy_to(open->bytes);
+            open->min_ns = open_min_ns_;
+            open->max_ns = open_max_ns_;
+            open->levels = open_levels_;
+            blocks.push_back(std::move(open));
+        }
+    }
+
+    uint8_t wanted_levels = 0;
+    for (int level = static_cast<int>(query.min_level); level <= static_cast<int>(LogLevel::Critical); ++level) {
+        wanted_levels |= level_bit(static_cast<LogLevel>(level));
+    }
+    const int64_t since_ns = bound_ns(query.since);
+    const int64_t until_ns = bound_ns(query.until);
+    auto matches = [&](const binlog::DecodedRecord& record) {
+        if (record.level < query.min_level) return false;
+        const int64_t ns = bound_ns(record.timestamp);
+        if (ns < since_ns || ns > until_ns) return false;
+        if (!query.logger.empty() && record.logger_name != query.logger) return false;
+        if (!query.contains.empty() && record.message.find(query.contains) == std::string_view::npos) {
+            return false;
+        }
+        for (const auto& [key, text] : query.fields) {
+            const bool found = std::any_of(record.fields.begin(), record.fields.end(), [&](const auto& field) {
+                return field.first == key && field.second.text() == text;
+            });
+            if (!found) return false;
+        }
+        return true;
+    };
+
+    // Newest block first, stopping once limit records have matched
+    RecentLogResult result;
+    std::vector<std::vector<RecentLogRecord>> found;
+    size_t total = 0;
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+        const Block& block = **it;
+        if (total >= query.limit) {
+            result.truncated = true;
+            break;
+        }
+        if ((block.levels & wanted_levels) == 0 || block.max_ns < since_ns || block.min_ns > until_ns) {
+            ++result.blocks_skipped;
+            continue;
+        }
+        ++result.blocks_scanned;
+        auto& records = found.emplace_back();
+        binlog::decode_block(block.bytes, block.ref, [&](const binlog::DecodedRecord& record) {
+            if (!matches(record)) return;
+            RecentLogRecord& out = records.emplace_back();
+            out.timestamp = record.timestamp;
+            out.level = record.level;
+            out.thread_id = record.thread_id;
+            out.logger_name = record.logger_name;
+            out.message = record.message;
+            out.file = record.file;
+            out.line = record.line;
+            out.fields.reserve(record.fields.size());
+            for (const auto& [key, value] : record.fields) {
+                out.fields.emplace_back(std::string(key), value);
+            }
+        });
+        total += records.size();
+    }
+
+    // Oldest first, without the matches past limit in the oldest block read
+    size_t skip = total > query.limit ? total - query.limit : 0;
+    result.truncated = result.truncated || skip > 0;
+    result.records.reserve(total - skip);
+    for (auto chunk = found.rbegin(); chunk != found.rend(); ++chunk) {
+        const size_t dropped = std::min(skip, chunk->size());
+        skip -= dropped;
+        std::move(chunk->begin() + static_cast<std::ptrdiff_t>(dropped), chunk->end(),
+                  std::back_inserter(result.records));
+    }
+    return result;
+}
+
+size_t RecentLogSink::size_bytes() const {
+    std::lock_guard<std::mutex> lock(ring_mtx_);
+    return ring_bytes_;
+}
+
+uint64_t RecentLogSink::evicted() const {
+    std::lock_guard<std::mutex> lock(ring_mtx_);
+    return evicted_;
+}
+
+std::string handle_recent_logs_request(RecentLogSink& sink, std::string_view query_string) {
+    RecentLogQuery query;
+    std::string error;
+    if (!RecentLogQuery::parse(query_string, query, error)) {
+        std::string out = "{\"error\":";
+        json::append_string(out, error);
+        out.push_back('}');
+        return out;
+    }
+    return sink.query(query).to_json();
+}
+
+}
@@ -0,0 +1,318 @@
+#include "Zyrnix/sinks/rfc5424_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/sinks/flush_policy.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
+#include <sys/un.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace Zyrnix {
+
+namespace {
+
+int severity(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace:
+        case LogLevel::Debug: return LOG_DEBUG;
+        case LogLevel::Info: return LOG_INFO;
+        case LogLevel::Warn: return LOG_WARNING;
+        case LogLevel::Error: return LOG_ERR;
+        case LogLevel::Critical: return LOG_CRIT;
+        default: return LOG_INFO;
+    }
+}
+
+std::string local_hostname() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+        return "localhost";
+    }
+    return name;
+}
+
+std::string program_name() {
+#if defined(__GLIBC__)
+    return program_invocation_short_name;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    return getprogname();
+#else
+    return "";
+#endif
+}
+
+// HOSTNAME, APP-NAME, PROCID and MSGID are printable US-ASCII without
+// spaces, "-" when empty
+void append_header_field(std::string& out, std::string_view value, size_t max_size) {
+    if (value.empty()) {
+        out += '-';
+        return;
+    }
+    for (char c : value.substr(0, max_size)) {
+        out += c > ' ' && c < 127 ? c : '_';
+    }
+}
+
+// SD-NAME also excludes '=', ']' and '"'
+void append_param_name(std::string& out, std::string_view key) {
+    if (key.empty()) {
+        out += '_';
+        return;
+    }
+    for (char c : key.substr(0, 32)) {
+        out += c > ' ' && c < 127 && c != '=' && c != ']' && c != '"' ? c : '_';
+    }
+}
+
+void append_param_value(std::string& out, std::string_view value) {
+    for (char c : value) {
+        if (c == '"' || c == '\\' || c == ']') {
+            out += '\\';
+        }
+        out += c;
+    }
+}
+
+// Cut the frame starting at start to max bytes without splitting a UTF-8 sequence
+void truncate_frame(std::string& out, size_t start, size_t max) {
+    if (out.size() - start <= max) {
+        return;
+    }
+    size_t cut = start + max;
+    while (cut > start && (static_cast<unsigned char>(out[cut]) & 0xC0) == 0x80) {
+        --cut;
+    }
+    out.resize(cut);
+}
+
+bool reconnectable(int error) {
+    return error == ECONNREFUSED || error == ENOTCONN || error == ECONNRESET || error == ENOENT;
+}
+
+}
+
+Rfc5424Sink::Rfc5424Sink(const Rfc5424Options& options) : options_(options) {
+    options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+    options_.max_frame = std::max<size_t>(options_.max_frame, 480);  // What every receiver must accept
+
+    for (int level = 0; level < 6; ++level) {
+        pri_[level] = "<" + std::to_string(options_.facility + severity(static_cast<LogLevel>(level))) + ">1 ";
+    }
+    header_tail_ = " ";
+    append_header_field(header_tail_, options_.hostname.empty() ? local_hostname() : options_.hostname, 255);
+    header_tail_ += ' ';
+    append_header_field(header_tail_, options_.app_name.empty() ? program_name() : options_.app_name, 48);
+    header_tail_ += ' ';
+    header_tail_ += std::to_string(getpid());
+    header_tail_ += ' ';
+
+    std::memset(&dest_, 0, sizeof(dest_));
+    if (options_.host.empty()) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (options_.socket_path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Rfc5424Sink: socket path too long: " << options_.socket_path << std::endl;
+            return;
+        }
+        std::memcpy(addr.sun_path, options_.socket_path.c_str(), options_.socket_path.size());
+        std::memcpy(&dest_, &addr, sizeof(addr));
+        dest_len_ = sizeof(addr);
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    } else {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* res = nullptr;
+        const std::string port = std::to_string(options_.port);
+        if (getaddrinfo(options_.host.c_str(), port.c_str(), &hints, &res) == 0) {
+            for (addrinfo* p = res; p != nullptr && fd_ < 0; p = p->ai_next) {
+                fd_ = ::socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+                if (fd_ >= 0) {
+                    std::memcpy(&dest_, p->ai_addr, p->ai_addrlen);
+                    dest_len_ = static_cast<socklen_t>(p->ai_addrlen);
+                }
+            }
+            freeaddrinfo(res);
+        }
+    }
+    if (fd_ < 0) {
+        std::cerr << "Rfc5424Sink: cannot open a socket for "
+                  << (options_.host.empty() ? options_.socket_path : options_.host) << std::endl;
+        return;
+    }
+    ::fcntl(fd_, F_SETFD, FD_CLOEXEC);
+    if (!reconnect()) {
+        // Kept: sends reconnect once the daemon is listening
+        std::cerr << "Rfc5424Sink: cannot connect to "
+                  << (options_.host.empty() ? options_.socket_path : options_.host) << ": "
+                  << std::strerror(errno) << std::endl;
+    }
+
+    if (batching()) {
+        frames_.reserve(options_.batch_size);
+        BackgroundFlusher::instance().add(this, options_.flush_interval);
+    }
+}
+
+Rfc5424Sink::~Rfc5424Sink() {
+    if (batching() && fd_ >= 0) {
+        BackgroundFlusher::instance().remove(this);
+        std::lock_guard<std::mutex> lock(mutex_);
+        send_buffered();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void Rfc5424Sink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    write(logger_name, level, LogClock::now(), nullptr, message);
+}
+
+void Rfc5424Sink::log_record(const FormattedRecord& record) {
+    write(record.logger_name(), record.level(), record.timestamp(), &record, record.message());
+}
+
+void Rfc5424Sink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    send_buffered();
+}
+
+void Rfc5424Sink::append_frame(std::string& out, std::string_view logger_name, LogLevel level,
+                               std::chrono::system_clock::time_point timestamp, const FormattedRecord* record,
+                               std::string_view message) const {
+    out += pri_[std::clamp(static_cast<int>(level), 0, 5)];
+    out += TimestampCache::utc(timestamp);
+    TimestampCache::append_fraction(out, timestamp, TimePrecision::Microseconds);
+    out += 'Z';
+    out += header_tail_;
+    append_header_field(out, logger_name, 32);
+    out += ' ';
+
+    if (record && !options_.fields_sd_id.empty() && !record->fields().empty()) {
+        out += '[';
+        out += options_.fields_sd_id;
+        for (const auto& field : record->fields()) {
+            out += ' ';
+            append_param_name(out, field.key);
+            out += "=\"";
+            append_param_value(out, field.value.text());
+            out += '"';
+        }
+        out += ']';
+    } else {
+        out += '-';
+    }
+
+    if (!message.empty()) {
+        out += ' ';
+        out += message;
+    }
+}
+
+void Rfc5424Sink::write(std::string_view logger_name, LogLevel level, std::chrono::system_clock::time_point timestamp,
+                        const FormattedRecord* record, std::string_view message) {
+    if (fd_ < 0) return;
+    if (!batching()) {
+        // A datagram goes out whole, so unbatched frames need no lock
+        thread_local std::string frame;
+        frame.clear();
+        append_frame(frame, logger_name, level, timestamp, record, message);
+        truncate_frame(frame, 0, options_.max_frame);
+        send_one(frame);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t start = buffer_.size();
+    append_frame(buffer_, logger_name, level, timestamp, record, message);
+    truncate_frame(buffer_, start, options_.max_frame);
+    frames_.push_back({start, buffer_.size() - start});
+    if (frames_.size() >= options_.batch_size || (options_.flush_on && level >= *options_.flush_on)) {
+        send_buffered();
+    }
+}
+
+bool Rfc5424Sink::send_one(std::string_view frame) {
+    bool retried = false;
+    for (;;) {
+        if (::send(fd_, frame.data(), frame.size(), 0) >= 0) {
+            return true;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (retried || !reconnectable(errno)) {
+            return false;
+        }
+        retried = true;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!reconnect()) {
+            return false;
+        }
+    }
+}
+
+bool Rfc5424Sink::reconnect() {
+    // A local daemon that restarted has a new socket at the same path;
+    // connecting again finds it. Over UDP this only refreshes the route
+    return ::connect(fd_, reinterpret_cast<const sockaddr*>(&dest_), dest_len_) == 0;
+}
+
+void Rfc5424Sink::send_buffered() {
+    if (frames_.empty()) return;
+    const size_t n = frames_.size();
+    iovecs_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        iovecs_[i] = {buffer_.data() + frames_[i].offset, frames_[i].size};
+    }
+
+    bool retried = false;
+#ifdef __linux__
+    messages_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        struct msghdr& msg = messages_[i].msg_hdr;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iovecs_[i];
+        msg.msg_iovlen = 1;
+    }
+    size_t done = 0;
+    while (done < n) {
+        const int sent = sendmmsg(fd_, messages_.data() + done, static_cast<unsigned int>(n - done), 0);
+        if (sent > 0) {
+            done += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && !retried && reconnectable(errno) && reconnect()) {
+            retried = true;
+        } else {
+            ++done;  // This frame is lost; send the rest
+        }
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iovecs_[i];
+        msg.msg_iovlen = 1;
+        while (sendmsg(fd_, &msg, 0) < 0) {
+            if (errno == EINTR) continue;
+            if (retried || !reconnectable(errno) || !reconnect()) break;
+            retried = true;
+        }
+    }
+#endif
+
+    buffer_.clear();
+    frames_.clear();
+}
+
+}
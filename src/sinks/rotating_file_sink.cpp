@@ -1,80 +1,334 @@
 #include "Zyrnix/sinks/rotating_file_sink.hpp"
 #include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
 #include "Zyrnix/util.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include "Zyrnix/tracepoints.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <filesystem>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
 namespace fs = std::filesystem;
 
 namespace Zyrnix {
 
-RotatingFileSink::RotatingFileSink(const std::string& base, size_t max_s, size_t max_f)
-    : base_name(base), max_size(max_s), max_files(max_f) {
+namespace {
+
+fs::path native(const std::string& name) {
+    return fs::path(path::to_native(name));
+}
+
+// "<stamp>-<n>.log", what follows ".rotating-" in a parked file's name
+bool parse_parked(std::string_view rest, uint64_t& stamp, uint64_t& sequence) {
+    constexpr std::string_view extension = ".log";
+    if (rest.size() <= extension.size() || rest.substr(rest.size() - extension.size()) != extension) {
+        return false;
+    }
+    rest.remove_suffix(extension.size());
+    const char* end = rest.data() + rest.size();
+    const auto stamp_end = std::from_chars(rest.data(), end, stamp);
+    if (stamp_end.ec != std::errc() || stamp_end.ptr == end || *stamp_end.ptr != '-') {
+        return false;
+    }
+    const auto sequence_end = std::from_chars(stamp_end.ptr + 1, end, sequence);
+    return sequence_end.ec == std::errc() && sequence_end.ptr == end;
+}
+
+RotationOptions by_size(size_t max_size, size_t max_files) {
+    RotationOptions options;
+    options.max_size = max_size;
+    options.max_files = max_files;
+    return options;
+}
+
+}
+
+RotatingFileSink::RotatingFileSink(const std::string& base, size_t max_s, size_t max_f, const FlushPolicy& policy)
+    : RotatingFileSink(base, by_size(max_s, max_f), policy) {}
+
+RotatingFileSink::RotatingFileSink(const std::string& base, const RotationOptions& opts, const FlushPolicy& policy)
+    : base_name(base), options(opts), buffer(policy), file(policy.backend, policy.buffer_size) {
+    if (options.sidecar.enabled) {
+        index = std::make_unique<sidecar::Builder>(options.sidecar);
+    }
     open_file();
+    recover_parked();
+    schedule_rollover();
+    if (policy.sync_on) {
+        start_commit();
+    }
+    BackgroundFlusher::instance().add(this, policy.interval);
 }
 
-void RotatingFileSink::open_file() {
-    std::string filename = base_name + ".log";
-    
-   
-#ifdef _WIN32
-    std::wstring wpath = path::to_native(filename);
-    file.open(wpath, std::ios::app);
-    if (file.is_open()) {
-        current_size = std::filesystem::file_size(fs::path(wpath));
+RotatingFileSink::~RotatingFileSink() {
+    BackgroundFlusher::instance().remove(this);
+    commit.reset();  // Serves the syncs still waiting
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (file.is_open()) {
+            buffer.write_out(file);
+            file.close();
+            if (index && index->complete()) {
+                index->write(base_name + ".log" + std::string(sidecar::suffix), current_size);
+            }
+        }
     }
-#else
-    file.open(filename, std::ios::app);
-    if (file.is_open()) {
-        current_size = std::filesystem::file_size(filename);
+    // Let the renamer finish the rotations already handed to it
+    {
+        std::lock_guard<std::mutex> lock(rename_mtx);
+        stopping = true;
+    }
+    rename_cv.notify_one();
+    if (renamer.joinable()) {
+        renamer.join();
     }
-#endif
 }
 
+void RotatingFileSink::schedule_rollover() {
+    if (options.interval != RotationInterval::None) {
+        next_rollover_ns = next_local_rollover_ns(std::chrono::system_clock::now(),
+                                                  options.interval == RotationInterval::Daily);
+    }
+}
+
+void RotatingFileSink::open_file() {
+    if (file.open(base_name + ".log")) {
+        current_size = static_cast<size_t>(file.size());
+        if (index) {
+            index->resume(base_name + ".log" + std::string(sidecar::suffix), current_size);
+        }
+    }
+}
+
+// Logging threads wait for one rename and one open; the cascade that
+// makes room for the parked file as .0 runs on the renamer thread
 void RotatingFileSink::rotate() {
+    XLOG_PROBE(rotate, base_name.c_str(), current_size);
+    // The buffered lines belong to the file being rotated out. A waiting
+    // sync would only reach the new file, so this one is synced here
+    buffer.write_out(file);
+    if (commit) {
+        file.sync();
+    }
     file.close();
-    
-
-    for (size_t i = max_files; i > 0; --i) {
-        std::string old_name = base_name + "." + std::to_string(i-1) + ".log";
-        std::string new_name = base_name + "." + std::to_string(i) + ".log";
-        
-#ifdef _WIN32
-        fs::path old_path(path::to_native(old_name));
-        fs::path new_path(path::to_native(new_name));
-        if (fs::exists(old_path)) {
-            std::error_code ec;
-            fs::rename(old_path, new_path, ec);
-        }
-#else
-        if (fs::exists(old_name)) {
-            std::error_code ec;
-            fs::rename(old_name, new_name, ec);
+    schedule_rollover();
+
+    const auto stamp = std::chrono::system_clock::now().time_since_epoch().count();
+    std::string parked = base_name + ".rotating-" + std::to_string(stamp) + "-" + std::to_string(rotations++) + ".log";
+    std::error_code ec;
+    fs::rename(native(base_name + ".log"), native(parked), ec);
+    if (!ec && index) {
+        // A page-cache write of the filter; the renamer moves it with the file
+        if (index->complete()) {
+            index->write(parked + std::string(sidecar::suffix), current_size);
         }
-#endif
-    }
-    
-    std::string current_file = base_name + ".log";
-    std::string rotated_file = base_name + ".0.log";
-    
-#ifdef _WIN32
-    fs::path current_path(path::to_native(current_file));
-    fs::path rotated_path(path::to_native(rotated_file));
+        std::error_code stale;
+        fs::remove(native(base_name + ".log" + std::string(sidecar::suffix)), stale);
+    }
+    open_file();
+    if (ec) {
+        return;  // Carry on appending to the same file, as a failed rename always did
+    }
+
+    std::lock_guard<std::mutex> lock(rename_mtx);
+    pending.push_back(std::move(parked));
+    if (!renamer.joinable()) {
+        renamer = std::thread(&RotatingFileSink::run_renamer, this);
+    }
+    rename_cv.notify_one();
+}
+
+// A process that dies between parking a file and shifting it in leaves
+// it behind; queue those to the renamer, oldest first, so they still
+// become .0 and up rather than sit outside the rotation forever
+void RotatingFileSink::recover_parked() {
+    const fs::path base_path = native(base_name);
+    const std::string prefix = base_path.filename().string() + ".rotating-";
+    const fs::path dir = base_path.has_parent_path() ? base_path.parent_path() : fs::path(".");
+    std::vector<std::tuple<uint64_t, uint64_t, std::string>> parked;
     std::error_code ec;
-    fs::rename(current_path, rotated_path, ec);
-#else
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        uint64_t stamp = 0;
+        uint64_t sequence = 0;
+        if (name.compare(0, prefix.size(), prefix) == 0 &&
+            parse_parked(std::string_view(name).substr(prefix.size()), stamp, sequence)) {
+            parked.emplace_back(stamp, sequence, base_name + ".rotating-" + name.substr(prefix.size()));
+        }
+    }
+    if (parked.empty()) {
+        return;
+    }
+    std::sort(parked.begin(), parked.end());
+    std::lock_guard<std::mutex> lock(rename_mtx);
+    for (auto& file : parked) {
+        pending.push_back(std::move(std::get<2>(file)));
+    }
+    renamer = std::thread(&RotatingFileSink::run_renamer, this);
+    rename_cv.notify_one();
+}
+
+void RotatingFileSink::shift_in(const std::string& parked) {
+    for (size_t i = options.max_files; i > 0; --i) {
+        const std::string old_name = base_name + "." + std::to_string(i - 1) + ".log";
+        if (fs::exists(native(old_name))) {
+            move_file(old_name, base_name + "." + std::to_string(i) + ".log");
+        }
+    }
+    move_file(parked, base_name + ".0.log");
+    if (options.max_total_bytes > 0) {
+        enforce_total_bytes();
+    }
+}
+
+// With its sidecar: one left at to from the file it replaces would let a
+// search skip this one
+void RotatingFileSink::move_file(const std::string& from, const std::string& to) {
     std::error_code ec;
-    fs::rename(current_file, rotated_file, ec);
-#endif
-    
-    open_file();
+    fs::rename(native(from), native(to), ec);
+    if (index) {
+        const std::string suffix(sidecar::suffix);
+        fs::remove(native(to + suffix), ec);
+        fs::rename(native(from + suffix), native(to + suffix), ec);
+    }
+}
+
+void RotatingFileSink::enforce_total_bytes() {
+    std::vector<std::pair<fs::path, uint64_t>> rotated;  // Newest first
+    uint64_t total = 0;
+    for (size_t i = 0; i <= options.max_files; ++i) {
+        fs::path rotated_path = native(base_name + "." + std::to_string(i) + ".log");
+        std::error_code ec;
+        const auto bytes = fs::file_size(rotated_path, ec);
+        if (!ec) {
+            total += bytes;
+            rotated.emplace_back(std::move(rotated_path), bytes);
+        }
+    }
+    while (total > options.max_total_bytes && rotated.size() > 1) {
+        std::error_code ec;
+        fs::remove(rotated.back().first, ec);
+        fs::remove(rotated.back().first.string() + std::string(sidecar::suffix), ec);
+        total -= rotated.back().second;
+        rotated.pop_back();
+    }
+}
+
+void RotatingFileSink::run_renamer() {
+    init_background_thread("xlog-rotate");
+    std::unique_lock<std::mutex> lock(rename_mtx);
+    for (;;) {
+        rename_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return;  // Stopping, and nothing left to do
+        }
+        // Oldest first, so .0 ends up the most recent
+        std::string parked = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        shift_in(parked);
+        lock.lock();
+    }
 }
 
 void RotatingFileSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
-    if (level < get_level()) return;
+    log_as_record(logger_name, level, message);
+}
+
+void RotatingFileSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    write_line(record.formatted(formatter), record.level(), &record);
+}
+
+void RotatingFileSink::write_line(const std::string& line, LogLevel level, const FormattedRecord* record) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file.is_open()) return;
+        append_line(line, level, record);
+    }
+    if (durable(level)) {
+        commit->request().wait();
+    }
+}
+
+void RotatingFileSink::log_batch(std::span<const FormattedRecord> records) {
+    bool sync = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file.is_open()) return;
+        for (const auto& record : records) {
+            if (record.level() < get_level()) continue;
+            append_line(record.formatted(formatter), record.level(), &record);
+            sync = sync || durable(record.level());
+        }
+    }
+    if (sync) {
+        commit->request().wait();
+    }
+}
+
+void RotatingFileSink::append_line(const std::string& line, LogLevel level, const FormattedRecord* record) {
+    // A line logged after the boundary starts the new file
+    if (realtime_coarse_ns() >= next_rollover_ns) {
+        if (current_size > 0) {
+            rotate();
+        } else {
+            schedule_rollover();
+        }
+    }
+    buffer.append(file, line, level);
+    current_size += line.size() + 1;
+    if (index) {
+        if (record) {
+            index->add(*record);
+        } else {
+            index->add(LogClock::now(), level);
+        }
+    }
+    if (options.max_size > 0 && current_size >= options.max_size) rotate();
+}
+
+bool RotatingFileSink::durable(LogLevel level) const {
+    const auto& sync_on = buffer.policy().sync_on;
+    return sync_on && level >= *sync_on;
+}
+
+std::future<void> RotatingFileSink::sync() {
+    GroupCommit* committer;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!commit) {
+            start_commit();
+        }
+        committer = commit.get();
+    }
+    return committer->request();
+}
+
+void RotatingFileSink::start_commit() {
+    commit = std::make_unique<GroupCommit>([this] {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file.is_open()) {
+            return -1;
+        }
+        buffer.write_out(file);
+        file.wait();
+        return file.open_for_sync();
+    });
+}
+
+void RotatingFileSink::flush() {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string line = formatter.format(logger_name, level, message) + "\n";
-    file << line;
-    current_size += line.size();
-    if (current_size >= max_size) rotate();
+    if (file.is_open()) {
+        buffer.write_out(file);
+        file.wait();
+    }
 }
 
 }
@@ -0,0 +1,242 @@
+#include "Zyrnix/sinks/shared_file_sink.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
+#include "Zyrnix/tracepoints.hpp"
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr int64_t check_interval_ns = 1'000'000'000;
+constexpr size_t max_pieces = 2 * 512;  // Line and newline per record, well under IOV_MAX
+const char newline = '\n';
+
+int open_append(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+}
+
+// The whole of iov, resuming after a short write; false on an error
+bool write_all(int fd, iovec* iov, int count) {
+    while (count > 0) {
+        const ssize_t n = ::writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        size_t left = static_cast<size_t>(n);
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+// fcntl() locks belong to the process, so they also exclude children
+// that share the descriptor after fork(), unlike flock()
+bool lock_file(int fd, short type) {
+    struct flock lock{};
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    while (fcntl(fd, F_SETLKW, &lock) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same_file(const struct stat& a, const struct stat& b) {
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+}
+
+SharedFileSink::SharedFileSink(const std::string& base_name, const SharedFileOptions& options)
+    : base_name_(base_name), path_(base_name + ".log"), options_(options) {
+    // Often enough that the file overshoots max_size by little, however
+    // many processes write to it
+    check_bytes_ = options_.max_size > 0 ? std::clamp<uint64_t>(options_.max_size / 256, 4096, 1 << 20) : UINT64_MAX;
+    options_.max_write = std::max<size_t>(options_.max_write, 1);
+    fd_ = open_append(path_);
+    if (fd_ < 0) {
+        std::cerr << "SharedFileSink: cannot open " << path_ << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    if (options_.max_size > 0 && options_.rotator) {
+        const std::string lock_path = base_name_ + ".lock";
+        lock_fd_ = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lock_fd_ < 0) {
+            std::cerr << "SharedFileSink: cannot open " << lock_path << ", not rotating: "
+                      << std::strerror(errno) << std::endl;
+        }
+    }
+    next_check_ns_.store(realtime_coarse_ns() + check_interval_ns, std::memory_order_relaxed);
+}
+
+SharedFileSink::~SharedFileSink() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (lock_fd_ >= 0) {
+        ::close(lock_fd_);
+    }
+}
+
+bool SharedFileSink::is_open() const {
+    return fd_ >= 0;
+}
+
+void SharedFileSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    log_as_record(logger_name, level, message);
+}
+
+void SharedFileSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    write_one(record.formatted(formatter));
+}
+
+void SharedFileSink::write_one(std::string_view line) {
+    const Piece pieces[2] = {{line.data(), line.size()}, {&newline, 1}};
+    write_pieces(pieces, 2, 1);
+}
+
+void SharedFileSink::log_batch(std::span<const FormattedRecord> records) {
+    thread_local std::vector<Piece> pieces;
+    pieces.clear();
+    size_t bytes = 0;
+    size_t grouped = 0;
+    for (const auto& record : records) {
+        if (record.level() < get_level()) continue;
+        const std::string& line = record.formatted(formatter);
+        // Whole records only: write out the group this one would overflow
+        if (grouped > 0 && (bytes + line.size() + 1 > options_.max_write || pieces.size() == max_pieces)) {
+            write_pieces(pieces.data(), pieces.size(), grouped);
+            pieces.clear();
+            bytes = 0;
+            grouped = 0;
+        }
+        pieces.push_back({line.data(), line.size()});
+        pieces.push_back({&newline, 1});
+        bytes += line.size() + 1;
+        ++grouped;
+    }
+    if (grouped > 0) {
+        write_pieces(pieces.data(), pieces.size(), grouped);
+    }
+}
+
+void SharedFileSink::write_pieces(const Piece* pieces, size_t count, size_t records) {
+    iovec iov[max_pieces];
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = const_cast<char*>(pieces[i].data);
+        iov[i].iov_len = pieces[i].size;
+        bytes += pieces[i].size;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        if (fd_ < 0) {
+            return;
+        }
+        if (!write_all(fd_, iov, static_cast<int>(count))) {
+            write_errors_.fetch_add(records, std::memory_order_relaxed);
+        }
+    }
+    after_write(bytes);
+}
+
+void SharedFileSink::after_write(size_t bytes) {
+    const uint64_t written = since_check_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    const int64_t now = realtime_coarse_ns();
+    if (written < check_bytes_ && now < next_check_ns_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    since_check_.store(0, std::memory_order_relaxed);
+    next_check_ns_.store(now + check_interval_ns, std::memory_order_relaxed);
+    check_file();
+}
+
+void SharedFileSink::check_file() {
+    struct stat open_st;
+    struct stat path_st;
+    bool moved;
+    bool full;
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        if (fd_ < 0 || fstat(fd_, &open_st) != 0) {
+            return;
+        }
+        moved = stat(path_.c_str(), &path_st) != 0 || !same_file(open_st, path_st);
+        full = options_.max_size > 0 && static_cast<uint64_t>(open_st.st_size) >= options_.max_size;
+    }
+    if (moved) {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        if (reopen()) {
+            reopens_.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else if (full && lock_fd_ >= 0) {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        rotate();
+    }
+}
+
+bool SharedFileSink::reopen() {
+    const int fd = open_append(path_);
+    if (fd < 0) {
+        return false;  // Keep appending to the file already open
+    }
+    ::close(fd_);
+    fd_ = fd;
+    return true;
+}
+
+void SharedFileSink::rotate() {
+    if (!lock_file(lock_fd_, F_WRLCK)) {
+        return;
+    }
+    // Another process may have rotated while this one waited for the lock,
+    // or this thread may be the second in this process to get here
+    struct stat open_st;
+    struct stat path_st;
+    const bool ours = fstat(fd_, &open_st) == 0 && stat(path_.c_str(), &path_st) == 0 &&
+                      same_file(open_st, path_st);
+    if (!ours) {
+        if (reopen()) {
+            reopens_.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else if (static_cast<uint64_t>(path_st.st_size) >= options_.max_size) {
+        XLOG_PROBE(rotate, base_name_.c_str(), static_cast<size_t>(path_st.st_size));
+        for (size_t i = options_.max_files; i > 0; --i) {
+            const std::string from = base_name_ + "." + std::to_string(i - 1) + ".log";
+            const std::string to = base_name_ + "." + std::to_string(i) + ".log";
+            std::rename(from.c_str(), to.c_str());  // Fails harmlessly for files not there yet
+        }
+        const std::string newest = base_name_ + ".0.log";
+        if (std::rename(path_.c_str(), newest.c_str()) == 0 && reopen()) {
+            rotations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    lock_file(lock_fd_, F_UNLCK);
+}
+
+}
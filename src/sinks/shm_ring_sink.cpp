@@ -0,0 +1,175 @@
+#include "Zyrnix/sinks/shm_ring_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/util.hpp"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace Zyrnix {
+
+namespace {
+
+// Each thread builds its blocks in its own buffers, so writers share
+// nothing but the ring's head
+struct Scratch {
+    binlog::BlockWriter block;
+    std::string out;
+};
+
+Scratch& scratch() {
+    thread_local Scratch s;
+    return s;
+}
+
+void store_commit(char* entry, uint64_t value) {
+    std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(entry)).store(value, std::memory_order_release);
+}
+
+void write_entry_header(char* entry, uint32_t size, shmring::EntryKind kind) {
+    const auto kind_value = static_cast<uint32_t>(kind);
+    std::memcpy(entry + 8, &size, sizeof(size));
+    std::memcpy(entry + 12, &kind_value, sizeof(kind_value));
+}
+
+}
+
+ShmRingSink::ShmRingSink(const std::string& name, const ShmRingOptions& options)
+    : name_(name), max_entry_bytes_(std::max<size_t>(options.max_entry_bytes, 1)) {
+    capacity_ = std::bit_ceil(std::max<uint64_t>(options.capacity, 4096));
+
+    // A ring left by a process that crashed is replaced, not reused: its
+    // head and tail may be anywhere
+    shm_unlink(name_.c_str());
+    const int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "ShmRingSink: cannot create " << name_ << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    const size_t size = shmring::header_size + static_cast<size_t>(capacity_);
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "ShmRingSink: cannot map " << name_ << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name_.c_str());
+        return;
+    }
+
+    // The object comes zero-filled: every commit word already reads as
+    // unwritten
+    header_ = new (map) shmring::Header{};
+    std::memcpy(header_->magic, shmring::magic, sizeof(shmring::magic));
+    header_->header_size = shmring::header_size;
+    header_->capacity = capacity_;
+    header_->owner_pid = getpid();
+    header_->version.store(shmring::format_version, std::memory_order_release);
+    data_ = static_cast<char*>(map) + shmring::header_size;
+    mapped_size_ = size;
+}
+
+ShmRingSink::~ShmRingSink() {
+    if (!header_) return;
+    header_->closed.store(1, std::memory_order_release);
+    shmring::notify(*header_);
+    munmap(header_, mapped_size_);
+    shm_unlink(name_.c_str());
+}
+
+void ShmRingSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    if (!header_) return;
+    Scratch& s = scratch();
+    s.block.add(LogClock::now(), level, current_thread_id(), logger_name, nullptr, message);
+    s.out.clear();
+    s.block.finish(s.out);
+    if (write(s.out)) {
+        records_written_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        records_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ShmRingSink::log_record(const FormattedRecord& record) {
+    log_batch(std::span<const FormattedRecord>(&record, 1));
+}
+
+void ShmRingSink::log_batch(std::span<const FormattedRecord> records) {
+    if (!header_) return;
+    Scratch& s = scratch();
+    size_t pending = 0;
+    const auto send = [&] {
+        s.out.clear();
+        s.block.finish(s.out);
+        if (write(s.out)) {
+            records_written_.fetch_add(pending, std::memory_order_relaxed);
+        } else {
+            records_dropped_.fetch_add(pending, std::memory_order_relaxed);
+        }
+        pending = 0;
+    };
+    for (const auto& record : records) {
+        s.block.add(record.timestamp(), record.level(), record.thread_id(), record.logger_name(), record.site(),
+                    record.message(), record.fields());
+        ++pending;
+        if (s.block.size() >= max_entry_bytes_) {
+            send();
+        }
+    }
+    if (pending > 0) {
+        send();
+    }
+}
+
+bool ShmRingSink::write(std::string_view block) {
+    const uint64_t size = (shmring::entry_header_size + block.size() + shmring::entry_alignment - 1) &
+                          ~static_cast<uint64_t>(shmring::entry_alignment - 1);
+    if (size > capacity_ || block.size() > UINT32_MAX) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Reserve the entry, and the padding to the end of the data area if
+    // it would wrap
+    uint64_t pos = header_->head.load(std::memory_order_relaxed);
+    uint64_t pad;
+    for (;;) {
+        const uint64_t offset = pos & (capacity_ - 1);
+        pad = capacity_ - offset < size ? capacity_ - offset : 0;
+        if (pos + pad + size - header_->tail.load(std::memory_order_acquire) > capacity_) {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (header_->head.compare_exchange_weak(pos, pos + pad + size, std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (pad > 0) {
+        char* entry = data_ + (pos & (capacity_ - 1));
+        write_entry_header(entry, static_cast<uint32_t>(pad - shmring::entry_header_size),
+                           shmring::EntryKind::Padding);
+        store_commit(entry, pos + 1);
+        pos += pad;
+    }
+    char* entry = data_ + (pos & (capacity_ - 1));
+    write_entry_header(entry, static_cast<uint32_t>(block.size()), shmring::EntryKind::Data);
+    std::memcpy(entry + shmring::entry_header_size, block.data(), block.size());
+    store_commit(entry, pos + 1);
+    shmring::notify(*header_);
+    return true;
+}
+
+ShmRingSink::Stats ShmRingSink::get_stats() const {
+    return Stats{records_written_.load(std::memory_order_relaxed), records_dropped_.load(std::memory_order_relaxed)};
+}
+
+}
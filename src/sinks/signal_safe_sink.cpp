@@ -2,14 +2,58 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <cstring>
 #include <algorithm>
+#include <bit>
 #include <cerrno>
 
 namespace Zyrnix {
 
-SignalSafeSink::SignalSafeSink(const std::string& path, size_t buffer_size) 
-    : fd_(-1), capacity_(std::min(buffer_size, MAX_BUFFER_SIZE)) {
+namespace {
+
+// Entry layout: u64 commit word (the entry's position + 1 once written),
+// u32 line size, u32 kind, the line, padding to entry_alignment
+constexpr uint64_t entry_header_size = 16;
+constexpr uint64_t entry_alignment = 16;
+constexpr uint64_t min_lane_capacity = 4096;
+
+enum EntryKind : uint32_t { Line = 1, Padding = 2 };
+
+std::atomic_ref<uint64_t> commit_word(char* entry) {
+    return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(entry));
+}
+
+uint64_t entry_size(uint64_t payload) {
+    return (entry_header_size + payload + entry_alignment - 1) & ~(entry_alignment - 1);
+}
+
+void write_entry_header(char* entry, uint32_t size, EntryKind kind) {
+    const uint32_t kind_value = kind;
+    std::memcpy(entry + 8, &size, sizeof(size));
+    std::memcpy(entry + 12, &kind_value, sizeof(kind_value));
+}
+
+}
+
+SignalSafeSink::SignalSafeSink(const std::string& path, size_t buffer_size, size_t lanes)
+    : fd_(-1), lane_count_(std::max<size_t>(lanes, 1)) {
+    capacity_ = std::bit_ceil(std::max<uint64_t>(buffer_size / lane_count_, min_lane_capacity));
+    const size_t size = static_cast<size_t>(capacity_) * lane_count_;
+
+    // Pre-faulted whatever set_buffer_memory() says, so that writing never
+    // takes a page fault in a handler
+    buffer_ = BufferRegion(size, entry_alignment, true);
+    if (!buffer_.data()) {
+        return;
+    }
+    budget_.charge(size);
+    char* data = static_cast<char*>(buffer_.data());
+
+    lanes_ = std::make_unique<Lane[]>(lane_count_);
+    for (size_t i = 0; i < lane_count_; ++i) {
+        lanes_[i].data = data + i * capacity_;
+    }
     fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
 }
 
@@ -35,29 +79,83 @@ const char* SignalSafeSink::level_to_str(LogLevel level) {
 }
 
 void SignalSafeSink::log(const std::string& name, LogLevel level, const std::string& message) {
+    write_line(level, message.data(), message.size());
+}
+
+void SignalSafeSink::log_record(const FormattedRecord& record) {
+    write_line(record.level(), record.message().data(), record.message().size());
+}
+
+SignalSafeSink::Lane& SignalSafeSink::local_lane() {
+    if (lane_count_ == 1) {
+        return lanes_[0];
+    }
+    // pthread_self() is a TCB address; mix it so neighbouring threads
+    // spread over the lanes
+    const uint64_t id = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(reinterpret_cast<void*>(::pthread_self())));
+    return lanes_[((id * 0x9E3779B97F4A7C15ull) >> 32) % lane_count_];
+}
+
+void SignalSafeSink::write_line(LogLevel level, const char* message, size_t len) {
     if (fd_ < 0) {
         return;
     }
-    
 
     const char* level_str = level_to_str(level);
-    
+    const size_t level_len = safe_strlen(level_str);
+    const uint64_t payload = level_len + len + 1;
+    const uint64_t size = entry_size(payload);
+    if (size > capacity_) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
 
-    write_to_buffer(level_str, safe_strlen(level_str));
-    
+    Lane& lane = local_lane();
+    uint64_t pos;
+    if (!reserve(lane, size, pos)) {
+        // Full: write out what is committed and try once more
+        flush_lane(lane);
+        if (!reserve(lane, size, pos)) {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
 
-    write_to_buffer(message.c_str(), message.length());
-    
+    char* entry = lane.data + (pos & (capacity_ - 1));
+    write_entry_header(entry, static_cast<uint32_t>(payload), EntryKind::Line);
+    char* line = entry + entry_header_size;
+    safe_memcpy(line, level_str, level_len);
+    safe_memcpy(line + level_len, message, len);
+    line[level_len + len] = '\n';
+    commit_word(entry).store(pos + 1, std::memory_order_release);
 
-    write_to_buffer("\n", 1);
-    
+    if (lane.head.load(std::memory_order_relaxed) - lane.tail.load(std::memory_order_relaxed) > capacity_ / 2) {
+        flush_lane(lane);
+    }
+}
 
-    size_t write_pos = write_pos_.load(std::memory_order_relaxed);
-    size_t read_pos = read_pos_.load(std::memory_order_relaxed);
-    size_t current_size = write_pos - read_pos;
-    if (current_size > capacity_ / 2) {
-        flush_buffer();
+bool SignalSafeSink::reserve(Lane& lane, uint64_t size, uint64_t& pos) {
+    // The entry, and a padding entry to the end of the ring if it would wrap
+    pos = lane.head.load(std::memory_order_relaxed);
+    uint64_t pad;
+    for (;;) {
+        const uint64_t offset = pos & (capacity_ - 1);
+        pad = capacity_ - offset < size ? capacity_ - offset : 0;
+        if (pos + pad + size - lane.tail.load(std::memory_order_acquire) > capacity_) {
+            return false;
+        }
+        if (lane.head.compare_exchange_weak(pos, pos + pad + size, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (pad > 0) {
+        char* entry = lane.data + (pos & (capacity_ - 1));
+        write_entry_header(entry, static_cast<uint32_t>(pad - entry_header_size), EntryKind::Padding);
+        commit_word(entry).store(pos + 1, std::memory_order_release);
+        pos += pad;
     }
+    return true;
 }
 
 void SignalSafeSink::flush() {
@@ -68,89 +166,45 @@ void SignalSafeSink::flush() {
     }
 }
 
-void SignalSafeSink::write_to_buffer(const char* data, size_t len) {
-    if (len == 0) return;
-    
-    size_t write_pos, new_write_pos;
-    size_t read_pos;
-    
-    do {
-        write_pos = write_pos_.load(std::memory_order_relaxed);
-        read_pos = read_pos_.load(std::memory_order_acquire);
-        
-        size_t available = capacity_ - (write_pos - read_pos);
-        
-        if (len > available) {
-         
-            bool expected = false;
-            if (flush_in_progress_.compare_exchange_strong(expected, true, 
-                    std::memory_order_acquire, std::memory_order_relaxed)) {
-                flush_buffer();
-                flush_in_progress_.store(false, std::memory_order_release);
-            }
-            
-  
-            write_pos = write_pos_.load(std::memory_order_relaxed);
-            read_pos = read_pos_.load(std::memory_order_acquire);
-            available = capacity_ - (write_pos - read_pos);
-            
-            if (len > available) {
-        
-                dropped_count_.fetch_add(1, std::memory_order_relaxed);
-                return;
-            }
-        }
-        
-        new_write_pos = write_pos + len;
-        
-    } while (!write_pos_.compare_exchange_weak(write_pos, new_write_pos,
-                std::memory_order_release, std::memory_order_relaxed));
-    
-
-    for (size_t i = 0; i < len; ++i) {
-        size_t idx = (write_pos + i) % capacity_;
-        buffer_[idx] = data[i];
-    }
-}
-
 void SignalSafeSink::flush_buffer() {
     if (fd_ < 0) {
         return;
     }
-    
-
-    size_t write_pos = write_pos_.load(std::memory_order_acquire);
-    size_t read_pos = read_pos_.load(std::memory_order_relaxed);
-    
-    if (write_pos == read_pos) {
-        return; 
+    for (size_t i = 0; i < lane_count_; ++i) {
+        flush_lane(lanes_[i]);
     }
-    
-
-    while (read_pos < write_pos) {
-        size_t idx = read_pos % capacity_;
-        size_t bytes_to_write;
-        
+}
 
-        if (write_pos - read_pos <= capacity_ - idx) {
-   
-            bytes_to_write = write_pos - read_pos;
-        } else {
-      
-            bytes_to_write = capacity_ - idx;
+void SignalSafeSink::flush_lane(Lane& lane) {
+    // Entries are written out in order. Whoever swaps the commit word at
+    // the tail to 0 owns that entry until it advances the tail, so
+    // concurrent or nested flushes never write an entry twice; the others
+    // stop there.
+    for (;;) {
+        const uint64_t tail = lane.tail.load(std::memory_order_acquire);
+        if (tail == lane.head.load(std::memory_order_acquire)) {
+            return;
         }
-        
-
-        if (bytes_to_write > write_pos - read_pos) {
-            bytes_to_write = write_pos - read_pos;
+        char* entry = lane.data + (tail & (capacity_ - 1));
+        uint64_t committed = tail + 1;
+        if (!commit_word(entry).compare_exchange_strong(committed, 0, std::memory_order_acquire,
+                                                        std::memory_order_relaxed)) {
+            return;
+        }
+        uint32_t payload;
+        uint32_t kind;
+        std::memcpy(&payload, entry + 8, sizeof(payload));
+        std::memcpy(&kind, entry + 12, sizeof(kind));
+        const uint64_t size = entry_size(payload);
+        if (kind == EntryKind::Line) {
+            safe_write(fd_, entry + entry_header_size, payload);
         }
-        
-        safe_write(fd_, &buffer_[idx], bytes_to_write);
-        read_pos += bytes_to_write;
+        // Zeroed, so that stale bytes never read as a later commit word
+        for (uint64_t j = 8; j < size; ++j) {
+            entry[j] = 0;
+        }
+        lane.tail.store(tail + size, std::memory_order_release);
     }
-    
- 
-    read_pos_.store(read_pos, std::memory_order_release);
 }
 
 void SignalSafeSink::safe_write(int fd, const char* data, size_t len) {
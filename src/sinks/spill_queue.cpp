@@ -0,0 +1,350 @@
+#include "Zyrnix/sinks/spill_queue.hpp"
+#include "Zyrnix/binary_log.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr uint32_t record_magic = 0x3150535A;  // "ZSP1"
+constexpr size_t record_header_size = 16;
+
+size_t padded(size_t size) {
+    return (size + 7) & ~size_t{7};
+}
+
+void put_u32(char* p, uint32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+uint32_t get_u32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+}
+
+SpillQueue::SpillQueue(const SpillOptions& options) : options_(options) {
+    load();
+}
+
+SpillQueue::~SpillQueue() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    replayed_cv_.wait(lock, [this] { return !replaying_; });
+    if (writer_) {
+        std::fclose(writer_);
+    }
+    if (reader_) {
+        std::fclose(reader_);
+    }
+}
+
+std::string SpillQueue::segment_path(uint64_t generation) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llu.spill", static_cast<unsigned long long>(generation));
+    return (std::filesystem::path(options_.directory) / name).string();
+}
+
+void SpillQueue::load() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(options_.directory, ec);
+
+    std::vector<uint64_t> generations;
+    for (const auto& entry : fs::directory_iterator(options_.directory, ec)) {
+        const fs::path& path = entry.path();
+        if (path.extension() != ".spill") {
+            continue;
+        }
+        const std::string stem = path.stem().string();
+        if (!stem.empty() && std::all_of(stem.begin(), stem.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            generations.push_back(std::stoull(stem));
+        }
+    }
+    std::sort(generations.begin(), generations.end());
+
+    uint64_t cursor_generation = 0;
+    uint64_t cursor_offset = 0;
+    if (std::FILE* cursor = std::fopen((fs::path(options_.directory) / "cursor").string().c_str(), "rb")) {
+        char buf[16];
+        if (std::fread(buf, 1, sizeof(buf), cursor) == sizeof(buf)) {
+            std::memcpy(&cursor_generation, buf, 8);
+            std::memcpy(&cursor_offset, buf + 8, 8);
+        }
+        std::fclose(cursor);
+    }
+
+    for (uint64_t generation : generations) {
+        next_generation_ = generation + 1;
+        if (generation < cursor_generation) {
+            fs::remove(segment_path(generation), ec);  // Replayed before the last process stopped
+            continue;
+        }
+        Segment segment{generation, 0, 0};
+        const size_t from = generation == cursor_generation ? static_cast<size_t>(cursor_offset) : 0;
+        scan(segment, from);
+        if (segment.bytes <= from) {
+            fs::remove(segment_path(generation), ec);
+            continue;
+        }
+        if (segments_.empty()) {
+            read_offset_ = from;
+        }
+        total_bytes_ += segment.bytes;
+        segments_.push_back(segment);
+    }
+}
+
+void SpillQueue::scan(Segment& segment, size_t from) {
+    // Counts the valid records from an offset; a torn or damaged record ends the segment
+    std::FILE* file = std::fopen(segment_path(segment.generation).c_str(), "rb");
+    if (!file) {
+        return;
+    }
+    size_t offset = 0;
+    std::string body;
+    char header[record_header_size];
+    while (std::fread(header, 1, sizeof(header), file) == sizeof(header) && get_u32(header) == record_magic) {
+        const uint32_t size = get_u32(header + 4);
+        body.resize(padded(size));
+        if (std::fread(body.data(), 1, body.size(), file) != body.size() ||
+            binlog::crc32c(body.data(), size) != get_u32(header + 12)) {
+            break;
+        }
+        if (offset >= from) {
+            segment.events += get_u32(header + 8);
+        }
+        offset += record_header_size + body.size();
+    }
+    segment.bytes = offset;
+    std::fclose(file);
+}
+
+bool SpillQueue::push(std::string_view body, uint32_t events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!writer_ || segments_.back().bytes >= options_.segment_bytes) {
+        if (writer_) {
+            std::fclose(writer_);
+        }
+        const uint64_t generation = next_generation_++;
+        writer_ = std::fopen(segment_path(generation).c_str(), "wb");
+        if (writer_) {
+            if (segments_.empty()) {
+                read_offset_ = 0;
+            }
+            segments_.push_back(Segment{generation, 0, 0});
+        }
+    }
+    if (!writer_) {
+        dropped_ += events;
+        return false;
+    }
+
+    char header[record_header_size];
+    put_u32(header, record_magic);
+    put_u32(header + 4, static_cast<uint32_t>(body.size()));
+    put_u32(header + 8, events);
+    put_u32(header + 12, binlog::crc32c(body.data(), body.size()));
+    static constexpr char padding[8] = {};
+    const size_t pad = padded(body.size()) - body.size();
+    if (std::fwrite(header, 1, sizeof(header), writer_) != sizeof(header) ||
+        std::fwrite(body.data(), 1, body.size(), writer_) != body.size() ||
+        std::fwrite(padding, 1, pad, writer_) != pad || std::fflush(writer_) != 0) {
+        // The segment ends at its last whole record; the next push starts another
+        std::fclose(writer_);
+        writer_ = nullptr;
+        dropped_ += events;
+        return false;
+    }
+
+    const size_t size = record_header_size + body.size() + pad;
+    segments_.back().bytes += size;
+    segments_.back().events += events;
+    total_bytes_ += size;
+    spilled_ += events;
+
+    // Never the segment being written, nor the one a replay is reading
+    const size_t keep_front = replaying_ ? 1 : 0;
+    while (total_bytes_ > options_.max_bytes && segments_.size() > keep_front + 1) {
+        drop_segment(keep_front);
+    }
+    return true;
+}
+
+void SpillQueue::mark_down() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    down_ = true;
+}
+
+bool SpillQueue::has_records() const {
+    return !segments_.empty() && (segments_.size() > 1 || read_offset_ < segments_.front().bytes);
+}
+
+bool SpillQueue::diverting() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return down_ && has_records();
+}
+
+bool SpillQueue::read_front(std::string& body, uint32_t& events, size_t& size) {
+    while (!segments_.empty()) {
+        Segment& front = segments_.front();
+        if (read_offset_ >= front.bytes) {
+            if (segments_.size() == 1 && writer_) {
+                return false;  // Caught up with the writer
+            }
+            drop_segment(0);
+            continue;
+        }
+
+        if (!reader_ || reader_generation_ != front.generation) {
+            if (reader_) {
+                std::fclose(reader_);
+            }
+            reader_ = std::fopen(segment_path(front.generation).c_str(), "rb");
+            reader_generation_ = front.generation;
+        }
+        char header[record_header_size];
+        if (reader_ && std::fseek(reader_, static_cast<long>(read_offset_), SEEK_SET) == 0 &&
+            std::fread(header, 1, sizeof(header), reader_) == sizeof(header) && get_u32(header) == record_magic) {
+            const uint32_t length = get_u32(header + 4);
+            body.resize(length);
+            if (std::fread(body.data(), 1, length, reader_) == length &&
+                binlog::crc32c(body.data(), length) == get_u32(header + 12)) {
+                events = get_u32(header + 8);
+                size = record_header_size + padded(length);
+                return true;
+            }
+        }
+        // Unreadable from here on: what is left of the segment is lost
+        dropped_ += front.events;
+        front.events = 0;
+        total_bytes_ -= front.bytes - read_offset_;
+        front.bytes = read_offset_;
+        if (segments_.size() == 1 && writer_) {
+            std::fclose(writer_);
+            writer_ = nullptr;
+        }
+    }
+    return false;
+}
+
+void SpillQueue::pop_front(size_t size, uint32_t events) {
+    Segment& front = segments_.front();
+    read_offset_ += size;
+    front.events -= std::min<uint64_t>(front.events, events);
+    if (read_offset_ >= front.bytes && !(segments_.size() == 1 && writer_)) {
+        drop_segment(0);
+    } else {
+        write_cursor();
+    }
+}
+
+void SpillQueue::drop_segment(size_t index) {
+    const Segment segment = segments_[index];
+    if (reader_ && reader_generation_ == segment.generation) {
+        std::fclose(reader_);
+        reader_ = nullptr;
+    }
+    if (writer_ && index + 1 == segments_.size()) {
+        std::fclose(writer_);
+        writer_ = nullptr;
+    }
+    std::error_code ec;
+    std::filesystem::remove(segment_path(segment.generation), ec);
+    total_bytes_ -= segment.bytes;
+    dropped_ += segment.events;
+    segments_.erase(segments_.begin() + static_cast<std::ptrdiff_t>(index));
+    if (index == 0) {
+        read_offset_ = 0;
+        write_cursor();
+    }
+}
+
+void SpillQueue::write_cursor() {
+    // Written in place, so a crash before the next replay at worst sends one record twice
+    char buf[16];
+    const uint64_t generation = segments_.empty() ? next_generation_ : segments_.front().generation;
+    const uint64_t offset = read_offset_;
+    std::memcpy(buf, &generation, 8);
+    std::memcpy(buf + 8, &offset, 8);
+    const std::string path = (std::filesystem::path(options_.directory) / "cursor").string();
+    if (std::FILE* cursor = std::fopen(path.c_str(), "wb")) {
+        std::fwrite(buf, 1, sizeof(buf), cursor);
+        std::fclose(cursor);
+    }
+}
+
+std::chrono::steady_clock::time_point SpillQueue::replay(HttpTransport& transport, const HttpRequest& base,
+                                                         Completion done) {
+    constexpr auto idle = std::chrono::steady_clock::time_point::max();
+    HttpRequest request;
+    size_t size = 0;
+    uint32_t events = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (replaying_ || !has_records()) {
+            return idle;  // The completion wakes the transport
+        }
+        if (std::chrono::steady_clock::now() < next_replay_) {
+            return next_replay_;
+        }
+        std::string body;
+        if (!read_front(body, events, size)) {
+            return idle;
+        }
+        replaying_ = true;
+        request = base;
+        request.body = std::move(body);
+        request.max_attempts = 1;  // Retried at retry_interval instead
+    }
+    transport.submit(std::move(request),
+                     [this, size, events, done = std::move(done)](const HttpResponse& response, int, HttpRequest&) {
+                         finish_replay(response, size, events, done);
+                     });
+    return idle;
+}
+
+void SpillQueue::finish_replay(const HttpResponse& response, size_t size, uint32_t events, const Completion& done) {
+    const int status = response.status_code;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = std::chrono::steady_clock::now();
+        if (!response.success || status == 429 || status >= 500) {
+            down_ = true;
+            next_replay_ = now + options_.retry_interval;
+        } else {
+            pop_front(size, events);
+            if (status >= 200 && status < 300) {
+                replayed_ += events;
+                down_ = false;
+            } else {
+                dropped_ += events;  // Rejected; sending it again will not help
+            }
+            next_replay_ = now;
+            if (options_.replay_bytes_per_second > 0) {
+                next_replay_ += std::chrono::microseconds(size * 1000000 / options_.replay_bytes_per_second);
+            }
+        }
+    }
+    // Still replaying_ while the sink hears of it, so it cannot be destroyed meanwhile
+    if (done) {
+        done(response, events);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replaying_ = false;
+        replayed_cv_.notify_all();
+    }
+    HttpTransport::instance().wake();
+}
+
+SpillQueue::Stats SpillQueue::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{spilled_, replayed_, dropped_, total_bytes_ - read_offset_};
+}
+
+}
@@ -1,21 +1,110 @@
 #include "Zyrnix/sinks/stdout_sink.hpp"
 #include "Zyrnix/formatter.hpp"
-#include "Zyrnix/color.hpp"
 #include "Zyrnix/log_level.hpp"
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace Zyrnix {
 
-StdoutSink::StdoutSink() {}
+namespace {
+
+// By LogLevel: warnings yellow, errors and critical red
+constexpr std::string_view color_prefix[] = {"", "", "", "\033[33m", "\033[31m", "\033[31m"};
+constexpr std::string_view color_reset = "\033[0m";
+
+long write_fd(int fd, const char* data, size_t size) {
+#ifdef _WIN32
+    return ::_write(fd, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+    return static_cast<long>(::write(fd, data, size));
+#endif
+}
+
+bool is_terminal(int fd) {
+#ifdef _WIN32
+    return ::_isatty(fd) != 0;
+#else
+    return ::isatty(fd) != 0;
+#endif
+}
+
+bool use_color(int fd, ColorMode mode) {
+#ifdef XLOG_NO_COLORS
+    (void)fd;
+    (void)mode;
+    return false;
+#else
+    if (mode != ColorMode::Auto) {
+        return mode == ColorMode::Always;
+    }
+    if (std::getenv("NO_COLOR") != nullptr) {
+        return false;
+    }
+    const char* term = std::getenv("TERM");
+    if (term != nullptr && std::strcmp(term, "dumb") == 0) {
+        return false;
+    }
+    return is_terminal(fd);
+#endif
+}
+
+}
+
+void StdoutSink::Fd::write(const char* data, std::streamsize size) {
+    while (size > 0) {
+        const long written = write_fd(fd, data, static_cast<size_t>(size));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;  // Closed or a broken pipe: nowhere left to report it
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+StdoutSink::StdoutSink(const FlushPolicy& policy) : StdoutSink(ConsoleStream::Stdout, ColorMode::Auto, policy) {}
+
+StdoutSink::StdoutSink(ConsoleStream stream, ColorMode color, const FlushPolicy& policy)
+    : out_{stream == ConsoleStream::Stderr ? 2 : 1}, colored_(use_color(out_.fd, color)), buffer(policy) {
+    BackgroundFlusher::instance().add(this, policy.interval);
+}
+
+StdoutSink::~StdoutSink() {
+    BackgroundFlusher::instance().remove(this);
+    std::lock_guard<std::mutex> lock(mtx);
+    buffer.write_out(out_);
+}
 
 void StdoutSink::log(const std::string& name, LogLevel level, const std::string& msg) {
-    std::string out = formatter.format(name, level, msg);
-    if (level == LogLevel::Error || level == LogLevel::Critical)
-        out = apply_color(out, Color::Red);
-    else if (level == LogLevel::Warn)
-        out = apply_color(out, Color::Yellow);
+    log_as_record(name, level, msg);
+}
+
+void StdoutSink::log_record(const FormattedRecord& record) {
+    write_line(record.level(), record.formatted(formatter));
+}
+
+void StdoutSink::write_line(LogLevel level, std::string_view line) {
+    std::lock_guard<std::mutex> lock(mtx);
+    const std::string_view prefix = colored_ ? color_prefix[std::clamp(static_cast<int>(level), 0, 5)] : "";
+    if (prefix.empty()) {
+        buffer.append(out_, line, level);
+    } else {
+        buffer.append_wrapped(out_, prefix, line, color_reset, level);
+    }
+}
 
-    std::cout << out << std::endl;
+void StdoutSink::flush() {
+    std::lock_guard<std::mutex> lock(mtx);
+    buffer.write_out(out_);
 }
 
 }
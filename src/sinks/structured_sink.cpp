@@ -0,0 +1,147 @@
+#include "Zyrnix/sinks/structured_sink.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/log_context.hpp"
+#include "Zyrnix/stack_trace.hpp"
+#include <chrono>
+
+namespace Zyrnix {
+
+StructuredSink::StructuredSink(const std::string& fname, std::unique_ptr<StructuredEncoder> enc,
+                               const FlushPolicy& policy)
+    : filename(fname), encoder(std::move(enc)), buffer(policy) {
+    file.rdbuf()->pubsetbuf(nullptr, 0);
+    file.open(filename, encoder->text() ? std::ios::app : std::ios::app | std::ios::binary);
+    BackgroundFlusher::instance().add(this, policy.interval);
+}
+
+StructuredSink::StructuredSink(const std::string& fname, StructuredFormat format, const FlushPolicy& policy)
+    : StructuredSink(fname, make_encoder(format), policy) {}
+
+StructuredSink::~StructuredSink() {
+    BackgroundFlusher::instance().remove(this);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (file.is_open()) {
+        buffer.write_out(file);
+        file.close();
+    }
+}
+
+namespace {
+
+bool shares_key(const LogContext::ContextMap& context, const FieldList& fields) {
+    for (const auto& [key, value] : context) {
+        if (fields.contains(key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+template <class EmitFields>
+void StructuredSink::write(const StructuredHeader& header, const FieldList* record_fields, size_t field_count,
+                           EmitFields&& emit_fields) {
+    line.clear();
+    const LogContext::ContextMap& context = LogContext::current();
+    // A record the logger captured context into holds some of it already
+    const bool shared = !context.empty() && record_fields && !record_fields->empty() &&
+                        shares_key(context, *record_fields);
+    size_t context_count = context.size();
+    if (shared) {
+        for (const auto& [key, value] : context) {
+            context_count -= record_fields->contains(key);
+        }
+    }
+
+    encoder->begin(line, header, global_context.size() + context_count + field_count);
+    line.append(global_encoded);
+    if (!shared) {
+        encoder->thread_context(line);
+    } else {
+        for (const auto& [key, value] : context) {
+            if (!record_fields->contains(key)) {
+                encoder->member(line, key, FieldType::String, value);
+            }
+        }
+    }
+    emit_fields();
+    encoder->end(line, 0);
+    buffer.append_record(file, line, header.level);
+}
+
+void StructuredSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    static const std::map<std::string, std::string> no_fields;
+    log_with_fields(logger_name, level, message, no_fields);
+}
+
+void StructuredSink::log_record(const FormattedRecord& record) {
+    if (record.level() < get_level()) return;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!file.is_open()) return;
+    const StructuredHeader header{record.timestamp(), record.level(), record.logger_name(), record.message(),
+                                  &record.trace()};
+    const auto& fields = record.fields();
+    const StackTrace* stack = record.stack();
+    write(header, &fields, fields.size() + (stack ? 1 : 0), [&] {
+        encoder->record_fields(line, record);
+        if (stack) {
+            encoder->stack_trace(line, stack->text());
+        }
+    });
+}
+
+void StructuredSink::log_with_fields(const std::string& logger_name, LogLevel level, const std::string& message,
+                                     const std::map<std::string, std::string>& fields) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!file.is_open()) return;
+    const StructuredHeader header{LogClock::now(), level, logger_name, message,
+                                  &TraceContext::current()};
+    write(header, nullptr, fields.size(), [&] {
+        for (const auto& [key, value] : fields) {
+            encoder->member(line, key, FieldType::String, value);
+        }
+    });
+}
+
+void StructuredSink::log_fields(std::string_view logger_name, LogLevel level, std::string_view message,
+                                std::span<const Field> fields) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!file.is_open()) return;
+    const StructuredHeader header{LogClock::now(), level, logger_name, message,
+                                  &TraceContext::current()};
+    write(header, nullptr, fields.size(), [&] {
+        for (const auto& field : fields) {
+            encoder->member(line, field.key, field.value);
+        }
+    });
+}
+
+void StructuredSink::rebuild_global() {
+    global_encoded.clear();
+    for (const auto& [key, value] : global_context) {
+        encoder->member(global_encoded, key, FieldType::String, value);
+    }
+}
+
+void StructuredSink::set_context(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mtx);
+    global_context[key] = value;
+    rebuild_global();
+}
+
+void StructuredSink::clear_context() {
+    std::lock_guard<std::mutex> lock(mtx);
+    global_context.clear();
+    global_encoded.clear();
+}
+
+void StructuredSink::flush() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (file.is_open()) {
+        buffer.write_out(file);
+    }
+}
+
+}
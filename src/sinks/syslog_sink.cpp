@@ -25,10 +25,23 @@ int SyslogSink::map_level(LogLevel lvl) {
 }
 
 void SyslogSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    write(logger_name, level, message);
+}
+
+void SyslogSink::log_record(const FormattedRecord& record) {
+    write(record.logger_name(), record.level(), record.message());
+}
+
+// Precision-limited %s lets syslog() read the views directly
+void SyslogSink::write(std::string_view logger_name, LogLevel level, std::string_view message) {
     std::lock_guard<std::mutex> lock(mtx);
     int prio = map_level(level);
-    std::string out = logger_name.empty() ? message : (logger_name + ": " + message);
-    syslog(prio, "%s", out.c_str());
+    if (logger_name.empty()) {
+        syslog(prio, "%.*s", static_cast<int>(message.size()), message.data());
+    } else {
+        syslog(prio, "%.*s: %.*s", static_cast<int>(logger_name.size()), logger_name.data(),
+               static_cast<int>(message.size()), message.data());
+    }
 }
 
 }
@@ -0,0 +1,582 @@
+#include "Zyrnix/sinks/tcp_sink.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/thread_placement.hpp"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#ifdef XLOG_HAS_OPENSSL
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t max_iov = 512;
+constexpr size_t tls_chunk = 64 * 1024;
+
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;  // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+// poll() one descriptor until deadline (max() waits for ever); > 0 when ready
+int wait_fd(int fd, short events, Clock::time_point deadline) {
+    for (;;) {
+        int timeout_ms = -1;
+        if (deadline != Clock::time_point::max()) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout_ms = static_cast<int>(std::clamp<int64_t>(left.count(), 0, 60000));
+        }
+        pollfd pfd{fd, events, 0};
+        const int ready = ::poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        return ready;
+    }
+}
+
+void set_nonblocking(int fd) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, ::fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+#ifdef XLOG_HAS_OPENSSL
+std::string tls_error() {
+    char buf[256] = "unknown error";
+    if (const unsigned long code = ERR_get_error()) {
+        ERR_error_string_n(code, buf, sizeof(buf));
+    }
+    ERR_clear_error();
+    return buf;
+}
+#endif
+
+}
+
+struct TcpSink::Connection {
+    int fd = -1;
+    short want = POLLOUT;  // What a blocked send is waiting for
+    std::string error;
+#ifdef XLOG_HAS_OPENSSL
+    SSL_CTX* ctx = nullptr;  // Kept across reconnects
+    SSL* ssl = nullptr;
+#endif
+
+    Connection() = default;
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    ~Connection() {
+        close();
+#ifdef XLOG_HAS_OPENSSL
+        SSL_CTX_free(ctx);
+#endif
+    }
+
+    void close() {
+#ifdef XLOG_HAS_OPENSSL
+        SSL_free(ssl);
+        ssl = nullptr;
+#endif
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+#ifdef XLOG_HAS_OPENSSL
+    bool handshake(const TcpOptions& options, const std::string& host, Clock::time_point deadline) {
+        if (!ctx) {
+            ctx = SSL_CTX_new(TLS_client_method());
+            if (!ctx) {
+                error = tls_error();
+                return false;
+            }
+            SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+            if (!options.insecure_skip_verify) {
+                const int loaded = options.ca_cert_path.empty()
+                                       ? SSL_CTX_set_default_verify_paths(ctx)
+                                       : SSL_CTX_load_verify_locations(ctx, options.ca_cert_path.c_str(), nullptr);
+                if (loaded != 1) {
+                    error = "cannot load CA certificates: " + tls_error();
+                    SSL_CTX_free(ctx);
+                    ctx = nullptr;
+                    return false;
+                }
+                SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+            }
+        }
+
+        ssl = SSL_new(ctx);
+        if (!ssl) {
+            error = tls_error();
+            return false;
+        }
+        SSL_set_fd(ssl, fd);
+        SSL_set_mode(ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        const std::string& name = options.tls_server_name.empty() ? host : options.tls_server_name;
+        in6_addr address;
+        const bool is_ip = inet_pton(AF_INET, name.c_str(), &address) == 1 ||
+                           inet_pton(AF_INET6, name.c_str(), &address) == 1;
+        if (!is_ip) {
+            SSL_set_tlsext_host_name(ssl, name.c_str());  // SNI carries host names only
+        }
+        if (!options.insecure_skip_verify) {
+            if (is_ip) {
+                X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), name.c_str());
+            } else {
+                SSL_set1_host(ssl, name.c_str());
+            }
+        }
+
+        for (;;) {
+            const int result = SSL_connect(ssl);
+            if (result == 1) {
+                return true;
+            }
+            const int reason = SSL_get_error(ssl, result);
+            const short events = reason == SSL_ERROR_WANT_READ    ? POLLIN
+                                 : reason == SSL_ERROR_WANT_WRITE ? POLLOUT
+                                                                  : 0;
+            if (!events) {
+                const long verified = SSL_get_verify_result(ssl);
+                error = verified != X509_V_OK ? std::string("certificate rejected: ") +
+                                                    X509_verify_cert_error_string(verified)
+                                              : "TLS handshake failed: " + tls_error();
+                return false;
+            }
+            if (wait_fd(fd, events, deadline) <= 0) {
+                error = "TLS handshake timed out";
+                return false;
+            }
+        }
+    }
+#endif
+};
+
+TcpSink::TcpSink(const std::string& host, unsigned short port, const TcpOptions& options)
+    : host_(host), port_(port), options_(options) {
+    if (::pipe(wake_pipe_) != 0) {
+        std::cerr << "TcpSink: cannot create wake pipe: " << std::strerror(errno) << std::endl;
+        wake_pipe_[0] = wake_pipe_[1] = -1;
+        return;
+    }
+    set_nonblocking(wake_pipe_[0]);
+    set_nonblocking(wake_pipe_[1]);
+    thread_ = std::thread(&TcpSink::run, this);
+}
+
+TcpSink::~TcpSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    space_cv_.notify_all();
+    flushed_cv_.notify_all();
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    for (int fd : wake_pipe_) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+void TcpSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
+    log_as_record(logger_name, level, message);
+}
+
+void TcpSink::log_record(const FormattedRecord& record) {
+    enqueue(record.formatted(formatter));
+}
+
+void TcpSink::enqueue(const std::string& line) {
+    std::string framed;
+    if (options_.framing == TcpFraming::OctetCounting) {
+        framed.reserve(line.size() + 12);
+        framed = std::to_string(line.size());
+        framed += ' ';
+        framed += line;
+    } else {
+        framed.reserve(line.size() + 1);
+        framed = line;
+        framed += '\n';
+    }
+    const size_t size = framed.size();
+    const size_t limit = options_.max_buffer_bytes;
+
+    bool was_idle;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (buffered_bytes_ + size > limit) {
+            if (size > limit) {
+                ++records_dropped_;  // Could never fit
+                return;
+            }
+            switch (options_.drop_policy) {
+            case TcpDropPolicy::DropNewest:
+                ++records_dropped_;
+                return;
+            case TcpDropPolicy::DropOldest:
+                while (!pending_.empty() && buffered_bytes_ + size > limit) {
+                    buffered_bytes_ -= pending_.front().size();
+                    pending_.pop_front();
+                    ++records_dropped_;
+                }
+                if (buffered_bytes_ + size > limit) {
+                    ++records_dropped_;  // The rest is already being sent
+                    return;
+                }
+                break;
+            case TcpDropPolicy::Block:
+                space_cv_.wait(lock, [&] { return buffered_bytes_ + size <= limit || closing_; });
+                if (closing_) {
+                    ++records_dropped_;
+                    return;
+                }
+                break;
+            }
+        }
+        // The I/O thread only needs waking when it may have run out of work
+        was_idle = pending_.empty();
+        buffered_bytes_ += size;
+        pending_.push_back(std::move(framed));
+    }
+    if (was_idle) {
+        wake();
+    }
+}
+
+void TcpSink::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_cv_.wait(lock, [this] { return buffered_bytes_ == 0 || backing_off_ || closing_ || !thread_.joinable(); });
+}
+
+TcpSink::Stats TcpSink::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{records_sent_, records_dropped_, bytes_sent_, connects_, buffered_bytes_, connected_};
+}
+
+void TcpSink::wake() {
+    if (wake_pipe_[1] >= 0) {
+        const char byte = 0;
+        const ssize_t written = ::write(wake_pipe_[1], &byte, 1);
+        (void)written;  // A full pipe has a wake-up pending already
+    }
+}
+
+void TcpSink::run() {
+    init_background_thread("xlog-tcp");
+    const auto reconnect_min = std::max(options_.reconnect_min, std::chrono::milliseconds(1));
+    const auto reconnect_max = std::max(options_.reconnect_max, reconnect_min);
+    auto delay = reconnect_min;
+    auto retry_at = Clock::now();
+    auto drain_deadline = Clock::time_point::max();
+    bool reported = false;  // One message per outage, not per attempt
+    Connection connection;
+
+    auto back_off = [&] {
+        retry_at = Clock::now() + delay;
+        delay = std::min(delay * 2, reconnect_max);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            backing_off_ = true;
+            connected_ = false;
+        }
+        flushed_cv_.notify_all();
+    };
+
+    // Waits for the wake pipe or, when fd >= 0, fd becoming ready for events
+    auto wait = [&](int fd, short events, Clock::time_point deadline) -> short {
+        pollfd fds[2] = {{wake_pipe_[0], POLLIN, 0}, {fd, events, 0}};
+        int timeout_ms = -1;
+        if (deadline != Clock::time_point::max()) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout_ms = static_cast<int>(std::clamp<int64_t>(left.count(), 0, 60000));
+        }
+        if (::poll(fds, fd >= 0 ? 2 : 1, timeout_ms) <= 0) {
+            return 0;
+        }
+        if (fds[0].revents) {
+            char buf[64];
+            while (::read(wake_pipe_[0], buf, sizeof(buf)) > 0) {
+            }
+        }
+        return fd >= 0 ? fds[1].revents : 0;
+    };
+
+    for (;;) {
+        bool closing;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing = closing_;
+            if (sending_.empty()) {
+                sending_.swap(pending_);
+            }
+        }
+        const auto now = Clock::now();
+        if (closing) {
+            if (drain_deadline == Clock::time_point::max()) {
+                drain_deadline = now + options_.connect_timeout;
+            }
+            // A collector that is down when the sink closes is not waited for
+            if (sending_.empty() || now >= drain_deadline || (connection.fd < 0 && now < retry_at)) {
+                break;
+            }
+        }
+
+        if (connection.fd < 0) {
+            if (now < retry_at) {
+                wait(-1, 0, retry_at);
+                continue;
+            }
+            if (connect_once(connection)) {
+                delay = reconnect_min;
+                reported = false;
+                std::lock_guard<std::mutex> lock(mutex_);
+                backing_off_ = false;
+                connected_ = true;
+                ++connects_;
+            } else {
+                if (!reported) {
+                    std::cerr << "TcpSink: cannot connect to " << host_ << ":" << port_ << ": " << connection.error
+                              << std::endl;
+                    reported = true;
+                }
+                connection.close();
+                back_off();
+            }
+            continue;
+        }
+
+        if (sending_.empty()) {
+            // Collectors do not answer, so a readable socket means it was closed
+            const short events = wait(connection.fd, POLLIN, Clock::time_point::max());
+            if (events) {
+                char buf[256];
+                bool closed;
+#ifdef XLOG_HAS_OPENSSL
+                if (connection.ssl) {
+                    const int result = SSL_read(connection.ssl, buf, sizeof(buf));
+                    closed = result <= 0 && SSL_get_error(connection.ssl, result) != SSL_ERROR_WANT_READ;
+                } else
+#endif
+                {
+                    const ssize_t result = ::recv(connection.fd, buf, sizeof(buf), 0);
+                    closed = result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+                }
+                if (closed) {
+                    disconnect(connection);
+                    back_off();
+                }
+            }
+            continue;
+        }
+
+        switch (send_some(connection)) {
+        case Progress::Sent:
+            break;
+        case Progress::Blocked:
+            wait(connection.fd, connection.want, closing ? drain_deadline : Clock::time_point::max());
+            break;
+        case Progress::Failed:
+            std::cerr << "TcpSink: connection to " << host_ << ":" << port_ << " lost: " << connection.error
+                      << std::endl;
+            reported = true;
+            disconnect(connection);
+            back_off();
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records_dropped_ += sending_.size() + pending_.size();
+        pending_.clear();
+        buffered_bytes_ = 0;
+        connected_ = false;
+    }
+    sending_.clear();
+    flushed_cv_.notify_all();
+}
+
+bool TcpSink::connect_once(Connection& connection) {
+    const auto deadline = Clock::now() + options_.connect_timeout;
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    const std::string port = std::to_string(port_);
+    if (const int rc = getaddrinfo(host_.c_str(), port.c_str(), &hints, &res); rc != 0) {
+        connection.error = gai_strerror(rc);
+        return false;
+    }
+
+    for (addrinfo* p = res; p != nullptr && connection.fd < 0; p = p->ai_next) {
+        const int fd = ::socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if (fd < 0) {
+            connection.error = std::strerror(errno);
+            continue;
+        }
+        set_nonblocking(fd);
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Records are batched here already
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        int err = 0;
+        if (::connect(fd, p->ai_addr, p->ai_addrlen) != 0) {
+            err = errno;
+            if (err == EINPROGRESS) {
+                const int ready = wait_fd(fd, POLLOUT, deadline);
+                socklen_t len = sizeof(err);
+                if (ready > 0) {
+                    getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                } else {
+                    err = ready == 0 ? ETIMEDOUT : errno;
+                }
+            }
+        }
+        if (err == 0) {
+            connection.fd = fd;
+        } else {
+            connection.error = std::strerror(err);
+            ::close(fd);
+        }
+    }
+    freeaddrinfo(res);
+    if (connection.fd < 0 || !options_.tls) {
+        return connection.fd >= 0;
+    }
+
+#ifdef XLOG_HAS_OPENSSL
+    return connection.handshake(options_, host_, deadline);
+#else
+    connection.error = "TLS requested, but Zyrnix was built without OpenSSL";
+    return false;
+#endif
+}
+
+TcpSink::Progress TcpSink::send_some(Connection& connection) {
+#ifdef XLOG_HAS_OPENSSL
+    if (connection.ssl) {
+        if (tls_buffer_.empty()) {
+            // front_offset_ is 0 here: chunks end on record boundaries
+            for (const std::string& record : sending_) {
+                if (!tls_buffer_.empty() && tls_buffer_.size() + record.size() > tls_chunk) {
+                    break;
+                }
+                tls_buffer_ += record;
+            }
+            tls_written_ = 0;
+        }
+        const int written = SSL_write(connection.ssl, tls_buffer_.data() + tls_written_,
+                                      static_cast<int>(tls_buffer_.size() - tls_written_));
+        if (written > 0) {
+            tls_written_ += static_cast<size_t>(written);
+            if (tls_written_ == tls_buffer_.size()) {
+                tls_buffer_.clear();
+                tls_written_ = 0;
+            }
+            consume(static_cast<size_t>(written));
+            return Progress::Sent;
+        }
+        const int reason = SSL_get_error(connection.ssl, written);
+        if (reason == SSL_ERROR_WANT_WRITE || reason == SSL_ERROR_WANT_READ) {
+            connection.want = reason == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT;
+            return Progress::Blocked;
+        }
+        connection.error = reason == SSL_ERROR_SYSCALL && errno ? std::strerror(errno) : tls_error();
+        return Progress::Failed;
+    }
+#endif
+
+    iovec iov[max_iov];
+    size_t count = 0;
+    for (auto it = sending_.begin(); it != sending_.end() && count < max_iov; ++it, ++count) {
+        const size_t skip = count == 0 ? front_offset_ : 0;
+        iov[count] = {const_cast<char*>(it->data() + skip), it->size() - skip};
+    }
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    const ssize_t sent = ::sendmsg(connection.fd, &msg, send_flags);
+    if (sent >= 0) {
+        consume(static_cast<size_t>(sent));
+        return Progress::Sent;
+    }
+    if (errno == EINTR) {
+        return Progress::Sent;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        connection.want = POLLOUT;
+        return Progress::Blocked;
+    }
+    connection.error = std::strerror(errno);
+    return Progress::Failed;
+}
+
+void TcpSink::consume(size_t bytes) {
+    uint64_t records = 0;
+    for (size_t left = bytes; left > 0;) {
+        const size_t rest = sending_.front().size() - front_offset_;
+        if (left < rest) {
+            front_offset_ += left;
+            break;
+        }
+        left -= rest;
+        front_offset_ = 0;
+        sending_.pop_front();
+        ++records;
+    }
+
+    bool empty;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffered_bytes_ -= bytes;
+        bytes_sent_ += bytes;
+        records_sent_ += records;
+        empty = buffered_bytes_ == 0;
+    }
+    space_cv_.notify_all();
+    if (empty) {
+        flushed_cv_.notify_all();
+    }
+}
+
+void TcpSink::disconnect(Connection& connection) {
+    connection.close();
+    tls_buffer_.clear();
+    tls_written_ = 0;
+    // The record cut off goes again, whole, on the next connection
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffered_bytes_ += front_offset_;
+    front_offset_ = 0;
+    connected_ = false;
+}
+
+}
@@ -1,15 +1,30 @@
 #include "Zyrnix/sinks/udp_sink.hpp"
+#include "Zyrnix/sinks/flush_policy.hpp"
+#include "Zyrnix/formatted_record.hpp"
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <string>
 #include <iostream>
 
 namespace Zyrnix {
 
-UdpSink::UdpSink(const std::string& host, unsigned short port) : sockfd(-1), dest_len(0), initialized(false) {
+namespace {
+
+constexpr size_t max_udp_payload = 65507;
+
+}
+
+UdpSink::UdpSink(const std::string& host, unsigned short port, const UdpOptions& opts)
+    : sockfd(-1), dest_len(0), initialized(false), options(opts) {
+    options.batch_size = std::max<size_t>(options.batch_size, 1);
+    options.max_datagram = std::clamp<size_t>(options.max_datagram, 1, max_udp_payload);
+
     struct addrinfo hints;
     struct addrinfo* res = nullptr;
     memset(&hints, 0, sizeof(hints));
@@ -27,25 +42,155 @@ UdpSink::UdpSink(const std::string& host, unsigned short port) : sockfd(-1), des
 
         memcpy(&dest, p->ai_addr, p->ai_addrlen);
         dest_len = (socklen_t)p->ai_addrlen;
+        // Sends then skip the per-datagram address and route lookup; a
+        // socket that cannot connect still sends to dest
+        connected = ::connect(sockfd, p->ai_addr, p->ai_addrlen) == 0;
         initialized = true;
         break;
     }
 
     freeaddrinfo(res);
+
+    if (batching()) {
+        datagrams.reserve(options.batch_size);
+        BackgroundFlusher::instance().add(this, options.flush_interval);
+    }
 }
 
 UdpSink::~UdpSink() {
+    if (batching()) {
+        BackgroundFlusher::instance().remove(this);
+        std::lock_guard<std::mutex> lock(mtx);
+        send_buffered();
+    }
     if (sockfd != -1) close(sockfd);
 }
 
 void UdpSink::log(const std::string& logger_name, LogLevel level, const std::string& message) {
-    if (!initialized) return;
+    if (batching()) {
+        buffer_line(logger_name, level, message);
+    } else {
+        send(logger_name, message);
+    }
+}
+
+void UdpSink::log_record(const FormattedRecord& record) {
+    if (batching()) {
+        buffer_line(record.logger_name(), record.level(), record.message());
+    } else {
+        send(record.logger_name(), record.message());
+    }
+}
+
+void UdpSink::flush() {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string out = logger_name.empty() ? message : (logger_name + ": " + message);
+    send_buffered();
+}
 
-    out.push_back('\n');
-    ssize_t sent = sendto(sockfd, out.data(), out.size(), 0, (struct sockaddr*)&dest, dest_len);
+// Gathers "name: message\n" straight from the caller's buffers into one
+// datagram instead of concatenating it into a string first
+void UdpSink::send(std::string_view logger_name, std::string_view message) {
+    if (!initialized) return;
+    static const char separator[] = ": ";
+    static const char newline[] = "\n";
+    struct iovec parts[4];
+    int count = 0;
+    if (!logger_name.empty()) {
+        parts[count++] = {const_cast<char*>(logger_name.data()), logger_name.size()};
+        parts[count++] = {const_cast<char*>(separator), 2};
+    }
+    parts[count++] = {const_cast<char*>(message.data()), message.size()};
+    parts[count++] = {const_cast<char*>(newline), 1};
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    if (!connected) {
+        msg.msg_name = &dest;
+        msg.msg_namelen = dest_len;
+    }
+    msg.msg_iov = parts;
+    msg.msg_iovlen = static_cast<size_t>(count);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    ssize_t sent = sendmsg(sockfd, &msg, 0);
     (void)sent;
 }
 
+void UdpSink::buffer_line(std::string_view logger_name, LogLevel level, std::string_view message) {
+    if (!initialized) return;
+    const size_t line_size = (logger_name.empty() ? 0 : logger_name.size() + 2) + message.size() + 1;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const bool fits = options.pack_lines && !datagrams.empty() &&
+                      datagrams.back().size + line_size <= options.max_datagram;
+    if (!fits) {
+        if (datagrams.size() >= options.batch_size) {
+            send_buffered();
+        }
+        datagrams.push_back({buffer.size(), 0});
+    }
+    if (!logger_name.empty()) {
+        buffer.append(logger_name);
+        buffer.append(": ");
+    }
+    buffer.append(message);
+    buffer.push_back('\n');
+    datagrams.back().size += line_size;
+
+    if ((!options.pack_lines && datagrams.size() >= options.batch_size) ||
+        (options.flush_on && level >= *options.flush_on)) {
+        send_buffered();
+    }
+}
+
+void UdpSink::send_buffered() {
+    if (datagrams.empty()) return;
+    const size_t n = datagrams.size();
+    iovecs.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        iovecs[i] = {buffer.data() + datagrams[i].offset, datagrams[i].size};
+    }
+
+#ifdef __linux__
+    messages.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        struct msghdr& msg = messages[i].msg_hdr;
+        memset(&msg, 0, sizeof(msg));
+        if (!connected) {
+            msg.msg_name = &dest;
+            msg.msg_namelen = dest_len;
+        }
+        msg.msg_iov = &iovecs[i];
+        msg.msg_iovlen = 1;
+    }
+    size_t done = 0;
+    while (done < n) {
+        const int sent = sendmmsg(sockfd, messages.data() + done, static_cast<unsigned int>(n - done), 0);
+        if (sent > 0) {
+            done += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            ++done;  // This datagram is lost (e.g. ECONNREFUSED from an earlier one); send the rest
+        }
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        if (!connected) {
+            msg.msg_name = &dest;
+            msg.msg_namelen = dest_len;
+        }
+        msg.msg_iov = &iovecs[i];
+        msg.msg_iovlen = 1;
+        ssize_t sent = sendmsg(sockfd, &msg, 0);
+        (void)sent;
+    }
+#endif
+
+    buffer.clear();
+    datagrams.clear();
+}
+
 }
@@ -0,0 +1,137 @@
+#include "Zyrnix/snappy.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Zyrnix::snappy {
+
+namespace {
+
+constexpr size_t block_size = 1 << 16;  // Keeps every offset within two bytes
+constexpr int hash_bits = 14;
+constexpr size_t min_block_for_matches = 15;
+
+uint32_t load32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash(uint32_t bytes) {
+    return (bytes * 0x1E35A7BDu) >> (32 - hash_bits);
+}
+
+char* put_varint(char* op, uint64_t value) {
+    while (value >= 0x80) {
+        *op++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *op++ = static_cast<char>(value);
+    return op;
+}
+
+char* emit_literal(char* op, const char* literal, size_t len) {
+    const size_t n = len - 1;
+    if (n < 60) {
+        *op++ = static_cast<char>(n << 2);
+    } else {
+        // 60 + k: the length follows in k + 1 little-endian bytes
+        char* tag = op++;
+        int count = 0;
+        for (size_t rest = n; rest > 0; rest >>= 8) {
+            *op++ = static_cast<char>(rest & 0xFF);
+            ++count;
+        }
+        *tag = static_cast<char>((59 + count) << 2);
+    }
+    std::memcpy(op, literal, len);
+    return op + len;
+}
+
+// A copy of 4..64 bytes
+char* emit_copy_upto_64(char* op, size_t offset, size_t len) {
+    if (len < 12 && offset < 2048) {
+        *op++ = static_cast<char>(1 | ((len - 4) << 2) | ((offset >> 8) << 5));
+        *op++ = static_cast<char>(offset & 0xFF);
+    } else {
+        *op++ = static_cast<char>(2 | ((len - 1) << 2));
+        *op++ = static_cast<char>(offset & 0xFF);
+        *op++ = static_cast<char>(offset >> 8);
+    }
+    return op;
+}
+
+char* emit_copy(char* op, size_t offset, size_t len) {
+    // Long matches go out 64 bytes at a time, keeping the tail at 4 or more
+    while (len >= 68) {
+        op = emit_copy_upto_64(op, offset, 64);
+        len -= 64;
+    }
+    if (len > 64) {
+        op = emit_copy_upto_64(op, offset, 60);
+        len -= 60;
+    }
+    return emit_copy_upto_64(op, offset, len);
+}
+
+char* compress_block(const char* input, size_t n, char* op, uint16_t* table) {
+    if (n < min_block_for_matches) {
+        return n > 0 ? emit_literal(op, input, n) : op;
+    }
+    std::memset(table, 0, sizeof(uint16_t) << hash_bits);
+
+    // Matches may start up to the last 4 bytes, but the search stops a little
+    // earlier so load32 never reads past the block
+    const size_t search_limit = n - 4;
+    size_t next_emit = 0;
+    size_t ip = 1;
+    uint32_t skip = 32;
+    while (ip <= search_limit) {
+        const uint32_t bytes = load32(input + ip);
+        const uint32_t h = hash(bytes);
+        const size_t candidate = table[h];
+        table[h] = static_cast<uint16_t>(ip);
+        if (candidate >= ip || load32(input + candidate) != bytes) {
+            // Step further the longer nothing matches, as libsnappy does
+            ip += skip++ >> 5;
+            continue;
+        }
+        skip = 32;
+
+        if (ip > next_emit) {
+            op = emit_literal(op, input + next_emit, ip - next_emit);
+        }
+        size_t len = 4;
+        while (ip + len < n && input[candidate + len] == input[ip + len]) {
+            ++len;
+        }
+        op = emit_copy(op, ip - candidate, len);
+        ip += len;
+        next_emit = ip;
+        if (ip <= search_limit) {
+            table[hash(load32(input + ip - 1))] = static_cast<uint16_t>(ip - 1);
+        }
+    }
+    if (next_emit < n) {
+        op = emit_literal(op, input + next_emit, n - next_emit);
+    }
+    return op;
+}
+
+}
+
+void compress(std::string_view input, std::string& out) {
+    const size_t start = out.size();
+    out.resize(start + max_compressed_length(input.size()));
+    char* const base = out.data() + start;
+    char* op = put_varint(base, input.size());
+
+    uint16_t table[1 << hash_bits];
+    for (size_t pos = 0; pos < input.size(); pos += block_size) {
+        const size_t n = std::min(block_size, input.size() - pos);
+        op = compress_block(input.data() + pos, n, op, table);
+    }
+    out.resize(start + static_cast<size_t>(op - base));
+}
+
+}
@@ -0,0 +1,176 @@
+#include "Zyrnix/stack_trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#ifdef _WIN32
+#include <windows.h>
+#elif __has_include(<execinfo.h>)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#define XLOG_HAS_EXECINFO 1
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+void append_hex(std::string& out, uintptr_t value) {
+    char buf[2 + 2 * sizeof(uintptr_t) + 1];
+    std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(value));
+    out.append(buf);
+}
+
+std::string describe(void* address) {
+    std::string text;
+#ifdef XLOG_HAS_EXECINFO
+    // A return address points past the call; the byte before it is still
+    // inside the calling function, even when the call was its last instruction
+    const uintptr_t call = reinterpret_cast<uintptr_t>(address) - 1;
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(call), &info) == 0 || !info.dli_fname) {
+        return text;
+    }
+    if (info.dli_sname && info.dli_saddr) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        text.append(status == 0 && demangled ? demangled : info.dli_sname);
+        std::free(demangled);
+        text.push_back('+');
+        append_hex(text, reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_saddr));
+        text.append(" (");
+        text.append(info.dli_fname);
+        text.push_back(')');
+    } else {
+        text.push_back('(');
+        text.append(info.dli_fname);
+        text.push_back('+');
+        append_hex(text, reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+        text.push_back(')');
+    }
+#else
+    (void)address;
+#endif
+    return text;
+}
+
+// Frames of the logging call itself, above the caller's
+bool inside_library(std::string_view symbol) {
+    return symbol.starts_with("Zyrnix::");
+}
+
+}
+
+SymbolCache::SymbolCache(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+SymbolCache& SymbolCache::instance() {
+    static SymbolCache cache;
+    return cache;
+}
+
+std::string SymbolCache::lookup(void* address) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(address);
+        if (it != index_.end()) {
+            ++hits_;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->second;
+        }
+        ++misses_;
+    }
+    // Looked up outside the lock; two threads missing on one address
+    // both look it up, and the second insert is dropped
+    std::string text = describe(address);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(address) == index_.end()) {
+        entries_.emplace_front(address, text);
+        index_.emplace(address, entries_.begin());
+        trim();
+    }
+    return text;
+}
+
+void SymbolCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max<size_t>(capacity, 1);
+    trim();
+}
+
+void SymbolCache::trim() {
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+}
+
+SymbolCache::Stats SymbolCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{hits_, misses_, entries_.size()};
+}
+
+std::shared_ptr<StackTrace> StackTrace::capture(size_t max_frames) {
+    max_frames = std::min(max_frames, XLOG_MAX_STACK_FRAMES);
+    if (max_frames == 0) {
+        return nullptr;
+    }
+    // One more than asked for: the first frame is this function
+    void* frames[XLOG_MAX_STACK_FRAMES + 1];
+#ifdef _WIN32
+    const size_t count = RtlCaptureStackBackTrace(0, static_cast<DWORD>(max_frames + 1), frames, nullptr);
+#elif defined(XLOG_HAS_EXECINFO)
+    const int walked = backtrace(frames, static_cast<int>(max_frames + 1));
+    const size_t count = walked > 0 ? static_cast<size_t>(walked) : 0;
+#else
+    const size_t count = 0;
+#endif
+    if (count <= 1) {
+        return nullptr;
+    }
+    auto trace = std::make_shared<StackTrace>();
+    trace->count_ = count - 1;
+    std::copy(frames + 1, frames + count, trace->addresses_);
+    return trace;
+}
+
+void StackTrace::symbolize() const {
+    std::call_once(symbolized_, [this] {
+        SymbolCache& cache = SymbolCache::instance();
+        std::vector<std::string> symbols;
+        symbols.reserve(count_);
+        for (size_t i = 0; i < count_; ++i) {
+            symbols.push_back(cache.lookup(addresses_[i]));
+        }
+        size_t first = 0;
+        while (first + 1 < count_ && inside_library(symbols[first])) {
+            ++first;
+        }
+        frames_.reserve(count_ - first);
+        for (size_t i = first; i < count_; ++i) {
+            std::string frame = "#" + std::to_string(i - first) + " ";
+            append_hex(frame, reinterpret_cast<uintptr_t>(addresses_[i]));
+            if (!symbols[i].empty()) {
+                frame.push_back(' ');
+                frame.append(symbols[i]);
+            }
+            if (!text_.empty()) {
+                text_.push_back('\n');
+            }
+            text_.append(frame);
+            frames_.push_back(std::move(frame));
+        }
+    });
+}
+
+const std::vector<std::string>& StackTrace::frames() const {
+    symbolize();
+    return frames_;
+}
+
+const std::string& StackTrace::text() const {
+    symbolize();
+    return text_;
+}
+
+}
@@ -0,0 +1,644 @@
+#include "Zyrnix/structured_encoder.hpp"
+#include "Zyrnix/formatted_record.hpp"
+#include "Zyrnix/json_escape.hpp"
+#include "Zyrnix/log_context.hpp"
+#include "Zyrnix/timestamp_cache.hpp"
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+namespace Zyrnix {
+
+namespace {
+
+// Field text back to the number it was printed from; fails for text that
+// is not one, which is then written as a string
+bool parse_integer(std::string_view text, int64_t& value) {
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parse_unsigned(std::string_view text, uint64_t& value) {
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parse_float(std::string_view text, double& value) {
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+void put_be(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = bytes; i > 0; --i) {
+        out.push_back(static_cast<char>(value >> (8 * (i - 1))));
+    }
+}
+
+void put_le(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+void put_byte(std::string& out, uint8_t byte) {
+    out.push_back(static_cast<char>(byte));
+}
+
+int64_t unix_nanos(std::chrono::system_clock::time_point when) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+}
+
+bool has_trace(const StructuredHeader& header) {
+    return header.trace && header.trace->valid();
+}
+
+// Hex ids as text, for the formats whose readers expect strings
+template <class PutString>
+void put_trace_ids(const StructuredHeader& header, PutString&& put_string) {
+    char trace_id[TraceContext::trace_id_hex_size];
+    char span_id[TraceContext::span_id_hex_size];
+    header.trace->write_trace_id(trace_id);
+    header.trace->write_span_id(span_id);
+    put_string("trace_id");
+    put_string(std::string_view(trace_id, sizeof(trace_id)));
+    put_string("span_id");
+    put_string(std::string_view(span_id, sizeof(span_id)));
+}
+
+}
+
+void StructuredEncoder::thread_context(std::string& out) {
+    for (const auto& [key, value] : LogContext::current()) {
+        member(out, key, FieldType::String, value);
+    }
+}
+
+void StructuredEncoder::record_fields(std::string& out, const FormattedRecord& record) {
+    for (const auto& [key, value] : record.fields()) {
+        member(out, key, value);
+    }
+}
+
+// JSON
+
+void JsonEncoder::begin(std::string& out, const StructuredHeader& header, size_t) {
+    out.append("{\"timestamp\":\"");
+    out.append(TimestampCache::utc(header.timestamp));
+    TimestampCache::append_fraction(out, header.timestamp, TimePrecision::Milliseconds);
+    out.append("Z\",\"level\":\"");
+    out.append(to_string(header.level));
+    out.append("\",\"logger\":");
+    json::append_string(out, header.logger_name);
+    out.append(",\"message\":");
+    json::append_string(out, header.message);
+    if (has_trace(header)) {
+        out.append(",\"trace_id\":\"");
+        header.trace->append_trace_id(out);
+        out.append("\",\"span_id\":\"");
+        header.trace->append_span_id(out);
+        out.push_back('"');
+    }
+}
+
+void JsonEncoder::member(std::string& out, std::string_view key, FieldType type, std::string_view text) {
+    out.push_back(',');
+    json::append_string(out, key);
+    out.push_back(':');
+    if (type == FieldType::String) {
+        json::append_string(out, text);
+    } else {
+        out.append(text);
+    }
+}
+
+void JsonEncoder::end(std::string& out, size_t) {
+    out.append("}\n");
+}
+
+void JsonEncoder::thread_context(std::string& out) {
+    out.append(LogContext::json_fragment());
+}
+
+void JsonEncoder::record_fields(std::string& out, const FormattedRecord& record) {
+    out.append(record.fields_json());
+}
+
+// MessagePack
+
+namespace {
+
+void msgpack_str(std::string& out, std::string_view text) {
+    const size_t n = text.size();
+    if (n < 32) {
+        put_byte(out, static_cast<uint8_t>(0xA0 | n));
+    } else if (n < 0x100) {
+        put_byte(out, 0xD9);
+        put_be(out, n, 1);
+    } else if (n < 0x10000) {
+        put_byte(out, 0xDA);
+        put_be(out, n, 2);
+    } else {
+        put_byte(out, 0xDB);
+        put_be(out, n, 4);
+    }
+    out.append(text);
+}
+
+void msgpack_int(std::string& out, int64_t value) {
+    if (value >= 0) {
+        const auto u = static_cast<uint64_t>(value);
+        if (u < 0x80) {
+            put_byte(out, static_cast<uint8_t>(u));
+        } else if (u < 0x100) {
+            put_byte(out, 0xCC);
+            put_be(out, u, 1);
+        } else if (u < 0x10000) {
+            put_byte(out, 0xCD);
+            put_be(out, u, 2);
+        } else if (u < 0x100000000) {
+            put_byte(out, 0xCE);
+            put_be(out, u, 4);
+        } else {
+            put_byte(out, 0xCF);
+            put_be(out, u, 8);
+        }
+    } else if (value >= -32) {
+        put_byte(out, static_cast<uint8_t>(value));
+    } else if (value >= INT8_MIN) {
+        put_byte(out, 0xD0);
+        put_be(out, static_cast<uint64_t>(value), 1);
+    } else if (value >= INT16_MIN) {
+        put_byte(out, 0xD1);
+        put_be(out, static_cast<uint64_t>(value), 2);
+    } else if (value >= INT32_MIN) {
+        put_byte(out, 0xD2);
+        put_be(out, static_cast<uint64_t>(value), 4);
+    } else {
+        put_byte(out, 0xD3);
+        put_be(out, static_cast<uint64_t>(value), 8);
+    }
+}
+
+void msgpack_value(std::string& out, FieldType type, std::string_view text) {
+    int64_t integer;
+    uint64_t big;
+    double real;
+    if (type == FieldType::Integer && parse_integer(text, integer)) {
+        msgpack_int(out, integer);
+    } else if (type == FieldType::Integer && parse_unsigned(text, big)) {
+        put_byte(out, 0xCF);
+        put_be(out, big, 8);
+    } else if (type == FieldType::Float && parse_float(text, real)) {
+        put_byte(out, 0xCB);
+        put_be(out, std::bit_cast<uint64_t>(real), 8);
+    } else if (type == FieldType::Bool) {
+        put_byte(out, text == "true" ? 0xC3 : 0xC2);
+    } else {
+        msgpack_str(out, text);
+    }
+}
+
+}
+
+void MsgPackEncoder::begin(std::string& out, const StructuredHeader& header, size_t members) {
+    const size_t count = members + (has_trace(header) ? 6 : 4);
+    if (count < 16) {
+        put_byte(out, static_cast<uint8_t>(0x80 | count));
+    } else if (count < 0x10000) {
+        put_byte(out, 0xDE);
+        put_be(out, count, 2);
+    } else {
+        put_byte(out, 0xDF);
+        put_be(out, count, 4);
+    }
+
+    msgpack_str(out, "timestamp");
+    const int64_t ns = unix_nanos(header.timestamp);
+    int64_t seconds = ns / 1000000000;
+    int64_t nanos = ns % 1000000000;
+    if (nanos < 0) {
+        --seconds;
+        nanos += 1000000000;
+    }
+    if (seconds >= 0 && seconds < (int64_t{1} << 34)) {
+        // timestamp 64: 30 bits of nanoseconds over 34 of seconds
+        put_byte(out, 0xD7);
+        put_byte(out, 0xFF);
+        put_be(out, static_cast<uint64_t>(nanos) << 34 | static_cast<uint64_t>(seconds), 8);
+    } else {
+        put_byte(out, 0xC7);
+        put_byte(out, 12);
+        put_byte(out, 0xFF);
+        put_be(out, static_cast<uint64_t>(nanos), 4);
+        put_be(out, static_cast<uint64_t>(seconds), 8);
+    }
+    msgpack_str(out, "level");
+    msgpack_str(out, to_string(header.level));
+    msgpack_str(out, "logger");
+    msgpack_str(out, header.logger_name);
+    msgpack_str(out, "message");
+    msgpack_str(out, header.message);
+    if (has_trace(header)) {
+        put_trace_ids(header, [&](std::string_view text) { msgpack_str(out, text); });
+    }
+}
+
+void MsgPackEncoder::member(std::string& out, std::string_view key, FieldType type, std::string_view text) {
+    msgpack_str(out, key);
+    msgpack_value(out, type, text);
+}
+
+// CBOR
+
+namespace {
+
+void cbor_head(std::string& out, uint8_t major, uint64_t value) {
+    const auto type = static_cast<uint8_t>(major << 5);
+    if (value < 24) {
+        put_byte(out, static_cast<uint8_t>(type | value));
+    } else if (value < 0x100) {
+        put_byte(out, type | 24);
+        put_be(out, value, 1);
+    } else if (value < 0x10000) {
+        put_byte(out, type | 25);
+        put_be(out, value, 2);
+    } else if (value < 0x100000000) {
+        put_byte(out, type | 26);
+        put_be(out, value, 4);
+    } else {
+        put_byte(out, type | 27);
+        put_be(out, value, 8);
+    }
+}
+
+void cbor_text(std::string& out, std::string_view text) {
+    cbor_head(out, 3, text.size());
+    out.append(text);
+}
+
+void cbor_double(std::string& out, double value) {
+    put_byte(out, 0xFB);
+    put_be(out, std::bit_cast<uint64_t>(value), 8);
+}
+
+void cbor_value(std::string& out, FieldType type, std::string_view text) {
+    int64_t integer;
+    uint64_t big;
+    double real;
+    if (type == FieldType::Integer && parse_integer(text, integer)) {
+        if (integer >= 0) {
+            cbor_head(out, 0, static_cast<uint64_t>(integer));
+        } else {
+            cbor_head(out, 1, ~static_cast<uint64_t>(integer));  // -1 - n
+        }
+    } else if (type == FieldType::Integer && parse_unsigned(text, big)) {
+        cbor_head(out, 0, big);
+    } else if (type == FieldType::Float && parse_float(text, real)) {
+        cbor_double(out, real);
+    } else if (type == FieldType::Bool) {
+        put_byte(out, text == "true" ? 0xF5 : 0xF4);
+    } else {
+        cbor_text(out, text);
+    }
+}
+
+}
+
+void CborEncoder::begin(std::string& out, const StructuredHeader& header, size_t members) {
+    cbor_head(out, 5, members + (has_trace(header) ? 6 : 4));
+    cbor_text(out, "timestamp");
+    put_byte(out, 0xC1);  // Tag 1: epoch-based date/time
+    cbor_double(out, static_cast<double>(unix_nanos(header.timestamp)) / 1e9);
+    cbor_text(out, "level");
+    cbor_text(out, to_string(header.level));
+    cbor_text(out, "logger");
+    cbor_text(out, header.logger_name);
+    cbor_text(out, "message");
+    cbor_text(out, header.message);
+    if (has_trace(header)) {
+        put_trace_ids(header, [&](std::string_view text) { cbor_text(out, text); });
+    }
+}
+
+void CborEncoder::member(std::string& out, std::string_view key, FieldType type, std::string_view text) {
+    cbor_text(out, key);
+    cbor_value(out, type, text);
+}
+
+// Protobuf
+
+namespace {
+
+enum WireType : uint8_t { Varint = 0, Fixed64 = 1, Delimited = 2 };
+
+constexpr uint8_t tag(uint32_t field, WireType wire) {
+    return static_cast<uint8_t>(field << 3 | wire);
+}
+
+size_t varint_size(uint64_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void put_bytes(std::string& out, uint8_t field_tag, std::string_view bytes) {
+    put_byte(out, field_tag);
+    put_varint(out, bytes.size());
+    out.append(bytes);
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+}
+
+void ProtobufEncoder::begin(std::string& out, const StructuredHeader& header, size_t) {
+    put_byte(out, tag(1, Fixed64));
+    put_le(out, static_cast<uint64_t>(unix_nanos(header.timestamp)), 8);
+    put_byte(out, tag(2, Varint));
+    put_varint(out, static_cast<uint64_t>(header.level));
+    put_bytes(out, tag(3, Delimited), header.logger_name);
+    put_bytes(out, tag(4, Delimited), header.message);
+    if (has_trace(header)) {
+        put_bytes(out, tag(5, Delimited),
+                  std::string_view(reinterpret_cast<const char*>(header.trace->trace_id.data()), 16));
+        put_bytes(out, tag(6, Delimited),
+                  std::string_view(reinterpret_cast<const char*>(header.trace->span_id.data()), 8));
+    }
+}
+
+void ProtobufEncoder::member(std::string& out, std::string_view key, FieldType type, std::string_view text) {
+    // The Field's size goes first, so size the value up front
+    int64_t integer = 0;
+    double real = 0;
+    enum { String, Integer, Float, Bool } kind = String;
+    size_t value_size;
+    if (type == FieldType::Integer && parse_integer(text, integer)) {
+        kind = Integer;
+        value_size = 1 + varint_size(zigzag(integer));
+    } else if (type == FieldType::Float && parse_float(text, real)) {
+        kind = Float;
+        value_size = 1 + 8;
+    } else if (type == FieldType::Bool) {
+        kind = Bool;
+        value_size = 1 + 1;
+    } else {
+        value_size = 1 + varint_size(text.size()) + text.size();
+    }
+
+    put_byte(out, tag(7, Delimited));
+    put_varint(out, 1 + varint_size(key.size()) + key.size() + value_size);
+    put_bytes(out, tag(1, Delimited), key);
+    switch (kind) {
+        case Integer:
+            put_byte(out, tag(3, Varint));
+            put_varint(out, zigzag(integer));
+            break;
+        case Float:
+            put_byte(out, tag(4, Fixed64));
+            put_le(out, std::bit_cast<uint64_t>(real), 8);
+            break;
+        case Bool:
+            put_byte(out, tag(5, Varint));
+            put_byte(out, text == "true" ? 1 : 0);
+            break;
+        case String:
+            put_bytes(out, tag(2, Delimited), text);
+            break;
+    }
+}
+
+void ProtobufEncoder::end(std::string& out, size_t start) {
+    char prefix[10];
+    size_t n = 0;
+    for (uint64_t size = out.size() - start; ; size >>= 7) {
+        if (size < 0x80) {
+            prefix[n++] = static_cast<char>(size);
+            break;
+        }
+        prefix[n++] = static_cast<char>(size | 0x80);
+    }
+    out.insert(start, prefix, n);
+}
+
+// Text formats
+
+namespace {
+
+constexpr std::string_view lower_level_name(LogLevel lvl) {
+    switch (lvl) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+        case LogLevel::Critical: return "critical";
+        default: return "unknown";
+    }
+}
+
+void append_iso_timestamp(std::string& out, std::chrono::system_clock::time_point when) {
+    out.append(TimestampCache::utc(when));
+    TimestampCache::append_fraction(out, when, TimePrecision::Milliseconds);
+    out.push_back('Z');
+}
+
+}
+
+// logfmt
+
+namespace {
+
+bool logfmt_needs_quotes(std::string_view text) {
+    // memchr and find_escape are both vectorized; find_escape catches
+    // quotes, backslashes and control characters
+    return text.empty() || std::memchr(text.data(), ' ', text.size()) ||
+           std::memchr(text.data(), '=', text.size()) || json::find_escape(text) != text.size();
+}
+
+void logfmt_value(std::string& out, std::string_view text) {
+    if (logfmt_needs_quotes(text)) {
+        json::append_string(out, text);
+    } else {
+        out.append(text);
+    }
+}
+
+void logfmt_key(std::string& out, std::string_view key) {
+    // A key cannot be quoted, so characters that would end it become '_'
+    const size_t start = out.size();
+    out.append(key);
+    for (size_t i = start; i < out.size(); ++i) {
+        const auto c = static_cast<unsigned char>(out[i]);
+        if (c <= ' ' || c == '=' || c == '"' || c == 0x7F) {
+            out[i] = '_';
+        }
+    }
+    if (key.empty()) {
+        out.push_back('_');
+    }
+}
+
+}
+
+void LogfmtEncoder::begin(std::string& out, const StructuredHeader& header, size_t) {
+    out.append("ts=");
+    append_iso_timestamp(out, header.timestamp);
+    out.append(" level=");
+    out.append(lower_level_name(header.level));
+    out.append(" logger=");
+    logfmt_value(out, header.logger_name);
+    out.append(" msg=");
+    logfmt_value(out, header.message);
+    if (has_trace(header)) {
+        out.append(" trace_id=");
+        header.trace->append_trace_id(out);
+        out.append(" span_id=");
+        header.trace->append_span_id(out);
+    }
+}
+
+void LogfmtEncoder::member(std::string& out, std::string_view key, FieldType type, std::string_view text) {
+    out.push_back(' ');
+    logfmt_key(out, key);
+    out.push_back('=');
+    if (type == FieldType::String) {
+        logfmt_value(out, text);
+    } else {
+        out.append(text);
+    }
+}
+
+void LogfmtEncoder::end(std::string& out, size_t) {
+    out.push_back('\n');
+}
+
+// ECS
+
+void EcsEncoder::begin(std::string& out, const StructuredHeader& header, size_t) {
+    out.append("{\"@timestamp\":\"");
+    append_iso_timestamp(out, header.timestamp);
+    out.append("\",\"log.level\":\"");
+    out.append(lower_level_name(header.level));
+    out.append("\",\"message\":");
+    json::append_string(out, header.message);
+    out.append(",\"ecs.version\":\"");
+    out.append(ecs_version);
+    out.append("\",\"log.logger\":");
+    json::append_string(out, header.logger_name);
+    if (has_trace(header)) {
+        out.append(",\"trace.id\":\"");
+        header.trace->append_trace_id(out);
+        out.append("\",\"span.id\":\"");
+        header.trace->append_span_id(out);
+        out.push_back('"');
+    }
+}
+
+// GELF
+
+namespace {
+
+// RFC 5424 severities
+constexpr int syslog_severity(LogLevel lvl) {
+    switch (lvl) {
+        case LogLevel::Trace:
+        case LogLevel::Debug: return 7;
+        case LogLevel::Info: return 6;
+        case LogLevel::Warn: return 4;
+        case LogLevel::Error: return 3;
+        case LogLevel::Critical: return 2;
+        default: return 6;
+    }
+}
+
+std::string local_hostname() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+        return "localhost";
+    }
+    return name;
+}
+
+}
+
+GelfEncoder::GelfEncoder(std::string host) {
+    json::append_string(host_json_, host.empty() ? local_hostname() : host);
+}
+
+void GelfEncoder::begin(std::string& out, const StructuredHeader& header, size_t) {
+    out.append("{\"version\":\"1.1\",\"host\":");
+    out.append(host_json_);
+    out.append(",\"short_message\":");
+    json::append_string(out, header.message);
+
+    int64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        header.timestamp.time_since_epoch()).count();
+    int64_t seconds = millis / 1000;
+    millis %= 1000;
+    if (millis < 0) {
+        --seconds;
+        millis += 1000;
+    }
+    char number[24];
+    out.append(",\"timestamp\":");
+    out.append(number, std::to_chars(number, number + sizeof(number), seconds).ptr);
+    out.push_back('.');
+    out.push_back(static_cast<char>('0' + millis / 100));
+    out.push_back(static_cast<char>('0' + millis / 10 % 10));
+    out.push_back(static_cast<char>('0' + millis % 10));
+
+    out.append(",\"level\":");
+    out.push_back(static_cast<char>('0' + syslog_severity(header.level)));
+    out.append(",\"_logger\":");
+    json::append_string(out, header.logger_name);
+    if (has_trace(header)) {
+        out.append(",\"_trace_id\":\"");
+        header.trace->append_trace_id(out);
+        out.append("\",\"_span_id\":\"");
+        header.trace->append_span_id(out);
+        out.push_back('"');
+    }
+}
+
+void GelfEncoder::member(std::string& out, std::string_view key, FieldType type, std::string_view text) {
+    out.append(",\"_");
+    json::append_escaped(out, key);
+    out.append("\":");
+    if (type == FieldType::Integer || type == FieldType::Float) {
+        out.append(text);
+    } else {
+        json::append_string(out, text);
+    }
+}
+
+void GelfEncoder::end(std::string& out, size_t) {
+    out.append("}\n");
+}
+
+std::unique_ptr<StructuredEncoder> make_encoder(StructuredFormat format) {
+    switch (format) {
+        case StructuredFormat::MsgPack: return std::make_unique<MsgPackEncoder>();
+        case StructuredFormat::Cbor: return std::make_unique<CborEncoder>();
+        case StructuredFormat::Protobuf: return std::make_unique<ProtobufEncoder>();
+        case StructuredFormat::Logfmt: return std::make_unique<LogfmtEncoder>();
+        case StructuredFormat::Ecs: return std::make_unique<EcsEncoder>();
+        case StructuredFormat::Gelf: return std::make_unique<GelfEncoder>();
+        default: return std::make_unique<JsonEncoder>();
+    }
+}
+
+}
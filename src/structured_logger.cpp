@@ -1,4 +1,5 @@
 #include "Zyrnix/structured_logger.hpp"
+#include <vector>
 
 namespace Zyrnix {
 
@@ -9,7 +10,7 @@ std::shared_ptr<StructuredLogger> StructuredLogger::create(const std::string& na
     return std::make_shared<StructuredLogger>(logger, sink);
 }
 
-StructuredLogger::StructuredLogger(std::shared_ptr<Logger> logger_, std::shared_ptr<StructuredJsonSink> sink_)
+StructuredLogger::StructuredLogger(std::shared_ptr<Logger> logger_, std::shared_ptr<StructuredSink> sink_)
     : logger(logger_), json_sink(sink_) {}
 
 void StructuredLogger::set_context(const std::string& key, const std::string& value) {
@@ -20,28 +21,42 @@ void StructuredLogger::clear_context() {
     json_sink->clear_context();
 }
 
+void StructuredLogger::log_map(LogLevel level, std::string_view message,
+                               const std::map<std::string, std::string>& fields) {
+    if (fields.empty()) {
+        logger->log(level, message);
+        return;
+    }
+    std::vector<Field> list;
+    list.reserve(fields.size());
+    for (const auto& [key, value] : fields) {
+        list.push_back(Field{key, FieldValue(value)});
+    }
+    logger->log_fields(level, message, list);
+}
+
 void StructuredLogger::trace(const std::string& message, const std::map<std::string, std::string>& fields) {
-    json_sink->log_with_fields(logger->name, LogLevel::Trace, message, fields);
+    log_map(LogLevel::Trace, message, fields);
 }
 
 void StructuredLogger::debug(const std::string& message, const std::map<std::string, std::string>& fields) {
-    json_sink->log_with_fields(logger->name, LogLevel::Debug, message, fields);
+    log_map(LogLevel::Debug, message, fields);
 }
 
 void StructuredLogger::info(const std::string& message, const std::map<std::string, std::string>& fields) {
-    json_sink->log_with_fields(logger->name, LogLevel::Info, message, fields);
+    log_map(LogLevel::Info, message, fields);
 }
 
 void StructuredLogger::warn(const std::string& message, const std::map<std::string, std::string>& fields) {
-    json_sink->log_with_fields(logger->name, LogLevel::Warn, message, fields);
+    log_map(LogLevel::Warn, message, fields);
 }
 
 void StructuredLogger::error(const std::string& message, const std::map<std::string, std::string>& fields) {
-    json_sink->log_with_fields(logger->name, LogLevel::Error, message, fields);
+    log_map(LogLevel::Error, message, fields);
 }
 
 void StructuredLogger::critical(const std::string& message, const std::map<std::string, std::string>& fields) {
-    json_sink->log_with_fields(logger->name, LogLevel::Critical, message, fields);
+    log_map(LogLevel::Critical, message, fields);
 }
 
 }
@@ -0,0 +1,195 @@
+#include "Zyrnix/thread_placement.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr unsigned long max_nodes = 16 * sizeof(unsigned long) * 8;  // Bits in NumaLocalScope's mask
+
+struct PlacementState {
+    std::mutex mtx;
+    ThreadPlacement placement;
+    std::atomic<int> numa_node{-1};  // Node of every CPU in placement, -1 if none or several
+};
+
+// Leaked, like the other process-wide singletons: background threads may
+// still start from static destructors
+PlacementState& state() {
+    static auto* s = new PlacementState;
+    return *s;
+}
+
+#ifdef __linux__
+// The node a CPU belongs to, from the nodeN link sysfs keeps in its directory
+int node_of_cpu(int cpu) {
+    const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, "node", 4) == 0) {
+            const char* end = name + std::strlen(name);
+            int value = -1;
+            if (std::from_chars(name + 4, end, value).ptr == end) {
+                node = value;
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+long get_mempolicy(int* mode, unsigned long* nodes) {
+    return syscall(SYS_get_mempolicy, mode, nodes, max_nodes, nullptr, 0UL);
+}
+
+// The kernel reads one bit less than it is told to
+long set_mempolicy(int mode, const unsigned long* nodes) {
+    return syscall(SYS_set_mempolicy, mode, nodes, nodes ? max_nodes + 1 : 0UL);
+}
+
+bool prefer_node(int node) {
+    unsigned long nodes[16] = {};
+    if (node < 0 || static_cast<unsigned long>(node) >= max_nodes) {
+        return false;
+    }
+    constexpr int bits = sizeof(unsigned long) * 8;
+    nodes[node / bits] = 1UL << (node % bits);
+    return set_mempolicy(MPOL_PREFERRED, nodes) == 0;
+}
+#endif
+
+}
+
+void set_thread_placement(ThreadPlacement placement) {
+    std::sort(placement.cpus.begin(), placement.cpus.end());
+    placement.cpus.erase(std::unique(placement.cpus.begin(), placement.cpus.end()), placement.cpus.end());
+
+    int node = -1;
+#ifdef __linux__
+    if (placement.numa_local) {
+        for (size_t i = 0; i < placement.cpus.size(); ++i) {
+            const int cpu_node = node_of_cpu(placement.cpus[i]);
+            if (cpu_node < 0 || (i > 0 && cpu_node != node)) {
+                node = -1;
+                break;
+            }
+            node = cpu_node;
+        }
+    }
+#endif
+
+    PlacementState& s = state();
+    std::lock_guard<std::mutex> lock(s.mtx);
+    s.placement = std::move(placement);
+    s.numa_node.store(node, std::memory_order_relaxed);
+}
+
+ThreadPlacement get_thread_placement() {
+    PlacementState& s = state();
+    std::lock_guard<std::mutex> lock(s.mtx);
+    return s.placement;
+}
+
+std::vector<int> parse_cpu_list(std::string_view list) {
+    std::vector<int> cpus;
+    const auto number = [&list](size_t& pos, int& value) {
+        const char* begin = list.data() + pos;
+        const auto result = std::from_chars(begin, list.data() + list.size(), value);
+        if (result.ec != std::errc() || value < 0) return false;
+        pos += static_cast<size_t>(result.ptr - begin);
+        return true;
+    };
+    size_t pos = 0;
+    while (pos < list.size()) {
+        int first = 0;
+        int last = 0;
+        if (!number(pos, first)) return {};
+        last = first;
+        if (pos < list.size() && list[pos] == '-') {
+            ++pos;
+            if (!number(pos, last) || last < first) return {};
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (pos < list.size()) {
+            if (list[pos] != ',' || pos + 1 == list.size()) return {};
+            ++pos;
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+void init_background_thread(const char* name) {
+    char short_name[16];
+    std::strncpy(short_name, name, sizeof(short_name) - 1);
+    short_name[sizeof(short_name) - 1] = '\0';
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), short_name);
+
+    PlacementState& s = state();
+    std::vector<int> cpus;
+    {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        cpus = s.placement.cpus;
+    }
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::cerr << "ThreadPlacement: cannot pin " << short_name << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+    prefer_node(s.numa_node.load(std::memory_order_relaxed));
+#elif defined(__APPLE__)
+    pthread_setname_np(short_name);
+#endif
+}
+
+NumaLocalScope::NumaLocalScope() {
+#ifdef __linux__
+    const int node = state().numa_node.load(std::memory_order_relaxed);
+    if (node >= 0 && get_mempolicy(&old_mode_, old_nodes_) == 0) {
+        active_ = prefer_node(node);
+    }
+#endif
+}
+
+NumaLocalScope::~NumaLocalScope() {
+#ifdef __linux__
+    if (active_) {
+        set_mempolicy(old_mode_, old_mode_ == MPOL_DEFAULT ? nullptr : old_nodes_);
+    }
+#endif
+}
+
+}
@@ -0,0 +1,117 @@
+#include "Zyrnix/timestamp_cache.hpp"
+#include <ctime>
+
+namespace Zyrnix {
+
+namespace {
+
+constexpr size_t datetime_size = 19;  // "YYYY-MM-DD HH:MM:SS"
+
+inline void write2(char* out, int value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+void write_datetime(char* out, const std::tm& tm, char separator) {
+    const int year = tm.tm_year + 1900;
+    write2(out, year / 100);
+    write2(out + 2, year % 100);
+    out[4] = '-';
+    write2(out + 5, tm.tm_mon + 1);
+    out[7] = '-';
+    write2(out + 8, tm.tm_mday);
+    out[10] = separator;
+    write2(out + 11, tm.tm_hour);
+    out[13] = ':';
+    write2(out + 14, tm.tm_min);
+    out[16] = ':';
+    write2(out + 17, tm.tm_sec);
+}
+
+struct CachedSecond {
+    std::time_t second = 0;
+    bool valid = false;
+    char text[datetime_size];
+};
+
+template <bool Utc>
+std::string_view cached(std::chrono::system_clock::time_point when) {
+    thread_local CachedSecond cache;
+    const std::time_t second = static_cast<std::time_t>(
+        std::chrono::floor<std::chrono::seconds>(when.time_since_epoch()).count());
+    if (!cache.valid || cache.second != second) {
+        std::tm tm;
+        if constexpr (Utc) {
+            gmtime_r(&second, &tm);
+        } else {
+            localtime_r(&second, &tm);
+        }
+        write_datetime(cache.text, tm, Utc ? 'T' : ' ');
+        cache.second = second;
+        cache.valid = true;
+    }
+    return std::string_view(cache.text, datetime_size);
+}
+
+}
+
+std::string_view TimestampCache::local(std::chrono::system_clock::time_point when) {
+    return cached<false>(when);
+}
+
+std::string_view TimestampCache::utc(std::chrono::system_clock::time_point when) {
+    return cached<true>(when);
+}
+
+size_t TimestampCache::fraction_size(TimePrecision precision) {
+    switch (precision) {
+        case TimePrecision::Milliseconds: return 4;
+        case TimePrecision::Microseconds: return 7;
+        default: return 0;
+    }
+}
+
+void TimestampCache::append_fraction(std::string& out, std::chrono::system_clock::time_point when,
+                                     TimePrecision precision) {
+    if (precision == TimePrecision::Seconds) {
+        return;
+    }
+    const auto since_epoch = when.time_since_epoch();
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        since_epoch - std::chrono::floor<std::chrono::seconds>(since_epoch)).count();
+    int digits = 6;
+    if (precision == TimePrecision::Milliseconds) {
+        micros /= 1000;
+        digits = 3;
+    }
+    char buf[7];
+    buf[0] = '.';
+    for (int i = digits; i > 0; --i) {
+        buf[i] = static_cast<char>('0' + micros % 10);
+        micros /= 10;
+    }
+    out.append(buf, static_cast<size_t>(digits) + 1);
+}
+
+int64_t next_local_rollover_ns(std::chrono::system_clock::time_point when, bool daily) {
+    const std::time_t second = std::chrono::system_clock::to_time_t(when);
+    std::tm tm;
+    localtime_r(&second, &tm);
+    tm.tm_sec = 0;
+    tm.tm_min = 0;
+    if (daily) {
+        tm.tm_hour = 0;
+        tm.tm_mday += 1;
+    } else {
+        tm.tm_hour += 1;
+    }
+    tm.tm_isdst = -1;  // Let mktime() work out which side of a DST change it is
+    std::time_t next = std::mktime(&tm);
+    if (next <= second) {
+        // The repeated hour when the clocks go back can come out as now
+        next = second + (daily ? 86400 : 3600);
+    }
+    return static_cast<int64_t>(next) * 1'000'000'000ll;
+}
+
+}
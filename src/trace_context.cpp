@@ -0,0 +1,105 @@
+#include "Zyrnix/trace_context.hpp"
+
+namespace Zyrnix {
+
+namespace {
+
+thread_local TraceContext thread_trace;
+
+constexpr char hex_digits[] = "0123456789abcdef";
+
+template <size_t N>
+void to_hex(const std::array<uint8_t, N>& bytes, char* out) {
+    for (size_t i = 0; i < N; ++i) {
+        out[2 * i] = hex_digits[bytes[i] >> 4];
+        out[2 * i + 1] = hex_digits[bytes[i] & 0xF];
+    }
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool from_hex(std::string_view text, uint8_t* out, size_t bytes) {
+    if (text.size() != bytes * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < bytes; ++i) {
+        const int high = hex_value(text[2 * i]);
+        const int low = hex_value(text[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+}
+
+void TraceContext::write_trace_id(char (&out)[trace_id_hex_size]) const {
+    to_hex(trace_id, out);
+}
+
+void TraceContext::write_span_id(char (&out)[span_id_hex_size]) const {
+    to_hex(span_id, out);
+}
+
+void TraceContext::append_trace_id(std::string& out) const {
+    char hex[trace_id_hex_size];
+    write_trace_id(hex);
+    out.append(hex, sizeof(hex));
+}
+
+void TraceContext::append_span_id(std::string& out) const {
+    char hex[span_id_hex_size];
+    write_span_id(hex);
+    out.append(hex, sizeof(hex));
+}
+
+std::string TraceContext::traceparent() const {
+    std::string out = "00-";
+    append_trace_id(out);
+    out.push_back('-');
+    append_span_id(out);
+    out.push_back('-');
+    out.push_back(hex_digits[flags >> 4]);
+    out.push_back(hex_digits[flags & 0xF]);
+    return out;
+}
+
+// version "-" trace-id "-" parent-id "-" trace-flags; later versions may
+// append fields after the flags, which are ignored
+std::optional<TraceContext> TraceContext::from_traceparent(std::string_view header) {
+    if (header.size() < 55 || header[2] != '-' || header[35] != '-' || header[52] != '-' ||
+        (header.size() > 55 && header[55] != '-')) {
+        return std::nullopt;
+    }
+    uint8_t version;
+    TraceContext context;
+    if (!from_hex(header.substr(0, 2), &version, 1) || version == 0xFF ||
+        (version == 0 && header.size() != 55) ||
+        !from_hex(header.substr(3, 32), context.trace_id.data(), context.trace_id.size()) ||
+        !from_hex(header.substr(36, 16), context.span_id.data(), context.span_id.size()) ||
+        !from_hex(header.substr(53, 2), &context.flags, 1) || !context.valid()) {
+        return std::nullopt;
+    }
+    return context;
+}
+
+const TraceContext& TraceContext::current() {
+    return thread_trace;
+}
+
+void TraceContext::set(const TraceContext& context) {
+    thread_trace = context;
+}
+
+void TraceContext::clear() {
+    thread_trace = TraceContext{};
+}
+
+}
@@ -0,0 +1,6 @@
+#include "Zyrnix/tracepoints.hpp"
+
+// Raised by tracers attached to these probes; read on the logging path
+XLOG_PROBE_DEFINE_SEMAPHORE(log__return);
+XLOG_PROBE_DEFINE_SEMAPHORE(redact);
+XLOG_PROBE_DEFINE_SEMAPHORE(sink__write__end);
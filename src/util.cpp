@@ -1,5 +1,7 @@
 #include "Zyrnix/util.hpp"
 #include <cstdio>
+#include <functional>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,6 +13,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 namespace Zyrnix {
 
 std::string trim(const std::string& s) {
@@ -20,6 +26,17 @@ std::string trim(const std::string& s) {
     return s.substr(b, e - b + 1);
 }
 
+uint64_t current_thread_id() {
+    thread_local const uint64_t id = [] {
+#ifdef __linux__
+        return static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+        return static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+    }();
+    return id;
+}
+
 namespace path {
 
 #ifdef _WIN32
@@ -0,0 +1,365 @@
+// Allocations per log call on an async logger. The caller only fills a
+// record recycled from the pool and pushes it, so once the pool holds as
+// many records as are in flight a call allocates nothing on the logging
+// thread, on any queue backend. The worker renders into per-thread
+// buffers, so it does not allocate per record either. try_log(),
+// backpressure, tenant fairness and lazy messages are checked at the end.
+#include "test_harness.hpp"
+#include "Zyrnix/async/async_queue.hpp"
+#include "Zyrnix/log_macros.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+constexpr int calls = 1000;
+
+const char* const line = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+struct Counts {
+    uint64_t caller;
+    uint64_t worker;  // Everything else in the process, the flush included
+};
+
+// flush() itself allocates a fence and its future; allow for that
+constexpr uint64_t flush_allocations = 8;
+
+// Holds the worker in its first record until opened, so the warm-up has
+// every one of its records in flight at once and the pool ends up holding
+// at least as many as the measured run can need
+class GateSink : public LogSink {
+public:
+    void log(const std::string&, LogLevel, const std::string&) override { wait(); }
+    void log_record(const FormattedRecord&) override { wait(); }
+
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            open_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    // Returns once the worker is held in a record
+    void wait_held() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return held_; });
+    }
+
+private:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (!held_) {
+            held_ = true;
+            cv_.notify_all();
+        }
+        cv_.wait(lock, [this] { return open_; });
+    }
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool open_ = false;
+    bool held_ = false;
+};
+
+Counts allocations_per_run(Logger& logger, GateSink& gate) {
+    for (int i = 0; i <= calls; ++i) {
+        logger.info(line);
+    }
+    gate.open();
+    logger.flush().wait();
+
+    const uint64_t total_before = test::total_allocations();
+    test::AllocationScope scope;
+    for (int i = 0; i < calls; ++i) {
+        logger.info(line);
+    }
+    const uint64_t caller = scope.count();
+    logger.flush().wait();
+    return Counts{caller, test::total_allocations() - total_before - scope.count()};
+}
+
+void check_backend(QueueBackend backend, const LogSinkPtr& sink) {
+    AsyncOptions options;
+    options.backend = backend;
+    options.block_timeout_ms = 60000;  // Never drop
+    auto logger = Logger::create_async("test", options);
+    auto gate = std::make_shared<GateSink>();
+    logger->add_sink(gate);
+    logger->add_sink(sink);
+    const Counts counts = allocations_per_run(*logger, *gate);
+    XLOG_CHECK_EQ(counts.caller, 0u);
+    XLOG_CHECK(counts.worker <= flush_allocations);
+}
+
+}
+
+XLOG_TEST(async_null_sink_does_not_allocate) {
+    for (QueueBackend backend : {QueueBackend::Mutex, QueueBackend::LockFreeRing, QueueBackend::PerThreadLanes}) {
+        check_backend(backend, std::make_shared<NullSink>());
+    }
+}
+
+XLOG_TEST(async_file_sink_does_not_allocate) {
+    const auto path = std::filesystem::temp_directory_path() / "Zyrnix_test_async.log";
+    for (QueueBackend backend : {QueueBackend::Mutex, QueueBackend::LockFreeRing, QueueBackend::PerThreadLanes}) {
+        std::filesystem::remove(path);
+        check_backend(backend, std::make_shared<FileSink>(path.string()));
+        XLOG_CHECK(std::filesystem::file_size(path) > 0);
+    }
+    std::filesystem::remove(path);
+}
+
+// With the worker held in the first record, try_log() fills the queue and then reports
+// DroppedFull at once, though the policy would block for a minute;
+// pressure rises through both watermarks and drops back once drained
+XLOG_TEST(try_log_sheds_instead_of_blocking) {
+    for (QueueBackend backend : {QueueBackend::Mutex, QueueBackend::LockFreeRing, QueueBackend::PerThreadLanes}) {
+        AsyncOptions options;
+        options.backend = backend;
+        options.queue_capacity = 64;
+        options.lane_capacity = 64;
+        options.block_timeout_ms = 60000;
+        auto logger = Logger::create_async("test", options);
+        logger->set_level(LogLevel::Info);
+        auto gate = std::make_shared<GateSink>();
+        logger->add_sink(gate);
+
+        std::mutex mtx;
+        std::vector<std::pair<Backpressure, Backpressure>> transitions;
+        logger->register_backpressure_callback([&](Backpressure previous, Backpressure current) {
+            std::lock_guard<std::mutex> lock(mtx);
+            transitions.emplace_back(previous, current);
+        });
+
+        XLOG_CHECK(logger->try_log(LogLevel::Info, line) == LogStatus::Accepted);
+        gate->wait_held();
+
+        int accepted = 0;
+        LogStatus status = LogStatus::Accepted;
+        while (status == LogStatus::Accepted && accepted < 1000) {
+            status = logger->try_log(LogLevel::Info, line);
+            accepted += status == LogStatus::Accepted;
+        }
+        XLOG_CHECK(status == LogStatus::DroppedFull);
+        XLOG_CHECK(accepted >= 64 && accepted <= 66);
+        XLOG_CHECK(logger->backpressure() == Backpressure::Saturated);
+        XLOG_CHECK(logger->try_log(LogLevel::Debug, line) == LogStatus::Filtered);
+
+        gate->open();
+        logger->flush().wait();
+        XLOG_CHECK(logger->backpressure() == Backpressure::Normal);
+        std::lock_guard<std::mutex> lock(mtx);
+        XLOG_CHECK_EQ(transitions.size(), 3u);
+        XLOG_CHECK(transitions[0] == std::make_pair(Backpressure::Normal, Backpressure::Elevated));
+        XLOG_CHECK(transitions[1] == std::make_pair(Backpressure::Elevated, Backpressure::Saturated));
+        XLOG_CHECK(transitions[2] == std::make_pair(Backpressure::Saturated, Backpressure::Normal));
+    }
+}
+
+// Single-record pop() on the Mutex backend lowers the pressure too
+XLOG_TEST(pop_drops_pressure_back_to_normal) {
+    AsyncQueueOptions options;
+    options.capacity = 64;
+    AsyncQueue queue(options);
+    std::vector<Backpressure> seen;
+    queue.set_pressure_callback([&](Backpressure, Backpressure current) { seen.push_back(current); });
+    for (size_t i = 0; i < options.capacity; ++i) {
+        LogRecord record;
+        record.message = line;
+        XLOG_CHECK(queue.try_push(std::move(record)));
+    }
+    XLOG_CHECK(!queue.try_push(LogRecord()));
+    XLOG_CHECK(queue.pressure() == Backpressure::Saturated);
+    LogRecord record;
+    for (size_t i = 0; i < options.capacity; ++i) {
+        XLOG_CHECK(queue.pop(record));
+    }
+    XLOG_CHECK(queue.pressure() == Backpressure::Normal);
+    XLOG_CHECK(!seen.empty() && seen.back() == Backpressure::Normal);
+}
+
+XLOG_TEST(try_log_reports_the_rate_limit) {
+    auto logger = std::make_shared<Logger>("test");
+    logger->add_sink(std::make_shared<NullSink>());
+    logger->set_rate_limit(RateLimiterOptions{1, 2});
+    XLOG_CHECK(logger->try_log(LogLevel::Info, line) == LogStatus::Accepted);
+    XLOG_CHECK(logger->try_log(LogLevel::Info, line) == LogStatus::Accepted);
+    XLOG_CHECK(logger->try_log(LogLevel::Info, line) == LogStatus::RateLimited);
+    logger->clear_rate_limit();
+    XLOG_CHECK(logger->try_log(LogLevel::Info, line) == LogStatus::Accepted);
+}
+
+// Held back by the gate, an unbounded queue fills the budget: Info lines
+// are sampled, then dropped, while Error lines still get in, and the
+// account is back to zero once the queue drains
+XLOG_TEST(memory_budget_sheds_low_levels_first) {
+    MemoryBudgetOptions limits;
+    limits.limit_bytes = 256 * 1024;
+    limits.sample_fill = 0.5;
+    MemoryBudget::instance().configure(limits);
+    {
+        AsyncOptions options;
+        options.queue_capacity = 0;
+        auto logger = Logger::create_async("budget_test", options);
+        auto gate = std::make_shared<GateSink>();
+        logger->add_sink(gate);
+
+        int accepted = 0;
+        for (int i = 0; i < 10000; ++i) {
+            accepted += logger->try_log(LogLevel::Info, line) == LogStatus::Accepted;
+        }
+        const MemoryBudgetStats stats = MemoryBudget::instance().stats();
+        XLOG_CHECK(accepted > 0 && accepted < 10000);
+        XLOG_CHECK(stats.sampled_out > 0);
+        XLOG_CHECK(stats.dropped > 0);
+        XLOG_CHECK(stats.used <= limits.limit_bytes);
+        XLOG_CHECK(logger->try_log(LogLevel::Error, line) == LogStatus::Accepted);
+
+        gate->open();
+        logger->flush().wait();
+        for (const auto& account : MemoryBudget::instance().stats().accounts) {
+            if (account.name == "budget_test") {
+                XLOG_CHECK_EQ(account.used, 0u);
+            }
+        }
+    }
+    MemoryBudget::instance().configure(MemoryBudgetOptions{});
+}
+
+// A quiet tenant's records come out within a round of the noisy one's,
+// not behind its backlog; the noisy one stops at its quota
+XLOG_TEST(tenants_share_the_queue_fairly) {
+    AsyncQueueOptions options;
+    options.capacity = 0;
+    options.budget_account = "tenant_test";
+    options.tenants.field = "tenant";
+    options.tenants.quantum_bytes = 4 * sizeof(LogRecord);
+    options.tenants.quota_bytes = 200 * (sizeof(LogRecord) + 64);
+    AsyncQueue queue(options);
+
+    auto record = [](const char* tenant) {
+        LogRecord r;
+        r.level = LogLevel::Info;
+        r.message.assign(32, 'x');
+        r.fields.emplace("tenant", tenant);
+        return r;
+    };
+    size_t noisy = 0;
+    while (queue.push(record("noisy"))) {
+        ++noisy;
+    }
+    XLOG_CHECK(noisy >= 200 && noisy < 400);
+    XLOG_CHECK_EQ(queue.overflow_stats().over_quota, 1u);
+    for (int i = 0; i < 3; ++i) {
+        XLOG_CHECK(queue.push(record("quiet")));
+    }
+
+    std::vector<LogRecord> out;
+    XLOG_CHECK(queue.pop_bulk(out, 12));
+    size_t quiet = 0;
+    for (const auto& r : out) {
+        quiet += r.get_field("tenant") == "quiet";
+    }
+    XLOG_CHECK_EQ(quiet, 3u);
+
+    auto tenants = MetricsRegistry::instance().get_tenant_metrics("tenant_test")->snapshot();
+    XLOG_CHECK_EQ(tenants.size(), 2u);
+    XLOG_CHECK(tenants[0].tenant == "noisy" && tenants[0].over_quota == 1);
+    XLOG_CHECK_EQ(tenants[0].queued, noisy - (12 - 3));
+    XLOG_CHECK(tenants[1].tenant == "quiet" && tenants[1].queued == 0 && tenants[1].enqueued == 3);
+    std::string exposition;
+    MetricsRegistry::instance().write_exposition(exposition);
+    XLOG_CHECK(exposition.find("tenant_dropped_total{queue=\"tenant_test\",tenant=\"noisy\",reason=\"quota\"} 1") !=
+               std::string::npos);
+}
+
+// Keeps the messages it gets and the thread each arrives on
+class CaptureSink : public LogSink {
+public:
+    void log(const std::string&, LogLevel, const std::string& message) override { keep(message); }
+    void log_record(const FormattedRecord& record) override { keep(std::string(record.message())); }
+
+    std::vector<std::pair<std::string, std::thread::id>> take() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return std::move(messages_);
+    }
+
+private:
+    void keep(std::string message) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        messages_.emplace_back(std::move(message), std::this_thread::get_id());
+    }
+
+    std::mutex mtx_;
+    std::vector<std::pair<std::string, std::thread::id>> messages_;
+};
+
+// The wrapper stays at Trace and reads the inner sink's level on each
+// record, so lowering that level later still lets records through
+XLOG_TEST(isolated_sink_follows_the_inner_level) {
+    auto inner = std::make_shared<CaptureSink>();
+    inner->set_level(LogLevel::Warn);
+    auto logger = std::make_shared<Logger>("isolated");
+    SinkOptions options;
+    options.dedicated_worker = true;
+    logger->add_sink(inner, "inner", options);
+    logger->info("before");
+    inner->set_level(LogLevel::Debug);
+    logger->debug("after");
+    logger->flush().wait();
+    auto messages = inner->take();
+    XLOG_CHECK_EQ(messages.size(), 1u);
+    XLOG_CHECK_EQ(messages[0].first, std::string("after"));
+}
+
+// Disabled macros evaluate nothing; a deferrable() closure runs on the
+// worker of an async logger and on the caller of a sync one
+XLOG_TEST(lazy_messages_run_only_when_logged) {
+    int built = 0;
+    auto build = [&] {
+        ++built;
+        return std::string("built");
+    };
+
+    auto sink = std::make_shared<CaptureSink>();
+    auto sync = std::make_shared<Logger>("sync");
+    sync->add_sink(sink);
+    sync->set_level(LogLevel::Info);
+    XLOG_DEBUG(sync, build());
+    XLOG_DEBUG_LAZY(sync, build);
+    XLOG_DEBUG_DEFERRED(sync, "{}", build());
+    XLOG_CHECK_EQ(built, 0);
+    XLOG_INFO_LAZY(sync, build);
+    XLOG_CHECK_EQ(built, 1);
+
+    const int id = 42;
+    const double total = 9.5;
+    XLOG_INFO_LAZY(sync, deferrable([id, total] { return id + total > 50 ? "large" : "small"; }));
+    auto messages = sink->take();
+    XLOG_CHECK_EQ(messages.size(), 2u);
+    XLOG_CHECK_EQ(messages[1].first, std::string("large"));
+    XLOG_CHECK(messages[1].second == std::this_thread::get_id());
+
+    auto async = Logger::create_async("async", AsyncOptions{});
+    async->add_sink(sink);
+    async->set_level(LogLevel::Info);
+    XLOG_DEBUG_LAZY(async, deferrable([] { return "dropped"; }));
+    XLOG_INFO_LAZY(async, deferrable([id] { return id == 42 ? "on the worker" : "wrong"; }));
+    async->flush().wait();
+    messages = sink->take();
+    XLOG_CHECK_EQ(messages.size(), 1u);
+    XLOG_CHECK_EQ(messages[0].first, std::string("on the worker"));
+    XLOG_CHECK(messages[0].second != std::this_thread::get_id());
+}
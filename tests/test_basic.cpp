@@ -0,0 +1,454 @@
+// Allocations per log call on the synchronous path. Once a thread has
+// logged a few lines its buffers have grown to fit, and from then on a
+// call that reaches no sink, or any of the sinks below, allocates nothing.
+#include "test_harness.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/binary_log.hpp"
+#include "Zyrnix/buffer_memory.hpp"
+#include "Zyrnix/async/mpmc_ring.hpp"
+#include "Zyrnix/log_clock.hpp"
+#include "Zyrnix/log_filter.hpp"
+#include "Zyrnix/log_macros.hpp"
+#include "Zyrnix/static_logger.hpp"
+#include "Zyrnix/sinks/file_sink.hpp"
+#include "Zyrnix/sinks/null_sink.hpp"
+#ifndef _WIN32
+#include "Zyrnix/sinks/flight_recorder_sink.hpp"
+#endif
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+constexpr int warm_up = 100;
+constexpr int calls = 1000;
+
+const char* const line = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+// Logs calls lines after warm_up and returns this thread's allocations
+// across the measured calls
+template <class Call>
+uint64_t allocations_per_run(Call&& call) {
+    for (int i = 0; i < warm_up; ++i) {
+        call(i);
+    }
+    test::AllocationScope scope;
+    for (int i = 0; i < calls; ++i) {
+        call(i);
+    }
+    return scope.count();
+}
+
+// Counts the lines it is handed
+class CountingSink : public LogSink {
+public:
+    void log(const std::string&, LogLevel, const std::string&) override { ++count; }
+    size_t count = 0;
+};
+
+std::shared_ptr<Logger> null_logger() {
+    auto logger = std::make_shared<Logger>("test");
+    logger->add_sink(std::make_shared<NullSink>());
+    return logger;
+}
+
+}
+
+// The checks below would all pass if the counting operator new were not
+// linked in
+XLOG_TEST(allocation_counter_sees_this_thread) {
+    test::AllocationScope scope;
+    auto value = std::make_unique<int>(42);
+    XLOG_CHECK_EQ(scope.count(), 1u);
+    XLOG_CHECK_EQ(*value, 42);
+}
+
+XLOG_TEST(level_disabled_does_not_allocate) {
+    auto logger = null_logger();
+    logger->set_level(LogLevel::Info);
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->debug(line); }), 0u);
+#if XLOG_HAS_FMT
+    XLOG_CHECK_EQ(allocations_per_run([&](int i) { logger->debug("request {} status={} latency_ms={}", i, 200, 17.25); }), 0u);
+#endif
+}
+
+// The logger's level, the sink floor and the backtrace ring share one
+// word; each change must leave the others as they were
+XLOG_TEST(effective_level_follows_level_sinks_and_backtrace) {
+    auto logger = std::make_shared<Logger>("test");
+    logger->set_level(LogLevel::Info);
+    auto sink = std::make_shared<NullSink>();
+    sink->set_level(LogLevel::Warn);
+    logger->add_sink(sink);
+    XLOG_CHECK(logger->get_level() == LogLevel::Info);
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Warn);
+    logger->set_level(LogLevel::Error);
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Error);
+    logger->enable_backtrace(16);
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Warn);
+    XLOG_CHECK(logger->get_level() == LogLevel::Error);
+    logger->disable_backtrace();
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Error);
+    XLOG_CHECK(!logger->has_backtrace());
+}
+
+// A sink's own level may change after it was added; the floor follows
+XLOG_TEST(sink_set_level_after_add_moves_the_floor) {
+    auto logger = std::make_shared<Logger>("test");
+    logger->set_level(LogLevel::Trace);
+    auto sink = std::make_shared<CountingSink>();
+    sink->set_level(LogLevel::Warn);
+    logger->add_sink(sink);
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Warn);
+    sink->set_level(LogLevel::Debug);
+    logger->debug("debug");
+    logger->info("info");
+    logger->warn("warn");
+    XLOG_CHECK_EQ(sink->count, 3u);
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Debug);
+    sink->set_level(LogLevel::Error);
+    logger->warn("warn");
+    XLOG_CHECK_EQ(sink->count, 3u);
+    XLOG_CHECK(logger->get_effective_level() == LogLevel::Error);
+}
+
+#if XLOG_HAS_FMT
+// The macros skip log() below the effective level; an expired temporary
+// level must not keep them doing so
+XLOG_TEST(temporary_level_expires_under_macros) {
+    Logger logger("test");
+    logger.set_level(LogLevel::Info);
+    auto sink = std::make_shared<CountingSink>();
+    logger.add_sink(sink);
+    logger.set_level_temporary(LogLevel::Error, std::chrono::seconds(1));
+    // Until the deadline the raised level still keeps disabled calls cheap
+    int built = 0;
+    XLOG_INFO(&logger, "while raised {}", ++built);
+    XLOG_CHECK_EQ(built, 0);
+    XLOG_CHECK(logger.get_effective_level() == LogLevel::Error);
+    XLOG_CHECK_EQ(sink->count, 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    for (int i = 0; i < 10; ++i) {
+        XLOG_INFO(&logger, "line {}", i);
+    }
+    XLOG_CHECK_EQ(sink->count, 10u);
+    XLOG_CHECK(!logger.has_temporary_level());
+    XLOG_CHECK(logger.get_effective_level() == LogLevel::Info);
+}
+#endif
+
+XLOG_TEST(below_every_sink_does_not_allocate) {
+    auto logger = std::make_shared<Logger>("test");
+    auto sink = std::make_shared<NullSink>();
+    sink->set_level(LogLevel::Warn);
+    logger->add_sink(sink);
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+}
+
+XLOG_TEST(null_sink_does_not_allocate) {
+    auto logger = null_logger();
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+#if XLOG_HAS_FMT
+    XLOG_CHECK_EQ(allocations_per_run([&](int i) { logger->info("request {} status={} latency_ms={}", i, 200, 17.25); }), 0u);
+#endif
+}
+
+XLOG_TEST(buffered_file_sink_does_not_allocate) {
+    const auto path = std::filesystem::temp_directory_path() / "Zyrnix_test_basic.log";
+    std::filesystem::remove(path);
+    {
+        auto logger = std::make_shared<Logger>("test");
+        logger->add_sink(std::make_shared<FileSink>(path.string()));
+        XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+#if XLOG_HAS_FMT
+        XLOG_CHECK_EQ(allocations_per_run([&](int i) { logger->info("request {} status={} latency_ms={}", i, 200, 17.25); }), 0u);
+#endif
+        logger->flush().wait();
+    }
+    XLOG_CHECK(std::filesystem::file_size(path) > 0);
+    std::filesystem::remove(path);
+}
+
+// Each layout renders into a buffer the thread keeps, and so does a plain
+// log() call on a sink
+XLOG_TEST(sinks_of_several_layouts_do_not_allocate) {
+    const auto path = std::filesystem::temp_directory_path() / "Zyrnix_test_layouts.log";
+    std::filesystem::remove(path);
+    {
+        auto logger = std::make_shared<Logger>("test");
+        auto full = std::make_shared<FileSink>(path.string());
+        auto brief = std::make_shared<FileSink>(path.string() + ".brief");
+        brief->set_pattern("%l %v");
+        logger->add_sink(full);
+        logger->add_sink(brief);
+        XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+        const std::string name = "direct";
+        const std::string message = line;
+        XLOG_CHECK_EQ(allocations_per_run([&](int) { brief->log(name, LogLevel::Info, message); }), 0u);
+        logger->flush().wait();
+    }
+    XLOG_CHECK(RenderCache::high_water_bytes() >= std::char_traits<char>::length(line));
+    XLOG_CHECK(std::filesystem::file_size(path.string() + ".brief") > 0);
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + ".brief");
+}
+
+// A flipped size byte in one header costs that block only
+XLOG_TEST(binary_log_skips_block_with_damaged_size) {
+    binlog::BlockWriter writer;
+    std::string file(binlog::file_magic, sizeof(binlog::file_magic));
+    for (int i = 0; i < 3; ++i) {
+        writer.add(std::chrono::system_clock::now(), LogLevel::Info, 1, "test", nullptr,
+                   "block " + std::to_string(i));
+        writer.finish(file);
+    }
+    size_t damaged = 0;
+    XLOG_CHECK_EQ(binlog::scan_blocks(file, &damaged).size(), 3u);
+    XLOG_CHECK_EQ(damaged, 0u);
+
+    file[sizeof(binlog::file_magic) + 7] = '\x7F';  // High byte of the first block's size
+    const auto blocks = binlog::scan_blocks(file, &damaged);
+    XLOG_CHECK_EQ(damaged, 1u);
+    std::vector<std::string> messages;
+    for (const auto& block : blocks) {
+        XLOG_CHECK(binlog::decode_block(file, block, [&](const binlog::DecodedRecord& record) {
+            messages.emplace_back(record.message);
+        }));
+    }
+    XLOG_CHECK_EQ(messages.size(), 2u);
+    XLOG_CHECK_EQ(messages.back(), std::string("block 2"));
+}
+
+#ifndef _WIN32
+// Copied into the mapping, and read back oldest first once the ring has
+// lapped
+XLOG_TEST(flight_recorder_sink_does_not_allocate) {
+    const auto path = std::filesystem::temp_directory_path() / "Zyrnix_test_basic.flight";
+    std::filesystem::remove(path);
+    {
+        auto logger = std::make_shared<Logger>("test");
+        logger->add_sink(std::make_shared<FlightRecorderSink>(path.string(), FlightRecorderOptions{64 * 1024}));
+        XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+        logger->info("last");
+    }
+    flight::Reader reader(path.string());
+    XLOG_CHECK(reader.is_open());
+    std::string last;
+    const size_t records = reader.read([&](const flight::Record& record) { last = record.message; });
+    XLOG_CHECK(records > 0 && records < static_cast<size_t>(warm_up + calls));
+    XLOG_CHECK_EQ(reader.damaged(), 0u);
+    XLOG_CHECK_EQ(last, std::string("last"));
+    std::filesystem::remove(path);
+}
+#endif
+
+// Configured, but with nothing in the line to redact: the line goes out
+// unchanged without a copy
+XLOG_TEST(redaction_without_a_match_does_not_allocate) {
+    auto logger = null_logger();
+    logger->set_redact_patterns({"password", "api_key", "secret"});
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+}
+
+#ifndef XLOG_NO_FILTERS
+// Decided in the first stage, on the caller's strings, so no record is built
+XLOG_TEST(stage_one_filter_does_not_allocate) {
+    auto logger = null_logger();
+    logger->add_filter(std::make_shared<LevelFilter>(LogLevel::Info));
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->debug(line); }), 0u);
+}
+#endif
+
+// Keeps the last line in a buffer that has grown to fit
+struct LastLineSink {
+    void write(LogLevel, std::string_view text) {
+        last.assign(text);
+        ++lines;
+    }
+    std::string last;
+    int lines = 0;
+};
+
+// Rendered by the compiled pattern and handed to both sinks by direct calls
+XLOG_TEST(static_logger_does_not_allocate) {
+    StaticLogger<StaticPattern<"[%l] %n: %v">, LastLineSink, NullSink> logger("static");
+    XLOG_CHECK_EQ(allocations_per_run([&](int) { logger.info(line); }), 0u);
+#if XLOG_HAS_FMT
+    XLOG_CHECK_EQ(allocations_per_run([&](int i) { XLOG_INFO(&logger, "request {} status={}", i, 200); }), 0u);
+#endif
+    auto& sink = logger.sink<LastLineSink>();
+    XLOG_CHECK_EQ(sink.lines, 2 * (warm_up + calls));
+
+    logger.set_level(LogLevel::Warn);
+    XLOG_INFO(&logger, "dropped");
+    XLOG_CHECK_EQ(sink.lines, 2 * (warm_up + calls));
+    XLOG_ERROR(&logger, "disk full");
+    XLOG_CHECK_EQ(sink.last, std::string("[ERROR] static: disk full\n"));
+}
+
+namespace {
+
+// Keeps the messages and the size of every batch it is handed
+class BatchRecorder : public LogSink {
+public:
+    void log(const std::string&, LogLevel, const std::string& message) override {
+        messages.push_back(message);
+        batches.push_back(1);
+    }
+    void log_batch(std::span<const FormattedRecord> records) override {
+        for (const auto& record : records) {
+            messages.emplace_back(record.message());
+            XLOG_CHECK_EQ(std::string(record.logger_name()), std::string("importer"));
+        }
+        batches.push_back(records.size());
+    }
+
+    std::vector<std::string> messages;
+    std::vector<size_t> batches;
+};
+
+std::vector<LogRecord> import_records(size_t count) {
+    std::vector<LogRecord> records(count);
+    for (size_t k = 0; k < count; ++k) {
+        records[k].level = k % 4 == 0 ? LogLevel::Debug : LogLevel::Info;
+        records[k].message = "row " + std::to_string(k);
+    }
+    return records;
+}
+
+}
+
+// One call, one batch per sink; below the level is left out, and the
+// queue keeps the order through a capacity far smaller than the batch
+XLOG_TEST(log_batch_reaches_sinks_as_one_batch) {
+    auto recorder = std::make_shared<BatchRecorder>();
+    auto logger = std::make_shared<Logger>("importer");
+    logger->set_level(LogLevel::Info);
+    logger->add_sink(recorder);
+    auto records = import_records(40);
+    XLOG_CHECK_EQ(logger->log_batch(records), 30u);
+    XLOG_CHECK_EQ(recorder->batches.size(), 1u);
+    XLOG_CHECK_EQ(recorder->messages.size(), 30u);
+    XLOG_CHECK_EQ(recorder->messages[0], std::string("row 1"));
+
+    for (QueueBackend backend : {QueueBackend::Mutex, QueueBackend::LockFreeRing, QueueBackend::PerThreadLanes}) {
+        auto queued = std::make_shared<BatchRecorder>();
+        auto async = std::make_shared<Logger>("importer");
+        async->set_level(LogLevel::Info);
+        async->add_sink(queued);
+        AsyncOptions options;
+        options.backend = backend;
+        options.queue_capacity = 64;
+        options.lane_capacity = 64;
+        options.block_timeout_ms = 5000;
+        async->enable_async(options);
+        auto rows = import_records(4000);
+        XLOG_CHECK_EQ(async->log_batch(rows), 3000u);
+        async->flush().get();
+        XLOG_CHECK_EQ(queued->messages.size(), 3000u);
+        bool in_order = true;
+        for (size_t k = 0; k < queued->messages.size(); ++k) {
+            in_order = in_order && queued->messages[k] == "row " + std::to_string(k + k / 3 + 1);
+        }
+        XLOG_CHECK(in_order);
+    }
+}
+
+namespace {
+
+// Keeps each record's rendering and whether it carried a stack
+class StackRecorder : public LogSink {
+public:
+    void log(const std::string&, LogLevel, const std::string& message) override { lines.push_back(message); }
+    void log_record(const FormattedRecord& record) override {
+        lines.push_back(record.formatted(formatter));
+        stacks.push_back(record.stack() != nullptr);
+    }
+
+    std::vector<std::string> lines;
+    std::vector<bool> stacks;
+};
+
+}
+
+// Errors carry the stack, rendered under the line; the second one from
+// the same place finds its frames in the SymbolCache
+XLOG_TEST(error_records_carry_stack_traces) {
+    auto recorder = std::make_shared<StackRecorder>();
+    auto logger = std::make_shared<Logger>("payments");
+    logger->add_sink(recorder);
+    logger->enable_stack_traces(LogLevel::Error, 16);
+    for (int i = 0; i < 2; ++i) {
+        logger->info("charging card");
+        logger->error("card declined");
+    }
+    logger->disable_stack_traces();
+    logger->error("card declined");
+
+    XLOG_CHECK_EQ(recorder->lines.size(), 5u);
+    XLOG_CHECK(!recorder->stacks[0]);
+    XLOG_CHECK(recorder->stacks[1]);
+    XLOG_CHECK(!recorder->stacks[4]);
+    XLOG_CHECK(recorder->lines[1].find("card declined\n    #0 0x") != std::string::npos);
+    XLOG_CHECK_EQ(recorder->lines[3].substr(recorder->lines[3].find('\n')),
+                  recorder->lines[1].substr(recorder->lines[1].find('\n')));
+    XLOG_CHECK(SymbolCache::instance().get_stats().hits > 0);
+}
+
+#ifdef __linux__
+// With huge pages asked for, a ring or a bounded queue is mapped on
+// MAP_HUGETLB or advised THP pages, and unmapped with it; small rings
+// stay on the heap
+XLOG_TEST(rings_use_buffer_memory) {
+    const BufferMemoryStats before = get_buffer_memory_stats();
+    BufferMemory memory;
+    memory.huge_pages = true;
+    memory.prefault = true;
+    set_buffer_memory(memory);
+    {
+        MpmcRing<LogRecord> small(4);
+        XLOG_CHECK_EQ(get_buffer_memory_stats().mapped_bytes, before.mapped_bytes);
+
+        MpmcRing<LogRecord> ring(8192);
+        const BufferMemoryStats stats = get_buffer_memory_stats();
+        XLOG_CHECK(stats.mapped_bytes >= before.mapped_bytes + 8192 * sizeof(LogRecord));
+        XLOG_CHECK(stats.huge_page_bytes > before.huge_page_bytes);
+        LogRecord record;
+        record.message = "queued";
+        XLOG_CHECK(ring.try_push(std::move(record)));
+        LogRecord out;
+        XLOG_CHECK(ring.try_pop(out));
+        XLOG_CHECK_EQ(out.message, std::string("queued"));
+
+        // The Mutex backend's slots, made at full capacity
+        const uint64_t mapped = get_buffer_memory_stats().mapped_bytes;
+        AsyncQueueOptions options;
+        options.capacity = 8192;
+        AsyncQueue queue(options);
+        XLOG_CHECK(get_buffer_memory_stats().mapped_bytes >= mapped + 8192 * sizeof(LogRecord));
+    }
+    set_buffer_memory(BufferMemory{});
+    XLOG_CHECK_EQ(get_buffer_memory_stats().mapped_bytes, before.mapped_bytes);
+}
+#endif
+
+// Every source stays within a few ms of system_clock, and while the
+// logger stamps with it a line still costs no allocation
+XLOG_TEST(log_clock_sources_track_the_wall_clock) {
+    auto logger = null_logger();
+    for (ClockSource source : {ClockSource::Coarse, ClockSource::Tsc, ClockSource::Precise}) {
+        LogClock::set_source(source);
+        for (int i = 0; i < 3; ++i) {
+            const auto skew = LogClock::now() - std::chrono::system_clock::now();
+            XLOG_CHECK(skew < std::chrono::milliseconds(20) && skew > -std::chrono::milliseconds(20));
+        }
+        XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+    }
+    XLOG_CHECK(LogClock::source() == ClockSource::Precise);
+}
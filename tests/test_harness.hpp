@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Minimal test registry for the tests executable
+ *
+ * XLOG_TEST(name) { ... } registers a test; test_main.cpp runs them all,
+ * or those whose name contains argv[1], and exits non-zero if any check
+ * failed. A failed check is reported and the test carries on.
+ *
+ * test_main.cpp also replaces the global operator new, so a test can
+ * count the heap allocations made by this thread (thread_allocations())
+ * or by the whole process (total_allocations()) across some calls.
+ */
+namespace Zyrnix::test {
+
+using TestFn = void (*)();
+
+struct Register {
+    Register(const char* name, TestFn fn);
+};
+
+void fail(const char* file, int line, const std::string& what);
+
+uint64_t thread_allocations();
+uint64_t total_allocations();
+
+// Allocations made on this thread while it is alive
+class AllocationScope {
+public:
+    AllocationScope() : start_(thread_allocations()) {}
+    uint64_t count() const { return thread_allocations() - start_; }
+
+private:
+    uint64_t start_;
+};
+
+template <class A, class B>
+void check_eq(const A& a, const B& b, const char* expr_a, const char* expr_b, const char* file, int line) {
+    if (!(a == b)) {
+        std::ostringstream what;
+        what << expr_a << " == " << expr_b << " (" << a << " vs " << b << ")";
+        fail(file, line, what.str());
+    }
+}
+
+}
+
+#define XLOG_TEST(name)                                                              \
+    static void name();                                                              \
+    static const ::Zyrnix::test::Register name##_registration(#name, &name);         \
+    static void name()
+
+#define XLOG_CHECK(cond)                                                             \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            ::Zyrnix::test::fail(__FILE__, __LINE__, #cond);                         \
+        }                                                                            \
+    } while (0)
+
+#define XLOG_CHECK_EQ(a, b) ::Zyrnix::test::check_eq((a), (b), #a, #b, __FILE__, __LINE__)
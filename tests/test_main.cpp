@@ -1,7 +1,81 @@
-// Minimal test main used for local sanitizer/fuzz runs
+// Runs every XLOG_TEST, or those whose name contains argv[1]
+#include "test_harness.hpp"
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <new>
+#include <string_view>
+#include <vector>
 
-int main() {
-    std::cout << "Zyrnix test stub running\n";
-    return 0;
+namespace {
+
+std::atomic<uint64_t> process_allocations{0};
+thread_local uint64_t this_thread_allocations = 0;
+
+struct TestCase {
+    const char* name;
+    Zyrnix::test::TestFn fn;
+};
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+int failures = 0;
+
+}
+
+// Every heap allocation in the process goes through here; new[] and the
+// nothrow forms forward to it
+void* operator new(std::size_t size) {
+    process_allocations.fetch_add(1, std::memory_order_relaxed);
+    ++this_thread_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace Zyrnix::test {
+
+Register::Register(const char* name, TestFn fn) {
+    registry().push_back({name, fn});
+}
+
+void fail(const char* file, int line, const std::string& what) {
+    ++failures;
+    std::cerr << "  " << file << ":" << line << ": check failed: " << what << "\n";
+}
+
+uint64_t thread_allocations() {
+    return this_thread_allocations;
+}
+
+uint64_t total_allocations() {
+    return process_allocations.load(std::memory_order_relaxed);
+}
+
+}
+
+int main(int argc, char** argv) {
+    const std::string_view only = argc > 1 ? argv[1] : "";
+    int run = 0;
+    int failed = 0;
+    for (const auto& test : registry()) {
+        if (std::string_view(test.name).find(only) == std::string_view::npos) {
+            continue;
+        }
+        const int before = failures;
+        test.fn();
+        ++run;
+        const bool ok = failures == before;
+        failed += ok ? 0 : 1;
+        std::cout << (ok ? "[ OK   ] " : "[ FAIL ] ") << test.name << "\n";
+    }
+    std::cout << run - failed << "/" << run << " tests passed\n";
+    return failed == 0 && run > 0 ? 0 : 1;
 }
@@ -0,0 +1,108 @@
+// RotatingFileSink: files left parked by a dead process are shifted in
+// when the file is opened, and every rotated file gets a sidecar index.
+#include "test_harness.hpp"
+#ifndef XLOG_NO_FILE_ROTATION
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/log_sidecar.hpp"
+#include "Zyrnix/sinks/rotating_file_sink.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+using namespace Zyrnix;
+
+namespace {
+
+const char* const line = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+}
+
+// Files parked by a process that died before its renamer ran are shifted
+// in, oldest first, when the file is next opened
+XLOG_TEST(rotating_file_sink_shifts_in_files_left_parked) {
+    const auto base = (std::filesystem::temp_directory_path() / "Zyrnix_test_parked").string();
+    auto read = [](const std::string& path) {
+        std::ifstream in(path);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    auto remove_all = [&] {
+        for (const char* suffix : {".log", ".0.log", ".1.log", ".2.log", ".rotating-100-0.log", ".rotating-200-1.log"}) {
+            std::filesystem::remove(base + suffix);
+        }
+    };
+    remove_all();
+    std::ofstream(base + ".0.log") << "oldest\n";
+    std::ofstream(base + ".rotating-200-1.log") << "newest\n";
+    std::ofstream(base + ".rotating-100-0.log") << "middle\n";
+    {
+        RotatingFileSink sink(base, 0, 5);
+    }
+    XLOG_CHECK_EQ(read(base + ".0.log"), std::string("newest\n"));
+    XLOG_CHECK_EQ(read(base + ".1.log"), std::string("middle\n"));
+    XLOG_CHECK_EQ(read(base + ".2.log"), std::string("oldest\n"));
+    XLOG_CHECK(!std::filesystem::exists(base + ".rotating-100-0.log"));
+    XLOG_CHECK(!std::filesystem::exists(base + ".rotating-200-1.log"));
+    remove_all();
+}
+
+// Every rotated file gets an index that never rules out a value it holds
+// and does rule out the ones it does not; the open file's is written on
+// close and describes it exactly
+XLOG_TEST(rotated_files_get_sidecars) {
+    const auto base = (std::filesystem::temp_directory_path() / "Zyrnix_test_sidecar").string();
+    auto name = [&](int i) { return i < 0 ? base + ".log" : base + "." + std::to_string(i) + ".log"; };
+    auto remove_all = [&] {
+        for (int i = -1; i <= 20; ++i) {
+            std::filesystem::remove(name(i));
+            std::filesystem::remove(name(i) + ".meta");
+        }
+    };
+    remove_all();
+    {
+        RotationOptions rotation;
+        rotation.max_size = 4096;
+        rotation.max_files = 20;
+        rotation.sidecar.enabled = true;
+        rotation.sidecar.bloom_fields = {"trace_id", "user_id"};
+        rotation.sidecar.expected_values = 1000;
+        auto sink = std::make_shared<RotatingFileSink>(base, rotation);
+        sink->set_pattern("%v");
+        auto logger = std::make_shared<Logger>("test");
+        logger->add_sink(sink);
+        for (int user = 1; user <= 3; ++user) {
+            for (int i = 0; i < 100; ++i) {
+                logger->info("user=" + std::to_string(user) + " " + line, kv("user_id", user));
+            }
+        }
+    }
+
+    size_t indexed = 0;
+    size_t ruled_out = 0;
+    uint64_t records = 0;
+    for (int i = -1; i <= 20; ++i) {
+        if (!std::filesystem::exists(name(i))) continue;
+        const auto index = sidecar::Index::read(name(i) + ".meta");
+        XLOG_CHECK(index.has_value());
+        if (!index) continue;
+        ++indexed;
+        XLOG_CHECK_EQ(index->data_size, std::filesystem::file_size(name(i)));
+        XLOG_CHECK(index->min_ns <= index->max_ns);
+        records += index->level_counts[static_cast<size_t>(LogLevel::Info)];
+        std::ifstream in(name(i));
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        for (int user = 1; user <= 3; ++user) {
+            const bool present = text.find("user=" + std::to_string(user) + " ") != std::string::npos;
+            const bool may = index->may_contain("user_id", std::to_string(user));
+            XLOG_CHECK(may || !present);
+            ruled_out += may ? 0 : 1;
+        }
+        XLOG_CHECK(index->may_contain("request_id", "anything"));  // Not indexed
+    }
+    XLOG_CHECK(indexed > 3);
+    XLOG_CHECK(ruled_out > 0);
+    XLOG_CHECK_EQ(records, 300u);
+    remove_all();
+}
+#endif
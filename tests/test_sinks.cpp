@@ -0,0 +1,244 @@
+// SharedFileSink, RecentLogSink and ParquetSink: a shared file keeps
+// lines whole across processes, the recent-log ring answers queries and
+// Parquet files come out finished.
+#include "test_harness.hpp"
+#include "Zyrnix/logger.hpp"
+#include "Zyrnix/sinks/parquet_sink.hpp"
+#include "Zyrnix/sinks/recent_log_sink.hpp"
+#ifndef _WIN32
+#include "Zyrnix/sinks/shared_file_sink.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+constexpr int warm_up = 100;
+constexpr int calls = 1000;
+
+const char* const line = "request completed status=200 latency_ms=17 path=/api/v1/orders/8812";
+
+// Logs calls lines after warm_up and returns this thread's allocations
+// across the measured calls
+template <class Call>
+uint64_t allocations_per_run(Call&& call) {
+    for (int i = 0; i < warm_up; ++i) {
+        call(i);
+    }
+    test::AllocationScope scope;
+    for (int i = 0; i < calls; ++i) {
+        call(i);
+    }
+    return scope.count();
+}
+
+}
+
+#ifndef _WIN32
+// One writev() per record straight from the formatted line
+XLOG_TEST(shared_file_sink_does_not_allocate) {
+    const auto base = std::filesystem::temp_directory_path() / "Zyrnix_test_shared";
+    const std::string path = base.string() + ".log";
+    std::filesystem::remove(path);
+    {
+        auto logger = std::make_shared<Logger>("test");
+        auto sink = std::make_shared<SharedFileSink>(base.string());
+        XLOG_CHECK(sink->is_open());
+        logger->add_sink(sink);
+        XLOG_CHECK_EQ(allocations_per_run([&](int) { logger->info(line); }), 0u);
+        XLOG_CHECK_EQ(sink->write_errors(), 0u);
+    }
+    XLOG_CHECK(std::filesystem::file_size(path) > 0);
+    std::filesystem::remove(path);
+}
+
+// Children of one parent share the sink opened before fork() and rotate
+// the file under each other; every line must come out whole, once
+XLOG_TEST(shared_file_sink_keeps_lines_whole_across_processes) {
+    constexpr int children = 3;
+    constexpr int per_child = 400;
+    constexpr size_t max_files = 100;
+    const auto base = std::filesystem::temp_directory_path() / "Zyrnix_test_shared_fork";
+    auto file = [&](size_t i) { return base.string() + "." + std::to_string(i) + ".log"; };
+    auto remove_all = [&] {
+        std::filesystem::remove(base.string() + ".log");
+        std::filesystem::remove(base.string() + ".lock");
+        for (size_t i = 0; i <= max_files; ++i) {
+            std::filesystem::remove(file(i));
+        }
+    };
+    remove_all();
+
+    SharedFileOptions options;
+    options.max_size = 16 * 1024;
+    options.max_files = max_files;
+    auto sink = std::make_shared<SharedFileSink>(base.string(), options);
+    sink->set_pattern("%v");
+    std::vector<pid_t> pids;
+    for (int child = 0; child < children; ++child) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            {
+                auto logger = std::make_shared<Logger>("test");
+                logger->add_sink(sink);
+                for (int i = 0; i < per_child; ++i) {
+                    logger->info("child=" + std::to_string(child) + " seq=" + std::to_string(i) + " " + line);
+                }
+            }
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+    for (pid_t pid : pids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        XLOG_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    std::vector<std::vector<int>> seen(children, std::vector<int>(per_child, 0));
+    size_t lines = 0;
+    size_t files = 0;
+    auto read = [&](const std::string& name) {
+        std::ifstream in(name);
+        if (!in) return;
+        ++files;
+        std::string text;
+        while (std::getline(in, text)) {
+            ++lines;
+            int child = -1;
+            int seq = -1;
+            int consumed = 0;
+            if (std::sscanf(text.c_str(), "child=%d seq=%d %n", &child, &seq, &consumed) == 2 &&
+                child >= 0 && child < children && seq >= 0 && seq < per_child &&
+                text.compare(static_cast<size_t>(consumed), std::string::npos, line) == 0) {
+                ++seen[child][seq];
+            }
+        }
+    };
+    read(base.string() + ".log");
+    for (size_t i = 0; i <= max_files; ++i) {
+        read(file(i));
+    }
+    XLOG_CHECK_EQ(lines, static_cast<size_t>(children * per_child));
+    XLOG_CHECK(files > 1);
+    bool each_once = true;
+    for (const auto& counts : seen) {
+        for (int count : counts) {
+            each_once = each_once && count == 1;
+        }
+    }
+    XLOG_CHECK(each_once);
+    remove_all();
+}
+#endif
+
+// Blocks are skipped by their index, the oldest are evicted, and the
+// newest matches come back oldest first
+XLOG_TEST(recent_log_sink_answers_queries) {
+    RecentLogOptions options;
+    options.block_bytes = 1024;
+    options.max_bytes = 16 * 1024;
+    auto recent = std::make_shared<RecentLogSink>(options);
+    auto logger = std::make_shared<Logger>("api");
+    logger->set_level(LogLevel::Trace);
+    logger->add_sink(recent);
+    for (int i = 0; i < 2000; ++i) {
+        logger->debug(line, kv("seq", i), kv("user", i % 10));
+    }
+    logger->error("payment declined", kv("user", 7), kv("code", "card_expired"));
+    logger->info("request timeout", kv("user", 7));
+
+    XLOG_CHECK(recent->evicted() > 0);
+    XLOG_CHECK(recent->size_bytes() <= options.max_bytes);
+
+    RecentLogQuery errors;
+    errors.min_level = LogLevel::Error;
+    const RecentLogResult result = recent->query(errors);
+    XLOG_CHECK_EQ(result.records.size(), 1u);
+    XLOG_CHECK_EQ(result.records[0].message, std::string("payment declined"));
+    XLOG_CHECK_EQ(result.blocks_scanned, 1u);
+    XLOG_CHECK(result.blocks_skipped > 0);
+
+    RecentLogQuery user;
+    std::string error;
+    XLOG_CHECK(RecentLogQuery::parse("field.user=7&contains=e&limit=3", user, error));
+    const RecentLogResult last = recent->query(user);
+    XLOG_CHECK_EQ(last.records.size(), 3u);
+    XLOG_CHECK(last.truncated);
+    XLOG_CHECK_EQ(last.records[1].message, std::string("payment declined"));
+    XLOG_CHECK_EQ(last.records[2].message, std::string("request timeout"));
+    XLOG_CHECK_EQ(last.records[0].fields[0].second.text(), std::string("1997"));
+
+    const std::string json = handle_recent_logs_request(*recent, "level=error&logger=api");
+    XLOG_CHECK(json.find("\"message\":\"payment declined\"") != std::string::npos);
+    XLOG_CHECK(json.find("\"code\":\"card_expired\"") != std::string::npos);
+    XLOG_CHECK(handle_recent_logs_request(*recent, "levle=error").starts_with("{\"error\":"));
+
+    // A query sees the open block without sealing it, so polling does
+    // not cut the ring into small blocks
+    RecentLogQuery polls;
+    polls.contains = "poll";
+    size_t first_blocks = 0;
+    size_t blocks = 0;
+    for (size_t i = 1; i <= 5; ++i) {
+        logger->info("poll");
+        const RecentLogResult polled = recent->query(polls);
+        XLOG_CHECK_EQ(polled.records.size(), i);
+        blocks = polled.blocks_scanned + polled.blocks_skipped;
+        first_blocks = i == 1 ? blocks : first_blocks;
+    }
+    XLOG_CHECK(blocks <= first_blocks + 1);
+}
+
+// Rotation and destruction each leave one finished file: PAR1 at both
+// ends and a footer that says how many rows it holds
+XLOG_TEST(parquet_sink_finishes_files) {
+    const auto dir = std::filesystem::temp_directory_path() / "Zyrnix_test_parquet";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    {
+        ParquetOptions options;
+        options.schema.fields = {{"user", FieldType::Integer}, {"region", FieldType::String}};
+        options.row_group_rows = 100;
+        options.page_rows = 32;
+        auto sink = std::make_shared<ParquetSink>((dir / "app").string(), options);
+        auto logger = std::make_shared<Logger>("test");
+        logger->add_sink(sink);
+        for (int i = 0; i < 250; ++i) {
+            logger->info(line, kv("user", i), kv("region", i % 2 ? "eu" : "us"));
+        }
+        sink->rotate();
+        XLOG_CHECK_EQ(sink->files_written(), 1u);
+        XLOG_CHECK_EQ(sink->rows_written(), 250u);
+        logger->warn("after rotation", kv("user", "not a number"));
+        XLOG_CHECK_EQ(sink->write_errors(), 0u);
+    }
+
+    size_t files = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        XLOG_CHECK_EQ(entry.path().extension().string(), std::string(".parquet"));
+        std::ifstream in(entry.path(), std::ios::binary);
+        const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        XLOG_CHECK(data.size() > 12);
+        XLOG_CHECK_EQ(data.substr(0, 4), std::string("PAR1"));
+        XLOG_CHECK_EQ(data.substr(data.size() - 4), std::string("PAR1"));
+        uint32_t footer = 0;
+        for (int i = 0; i < 4; ++i) {
+            footer |= static_cast<uint32_t>(static_cast<uint8_t>(data[data.size() - 8 + i])) << (8 * i);
+        }
+        XLOG_CHECK(footer > 0 && footer < data.size() - 12);
+        XLOG_CHECK(data.find("Zyrnix version", data.size() - 8 - footer) != std::string::npos);
+        ++files;
+    }
+    XLOG_CHECK_EQ(files, 2u);
+    std::filesystem::remove_all(dir);
+}
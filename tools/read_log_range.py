@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+read_log_range.py - Extract a time range from a seekable compressed log.
+
+CompressedFileSink with CompressionOptions::seekable writes each file as a
+series of independent gzip members or zstd frames, plus <file>.idx with one
+line per frame: byte offset, length, and the first and last record time in
+milliseconds since the epoch. This script reads the index and decompresses
+only the frames that overlap the requested range, so a ten-minute window of
+a multi-GB archive costs a few frames, not the whole file.
+
+Output is frame-granular: every line of a matching frame is printed, so
+expect up to one frame of lines either side of the range.
+
+Usage:
+    python tools/read_log_range.py app.log.3.gz --from "2026-10-14 11:00" --to "2026-10-14 11:10"
+    python tools/read_log_range.py app.log.zst --from 1791975600000 --to 1791976200000
+    python tools/read_log_range.py app.log.2.zst --from ... --dict app.log.1283061803.dict
+    python tools/read_log_range.py app.log.1.gz --list
+
+Zstd frames need the `zstandard` module or the `zstd` command on PATH.
+"""
+
+import argparse
+import shutil
+import subprocess
+import sys
+import zlib
+from dataclasses import dataclass
+from datetime import datetime
+from pathlib import Path
+from typing import List, Optional
+
+
+@dataclass
+class Frame:
+    """One index entry."""
+    offset: int
+    length: int
+    first_ms: int
+    last_ms: int
+
+
+def parse_time(text: str) -> int:
+    """Epoch milliseconds, or a local 'YYYY-MM-DD HH:MM[:SS]' time."""
+    if text.isdigit():
+        return int(text)
+    for layout in ("%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d"):
+        try:
+            return int(datetime.strptime(text, layout).timestamp() * 1000)
+        except ValueError:
+            continue
+    raise argparse.ArgumentTypeError(f"Unrecognized time: {text}")
+
+
+def read_index(path: Path) -> List[Frame]:
+    """Parse <archive>.idx, skipping a torn last line."""
+    frames = []
+    for line in path.read_text().splitlines():
+        parts = line.split()
+        if len(parts) != 4:
+            continue
+        try:
+            frames.append(Frame(*(int(p) for p in parts)))
+        except ValueError:
+            continue
+    return frames
+
+
+def decompress_gzip(data: bytes) -> bytes:
+    # 31: expect a gzip header; one member per frame
+    return zlib.decompressobj(31).decompress(data)
+
+
+def decompress_zstd(data: bytes, dictionary: Optional[Path]) -> bytes:
+    try:
+        import zstandard
+        dict_data = zstandard.ZstdCompressionDict(dictionary.read_bytes()) if dictionary else None
+        return zstandard.ZstdDecompressor(dict_data=dict_data).decompressobj().decompress(data)
+    except ImportError:
+        pass
+    zstd = shutil.which("zstd")
+    if not zstd:
+        sys.exit("error: zstd frames need the zstandard module or the zstd command")
+    command = [zstd, "-q", "-d", "-c"]
+    if dictionary:
+        command += ["-D", str(dictionary)]
+    return subprocess.run(command, input=data, stdout=subprocess.PIPE, check=True).stdout
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Extract a time range from a seekable compressed log")
+    parser.add_argument("archive", type=Path, help="A .gz or .zst file written with seekable = true")
+    parser.add_argument("--from", dest="start", type=parse_time, help="Start of the range")
+    parser.add_argument("--to", dest="end", type=parse_time, help="End of the range")
+    parser.add_argument("--dict", type=Path, help="Zstd dictionary the archive was written with")
+    parser.add_argument("--list", action="store_true", help="Print the index instead")
+    args = parser.parse_args()
+
+    index_path = Path(str(args.archive) + ".idx")
+    if not index_path.exists():
+        sys.exit(f"error: no index {index_path}; was the file written with seekable = true?")
+    frames = read_index(index_path)
+
+    if args.list:
+        for frame in frames:
+            first = datetime.fromtimestamp(frame.first_ms / 1000).isoformat(sep=" ", timespec="milliseconds")
+            last = datetime.fromtimestamp(frame.last_ms / 1000).isoformat(sep=" ", timespec="milliseconds")
+            print(f"{frame.offset:>12} {frame.length:>10}  {first}  {last}")
+        return 0
+
+    start = args.start if args.start is not None else 0
+    end = args.end if args.end is not None else 2**63 - 1
+    is_zstd = args.archive.suffix == ".zst"
+    out = sys.stdout.buffer
+    with args.archive.open("rb") as archive:
+        for frame in frames:
+            if frame.last_ms < start or frame.first_ms > end:
+                continue
+            archive.seek(frame.offset)
+            data = archive.read(frame.length)
+            out.write(decompress_zstd(data, args.dict) if is_zstd else decompress_gzip(data))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+search_logs.py - Find records across many rotated logs, skipping files by their sidecars.
+
+RotatingFileSink and CompressedFileSink with SidecarOptions::enabled leave
+<file>.meta beside each finished file: its first and last record time, a
+count of records per level and a Bloom filter over the values of chosen
+fields (trace_id, user_id, ...). This script reads the sidecars first and
+opens only the files that can hold a match, so looking for one trace id in
+500 rotated files usually decompresses one or two of them. Files without a
+sidecar, or with one that does not describe them any more, are searched in
+full.
+
+The files left are searched line by line: a line matches when it contains
+every --field value and the --text. The sidecar rules files out exactly;
+the line filter is a substring match on the rendered text, so a value must
+appear in the layout (e.g. through %x or a JSON layout) to be found.
+
+Usage:
+    python tools/search_logs.py /var/log/app/app.*.log* --field trace_id=4bf92f3577b34da6a3ce929d0e0e4736
+    python tools/search_logs.py app.*.gz --field user_id=42 --level error --from "2026-10-14 11:00"
+    python tools/search_logs.py app.*.log --field user_id=42 --list
+
+Zstd files need the `zstandard` module or the `zstd` command on PATH.
+"""
+
+import argparse
+import gzip
+import shutil
+import struct
+import subprocess
+import sys
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Iterator, List, Optional, Tuple
+
+from read_log_range import parse_time
+
+MAGIC = b"ZYRNIXS1"
+LEVELS = ["trace", "debug", "info", "warn", "error", "critical"]
+
+FNV_OFFSET = 14695981039346656037
+FNV_PRIME = 1099511628211
+MASK64 = (1 << 64) - 1
+
+
+def fnv1a(data: bytes) -> int:
+    h = FNV_OFFSET
+    for byte in data:
+        h = ((h ^ byte) * FNV_PRIME) & MASK64
+    return h
+
+
+@dataclass
+class Sidecar:
+    """One <file>.meta, as log_sidecar.hpp lays it out."""
+    data_size: int
+    min_ns: int
+    max_ns: int
+    records: int
+    level_counts: List[int]
+    keys: List[str] = field(default_factory=list)
+    hash_count: int = 0
+    bit_count: int = 0
+    bits: bytes = b""
+
+    def may_contain(self, key: str, value: str) -> bool:
+        if key not in self.keys or self.bit_count == 0:
+            return True
+        h = fnv1a(key.encode() + b"=" + value.encode())
+        h1 = h & 0xFFFFFFFF
+        h2 = (h >> 32) | 1
+        for i in range(self.hash_count):
+            bit = (h1 + i * h2) % self.bit_count
+            if not self.bits[bit // 8] & (1 << (bit % 8)):
+                return False
+        return True
+
+
+def read_sidecar(path: Path) -> Optional[Sidecar]:
+    """Parse <file>.meta; None if it is missing or malformed."""
+    try:
+        data = path.read_bytes()
+    except OSError:
+        return None
+    try:
+        if data[:8] != MAGIC:
+            return None
+        pos = 8
+        data_size, min_ns, max_ns, records = struct.unpack_from("<QqqQ", data, pos)
+        pos += 32
+        level_counts = list(struct.unpack_from("<6Q", data, pos))
+        pos += 48
+        (key_count,) = struct.unpack_from("<I", data, pos)
+        pos += 4
+        keys = []
+        for _ in range(key_count):
+            (length,) = struct.unpack_from("<H", data, pos)
+            pos += 2
+            keys.append(data[pos:pos + length].decode("utf-8", "replace"))
+            pos += length
+        hash_count, bit_count = struct.unpack_from("<IQ", data, pos)
+        pos += 12
+        bits = data[pos:pos + (bit_count + 7) // 8]
+        if len(bits) != (bit_count + 7) // 8:
+            return None
+    except struct.error:
+        return None
+    return Sidecar(data_size, min_ns, max_ns, records, level_counts, keys, hash_count, bit_count, bits)
+
+
+def is_compressed(path: Path) -> bool:
+    return path.suffix in (".gz", ".zst")
+
+
+def rules_out(path: Path, sidecar: Sidecar, args) -> bool:
+    """Whether the sidecar proves the file holds no match."""
+    # A plain file that has grown since its sidecar was written is not
+    # described by it any more; compressed files are recorded before
+    # compression, so their size is not compared
+    if not is_compressed(path) and path.stat().st_size != sidecar.data_size:
+        return False
+    if args.level is not None and not any(sidecar.level_counts[args.level:]):
+        return True
+    if sidecar.records and args.start is not None and sidecar.max_ns < args.start * 1_000_000:
+        return True
+    if sidecar.records and args.end is not None and sidecar.min_ns > args.end * 1_000_000:
+        return True
+    return any(not sidecar.may_contain(key, value) for key, value in args.fields)
+
+
+def read_lines(path: Path, dictionary: Optional[Path]) -> Iterator[bytes]:
+    if path.suffix == ".gz":
+        # Streamed files are a series of gzip members; gzip reads them all
+        with gzip.open(path, "rb") as f:
+            yield from f
+        return
+    if path.suffix == ".zst":
+        yield from decompress_zstd(path, dictionary).splitlines(keepends=True)
+        return
+    with path.open("rb") as f:
+        yield from f
+
+
+def decompress_zstd(path: Path, dictionary: Optional[Path]) -> bytes:
+    try:
+        import zstandard
+        dict_data = zstandard.ZstdCompressionDict(dictionary.read_bytes()) if dictionary else None
+        with path.open("rb") as f:
+            reader = zstandard.ZstdDecompressor(dict_data=dict_data).stream_reader(f, read_across_frames=True)
+            return reader.read()
+    except ImportError:
+        pass
+    zstd = shutil.which("zstd")
+    if not zstd:
+        sys.exit("error: zstd files need the zstandard module or the zstd command")
+    command = [zstd, "-q", "-d", "-c", str(path)]
+    if dictionary:
+        command += ["-D", str(dictionary)]
+    return subprocess.run(command, stdout=subprocess.PIPE, check=True).stdout
+
+
+def parse_field(text: str) -> Tuple[str, str]:
+    key, sep, value = text.partition("=")
+    if not sep or not key:
+        raise argparse.ArgumentTypeError(f"Expected KEY=VALUE, not {text}")
+    return key, value
+
+
+def parse_level(text: str) -> int:
+    name = {"warning": "warn", "fatal": "critical"}.get(text.lower(), text.lower())
+    if name not in LEVELS:
+        raise argparse.ArgumentTypeError(f"Unknown level: {text}")
+    return LEVELS.index(name)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Search rotated logs, skipping files by their sidecars")
+    parser.add_argument("files", nargs="+", type=Path, help="Log files, plain, .gz or .zst")
+    parser.add_argument("--field", dest="fields", action="append", type=parse_field, default=[],
+                        metavar="KEY=VALUE", help="A field value the record must have; repeatable")
+    parser.add_argument("--text", help="Text the line must contain")
+    parser.add_argument("--level", type=parse_level, help="Skip files with nothing at or above this level")
+    parser.add_argument("--from", dest="start", type=parse_time, help="Skip files that end before this")
+    parser.add_argument("--to", dest="end", type=parse_time, help="Skip files that start after this")
+    parser.add_argument("--dict", type=Path, help="Zstd dictionary the files were written with")
+    parser.add_argument("--list", action="store_true", help="Print the files that may match instead")
+    args = parser.parse_args()
+
+    needles = [value.encode() for _, value in args.fields]
+    if args.text:
+        needles.append(args.text.encode())
+
+    files = [p for p in args.files if p.suffix not in (".meta", ".idx", ".dict", ".lock") and p.is_file()]
+    skipped = 0
+    unindexed = 0
+    out = sys.stdout.buffer
+    for path in files:
+        sidecar = read_sidecar(Path(str(path) + ".meta"))
+        if sidecar is None:
+            unindexed += 1
+        elif rules_out(path, sidecar, args):
+            skipped += 1
+            continue
+        if args.list:
+            print(path)
+            continue
+        prefix = str(path).encode() + b":"
+        for line in read_lines(path, args.dict):
+            if all(needle in line for needle in needles):
+                out.write(prefix + line if line.endswith(b"\n") else prefix + line + b"\n")
+
+    print(f"{len(files)} files, {skipped} skipped by their sidecar, {unindexed} without one",
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
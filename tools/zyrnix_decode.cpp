@@ -0,0 +1,258 @@
+// zyrnix_decode - render BinaryFileSink files as text or JSON lines.
+//
+// Usage:
+//     zyrnix_decode [--json] [--pattern PATTERN] [--threads N] FILE...
+//
+// Text output uses the Formatter pattern given (the default layout
+// otherwise); --json writes the StructuredJsonSink layout. Blocks are
+// decoded on N threads (all cores by default) and written in file order.
+// Damaged blocks are skipped and counted on stderr.
+
+#include <Zyrnix/binary_log.hpp>
+#include <Zyrnix/formatter.hpp>
+#include <Zyrnix/json_escape.hpp>
+#include <Zyrnix/log_level.hpp>
+#include <Zyrnix/timestamp_cache.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Zyrnix;
+
+namespace {
+
+struct Options {
+    bool json = false;
+    std::string pattern = Formatter::default_pattern;
+    unsigned threads = 0;
+    std::vector<std::string> files;
+};
+
+// The whole file, mapped where possible
+class FileImage {
+public:
+    explicit FileImage(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                map_ = map;
+                size_ = static_cast<size_t>(st.st_size);
+                madvise(map_, size_, MADV_SEQUENTIAL);
+            }
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        if (map_ || fd >= 0) {
+            ok_ = fd >= 0;
+            return;
+        }
+#endif
+        std::ifstream in(path, std::ios::binary);
+        ok_ = static_cast<bool>(in);
+        copy_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    ~FileImage() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (map_) {
+            munmap(map_, size_);
+        }
+#endif
+    }
+
+    FileImage(const FileImage&) = delete;
+    FileImage& operator=(const FileImage&) = delete;
+
+    bool ok() const { return ok_; }
+    std::string_view view() const {
+        return map_ ? std::string_view(static_cast<const char*>(map_), size_) : std::string_view(copy_);
+    }
+
+private:
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::string copy_;
+    bool ok_ = false;
+};
+
+class Renderer {
+public:
+    explicit Renderer(const Options& options) : json_(options.json), formatter_(options.pattern) {}
+
+    void render(const binlog::DecodedRecord& record, std::string& out) {
+        if (json_) {
+            render_json(record, out);
+            return;
+        }
+        if (record.file.empty()) {
+            out.append(formatter_.format(record.timestamp, record.logger_name, record.level, record.message,
+                                         record.thread_id));
+        } else {
+            // LogSite wants C strings
+            file_.assign(record.file);
+            function_.assign(record.function);
+            const size_t slash = file_.find_last_of("/\\");
+            const LogSite site{record.level, file_.c_str(),
+                               static_cast<uint32_t>(slash == std::string::npos ? 0 : slash + 1), record.line,
+                               function_.c_str(), nullptr};
+            out.append(formatter_.format(record.timestamp, record.logger_name, record.level, record.message,
+                                         record.thread_id, &site));
+        }
+        out.push_back('\n');
+    }
+
+private:
+    void render_json(const binlog::DecodedRecord& record, std::string& out) {
+        out.append("{\"timestamp\":\"");
+        out.append(TimestampCache::utc(record.timestamp));
+        TimestampCache::append_fraction(out, record.timestamp, TimePrecision::Milliseconds);
+        out.append("Z\",\"level\":\"");
+        out.append(to_string(record.level));
+        out.append("\",\"logger\":");
+        json::append_string(out, record.logger_name);
+        out.append(",\"message\":");
+        json::append_string(out, record.message);
+        for (const auto& [key, value] : record.fields) {
+            out.push_back(',');
+            json::append_string(out, key);
+            out.push_back(':');
+            value.append_json(out);
+        }
+        out.append("}\n");
+    }
+
+    bool json_;
+    Formatter formatter_;
+    std::string file_;
+    std::string function_;
+};
+
+// Decodes blocks on worker threads, at most window ahead of the writer
+size_t decode_file(std::string_view image, const Options& options, unsigned threads) {
+    size_t bad_crc = 0;
+    const std::vector<binlog::BlockRef> blocks = binlog::scan_blocks(image, &bad_crc);
+    const size_t window = std::max<size_t>(threads * 4, 8);
+    std::vector<std::optional<std::string>> results(blocks.size());
+    std::atomic<size_t> damaged{0};
+    std::mutex mtx;
+    std::condition_variable ready_cv;
+    std::condition_variable space_cv;
+    size_t next = 0;
+    size_t written = 0;
+
+    auto worker = [&] {
+        Renderer renderer(options);
+        for (;;) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                space_cv.wait(lock, [&] { return next >= blocks.size() || next < written + window; });
+                if (next >= blocks.size()) {
+                    return;
+                }
+                index = next++;
+            }
+            std::string out;
+            out.reserve(blocks[index].size * 2);
+            const bool ok = binlog::decode_block(image, blocks[index], [&](const binlog::DecodedRecord& record) {
+                renderer.render(record, out);
+            });
+            if (!ok) {
+                damaged.fetch_add(1, std::memory_order_relaxed);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                results[index] = std::move(out);
+            }
+            ready_cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    for (; written < blocks.size();) {
+        std::string out;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            ready_cv.wait(lock, [&] { return results[written].has_value(); });
+            out = std::move(*results[written]);
+            results[written].reset();
+            ++written;
+        }
+        space_cv.notify_all();
+        std::fwrite(out.data(), 1, out.size(), stdout);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return bad_crc + damaged.load();
+}
+
+int usage() {
+    std::fprintf(stderr, "usage: zyrnix_decode [--json] [--pattern PATTERN] [--threads N] FILE...\n");
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--pattern" && i + 1 < argc) {
+            options.pattern = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-h" || arg == "--help" || (arg.size() > 1 && arg[0] == '-')) {
+            return usage();
+        } else {
+            options.files.emplace_back(arg);
+        }
+    }
+    if (options.files.empty()) {
+        return usage();
+    }
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    int status = 0;
+    for (const auto& path : options.files) {
+        FileImage image(path);
+        if (!image.ok()) {
+            std::fprintf(stderr, "zyrnix_decode: cannot read %s\n", path.c_str());
+            status = 1;
+            continue;
+        }
+        if (const size_t damaged = decode_file(image.view(), options, threads)) {
+            std::fprintf(stderr, "zyrnix_decode: %s: %zu damaged block(s) skipped\n", path.c_str(), damaged);
+            status = 1;
+        }
+    }
+    std::fflush(stdout);
+    return status;
+}
@@ -0,0 +1,107 @@
+// zyrnix_flight - print the recording a FlightRecorderSink left behind.
+//
+// Usage:
+//     zyrnix_flight [--json] [--pattern PATTERN] [--generation N] FILE...
+//
+// Records come out oldest first, in the Formatter pattern given (the
+// default layout otherwise) or as JSON lines with the generation, i.e.
+// the run of the process, each was written in. --generation keeps only
+// that run's records. Damaged records are skipped and counted on stderr.
+
+#include <Zyrnix/flight_recorder.hpp>
+#include <Zyrnix/formatter.hpp>
+#include <Zyrnix/json_escape.hpp>
+#include <Zyrnix/log_level.hpp>
+#include <Zyrnix/timestamp_cache.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace Zyrnix;
+
+namespace {
+
+struct Options {
+    bool json = false;
+    std::string pattern = Formatter::default_pattern;
+    uint64_t generation = 0;  // 0 = every generation
+    std::vector<std::string> files;
+};
+
+void render_json(const flight::Record& record, std::string& out) {
+    out.append("{\"timestamp\":\"");
+    out.append(TimestampCache::utc(record.timestamp));
+    TimestampCache::append_fraction(out, record.timestamp, TimePrecision::Milliseconds);
+    out.append("Z\",\"generation\":");
+    out.append(std::to_string(record.generation));
+    out.append(",\"level\":\"");
+    out.append(to_string(record.level));
+    out.append("\",\"logger\":");
+    json::append_string(out, record.logger_name);
+    out.append(",\"message\":");
+    json::append_string(out, record.message);
+    out.append("}\n");
+}
+
+int usage() {
+    std::fprintf(stderr, "usage: zyrnix_flight [--json] [--pattern PATTERN] [--generation N] FILE...\n");
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--pattern" && i + 1 < argc) {
+            options.pattern = argv[++i];
+        } else if (arg == "--generation" && i + 1 < argc) {
+            options.generation = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-h" || arg == "--help" || (arg.size() > 1 && arg[0] == '-')) {
+            return usage();
+        } else {
+            options.files.emplace_back(arg);
+        }
+    }
+    if (options.files.empty()) {
+        return usage();
+    }
+
+    const Formatter formatter(options.pattern);
+    int status = 0;
+    std::string out;
+    for (const auto& path : options.files) {
+        flight::Reader reader(path);
+        if (!reader.is_open()) {
+            std::fprintf(stderr, "zyrnix_flight: %s is not a flight recording\n", path.c_str());
+            status = 1;
+            continue;
+        }
+        reader.read([&](const flight::Record& record) {
+            if (options.generation != 0 && record.generation != options.generation) {
+                return;
+            }
+            out.clear();
+            if (options.json) {
+                render_json(record, out);
+            } else {
+                out.append(formatter.format(record.timestamp, record.logger_name, record.level, record.message,
+                                            record.thread_id));
+                out.push_back('\n');
+            }
+            std::fwrite(out.data(), 1, out.size(), stdout);
+        });
+        if (const size_t damaged = reader.damaged()) {
+            std::fprintf(stderr, "zyrnix_flight: %s: %zu damaged record(s) skipped\n", path.c_str(), damaged);
+            status = 1;
+        }
+    }
+    std::fflush(stdout);
+    return status;
+}
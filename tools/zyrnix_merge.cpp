@@ -0,0 +1,844 @@
+// zyrnix_merge - merge the logs of many hosts or processes into one stream,
+// in time order.
+//
+// Usage:
+//     zyrnix_merge [--json | --binary] [--pattern PATTERN] [--threads N]
+//                  [--level LEVEL] [--logger NAME]... [--field KEY=VALUE]...
+//                  [--from TIME] [--to TIME] [--output FILE] FILE...
+//
+// Reads BinaryFileSink files and text logs whose lines start with the
+// default layout's local time ("%Y-%m-%d %H:%M:%S", optionally with 'T'
+// and a fraction). Text lines that do not start with a time belong to the
+// line before them. Each file is taken to be in time order, as one sink
+// writes it; small reorderings within a block are straightened out.
+//
+// Files are mapped and cut into blocks (a binary file's own blocks, about
+// 1 MiB of lines for text), which worker threads decode, filter and render
+// ahead of the merge; the merge itself only compares timestamps in a heap
+// of one record per file. A file whose sidecar (<file>.meta) rules out the
+// time range, the level or a --field value is skipped without being read.
+//
+// --level keeps records at LEVEL and above (a text line without a
+// readable "[level]" counts as info), --logger keeps the names given,
+// --field keeps records with that field value (for text, lines holding
+// KEY=VALUE as a whitespace-separated word), and --from/--to take epoch milliseconds or a local
+// "YYYY-MM-DD HH:MM[:SS]". Text lines are written as they were, binary
+// records in PATTERN; --json writes the StructuredJsonSink layout and
+// --binary a BinaryFileSink file. Compressed files must be decompressed
+// first. Damaged binary blocks are skipped and counted on stderr.
+
+#include <Zyrnix/binary_log.hpp>
+#include <Zyrnix/formatter.hpp>
+#include <Zyrnix/json_escape.hpp>
+#include <Zyrnix/log_level.hpp>
+#include <Zyrnix/log_sidecar.hpp>
+#include <Zyrnix/log_site.hpp>
+#include <Zyrnix/timestamp_cache.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Zyrnix;
+
+namespace {
+
+struct Options {
+    bool json = false;
+    bool binary = false;
+    std::string pattern = Formatter::default_pattern;
+    unsigned threads = 0;
+    LogLevel level = LogLevel::Trace;
+    std::vector<std::string> loggers;
+    std::vector<std::pair<std::string, std::string>> fields;
+    int64_t from_ns = INT64_MIN;
+    int64_t to_ns = INT64_MAX;
+    std::string output;
+    std::vector<std::string> files;
+};
+
+constexpr size_t text_chunk_bytes = 1 << 20;
+constexpr size_t output_flush_bytes = 1 << 20;
+constexpr size_t output_block_bytes = 64 * 1024;
+
+// The whole file, mapped where possible
+class FileImage {
+public:
+    explicit FileImage(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                map_ = map;
+                size_ = static_cast<size_t>(st.st_size);
+                madvise(map_, size_, MADV_SEQUENTIAL);
+            }
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        if (map_ || fd >= 0) {
+            ok_ = fd >= 0;
+            return;
+        }
+#endif
+        std::ifstream in(path, std::ios::binary);
+        ok_ = static_cast<bool>(in);
+        copy_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    ~FileImage() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (map_) {
+            munmap(map_, size_);
+        }
+#endif
+    }
+
+    FileImage(const FileImage&) = delete;
+    FileImage& operator=(const FileImage&) = delete;
+
+    bool ok() const { return ok_; }
+    std::string_view view() const {
+        return map_ ? std::string_view(static_cast<const char*>(map_), size_) : std::string_view(copy_);
+    }
+
+private:
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::string copy_;
+    bool ok_ = false;
+};
+
+bool digits(std::string_view text, size_t at, size_t count) {
+    if (at + count > text.size()) {
+        return false;
+    }
+    for (size_t i = at; i < at + count; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(text[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int number(std::string_view text, size_t at, size_t count) {
+    int value = 0;
+    for (size_t i = at; i < at + count; ++i) {
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+// KEY=VALUE as a word of its own: at the start of text or after
+// whitespace, and followed by whitespace or the end
+bool has_field(std::string_view text, std::string_view key, std::string_view value) {
+    const auto space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    for (size_t at = text.find(key); at != std::string_view::npos; at = text.find(key, at + 1)) {
+        const size_t equals = at + key.size();
+        const size_t end = equals + 1 + value.size();
+        if ((at == 0 || space(text[at - 1])) && end <= text.size() && text[equals] == '=' &&
+            text.substr(equals + 1, value.size()) == value && (end == text.size() || space(text[end]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// "YYYY-MM-DD HH:MM" with ' ' or 'T', the part every line shares
+bool starts_with_time(std::string_view text) {
+    if (text.size() < 16) {
+        return false;
+    }
+    return digits(text, 0, 4) && text[4] == '-' && digits(text, 5, 2) && text[7] == '-' && digits(text, 8, 2) &&
+           (text[10] == ' ' || text[10] == 'T') && digits(text, 11, 2) && text[13] == ':' && digits(text, 14, 2);
+}
+
+// Local times to Unix nanoseconds. mktime() runs once a minute of log,
+// not once a line
+class LocalTime {
+public:
+    // "YYYY-MM-DD HH:MM[:SS[.fraction]]"; seconds are required unless
+    // minutes_ok. used is how many characters were read
+    bool parse(std::string_view text, int64_t& ns, size_t& used, bool minutes_ok = false) {
+        if (!starts_with_time(text)) {
+            return false;
+        }
+        used = 16;
+        int seconds = 0;
+        if (text.size() > 18 && text[16] == ':' && digits(text, 17, 2)) {
+            seconds = number(text, 17, 2);
+            used = 19;
+        } else if (!minutes_ok) {
+            return false;
+        }
+        int64_t fraction = 0;
+        if (used == 19 && text.size() > 20 && text[19] == '.' && digits(text, 20, 1)) {
+            size_t n = 0;
+            for (; n < 9 && digits(text, 20 + n, 1); ++n) {
+                fraction = fraction * 10 + (text[20 + n] - '0');
+            }
+            for (size_t k = n; k < 9; ++k) {
+                fraction *= 10;
+            }
+            used = 20 + n;
+            while (digits(text, used, 1)) {
+                ++used;  // Past nanoseconds
+            }
+        }
+        const std::string_view minute = text.substr(0, 16);
+        if (minute != std::string_view(minute_, minute_size_)) {
+            std::tm tm{};
+            tm.tm_year = number(text, 0, 4) - 1900;
+            tm.tm_mon = number(text, 5, 2) - 1;
+            tm.tm_mday = number(text, 8, 2);
+            tm.tm_hour = number(text, 11, 2);
+            tm.tm_min = number(text, 14, 2);
+            tm.tm_isdst = -1;
+            minute_seconds_ = static_cast<int64_t>(std::mktime(&tm));
+            std::memcpy(minute_, minute.data(), minute.size());
+            minute_size_ = minute.size();
+        }
+        ns = (minute_seconds_ + seconds) * 1000000000 + fraction;
+        return true;
+    }
+
+private:
+    char minute_[16] = {};
+    size_t minute_size_ = 0;
+    int64_t minute_seconds_ = 0;
+};
+
+bool parse_level(std::string_view text, LogLevel& level) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    static const std::pair<const char*, LogLevel> names[] = {
+        {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug},   {"info", LogLevel::Info},
+        {"warn", LogLevel::Warn},   {"warning", LogLevel::Warn},  {"error", LogLevel::Error},
+        {"critical", LogLevel::Critical},
+    };
+    for (const auto& [name, value] : names) {
+        if (lower == name) {
+            level = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_time_arg(std::string_view text, int64_t& ns) {
+    if (!text.empty() && std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        ns = std::strtoll(std::string(text).c_str(), nullptr, 10) * 1000000;
+        return true;
+    }
+    std::string padded(text);
+    if (padded.size() == 10) {
+        padded += " 00:00";  // A date alone is its midnight
+    }
+    LocalTime clock;
+    size_t used;
+    return clock.parse(padded, ns, used, true) && used == padded.size();
+}
+
+int64_t to_ns(std::chrono::system_clock::time_point when) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+}
+
+// One record ready to be merged: its bytes are already in the chunk's
+// text, or for --binary its decoded record is in the chunk's records
+struct Item {
+    int64_t ns;
+    size_t begin;
+    size_t end;
+    size_t record;
+};
+
+// What a worker made of one block of a file
+struct Chunk {
+    std::vector<Item> items;
+    std::string text;
+    std::vector<binlog::DecodedRecord> records;
+    bool damaged = false;
+};
+
+// A file being merged. Blocks are handed to workers in order, at most
+// window ahead of the one the merge is reading
+struct Source {
+    std::string path;
+    std::unique_ptr<FileImage> image;
+    bool binary = false;
+    std::vector<binlog::BlockRef> blocks;               // Binary
+    std::vector<std::pair<size_t, size_t>> ranges;      // Text: begin, end
+    size_t bad_crc = 0;
+
+    size_t next = 0;      // Next block to hand out
+    size_t consumed = 0;  // Blocks the merge is done with
+    std::vector<std::unique_ptr<Chunk>> done;
+
+    size_t units() const { return binary ? blocks.size() : ranges.size(); }
+};
+
+bool is_binary(std::string_view image) {
+    if (image.size() >= sizeof(binlog::file_magic) &&
+        std::memcmp(image.data(), binlog::file_magic, sizeof(binlog::file_magic)) == 0) {
+        return true;
+    }
+    const char block[4] = {'Z', 'B', 'K', '1'};
+    return image.size() >= 4 && std::memcmp(image.data(), block, 4) == 0;
+}
+
+// Cut at the first line after about text_chunk_bytes that starts with a
+// time, so a record's continuation lines stay with it
+std::vector<std::pair<size_t, size_t>> text_ranges(std::string_view image) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t begin = 0;
+    while (begin < image.size()) {
+        size_t cut = begin + text_chunk_bytes;
+        for (;;) {
+            if (cut >= image.size()) {
+                cut = image.size();
+                break;
+            }
+            const size_t newline = image.find('\n', cut);
+            if (newline == std::string_view::npos) {
+                cut = image.size();
+                break;
+            }
+            cut = newline + 1;
+            if (starts_with_time(image.substr(cut))) {
+                break;
+            }
+        }
+        ranges.emplace_back(begin, cut);
+        begin = cut;
+    }
+    return ranges;
+}
+
+// Whether the file's sidecar, if it has a current one, rules it out
+bool ruled_out(const std::string& path, size_t size, const Options& options) {
+    const auto index = sidecar::Index::read(path + std::string(sidecar::suffix));
+    if (!index || index->data_size != size) {
+        return false;
+    }
+    if (index->records == 0 || index->max_ns < options.from_ns || index->min_ns > options.to_ns) {
+        return true;
+    }
+    uint64_t at_level = 0;
+    for (size_t i = static_cast<size_t>(options.level); i < sidecar::level_count; ++i) {
+        at_level += index->level_counts[i];
+    }
+    if (at_level == 0) {
+        return true;
+    }
+    for (const auto& [key, value] : options.fields) {
+        if (!index->may_contain(key, value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decodes, filters and renders blocks; one per worker thread
+class BlockReader {
+public:
+    explicit BlockReader(const Options& options) : options_(options), formatter_(options.pattern) {}
+
+    std::unique_ptr<Chunk> read(const Source& source, size_t unit) {
+        auto chunk = std::make_unique<Chunk>();
+        if (source.binary) {
+            read_binary(source, source.blocks[unit], *chunk);
+        } else {
+            read_text(source, source.ranges[unit], *chunk);
+        }
+        // Threads of one process race to their sink; put them back in order
+        std::stable_sort(chunk->items.begin(), chunk->items.end(),
+                         [](const Item& a, const Item& b) { return a.ns < b.ns; });
+        return chunk;
+    }
+
+private:
+    bool keep(int64_t ns, LogLevel level, std::string_view logger_name) const {
+        if (ns < options_.from_ns || ns > options_.to_ns || level < options_.level) {
+            return false;
+        }
+        return options_.loggers.empty() ||
+               std::find(options_.loggers.begin(), options_.loggers.end(), logger_name) != options_.loggers.end();
+    }
+
+    void read_binary(const Source& source, const binlog::BlockRef& block, Chunk& chunk) {
+        const bool ok = binlog::decode_block(source.image->view(), block, [&](const binlog::DecodedRecord& record) {
+            const int64_t ns = to_ns(record.timestamp);
+            if (!keep(ns, record.level, record.logger_name)) {
+                return;
+            }
+            for (const auto& [key, value] : options_.fields) {
+                const auto field = std::find_if(record.fields.begin(), record.fields.end(),
+                                                [&key](const auto& f) { return f.first == key; });
+                if (field == record.fields.end() || field->second.text() != value) {
+                    return;
+                }
+            }
+            emit(chunk, ns, record);
+        });
+        chunk.damaged = !ok;
+    }
+
+    void read_text(const Source& source, std::pair<size_t, size_t> range, Chunk& chunk) {
+        const std::string_view text = source.image->view().substr(range.first, range.second - range.first);
+        binlog::DecodedRecord record;
+        int64_t ns = 0;
+        size_t record_begin = 0;
+        bool open = false;
+        auto finish = [&](size_t end) {
+            if (!open) {
+                return;
+            }
+            std::string_view raw = text.substr(record_begin, end - record_begin);
+            const size_t message_at = static_cast<size_t>(record.message.data() - raw.data());
+            record.message = raw.substr(message_at);
+            while (!record.message.empty() && (record.message.back() == '\n' || record.message.back() == '\r')) {
+                record.message.remove_suffix(1);
+            }
+            if (!keep(ns, record.level, record.logger_name)) {
+                return;
+            }
+            for (const auto& [key, value] : options_.fields) {
+                if (!has_field(raw, key, value)) {
+                    return;
+                }
+            }
+            raw_ = raw;
+            emit(chunk, ns, record);
+        };
+
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t line_end = text.find('\n', pos);
+            line_end = line_end == std::string_view::npos ? text.size() : line_end + 1;
+            const std::string_view line = text.substr(pos, line_end - pos);
+            int64_t line_ns;
+            size_t used;
+            if (clock_.parse(line, line_ns, used)) {
+                finish(pos);
+                // Lines before the first time go with the first record
+                record_begin = open ? pos : 0;
+                open = true;
+                ns = line_ns;
+                parse_rest(line.substr(used), record);
+                record.timestamp = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+            }
+            pos = line_end;
+        }
+        finish(text.size());
+    }
+
+    // " [level] name: message" after the time, as the default layout has
+    // it; what is missing is left empty (and the level info)
+    static void parse_rest(std::string_view rest, binlog::DecodedRecord& record) {
+        record.level = LogLevel::Info;
+        record.thread_id = 0;
+        record.logger_name = {};
+        record.fields.clear();
+        while (!rest.empty() && rest.front() == ' ') {
+            rest.remove_prefix(1);
+        }
+        if (!rest.empty() && rest.front() == '[') {
+            const size_t close = rest.find(']');
+            if (close != std::string_view::npos && close < 16) {
+                parse_level(rest.substr(1, close - 1), record.level);
+                rest.remove_prefix(close + 1);
+                while (!rest.empty() && rest.front() == ' ') {
+                    rest.remove_prefix(1);
+                }
+            }
+        }
+        const size_t colon = rest.find(": ");
+        const size_t newline = rest.find('\n');
+        if (colon != std::string_view::npos && colon < newline && rest.substr(0, colon).find(' ') == std::string_view::npos) {
+            record.logger_name = rest.substr(0, colon);
+            rest.remove_prefix(colon + 2);
+        }
+        record.message = rest;
+    }
+
+    void emit(Chunk& chunk, int64_t ns, const binlog::DecodedRecord& record) {
+        Item item{ns, chunk.text.size(), 0, 0};
+        if (options_.binary) {
+            item.record = chunk.records.size();
+            chunk.records.push_back(record);
+        } else if (options_.json) {
+            render_json(record, chunk.text);
+        } else if (!raw_.empty()) {
+            chunk.text.append(raw_);
+            if (chunk.text.back() != '\n') {
+                chunk.text.push_back('\n');
+            }
+        } else {
+            render_text(record, chunk.text);
+        }
+        raw_ = {};
+        item.end = chunk.text.size();
+        chunk.items.push_back(item);
+    }
+
+    void render_text(const binlog::DecodedRecord& record, std::string& out) {
+        if (record.file.empty()) {
+            formatter_.format_to(out, record.timestamp, record.logger_name, record.level, record.message,
+                                 record.thread_id);
+        } else {
+            // LogSite wants C strings
+            file_.assign(record.file);
+            function_.assign(record.function);
+            const size_t slash = file_.find_last_of("/\\");
+            const LogSite site{record.level, file_.c_str(),
+                               static_cast<uint32_t>(slash == std::string::npos ? 0 : slash + 1), record.line,
+                               function_.c_str(), nullptr};
+            formatter_.format_to(out, record.timestamp, record.logger_name, record.level, record.message,
+                                 record.thread_id, &site);
+        }
+        out.push_back('\n');
+    }
+
+    static void render_json(const binlog::DecodedRecord& record, std::string& out) {
+        out.append("{\"timestamp\":\"");
+        out.append(TimestampCache::utc(record.timestamp));
+        TimestampCache::append_fraction(out, record.timestamp, TimePrecision::Milliseconds);
+        out.append("Z\",\"level\":\"");
+        out.append(level_name(record.level));
+        out.append("\",\"logger\":");
+        json::append_string(out, record.logger_name);
+        out.append(",\"message\":");
+        json::append_string(out, record.message);
+        for (const auto& [key, value] : record.fields) {
+            out.push_back(',');
+            json::append_string(out, key);
+            out.push_back(':');
+            value.append_json(out);
+        }
+        out.append("}\n");
+    }
+
+    const Options& options_;
+    Formatter formatter_;
+    LocalTime clock_;
+    std::string_view raw_;  // The text record being emitted, as it was written
+    std::string file_;
+    std::string function_;
+};
+
+// Where merged records go
+class Writer {
+public:
+    Writer(const Options& options, std::FILE* out) : binary_(options.binary), out_(out) {
+        if (binary_) {
+            buffer_.append(binlog::file_magic, sizeof(binlog::file_magic));
+        }
+    }
+
+    void write(const Chunk& chunk, const Item& item) {
+        if (!binary_) {
+            buffer_.append(chunk.text, item.begin, item.end - item.begin);
+        } else {
+            add(chunk.records[item.record]);
+        }
+        if (buffer_.size() >= output_flush_bytes) {
+            drain();
+        }
+    }
+
+    void finish() {
+        if (binary_) {
+            block_.finish(buffer_);
+        }
+        drain();
+    }
+
+private:
+    void add(const binlog::DecodedRecord& record) {
+        if (record.file.empty()) {
+            block_.add(record.timestamp, record.level, record.thread_id, record.logger_name, nullptr,
+                       record.message, record.fields);
+        } else {
+            // BlockWriter keys call-site strings by pointer, so each text
+            // gets one lasting copy
+            const char* file = intern(record.file);
+            const std::string_view path(file);
+            const size_t slash = path.find_last_of("/\\");
+            const LogSite site{record.level, file,
+                               static_cast<uint32_t>(slash == std::string_view::npos ? 0 : slash + 1),
+                               record.line, intern(record.function), nullptr};
+            block_.add(record.timestamp, record.level, record.thread_id, record.logger_name, &site,
+                       record.message, record.fields);
+        }
+        if (block_.size() >= output_block_bytes) {
+            block_.finish(buffer_);
+        }
+    }
+
+    const char* intern(std::string_view text) {
+        return strings_.emplace(text).first->c_str();
+    }
+
+    void drain() {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+        buffer_.clear();
+    }
+
+    bool binary_;
+    std::FILE* out_;
+    std::string buffer_;
+    binlog::BlockWriter block_;
+    std::unordered_set<std::string> strings_;
+};
+
+class Merger {
+public:
+    Merger(std::vector<Source>& sources, const Options& options, unsigned threads)
+        : sources_(sources), options_(options), threads_(threads),
+          window_(std::max<size_t>(2, (threads * 4 + sources.size() - 1) / std::max<size_t>(sources.size(), 1))) {}
+
+    // Returns the number of damaged blocks
+    size_t run(Writer& writer) {
+        std::vector<std::thread> pool;
+        for (unsigned i = 0; i < threads_; ++i) {
+            pool.emplace_back([this] { work(); });
+        }
+
+        // One entry per file with records left: its next record's time
+        using Head = std::pair<int64_t, size_t>;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+        std::vector<std::unique_ptr<Chunk>> current(sources_.size());
+        std::vector<size_t> position(sources_.size(), 0);
+        size_t damaged = 0;
+
+        // Moves source s to a chunk with records, or returns false at its end
+        auto advance = [&](size_t s) {
+            Source& source = sources_[s];
+            while (!current[s] || position[s] == current[s]->items.size()) {
+                std::unique_lock<std::mutex> lock(mtx_);
+                if (current[s]) {
+                    current[s].reset();
+                    ++source.consumed;
+                    space_cv_.notify_all();
+                }
+                if (source.consumed == source.units()) {
+                    return false;
+                }
+                ready_cv_.wait(lock, [&] { return source.done[source.consumed] != nullptr; });
+                current[s] = std::move(source.done[source.consumed]);
+                position[s] = 0;
+                damaged += current[s]->damaged ? 1 : 0;
+            }
+            return true;
+        };
+
+        for (size_t s = 0; s < sources_.size(); ++s) {
+            if (advance(s)) {
+                heap.emplace(current[s]->items[0].ns, s);
+            }
+        }
+        while (!heap.empty()) {
+            const size_t s = heap.top().second;
+            heap.pop();
+            writer.write(*current[s], current[s]->items[position[s]]);
+            ++position[s];
+            if (advance(s)) {
+                heap.emplace(current[s]->items[position[s]].ns, s);
+            }
+        }
+        writer.finish();
+
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        for (const auto& source : sources_) {
+            damaged += source.bad_crc;
+        }
+        return damaged;
+    }
+
+private:
+    // Hands out blocks of the file least far ahead of the merge, so the
+    // file the merge is waiting for goes first
+    void work() {
+        BlockReader reader(options_);
+        for (;;) {
+            size_t s = 0;
+            size_t unit = 0;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                bool found = false;
+                bool left = false;
+                space_cv_.wait(lock, [&] {
+                    found = false;
+                    left = false;
+                    size_t best = SIZE_MAX;
+                    for (size_t i = 0; i < sources_.size(); ++i) {
+                        const Source& source = sources_[i];
+                        if (source.next >= source.units()) {
+                            continue;
+                        }
+                        left = true;
+                        const size_t ahead = source.next - source.consumed;
+                        if (ahead < window_ && ahead < best) {
+                            best = ahead;
+                            s = i;
+                            found = true;
+                        }
+                    }
+                    return found || !left;
+                });
+                if (!found) {
+                    return;
+                }
+                unit = sources_[s].next++;
+            }
+            auto chunk = reader.read(sources_[s], unit);
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                sources_[s].done[unit] = std::move(chunk);
+            }
+            ready_cv_.notify_all();
+        }
+    }
+
+    std::vector<Source>& sources_;
+    const Options& options_;
+    unsigned threads_;
+    size_t window_;
+    std::mutex mtx_;
+    std::condition_variable ready_cv_;
+    std::condition_variable space_cv_;
+};
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: zyrnix_merge [--json | --binary] [--pattern PATTERN] [--threads N] [--level LEVEL]\n"
+                 "                    [--logger NAME]... [--field KEY=VALUE]... [--from TIME] [--to TIME]\n"
+                 "                    [--output FILE] FILE...\n");
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--binary") {
+            options.binary = true;
+        } else if (arg == "--pattern" && has_value) {
+            options.pattern = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--level" && has_value) {
+            if (!parse_level(argv[++i], options.level)) {
+                std::fprintf(stderr, "zyrnix_merge: unknown level %s\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "--logger" && has_value) {
+            options.loggers.emplace_back(argv[++i]);
+        } else if (arg == "--field" && has_value) {
+            const std::string_view field = argv[++i];
+            const size_t equals = field.find('=');
+            if (equals == std::string_view::npos || equals == 0) {
+                return usage();
+            }
+            options.fields.emplace_back(field.substr(0, equals), field.substr(equals + 1));
+        } else if ((arg == "--from" || arg == "--to") && has_value) {
+            if (!parse_time_arg(argv[++i], arg == "--from" ? options.from_ns : options.to_ns)) {
+                std::fprintf(stderr, "zyrnix_merge: unrecognized time %s\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "--output" && has_value) {
+            options.output = argv[++i];
+        } else if (arg == "-h" || arg == "--help" || (arg.size() > 1 && arg[0] == '-')) {
+            return usage();
+        } else {
+            options.files.emplace_back(arg);
+        }
+    }
+    if (options.files.empty() || (options.json && options.binary)) {
+        return usage();
+    }
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    int status = 0;
+    std::vector<Source> sources;
+    sources.reserve(options.files.size());
+    for (const auto& path : options.files) {
+        auto image = std::make_unique<FileImage>(path);
+        if (!image->ok()) {
+            std::fprintf(stderr, "zyrnix_merge: cannot read %s\n", path.c_str());
+            status = 1;
+            continue;
+        }
+        const std::string_view view = image->view();
+        if (view.empty() || ruled_out(path, view.size(), options)) {
+            continue;
+        }
+        Source source;
+        source.path = path;
+        source.binary = is_binary(view);
+        if (source.binary) {
+            source.blocks = binlog::scan_blocks(view, &source.bad_crc);
+        } else {
+            source.ranges = text_ranges(view);
+        }
+        source.done.resize(source.units());
+        source.image = std::move(image);
+        sources.push_back(std::move(source));
+    }
+
+    std::FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = std::fopen(options.output.c_str(), "wb");
+        if (!out) {
+            std::fprintf(stderr, "zyrnix_merge: cannot write %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+    Writer writer(options, out);
+    Merger merger(sources, options, threads);
+    if (const size_t damaged = merger.run(writer)) {
+        std::fprintf(stderr, "zyrnix_merge: %zu damaged block(s) skipped\n", damaged);
+        status = 1;
+    }
+    if (std::fflush(out) != 0 || (out != stdout && std::fclose(out) != 0)) {
+        std::fprintf(stderr, "zyrnix_merge: write failed\n");
+        status = 1;
+    }
+    return status;
+}